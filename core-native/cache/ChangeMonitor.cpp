@@ -0,0 +1,329 @@
+#include "ChangeMonitor.h"
+#include <algorithm>
+#include <iostream>
+#include "../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+#ifdef _WIN32
+        constexpr wchar_t PATH_SEPARATOR = L'\\';
+#else
+        constexpr wchar_t PATH_SEPARATOR = L'/';
+#endif
+
+        // Idle wait when nothing is pending; only bounds how late Stop() is noticed
+        // if a Wake() were ever lost
+        constexpr auto IDLE_WAIT = std::chrono::milliseconds(1000);
+
+        bool SamePath(std::wstring_view a, std::wstring_view b) {
+#ifdef _WIN32
+            return EqualsIgnoreCase(a, b);
+#else
+            return a == b;
+#endif
+        }
+
+        // Folder holding `path`; roots keep their trailing separator ("C:\", "/")
+        std::wstring_view ParentDirectory(std::wstring_view path) {
+            size_t slash = path.find_last_of(L"\\/");
+            if (slash == std::wstring_view::npos) {
+                return {};
+            }
+            if (slash == 0 || path[slash - 1] == L':') {
+                return path.substr(0, slash + 1);
+            }
+            return path.substr(0, slash);
+        }
+
+        void Join(std::wstring& path, std::wstring_view directory, std::wstring_view name) {
+            path.clear();
+            path.append(directory);
+            if (!path.empty() && path.back() != L'\\' && path.back() != L'/') {
+                path.push_back(PATH_SEPARATOR);
+            }
+            path.append(name);
+        }
+
+        uint64_t MicrosecondsSince(std::chrono::steady_clock::time_point start) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    ChangeMonitor::ChangeMonitor(IOScheduler& ioScheduler)
+        : m_ioScheduler(ioScheduler)
+        , m_stopping(false)
+        , m_requestCount(0)
+        , m_rescanAll(false)
+        , m_eventCount(0)
+        , m_batchCount(0)
+        , m_pathCount(0)
+        , m_overflowCount(0)
+        , m_rescannedCount(0)
+        , m_lastLatencyUs(0)
+        , m_maxLatencyUs(0)
+        , m_directoryCount(0)
+    {
+    }
+
+    ChangeMonitor::~ChangeMonitor() {
+        Stop();
+    }
+
+    void ChangeMonitor::Subscribe(ChangeSubscriber& subscriber) {
+        m_subscribers.push_back(&subscriber);
+    }
+
+    bool ChangeMonitor::Start() {
+        if (m_thread.joinable()) {
+            return true;
+        }
+        if (!m_watcher.Open()) {
+            std::wcerr << L"Change monitor unavailable; cached previews are checked on use only" << std::endl;
+            return false;
+        }
+        m_stopping.store(false);
+        m_thread = std::thread(&ChangeMonitor::Run, this);
+        return true;
+    }
+
+    void ChangeMonitor::Stop() {
+        m_stopping.store(true);
+        m_watcher.Wake();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        m_watcher.Close();
+        m_directories.clear();
+        m_directoryCount.store(0, std::memory_order_relaxed);
+    }
+
+    void ChangeMonitor::WatchDirectoryOf(std::wstring_view path) {
+        std::wstring_view directory = ParentDirectory(path);
+        if (directory.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_requestMutex);
+            if (m_requestCount != 0 && SamePath(m_requests[m_requestCount - 1], directory)) {
+                return;
+            }
+            if (m_requestCount == m_requests.size()) {
+                m_requests.emplace_back();
+            }
+            m_requests[m_requestCount++].assign(directory);
+        }
+        m_watcher.Wake();
+    }
+
+    ChangeMonitorStats ChangeMonitor::Stats() const {
+        return {
+            m_eventCount.load(std::memory_order_relaxed),
+            m_batchCount.load(std::memory_order_relaxed),
+            m_pathCount.load(std::memory_order_relaxed),
+            m_overflowCount.load(std::memory_order_relaxed),
+            m_rescannedCount.load(std::memory_order_relaxed),
+            m_lastLatencyUs.load(std::memory_order_relaxed),
+            m_maxLatencyUs.load(std::memory_order_relaxed),
+            m_directoryCount.load(std::memory_order_relaxed)
+        };
+    }
+
+    void ChangeMonitor::Run() {
+        using Clock = std::chrono::steady_clock;
+
+        while (!m_stopping.load()) {
+            ApplyRequests();
+
+            bool pending = !m_changed.empty() || !m_removedTrees.empty() || !m_rescan.empty() || m_rescanAll;
+            auto timeout = IDLE_WAIT;
+            if (pending) {
+                // Let the kernel queue the rest of the burst instead of waking
+                // for every event; one read then drains it in bulk
+                auto now = Clock::now();
+                std::this_thread::sleep_until(std::min(now + COALESCE_QUIET, m_batchStart + COALESCE_MAX));
+                timeout = std::chrono::milliseconds(0);
+            }
+
+            m_events.clear();
+            if (!m_watcher.Wait(m_events, timeout)) {
+                std::wcerr << L"Change monitor stopped; cached previews are checked on use only" << std::endl;
+                break;
+            }
+
+            if (!m_events.empty()) {
+                if (!pending) {
+                    m_batchStart = Clock::now();
+                }
+                m_eventCount.fetch_add(m_events.size(), std::memory_order_relaxed);
+                for (const FileChange& change : m_events) {
+                    Record(change);
+                }
+            }
+
+            // Dispatch once a quiet period passes without events, or the burst runs too long
+            if (pending && (m_events.empty() || Clock::now() >= m_batchStart + COALESCE_MAX)) {
+                Dispatch();
+            }
+        }
+    }
+
+    void ChangeMonitor::ApplyRequests() {
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(m_requestMutex);
+            m_applying.swap(m_requests);
+            count = m_requestCount;
+            m_requestCount = 0;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            std::wstring& directory = m_applying[i];
+            auto existing = std::find_if(m_directories.begin(), m_directories.end(),
+                                         [&](const Directory& d) { return SamePath(d.path, directory); });
+            if (existing != m_directories.end()) {
+                m_directories.splice(m_directories.begin(), m_directories, existing);
+                continue;
+            }
+
+            while (m_directories.size() >= MAX_DIRECTORIES ||
+                   (!m_directories.empty() && m_watcher.WatchCount() >= DirectoryWatcher::MAX_WATCHES)) {
+                m_watcher.Remove(m_directories.back().watch);
+                m_directories.pop_back();
+            }
+
+            int watch = m_watcher.Add(directory);
+            if (watch < 0) {
+                std::wcerr << L"Cannot watch " << directory << std::endl;
+                continue;
+            }
+            m_directories.push_front(Directory{ std::move(directory), watch });
+        }
+        m_directoryCount.store(m_directories.size(), std::memory_order_relaxed);
+    }
+
+    std::list<ChangeMonitor::Directory>::iterator ChangeMonitor::FindWatch(int watch) {
+        return std::find_if(m_directories.begin(), m_directories.end(),
+                            [watch](const Directory& d) { return d.watch == watch; });
+    }
+
+    void ChangeMonitor::Record(const FileChange& change) {
+        if (change.kind == FileChangeKind::Overflow && change.watch < 0) {
+            m_rescanAll = true;
+            return;
+        }
+
+        auto directory = FindWatch(change.watch);
+        if (directory == m_directories.end()) {
+            return; // Dropped from the watch list while its events were queued
+        }
+
+        switch (change.kind) {
+        case FileChangeKind::Added:
+        case FileChangeKind::Modified:
+        case FileChangeKind::RenamedTo:
+            // Storms repeat the same few names; only copy the path the first time
+            Join(m_scratchPath, directory->path, change.name);
+            if (m_changed.find(m_scratchPath) == m_changed.end()) {
+                m_changed.insert(m_scratchPath);
+            }
+            break;
+        case FileChangeKind::Removed:
+        case FileChangeKind::RenamedFrom:
+            // A subfolder going away takes everything cached beneath it along
+            Join(m_scratchPath, directory->path, change.name);
+            m_removedTrees.insert(m_scratchPath);
+            m_changed.insert(m_scratchPath);
+            break;
+        case FileChangeKind::Overflow:
+            m_rescan.push_back(directory->path);
+            break;
+        case FileChangeKind::Lost:
+            m_removedTrees.insert(directory->path);
+            m_directories.erase(directory);
+            m_directoryCount.store(m_directories.size(), std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    void ChangeMonitor::Dispatch() {
+        if (m_rescanAll || !m_rescan.empty()) {
+            m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+            if (m_rescanAll) {
+                m_rescan.clear();
+                for (const Directory& directory : m_directories) {
+                    m_rescan.push_back(directory.path);
+                }
+                m_rescanAll = false;
+            }
+            std::sort(m_rescan.begin(), m_rescan.end());
+            m_rescan.erase(std::unique(m_rescan.begin(), m_rescan.end()), m_rescan.end());
+
+            auto deadline = std::chrono::steady_clock::now() + RESCAN_BUDGET;
+            size_t budgetFiles = RESCAN_MAX_FILES;
+            for (const std::wstring& directory : m_rescan) {
+                Rescan(directory, deadline, budgetFiles);
+            }
+            m_rescan.clear();
+        }
+
+        ChangeBatch batch;
+        batch.paths.reserve(m_changed.size());
+        for (auto it = m_changed.begin(); it != m_changed.end();) {
+            batch.paths.push_back(std::move(m_changed.extract(it++).value()));
+        }
+        batch.removedTrees.reserve(m_removedTrees.size());
+        for (auto it = m_removedTrees.begin(); it != m_removedTrees.end();) {
+            batch.removedTrees.push_back(std::move(m_removedTrees.extract(it++).value()));
+        }
+
+        for (ChangeSubscriber* subscriber : m_subscribers) {
+            subscriber->OnChanges(batch);
+        }
+
+        uint64_t latency = MicrosecondsSince(m_batchStart);
+        m_batchCount.fetch_add(1, std::memory_order_relaxed);
+        m_pathCount.fetch_add(batch.paths.size(), std::memory_order_relaxed);
+        m_lastLatencyUs.store(latency, std::memory_order_relaxed);
+        if (latency > m_maxLatencyUs.load(std::memory_order_relaxed)) {
+            m_maxLatencyUs.store(latency, std::memory_order_relaxed);
+        }
+    }
+
+    void ChangeMonitor::Rescan(const std::wstring& directory, std::chrono::steady_clock::time_point deadline,
+                               size_t& budgetFiles) {
+        std::vector<WatchedFile> files;
+        for (ChangeSubscriber* subscriber : m_subscribers) {
+            subscriber->CollectWatched(directory, files);
+        }
+        // Several subscribers (or kinds of entry) may hold the same file
+        std::sort(files.begin(), files.end(),
+                  [](const WatchedFile& a, const WatchedFile& b) { return a.path < b.path; });
+
+        for (size_t i = 0; i < files.size();) {
+            size_t end = i + 1;
+            while (end < files.size() && files[end].path == files[i].path) {
+                ++end;
+            }
+
+            bool unchanged = false;
+            auto now = std::chrono::steady_clock::now();
+            if (budgetFiles > 0 && now < deadline) {
+                --budgetFiles;
+                m_rescannedCount.fetch_add(1, std::memory_order_relaxed);
+                auto stat = m_ioScheduler.Stat(files[i].path,
+                                               std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now),
+                                               IOPriority::Speculative);
+                unchanged = stat && stat->exists && !stat->isDirectory &&
+                    std::all_of(files.begin() + i, files.begin() + end, [&](const WatchedFile& file) {
+                        return file.size == stat->size && file.modifiedTime == stat->modifiedTime;
+                    });
+            }
+            // Out of budget counts as changed: dropping a good entry only costs a re-probe
+            if (!unchanged) {
+                m_changed.insert(std::move(files[i].path));
+            }
+            i = end;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "../io/DirectoryWatcher.h"
+#include "../io/IOScheduler.h"
+
+namespace Lumos {
+    // A file some subscriber holds derived data for, with the stamp it was derived from
+    struct WatchedFile {
+        std::wstring path;
+        uint64_t size;
+        uint64_t modifiedTime;
+    };
+
+    // One coalesced round of changes, full paths without duplicates
+    struct ChangeBatch {
+        std::vector<std::wstring> paths;         // Created, modified, removed or renamed
+        std::vector<std::wstring> removedTrees;  // May have been directories: anything beneath them is stale too
+    };
+
+    // Holder of data derived from files (preview cache, folder summaries,
+    // selection state) that wants to drop it as soon as the files change
+    class ChangeSubscriber {
+    public:
+        virtual ~ChangeSubscriber() = default;
+
+        // Called on the monitor thread; should not block on slow work
+        virtual void OnChanges(const ChangeBatch& batch) = 0;
+
+        // Append the files directly inside `directory` this subscriber holds
+        // data for. Used to find what changed after events were lost.
+        virtual void CollectWatched(std::wstring_view directory, std::vector<WatchedFile>& files) = 0;
+    };
+
+    struct ChangeMonitorStats {
+        uint64_t events;           // Raw notifications received
+        uint64_t batches;          // Rounds delivered to subscribers
+        uint64_t pathsChanged;     // Distinct paths delivered, summed over batches
+        uint64_t overflows;        // Times events were lost and a rescan was needed
+        uint64_t rescannedFiles;   // Files stat'ed by rescans
+        uint64_t lastLatencyUs;    // First event of the last batch to subscribers done
+        uint64_t maxLatencyUs;
+        size_t directories;        // Currently watched
+    };
+
+    // Watches the folders of recently previewed files and tells subscribers
+    // which paths changed. Notifications arriving in a burst (an unzip, a
+    // build, a sync client) are merged into one batch that ends after
+    // COALESCE_QUIET without events or COALESCE_MAX after its first event.
+    // When the kernel drops events, the affected folders are rescanned: the
+    // subscribers' files there are stat'ed, at most RESCAN_MAX_FILES within
+    // RESCAN_BUDGET, and whatever could not be checked is reported changed.
+    class ChangeMonitor {
+    public:
+        static constexpr size_t MAX_DIRECTORIES = 32;
+        static constexpr auto COALESCE_QUIET = std::chrono::milliseconds(20);
+        static constexpr auto COALESCE_MAX = std::chrono::milliseconds(100);
+        static constexpr size_t RESCAN_MAX_FILES = 1024;
+        static constexpr auto RESCAN_BUDGET = std::chrono::milliseconds(250);
+
+        explicit ChangeMonitor(IOScheduler& ioScheduler);
+        ~ChangeMonitor();
+
+        ChangeMonitor(const ChangeMonitor&) = delete;
+        ChangeMonitor& operator=(const ChangeMonitor&) = delete;
+
+        // Before Start(); `subscriber` must outlive the monitor
+        void Subscribe(ChangeSubscriber& subscriber);
+
+        bool Start();
+        void Stop();
+
+        // Watch the folder holding `path`. The least recently used folder is
+        // dropped beyond MAX_DIRECTORIES; its subscribers' data is still
+        // checked against file stamps on use. Cheap and non-blocking.
+        void WatchDirectoryOf(std::wstring_view path);
+
+        ChangeMonitorStats Stats() const;
+
+    private:
+        struct Directory {
+            std::wstring path;
+            int watch;
+        };
+
+        void Run();
+        void ApplyRequests();
+        void Record(const FileChange& change);
+        void Dispatch();
+        void Rescan(const std::wstring& directory, std::chrono::steady_clock::time_point deadline,
+                    size_t& budgetFiles);
+        std::list<Directory>::iterator FindWatch(int watch);
+
+        IOScheduler& m_ioScheduler;
+        std::vector<ChangeSubscriber*> m_subscribers;
+
+        DirectoryWatcher m_watcher;
+        std::thread m_thread;
+        std::atomic<bool> m_stopping;
+
+        std::mutex m_requestMutex;
+        std::vector<std::wstring> m_requests; // Folders to watch, oldest first, in the first m_requestCount
+        size_t m_requestCount;                // slots; the rest keep their capacity for later presses
+
+        // Monitor thread only
+        std::list<Directory> m_directories;    // Most recently used at the front
+        std::vector<std::wstring> m_applying;  // Swapped with m_requests
+        std::unordered_set<std::wstring> m_changed;
+        std::unordered_set<std::wstring> m_removedTrees;
+        std::vector<std::wstring> m_rescan;
+        bool m_rescanAll;
+        std::chrono::steady_clock::time_point m_batchStart;
+        std::vector<FileChange> m_events;
+        std::wstring m_scratchPath;
+
+        std::atomic<uint64_t> m_eventCount;
+        std::atomic<uint64_t> m_batchCount;
+        std::atomic<uint64_t> m_pathCount;
+        std::atomic<uint64_t> m_overflowCount;
+        std::atomic<uint64_t> m_rescannedCount;
+        std::atomic<uint64_t> m_lastLatencyUs;
+        std::atomic<uint64_t> m_maxLatencyUs;
+        std::atomic<size_t> m_directoryCount;
+    };
+}
@@ -0,0 +1,212 @@
+#include "PreviewCache.h"
+
+namespace Lumos {
+    namespace {
+        // Bookkeeping overhead per entry on top of the payload
+        constexpr size_t ENTRY_OVERHEAD = 128;
+
+        bool IsSeparator(wchar_t c) {
+            return c == L'\\' || c == L'/';
+        }
+    }
+
+    PreviewCache::PreviewCache(MemoryGovernor& governor, std::string name, PoolPriority priority)
+        : m_bytes(0)
+        , m_hits(0)
+        , m_misses(0)
+        , m_invalidated(0)
+    {
+        m_pool = governor.RegisterPool(std::move(name), priority, [this](size_t bytes) { return Trim(bytes); });
+    }
+
+    PreviewCache::~PreviewCache() {
+        Clear();
+    }
+
+    bool PreviewCache::PutErased(CacheKind kind, std::wstring_view path, uint64_t size, uint64_t modifiedTime,
+                                 std::shared_ptr<const void> value, size_t bytes) {
+        bytes += ENTRY_OVERHEAD + path.size() * sizeof(wchar_t) * 2;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        BuildKey(m_scratchKey, kind, path);
+
+        auto existing = m_index.find(m_scratchKey);
+        if (existing != m_index.end()) {
+            EraseLocked(existing->second);
+        }
+
+        // Make room: other pools are reclaimed first by the governor; if that is
+        // not enough, give up our own least recently used entries
+        while (!m_pool->TryCharge(bytes)) {
+            if (EvictLruLocked() == 0) {
+                return false;
+            }
+        }
+
+        m_lru.push_front(Entry{ m_scratchKey, std::wstring(path), size, modifiedTime, std::move(value), bytes });
+        m_index.emplace(m_lru.front().key, m_lru.begin());
+        m_kindsByPath[m_lru.front().path] |= 1u << static_cast<uint32_t>(kind);
+        m_bytes += bytes;
+        return true;
+    }
+
+    std::shared_ptr<const void> PreviewCache::GetErased(CacheKind kind, std::wstring_view path,
+                                                        uint64_t size, uint64_t modifiedTime) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        BuildKey(m_scratchKey, kind, path);
+
+        auto it = m_index.find(m_scratchKey);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+
+        auto entry = it->second;
+        if (entry->size != size || entry->modifiedTime != modifiedTime) {
+            // File changed since the entry was derived
+            EraseLocked(entry);
+            ++m_misses;
+            return nullptr;
+        }
+
+        m_lru.splice(m_lru.begin(), m_lru, entry);
+        m_pool->Touch();
+        ++m_hits;
+        return entry->value;
+    }
+
+    void PreviewCache::Invalidate(std::wstring_view path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        InvalidateLocked(path);
+    }
+
+    void PreviewCache::InvalidateUnder(std::wstring_view directory) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        InvalidateUnderLocked(directory);
+    }
+
+    void PreviewCache::OnChanges(const ChangeBatch& batch) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const std::wstring& path : batch.paths) {
+            InvalidateLocked(path);
+        }
+        for (const std::wstring& directory : batch.removedTrees) {
+            InvalidateUnderLocked(directory);
+        }
+    }
+
+    void PreviewCache::CollectWatched(std::wstring_view directory, std::vector<WatchedFile>& files) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Entry& entry : m_lru) {
+            size_t slash = entry.path.find_last_of(L"\\/");
+            if (slash == std::wstring::npos) {
+                continue;
+            }
+            // Roots keep their separator ("C:\", "/"), other folders do not
+            std::wstring_view parent(entry.path.data(), slash);
+            if (parent == directory || (slash + 1 == directory.size() && entry.path.compare(0, slash + 1, directory) == 0)) {
+                files.push_back(WatchedFile{ entry.path, entry.size, entry.modifiedTime });
+            }
+        }
+    }
+
+    void PreviewCache::InvalidateLocked(std::wstring_view path) {
+        // Look up only the kinds held for the path instead of walking the LRU
+        auto kinds = m_kindsByPath.find(std::wstring(path));
+        if (kinds == m_kindsByPath.end()) {
+            return;
+        }
+        uint32_t mask = kinds->second;
+        for (uint32_t kind = 0; mask != 0; ++kind, mask >>= 1) {
+            if (!(mask & 1)) {
+                continue;
+            }
+            BuildKey(m_scratchKey, static_cast<CacheKind>(kind), path);
+            auto it = m_index.find(m_scratchKey);
+            if (it != m_index.end()) {
+                EraseLocked(it->second);
+                ++m_invalidated;
+            }
+        }
+    }
+
+    void PreviewCache::InvalidateUnderLocked(std::wstring_view directory) {
+        // Rare (a folder was deleted or renamed), so a scan of the paths is fine
+        if (directory.empty()) {
+            return;
+        }
+        std::vector<std::wstring> doomed;
+        for (const auto& [path, kinds] : m_kindsByPath) {
+            if (path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+                (IsSeparator(path[directory.size()]) || IsSeparator(directory.back()))) {
+                doomed.push_back(path);
+            }
+        }
+        for (const std::wstring& path : doomed) {
+            InvalidateLocked(path);
+        }
+    }
+
+    void PreviewCache::Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pool->Release(m_bytes);
+        m_lru.clear();
+        m_index.clear();
+        m_kindsByPath.clear();
+        m_bytes = 0;
+    }
+
+    PreviewCacheStats PreviewCache::Stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return { m_hits, m_misses, m_invalidated, m_lru.size(), m_bytes };
+    }
+
+    size_t PreviewCache::Trim(size_t bytes) {
+        // Called by the governor from another pool's charge; never block on our
+        // own lock, a thread holding it may be the one waiting on that reclaim
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return 0;
+        }
+
+        size_t freed = 0;
+        while (freed < bytes) {
+            size_t got = EvictLruLocked();
+            if (got == 0) {
+                break;
+            }
+            freed += got;
+        }
+        return freed;
+    }
+
+    size_t PreviewCache::EvictLruLocked() {
+        if (m_lru.empty()) {
+            return 0;
+        }
+        size_t bytes = m_lru.back().bytes;
+        EraseLocked(std::prev(m_lru.end()));
+        return bytes;
+    }
+
+    void PreviewCache::EraseLocked(std::list<Entry>::iterator it) {
+        m_pool->Release(it->bytes);
+        m_bytes -= it->bytes;
+        m_index.erase(it->key);
+        auto kinds = m_kindsByPath.find(it->path);
+        if (kinds != m_kindsByPath.end()) {
+            kinds->second &= ~(1u << static_cast<uint32_t>(it->key[0] - L'0'));
+            if (kinds->second == 0) {
+                m_kindsByPath.erase(kinds);
+            }
+        }
+        m_lru.erase(it);
+    }
+
+    void PreviewCache::BuildKey(std::wstring& key, CacheKind kind, std::wstring_view path) {
+        key.clear();
+        key.push_back(static_cast<wchar_t>(L'0' + static_cast<uint32_t>(kind)));
+        key.push_back(L'|');
+        key.append(path);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "ChangeMonitor.h"
+#include "../memory/MemoryGovernor.h"
+
+namespace Lumos {
+    // What a cache entry holds. One file can have several entries of different kinds.
+    enum class CacheKind : uint32_t {
+        Generic = 0,
+        ImageHeader = 1,      // engines/image ImageHeader
+        EmbeddedPreview = 2,  // engines/image EmbeddedPreview; length 0 = file has none
+        FileHashes = 3        // engines/hash FileHashes
+    };
+
+    struct PreviewCacheStats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t invalidated;  // Entries dropped because their file changed
+        size_t entries;
+        size_t bytes;
+    };
+
+    // LRU cache of derived preview data keyed by (kind, path). Entries carry the
+    // file size and modification stamp they were derived from and are dropped
+    // on lookup when the file no longer matches; with a ChangeMonitor they are
+    // dropped as soon as the file changes. Memory is charged to a governor
+    // pool, which may evict entries under pressure.
+    class PreviewCache : public ChangeSubscriber {
+    public:
+        PreviewCache(MemoryGovernor& governor, std::string name, PoolPriority priority = PoolPriority::Cache);
+        ~PreviewCache() override;
+
+        PreviewCache(const PreviewCache&) = delete;
+        PreviewCache& operator=(const PreviewCache&) = delete;
+
+        template <typename T>
+        bool Put(CacheKind kind, std::wstring_view path, uint64_t size, uint64_t modifiedTime,
+                 std::shared_ptr<const T> value, size_t bytes) {
+            return PutErased(kind, path, size, modifiedTime, std::static_pointer_cast<const void>(std::move(value)), bytes);
+        }
+
+        template <typename T>
+        std::shared_ptr<const T> Get(CacheKind kind, std::wstring_view path, uint64_t size, uint64_t modifiedTime) {
+            return std::static_pointer_cast<const T>(GetErased(kind, path, size, modifiedTime));
+        }
+
+        // Drop every entry for `path`, whatever its kind
+        void Invalidate(std::wstring_view path);
+        // Drop every entry for a path beneath `directory`
+        void InvalidateUnder(std::wstring_view directory);
+        void Clear();
+
+        void OnChanges(const ChangeBatch& batch) override;
+        void CollectWatched(std::wstring_view directory, std::vector<WatchedFile>& files) override;
+
+        PreviewCacheStats Stats() const;
+
+    private:
+        struct Entry {
+            std::wstring key;
+            std::wstring path;
+            uint64_t size;
+            uint64_t modifiedTime;
+            std::shared_ptr<const void> value;
+            size_t bytes;
+        };
+
+        bool PutErased(CacheKind kind, std::wstring_view path, uint64_t size, uint64_t modifiedTime,
+                       std::shared_ptr<const void> value, size_t bytes);
+        std::shared_ptr<const void> GetErased(CacheKind kind, std::wstring_view path, uint64_t size, uint64_t modifiedTime);
+
+        // Evict least recently used entries until `bytes` are freed (reclaim callback)
+        size_t Trim(size_t bytes);
+        size_t EvictLruLocked();
+        void EraseLocked(std::list<Entry>::iterator it);
+        void InvalidateLocked(std::wstring_view path);
+        void InvalidateUnderLocked(std::wstring_view directory);
+        static void BuildKey(std::wstring& key, CacheKind kind, std::wstring_view path);
+
+        mutable std::mutex m_mutex;
+        std::list<Entry> m_lru; // Most recently used at the front
+        std::unordered_map<std::wstring, std::list<Entry>::iterator> m_index;
+        std::unordered_map<std::wstring, uint32_t> m_kindsByPath; // Bit per CacheKind held for the path
+        std::wstring m_scratchKey;
+        size_t m_bytes;
+        uint64_t m_hits;
+        uint64_t m_misses;
+        uint64_t m_invalidated;
+
+        std::shared_ptr<MemoryPool> m_pool;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Lumos {
+    // Bounds-checked, non-owning view over untrusted bytes (file headers,
+    // mapped files). Integer readers return 0 past the end; parsers call
+    // Has() before trusting a field so truncated input is never misread.
+    class ByteView {
+    public:
+        ByteView()
+            : m_data(nullptr)
+            , m_size(0)
+        {
+        }
+
+        ByteView(const uint8_t* data, size_t size)
+            : m_data(data)
+            , m_size(data ? size : 0)
+        {
+        }
+
+        const uint8_t* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+        bool Empty() const { return m_size == 0; }
+
+        // [offset, offset + length) lies inside the view (overflow-safe)
+        bool Has(size_t offset, size_t length) const {
+            return offset <= m_size && length <= m_size - offset;
+        }
+
+        // Sub-range clamped to what is actually available
+        ByteView Sub(size_t offset, size_t length = SIZE_MAX) const {
+            if (offset >= m_size) {
+                return ByteView();
+            }
+            size_t available = m_size - offset;
+            return ByteView(m_data + offset, length < available ? length : available);
+        }
+
+        bool Matches(size_t offset, const void* bytes, size_t length) const {
+            return Has(offset, length) && std::memcmp(m_data + offset, bytes, length) == 0;
+        }
+
+        uint8_t U8(size_t offset) const {
+            return Has(offset, 1) ? m_data[offset] : 0;
+        }
+
+        uint16_t U16LE(size_t offset) const {
+            if (!Has(offset, 2)) return 0;
+            return static_cast<uint16_t>(m_data[offset] | (m_data[offset + 1] << 8));
+        }
+
+        uint16_t U16BE(size_t offset) const {
+            if (!Has(offset, 2)) return 0;
+            return static_cast<uint16_t>((m_data[offset] << 8) | m_data[offset + 1]);
+        }
+
+        uint32_t U24LE(size_t offset) const {
+            if (!Has(offset, 3)) return 0;
+            return static_cast<uint32_t>(m_data[offset]) |
+                   (static_cast<uint32_t>(m_data[offset + 1]) << 8) |
+                   (static_cast<uint32_t>(m_data[offset + 2]) << 16);
+        }
+
+        uint32_t U32LE(size_t offset) const {
+            if (!Has(offset, 4)) return 0;
+            return static_cast<uint32_t>(m_data[offset]) |
+                   (static_cast<uint32_t>(m_data[offset + 1]) << 8) |
+                   (static_cast<uint32_t>(m_data[offset + 2]) << 16) |
+                   (static_cast<uint32_t>(m_data[offset + 3]) << 24);
+        }
+
+        uint32_t U32BE(size_t offset) const {
+            if (!Has(offset, 4)) return 0;
+            return (static_cast<uint32_t>(m_data[offset]) << 24) |
+                   (static_cast<uint32_t>(m_data[offset + 1]) << 16) |
+                   (static_cast<uint32_t>(m_data[offset + 2]) << 8) |
+                   static_cast<uint32_t>(m_data[offset + 3]);
+        }
+
+        uint64_t U64LE(size_t offset) const {
+            if (!Has(offset, 8)) return 0;
+            return static_cast<uint64_t>(U32LE(offset)) | (static_cast<uint64_t>(U32LE(offset + 4)) << 32);
+        }
+
+        uint64_t U64BE(size_t offset) const {
+            if (!Has(offset, 8)) return 0;
+            return (static_cast<uint64_t>(U32BE(offset)) << 32) | static_cast<uint64_t>(U32BE(offset + 4));
+        }
+
+        uint16_t U16(size_t offset, bool bigEndian) const {
+            return bigEndian ? U16BE(offset) : U16LE(offset);
+        }
+
+        uint32_t U32(size_t offset, bool bigEndian) const {
+            return bigEndian ? U32BE(offset) : U32LE(offset);
+        }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+namespace Lumos {
+    // Cooperative cancellation flag. Workers poll IsCancellationRequested()
+    // between units of work; the owner of the matching CancellationSource flips it.
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        bool IsCancellationRequested() const {
+            return m_state && m_state->load(std::memory_order_acquire);
+        }
+
+        // A default-constructed token can never be cancelled
+        bool CanBeCancelled() const { return m_state != nullptr; }
+
+        // Reads a flag someone else owns (a shared-memory section), which
+        // must outlive every copy of the token
+        static CancellationToken FromFlag(std::atomic<bool>& flag) {
+            return CancellationToken(std::shared_ptr<std::atomic<bool>>(std::shared_ptr<void>(), &flag));
+        }
+
+    private:
+        friend class CancellationSource;
+        explicit CancellationToken(std::shared_ptr<std::atomic<bool>> state)
+            : m_state(std::move(state))
+        {
+        }
+
+        std::shared_ptr<std::atomic<bool>> m_state;
+    };
+
+    class CancellationSource {
+    public:
+        CancellationSource()
+            : m_state(std::make_shared<std::atomic<bool>>(false))
+        {
+        }
+
+        CancellationToken Token() const { return CancellationToken(m_state); }
+
+        void Cancel() { m_state->store(true, std::memory_order_release); }
+
+        bool IsCancellationRequested() const { return m_state->load(std::memory_order_acquire); }
+
+        // Start over uncancelled. The flag is reused when no token still
+        // holds it, so a steady stream of renewals does not allocate; tokens
+        // handed out before keep the old, cancelled flag otherwise.
+        void Renew() {
+            if (m_state.use_count() == 1) {
+                m_state->store(false, std::memory_order_release);
+            } else {
+                m_state = std::make_shared<std::atomic<bool>>(false);
+            }
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_state;
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// Kernels for instruction sets beyond the x64 baseline (SSE2) are compiled
+// with LUMOS_TARGET and only called after checking CpuFeatures at run time.
+// MSVC needs no per-function target: it accepts every intrinsic anywhere.
+#if defined(_M_X64) || defined(__x86_64__)
+#define LUMOS_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define LUMOS_TARGET(features)
+#else
+#include <cpuid.h>
+#define LUMOS_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+namespace Lumos {
+    struct CpuFeatures {
+        bool sse42;   // SSE4.2 (CRC32C), implies SSSE3 and SSE4.1
+        bool avx2;    // Including OS support for the YMM registers
+        bool sha;     // SHA-1 / SHA-256 extensions
+        bool pclmul;  // Carry-less multiply
+    };
+
+    // Detected once per process
+    inline const CpuFeatures& Cpu() {
+        static const CpuFeatures features = [] {
+            CpuFeatures detected{};
+#ifdef LUMOS_X64
+            unsigned int leaf1[4] = {};
+            unsigned int leaf7[4] = {};
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            int maxLeaf = info[0];
+            __cpuid(info, 1);
+            for (int i = 0; i < 4; ++i) {
+                leaf1[i] = static_cast<unsigned int>(info[i]);
+            }
+            if (maxLeaf >= 7) {
+                __cpuidex(info, 7, 0);
+                for (int i = 0; i < 4; ++i) {
+                    leaf7[i] = static_cast<unsigned int>(info[i]);
+                }
+            }
+            bool ymmEnabled = (leaf1[2] & (1u << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+#else
+            unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+            __get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+            if (maxLeaf >= 7) {
+                __get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+            }
+            // Also covers the OSXSAVE / XCR0 check
+            bool ymmEnabled = __builtin_cpu_supports("avx2");
+#endif
+            detected.sse42 = (leaf1[2] & (1u << 20)) != 0;
+            detected.pclmul = (leaf1[2] & (1u << 1)) != 0;
+            detected.avx2 = ymmEnabled && (leaf7[1] & (1u << 5)) != 0;
+            detected.sha = detected.sse42 && (leaf7[1] & (1u << 29)) != 0;
+#endif
+            return detected;
+        }();
+        return features;
+    }
+}
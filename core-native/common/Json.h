@@ -0,0 +1,94 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "Utf8.h"
+
+// Helpers for the JSON engines hand to the UI (PreviewMarkdown::blocksJson
+// and the like), written straight into arena-backed strings
+namespace Lumos {
+    // UTF-8 in, UTF-8 out; quotes, backslashes and control characters are
+    // escaped and malformed bytes become U+FFFD, so the UI never rejects
+    // a chunk because a file was not quite UTF-8
+    inline void AppendJsonString(std::pmr::string& out, std::string_view text) {
+        static const char HEX[] = "0123456789abcdef";
+
+        out.push_back('"');
+        size_t runStart = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x80) {
+                size_t length = Utf8SequenceLength(text, i);
+                if (length != 0) {
+                    i += length - 1;
+                    continue;
+                }
+                out.append(text.data() + runStart, i - runStart);
+                runStart = i + 1;
+                out.append("\xEF\xBF\xBD");
+                continue;
+            }
+            if (c != '"' && c != '\\' && c >= 0x20) {
+                continue;
+            }
+            out.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(HEX[c >> 4]);
+                out.push_back(HEX[c & 0xF]);
+                break;
+            }
+        }
+        out.append(text.data() + runStart, text.size() - runStart);
+        out.push_back('"');
+    }
+
+    // The same for UTF-16 text (paths and other Windows strings), written
+    // out as UTF-8
+    inline void AppendJsonString(std::pmr::string& out, std::wstring_view text) {
+        static const char HEX[] = "0123456789abcdef";
+
+        out.push_back('"');
+        size_t runStart = 0;
+        auto flush = [&](size_t end) {
+            if (end > runStart) {
+                AppendUtf8(out, text.substr(runStart, end - runStart));
+            }
+        };
+
+        for (size_t i = 0; i < text.size(); ++i) {
+            wchar_t c = text[i];
+            if (c == L'\\' || c == L'"') {
+                flush(i);
+                out.push_back('\\');
+                out.push_back(static_cast<char>(c));
+                runStart = i + 1;
+            } else if (c < 0x20) {
+                flush(i);
+                out.append("\\u00");
+                out.push_back(HEX[(c >> 4) & 0xF]);
+                out.push_back(HEX[c & 0xF]);
+                runStart = i + 1;
+            }
+        }
+        flush(text.size());
+        out.push_back('"');
+    }
+
+    inline void AppendField(std::pmr::string& out, const char* name, uint64_t value) {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(",\"");
+        out.append(name);
+        out.append("\":");
+        out.append(buffer, result.ptr);
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Static lookup tables for short keys (file extensions, magic numbers):
+// hash-and-displace perfect hashing, the CHD scheme without its
+// compression. Keys are split into buckets by one hash; buckets are placed
+// largest first, each trying displacements until all of its keys land on
+// free slots. A lookup is two hashes, two loads and one compare, with no
+// probe sequence and no string compares, whatever the table holds.
+namespace Lumos {
+    namespace PerfectHash {
+        constexpr uint32_t MAX_DISPLACEMENT = 1u << 16;
+        constexpr uint32_t MAX_SEEDS = 64;
+
+        // splitmix64 finalizer
+        constexpr uint64_t Mix(uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xBF58476D1CE4E5B9ull;
+            x ^= x >> 27;
+            x *= 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        constexpr size_t NextPowerOfTwo(size_t n) {
+            size_t power = 1;
+            while (power < n) {
+                power <<= 1;
+            }
+            return power;
+        }
+
+        // Buckets average two keys; slots are filled to between 40% and 80%
+        constexpr size_t BucketCount(size_t keys) { return NextPowerOfTwo(keys / 2 + 1); }
+        constexpr size_t SlotCount(size_t keys) { return NextPowerOfTwo(keys + keys / 4 + 1); }
+
+        constexpr uint64_t SeedAt(uint32_t attempt) {
+            return Mix(0x9E3779B97F4A7C15ull * (attempt + 1));
+        }
+
+        constexpr size_t SlotOf(uint64_t hash, uint32_t displacement, size_t slotMask) {
+            return static_cast<size_t>(Mix(hash + displacement)) & slotMask;
+        }
+
+        template <typename Value>
+        struct Entry {
+            uint64_t key = 0;
+            Value value{};
+            bool used = false;
+        };
+
+        template <typename Value>
+        constexpr const Value* Find(uint64_t key, uint64_t seed, const uint32_t* displacements, size_t bucketMask,
+                                    const Entry<Value>* slots, size_t slotMask) {
+            uint64_t hash = Mix(key ^ seed);
+            const Entry<Value>& entry = slots[SlotOf(hash, displacements[hash & bucketMask], slotMask)];
+            return entry.used && entry.key == key ? &entry.value : nullptr;
+        }
+
+        // Place `count` distinct keys under `seed`. `slots` (slotMask + 1,
+        // all unused) and `displacements` (bucketMask + 1) receive the
+        // layout; `order` (count) and `starts` (bucketMask + 2) are scratch.
+        // False if some bucket found no free displacement; `slots` is then
+        // left partly filled and must be cleared before the next seed.
+        template <typename Value>
+        constexpr bool Place(const Entry<Value>* entries, size_t count, uint64_t seed,
+                             uint32_t* displacements, size_t bucketMask, Entry<Value>* slots, size_t slotMask,
+                             uint32_t* order, uint32_t* starts) {
+            // Counting sort of the keys by bucket
+            size_t buckets = bucketMask + 1;
+            for (size_t b = 0; b <= buckets; ++b) {
+                starts[b] = 0;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                ++starts[(Mix(entries[i].key ^ seed) & bucketMask) + 1];
+            }
+            uint32_t largest = 0;
+            for (size_t b = 0; b < buckets; ++b) {
+                largest = starts[b + 1] > largest ? starts[b + 1] : largest;
+                starts[b + 1] += starts[b];
+            }
+            for (size_t i = 0; i < count; ++i) {
+                order[starts[Mix(entries[i].key ^ seed) & bucketMask]++] = static_cast<uint32_t>(i);
+            }
+            for (size_t b = buckets; b > 0; --b) {
+                starts[b] = starts[b - 1];
+            }
+            starts[0] = 0;
+
+            // Crowded buckets first, while most slots are still free
+            for (uint32_t size = largest; size > 0; --size) {
+                for (size_t b = 0; b < buckets; ++b) {
+                    if (starts[b + 1] - starts[b] != size) {
+                        continue;
+                    }
+                    bool placed = false;
+                    for (uint32_t displacement = 0; displacement < MAX_DISPLACEMENT && !placed; ++displacement) {
+                        uint32_t k = starts[b];
+                        for (; k < starts[b + 1]; ++k) {
+                            const Entry<Value>& entry = entries[order[k]];
+                            Entry<Value>& slot = slots[SlotOf(Mix(entry.key ^ seed), displacement, slotMask)];
+                            if (slot.used) {
+                                break;
+                            }
+                            slot = entry;
+                            slot.used = true;
+                        }
+                        placed = k == starts[b + 1];
+                        if (!placed) {
+                            for (uint32_t undo = starts[b]; undo < k; ++undo) {
+                                slots[SlotOf(Mix(entries[order[undo]].key ^ seed), displacement, slotMask)].used = false;
+                            }
+                        } else {
+                            displacements[b] = displacement;
+                        }
+                    }
+                    if (!placed) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    // Built at compile time from a fixed list of distinct keys; check
+    // IsValid() in a static_assert
+    template <typename Value, size_t Count>
+    class StaticPerfectHashMap {
+    public:
+        using Entry = PerfectHash::Entry<Value>;
+
+        static constexpr size_t BUCKETS = PerfectHash::BucketCount(Count);
+        static constexpr size_t SLOTS = PerfectHash::SlotCount(Count);
+
+        constexpr explicit StaticPerfectHashMap(const std::array<Entry, Count>& entries)
+            : m_seed(0)
+            , m_displacements{}
+            , m_slots{}
+            , m_valid(false)
+        {
+            std::array<uint32_t, Count> order{};
+            std::array<uint32_t, BUCKETS + 1> starts{};
+            for (uint32_t attempt = 0; attempt < PerfectHash::MAX_SEEDS && !m_valid; ++attempt) {
+                for (size_t s = 0; s < SLOTS; ++s) {
+                    m_slots[s] = Entry{};
+                }
+                m_seed = PerfectHash::SeedAt(attempt);
+                m_valid = PerfectHash::Place(entries.data(), Count, m_seed, m_displacements.data(), BUCKETS - 1,
+                                             m_slots.data(), SLOTS - 1, order.data(), starts.data());
+            }
+        }
+
+        constexpr bool IsValid() const { return m_valid; }
+
+        constexpr const Value* Find(uint64_t key) const {
+            return PerfectHash::Find(key, m_seed, m_displacements.data(), BUCKETS - 1, m_slots.data(), SLOTS - 1);
+        }
+
+    private:
+        uint64_t m_seed;
+        std::array<uint32_t, BUCKETS> m_displacements;
+        std::array<Entry, SLOTS> m_slots;
+        bool m_valid;
+    };
+
+    // Built at run time, once, then read-only
+    template <typename Value>
+    class PerfectHashMap {
+    public:
+        using Entry = PerfectHash::Entry<Value>;
+
+        PerfectHashMap()
+            : m_seed(0)
+            , m_displacements(1, 0)
+            , m_slots(1)
+            , m_size(0)
+        {
+        }
+
+        // Keys must be distinct. False (and the map left empty) only if no
+        // seed worked, which for distinct keys does not happen in practice.
+        bool Build(const std::vector<Entry>& entries) {
+            size_t buckets = PerfectHash::BucketCount(entries.size());
+            size_t slots = PerfectHash::SlotCount(entries.size());
+            std::vector<uint32_t> order(entries.size());
+            std::vector<uint32_t> starts(buckets + 1);
+            m_displacements.assign(buckets, 0);
+            for (uint32_t attempt = 0; attempt < PerfectHash::MAX_SEEDS; ++attempt) {
+                m_slots.assign(slots, Entry{});
+                m_seed = PerfectHash::SeedAt(attempt);
+                if (PerfectHash::Place(entries.data(), entries.size(), m_seed, m_displacements.data(), buckets - 1,
+                                       m_slots.data(), slots - 1, order.data(), starts.data())) {
+                    m_size = entries.size();
+                    return true;
+                }
+            }
+            *this = PerfectHashMap();
+            return false;
+        }
+
+        const Value* Find(uint64_t key) const {
+            return PerfectHash::Find(key, m_seed, m_displacements.data(), m_displacements.size() - 1,
+                                     m_slots.data(), m_slots.size() - 1);
+        }
+
+        size_t Size() const { return m_size; }
+
+    private:
+        uint64_t m_seed;
+        std::vector<uint32_t> m_displacements;
+        std::vector<Entry> m_slots;
+        size_t m_size;
+    };
+
+    // ASCII extension with its leading dot, folded to lower case and packed
+    // into a key. 0 (matches nothing) if empty, more than 8 characters
+    // after the dot, or not ASCII.
+    template <typename Char>
+    constexpr uint64_t ExtensionKey(std::basic_string_view<Char> extension) {
+        if (extension.size() < 2 || extension.size() > 9 || extension[0] != '.') {
+            return 0;
+        }
+        uint64_t key = 0;
+        for (size_t i = 1; i < extension.size(); ++i) {
+            auto c = static_cast<uint32_t>(extension[i]);
+            if (c == 0 || c > 0x7F) {
+                return 0;
+            }
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            key |= static_cast<uint64_t>(c) << (8 * (i - 1));
+        }
+        return key;
+    }
+
+    constexpr uint64_t ExtensionKey(std::wstring_view extension) { return ExtensionKey<wchar_t>(extension); }
+    constexpr uint64_t ExtensionKey(std::string_view extension) { return ExtensionKey<char>(extension); }
+
+    // Up to 8 bytes packed in file order
+    constexpr uint64_t SignatureKey(const uint8_t* bytes, size_t length) {
+        uint64_t key = 0;
+        for (size_t i = 0; i < length && i < 8; ++i) {
+            key |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        }
+        return key;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cwctype>
+#include <initializer_list>
+#include <string_view>
+
+namespace Lumos {
+    // Case-insensitive comparison for file extensions and other short tokens
+    inline bool EqualsIgnoreCase(std::wstring_view a, std::wstring_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (std::towlower(a[i]) != std::towlower(b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // ASCII-only folding, as SQL and most file formats compare identifiers
+    inline bool EqualsIgnoreCaseAscii(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            char y = b[i] >= 'A' && b[i] <= 'Z' ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+            if (x != y) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // `extension` (with its leading dot) is one of `known`
+    inline bool ExtensionIn(std::wstring_view extension, std::initializer_list<std::wstring_view> known) {
+        for (std::wstring_view candidate : known) {
+            if (EqualsIgnoreCase(extension, candidate)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
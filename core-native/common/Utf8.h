@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Lumos {
+    // Append wide text as UTF-8. wchar_t is UTF-16 on Windows and UTF-32 elsewhere;
+    // unpaired surrogates are replaced with U+FFFD.
+    template <typename String>
+    void AppendUtf8(String& out, std::wstring_view text) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            uint32_t cp = static_cast<uint32_t>(text[i]);
+
+            if constexpr (sizeof(wchar_t) == 2) {
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    if (i + 1 < text.size()) {
+                        uint32_t low = static_cast<uint32_t>(text[i + 1]);
+                        if (low >= 0xDC00 && low <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            ++i;
+                        } else {
+                            cp = 0xFFFD;
+                        }
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+            } else if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                cp = 0xFFFD;
+            }
+
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+    }
+
+    inline std::string ToUtf8(std::wstring_view text) {
+        std::string out;
+        out.reserve(text.size());
+        AppendUtf8(out, text);
+        return out;
+    }
+
+    // Length of the well-formed UTF-8 sequence starting at `text[i]`, or 0 if
+    // the bytes there are malformed (truncated, overlong, surrogate, > U+10FFFF)
+    inline size_t Utf8SequenceLength(std::string_view text, size_t i) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            return 1;
+        }
+        size_t length = c >= 0xF0 && c <= 0xF4 ? 4 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xC2 && c <= 0xDF ? 2 : 0;
+        if (length == 0 || i + length > text.size()) {
+            return 0;
+        }
+        auto second = static_cast<unsigned char>(text[i + 1]);
+        if ((c == 0xE0 && second < 0xA0) || (c == 0xED && second > 0x9F) ||
+            (c == 0xF0 && second < 0x90) || (c == 0xF4 && second > 0x8F)) {
+            return 0;
+        }
+        for (size_t k = 1; k < length; ++k) {
+            if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+    // Decode UTF-8 (file names from the OS) to wide text; malformed bytes
+    // become U+FFFD
+    inline std::wstring FromUtf8(std::string_view text) {
+        std::wstring out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size();) {
+            size_t length = Utf8SequenceLength(text, i);
+            if (length == 0) {
+                out.push_back(static_cast<wchar_t>(0xFFFD));
+                ++i;
+                continue;
+            }
+
+            auto c = static_cast<unsigned char>(text[i]);
+            uint32_t cp = length == 1 ? c : length == 2 ? (c & 0x1F) : length == 3 ? (c & 0x0F) : (c & 0x07);
+            for (size_t k = 1; k < length; ++k) {
+                cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+            }
+            i += length;
+
+            if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+                cp -= 0x10000;
+                out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+                out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+            } else {
+                out.push_back(static_cast<wchar_t>(cp));
+            }
+        }
+        return out;
+    }
+}
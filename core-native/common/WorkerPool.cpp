@@ -0,0 +1,72 @@
+#include "WorkerPool.h"
+
+namespace Lumos {
+    WorkerPool::WorkerPool(size_t threadCount)
+        : m_nextSequence(0)
+        , m_running(0)
+        , m_stopping(false)
+    {
+        if (threadCount == 0) {
+            size_t cores = std::thread::hardware_concurrency();
+            threadCount = cores > 1 ? cores - 1 : 1;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        // Queued jobs still run: owners rely on them to release what they captured
+        WaitIdle();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::Submit(Job job, int priority) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push(Item{ priority, m_nextSequence++, std::move(job) });
+        }
+        m_wake.notify_one();
+    }
+
+    void WorkerPool::WaitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_queue.empty() && m_running == 0; });
+    }
+
+    size_t WorkerPool::Pending() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    void WorkerPool::WorkerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return; // Stopping
+            }
+
+            // priority_queue::top is const; the job is moved out just before pop
+            Job job = std::move(const_cast<Item&>(m_queue.top()).job);
+            m_queue.pop();
+            ++m_running;
+            lock.unlock();
+
+            job();
+
+            lock.lock();
+            --m_running;
+            if (m_queue.empty() && m_running == 0) {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Lumos {
+    // Fixed set of threads for short CPU-bound jobs (tile decodes, search
+    // chunks, hash lanes). Lower priority values run first, FIFO within a
+    // priority. Jobs must not block on I/O; that is the IOScheduler's job.
+    class WorkerPool {
+    public:
+        using Job = std::function<void()>;
+
+        // 0 = one thread per core, leaving one for the pipeline and UI
+        explicit WorkerPool(size_t threadCount = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        void Submit(Job job, int priority = 0);
+
+        // Block until every job submitted so far has finished
+        void WaitIdle();
+
+        size_t ThreadCount() const { return m_threads.size(); }
+        size_t Pending() const;
+
+    private:
+        struct Item {
+            int priority;
+            uint64_t sequence;
+            Job job;
+        };
+
+        struct Later {
+            bool operator()(const Item& a, const Item& b) const {
+                return a.priority != b.priority ? a.priority > b.priority : a.sequence > b.sequence;
+            }
+        };
+
+        void WorkerLoop();
+
+        std::vector<std::thread> m_threads;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::priority_queue<Item, std::vector<Item>, Later> m_queue;
+        uint64_t m_nextSequence;
+        size_t m_running;
+        bool m_stopping;
+    };
+}
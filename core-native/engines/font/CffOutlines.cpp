@@ -0,0 +1,549 @@
+#include "CffOutlines.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace Lumos {
+    namespace {
+        // DICT operators; escaped ones are 1200 + the second byte
+        constexpr uint32_t OP_CHARSTRINGS = 17;
+        constexpr uint32_t OP_PRIVATE = 18;
+        constexpr uint32_t OP_SUBRS = 19;
+        constexpr uint32_t OP_CHARSTRING_TYPE = 1206;
+        constexpr uint32_t OP_FONT_MATRIX = 1207;
+        constexpr uint32_t OP_ROS = 1230;
+        constexpr uint32_t OP_FD_ARRAY = 1236;
+        constexpr uint32_t OP_FD_SELECT = 1237;
+
+        constexpr size_t MAX_DICT_OPERANDS = 48;
+        constexpr size_t MAX_FONT_DICTS = 256;
+
+        uint32_t ReadOffset(ByteView bytes, size_t at, uint8_t size) {
+            uint32_t value = 0;
+            for (uint8_t i = 0; i < size; ++i) {
+                value = (value << 8) | bytes.U8(at + i);
+            }
+            return value;
+        }
+
+        // Packed BCD: digits, '.', 'E', 'E-', '-', end
+        bool ReadReal(ByteView dict, size_t& at, double& value) {
+            char text[64];
+            size_t length = 0;
+            while (at < dict.Size()) {
+                uint8_t byte = dict.U8(at++);
+                for (int shift = 4; shift >= 0; shift -= 4) {
+                    uint8_t nibble = (byte >> shift) & 0x0F;
+                    if (nibble == 0x0F) {
+                        text[length] = '\0';
+                        value = std::strtod(text, nullptr);
+                        return true;
+                    }
+                    if (length + 2 >= sizeof(text)) {
+                        return false;
+                    }
+                    if (nibble <= 9) {
+                        text[length++] = static_cast<char>('0' + nibble);
+                    } else if (nibble == 0x0A) {
+                        text[length++] = '.';
+                    } else if (nibble == 0x0B) {
+                        text[length++] = 'E';
+                    } else if (nibble == 0x0C) {
+                        text[length++] = 'E';
+                        text[length++] = '-';
+                    } else if (nibble == 0x0E) {
+                        text[length++] = '-';
+                    } else {
+                        return false;
+                    }
+                }
+            }
+            return false;
+        }
+
+        // Calls visit(op, operands, count) for each operator in a DICT
+        template <typename Visit>
+        bool ParseDict(ByteView dict, Visit&& visit) {
+            double operands[MAX_DICT_OPERANDS];
+            size_t count = 0;
+            size_t at = 0;
+            while (at < dict.Size()) {
+                uint8_t b0 = dict.U8(at++);
+                double value = 0;
+                if (b0 <= 21) {
+                    uint32_t op = b0;
+                    if (b0 == 12) {
+                        op = 1200 + dict.U8(at++);
+                    }
+                    visit(op, operands, count);
+                    count = 0;
+                    continue;
+                } else if (b0 == 28) {
+                    value = static_cast<int16_t>(dict.U16BE(at));
+                    at += 2;
+                } else if (b0 == 29) {
+                    value = static_cast<int32_t>(dict.U32BE(at));
+                    at += 4;
+                } else if (b0 == 30) {
+                    if (!ReadReal(dict, at, value)) {
+                        return false;
+                    }
+                } else if (b0 >= 32 && b0 <= 246) {
+                    value = static_cast<int>(b0) - 139;
+                } else if (b0 >= 247 && b0 <= 250) {
+                    value = (static_cast<int>(b0) - 247) * 256 + dict.U8(at++) + 108;
+                } else if (b0 >= 251 && b0 <= 254) {
+                    value = -(static_cast<int>(b0) - 251) * 256 - dict.U8(at++) - 108;
+                } else {
+                    return false;
+                }
+                if (count == MAX_DICT_OPERANDS) {
+                    return false;
+                }
+                operands[count++] = value;
+            }
+            return true;
+        }
+
+        // DICT numbers are untrusted doubles; offsets outside the table become 0
+        size_t ToOffset(double value) {
+            return value >= 0 && value < 4294967296.0 ? static_cast<size_t>(value) : 0;
+        }
+
+        uint32_t SubrBias(uint32_t count) {
+            return count < 1240 ? 107 : count < 33900 ? 1131 : 32768;
+        }
+    }
+
+    bool CffOutlines::Index::Read(ByteView cff, size_t offset) {
+        data = cff.Sub(offset);
+        count = data.U16BE(0);
+        if (count == 0) {
+            objects = end = 2;
+            return data.Has(0, 2);
+        }
+        offSize = data.U8(2);
+        if (offSize < 1 || offSize > 4) {
+            return false;
+        }
+        objects = 3 + (static_cast<size_t>(count) + 1) * offSize;
+        uint32_t last = ReadOffset(data, objects - offSize, offSize);
+        if (!data.Has(0, objects) || last < 1) {
+            return false;
+        }
+        end = objects + last - 1;
+        return data.Has(0, end);
+    }
+
+    ByteView CffOutlines::Index::Get(uint32_t i) const {
+        if (i >= count) {
+            return ByteView();
+        }
+        uint32_t first = ReadOffset(data, 3 + static_cast<size_t>(i) * offSize, offSize);
+        uint32_t next = ReadOffset(data, 3 + (static_cast<size_t>(i) + 1) * offSize, offSize);
+        if (first < 1 || next < first || objects + next - 1 > end) {
+            return ByteView();
+        }
+        return data.Sub(objects + first - 1, next - first);
+    }
+
+    CffOutlines::CffOutlines(ByteView cff, uint16_t unitsPerEm)
+        : m_cff(cff)
+        , m_valid(false)
+        , m_scale(1)
+        , m_fdSelectFormat(0)
+    {
+        if (cff.U8(0) != 1) {
+            return;
+        }
+        // Header, then the Name, Top DICT, String and Global Subr INDEXes back to back
+        size_t at = cff.U8(2);
+        Index names;
+        Index topDicts;
+        Index strings;
+        if (!names.Read(cff, at) || !topDicts.Read(cff, at += names.end) ||
+            !strings.Read(cff, at += topDicts.end) || !m_globalSubrs.Read(cff, at += strings.end)) {
+            return;
+        }
+
+        size_t charStrings = 0;
+        size_t privateSize = 0;
+        size_t privateOffset = 0;
+        size_t fdArray = 0;
+        size_t fdSelect = 0;
+        bool cid = false;
+        int charstringType = 2;
+        double fontMatrix = 0.001;
+        bool parsed = ParseDict(topDicts.Get(0), [&](uint32_t op, const double* operands, size_t count) {
+            double last = count > 0 ? operands[count - 1] : 0;
+            switch (op) {
+            case OP_CHARSTRINGS: charStrings = ToOffset(last); break;
+            case OP_PRIVATE:
+                if (count >= 2) {
+                    privateSize = ToOffset(operands[0]);
+                    privateOffset = ToOffset(operands[1]);
+                }
+                break;
+            case OP_CHARSTRING_TYPE: charstringType = last == 2 ? 2 : 0; break;
+            case OP_FONT_MATRIX: fontMatrix = count >= 1 ? operands[0] : fontMatrix; break;
+            case OP_ROS: cid = true; break;
+            case OP_FD_ARRAY: fdArray = ToOffset(last); break;
+            case OP_FD_SELECT: fdSelect = ToOffset(last); break;
+            }
+        });
+        if (!parsed || charstringType != 2 || charStrings == 0 || !m_charStrings.Read(cff, charStrings)) {
+            return;
+        }
+
+        // Charstring units to the head table's units per em (1 for nearly all fonts)
+        double scale = fontMatrix * unitsPerEm;
+        m_scale = std::isfinite(scale) && scale > 0.001 && scale < 1000 ? static_cast<float>(scale) : 1.0f;
+
+        if (cid) {
+            Index fonts;
+            if (fdArray == 0 || fdSelect == 0 || !fonts.Read(cff, fdArray)) {
+                return;
+            }
+            for (uint32_t i = 0; i < fonts.count && i < MAX_FONT_DICTS; ++i) {
+                size_t size = 0;
+                size_t offset = 0;
+                ParseDict(fonts.Get(i), [&](uint32_t op, const double* operands, size_t count) {
+                    if (op == OP_PRIVATE && count >= 2) {
+                        size = ToOffset(operands[0]);
+                        offset = ToOffset(operands[1]);
+                    }
+                });
+                m_fdSubrs.push_back(ReadPrivateSubrs(offset, size));
+            }
+            m_fdSelect = cff.Sub(fdSelect);
+            m_fdSelectFormat = m_fdSelect.U8(0);
+            if (m_fdSelectFormat != 0 && m_fdSelectFormat != 3) {
+                return;
+            }
+        } else {
+            m_localSubrs = ReadPrivateSubrs(privateOffset, privateSize);
+        }
+        m_valid = true;
+    }
+
+    // The Subrs offset is relative to the Private DICT
+    CffOutlines::Index CffOutlines::ReadPrivateSubrs(size_t offset, size_t size) const {
+        Index subrs;
+        if (size == 0 || !m_cff.Has(offset, size)) {
+            return subrs;
+        }
+        size_t relative = 0;
+        ParseDict(m_cff.Sub(offset, size), [&](uint32_t op, const double* operands, size_t count) {
+            if (op == OP_SUBRS && count >= 1 && operands[count - 1] > 0) {
+                relative = ToOffset(operands[count - 1]);
+            }
+        });
+        if (relative == 0 || !subrs.Read(m_cff, offset + relative)) {
+            return Index();
+        }
+        return subrs;
+    }
+
+    const CffOutlines::Index& CffOutlines::LocalSubrs(uint16_t glyph) const {
+        static const Index NONE;
+        if (m_fdSubrs.empty()) {
+            return m_localSubrs;
+        }
+        size_t fd = SIZE_MAX;
+        if (m_fdSelectFormat == 0) {
+            fd = m_fdSelect.Has(1 + glyph, 1) ? m_fdSelect.U8(1 + glyph) : SIZE_MAX;
+        } else {
+            // Ranges of (first glyph, fd) sorted by first glyph, then a sentinel
+            uint16_t ranges = m_fdSelect.U16BE(1);
+            size_t low = 0;
+            size_t high = ranges;
+            while (low < high) {
+                size_t mid = (low + high) / 2;
+                if (m_fdSelect.U16BE(3 + mid * 3) <= glyph) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low > 0 && m_fdSelect.Has(3 + low * 3, 2) && glyph < m_fdSelect.U16BE(3 + low * 3)) {
+                fd = m_fdSelect.U8(3 + (low - 1) * 3 + 2);
+            }
+        }
+        return fd < m_fdSubrs.size() ? m_fdSubrs[fd] : NONE;
+    }
+
+    // Interpreter state shared across subroutine calls: the argument stack
+    // persists through callsubr and return
+    struct CffOutlines::Machine {
+        GlyphOutline& outline;
+        float scale;
+        float stack[MAX_STACK];
+        size_t count = 0;
+        float x = 0;
+        float y = 0;
+        size_t stems = 0;
+        size_t operations = 0;
+        bool widthSeen = false;
+        bool open = false;
+        bool ended = false;
+
+        Machine(GlyphOutline& target, float unitsScale)
+            : outline(target)
+            , scale(unitsScale)
+        {
+        }
+
+        // The first stack-clearing operator may carry the advance width as
+        // an extra leading argument; returns where the real arguments start
+        size_t Width(bool present) {
+            if (widthSeen) {
+                return 0;
+            }
+            widthSeen = true;
+            return present ? 1 : 0;
+        }
+
+        void MoveTo(float dx, float dy) {
+            x += dx;
+            y += dy;
+            outline.MoveTo(x * scale, y * scale);
+            open = true;
+        }
+
+        void Begin() {
+            if (!open) {
+                outline.MoveTo(x * scale, y * scale);
+                open = true;
+            }
+        }
+
+        void LineTo(float dx, float dy) {
+            Begin();
+            x += dx;
+            y += dy;
+            outline.LineTo(x * scale, y * scale);
+        }
+
+        void CurveTo(float dx1, float dy1, float dx2, float dy2, float dx3, float dy3) {
+            Begin();
+            float x1 = x + dx1;
+            float y1 = y + dy1;
+            float x2 = x1 + dx2;
+            float y2 = y1 + dy2;
+            x = x2 + dx3;
+            y = y2 + dy3;
+            outline.CubicTo(x1 * scale, y1 * scale, x2 * scale, y2 * scale, x * scale, y * scale);
+        }
+    };
+
+    bool CffOutlines::LoadOutline(uint16_t glyph, GlyphOutline& outline) const {
+        if (!m_valid || glyph >= m_charStrings.count) {
+            return false;
+        }
+        Machine machine(outline, m_scale);
+        return Run(machine, m_charStrings.Get(glyph), LocalSubrs(glyph), 0);
+    }
+
+    bool CffOutlines::Run(Machine& m, ByteView code, const Index& localSubrs, size_t depth) const {
+        size_t at = 0;
+        while (at < code.Size()) {
+            if (++m.operations > MAX_OPERATIONS) {
+                return false;
+            }
+            uint8_t b0 = code.U8(at++);
+
+            // Operands
+            if (b0 == 28 || b0 >= 32) {
+                float value;
+                if (b0 == 28) {
+                    value = static_cast<int16_t>(code.U16BE(at));
+                    at += 2;
+                } else if (b0 <= 246) {
+                    value = static_cast<float>(static_cast<int>(b0) - 139);
+                } else if (b0 <= 250) {
+                    value = static_cast<float>((static_cast<int>(b0) - 247) * 256 + code.U8(at++) + 108);
+                } else if (b0 <= 254) {
+                    value = static_cast<float>(-(static_cast<int>(b0) - 251) * 256 - code.U8(at++) - 108);
+                } else {
+                    value = static_cast<float>(static_cast<int32_t>(code.U32BE(at))) / 65536.0f;
+                    at += 4;
+                }
+                if (m.count == MAX_STACK) {
+                    return false;
+                }
+                m.stack[m.count++] = value;
+                continue;
+            }
+
+            const float* a = m.stack;
+            size_t n = m.count;
+            switch (b0) {
+            case 1:   // hstem
+            case 3:   // vstem
+            case 18:  // hstemhm
+            case 23:  // vstemhm
+                m.stems += (n - m.Width(n % 2 == 1)) / 2;
+                break;
+
+            case 19:  // hintmask
+            case 20:  // cntrmask
+                // Pending arguments are an implied vstem
+                m.stems += (n - m.Width(n % 2 == 1)) / 2;
+                at += (m.stems + 7) / 8;
+                break;
+
+            case 21: {  // rmoveto
+                size_t base = m.Width(n > 2);
+                if (n < base + 2) {
+                    return false;
+                }
+                m.MoveTo(a[base], a[base + 1]);
+                break;
+            }
+            case 22:  // hmoveto
+            case 4: {  // vmoveto
+                size_t base = m.Width(n > 1);
+                if (n < base + 1) {
+                    return false;
+                }
+                if (b0 == 22) {
+                    m.MoveTo(a[base], 0);
+                } else {
+                    m.MoveTo(0, a[base]);
+                }
+                break;
+            }
+
+            case 5:  // rlineto
+                for (size_t k = 0; k + 2 <= n; k += 2) {
+                    m.LineTo(a[k], a[k + 1]);
+                }
+                break;
+            case 6:  // hlineto
+            case 7: {  // vlineto
+                bool horizontal = b0 == 6;
+                for (size_t k = 0; k < n; ++k, horizontal = !horizontal) {
+                    if (horizontal) {
+                        m.LineTo(a[k], 0);
+                    } else {
+                        m.LineTo(0, a[k]);
+                    }
+                }
+                break;
+            }
+
+            case 8:  // rrcurveto
+                for (size_t k = 0; k + 6 <= n; k += 6) {
+                    m.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+                }
+                break;
+            case 27: {  // hhcurveto: dy1? {dxa dxb dyb dxc}+
+                size_t k = 0;
+                float dy1 = n % 2 == 1 ? a[k++] : 0;
+                for (; k + 4 <= n; k += 4, dy1 = 0) {
+                    m.CurveTo(a[k], dy1, a[k + 1], a[k + 2], a[k + 3], 0);
+                }
+                break;
+            }
+            case 26: {  // vvcurveto: dx1? {dya dxb dyb dyc}+
+                size_t k = 0;
+                float dx1 = n % 2 == 1 ? a[k++] : 0;
+                for (; k + 4 <= n; k += 4, dx1 = 0) {
+                    m.CurveTo(dx1, a[k], a[k + 1], a[k + 2], 0, a[k + 3]);
+                }
+                break;
+            }
+            case 30:  // vhcurveto
+            case 31: {  // hvcurveto: tangents alternate; the last curve may take a fifth argument
+                bool horizontal = b0 == 31;
+                for (size_t k = 0; k + 4 <= n; horizontal = !horizontal) {
+                    bool last = n - k == 5;
+                    float extra = last ? a[k + 4] : 0;
+                    if (horizontal) {
+                        m.CurveTo(a[k], 0, a[k + 1], a[k + 2], extra, a[k + 3]);
+                    } else {
+                        m.CurveTo(0, a[k], a[k + 1], a[k + 2], a[k + 3], extra);
+                    }
+                    k += last ? 5 : 4;
+                }
+                break;
+            }
+            case 24: {  // rcurveline
+                if (n < 8) {
+                    return false;
+                }
+                size_t k = 0;
+                for (; k + 6 <= n - 2; k += 6) {
+                    m.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+                }
+                m.LineTo(a[k], a[k + 1]);
+                break;
+            }
+            case 25: {  // rlinecurve
+                if (n < 8) {
+                    return false;
+                }
+                size_t k = 0;
+                for (; k + 2 <= n - 6; k += 2) {
+                    m.LineTo(a[k], a[k + 1]);
+                }
+                m.CurveTo(a[k], a[k + 1], a[k + 2], a[k + 3], a[k + 4], a[k + 5]);
+                break;
+            }
+
+            case 10:    // callsubr
+            case 29: {  // callgsubr
+                const Index& subrs = b0 == 10 ? localSubrs : m_globalSubrs;
+                if (n == 0 || depth + 1 > MAX_SUBR_DEPTH) {
+                    return false;
+                }
+                int64_t index = static_cast<int64_t>(a[--m.count]) + SubrBias(subrs.count);
+                if (index < 0 || index >= subrs.count) {
+                    return false;
+                }
+                if (!Run(m, subrs.Get(static_cast<uint32_t>(index)), localSubrs, depth + 1)) {
+                    return false;
+                }
+                if (m.ended) {
+                    return true;
+                }
+                continue;  // The stack carries over
+            }
+            case 11:  // return
+                return true;
+
+            case 14:  // endchar; the seac form (accented characters) is not composed
+                m.Width(n == 1 || n == 5);
+                m.ended = true;
+                return true;
+
+            case 12: {
+                uint8_t b1 = code.U8(at++);
+                if (b1 == 35 && n >= 12) {  // flex
+                    m.CurveTo(a[0], a[1], a[2], a[3], a[4], a[5]);
+                    m.CurveTo(a[6], a[7], a[8], a[9], a[10], a[11]);
+                } else if (b1 == 34 && n >= 7) {  // hflex
+                    m.CurveTo(a[0], 0, a[1], a[2], a[3], 0);
+                    m.CurveTo(a[4], 0, a[5], -a[2], a[6], 0);
+                } else if (b1 == 36 && n >= 9) {  // hflex1
+                    m.CurveTo(a[0], a[1], a[2], a[3], a[4], 0);
+                    m.CurveTo(a[5], 0, a[6], a[7], a[8], -(a[1] + a[3] + a[7]));
+                } else if (b1 == 37 && n >= 11) {  // flex1: the last point moves along the longer axis
+                    float dx = a[0] + a[2] + a[4] + a[6] + a[8];
+                    float dy = a[1] + a[3] + a[5] + a[7] + a[9];
+                    bool alongX = std::fabs(dx) > std::fabs(dy);
+                    m.CurveTo(a[0], a[1], a[2], a[3], a[4], a[5]);
+                    m.CurveTo(a[6], a[7], a[8], a[9], alongX ? a[10] : -dx, alongX ? -dy : a[10]);
+                }
+                // The arithmetic operators are deprecated and unused in OpenType CFF
+                break;
+            }
+
+            default:
+                break;
+            }
+            m.count = 0;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "GlyphOutline.h"
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    // Glyph outlines from an OpenType 'CFF ' table: INDEX and DICT parsing
+    // enough to find the charstrings and subroutines (including CID-keyed
+    // fonts with per-FD private dictionaries), and a Type 2 charstring
+    // interpreter that turns them into cubic outlines. Hints are skipped.
+    // CFF2 (variable fonts) is a different table and not read here.
+    class CffOutlines {
+    public:
+        static constexpr size_t MAX_STACK = 48;
+        static constexpr size_t MAX_SUBR_DEPTH = 10;
+        static constexpr size_t MAX_OPERATIONS = 1 << 16;  // Per glyph, subroutines included
+
+        CffOutlines(ByteView cff, uint16_t unitsPerEm);
+
+        bool IsValid() const { return m_valid; }
+
+        // Outline in the font's units per em
+        bool LoadOutline(uint16_t glyph, GlyphOutline& outline) const;
+
+    private:
+        // count objects; object i is [offsets[i], offsets[i + 1])
+        struct Index {
+            ByteView data;       // Starting at the count
+            uint32_t count = 0;
+            uint8_t offSize = 0;
+            size_t objects = 0;  // Where object data starts, within data
+            size_t end = 0;      // Size of the whole INDEX
+
+            bool Read(ByteView cff, size_t offset);
+            ByteView Get(uint32_t i) const;
+        };
+
+        struct Machine;
+
+        Index ReadPrivateSubrs(size_t offset, size_t size) const;
+        const Index& LocalSubrs(uint16_t glyph) const;
+        bool Run(Machine& machine, ByteView code, const Index& localSubrs, size_t depth) const;
+
+        ByteView m_cff;
+        bool m_valid;
+        float m_scale;        // FontMatrix to units per em
+        Index m_charStrings;
+        Index m_globalSubrs;
+        Index m_localSubrs;   // Non-CID fonts
+        std::vector<Index> m_fdSubrs;  // CID fonts: one per Font DICT
+        ByteView m_fdSelect;
+        uint8_t m_fdSelectFormat;
+    };
+}
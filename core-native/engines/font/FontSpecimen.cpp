@@ -0,0 +1,166 @@
+#include "FontSpecimen.h"
+#include <algorithm>
+#include <cmath>
+#include "GlyphCache.h"
+#include "OpenTypeFont.h"
+
+namespace Lumos {
+    namespace {
+        constexpr char PANGRAM[] = "The quick brown fox jumps over the lazy dog";
+
+        // Fonts missing more letters than this (symbols, CJK-only) show
+        // their own first characters instead
+        constexpr size_t MAX_MISSING_LETTERS = 3;
+        constexpr size_t MAX_FALLBACK_GLYPHS = 48;
+
+        constexpr uint8_t GRID_GREY = 0xE0;
+
+        struct Clip {
+            int32_t left;
+            int32_t top;
+            int32_t right;
+            int32_t bottom;
+        };
+
+        // Black at the glyph's coverage, composited over what is there
+        void Blit(uint8_t* pixels, uint32_t stride, const GlyphBitmap& glyph, int32_t x, int32_t y, const Clip& clip) {
+            int32_t rowFirst = std::max(y, clip.top);
+            int32_t rowEnd = std::min(y + static_cast<int32_t>(glyph.height), clip.bottom);
+            int32_t columnFirst = std::max(x, clip.left);
+            int32_t columnEnd = std::min(x + static_cast<int32_t>(glyph.width), clip.right);
+            for (int32_t row = rowFirst; row < rowEnd; ++row) {
+                const uint8_t* coverage = glyph.coverage.data() + static_cast<size_t>(row - y) * glyph.width;
+                uint8_t* out = pixels + static_cast<size_t>(row) * stride;
+                for (int32_t column = columnFirst; column < columnEnd; ++column) {
+                    uint32_t alpha = coverage[column - x];
+                    if (alpha == 0) {
+                        continue;
+                    }
+                    uint8_t* pixel = out + static_cast<size_t>(column) * 4;
+                    uint32_t keep = 255 - alpha;
+                    pixel[0] = static_cast<uint8_t>((pixel[0] * keep + 127) / 255);
+                    pixel[1] = static_cast<uint8_t>((pixel[1] * keep + 127) / 255);
+                    pixel[2] = static_cast<uint8_t>((pixel[2] * keep + 127) / 255);
+                    pixel[3] = static_cast<uint8_t>(alpha + (pixel[3] * keep + 127) / 255);
+                }
+            }
+        }
+
+        void FillRect(uint8_t* pixels, uint32_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+            for (uint32_t row = y; row < y + height; ++row) {
+                uint8_t* pixel = pixels + static_cast<size_t>(row) * stride + static_cast<size_t>(x) * 4;
+                for (uint32_t column = 0; column < width; ++column, pixel += 4) {
+                    pixel[0] = pixel[1] = pixel[2] = GRID_GREY;
+                    pixel[3] = 0xFF;
+                }
+            }
+        }
+    }
+
+    FontSpecimen::FontSpecimen(const OpenTypeFont& font)
+        : m_font(font)
+        , m_ascender(font.Ascender())
+        , m_descender(font.Descender())
+        , m_gridTop(0)
+        , m_gridColumns((WIDTH - 2 * MARGIN) / GRID_CELL)
+        , m_gridRows(0)
+        , m_height(0)
+    {
+        float extent = m_ascender - m_descender;
+        if (extent <= 0 || extent > 4.0f * font.UnitsPerEm()) {
+            // Broken hhea: assume typical Latin proportions
+            m_ascender = 0.8f * font.UnitsPerEm();
+            m_descender = -0.2f * font.UnitsPerEm();
+        }
+
+        size_t missing = 0;
+        for (const char* c = PANGRAM; *c; ++c) {
+            uint16_t glyph = font.GlyphIndex(static_cast<uint8_t>(*c));
+            missing += glyph == 0 && *c != ' ';
+            m_sample.push_back(glyph);
+        }
+        if (missing > MAX_MISSING_LETTERS) {
+            m_sample.clear();
+            for (uint32_t codepoint : font.MappedCodepoints(MAX_FALLBACK_GLYPHS + 0x21)) {
+                if (codepoint > 0x20 && m_sample.size() < MAX_FALLBACK_GLYPHS) {
+                    m_sample.push_back(font.GlyphIndex(codepoint));
+                }
+            }
+        }
+
+        float y = MARGIN;
+        for (float size : SAMPLE_SIZES) {
+            y += std::ceil(LineHeight(size));
+        }
+        m_gridTop = static_cast<uint32_t>(y) + MARGIN;
+
+        uint32_t neededRows = (font.GlyphCount() + m_gridColumns - 1) / m_gridColumns;
+        uint32_t roomRows = m_gridTop + MARGIN + 1 < MAX_HEIGHT ? (MAX_HEIGHT - m_gridTop - MARGIN - 1) / GRID_CELL : 0;
+        m_gridRows = std::min(neededRows, roomRows);
+        m_height = m_gridTop + m_gridRows * GRID_CELL + 1 + MARGIN;
+    }
+
+    float FontSpecimen::LineHeight(float pixelsPerEm) const {
+        return (m_ascender - m_descender) * pixelsPerEm / m_font.UnitsPerEm() + pixelsPerEm * 0.25f;
+    }
+
+    FontSpecimenStats FontSpecimen::Render(GlyphCache& cache, uint8_t* pixels) const {
+        FontSpecimenStats stats;
+        uint64_t missesBefore = cache.Stats().misses;
+        uint32_t stride = Stride();
+
+        // Sample lines, clipped at the right margin
+        Clip lines{ 0, 0, static_cast<int32_t>(WIDTH - MARGIN), static_cast<int32_t>(m_gridTop) };
+        float y = MARGIN;
+        for (float size : SAMPLE_SIZES) {
+            float scale = size / m_font.UnitsPerEm();
+            int32_t baseline = static_cast<int32_t>(std::lround(y + m_ascender * scale + size * 0.125f));
+            float penX = MARGIN;
+            for (uint16_t glyph : m_sample) {
+                if (penX >= WIDTH - MARGIN) {
+                    break;
+                }
+                auto bitmap = cache.Get(glyph, size);
+                if (bitmap) {
+                    Blit(pixels, stride, *bitmap, static_cast<int32_t>(std::lround(penX)) + bitmap->left,
+                         baseline - bitmap->top, lines);
+                    ++stats.glyphsDrawn;
+                }
+                penX += std::max(0.0f, bitmap ? bitmap->advance : m_font.AdvanceWidth(glyph) * scale);
+            }
+            y += std::ceil(LineHeight(size));
+        }
+
+        // Glyph grid: lines first, then each glyph centred in its cell
+        if (m_gridRows > 0) {
+            uint32_t gridWidth = m_gridColumns * GRID_CELL;
+            for (uint32_t row = 0; row <= m_gridRows; ++row) {
+                FillRect(pixels, stride, MARGIN, m_gridTop + row * GRID_CELL, gridWidth + 1, 1);
+            }
+            for (uint32_t column = 0; column <= m_gridColumns; ++column) {
+                FillRect(pixels, stride, MARGIN + column * GRID_CELL, m_gridTop, 1, m_gridRows * GRID_CELL);
+            }
+        }
+
+        float scale = GRID_GLYPH_SIZE / m_font.UnitsPerEm();
+        float baselineOffset = (GRID_CELL - (m_ascender - m_descender) * scale) * 0.5f + m_ascender * scale;
+        uint32_t shown = std::min<uint32_t>(m_font.GlyphCount(), m_gridRows * m_gridColumns);
+        for (uint32_t glyph = 0; glyph < shown; ++glyph) {
+            auto bitmap = cache.Get(static_cast<uint16_t>(glyph), GRID_GLYPH_SIZE);
+            if (!bitmap || bitmap->coverage.empty()) {
+                continue;
+            }
+            int32_t cellX = static_cast<int32_t>(MARGIN + (glyph % m_gridColumns) * GRID_CELL);
+            int32_t cellY = static_cast<int32_t>(m_gridTop + (glyph / m_gridColumns) * GRID_CELL);
+            float advance = std::clamp(bitmap->advance, 0.0f, static_cast<float>(GRID_CELL));
+            int32_t penX = cellX + static_cast<int32_t>(std::lround((GRID_CELL - advance) * 0.5f));
+            int32_t baseline = cellY + static_cast<int32_t>(std::lround(baselineOffset));
+            Clip cell{ cellX + 1, cellY + 1, cellX + static_cast<int32_t>(GRID_CELL), cellY + static_cast<int32_t>(GRID_CELL) };
+            Blit(pixels, stride, *bitmap, penX + bitmap->left, baseline - bitmap->top, cell);
+            ++stats.glyphsDrawn;
+        }
+
+        stats.glyphsRendered = static_cast<size_t>(cache.Stats().misses - missesBefore);
+        return stats;
+    }
+}
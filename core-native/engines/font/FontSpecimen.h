@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Lumos {
+    class GlyphCache;
+    class OpenTypeFont;
+
+    struct FontSpecimenStats {
+        size_t glyphsDrawn = 0;
+        size_t glyphsRendered = 0;  // Cache misses: outlined and rasterized
+    };
+
+    // Lays out a font preview: a sample line at each of SAMPLE_SIZES, then
+    // a grid of the font's glyphs in glyph order, as many rows as fit under
+    // MAX_HEIGHT. Black glyphs are composited onto a premultiplied BGRA
+    // surface that starts transparent, with light grey grid lines.
+    class FontSpecimen {
+    public:
+        static constexpr uint32_t WIDTH = 960;
+        static constexpr uint32_t MAX_HEIGHT = 1400;
+        static constexpr size_t MAX_BYTES = static_cast<size_t>(WIDTH) * 4 * MAX_HEIGHT;  // The tallest specimen
+        static constexpr uint32_t MARGIN = 16;
+        static constexpr float SAMPLE_SIZES[] = { 12, 16, 24, 32, 48, 72 };
+        static constexpr uint32_t GRID_CELL = 48;
+        static constexpr float GRID_GLYPH_SIZE = 32;
+
+        explicit FontSpecimen(const OpenTypeFont& font);
+
+        uint32_t Width() const { return WIDTH; }
+        uint32_t Height() const { return m_height; }
+        uint32_t Stride() const { return WIDTH * 4; }
+
+        // `pixels` holds Stride() * Height() bytes, zeroed
+        FontSpecimenStats Render(GlyphCache& cache, uint8_t* pixels) const;
+
+    private:
+        // Line height in pixels at `pixelsPerEm`
+        float LineHeight(float pixelsPerEm) const;
+
+        const OpenTypeFont& m_font;
+        std::vector<uint16_t> m_sample;  // Glyphs of the sample line
+        float m_ascender;                // Font units, sanitized
+        float m_descender;
+        uint32_t m_gridTop;
+        uint32_t m_gridColumns;
+        uint32_t m_gridRows;
+        uint32_t m_height;
+    };
+}
@@ -0,0 +1,118 @@
+#include "GlyphCache.h"
+#include "OpenTypeFont.h"
+
+namespace Lumos {
+    namespace {
+        // Bookkeeping overhead per glyph on top of the coverage
+        constexpr size_t ENTRY_OVERHEAD = 96;
+    }
+
+    GlyphCache::GlyphCache(MemoryGovernor& governor, size_t capacityBytes, std::string name, PoolPriority priority)
+        : m_font(nullptr)
+        , m_fontKey(0)
+        , m_capacity(capacityBytes)
+        , m_bytes(0)
+        , m_hits(0)
+        , m_misses(0)
+    {
+        m_pool = governor.RegisterPool(std::move(name), priority, [this](size_t bytes) { return Trim(bytes); });
+    }
+
+    GlyphCache::~GlyphCache() {
+        Clear();
+    }
+
+    void GlyphCache::Bind(const OpenTypeFont& font, uint64_t fontKey) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (fontKey == 0 || fontKey != m_fontKey) {
+            ClearLocked();
+        }
+        m_font = &font;
+        m_fontKey = fontKey;
+    }
+
+    std::shared_ptr<const GlyphBitmap> GlyphCache::Get(uint16_t glyph, float pixelsPerEm) {
+        uint64_t key = Key(glyph, pixelsPerEm);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            m_pool->Touch();
+            ++m_hits;
+            return it->second->bitmap;
+        }
+        ++m_misses;
+
+        // Malformed glyphs are remembered as null so they are parsed only once
+        std::shared_ptr<GlyphBitmap> bitmap = std::make_shared<GlyphBitmap>();
+        float scale = pixelsPerEm / m_font->UnitsPerEm();
+        if (m_font->LoadOutline(glyph, m_outline) && m_rasterizer.Render(m_outline, scale, *bitmap)) {
+            bitmap->advance = m_font->AdvanceWidth(glyph) * scale;
+        } else {
+            bitmap.reset();
+        }
+
+        // Over the cap or the budget, the oldest glyphs make room; when
+        // nothing is left to evict the glyph is drawn but not kept
+        size_t bytes = (bitmap ? bitmap->coverage.size() : 0) + ENTRY_OVERHEAD;
+        while (!m_lru.empty() && m_bytes + bytes > m_capacity) {
+            EvictLruLocked();
+        }
+        while (!m_pool->TryCharge(bytes)) {
+            if (EvictLruLocked() == 0) {
+                return bitmap;
+            }
+        }
+        m_lru.push_front(Entry{ key, bitmap, bytes });
+        m_index.emplace(key, m_lru.begin());
+        m_bytes += bytes;
+        return bitmap;
+    }
+
+    void GlyphCache::Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ClearLocked();
+    }
+
+    GlyphCacheStats GlyphCache::Stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return { m_hits, m_misses, m_lru.size(), m_bytes };
+    }
+
+    size_t GlyphCache::Trim(size_t bytes) {
+        // Same rule as PreviewCache: never block inside a reclaim
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return 0;
+        }
+
+        size_t freed = 0;
+        while (freed < bytes) {
+            size_t got = EvictLruLocked();
+            if (got == 0) {
+                break;
+            }
+            freed += got;
+        }
+        return freed;
+    }
+
+    size_t GlyphCache::EvictLruLocked() {
+        if (m_lru.empty()) {
+            return 0;
+        }
+        size_t bytes = m_lru.back().bytes;
+        m_pool->Release(bytes);
+        m_bytes -= bytes;
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+        return bytes;
+    }
+
+    void GlyphCache::ClearLocked() {
+        m_pool->Release(m_bytes);
+        m_lru.clear();
+        m_index.clear();
+        m_bytes = 0;
+    }
+}
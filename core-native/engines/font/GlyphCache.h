@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "GlyphOutline.h"
+#include "GlyphRasterizer.h"
+#include "../../memory/MemoryGovernor.h"
+
+namespace Lumos {
+    class OpenTypeFont;
+
+    struct GlyphCacheStats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t glyphs;
+        size_t bytes;
+    };
+
+    // Rendered glyphs of one font at a time, keyed by pixel size and glyph,
+    // least recently used dropped past the byte cap. A specimen draws the
+    // same letters at each size many times over; each is outlined and
+    // rasterized once, and previewing the same font again reuses them.
+    // Charged to a governor pool, which may evict glyphs under pressure.
+    // Get() and Bind() belong to one rendering thread.
+    class GlyphCache {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 8 * 1024 * 1024;
+
+        explicit GlyphCache(MemoryGovernor& governor, size_t capacityBytes = DEFAULT_CAPACITY,
+                            std::string name = "glyph-cache", PoolPriority priority = PoolPriority::Cache);
+        ~GlyphCache();
+
+        GlyphCache(const GlyphCache&) = delete;
+        GlyphCache& operator=(const GlyphCache&) = delete;
+
+        // Render from `font` until the next Bind. `fontKey` names the file
+        // version the font was read from; glyphs cached under another key
+        // are dropped. 0 means unknown and never matches.
+        void Bind(const OpenTypeFont& font, uint64_t fontKey);
+
+        // Null if the glyph is malformed or too large to render
+        std::shared_ptr<const GlyphBitmap> Get(uint16_t glyph, float pixelsPerEm);
+
+        void Clear();
+        GlyphCacheStats Stats() const;
+
+    private:
+        struct Entry {
+            uint64_t key;
+            std::shared_ptr<const GlyphBitmap> bitmap;
+            size_t bytes;
+        };
+
+        // Sizes are keyed in 1/64 pixel steps
+        static uint64_t Key(uint16_t glyph, float pixelsPerEm) {
+            return (static_cast<uint64_t>(pixelsPerEm * 64.0f + 0.5f) << 16) | glyph;
+        }
+
+        // Evict least recently used glyphs until `bytes` are freed (reclaim callback)
+        size_t Trim(size_t bytes);
+        size_t EvictLruLocked();
+        void ClearLocked();
+
+        const OpenTypeFont* m_font;
+        uint64_t m_fontKey;
+        size_t m_capacity;
+        GlyphRasterizer m_rasterizer;
+        GlyphOutline m_outline;  // Scratch, reused between glyphs
+
+        mutable std::mutex m_mutex;
+        std::list<Entry> m_lru;  // Most recently used at the front
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+        size_t m_bytes;
+        uint64_t m_hits;
+        uint64_t m_misses;
+
+        std::shared_ptr<MemoryPool> m_pool;
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Lumos {
+    // A glyph's contours in font units, y up. Each Move starts a contour;
+    // contours are closed implicitly. TrueType outlines use quadratic
+    // curves, CFF outlines cubic ones.
+    struct GlyphOutline {
+        enum class Verb : uint8_t { Move, Line, Quad, Cubic };
+
+        std::vector<Verb> verbs;
+        std::vector<float> points;  // x, y pairs: one per Move or Line, two per Quad, three per Cubic
+
+        void Clear() {
+            verbs.clear();
+            points.clear();
+        }
+
+        bool Empty() const { return verbs.empty(); }
+
+        void MoveTo(float x, float y) {
+            verbs.push_back(Verb::Move);
+            points.insert(points.end(), { x, y });
+        }
+
+        void LineTo(float x, float y) {
+            verbs.push_back(Verb::Line);
+            points.insert(points.end(), { x, y });
+        }
+
+        void QuadTo(float cx, float cy, float x, float y) {
+            verbs.push_back(Verb::Quad);
+            points.insert(points.end(), { cx, cy, x, y });
+        }
+
+        void CubicTo(float c1x, float c1y, float c2x, float c2y, float x, float y) {
+            verbs.push_back(Verb::Cubic);
+            points.insert(points.end(), { c1x, c1y, c2x, c2y, x, y });
+        }
+    };
+
+    // 8-bit coverage of one glyph at one size. `left` and `top` place the
+    // bitmap relative to the pen position on the baseline (top is up).
+    struct GlyphBitmap {
+        int32_t left = 0;
+        int32_t top = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        float advance = 0;          // Pixels
+        std::vector<uint8_t> coverage;  // width * height, rows top to bottom
+    };
+}
@@ -0,0 +1,222 @@
+#include "GlyphRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Lumos {
+    namespace {
+        // Curve flattening: segments grow with the square root of the
+        // curve's deviation from its chord, so the error stays around a
+        // tenth of a pixel at any size
+        constexpr float FLATTEN_TOLERANCE = 3.0f;
+        constexpr int MAX_SEGMENTS = 100;
+
+        // The running sum may step one cell past the row end
+        constexpr size_t AREA_SLACK = 4;
+
+        int Segments(float dd) {
+            int n = 1 + static_cast<int>(std::sqrt(std::sqrt(FLATTEN_TOLERANCE * dd)));
+            return std::min(n, MAX_SEGMENTS);
+        }
+    }
+
+    bool GlyphRasterizer::Render(const GlyphOutline& outline, float scale, GlyphBitmap& bitmap) {
+        bitmap.left = 0;
+        bitmap.top = 0;
+        bitmap.width = 0;
+        bitmap.height = 0;
+        bitmap.coverage.clear();
+        if (outline.points.size() < 2) {
+            return true;
+        }
+
+        // Control points bound the curves, so their box bounds the glyph
+        float xMin = outline.points[0];
+        float xMax = xMin;
+        float yMin = outline.points[1];
+        float yMax = yMin;
+        for (size_t i = 0; i + 1 < outline.points.size(); i += 2) {
+            xMin = std::min(xMin, outline.points[i]);
+            xMax = std::max(xMax, outline.points[i]);
+            yMin = std::min(yMin, outline.points[i + 1]);
+            yMax = std::max(yMax, outline.points[i + 1]);
+        }
+        float left = std::floor(xMin * scale);
+        float right = std::ceil(xMax * scale);
+        float bottom = std::floor(yMin * scale);
+        float top = std::ceil(yMax * scale);
+        if (!(right - left <= MAX_DIMENSION) || !(top - bottom <= MAX_DIMENSION)) {
+            return false;  // Also catches NaN and infinities
+        }
+        bitmap.left = static_cast<int32_t>(left);
+        bitmap.top = static_cast<int32_t>(top);
+        m_width = static_cast<uint32_t>(right - left);
+        m_height = static_cast<uint32_t>(top - bottom);
+        if (m_width == 0 || m_height == 0) {
+            return true;
+        }
+        m_area.assign(static_cast<size_t>(m_width) * m_height + AREA_SLACK, 0.0f);
+
+        // Pixel space: origin at the bitmap's top left, y down
+        const float* p = outline.points.data();
+        auto px = [&](size_t i) { return p[i] * scale - left; };
+        auto py = [&](size_t i) { return top - p[i + 1] * scale; };
+
+        size_t at = 0;
+        float startX = 0;
+        float startY = 0;
+        float x = 0;
+        float y = 0;
+        for (GlyphOutline::Verb verb : outline.verbs) {
+            switch (verb) {
+            case GlyphOutline::Verb::Move:
+                Line(x, y, startX, startY);  // Close the previous contour
+                x = startX = px(at);
+                y = startY = py(at);
+                at += 2;
+                break;
+            case GlyphOutline::Verb::Line:
+                Line(x, y, px(at), py(at));
+                x = px(at);
+                y = py(at);
+                at += 2;
+                break;
+            case GlyphOutline::Verb::Quad:
+                Quad(x, y, px(at), py(at), px(at + 2), py(at + 2));
+                x = px(at + 2);
+                y = py(at + 2);
+                at += 4;
+                break;
+            case GlyphOutline::Verb::Cubic:
+                Cubic(x, y, px(at), py(at), px(at + 2), py(at + 2), px(at + 4), py(at + 4));
+                x = px(at + 4);
+                y = py(at + 4);
+                at += 6;
+                break;
+            }
+        }
+        Line(x, y, startX, startY);
+
+        bitmap.width = m_width;
+        bitmap.height = m_height;
+        bitmap.coverage.resize(static_cast<size_t>(m_width) * m_height);
+        float sum = 0;
+        for (size_t i = 0; i < bitmap.coverage.size(); ++i) {
+            sum += m_area[i];
+            float coverage = std::min(std::fabs(sum), 1.0f);
+            bitmap.coverage[i] = static_cast<uint8_t>(coverage * 255.0f + 0.5f);
+        }
+        return true;
+    }
+
+    // Adds the line's signed area to each cell it passes through, and the
+    // remainder of the row to the cell after, so that a running sum along
+    // the row gives the coverage
+    void GlyphRasterizer::Line(float x0, float y0, float x1, float y1) {
+        if (y0 == y1) {
+            return;
+        }
+        float width = static_cast<float>(m_width);
+        x0 = std::clamp(x0, 0.0f, width);
+        x1 = std::clamp(x1, 0.0f, width);
+
+        float direction = 1.0f;
+        if (y0 > y1) {
+            direction = -1.0f;
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        float dxdy = (x1 - x0) / (y1 - y0);
+        float x = x0;
+        if (y0 < 0) {
+            x -= y0 * dxdy;
+        }
+
+        size_t rowFirst = static_cast<size_t>(std::max(0.0f, std::floor(y0)));
+        size_t rowEnd = static_cast<size_t>(std::min(static_cast<float>(m_height), std::max(0.0f, std::ceil(y1))));
+        for (size_t row = rowFirst; row < rowEnd; ++row) {
+            float* line = m_area.data() + row * m_width;
+            float dy = std::min(static_cast<float>(row + 1), y1) - std::max(static_cast<float>(row), y0);
+            float xNext = std::clamp(x + dxdy * dy, 0.0f, width);
+            float d = dy * direction;
+
+            float a = std::min(x, xNext);
+            float b = std::max(x, xNext);
+            float aFloor = std::floor(a);
+            size_t aCell = static_cast<size_t>(aFloor);
+            float bCeil = std::ceil(b);
+            size_t bCell = static_cast<size_t>(bCeil);
+
+            if (bCell <= aCell + 1) {
+                // Within one cell: split by the midpoint
+                float middle = 0.5f * (x + xNext) - aFloor;
+                line[aCell] += d - d * middle;
+                line[aCell + 1] += d * middle;
+            } else {
+                float inverse = 1.0f / (b - a);
+                float aFraction = a - aFloor;
+                float first = 0.5f * inverse * (1.0f - aFraction) * (1.0f - aFraction);
+                float bFraction = b - bCeil + 1.0f;
+                float last = 0.5f * inverse * bFraction * bFraction;
+                line[aCell] += d * first;
+                if (bCell == aCell + 2) {
+                    line[aCell + 1] += d * (1.0f - first - last);
+                } else {
+                    float second = inverse * (1.5f - aFraction);
+                    line[aCell + 1] += d * (second - first);
+                    for (size_t cell = aCell + 2; cell < bCell - 1; ++cell) {
+                        line[cell] += d * inverse;
+                    }
+                    float beforeLast = second + static_cast<float>(bCell - aCell - 3) * inverse;
+                    line[bCell - 1] += d * (1.0f - beforeLast - last);
+                }
+                line[bCell] += d * last;
+            }
+            x = xNext;
+        }
+    }
+
+    void GlyphRasterizer::Quad(float x0, float y0, float cx, float cy, float x1, float y1) {
+        float devX = x0 - 2.0f * cx + x1;
+        float devY = y0 - 2.0f * cy + y1;
+        int n = Segments(devX * devX + devY * devY);
+        float step = 1.0f / static_cast<float>(n);
+        float previousX = x0;
+        float previousY = y0;
+        for (int i = 1; i <= n; ++i) {
+            float t = static_cast<float>(i) * step;
+            float u = 1.0f - t;
+            float x = i == n ? x1 : u * u * x0 + 2.0f * u * t * cx + t * t * x1;
+            float y = i == n ? y1 : u * u * y0 + 2.0f * u * t * cy + t * t * y1;
+            Line(previousX, previousY, x, y);
+            previousX = x;
+            previousY = y;
+        }
+    }
+
+    void GlyphRasterizer::Cubic(float x0, float y0, float c1x, float c1y, float c2x, float c2y, float x1, float y1) {
+        // A cubic bends up to three times as hard as a quad with the same
+        // second differences
+        float dev1X = x0 - 2.0f * c1x + c2x;
+        float dev1Y = y0 - 2.0f * c1y + c2y;
+        float dev2X = c1x - 2.0f * c2x + x1;
+        float dev2Y = c1y - 2.0f * c2y + y1;
+        float dd = std::max(dev1X * dev1X + dev1Y * dev1Y, dev2X * dev2X + dev2Y * dev2Y);
+        int n = Segments(9.0f * dd);
+        float step = 1.0f / static_cast<float>(n);
+        float previousX = x0;
+        float previousY = y0;
+        for (int i = 1; i <= n; ++i) {
+            float t = static_cast<float>(i) * step;
+            float u = 1.0f - t;
+            float a = u * u * u;
+            float b = 3.0f * u * u * t;
+            float c = 3.0f * u * t * t;
+            float e = t * t * t;
+            float x = i == n ? x1 : a * x0 + b * c1x + c * c2x + e * x1;
+            float y = i == n ? y1 : a * y0 + b * c1y + c * c2y + e * y1;
+            Line(previousX, previousY, x, y);
+            previousX = x;
+            previousY = y;
+        }
+    }
+}
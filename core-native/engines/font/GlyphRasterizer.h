@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "GlyphOutline.h"
+
+namespace Lumos {
+    // Anti-aliased scanline rasterizer for glyph outlines. Curves are
+    // flattened into lines, each line adds its exact signed area to the
+    // cells it crosses, and one running sum per row turns those into
+    // coverage (non-zero winding, approximated by |sum| clamped to 1, which
+    // only differs from it where contours overlap in the same direction
+    // inside one pixel). No hinting. One instance per thread; the
+    // accumulation buffer is reused between glyphs.
+    class GlyphRasterizer {
+    public:
+        static constexpr uint32_t MAX_DIMENSION = 2048;
+
+        // `scale` is pixels per font unit. False if the glyph would be
+        // larger than MAX_DIMENSION on a side; an empty outline gives an
+        // empty bitmap.
+        bool Render(const GlyphOutline& outline, float scale, GlyphBitmap& bitmap);
+
+    private:
+        void Line(float x0, float y0, float x1, float y1);
+        void Quad(float x0, float y0, float cx, float cy, float x1, float y1);
+        void Cubic(float x0, float y0, float c1x, float c1y, float c2x, float c2y, float x1, float y1);
+
+        std::vector<float> m_area;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+    };
+}
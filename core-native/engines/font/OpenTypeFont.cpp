@@ -0,0 +1,621 @@
+#include "OpenTypeFont.h"
+#include <cstring>
+#include "CffOutlines.h"
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        constexpr uint32_t TAG_TTCF = 0x74746366;  // 'ttcf'
+        constexpr uint32_t TAG_OTTO = 0x4F54544F;  // 'OTTO'
+        constexpr uint32_t TAG_TRUE = 0x74727565;  // 'true' (old Apple TrueType)
+        constexpr uint32_t SFNT_VERSION_1 = 0x00010000;
+
+        constexpr size_t MAX_NAME_BYTES = 1024;
+        constexpr size_t MAX_CMAP_LOOKUPS = 1 << 20;
+
+        // Composite glyph component flags
+        constexpr uint16_t ARG_1_AND_2_ARE_WORDS = 0x0001;
+        constexpr uint16_t ARGS_ARE_XY_VALUES = 0x0002;
+        constexpr uint16_t WE_HAVE_A_SCALE = 0x0008;
+        constexpr uint16_t MORE_COMPONENTS = 0x0020;
+        constexpr uint16_t WE_HAVE_AN_X_AND_Y_SCALE = 0x0040;
+        constexpr uint16_t WE_HAVE_A_TWO_BY_TWO = 0x0080;
+        constexpr uint16_t SCALED_COMPONENT_OFFSET = 0x0800;
+
+        // Simple glyph point flags
+        constexpr uint8_t ON_CURVE = 0x01;
+        constexpr uint8_t X_SHORT = 0x02;
+        constexpr uint8_t Y_SHORT = 0x04;
+        constexpr uint8_t REPEAT = 0x08;
+        constexpr uint8_t X_SAME_OR_POSITIVE = 0x10;
+        constexpr uint8_t Y_SAME_OR_POSITIVE = 0x20;
+
+        uint32_t Tag(const char tag[4]) {
+            return (static_cast<uint32_t>(static_cast<uint8_t>(tag[0])) << 24) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(tag[1])) << 16) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(tag[2])) << 8) |
+                   static_cast<uint32_t>(static_cast<uint8_t>(tag[3]));
+        }
+
+        int16_t I16(ByteView bytes, size_t offset) {
+            return static_cast<int16_t>(bytes.U16BE(offset));
+        }
+
+        float F2Dot14(ByteView bytes, size_t offset) {
+            return static_cast<float>(I16(bytes, offset)) / 16384.0f;
+        }
+
+        // x' = a x + c y + e, y' = b x + d y + f
+        void Compose(const float outer[6], const float inner[6], float result[6]) {
+            result[0] = outer[0] * inner[0] + outer[2] * inner[1];
+            result[1] = outer[1] * inner[0] + outer[3] * inner[1];
+            result[2] = outer[0] * inner[2] + outer[2] * inner[3];
+            result[3] = outer[1] * inner[2] + outer[3] * inner[3];
+            result[4] = outer[0] * inner[4] + outer[2] * inner[5] + outer[4];
+            result[5] = outer[1] * inner[4] + outer[3] * inner[5] + outer[5];
+        }
+
+        void AppendCodePoint(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        std::string DecodeUtf16BE(ByteView bytes) {
+            std::string out;
+            for (size_t i = 0; i + 1 < bytes.Size(); i += 2) {
+                uint32_t cp = bytes.U16BE(i);
+                if (cp >= 0xD800 && cp <= 0xDBFF && bytes.Has(i + 2, 2)) {
+                    uint32_t low = bytes.U16BE(i + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                AppendCodePoint(out, cp);
+            }
+            return out;
+        }
+
+        // Mac Roman names are nearly always ASCII; anything else is shown replaced
+        std::string DecodeMacRoman(ByteView bytes) {
+            std::string out;
+            for (size_t i = 0; i < bytes.Size(); ++i) {
+                uint8_t c = bytes.U8(i);
+                AppendCodePoint(out, c < 0x80 ? c : 0xFFFD);
+            }
+            return out;
+        }
+    }
+
+    OpenTypeFont::OpenTypeFont(ByteView data, uint32_t faceIndex)
+        : m_data(data)
+        , m_valid(false)
+        , m_faceCount(1)
+        , m_format(FontOutlineFormat::None)
+        , m_unitsPerEm(0)
+        , m_ascender(0)
+        , m_descender(0)
+        , m_lineGap(0)
+        , m_glyphCount(0)
+        , m_hMetricCount(0)
+        , m_longLoca(false)
+        , m_cmapFormat(0)
+        , m_symbolCmap(false)
+    {
+        size_t faceOffset = 0;
+        if (data.U32BE(0) == TAG_TTCF) {
+            m_faceCount = data.U32BE(8);
+            if (faceIndex >= m_faceCount || !data.Has(12, static_cast<size_t>(faceIndex) * 4 + 4)) {
+                return;
+            }
+            faceOffset = data.U32BE(12 + static_cast<size_t>(faceIndex) * 4);
+        } else if (faceIndex != 0) {
+            return;
+        }
+
+        uint32_t version = data.U32BE(faceOffset);
+        if (version != SFNT_VERSION_1 && version != TAG_OTTO && version != TAG_TRUE) {
+            return;
+        }
+        uint16_t tableCount = data.U16BE(faceOffset + 4);
+        if (!data.Has(faceOffset, 12 + static_cast<size_t>(tableCount) * 16)) {
+            return;
+        }
+        m_directory = data.Sub(faceOffset, 12 + static_cast<size_t>(tableCount) * 16);
+
+        ByteView head = Table("head");
+        ByteView hhea = Table("hhea");
+        ByteView maxp = Table("maxp");
+        if (!head.Has(0, 54) || !hhea.Has(0, 36) || !maxp.Has(0, 6)) {
+            return;
+        }
+        m_unitsPerEm = head.U16BE(18);
+        m_longLoca = I16(head, 50) != 0;
+        m_ascender = I16(hhea, 4);
+        m_descender = I16(hhea, 6);
+        m_lineGap = I16(hhea, 8);
+        m_hMetricCount = hhea.U16BE(34);
+        m_glyphCount = maxp.U16BE(4);
+        m_hmtx = Table("hmtx");
+        if (m_unitsPerEm < 16 || m_unitsPerEm > 16384 || m_glyphCount == 0 || m_hMetricCount == 0 ||
+            !m_hmtx.Has(0, static_cast<size_t>(m_hMetricCount) * 4)) {
+            return;
+        }
+
+        m_glyf = Table("glyf");
+        m_loca = Table("loca");
+        ByteView cff = Table("CFF ");
+        if (!m_glyf.Empty() && m_loca.Has(0, (static_cast<size_t>(m_glyphCount) + 1) * (m_longLoca ? 4 : 2))) {
+            m_format = FontOutlineFormat::TrueType;
+        } else if (!cff.Empty()) {
+            m_cff = std::make_unique<CffOutlines>(cff, m_unitsPerEm);
+            if (m_cff->IsValid()) {
+                m_format = FontOutlineFormat::Cff;
+            }
+        }
+
+        SelectCmap();
+        ReadNames();
+        m_valid = true;
+    }
+
+    OpenTypeFont::~OpenTypeFont() = default;
+
+    bool OpenTypeFont::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, { L".ttf", L".otf", L".ttc", L".otc" });
+    }
+
+    ByteView OpenTypeFont::Table(const char tag[4]) const {
+        uint32_t wanted = Tag(tag);
+        uint16_t tableCount = m_directory.U16BE(4);
+        for (size_t i = 0; i < tableCount; ++i) {
+            size_t record = 12 + i * 16;
+            if (m_directory.U32BE(record) == wanted) {
+                uint32_t offset = m_directory.U32BE(record + 8);
+                uint32_t length = m_directory.U32BE(record + 12);
+                return m_data.Has(offset, length) ? m_data.Sub(offset, length) : ByteView();
+            }
+        }
+        return ByteView();
+    }
+
+    // Prefer full Unicode (format 12), then the BMP (format 4), then the
+    // Windows symbol encoding, then old Mac byte tables
+    void OpenTypeFont::SelectCmap() {
+        ByteView cmap = Table("cmap");
+        uint16_t count = cmap.U16BE(2);
+        int bestRank = 100;
+        for (size_t i = 0; i < count && cmap.Has(4 + i * 8, 8); ++i) {
+            uint16_t platform = cmap.U16BE(4 + i * 8);
+            uint16_t encoding = cmap.U16BE(6 + i * 8);
+            uint32_t offset = cmap.U32BE(8 + i * 8);
+            uint16_t format = cmap.U16BE(offset);
+
+            bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+            int rank = unicode && format == 12 ? 0
+                     : unicode && format == 4 ? 1
+                     : platform == 3 && encoding == 0 && format == 4 ? 2
+                     : platform == 1 && encoding == 0 && (format == 0 || format == 6) ? 3
+                     : 100;
+            if (rank >= bestRank) {
+                continue;
+            }
+
+            size_t length = format == 12 ? cmap.U32BE(offset + 4) : cmap.U16BE(offset + 2);
+            if (!cmap.Has(offset, length)) {
+                continue;
+            }
+            bestRank = rank;
+            m_cmap = cmap.Sub(offset, length);
+            m_cmapFormat = format;
+            m_symbolCmap = rank == 2;
+        }
+    }
+
+    uint16_t OpenTypeFont::GlyphIndex(uint32_t codepoint) const {
+        if (m_symbolCmap && codepoint < 0x100) {
+            // Symbol fonts map their characters at U+F020-U+F0FF
+            codepoint |= 0xF000;
+        }
+
+        uint32_t glyph = 0;
+        switch (m_cmapFormat) {
+        case 0:
+            glyph = codepoint < 256 ? m_cmap.U8(6 + codepoint) : 0;
+            break;
+        case 6: {
+            uint16_t first = m_cmap.U16BE(6);
+            uint16_t count = m_cmap.U16BE(8);
+            glyph = codepoint >= first && codepoint - first < count ? m_cmap.U16BE(10 + (codepoint - first) * 2) : 0;
+            break;
+        }
+        case 4: {
+            if (codepoint > 0xFFFF) {
+                break;
+            }
+            size_t segments = m_cmap.U16BE(6) / 2;
+            size_t ends = 14;
+            size_t starts = ends + segments * 2 + 2;
+            size_t deltas = starts + segments * 2;
+            size_t rangeOffsets = deltas + segments * 2;
+
+            // First segment whose end is at or past the code point
+            size_t low = 0;
+            size_t high = segments;
+            while (low < high) {
+                size_t mid = (low + high) / 2;
+                if (m_cmap.U16BE(ends + mid * 2) < codepoint) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low == segments || m_cmap.U16BE(starts + low * 2) > codepoint) {
+                break;
+            }
+            uint16_t delta = m_cmap.U16BE(deltas + low * 2);
+            uint16_t rangeOffset = m_cmap.U16BE(rangeOffsets + low * 2);
+            if (rangeOffset == 0) {
+                glyph = (codepoint + delta) & 0xFFFF;
+            } else {
+                size_t at = rangeOffsets + low * 2 + rangeOffset + (codepoint - m_cmap.U16BE(starts + low * 2)) * 2;
+                uint16_t value = m_cmap.U16BE(at);
+                glyph = value != 0 ? (value + delta) & 0xFFFF : 0;
+            }
+            break;
+        }
+        case 12: {
+            uint32_t groups = m_cmap.U32BE(12);
+            if (!m_cmap.Has(16, static_cast<size_t>(groups) * 12)) {
+                break;
+            }
+            size_t low = 0;
+            size_t high = groups;
+            while (low < high) {
+                size_t mid = (low + high) / 2;
+                if (m_cmap.U32BE(16 + mid * 12 + 4) < codepoint) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            size_t group = 16 + low * 12;
+            if (low < groups && m_cmap.U32BE(group) <= codepoint) {
+                glyph = m_cmap.U32BE(group + 8) + (codepoint - m_cmap.U32BE(group));
+            }
+            break;
+        }
+        }
+        return glyph < m_glyphCount ? static_cast<uint16_t>(glyph) : 0;
+    }
+
+    std::vector<uint32_t> OpenTypeFont::MappedCodepoints(size_t max) const {
+        std::vector<uint32_t> codepoints;
+        size_t lookups = MAX_CMAP_LOOKUPS;  // Hostile cmaps can claim every code point
+        auto consider = [&](uint32_t first, uint32_t last) {
+            for (uint32_t c = first; c <= last && codepoints.size() < max && lookups > 0; ++c, --lookups) {
+                if (GlyphIndex(c) != 0) {
+                    codepoints.push_back(c);
+                }
+            }
+        };
+
+        if (m_cmapFormat == 4) {
+            size_t segments = m_cmap.U16BE(6) / 2;
+            for (size_t s = 0; s < segments && codepoints.size() < max; ++s) {
+                uint16_t start = m_cmap.U16BE(14 + segments * 2 + 2 + s * 2);
+                uint16_t end = m_cmap.U16BE(14 + s * 2);
+                if (start != 0xFFFF) {
+                    consider(start, end);
+                }
+            }
+        } else if (m_cmapFormat == 12) {
+            uint32_t groups = m_cmap.U32BE(12);
+            for (size_t g = 0; g < groups && m_cmap.Has(16 + g * 12, 12) && codepoints.size() < max; ++g) {
+                consider(m_cmap.U32BE(16 + g * 12), std::min<uint32_t>(m_cmap.U32BE(20 + g * 12), 0x10FFFF));
+            }
+        } else if (m_cmapFormat == 6) {
+            uint32_t first = m_cmap.U16BE(6);
+            uint32_t count = m_cmap.U16BE(8);
+            if (count > 0) {
+                consider(first, first + count - 1);
+            }
+        } else if (!m_cmap.Empty()) {
+            consider(0, 0xFF);
+        }
+
+        if (m_symbolCmap) {
+            for (uint32_t& c : codepoints) {
+                if (c >= 0xF000 && c <= 0xF0FF) {
+                    c &= 0xFF;
+                }
+            }
+        }
+        return codepoints;
+    }
+
+    uint16_t OpenTypeFont::AdvanceWidth(uint16_t glyph) const {
+        size_t index = glyph < m_hMetricCount ? glyph : m_hMetricCount - 1u;
+        return m_hmtx.U16BE(index * 4);
+    }
+
+    void OpenTypeFont::ReadNames() {
+        ByteView name = Table("name");
+        uint16_t count = name.U16BE(2);
+        uint16_t storage = name.U16BE(4);
+
+        // Best record per name ID: Windows US English, then any Windows or
+        // Unicode record, then Mac Roman
+        int bestScore[18] = {};
+        ByteView bestBytes[18];
+        bool bestUtf16[18] = {};
+        for (size_t i = 0; i < count && name.Has(6 + i * 12, 12); ++i) {
+            size_t record = 6 + i * 12;
+            uint16_t platform = name.U16BE(record);
+            uint16_t encoding = name.U16BE(record + 2);
+            uint16_t language = name.U16BE(record + 4);
+            uint16_t id = name.U16BE(record + 6);
+            uint16_t length = name.U16BE(record + 8);
+            uint16_t offset = name.U16BE(record + 10);
+            if (id >= 18 || length == 0 || !name.Has(static_cast<size_t>(storage) + offset, length)) {
+                continue;
+            }
+
+            int score = platform == 3 && language == 0x409 ? 3
+                      : platform == 3 || platform == 0 ? 2
+                      : platform == 1 && encoding == 0 ? 1
+                      : 0;
+            if (score > bestScore[id]) {
+                bestScore[id] = score;
+                bestBytes[id] = name.Sub(static_cast<size_t>(storage) + offset, std::min<size_t>(length, MAX_NAME_BYTES));
+                bestUtf16[id] = platform != 1;
+            }
+        }
+
+        auto decode = [&](uint16_t id) {
+            return bestScore[id] == 0 ? std::string()
+                 : bestUtf16[id] ? DecodeUtf16BE(bestBytes[id]) : DecodeMacRoman(bestBytes[id]);
+        };
+        m_names.family = decode(bestScore[16] != 0 ? 16 : 1);
+        m_names.subfamily = decode(bestScore[17] != 0 ? 17 : 2);
+        m_names.fullName = decode(4);
+        m_names.version = decode(5);
+    }
+
+    bool OpenTypeFont::LoadOutline(uint16_t glyph, GlyphOutline& outline) const {
+        outline.Clear();
+        if (glyph >= m_glyphCount) {
+            return false;
+        }
+        if (m_format == FontOutlineFormat::Cff) {
+            return m_cff->LoadOutline(glyph, outline);
+        }
+        if (m_format != FontOutlineFormat::TrueType) {
+            return false;
+        }
+        static const float IDENTITY[6] = { 1, 0, 0, 1, 0, 0 };
+        size_t pointBudget = MAX_OUTLINE_POINTS;
+        return LoadTrueType(glyph, outline, 0, IDENTITY, pointBudget);
+    }
+
+    bool OpenTypeFont::LoadTrueType(uint16_t glyph, GlyphOutline& outline, size_t depth,
+                                    const float transform[6], size_t& pointBudget) const {
+        if (glyph >= m_glyphCount || depth > MAX_COMPONENT_DEPTH) {
+            return false;
+        }
+        size_t start = m_longLoca ? m_loca.U32BE(glyph * 4u) : m_loca.U16BE(glyph * 2u) * 2u;
+        size_t end = m_longLoca ? m_loca.U32BE(glyph * 4u + 4) : m_loca.U16BE(glyph * 2u + 2) * 2u;
+        if (end <= start) {
+            return end == start;  // No outline: a space
+        }
+        if (!m_glyf.Has(start, end - start)) {
+            return false;
+        }
+        ByteView data = m_glyf.Sub(start, end - start);
+        int16_t contours = I16(data, 0);
+
+        if (contours < 0) {
+            size_t at = 10;
+            uint16_t flags = MORE_COMPONENTS;
+            while (flags & MORE_COMPONENTS) {
+                if (!data.Has(at, 4)) {
+                    return false;
+                }
+                flags = data.U16BE(at);
+                uint16_t component = data.U16BE(at + 2);
+                at += 4;
+
+                float dx = 0;
+                float dy = 0;
+                if (flags & ARG_1_AND_2_ARE_WORDS) {
+                    dx = static_cast<float>(I16(data, at));
+                    dy = static_cast<float>(I16(data, at + 2));
+                    at += 4;
+                } else {
+                    dx = static_cast<float>(static_cast<int8_t>(data.U8(at)));
+                    dy = static_cast<float>(static_cast<int8_t>(data.U8(at + 1)));
+                    at += 2;
+                }
+                if (!(flags & ARGS_ARE_XY_VALUES)) {
+                    dx = 0;  // Point matching: rare, and only nudges the component
+                    dy = 0;
+                }
+
+                float local[6] = { 1, 0, 0, 1, 0, 0 };
+                if (flags & WE_HAVE_A_SCALE) {
+                    local[0] = local[3] = F2Dot14(data, at);
+                    at += 2;
+                } else if (flags & WE_HAVE_AN_X_AND_Y_SCALE) {
+                    local[0] = F2Dot14(data, at);
+                    local[3] = F2Dot14(data, at + 2);
+                    at += 4;
+                } else if (flags & WE_HAVE_A_TWO_BY_TWO) {
+                    local[0] = F2Dot14(data, at);
+                    local[1] = F2Dot14(data, at + 2);
+                    local[2] = F2Dot14(data, at + 4);
+                    local[3] = F2Dot14(data, at + 6);
+                    at += 8;
+                }
+                if (flags & SCALED_COMPONENT_OFFSET) {
+                    local[4] = local[0] * dx + local[2] * dy;
+                    local[5] = local[1] * dx + local[3] * dy;
+                } else {
+                    local[4] = dx;
+                    local[5] = dy;
+                }
+
+                float combined[6];
+                Compose(transform, local, combined);
+                if (!LoadTrueType(component, outline, depth + 1, combined, pointBudget)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Simple glyph: contour end points, instructions, flags, then x and y deltas
+        size_t contourCount = static_cast<size_t>(contours);
+        if (contourCount == 0) {
+            return true;
+        }
+        if (!data.Has(10, contourCount * 2 + 2)) {
+            return false;
+        }
+        size_t pointCount = data.U16BE(10 + (contourCount - 1) * 2) + 1u;
+        if (pointCount > pointBudget) {
+            return false;
+        }
+        pointBudget -= pointCount;
+
+        size_t at = 10 + contourCount * 2;
+        at += 2 + data.U16BE(at);
+
+        std::vector<uint8_t> flags(pointCount);
+        for (size_t i = 0; i < pointCount;) {
+            if (!data.Has(at, 1)) {
+                return false;
+            }
+            uint8_t flag = data.U8(at++);
+            size_t repeat = 1;
+            if (flag & REPEAT) {
+                repeat += data.U8(at++);
+            }
+            for (size_t r = 0; r < repeat && i < pointCount; ++r) {
+                flags[i++] = flag;
+            }
+        }
+
+        std::vector<float> xs(pointCount);
+        std::vector<float> ys(pointCount);
+        auto readAxis = [&](std::vector<float>& values, uint8_t shortBit, uint8_t sameBit) {
+            int32_t value = 0;
+            for (size_t i = 0; i < pointCount; ++i) {
+                uint8_t flag = flags[i];
+                if (flag & shortBit) {
+                    if (!data.Has(at, 1)) {
+                        return false;
+                    }
+                    int32_t delta = data.U8(at++);
+                    value += (flag & sameBit) ? delta : -delta;
+                } else if (!(flag & sameBit)) {
+                    if (!data.Has(at, 2)) {
+                        return false;
+                    }
+                    value += I16(data, at);
+                    at += 2;
+                }
+                values[i] = static_cast<float>(value);
+            }
+            return true;
+        };
+        if (!readAxis(xs, X_SHORT, X_SAME_OR_POSITIVE) || !readAxis(ys, Y_SHORT, Y_SAME_OR_POSITIVE)) {
+            return false;
+        }
+        for (size_t i = 0; i < pointCount; ++i) {
+            float x = xs[i];
+            float y = ys[i];
+            xs[i] = transform[0] * x + transform[2] * y + transform[4];
+            ys[i] = transform[1] * x + transform[3] * y + transform[5];
+        }
+
+        // Quadratic B-splines: two off-curve points in a row imply an
+        // on-curve point halfway between them
+        size_t first = 0;
+        for (size_t c = 0; c < contourCount; ++c) {
+            size_t last = data.U16BE(10 + c * 2);
+            if (last < first || last >= pointCount) {
+                return false;
+            }
+            size_t count = last - first + 1;
+
+            size_t startIndex = count;
+            for (size_t i = 0; i < count; ++i) {
+                if (flags[first + i] & ON_CURVE) {
+                    startIndex = i;
+                    break;
+                }
+            }
+
+            float startX;
+            float startY;
+            size_t steps;
+            if (startIndex < count) {
+                startX = xs[first + startIndex];
+                startY = ys[first + startIndex];
+                steps = count;  // Ends back on the start point, closing the contour
+            } else {
+                startX = (xs[first] + xs[last]) * 0.5f;
+                startY = (ys[first] + ys[last]) * 0.5f;
+                startIndex = count - 1;
+                steps = count;
+            }
+            outline.MoveTo(startX, startY);
+
+            bool pending = false;
+            float controlX = 0;
+            float controlY = 0;
+            for (size_t s = 1; s <= steps; ++s) {
+                size_t i = first + (startIndex + s) % count;
+                float x = xs[i];
+                float y = ys[i];
+                if (flags[i] & ON_CURVE) {
+                    if (pending) {
+                        outline.QuadTo(controlX, controlY, x, y);
+                    } else {
+                        outline.LineTo(x, y);
+                    }
+                    pending = false;
+                } else {
+                    if (pending) {
+                        outline.QuadTo(controlX, controlY, (controlX + x) * 0.5f, (controlY + y) * 0.5f);
+                    }
+                    controlX = x;
+                    controlY = y;
+                    pending = true;
+                }
+            }
+            if (pending) {
+                outline.QuadTo(controlX, controlY, startX, startY);
+            }
+            first = last + 1;
+        }
+        return true;
+    }
+}
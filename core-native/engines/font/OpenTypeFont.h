@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GlyphOutline.h"
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    class CffOutlines;
+
+    enum class FontOutlineFormat : uint8_t {
+        None,      // Bitmap-only or CFF2 (variable) fonts: nothing to draw
+        TrueType,  // glyf/loca quadratic outlines
+        Cff        // CFF Type 2 charstrings
+    };
+
+    // From the name table, as UTF-8; typographic family names preferred
+    struct FontNames {
+        std::string family;
+        std::string subfamily;
+        std::string fullName;
+        std::string version;
+    };
+
+    // Read-only OpenType/TrueType reader over a memory-mapped font file
+    // (.ttf, .otf, or one face of a .ttc collection). It reads the tables a
+    // specimen needs (head, hhea, maxp, hmtx, cmap, name) and turns glyf or
+    // CFF glyphs into outlines on demand, touching only the pages of the
+    // glyphs drawn. No hinting, shaping or kerning: a preview shows what
+    // the font looks like, not how a text engine would lay it out.
+    class OpenTypeFont {
+    public:
+        static constexpr size_t MAX_COMPONENT_DEPTH = 8;
+        static constexpr size_t MAX_OUTLINE_POINTS = 1 << 16;
+
+        explicit OpenTypeFont(ByteView data, uint32_t faceIndex = 0);
+        ~OpenTypeFont();
+
+        OpenTypeFont(const OpenTypeFont&) = delete;
+        OpenTypeFont& operator=(const OpenTypeFont&) = delete;
+
+        static bool HandlesExtension(std::wstring_view extension);
+
+        bool IsValid() const { return m_valid; }
+        uint32_t FaceCount() const { return m_faceCount; }
+        FontOutlineFormat OutlineFormat() const { return m_format; }
+        const FontNames& Names() const { return m_names; }
+
+        uint16_t UnitsPerEm() const { return m_unitsPerEm; }
+        int16_t Ascender() const { return m_ascender; }
+        int16_t Descender() const { return m_descender; }  // Negative below the baseline
+        int16_t LineGap() const { return m_lineGap; }
+        uint16_t GlyphCount() const { return m_glyphCount; }
+
+        // Glyph for a Unicode code point; 0 (.notdef) if the font has none
+        uint16_t GlyphIndex(uint32_t codepoint) const;
+
+        // The first `max` code points the cmap maps, ascending
+        std::vector<uint32_t> MappedCodepoints(size_t max) const;
+
+        // Font units
+        uint16_t AdvanceWidth(uint16_t glyph) const;
+
+        // False if the glyph is out of range or malformed; an empty outline
+        // (a space) is not an error
+        bool LoadOutline(uint16_t glyph, GlyphOutline& outline) const;
+
+    private:
+        ByteView Table(const char tag[4]) const;
+        void ReadNames();
+        void SelectCmap();
+        bool LoadTrueType(uint16_t glyph, GlyphOutline& outline, size_t depth,
+                          const float transform[6], size_t& pointBudget) const;
+
+        ByteView m_data;
+        ByteView m_directory;  // This face's table directory
+        bool m_valid;
+        uint32_t m_faceCount;
+        FontOutlineFormat m_format;
+        FontNames m_names;
+
+        uint16_t m_unitsPerEm;
+        int16_t m_ascender;
+        int16_t m_descender;
+        int16_t m_lineGap;
+        uint16_t m_glyphCount;
+        uint16_t m_hMetricCount;
+        bool m_longLoca;
+
+        ByteView m_hmtx;
+        ByteView m_loca;
+        ByteView m_glyf;
+        ByteView m_cmap;       // The chosen subtable
+        uint16_t m_cmapFormat;
+        bool m_symbolCmap;     // Windows symbol encoding: code points live at U+F0xx
+
+        std::unique_ptr<CffOutlines> m_cff;
+    };
+}
@@ -0,0 +1,149 @@
+#include "Crc32c.h"
+#include <cstring>
+#include "../../common/CpuFeatures.h"
+
+namespace Lumos {
+    namespace {
+        constexpr uint32_t POLYNOMIAL = 0x82F63B78u;  // Reflected 0x1EDC6F41
+
+        // Slicing-by-8: TABLES[k][b] is the remainder of byte b followed by k zero bytes
+        struct Tables {
+            uint32_t t[8][256];
+
+            Tables() : t{} {
+                for (uint32_t b = 0; b < 256; ++b) {
+                    uint32_t crc = b;
+                    for (int bit = 0; bit < 8; ++bit) {
+                        crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+                    }
+                    t[0][b] = crc;
+                }
+                for (uint32_t b = 0; b < 256; ++b) {
+                    for (int k = 1; k < 8; ++k) {
+                        t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+                    }
+                }
+            }
+        };
+
+        const Tables& SlicingTables() {
+            static const Tables tables;
+            return tables;
+        }
+
+        uint32_t UpdatePortable(uint32_t crc, const uint8_t* data, size_t length) {
+            const auto& t = SlicingTables().t;
+            while (length >= 8) {
+                uint32_t low;
+                uint32_t high;
+                std::memcpy(&low, data, 4);
+                std::memcpy(&high, data + 4, 4);
+                low ^= crc;
+                crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                      t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+                data += 8;
+                length -= 8;
+            }
+            while (length-- > 0) {
+                crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+            }
+            return crc;
+        }
+
+#ifdef LUMOS_X64
+        // Three independent streams hide the instruction's 3-cycle latency;
+        // they are merged with a carry-less shift by the stream length, done
+        // with the same instruction on a precomputed power of x
+        constexpr size_t STREAM_BYTES = 8 * 1024;
+
+        // x^(8n-33) mod P as a multiplier for shifting a CRC over n zero bytes
+        uint32_t ShiftConstant(size_t bytes) {
+            // Square-and-multiply on the reflected representation
+            auto multiply = [](uint32_t a, uint32_t b) {
+                uint32_t product = 0;
+                for (int i = 0; i < 32; ++i) {
+                    if (a & 0x80000000u) {
+                        product ^= b;
+                    }
+                    a <<= 1;
+                    b = (b >> 1) ^ (POLYNOMIAL & (0u - (b & 1)));
+                }
+                return product;
+            };
+            uint32_t result = 0x80000000u;  // x^0
+            uint32_t power = 0x40000000u;   // x^1
+            for (uint64_t n = 8 * static_cast<uint64_t>(bytes) - 33; n != 0; n >>= 1) {
+                if (n & 1) {
+                    result = multiply(result, power);
+                }
+                power = multiply(power, power);
+            }
+            return result;
+        }
+
+        LUMOS_TARGET("sse4.2,pclmul") uint32_t Shift(uint32_t crc, uint32_t constant) {
+            __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+                                                   _mm_cvtsi32_si128(static_cast<int>(constant)), 0);
+            return static_cast<uint32_t>(_mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+        }
+
+        LUMOS_TARGET("sse4.2,pclmul") uint32_t UpdateSse42(uint32_t crc, const uint8_t* data, size_t length) {
+            static const uint32_t streamShift = ShiftConstant(STREAM_BYTES);
+
+            uint64_t c0 = crc;
+            while (length >= 3 * STREAM_BYTES) {
+                uint64_t c1 = 0;
+                uint64_t c2 = 0;
+                for (size_t i = 0; i < STREAM_BYTES; i += 8) {
+                    uint64_t v0;
+                    uint64_t v1;
+                    uint64_t v2;
+                    std::memcpy(&v0, data + i, 8);
+                    std::memcpy(&v1, data + STREAM_BYTES + i, 8);
+                    std::memcpy(&v2, data + 2 * STREAM_BYTES + i, 8);
+                    c0 = _mm_crc32_u64(c0, v0);
+                    c1 = _mm_crc32_u64(c1, v1);
+                    c2 = _mm_crc32_u64(c2, v2);
+                }
+                c0 = Shift(static_cast<uint32_t>(c0), streamShift) ^ c1;
+                c0 = Shift(static_cast<uint32_t>(c0), streamShift) ^ c2;
+                data += 3 * STREAM_BYTES;
+                length -= 3 * STREAM_BYTES;
+            }
+            while (length >= 8) {
+                uint64_t v;
+                std::memcpy(&v, data, 8);
+                c0 = _mm_crc32_u64(c0, v);
+                data += 8;
+                length -= 8;
+            }
+            uint32_t c = static_cast<uint32_t>(c0);
+            while (length-- > 0) {
+                c = _mm_crc32_u8(c, *data++);
+            }
+            return c;
+        }
+
+        const bool g_hasSse42 = Cpu().sse42 && Cpu().pclmul;
+#endif
+    }
+
+    Crc32c::Crc32c()
+        : m_crc(0xFFFFFFFFu)
+    {
+    }
+
+    void Crc32c::Update(const uint8_t* data, size_t length) {
+#ifdef LUMOS_X64
+        if (g_hasSse42) {
+            m_crc = UpdateSse42(m_crc, data, length);
+            return;
+        }
+#endif
+        m_crc = UpdatePortable(m_crc, data, length);
+    }
+
+    uint32_t Crc32c::Finish() const {
+        return ~m_crc;
+    }
+}
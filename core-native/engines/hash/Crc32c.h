@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Lumos {
+    // Streaming CRC-32C (Castagnoli, as in iSCSI, ext4 and cloud storage
+    // object checksums). Uses the SSE4.2 CRC32 instruction when present.
+    class Crc32c {
+    public:
+        Crc32c();
+
+        void Update(const uint8_t* data, size_t length);
+
+        // Does not disturb the state; more data may follow
+        uint32_t Finish() const;
+
+    private:
+        uint32_t m_crc;  // Inverted running remainder
+    };
+}
@@ -0,0 +1,228 @@
+#include "FileHasher.h"
+#include <algorithm>
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        // One read per page is enough to fault it in
+        constexpr size_t PAGE_STRIDE = 4096;
+
+        // How often a blocked reader looks at the cancellation token
+        constexpr auto CANCEL_POLL = std::chrono::milliseconds(10);
+
+        // Hash lanes yield to interactive work such as visible tiles
+        constexpr int HASH_PRIORITY = 3;
+
+        // Longest a block read waits before looking at the token again
+        constexpr auto READ_BUDGET = std::chrono::milliseconds(250);
+    }
+
+    FileHasher::FileHasher(WorkerPool& workers)
+        : m_workers(workers)
+        , m_reader(nullptr)
+        , m_size(0)
+        , m_blockCount(0)
+        , m_blocksRead(0)
+        , m_lanesBlocks{}
+        , m_laneQueued{}
+        , m_stopped(false)
+    {
+    }
+
+    FileHasher::~FileHasher() = default;
+
+    bool FileHasher::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, {
+            L".iso", L".img", L".dmg", L".vhd", L".vhdx", L".vmdk", L".qcow2",
+            L".zip", L".7z", L".rar", L".tar", L".gz", L".tgz", L".bz2", L".xz", L".zst",
+            L".exe", L".msi", L".msix", L".appx", L".dll", L".sys", L".bin", L".apk", L".deb", L".rpm"
+        });
+    }
+
+    std::optional<FileHashes> FileHasher::Hash(ByteView data, const CancellationToken& cancellation,
+                                               const HashProgressCallback& onProgress) {
+        m_data = data;
+        m_reader = nullptr;
+        return Run(data.Size(), cancellation, onProgress);
+    }
+
+    std::optional<FileHashes> FileHasher::Hash(IOScheduler& io, std::wstring_view path, uint64_t size,
+                                               const CancellationToken& cancellation,
+                                               const HashProgressCallback& onProgress) {
+        m_data = ByteView();
+        m_reader = &io;
+        m_path = path;
+        auto hashes = Run(size, cancellation, onProgress);
+
+        // Up to WINDOW_BLOCKS + 1 blocks; not worth keeping between files
+        for (auto& block : m_window) {
+            block = std::vector<uint8_t>();
+        }
+        m_read.data = std::vector<uint8_t>();
+        m_reader = nullptr;
+        return hashes;
+    }
+
+    std::optional<FileHashes> FileHasher::Run(uint64_t size, const CancellationToken& cancellation,
+                                              const HashProgressCallback& onProgress) {
+        using Clock = std::chrono::steady_clock;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_size = size;
+        m_blockCount = static_cast<size_t>((size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        m_blocksRead = 0;
+        std::fill(std::begin(m_lanesBlocks), std::end(m_lanesBlocks), 0);
+        std::fill(std::begin(m_laneQueued), std::end(m_laneQueued), false);
+        m_stopped = false;
+        m_xxh3 = Xxh3();
+        m_crc32c = Crc32c();
+        m_sha1 = Sha1();
+        m_sha256 = Sha256();
+
+        auto lastReport = Clock::now();
+        auto report = [&](bool force) {
+            auto now = Clock::now();
+            if (onProgress && (force || now - lastReport >= PROGRESS_INTERVAL)) {
+                lastReport = now;
+                uint64_t hashed = HashedBytes();
+                lock.unlock();
+                onProgress(hashed, size);
+                lock.lock();
+            }
+        };
+        auto slowestLane = [this] {
+            return *std::min_element(std::begin(m_lanesBlocks), std::end(m_lanesBlocks));
+        };
+
+        bool stopped = false;
+        while (!stopped && slowestLane() < m_blockCount) {
+            if (m_blocksRead < m_blockCount && m_blocksRead < slowestLane() + WINDOW_BLOCKS) {
+                // Read the next block without holding the lock; the lanes
+                // keep hashing what was read before it meanwhile
+                size_t block = m_blocksRead;
+                lock.unlock();
+                bool read = ReadBlock(block, cancellation);
+                lock.lock();
+                if (!read) {
+                    break;
+                }
+                ++m_blocksRead;
+                Schedule();
+            } else {
+                m_progress.wait_for(lock, CANCEL_POLL);
+            }
+            stopped = cancellation.IsCancellationRequested();
+            report(false);
+        }
+
+        if (slowestLane() < m_blockCount) {
+            // Cancelled or unreadable. Queued lane jobs still run; they only
+            // need to see the flag.
+            m_stopped = true;
+            m_progress.wait(lock, [this] {
+                return std::none_of(std::begin(m_laneQueued), std::end(m_laneQueued), [](bool queued) { return queued; });
+            });
+            m_data = ByteView();
+            return std::nullopt;
+        }
+
+        report(true);
+        m_data = ByteView();
+
+        FileHashes hashes;
+        hashes.xxh3 = m_xxh3.Finish();
+        hashes.crc32c = m_crc32c.Finish();
+        m_sha1.Finish(hashes.sha1);
+        m_sha256.Finish(hashes.sha256);
+        return hashes;
+    }
+
+    bool FileHasher::ReadBlock(size_t block, const CancellationToken& cancellation) {
+        uint64_t begin = static_cast<uint64_t>(block) * BLOCK_SIZE;
+        size_t length = static_cast<size_t>(std::min<uint64_t>(BLOCK_SIZE, m_size - begin));
+        if (!m_reader) {
+            // Fault the mapping in; the lanes then hash straight from it
+            volatile uint8_t touched = 0;
+            for (size_t offset = 0; offset < length; offset += PAGE_STRIDE) {
+                touched = touched ^ m_data.Data()[begin + offset];
+            }
+            return true;
+        }
+
+        // Every wait ends by READ_BUDGET, so a dead share never holds up a
+        // newer press for longer than that; a slow one just takes its time
+        std::vector<uint8_t>& bytes = m_window[block % WINDOW_BLOCKS];
+        bytes.clear();
+        while (bytes.size() < length && !cancellation.IsCancellationRequested()) {
+            m_reader->Read(m_path, begin + bytes.size(), length - bytes.size(), READ_BUDGET, m_read,
+                           IOPriority::Interactive, cancellation);
+            if (m_read.status == IOStatus::Failed || m_read.status == IOStatus::Cancelled ||
+                (m_read.status == IOStatus::Complete && bytes.size() + m_read.data.size() < length)) {
+                return false;  // Gone, or shorter than when hashing began
+            }
+            if (bytes.empty()) {
+                bytes.swap(m_read.data);
+            } else {
+                bytes.insert(bytes.end(), m_read.data.begin(), m_read.data.end());
+            }
+        }
+        return bytes.size() == length;
+    }
+
+    // Queue the next block for every idle lane that has one read. Called with m_mutex held.
+    void FileHasher::Schedule() {
+        for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+            if (!m_laneQueued[lane] && !m_stopped && m_lanesBlocks[lane] < m_blocksRead) {
+                m_laneQueued[lane] = true;
+                m_workers.Submit([this, lane] { HashBlock(lane); }, HASH_PRIORITY);
+            }
+        }
+    }
+
+    void FileHasher::HashBlock(size_t lane) {
+        size_t block;
+        bool stopped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            block = m_lanesBlocks[lane];
+            stopped = m_stopped;
+        }
+
+        if (!stopped) {
+            uint64_t begin = static_cast<uint64_t>(block) * BLOCK_SIZE;
+            size_t length = static_cast<size_t>(std::min<uint64_t>(BLOCK_SIZE, m_size - begin));
+            const uint8_t* bytes = m_reader ? m_window[block % WINDOW_BLOCKS].data() : m_data.Data() + begin;
+            switch (lane) {
+            case LANE_XXH3:
+                m_xxh3.Update(bytes, length);
+                break;
+            case LANE_CRC32C:
+                m_crc32c.Update(bytes, length);
+                break;
+            case LANE_SHA1:
+                m_sha1.Update(bytes, length);
+                break;
+            case LANE_SHA256:
+                m_sha256.Update(bytes, length);
+                break;
+            default:
+                return;  // Not a lane: Schedule never queued it
+            }
+        }
+
+        // One job per lane at a time: the next block is a new job, so with
+        // few threads the lanes take turns instead of one running to the end
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_laneQueued[lane] = false;
+        if (!stopped) {
+            ++m_lanesBlocks[lane];
+            Schedule();
+        }
+        m_progress.notify_all();
+    }
+
+    uint64_t FileHasher::HashedBytes() const {
+        size_t slowest = *std::min_element(std::begin(m_lanesBlocks), std::end(m_lanesBlocks));
+        return std::min<uint64_t>(static_cast<uint64_t>(slowest) * BLOCK_SIZE, m_size);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "Crc32c.h"
+#include "Sha1.h"
+#include "Sha256.h"
+#include "Xxh3.h"
+#include "../../common/ByteView.h"
+#include "../../common/CancellationToken.h"
+#include "../../common/WorkerPool.h"
+#include "../../io/IOScheduler.h"
+
+namespace Lumos {
+    struct FileHashes {
+        uint64_t xxh3;
+        uint32_t crc32c;
+        uint8_t sha1[Sha1::DIGEST_SIZE];
+        uint8_t sha256[Sha256::DIGEST_SIZE];
+    };
+
+    // Bytes every algorithm has finished with, out of the total. Called on
+    // the thread running the hash, at most every PROGRESS_INTERVAL.
+    using HashProgressCallback = std::function<void(uint64_t hashedBytes, uint64_t totalBytes)>;
+
+    // Checksums a file with all four algorithms in one pass. The calling
+    // thread reads block by block, so page-cache misses and slow disks
+    // never stall the worker pool. Each algorithm is a
+    // lane on the pool that hashes the blocks read so far in order, one
+    // BLOCK_SIZE job at a time, so the lanes run side by side and the file
+    // takes about as long as its slowest algorithm. Reading stays at most
+    // WINDOW_BLOCKS ahead of the slowest lane to bound the memory in flight.
+    class FileHasher {
+    public:
+        static constexpr size_t BLOCK_SIZE = 4 * 1024 * 1024;
+        static constexpr size_t WINDOW_BLOCKS = 8;
+        static constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+
+        explicit FileHasher(WorkerPool& workers);
+        ~FileHasher();
+
+        FileHasher(const FileHasher&) = delete;
+        FileHasher& operator=(const FileHasher&) = delete;
+
+        // Archives, disk images, installers and binaries: files people check
+        // a published checksum for and that no other engine previews
+        static bool HandlesExtension(std::wstring_view extension);
+
+        // Hash `data`, which must stay valid until this returns. Nullopt if
+        // cancelled. Blocks until done, so it must not be called from the
+        // worker pool.
+        std::optional<FileHashes> Hash(ByteView data, const CancellationToken& cancellation,
+                                       const HashProgressCallback& onProgress = nullptr);
+
+        // Hash the first `size` bytes of the file at `path`, read through
+        // `io` into a window of WINDOW_BLOCKS buffers. Nothing is mapped, so a
+        // share that drops or a writer that truncates the file fails the
+        // read instead of faulting the process, and each wait is bounded.
+        // Nullopt if cancelled or the file could not be read that far.
+        std::optional<FileHashes> Hash(IOScheduler& io, std::wstring_view path, uint64_t size,
+                                       const CancellationToken& cancellation,
+                                       const HashProgressCallback& onProgress = nullptr);
+
+    private:
+        enum Lane { LANE_XXH3, LANE_CRC32C, LANE_SHA1, LANE_SHA256, LANE_COUNT };
+
+        std::optional<FileHashes> Run(uint64_t size, const CancellationToken& cancellation,
+                                      const HashProgressCallback& onProgress);
+        bool ReadBlock(size_t block, const CancellationToken& cancellation);
+        void Schedule();
+        void HashBlock(size_t lane);
+        uint64_t HashedBytes() const;
+
+        WorkerPool& m_workers;
+
+        // Current run, guarded by m_mutex except each lane's hasher, which
+        // only its one queued job touches
+        std::mutex m_mutex;
+        std::condition_variable m_progress;
+        ByteView m_data;
+        IOScheduler* m_reader;             // Set: blocks come from m_window, not m_data
+        std::wstring_view m_path;
+        uint64_t m_size;
+        size_t m_blockCount;
+        size_t m_blocksRead;
+        size_t m_lanesBlocks[LANE_COUNT];  // Blocks each lane has hashed
+        bool m_laneQueued[LANE_COUNT];
+        bool m_stopped;
+
+        // Reading thread only, except the lanes reading the blocks it filled
+        std::vector<uint8_t> m_window[WINDOW_BLOCKS];
+        IOResult m_read;
+
+        Xxh3 m_xxh3;
+        Crc32c m_crc32c;
+        Sha1 m_sha1;
+        Sha256 m_sha256;
+    };
+}
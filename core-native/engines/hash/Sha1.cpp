@@ -0,0 +1,177 @@
+#include "Sha1.h"
+#include <cstring>
+#include <utility>
+#include "../../common/CpuFeatures.h"
+
+namespace Lumos {
+    namespace {
+        inline uint32_t Rotl(uint32_t x, int r) {
+            return (x << r) | (x >> (32 - r));
+        }
+
+        inline uint32_t ReadBigEndian32(const uint8_t* p) {
+            return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        }
+
+        void CompressPortable(uint32_t* state, const uint8_t* blocks, size_t count) {
+            uint32_t w[80];
+            for (; count > 0; --count, blocks += 64) {
+                for (int i = 0; i < 16; ++i) {
+                    w[i] = ReadBigEndian32(blocks + 4 * i);
+                }
+                for (int i = 16; i < 80; ++i) {
+                    w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                }
+
+                uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+                for (int i = 0; i < 80; ++i) {
+                    uint32_t f;
+                    uint32_t k;
+                    if (i < 20) {
+                        f = (b & c) | (~b & d);
+                        k = 0x5A827999;
+                    } else if (i < 40) {
+                        f = b ^ c ^ d;
+                        k = 0x6ED9EBA1;
+                    } else if (i < 60) {
+                        f = (b & c) | (b & d) | (c & d);
+                        k = 0x8F1BBCDC;
+                    } else {
+                        f = b ^ c ^ d;
+                        k = 0xCA62C1D6;
+                    }
+                    uint32_t t = Rotl(a, 5) + f + e + k + w[i];
+                    e = d;
+                    d = c;
+                    c = Rotl(b, 30);
+                    b = a;
+                    a = t;
+                }
+                state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+            }
+        }
+
+#ifdef LUMOS_X64
+        // Rounds 4G..4G+3. E alternates between two registers; w[] holds four
+        // message vectors in rotation, the schedule running a few groups ahead.
+        template <int G>
+        LUMOS_TARGET("sha,sse4.1") inline void ShaNiGroup(__m128i& abcd, __m128i (&e)[2], __m128i (&w)[4]) {
+            __m128i& eIn = e[G % 2];
+            if (G == 0) {
+                eIn = _mm_add_epi32(eIn, w[0]);
+            } else {
+                eIn = _mm_sha1nexte_epu32(eIn, w[G % 4]);
+            }
+            e[(G + 1) % 2] = abcd;
+            if (G >= 3 && G <= 18) {
+                w[(G + 1) % 4] = _mm_sha1msg2_epu32(w[(G + 1) % 4], w[G % 4]);
+            }
+            abcd = _mm_sha1rnds4_epu32(abcd, eIn, G / 5);
+            if (G >= 1 && G <= 16) {
+                w[(G + 3) % 4] = _mm_sha1msg1_epu32(w[(G + 3) % 4], w[G % 4]);
+            }
+            if (G >= 2 && G <= 17) {
+                w[(G + 2) % 4] = _mm_xor_si128(w[(G + 2) % 4], w[G % 4]);
+            }
+        }
+
+        template <int... G>
+        LUMOS_TARGET("sha,sse4.1") inline void ShaNiRounds(__m128i& abcd, __m128i (&e)[2], __m128i (&w)[4],
+                                                           std::integer_sequence<int, G...>) {
+            (ShaNiGroup<G>(abcd, e, w), ...);
+        }
+
+        LUMOS_TARGET("sha,sse4.1") void CompressShaNi(uint32_t* state, const uint8_t* blocks, size_t count) {
+            const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+
+            __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+            __m128i e[2] = { _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0), _mm_setzero_si128() };
+
+            for (; count > 0; --count, blocks += 64) {
+                __m128i abcdSaved = abcd;
+                __m128i eSaved = e[0];
+                __m128i w[4];
+                for (int i = 0; i < 4; ++i) {
+                    w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks) + i), byteSwap);
+                }
+                ShaNiRounds(abcd, e, w, std::make_integer_sequence<int, 20>());
+                e[0] = _mm_sha1nexte_epu32(e[0], eSaved);
+                abcd = _mm_add_epi32(abcd, abcdSaved);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+            state[4] = static_cast<uint32_t>(_mm_extract_epi32(e[0], 3));
+        }
+
+        const bool g_hasShaNi = Cpu().sha;
+#endif
+
+        void Compress(uint32_t* state, const uint8_t* blocks, size_t count) {
+#ifdef LUMOS_X64
+            if (g_hasShaNi) {
+                CompressShaNi(state, blocks, count);
+                return;
+            }
+#endif
+            CompressPortable(state, blocks, count);
+        }
+    }
+
+    Sha1::Sha1()
+        : m_state{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 }
+        , m_buffer{}
+        , m_buffered(0)
+        , m_totalLength(0)
+    {
+    }
+
+    void Sha1::Update(const uint8_t* data, size_t length) {
+        m_totalLength += length;
+        if (m_buffered > 0) {
+            size_t fill = BLOCK_SIZE - m_buffered;
+            if (length < fill) {
+                std::memcpy(m_buffer + m_buffered, data, length);
+                m_buffered += length;
+                return;
+            }
+            std::memcpy(m_buffer + m_buffered, data, fill);
+            Compress(m_state, m_buffer, 1);
+            data += fill;
+            length -= fill;
+            m_buffered = 0;
+        }
+
+        size_t blocks = length / BLOCK_SIZE;
+        if (blocks > 0) {
+            Compress(m_state, data, blocks);
+            data += blocks * BLOCK_SIZE;
+            length -= blocks * BLOCK_SIZE;
+        }
+        std::memcpy(m_buffer, data, length);
+        m_buffered = length;
+    }
+
+    void Sha1::Finish(uint8_t (&digest)[DIGEST_SIZE]) const {
+        uint32_t state[5];
+        std::memcpy(state, m_state, sizeof(state));
+
+        // 0x80, zeros, then the length in bits, big-endian, ending a block
+        uint8_t tail[2 * BLOCK_SIZE] = {};
+        std::memcpy(tail, m_buffer, m_buffered);
+        tail[m_buffered] = 0x80;
+        size_t tailSize = m_buffered + 1 + 8 <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+        uint64_t bits = m_totalLength * 8;
+        for (int i = 0; i < 8; ++i) {
+            tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        Compress(state, tail, tailSize / BLOCK_SIZE);
+
+        for (int i = 0; i < 5; ++i) {
+            digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+            digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Lumos {
+    // Streaming SHA-1 (FIPS 180-4). Broken for collision resistance; shown
+    // because download pages and older tools still publish it. Uses the SHA
+    // extensions when present.
+    class Sha1 {
+    public:
+        static constexpr size_t DIGEST_SIZE = 20;
+
+        Sha1();
+
+        void Update(const uint8_t* data, size_t length);
+
+        // Does not disturb the state; more data may follow
+        void Finish(uint8_t (&digest)[DIGEST_SIZE]) const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64;
+
+        uint32_t m_state[5];
+        uint8_t m_buffer[BLOCK_SIZE];
+        size_t m_buffered;
+        uint64_t m_totalLength;
+    };
+}
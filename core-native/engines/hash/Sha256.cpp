@@ -0,0 +1,179 @@
+#include "Sha256.h"
+#include <cstring>
+#include <utility>
+#include "../../common/CpuFeatures.h"
+
+namespace Lumos {
+    namespace {
+        alignas(16) constexpr uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+        };
+
+        inline uint32_t Rotr(uint32_t x, int r) {
+            return (x >> r) | (x << (32 - r));
+        }
+
+        inline uint32_t ReadBigEndian32(const uint8_t* p) {
+            return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | p[3];
+        }
+
+        void CompressPortable(uint32_t* state, const uint8_t* blocks, size_t count) {
+            uint32_t w[64];
+            for (; count > 0; --count, blocks += 64) {
+                for (int i = 0; i < 16; ++i) {
+                    w[i] = ReadBigEndian32(blocks + 4 * i);
+                }
+                for (int i = 16; i < 64; ++i) {
+                    uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+                uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+                for (int i = 0; i < 64; ++i) {
+                    uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                    uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + t1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = t1 + t2;
+                }
+                state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+                state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+            }
+        }
+
+#ifdef LUMOS_X64
+        // Rounds 4G..4G+3. The schedule for later groups is computed in the
+        // same pass: w[] holds four message vectors in rotation.
+        template <int G>
+        LUMOS_TARGET("sha,sse4.1") inline void ShaNiGroup(__m128i& abef, __m128i& cdgh, __m128i (&w)[4]) {
+            __m128i message = _mm_add_epi32(w[G % 4], _mm_load_si128(reinterpret_cast<const __m128i*>(K) + G));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            if (G >= 3 && G <= 14) {
+                __m128i carry = _mm_alignr_epi8(w[G % 4], w[(G + 3) % 4], 4);
+                w[(G + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(w[(G + 1) % 4], carry), w[G % 4]);
+            }
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0E));
+            if (G >= 1 && G <= 12) {
+                w[(G + 3) % 4] = _mm_sha256msg1_epu32(w[(G + 3) % 4], w[G % 4]);
+            }
+        }
+
+        template <int... G>
+        LUMOS_TARGET("sha,sse4.1") inline void ShaNiRounds(__m128i& abef, __m128i& cdgh, __m128i (&w)[4],
+                                                           std::integer_sequence<int, G...>) {
+            (ShaNiGroup<G>(abef, cdgh, w), ...);
+        }
+
+        LUMOS_TARGET("sha,sse4.1") void CompressShaNi(uint32_t* state, const uint8_t* blocks, size_t count) {
+            const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+            // The instructions want the state as ABEF / CDGH
+            __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+            __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+            __m128i abef = _mm_alignr_epi8(dcba, efgh, 8);
+            __m128i cdgh = _mm_blend_epi16(efgh, dcba, 0xF0);
+
+            for (; count > 0; --count, blocks += 64) {
+                __m128i abefSaved = abef;
+                __m128i cdghSaved = cdgh;
+                __m128i w[4];
+                for (int i = 0; i < 4; ++i) {
+                    w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks) + i), byteSwap);
+                }
+                ShaNiRounds(abef, cdgh, w, std::make_integer_sequence<int, 16>());
+                abef = _mm_add_epi32(abef, abefSaved);
+                cdgh = _mm_add_epi32(cdgh, cdghSaved);
+            }
+
+            __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+            __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+        }
+
+        const bool g_hasShaNi = Cpu().sha;
+#endif
+
+        void Compress(uint32_t* state, const uint8_t* blocks, size_t count) {
+#ifdef LUMOS_X64
+            if (g_hasShaNi) {
+                CompressShaNi(state, blocks, count);
+                return;
+            }
+#endif
+            CompressPortable(state, blocks, count);
+        }
+    }
+
+    Sha256::Sha256()
+        : m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 }
+        , m_buffer{}
+        , m_buffered(0)
+        , m_totalLength(0)
+    {
+    }
+
+    void Sha256::Update(const uint8_t* data, size_t length) {
+        m_totalLength += length;
+        if (m_buffered > 0) {
+            size_t fill = BLOCK_SIZE - m_buffered;
+            if (length < fill) {
+                std::memcpy(m_buffer + m_buffered, data, length);
+                m_buffered += length;
+                return;
+            }
+            std::memcpy(m_buffer + m_buffered, data, fill);
+            Compress(m_state, m_buffer, 1);
+            data += fill;
+            length -= fill;
+            m_buffered = 0;
+        }
+
+        size_t blocks = length / BLOCK_SIZE;
+        if (blocks > 0) {
+            Compress(m_state, data, blocks);
+            data += blocks * BLOCK_SIZE;
+            length -= blocks * BLOCK_SIZE;
+        }
+        std::memcpy(m_buffer, data, length);
+        m_buffered = length;
+    }
+
+    void Sha256::Finish(uint8_t (&digest)[DIGEST_SIZE]) const {
+        uint32_t state[8];
+        std::memcpy(state, m_state, sizeof(state));
+
+        // 0x80, zeros, then the length in bits, big-endian, ending a block
+        uint8_t tail[2 * BLOCK_SIZE] = {};
+        std::memcpy(tail, m_buffer, m_buffered);
+        tail[m_buffered] = 0x80;
+        size_t tailSize = m_buffered + 1 + 8 <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+        uint64_t bits = m_totalLength * 8;
+        for (int i = 0; i < 8; ++i) {
+            tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        Compress(state, tail, tailSize / BLOCK_SIZE);
+
+        for (int i = 0; i < 8; ++i) {
+            digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+            digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+}
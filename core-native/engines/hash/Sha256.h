@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Lumos {
+    // Streaming SHA-256 (FIPS 180-4). Uses the SHA extensions when present.
+    class Sha256 {
+    public:
+        static constexpr size_t DIGEST_SIZE = 32;
+
+        Sha256();
+
+        void Update(const uint8_t* data, size_t length);
+
+        // Does not disturb the state; more data may follow
+        void Finish(uint8_t (&digest)[DIGEST_SIZE]) const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64;
+
+        uint32_t m_state[8];
+        uint8_t m_buffer[BLOCK_SIZE];
+        size_t m_buffered;
+        uint64_t m_totalLength;
+    };
+}
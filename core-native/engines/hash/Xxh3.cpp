@@ -0,0 +1,330 @@
+#include "Xxh3.h"
+#include <cstring>
+#include "../../common/CpuFeatures.h"
+
+namespace Lumos {
+    namespace {
+        constexpr uint64_t PRIME32_1 = 0x9E3779B1u;
+        constexpr uint64_t PRIME32_2 = 0x85EBCA77u;
+        constexpr uint64_t PRIME32_3 = 0xC2B2AE3Du;
+        constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+        constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+        constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+        constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ull;
+        constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ull;
+
+        constexpr size_t STRIPE = 64;
+        constexpr size_t SECRET_SIZE = 192;
+        constexpr size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE) / 8;  // 16
+        constexpr size_t BLOCK = STRIPE * STRIPES_PER_BLOCK;
+        constexpr size_t SCRAMBLE_OFFSET = SECRET_SIZE - STRIPE;
+        constexpr size_t LAST_STRIPE_OFFSET = SECRET_SIZE - STRIPE - 7;
+        constexpr size_t MERGE_OFFSET = 11;
+        constexpr size_t MIDSIZE_MAX = 240;
+
+        alignas(64) constexpr uint8_t SECRET[SECRET_SIZE] = {
+            0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+            0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+            0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+            0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+            0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+            0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+            0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+            0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+            0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+            0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+            0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+            0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+        };
+
+        inline uint32_t Read32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t Read64(const uint8_t* p) {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t Rotl64(uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        inline uint32_t Swap32(uint32_t x) {
+            return ((x << 24) & 0xff000000u) | ((x << 8) & 0x00ff0000u) |
+                   ((x >> 8) & 0x0000ff00u) | ((x >> 24) & 0x000000ffu);
+        }
+
+        inline uint64_t Swap64(uint64_t x) {
+            return (static_cast<uint64_t>(Swap32(static_cast<uint32_t>(x))) << 32) |
+                   Swap32(static_cast<uint32_t>(x >> 32));
+        }
+
+        // Low and high halves of the 128-bit product, xor'ed
+        inline uint64_t MulFold64(uint64_t a, uint64_t b) {
+#ifdef _MSC_VER
+            uint64_t high;
+            uint64_t low = _umul128(a, b, &high);
+            return low ^ high;
+#else
+            __uint128_t product = static_cast<__uint128_t>(a) * b;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#endif
+        }
+
+        inline uint64_t Avalanche(uint64_t h) {
+            h ^= h >> 37;
+            h *= PRIME_MX1;
+            return h ^ (h >> 32);
+        }
+
+        inline uint64_t Xxh64Avalanche(uint64_t h) {
+            h ^= h >> 33;
+            h *= PRIME64_2;
+            h ^= h >> 29;
+            h *= PRIME64_3;
+            return h ^ (h >> 32);
+        }
+
+        inline uint64_t Rrmxmx(uint64_t h, uint64_t length) {
+            h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+            h *= PRIME_MX2;
+            h ^= (h >> 35) + length;
+            h *= PRIME_MX2;
+            return h ^ (h >> 28);
+        }
+
+        inline uint64_t Mix16(const uint8_t* input, const uint8_t* secret) {
+            return MulFold64(Read64(input) ^ Read64(secret), Read64(input + 8) ^ Read64(secret + 8));
+        }
+
+        // Inputs of at most MIDSIZE_MAX bytes are hashed in one go, without accumulators
+        uint64_t HashShort(const uint8_t* input, size_t length) {
+            if (length == 0) {
+                return Xxh64Avalanche(Read64(SECRET + 56) ^ Read64(SECRET + 64));
+            }
+            if (length <= 3) {
+                uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) |
+                                    (static_cast<uint32_t>(input[length >> 1]) << 24) |
+                                    static_cast<uint32_t>(input[length - 1]) |
+                                    (static_cast<uint32_t>(length) << 8);
+                uint64_t flip = Read32(SECRET) ^ Read32(SECRET + 4);
+                return Xxh64Avalanche(combined ^ flip);
+            }
+            if (length <= 8) {
+                uint64_t flip = Read64(SECRET + 8) ^ Read64(SECRET + 16);
+                uint64_t value = Read32(input + length - 4) + (static_cast<uint64_t>(Read32(input)) << 32);
+                return Rrmxmx(value ^ flip, length);
+            }
+            if (length <= 16) {
+                uint64_t low = Read64(input) ^ (Read64(SECRET + 24) ^ Read64(SECRET + 32));
+                uint64_t high = Read64(input + length - 8) ^ (Read64(SECRET + 40) ^ Read64(SECRET + 48));
+                return Avalanche(length + Swap64(low) + high + MulFold64(low, high));
+            }
+
+            uint64_t acc = length * PRIME64_1;
+            if (length <= 128) {
+                if (length > 32) {
+                    if (length > 64) {
+                        if (length > 96) {
+                            acc += Mix16(input + 48, SECRET + 96);
+                            acc += Mix16(input + length - 64, SECRET + 112);
+                        }
+                        acc += Mix16(input + 32, SECRET + 64);
+                        acc += Mix16(input + length - 48, SECRET + 80);
+                    }
+                    acc += Mix16(input + 16, SECRET + 32);
+                    acc += Mix16(input + length - 32, SECRET + 48);
+                }
+                acc += Mix16(input, SECRET);
+                acc += Mix16(input + length - 16, SECRET + 16);
+                return Avalanche(acc);
+            }
+
+            size_t rounds = length / 16;
+            for (size_t i = 0; i < 8; ++i) {
+                acc += Mix16(input + 16 * i, SECRET + 16 * i);
+            }
+            acc = Avalanche(acc);
+            for (size_t i = 8; i < rounds; ++i) {
+                acc += Mix16(input + 16 * i, SECRET + 16 * (i - 8) + 3);
+            }
+            acc += Mix16(input + length - 16, SECRET + 136 - 17);
+            return Avalanche(acc);
+        }
+
+#ifdef LUMOS_X64
+        void AccumulateSse2(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+            __m128i a[4];
+            for (int i = 0; i < 4; ++i) {
+                a[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(acc) + i);
+            }
+            for (size_t s = 0; s < stripes; ++s, input += STRIPE, secret += 8) {
+                for (int i = 0; i < 4; ++i) {
+                    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+                    __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+                    __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+                    __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+                    a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+                }
+            }
+            for (int i = 0; i < 4; ++i) {
+                _mm_store_si128(reinterpret_cast<__m128i*>(acc) + i, a[i]);
+            }
+        }
+
+        LUMOS_TARGET("avx2") void AccumulateAvx2(uint64_t* acc, const uint8_t* input, const uint8_t* secret,
+                                                 size_t stripes) {
+            __m256i a0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc));
+            __m256i a1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc) + 1);
+            for (size_t s = 0; s < stripes; ++s, input += STRIPE, secret += 8) {
+                __m256i value0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+                __m256i value1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + 1);
+                __m256i keyed0 = _mm256_xor_si256(value0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret)));
+                __m256i keyed1 = _mm256_xor_si256(value1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + 1));
+                __m256i product0 = _mm256_mul_epu32(keyed0, _mm256_shuffle_epi32(keyed0, _MM_SHUFFLE(0, 3, 0, 1)));
+                __m256i product1 = _mm256_mul_epu32(keyed1, _mm256_shuffle_epi32(keyed1, _MM_SHUFFLE(0, 3, 0, 1)));
+                a0 = _mm256_add_epi64(a0, _mm256_add_epi64(product0, _mm256_shuffle_epi32(value0, _MM_SHUFFLE(1, 0, 3, 2))));
+                a1 = _mm256_add_epi64(a1, _mm256_add_epi64(product1, _mm256_shuffle_epi32(value1, _MM_SHUFFLE(1, 0, 3, 2))));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(acc), a0);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(acc) + 1, a1);
+        }
+
+        const bool g_hasAvx2 = Cpu().avx2;
+#else
+        void AccumulateScalar(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+            for (size_t s = 0; s < stripes; ++s, input += STRIPE, secret += 8) {
+                for (size_t i = 0; i < 8; ++i) {
+                    uint64_t value = Read64(input + 8 * i);
+                    uint64_t keyed = value ^ Read64(secret + 8 * i);
+                    acc[i ^ 1] += value;
+                    acc[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+                }
+            }
+        }
+#endif
+
+        // `stripes` consecutive stripes, each keyed with the secret shifted by 8 more bytes
+        inline void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+#ifdef LUMOS_X64
+            if (g_hasAvx2) {
+                AccumulateAvx2(acc, input, secret, stripes);
+            } else {
+                AccumulateSse2(acc, input, secret, stripes);
+            }
+#else
+            AccumulateScalar(acc, input, secret, stripes);
+#endif
+        }
+
+        // Once per BLOCK; cheap enough that it stays scalar
+        inline void Scramble(uint64_t* acc) {
+            const uint8_t* secret = SECRET + SCRAMBLE_OFFSET;
+            for (size_t i = 0; i < 8; ++i) {
+                uint64_t a = acc[i];
+                a ^= a >> 47;
+                a ^= Read64(secret + 8 * i);
+                acc[i] = a * PRIME32_1;
+            }
+        }
+
+        // Accumulate `stripes` stripes continuing a block that already has
+        // `stripesInBlock`, scrambling at the block boundary
+        void ConsumeStripes(uint64_t* acc, size_t& stripesInBlock, const uint8_t* input, size_t stripes) {
+            while (stripes > 0) {
+                size_t toBlockEnd = STRIPES_PER_BLOCK - stripesInBlock;
+                size_t count = stripes < toBlockEnd ? stripes : toBlockEnd;
+                Accumulate(acc, input, SECRET + stripesInBlock * 8, count);
+                input += count * STRIPE;
+                stripes -= count;
+                stripesInBlock += count;
+                if (stripesInBlock == STRIPES_PER_BLOCK) {
+                    Scramble(acc);
+                    stripesInBlock = 0;
+                }
+            }
+        }
+
+        uint64_t Merge(const uint64_t* acc, uint64_t start) {
+            uint64_t result = start;
+            for (size_t i = 0; i < 4; ++i) {
+                result += MulFold64(acc[2 * i] ^ Read64(SECRET + MERGE_OFFSET + 16 * i),
+                                    acc[2 * i + 1] ^ Read64(SECRET + MERGE_OFFSET + 16 * i + 8));
+            }
+            return Avalanche(result);
+        }
+    }
+
+    Xxh3::Xxh3()
+        : m_acc{ PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1 }
+        , m_buffer{}
+        , m_buffered(0)
+        , m_stripesInBlock(0)
+        , m_totalLength(0)
+    {
+    }
+
+    void Xxh3::Update(const uint8_t* data, size_t length) {
+        m_totalLength += length;
+        if (length <= BUFFER_SIZE - m_buffered) {
+            std::memcpy(m_buffer + m_buffered, data, length);
+            m_buffered += length;
+            return;
+        }
+
+        // Input only leaves the buffer once more follows it: the final stripe
+        // is hashed differently, and short inputs take another path entirely
+        const uint8_t* end = data + length;
+        if (m_buffered > 0) {
+            size_t fill = BUFFER_SIZE - m_buffered;
+            std::memcpy(m_buffer + m_buffered, data, fill);
+            data += fill;
+            ConsumeStripes(m_acc, m_stripesInBlock, m_buffer, BUFFER_SIZE / STRIPE);
+            m_buffered = 0;
+        }
+
+        if (static_cast<size_t>(end - data) > BUFFER_SIZE) {
+            // Whole stripes straight from the caller's memory, keeping at least one byte back
+            size_t stripes = (static_cast<size_t>(end - data) - 1) / STRIPE;
+            ConsumeStripes(m_acc, m_stripesInBlock, data, stripes);
+            data += stripes * STRIPE;
+            // Finish() may need the last consumed stripe to complete a short tail
+            std::memcpy(m_buffer + BUFFER_SIZE - STRIPE, data - STRIPE, STRIPE);
+        }
+
+        m_buffered = static_cast<size_t>(end - data);
+        std::memcpy(m_buffer, data, m_buffered);
+    }
+
+    uint64_t Xxh3::Finish() const {
+        if (m_totalLength <= MIDSIZE_MAX) {
+            return HashShort(m_buffer, static_cast<size_t>(m_totalLength));
+        }
+
+        alignas(32) uint64_t acc[8];
+        std::memcpy(acc, m_acc, sizeof(acc));
+        size_t stripesInBlock = m_stripesInBlock;
+
+        uint8_t lastStripe[STRIPE];
+        const uint8_t* last;
+        if (m_buffered >= STRIPE) {
+            size_t stripes = (m_buffered - 1) / STRIPE;
+            ConsumeStripes(acc, stripesInBlock, m_buffer, stripes);
+            last = m_buffer + m_buffered - STRIPE;
+        } else {
+            // The tail is shorter than a stripe: complete it with the end of the previous one
+            size_t catchUp = STRIPE - m_buffered;
+            std::memcpy(lastStripe, m_buffer + BUFFER_SIZE - catchUp, catchUp);
+            std::memcpy(lastStripe + catchUp, m_buffer, m_buffered);
+            last = lastStripe;
+        }
+        Accumulate(acc, last, SECRET + LAST_STRIPE_OFFSET, 1);
+        return Merge(acc, m_totalLength * PRIME64_1);
+    }
+}
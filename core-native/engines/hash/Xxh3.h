@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Lumos {
+    // Streaming XXH3-64 with the default secret and seed 0; the digest equals
+    // XXH3_64bits() from the reference xxHash library for the same bytes.
+    // Not a cryptographic hash: it tells copies apart, it does not vouch for them.
+    class Xxh3 {
+    public:
+        Xxh3();
+
+        void Update(const uint8_t* data, size_t length);
+
+        // Does not disturb the state; more data may follow
+        uint64_t Finish() const;
+
+    private:
+        static constexpr size_t STRIPE_SIZE = 64;
+        static constexpr size_t BUFFER_SIZE = 256;  // 4 stripes; the last input stays buffered
+
+        alignas(32) uint64_t m_acc[8];
+        alignas(32) uint8_t m_buffer[BUFFER_SIZE];
+        size_t m_buffered;
+        size_t m_stripesInBlock;  // Stripes accumulated since the last scramble
+        uint64_t m_totalLength;
+    };
+}
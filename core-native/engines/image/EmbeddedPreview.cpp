@@ -0,0 +1,270 @@
+#include "EmbeddedPreview.h"
+#include <vector>
+#include "ImageHeaderProbe.h"
+#include "TiffReader.h"
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        const uint8_t EXIF_PREFIX[] = { 'E', 'x', 'i', 'f', 0, 0 };
+        const uint8_t MPF_PREFIX[] = { 'M', 'P', 'F', 0 };
+
+        constexpr uint16_t MPF_ENTRY_TAG = 0xB002;
+        constexpr size_t MPF_ENTRY_SIZE = 16;
+        constexpr uint16_t RW2_JPEG_FROM_RAW_TAG = 0x002E; // Panasonic: whole JPEG stored as the tag value
+
+        constexpr uint32_t COMPRESSION_OLD_JPEG = 6;
+        constexpr uint32_t COMPRESSION_JPEG = 7;
+        constexpr uint32_t COMPRESSION_LOSSY_DNG = 34892;
+
+        // Cycle and fan-out guards; real files have a handful of IFDs
+        constexpr size_t MAX_IFDS = 64;
+        constexpr uint32_t MAX_SUB_IFDS = 16;
+        constexpr size_t MAX_MPF_ENTRIES = 16;
+
+        uint32_t LongEdge(const EmbeddedPreview& preview) {
+            return preview.width > preview.height ? preview.width : preview.height;
+        }
+
+        // Keep [offset, offset + length) only if it is a complete JPEG the UI
+        // can decode on its own. 12/14-bit and lossless streams are sensor
+        // data (CR2 and DNG raw planes), not previews.
+        void AddCandidate(ByteView file, uint64_t offset, uint64_t length, EmbeddedPreviewSource source,
+                          std::vector<EmbeddedPreview>& candidates) {
+            if (length < 4 || !file.Has(static_cast<size_t>(offset), static_cast<size_t>(length))) {
+                return;
+            }
+            ByteView jpeg = file.Sub(static_cast<size_t>(offset), static_cast<size_t>(length));
+            if (jpeg.U8(0) != 0xFF || jpeg.U8(1) != 0xD8) {
+                return;
+            }
+
+            ImageHeader header;
+            if (ImageHeaderProbe::Probe(jpeg, header) != ProbeStatus::Ok || header.format != ImageFormat::Jpeg) {
+                return;
+            }
+            if (header.bitDepth != 8 && header.bitDepth != 24) {
+                return;
+            }
+
+            EmbeddedPreview preview;
+            preview.source = source;
+            preview.offset = offset;
+            preview.length = length;
+            preview.width = header.width;
+            preview.height = header.height;
+            candidates.push_back(preview);
+        }
+
+        uint16_t ReadOrientation(const TiffReader& tiff, uint32_t ifd) {
+            uint16_t orientation = 1;
+            tiff.VisitIfd(ifd, [&](const TiffEntry& entry) {
+                if (entry.tag == TiffTag::Orientation) {
+                    uint32_t value = tiff.Value(entry);
+                    orientation = (value >= 1 && value <= 8) ? static_cast<uint16_t>(value) : 1;
+                }
+            });
+            return orientation;
+        }
+
+        // IFD0 chain plus SubIFDs of a TIFF-based file. `base` is where the
+        // TIFF header sits in `file`; IFD offsets are relative to it.
+        uint16_t CollectTiffCandidates(ByteView file, size_t base, std::vector<EmbeddedPreview>& candidates) {
+            TiffReader tiff(file.Sub(base));
+            if (!tiff.IsValid()) {
+                return 1;
+            }
+
+            std::vector<uint32_t> pending{ tiff.FirstIfdOffset() };
+            std::vector<uint32_t> visited;
+            while (!pending.empty() && visited.size() < MAX_IFDS) {
+                uint32_t ifd = pending.back();
+                pending.pop_back();
+                bool seen = false;
+                for (uint32_t v : visited) seen = seen || v == ifd;
+                if (seen) {
+                    continue;
+                }
+                visited.push_back(ifd);
+
+                uint32_t compression = 0;
+                uint32_t stripOffset = 0;
+                uint32_t stripLength = 0;
+                uint32_t stripCount = 0;
+                uint32_t jpegOffset = 0;
+                uint32_t jpegLength = 0;
+                bool hasJpegTables = false;
+                uint32_t nextIfd = 0;
+
+                tiff.VisitIfd(ifd, [&](const TiffEntry& entry) {
+                    switch (entry.tag) {
+                    case TiffTag::Compression:
+                        compression = tiff.Value(entry);
+                        break;
+                    case TiffTag::StripOffsets:
+                        stripOffset = tiff.Value(entry);
+                        stripCount = entry.count;
+                        break;
+                    case TiffTag::StripByteCounts:
+                        stripLength = tiff.Value(entry);
+                        break;
+                    case TiffTag::JpegInterchangeFormat:
+                        jpegOffset = tiff.Value(entry);
+                        break;
+                    case TiffTag::JpegInterchangeFormatLength:
+                        jpegLength = tiff.Value(entry);
+                        break;
+                    case TiffTag::JpegTables:
+                        hasJpegTables = true; // Abbreviated streams cannot be decoded on their own
+                        break;
+                    case TiffTag::SubIFDs:
+                        for (uint32_t i = 0; i < entry.count && i < MAX_SUB_IFDS; ++i) {
+                            pending.push_back(tiff.Value(entry, i));
+                        }
+                        break;
+                    case RW2_JPEG_FROM_RAW_TAG:
+                        if (entry.count > 4) {
+                            AddCandidate(file, base + entry.valueOffset, entry.count,
+                                         EmbeddedPreviewSource::TiffIfd, candidates);
+                        }
+                        break;
+                    }
+                }, &nextIfd);
+
+                if (jpegOffset != 0 && jpegLength != 0) {
+                    AddCandidate(file, base + static_cast<uint64_t>(jpegOffset), jpegLength,
+                                 EmbeddedPreviewSource::TiffIfd, candidates);
+                }
+                bool jpegCompressed = compression == COMPRESSION_OLD_JPEG || compression == COMPRESSION_JPEG ||
+                                      compression == COMPRESSION_LOSSY_DNG;
+                if (jpegCompressed && stripCount == 1 && stripLength != 0 && !hasJpegTables &&
+                    stripOffset != jpegOffset) {
+                    AddCandidate(file, base + static_cast<uint64_t>(stripOffset), stripLength,
+                                 EmbeddedPreviewSource::TiffIfd, candidates);
+                }
+
+                if (nextIfd != 0) {
+                    pending.push_back(nextIfd);
+                }
+            }
+
+            return ReadOrientation(tiff, tiff.FirstIfdOffset());
+        }
+
+        // EXIF thumbnail (APP1, IFD1) and MPF secondary images (APP2) of a JPEG
+        uint16_t CollectJpegCandidates(ByteView file, std::vector<EmbeddedPreview>& candidates) {
+            uint16_t orientation = 1;
+            size_t position = 2;
+            while (file.Has(position, 4) && file.U8(position) == 0xFF) {
+                uint8_t marker = file.U8(position + 1);
+                if (marker == 0xFF) {
+                    ++position; // Fill byte
+                    continue;
+                }
+                bool isFrameHeader = marker >= 0xC0 && marker <= 0xCF &&
+                                     marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+                if (isFrameHeader || marker == 0xDA || marker == 0xD9) {
+                    break; // Metadata segments all precede the frame
+                }
+
+                uint16_t length = file.U16BE(position + 2);
+                if (length < 2) {
+                    break;
+                }
+                size_t segment = position + 4;
+                size_t segmentLength = length - 2u;
+
+                if (marker == 0xE1 && segmentLength > sizeof(EXIF_PREFIX) &&
+                    file.Matches(segment, EXIF_PREFIX, sizeof(EXIF_PREFIX))) {
+                    // Thumbnail offsets are relative to the embedded TIFF header
+                    size_t base = segment + sizeof(EXIF_PREFIX);
+                    TiffReader tiff(file.Sub(base, segmentLength - sizeof(EXIF_PREFIX)));
+                    uint32_t ifd1 = 0;
+                    tiff.VisitIfd(tiff.FirstIfdOffset(), [&](const TiffEntry& entry) {
+                        if (entry.tag == TiffTag::Orientation) {
+                            uint32_t value = tiff.Value(entry);
+                            orientation = (value >= 1 && value <= 8) ? static_cast<uint16_t>(value) : 1;
+                        }
+                    }, &ifd1);
+
+                    uint32_t thumbnailOffset = 0;
+                    uint32_t thumbnailLength = 0;
+                    tiff.VisitIfd(ifd1, [&](const TiffEntry& entry) {
+                        if (entry.tag == TiffTag::JpegInterchangeFormat) thumbnailOffset = tiff.Value(entry);
+                        if (entry.tag == TiffTag::JpegInterchangeFormatLength) thumbnailLength = tiff.Value(entry);
+                    });
+                    if (thumbnailOffset != 0 && thumbnailLength != 0) {
+                        AddCandidate(file, base + static_cast<uint64_t>(thumbnailOffset), thumbnailLength,
+                                     EmbeddedPreviewSource::ExifThumbnail, candidates);
+                    }
+                } else if (marker == 0xE2 && segmentLength > sizeof(MPF_PREFIX) &&
+                           file.Matches(segment, MPF_PREFIX, sizeof(MPF_PREFIX))) {
+                    // Multi-Picture Format index: image offsets are relative to
+                    // the MPF TIFF header; the first entry is this image
+                    size_t base = segment + sizeof(MPF_PREFIX);
+                    TiffReader tiff(file.Sub(base, segmentLength - sizeof(MPF_PREFIX)));
+                    ByteView mpf = tiff.Data();
+                    tiff.VisitIfd(tiff.FirstIfdOffset(), [&](const TiffEntry& entry) {
+                        if (entry.tag != MPF_ENTRY_TAG) {
+                            return;
+                        }
+                        size_t count = entry.count / MPF_ENTRY_SIZE;
+                        for (size_t i = 1; i < count && i < MAX_MPF_ENTRIES; ++i) {
+                            size_t record = entry.valueOffset + i * MPF_ENTRY_SIZE;
+                            uint32_t size = mpf.U32(record + 4, tiff.IsBigEndian());
+                            uint32_t offset = mpf.U32(record + 8, tiff.IsBigEndian());
+                            if (offset != 0 && size != 0) {
+                                AddCandidate(file, base + static_cast<uint64_t>(offset), size,
+                                             EmbeddedPreviewSource::MultiPicture, candidates);
+                            }
+                        }
+                    });
+                }
+
+                position = segment + segmentLength;
+            }
+            return orientation;
+        }
+    }
+
+    std::optional<EmbeddedPreview> EmbeddedPreviewFinder::Find(ByteView file, uint32_t targetEdge, uint32_t minimumEdge) {
+        std::vector<EmbeddedPreview> candidates;
+        uint16_t orientation = 1;
+
+        if (file.U8(0) == 0xFF && file.U8(1) == 0xD8) {
+            orientation = CollectJpegCandidates(file, candidates);
+        } else {
+            orientation = CollectTiffCandidates(file, 0, candidates);
+        }
+
+        const EmbeddedPreview* covering = nullptr;
+        const EmbeddedPreview* largest = nullptr;
+        for (const auto& candidate : candidates) {
+            uint32_t edge = LongEdge(candidate);
+            if (edge < minimumEdge) {
+                continue;
+            }
+            if (edge >= targetEdge) {
+                if (!covering || edge < LongEdge(*covering)) covering = &candidate;
+            } else if (!largest || edge > LongEdge(*largest)) {
+                largest = &candidate;
+            }
+        }
+
+        const EmbeddedPreview* best = covering ? covering : largest;
+        if (!best) {
+            return std::nullopt;
+        }
+        EmbeddedPreview result = *best;
+        result.orientation = orientation;
+        return result;
+    }
+
+    bool EmbeddedPreviewFinder::IsRawExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, { L".cr2", L".nef", L".arw", L".dng", L".orf", L".rw2" });
+    }
+
+    bool EmbeddedPreviewFinder::HandlesExtension(std::wstring_view extension) {
+        return IsRawExtension(extension) || ExtensionIn(extension, { L".jpg", L".jpeg", L".tif", L".tiff" });
+    }
+}
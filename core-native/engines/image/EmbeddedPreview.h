@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    enum class EmbeddedPreviewSource {
+        ExifThumbnail,   // JPEG APP1, IFD1 (typically 160x120)
+        MultiPicture,    // JPEG APP2 MPF large preview (camera JPEGs)
+        TiffIfd          // JPEG stream referenced from a TIFF/RAW IFD or SubIFD
+    };
+
+    // A self-contained baseline JPEG stored inside another file
+    struct EmbeddedPreview {
+        EmbeddedPreviewSource source = EmbeddedPreviewSource::TiffIfd;
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint16_t orientation = 1; // Of the containing image; embedded JPEGs rarely carry their own
+    };
+
+    // Finds preview-sized JPEGs that cameras and raw converters embed next to
+    // the main image, so the UI can decode a few hundred KB instead of a
+    // 24-50 MP frame (or a RAW format it cannot decode at all). Walks JPEG
+    // APP1/APP2 segments and TIFF IFD chains and SubIFDs, which covers TIFF,
+    // DNG, CR2, NEF, ARW, ORF and RW2. Every candidate is checked to be a
+    // complete, 8-bit baseline/progressive JPEG inside the file.
+    class EmbeddedPreviewFinder {
+    public:
+        // Pick the smallest preview whose long edge is at least `targetEdge`,
+        // otherwise the largest one; nothing below `minimumEdge`
+        static std::optional<EmbeddedPreview> Find(ByteView file, uint32_t targetEdge, uint32_t minimumEdge);
+
+        // Camera RAW containers: the embedded preview is the only thing we can show
+        static bool IsRawExtension(std::wstring_view extension);
+
+        // Extensions worth searching (RAW plus JPEG and TIFF)
+        static bool HandlesExtension(std::wstring_view extension);
+    };
+}
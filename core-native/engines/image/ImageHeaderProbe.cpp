@@ -0,0 +1,489 @@
+#include "ImageHeaderProbe.h"
+#include "TiffReader.h"
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        const uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        const uint8_t EXIF_PREFIX[] = { 'E', 'x', 'i', 'f', 0, 0 };
+        const char ICC_PROFILE_PREFIX[] = "ICC_PROFILE"; // Followed by a NUL
+        const char GIF_ICC_APPLICATION[] = "ICCRGBG1012";
+
+        // Upper bound on IFD chains we follow while counting TIFF pages
+        constexpr uint32_t MAX_TIFF_PAGES = 4096;
+
+        constexpr uint32_t FourCC(char a, char b, char c, char d) {
+            return static_cast<uint32_t>(static_cast<uint8_t>(a)) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+        }
+
+        uint16_t NormalizeOrientation(uint32_t value) {
+            return (value >= 1 && value <= 8) ? static_cast<uint16_t>(value) : 1;
+        }
+
+        // Skip GIF data sub-blocks starting at `position`; false if they run
+        // past the end of the data
+        bool SkipGifSubBlocks(ByteView data, size_t& position) {
+            while (data.Has(position, 1)) {
+                uint8_t length = data.U8(position);
+                position += 1 + static_cast<size_t>(length);
+                if (length == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Width/height/bit depth from a PNG IHDR at the start of `data`
+        bool ReadPngHeader(ByteView data, ImageHeader& out) {
+            if (!data.Matches(0, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) ||
+                data.U32BE(8) != 13 || !data.Matches(12, "IHDR", 4) || !data.Has(16, 13)) {
+                return false;
+            }
+
+            out.width = data.U32BE(16);
+            out.height = data.U32BE(20);
+            uint8_t bitDepth = data.U8(24);
+            uint8_t colorType = data.U8(25);
+
+            uint16_t channels = 1;
+            switch (colorType) {
+            case 0: channels = 1; break; // Grayscale
+            case 2: channels = 3; break; // RGB
+            case 3: channels = 1; break; // Palette index
+            case 4: channels = 2; break; // Grayscale + alpha
+            case 6: channels = 4; break; // RGBA
+            default: return false;
+            }
+            out.bitDepth = static_cast<uint16_t>(bitDepth * channels);
+            return true;
+        }
+    }
+
+    ProbeStatus ImageHeaderProbe::Probe(ByteView data, ImageHeader& out) {
+        out = ImageHeader();
+        if (data.Size() < 4) {
+            return ProbeStatus::NeedMoreData;
+        }
+
+        ProbeStatus status = ProbeStatus::Unrecognized;
+        if (data.U8(0) == 0xFF && data.U8(1) == 0xD8) {
+            status = ProbeJpeg(data, out);
+        } else if (data.Matches(0, PNG_SIGNATURE, 4)) {
+            status = ProbePng(data, out);
+        } else if (data.Matches(0, "GIF8", 4)) {
+            status = ProbeGif(data, out);
+        } else if (data.Matches(0, "RIFF", 4)) {
+            status = ProbeWebP(data, out);
+        } else if (data.Matches(0, "BM", 2)) {
+            status = ProbeBmp(data, out);
+        } else if (data.Matches(0, "II*\0", 4) || data.Matches(0, "MM\0*", 4)) {
+            status = ProbeTiff(data, out);
+        } else if (data.U16LE(0) == 0 && (data.U16LE(2) == 1 || data.U16LE(2) == 2)) {
+            status = ProbeIco(data, out);
+        }
+
+        if (status == ProbeStatus::Ok && (out.width == 0 || out.height == 0)) {
+            return ProbeStatus::Malformed;
+        }
+        return status;
+    }
+
+    bool ImageHeaderProbe::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, {
+            L".jpg", L".jpeg", L".png", L".gif", L".bmp", L".webp", L".tiff", L".ico"
+        });
+    }
+
+    const char* ImageHeaderProbe::FormatName(ImageFormat format) {
+        switch (format) {
+        case ImageFormat::Jpeg: return "jpeg";
+        case ImageFormat::Png: return "png";
+        case ImageFormat::Gif: return "gif";
+        case ImageFormat::WebP: return "webp";
+        case ImageFormat::Bmp: return "bmp";
+        case ImageFormat::Tiff: return "tiff";
+        case ImageFormat::Ico: return "ico";
+        default: return "unknown";
+        }
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeJpeg(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Jpeg;
+
+        // Walk marker segments up to the first SOFn; EXIF and ICC live in the
+        // APPn segments before it
+        size_t position = 2;
+        while (true) {
+            if (!data.Has(position, 2)) {
+                return ProbeStatus::NeedMoreData;
+            }
+            if (data.U8(position) != 0xFF) {
+                return ProbeStatus::Malformed;
+            }
+
+            uint8_t marker = data.U8(position + 1);
+            if (marker == 0xFF) {
+                ++position; // Fill byte
+                continue;
+            }
+            position += 2;
+
+            // Standalone markers carry no length
+            if (marker == 0x01 || marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7)) {
+                continue;
+            }
+            if (marker == 0xD9 || marker == 0xDA) {
+                return ProbeStatus::Malformed; // Scan data or EOI before any frame header
+            }
+
+            if (!data.Has(position, 2)) {
+                return ProbeStatus::NeedMoreData;
+            }
+            uint16_t length = data.U16BE(position);
+            if (length < 2) {
+                return ProbeStatus::Malformed;
+            }
+            size_t segment = position + 2;
+            size_t segmentLength = length - 2u;
+
+            bool isFrameHeader = marker >= 0xC0 && marker <= 0xCF &&
+                                 marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+            if (isFrameHeader) {
+                if (!data.Has(segment, 6)) {
+                    return ProbeStatus::NeedMoreData;
+                }
+                uint8_t precision = data.U8(segment);
+                out.height = data.U16BE(segment + 1);
+                out.width = data.U16BE(segment + 3);
+                uint8_t components = data.U8(segment + 5);
+                out.bitDepth = static_cast<uint16_t>(precision * components);
+                return ProbeStatus::Ok;
+            }
+
+            if (marker == 0xE1 && segmentLength >= sizeof(EXIF_PREFIX) &&
+                data.Matches(segment, EXIF_PREFIX, sizeof(EXIF_PREFIX))) {
+                out.orientation = ReadExifOrientation(
+                    data.Sub(segment + sizeof(EXIF_PREFIX), segmentLength - sizeof(EXIF_PREFIX)));
+            } else if (marker == 0xE2 && data.Matches(segment, ICC_PROFILE_PREFIX, sizeof(ICC_PROFILE_PREFIX))) {
+                out.hasColorProfile = true;
+            }
+
+            position = segment + segmentLength;
+        }
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbePng(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Png;
+        if (!data.Has(0, 33)) {
+            return ProbeStatus::NeedMoreData;
+        }
+        if (!ReadPngHeader(data, out)) {
+            return ProbeStatus::Malformed;
+        }
+
+        // Ancillary chunks that matter for layout all precede the image data
+        size_t position = 33;
+        while (data.Has(position, 8)) {
+            uint32_t length = data.U32BE(position);
+            size_t chunk = position + 8;
+
+            if (data.Matches(position + 4, "IDAT", 4)) {
+                break;
+            }
+            if (data.Matches(position + 4, "iCCP", 4)) {
+                out.hasColorProfile = true;
+            } else if (data.Matches(position + 4, "acTL", 4) && data.Has(chunk, 4)) {
+                uint32_t frames = data.U32BE(chunk);
+                out.frameCount = frames > 0 ? frames : 1;
+            } else if (data.Matches(position + 4, "eXIf", 4)) {
+                out.orientation = ReadExifOrientation(data.Sub(chunk, length));
+            }
+
+            position = chunk + static_cast<size_t>(length) + 4; // Data and CRC
+        }
+        return ProbeStatus::Ok;
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeGif(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Gif;
+        if (!data.Has(0, 13)) {
+            return ProbeStatus::NeedMoreData;
+        }
+        if (!data.Matches(0, "GIF87a", 6) && !data.Matches(0, "GIF89a", 6)) {
+            return ProbeStatus::Malformed;
+        }
+
+        out.width = data.U16LE(6);
+        out.height = data.U16LE(8);
+        uint8_t flags = data.U8(10);
+        out.bitDepth = static_cast<uint16_t>((flags & 0x07) + 1);
+
+        size_t position = 13;
+        if (flags & 0x80) {
+            position += 3u * (1u << ((flags & 0x07) + 1)); // Global color table
+        }
+
+        // Count image descriptors in whatever part of the stream we have
+        uint32_t frames = 0;
+        while (data.Has(position, 1)) {
+            uint8_t block = data.U8(position);
+            if (block == 0x3B) {
+                break; // Trailer
+            }
+
+            if (block == 0x2C) {
+                if (!data.Has(position, 10)) {
+                    break;
+                }
+                ++frames;
+                uint8_t imageFlags = data.U8(position + 9);
+                position += 10;
+                if (imageFlags & 0x80) {
+                    position += 3u * (1u << ((imageFlags & 0x07) + 1)); // Local color table
+                }
+                position += 1; // LZW minimum code size
+                if (!SkipGifSubBlocks(data, position)) {
+                    break;
+                }
+            } else if (block == 0x21) {
+                if (!data.Has(position, 2)) {
+                    break;
+                }
+                uint8_t label = data.U8(position + 1);
+                position += 2;
+                // Application extension: 11-byte identifier block, then data
+                if (label == 0xFF && data.U8(position) == 11 &&
+                    data.Matches(position + 1, GIF_ICC_APPLICATION, 11)) {
+                    out.hasColorProfile = true;
+                }
+                if (!SkipGifSubBlocks(data, position)) {
+                    break;
+                }
+            } else {
+                break; // Garbage after the last frame; decoders stop here too
+            }
+        }
+
+        out.frameCount = frames > 0 ? frames : 1;
+        return ProbeStatus::Ok;
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeWebP(ByteView data, ImageHeader& out) {
+        if (!data.Has(0, 12)) {
+            return ProbeStatus::NeedMoreData;
+        }
+        if (!data.Matches(8, "WEBP", 4)) {
+            return ProbeStatus::Unrecognized; // Some other RIFF container (WAV, AVI)
+        }
+        out.format = ImageFormat::WebP;
+
+        bool haveSize = false;
+        uint32_t frames = 0;
+        size_t position = 12;
+        while (data.Has(position, 8)) {
+            uint32_t fourcc = data.U32LE(position);
+            uint32_t length = data.U32LE(position + 4);
+            size_t chunk = position + 8;
+            ByteView payload = data.Sub(chunk, length);
+
+            if (fourcc == FourCC('V', 'P', '8', 'X')) {
+                if (!payload.Has(0, 10)) {
+                    return ProbeStatus::NeedMoreData;
+                }
+                uint8_t flags = payload.U8(0);
+                out.hasColorProfile = (flags & 0x20) != 0;
+                out.bitDepth = (flags & 0x10) ? 32 : 24;
+                out.width = payload.U24LE(4) + 1;
+                out.height = payload.U24LE(7) + 1;
+                haveSize = true;
+            } else if (fourcc == FourCC('V', 'P', '8', ' ') && !haveSize) {
+                // Lossy key frame: 3-byte frame tag, start code, 14-bit dimensions
+                if (!payload.Has(0, 10)) {
+                    return ProbeStatus::NeedMoreData;
+                }
+                if (payload.U8(3) != 0x9D || payload.U8(4) != 0x01 || payload.U8(5) != 0x2A) {
+                    return ProbeStatus::Malformed;
+                }
+                out.width = payload.U16LE(6) & 0x3FFF;
+                out.height = payload.U16LE(8) & 0x3FFF;
+                out.bitDepth = 24;
+                haveSize = true;
+            } else if (fourcc == FourCC('V', 'P', '8', 'L') && !haveSize) {
+                if (!payload.Has(0, 5)) {
+                    return ProbeStatus::NeedMoreData;
+                }
+                if (payload.U8(0) != 0x2F) {
+                    return ProbeStatus::Malformed;
+                }
+                uint32_t bits = payload.U32LE(1);
+                out.width = (bits & 0x3FFF) + 1;
+                out.height = ((bits >> 14) & 0x3FFF) + 1;
+                out.bitDepth = ((bits >> 28) & 1) ? 32 : 24;
+                haveSize = true;
+            } else if (fourcc == FourCC('A', 'N', 'M', 'F')) {
+                ++frames;
+            } else if (fourcc == FourCC('I', 'C', 'C', 'P')) {
+                out.hasColorProfile = true;
+            } else if (fourcc == FourCC('E', 'X', 'I', 'F')) {
+                // Some writers keep the JPEG-style "Exif\0\0" prefix
+                ByteView exif = payload.Matches(0, EXIF_PREFIX, sizeof(EXIF_PREFIX))
+                    ? payload.Sub(sizeof(EXIF_PREFIX)) : payload;
+                out.orientation = ReadExifOrientation(exif);
+            }
+
+            position = chunk + static_cast<size_t>(length) + (length & 1); // Chunks are padded to even sizes
+        }
+
+        if (!haveSize) {
+            return ProbeStatus::NeedMoreData;
+        }
+        out.frameCount = frames > 0 ? frames : 1;
+        return ProbeStatus::Ok;
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeBmp(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Bmp;
+        if (!data.Has(0, 18)) {
+            return ProbeStatus::NeedMoreData;
+        }
+
+        uint32_t infoSize = data.U32LE(14);
+        if (infoSize == 12) {
+            // OS/2 BITMAPCOREHEADER: 16-bit dimensions
+            if (!data.Has(14, 12)) {
+                return ProbeStatus::NeedMoreData;
+            }
+            out.width = data.U16LE(18);
+            out.height = data.U16LE(20);
+            out.bitDepth = data.U16LE(24);
+            return ProbeStatus::Ok;
+        }
+        if (infoSize < 40) {
+            return ProbeStatus::Malformed;
+        }
+        if (!data.Has(14, 40)) {
+            return ProbeStatus::NeedMoreData;
+        }
+
+        // Negative height means a top-down bitmap
+        int32_t width = static_cast<int32_t>(data.U32LE(18));
+        int32_t height = static_cast<int32_t>(data.U32LE(22));
+        if (width <= 0 || height == INT32_MIN) {
+            return ProbeStatus::Malformed;
+        }
+        out.width = static_cast<uint32_t>(width);
+        out.height = static_cast<uint32_t>(height < 0 ? -height : height);
+        out.bitDepth = data.U16LE(28);
+
+        // BITMAPV5HEADER: bV5CSType is PROFILE_EMBEDDED ('MBED') or PROFILE_LINKED ('LINK')
+        if (infoSize >= 124 && data.Has(14 + 56, 4)) {
+            uint32_t colorSpace = data.U32LE(14 + 56);
+            out.hasColorProfile = colorSpace == 0x4D424544 || colorSpace == 0x4C494E4B;
+        }
+        return ProbeStatus::Ok;
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeTiff(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Tiff;
+        TiffReader tiff(data);
+        if (!tiff.IsValid()) {
+            return ProbeStatus::Malformed;
+        }
+
+        uint32_t samplesPerPixel = 1;
+        uint32_t bitsPerSample = 1;
+        uint32_t nextIfd = 0;
+        bool found = tiff.VisitIfd(tiff.FirstIfdOffset(), [&](const TiffEntry& entry) {
+            switch (entry.tag) {
+            case TiffTag::ImageWidth:
+                out.width = tiff.Value(entry);
+                break;
+            case TiffTag::ImageLength:
+                out.height = tiff.Value(entry);
+                break;
+            case TiffTag::BitsPerSample:
+                bitsPerSample = tiff.Value(entry);
+                break;
+            case TiffTag::SamplesPerPixel:
+                samplesPerPixel = tiff.Value(entry);
+                break;
+            case TiffTag::Orientation:
+                out.orientation = NormalizeOrientation(tiff.Value(entry));
+                break;
+            case TiffTag::IccProfile:
+                out.hasColorProfile = true;
+                break;
+            }
+        }, &nextIfd);
+
+        if (!found) {
+            return ProbeStatus::NeedMoreData; // IFD0 lies beyond the probed bytes
+        }
+        out.bitDepth = static_cast<uint16_t>(bitsPerSample * samplesPerPixel);
+
+        // Multi-page TIFF: follow the IFD chain as far as the probed bytes go
+        uint32_t pages = 1;
+        while (nextIfd != 0 && pages < MAX_TIFF_PAGES &&
+               tiff.VisitIfd(nextIfd, [](const TiffEntry&) {}, &nextIfd)) {
+            ++pages;
+        }
+        out.frameCount = pages;
+        return ProbeStatus::Ok;
+    }
+
+    ProbeStatus ImageHeaderProbe::ProbeIco(ByteView data, ImageHeader& out) {
+        out.format = ImageFormat::Ico;
+        uint16_t count = data.U16LE(4);
+        if (count == 0) {
+            return ProbeStatus::Malformed;
+        }
+        if (!data.Has(6, static_cast<size_t>(count) * 16)) {
+            return ProbeStatus::NeedMoreData;
+        }
+
+        // Show the largest image in the directory; deeper color wins a tie
+        uint64_t bestArea = 0;
+        uint32_t bestOffset = 0;
+        for (uint16_t i = 0; i < count; ++i) {
+            size_t entry = 6 + static_cast<size_t>(i) * 16;
+            uint32_t width = data.U8(entry) ? data.U8(entry) : 256;
+            uint32_t height = data.U8(entry + 1) ? data.U8(entry + 1) : 256;
+            uint16_t bitDepth = data.U16LE(entry + 6);
+            uint64_t area = static_cast<uint64_t>(width) * height;
+
+            if (area > bestArea || (area == bestArea && bitDepth > out.bitDepth)) {
+                bestArea = area;
+                bestOffset = data.U32LE(entry + 12);
+                out.width = width;
+                out.height = height;
+                out.bitDepth = bitDepth;
+            }
+        }
+
+        // Vista-style icons embed PNGs whose real size can exceed 256
+        ImageHeader embedded;
+        if (ReadPngHeader(data.Sub(bestOffset), embedded)) {
+            out.width = embedded.width;
+            out.height = embedded.height;
+            out.bitDepth = embedded.bitDepth;
+        }
+        if (out.bitDepth == 0) {
+            out.bitDepth = 32;
+        }
+        return ProbeStatus::Ok;
+    }
+
+    uint16_t ImageHeaderProbe::ReadExifOrientation(ByteView tiffData) {
+        TiffReader tiff(tiffData);
+        uint16_t orientation = 1;
+        tiff.VisitIfd(tiff.FirstIfdOffset(), [&](const TiffEntry& entry) {
+            if (entry.tag == TiffTag::Orientation) {
+                orientation = NormalizeOrientation(tiff.Value(entry));
+            }
+        });
+        return orientation;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    enum class ImageFormat {
+        Unknown,
+        Jpeg,
+        Png,
+        Gif,
+        WebP,
+        Bmp,
+        Tiff,
+        Ico
+    };
+
+    struct ImageHeader {
+        ImageFormat format = ImageFormat::Unknown;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint16_t orientation = 1;    // EXIF orientation 1-8; 5-8 swap width and height on display
+        uint16_t bitDepth = 0;       // Bits per pixel across all channels
+        uint32_t frameCount = 1;     // Frames (or TIFF pages) seen in the probed bytes; > 1 means animated
+        bool hasColorProfile = false;
+    };
+
+    enum class ProbeStatus {
+        Ok,             // Dimensions found; metadata after the probed range may be missing
+        NeedMoreData,   // Recognized, but the dimensions lie beyond the probed bytes
+        Unrecognized,   // Not one of the supported formats
+        Malformed       // Recognized, but the header is inconsistent
+    };
+
+    // Reads image dimensions and layout metadata from the first bytes of a
+    // file without decoding any pixels, so the preview window can open at its
+    // final size while the real decode runs. The format is sniffed from the
+    // content, not the extension. Input is untrusted and never read past the
+    // end of `data`.
+    class ImageHeaderProbe {
+    public:
+        // Enough for every format except JPEGs with very large APPn segments
+        static constexpr size_t DEFAULT_PROBE_BYTES = 64 * 1024;
+        static constexpr size_t MAX_PROBE_BYTES = 1024 * 1024;
+
+        static ProbeStatus Probe(ByteView data, ImageHeader& out);
+
+        // Extensions ImageRenderer accepts (case-insensitive)
+        static bool HandlesExtension(std::wstring_view extension);
+
+        static const char* FormatName(ImageFormat format);
+
+    private:
+        static ProbeStatus ProbeJpeg(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbePng(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbeGif(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbeWebP(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbeBmp(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbeTiff(ByteView data, ImageHeader& out);
+        static ProbeStatus ProbeIco(ByteView data, ImageHeader& out);
+
+        // Orientation from IFD0 of an embedded EXIF (TIFF) block
+        static uint16_t ReadExifOrientation(ByteView tiff);
+    };
+}
@@ -0,0 +1,74 @@
+#include "TiffReader.h"
+
+namespace Lumos {
+    namespace {
+        enum TiffType : uint16_t {
+            Byte = 1, Ascii = 2, Short = 3, Long = 4, Rational = 5,
+            SByte = 6, Undefined = 7, SShort = 8, SLong = 9, SRational = 10,
+            Float = 11, Double = 12, Ifd = 13
+        };
+    }
+
+    TiffReader::TiffReader(ByteView data)
+        : m_data(data)
+        , m_valid(false)
+        , m_bigEndian(false)
+        , m_firstIfd(0)
+    {
+        if (!m_data.Has(0, HEADER_SIZE)) {
+            return;
+        }
+
+        if (m_data.U8(0) == 'I' && m_data.U8(1) == 'I') {
+            m_bigEndian = false;
+        } else if (m_data.U8(0) == 'M' && m_data.U8(1) == 'M') {
+            m_bigEndian = true;
+        } else {
+            return;
+        }
+
+        // 42 for TIFF, DNG, CR2, NEF and ARW; Olympus ORF and Panasonic RW2
+        // only change the magic
+        uint16_t magic = m_data.U16(2, m_bigEndian);
+        if (magic != 42 && magic != 0x4F52 && magic != 0x5352 && magic != 0x55) {
+            return;
+        }
+
+        m_firstIfd = m_data.U32(4, m_bigEndian);
+        m_valid = m_firstIfd >= HEADER_SIZE;
+    }
+
+    uint32_t TiffReader::Value(const TiffEntry& entry, uint32_t index) const {
+        if (index >= entry.count) {
+            return 0;
+        }
+
+        switch (entry.type) {
+        case Byte:
+        case Undefined:
+            return m_data.U8(entry.valueOffset + index);
+        case Short:
+            return m_data.U16(entry.valueOffset + static_cast<size_t>(index) * 2, m_bigEndian);
+        case Long:
+        case Ifd:
+            return m_data.U32(entry.valueOffset + static_cast<size_t>(index) * 4, m_bigEndian);
+        default:
+            return 0;
+        }
+    }
+
+    size_t TiffReader::TypeSize(uint16_t type) {
+        switch (type) {
+        case Byte: case Ascii: case SByte: case Undefined:
+            return 1;
+        case Short: case SShort:
+            return 2;
+        case Long: case SLong: case Float: case Ifd:
+            return 4;
+        case Rational: case SRational: case Double:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+}
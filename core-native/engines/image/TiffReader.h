@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    namespace TiffTag {
+        constexpr uint16_t NewSubfileType = 254;
+        constexpr uint16_t ImageWidth = 256;
+        constexpr uint16_t ImageLength = 257;
+        constexpr uint16_t BitsPerSample = 258;
+        constexpr uint16_t Compression = 259;
+        constexpr uint16_t Photometric = 262;
+        constexpr uint16_t StripOffsets = 273;
+        constexpr uint16_t Orientation = 274;
+        constexpr uint16_t SamplesPerPixel = 277;
+        constexpr uint16_t RowsPerStrip = 278;
+        constexpr uint16_t StripByteCounts = 279;
+        constexpr uint16_t PlanarConfiguration = 284;
+        constexpr uint16_t TileWidth = 322;
+        constexpr uint16_t TileLength = 323;
+        constexpr uint16_t TileOffsets = 324;
+        constexpr uint16_t TileByteCounts = 325;
+        constexpr uint16_t SubIFDs = 330;
+        constexpr uint16_t JpegTables = 347;
+        constexpr uint16_t JpegInterchangeFormat = 513;
+        constexpr uint16_t JpegInterchangeFormatLength = 514;
+        constexpr uint16_t IccProfile = 34675;
+        constexpr uint16_t ExifIfd = 34665;
+    }
+
+    struct TiffEntry {
+        uint16_t tag;
+        uint16_t type;
+        uint32_t count;
+        size_t valueOffset; // Where the value bytes start in the view (inline when they fit in 4 bytes)
+    };
+
+    // Read-only walker over a TIFF structure: standalone TIFF files, the EXIF
+    // block of JPEG/PNG/WebP, and TIFF-based RAW formats. Every offset comes
+    // from the file, so all of them are bounds-checked against the view.
+    class TiffReader {
+    public:
+        explicit TiffReader(ByteView data);
+
+        bool IsValid() const { return m_valid; }
+        bool IsBigEndian() const { return m_bigEndian; }
+        uint32_t FirstIfdOffset() const { return m_firstIfd; }
+        ByteView Data() const { return m_data; }
+
+        // Call visit(const TiffEntry&) for every entry of the IFD at `offset`
+        // whose header lies inside the view. Returns false if the IFD itself
+        // does not. `nextIfd` receives the chained IFD offset (0 at the end,
+        // or when the link itself was not in the view).
+        template <typename Visitor>
+        bool VisitIfd(uint32_t offset, Visitor&& visit, uint32_t* nextIfd = nullptr) const {
+            if (nextIfd) *nextIfd = 0;
+            if (!m_valid || offset < HEADER_SIZE || !m_data.Has(offset, 2)) {
+                return false;
+            }
+
+            uint16_t count = m_data.U16(offset, m_bigEndian);
+            size_t position = static_cast<size_t>(offset) + 2;
+            for (uint16_t i = 0; i < count; ++i, position += ENTRY_SIZE) {
+                if (!m_data.Has(position, ENTRY_SIZE)) {
+                    return true; // Truncated: report what we have
+                }
+                TiffEntry entry;
+                entry.tag = m_data.U16(position, m_bigEndian);
+                entry.type = m_data.U16(position + 2, m_bigEndian);
+                entry.count = m_data.U32(position + 4, m_bigEndian);
+                uint64_t bytes = TypeSize(entry.type) * static_cast<uint64_t>(entry.count);
+                entry.valueOffset = bytes <= 4 ? position + 8 : m_data.U32(position + 8, m_bigEndian);
+                visit(entry);
+            }
+
+            if (nextIfd && m_data.Has(position, 4)) {
+                *nextIfd = m_data.U32(position, m_bigEndian);
+            }
+            return true;
+        }
+
+        // Element `index` of a BYTE/SHORT/LONG entry; 0 for other types or
+        // values outside the view
+        uint32_t Value(const TiffEntry& entry, uint32_t index = 0) const;
+
+        // Bytes per element for a TIFF field type (0 if unknown)
+        static size_t TypeSize(uint16_t type);
+
+    private:
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t ENTRY_SIZE = 12;
+
+        ByteView m_data;
+        bool m_valid;
+        bool m_bigEndian;
+        uint32_t m_firstIfd;
+    };
+}
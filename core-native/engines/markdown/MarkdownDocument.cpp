@@ -0,0 +1,69 @@
+#include "MarkdownDocument.h"
+#include "../../common/Json.h"
+
+namespace Lumos {
+    namespace {
+        const char* KindName(MarkdownBlockKind kind) {
+            switch (kind) {
+            case MarkdownBlockKind::Heading: return "heading";
+            case MarkdownBlockKind::CodeBlock: return "code";
+            case MarkdownBlockKind::HtmlBlock: return "html";
+            case MarkdownBlockKind::ThematicBreak: return "rule";
+            case MarkdownBlockKind::TableRow: return "row";
+            default: return "paragraph";
+            }
+        }
+    }
+
+    void MarkdownDocument::WriteJson(std::pmr::string& out) const {
+        out.push_back('[');
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            const MarkdownBlock& block = blocks[b];
+            if (b != 0) {
+                out.push_back(',');
+            }
+
+            out.append("{\"kind\":\"");
+            out.append(KindName(block.kind));
+            out.push_back('"');
+            if (block.level != 0) AppendField(out, "level", block.level);
+            if (block.quoteDepth != 0) AppendField(out, "quoteDepth", block.quoteDepth);
+            if (block.listDepth != 0) AppendField(out, "listDepth", block.listDepth);
+            if (block.listItemStart) {
+                out.append(",\"listItemStart\":true");
+                if (block.listOrdered) {
+                    out.append(",\"listOrdered\":true");
+                    AppendField(out, "listNumber", block.listNumber);
+                }
+            }
+            if (block.kind == MarkdownBlockKind::TableRow) {
+                AppendField(out, "cellCount", block.cellCount);
+                if (block.tableHeader) out.append(",\"tableHeader\":true");
+            }
+            if (block.infoLength != 0) {
+                out.append(",\"info\":");
+                AppendJsonString(out, Text(block.infoOffset, block.infoLength));
+            }
+
+            out.append(",\"runs\":[");
+            for (uint32_t r = 0; r < block.runCount; ++r) {
+                const MarkdownRun& run = runs[block.firstRun + r];
+                if (r != 0) {
+                    out.push_back(',');
+                }
+                out.append("{\"text\":");
+                AppendJsonString(out, Text(run.textOffset, run.textLength));
+                if (run.style != 0) AppendField(out, "style", run.style);
+                if (run.linkLength != 0) {
+                    out.append(",\"link\":");
+                    AppendJsonString(out, Text(run.linkOffset, run.linkLength));
+                }
+                if (run.cell != 0) AppendField(out, "cell", run.cell);
+                if (run.align != MarkdownAlign::None) AppendField(out, "align", static_cast<uint64_t>(run.align));
+                out.push_back('}');
+            }
+            out.append("]}");
+        }
+        out.push_back(']');
+    }
+}
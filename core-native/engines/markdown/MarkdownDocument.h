@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Lumos {
+    enum class MarkdownBlockKind : uint8_t {
+        Paragraph,
+        Heading,
+        CodeBlock,      // Fenced or indented; one run holding every line
+        HtmlBlock,      // Raw HTML, shown as source
+        ThematicBreak,
+        TableRow
+    };
+
+    // Inline style bits of a run; nesting is already resolved
+    enum MarkdownStyle : uint16_t {
+        MarkdownStrong = 1 << 0,
+        MarkdownEmphasis = 1 << 1,
+        MarkdownCode = 1 << 2,
+        MarkdownStrikethrough = 1 << 3,
+        MarkdownLink = 1 << 4,       // `link` holds the destination
+        MarkdownImage = 1 << 5,      // Alt text; `link` holds the source
+        MarkdownLineBreak = 1 << 6   // Hard line break; no text
+    };
+
+    enum class MarkdownAlign : uint8_t { None, Left, Center, Right };
+
+    // Styled span of text. Offsets index MarkdownDocument::text (UTF-8).
+    struct MarkdownRun {
+        uint32_t textOffset;
+        uint32_t textLength;
+        uint32_t linkOffset;
+        uint32_t linkLength;
+        uint16_t style;
+        uint16_t cell;          // TableRow: column of this run
+        MarkdownAlign align;    // TableRow: column alignment
+    };
+
+    // Flat render tree: containers (block quotes, list items) are not nodes,
+    // each leaf block carries the depth of the containers around it. A UI
+    // walks the blocks in order and never recurses.
+    struct MarkdownBlock {
+        MarkdownBlockKind kind;
+        uint8_t level;          // Heading 1-6
+        uint8_t quoteDepth;     // Enclosing block quotes
+        uint8_t listDepth;      // Enclosing list items
+        bool listItemStart;     // First block of a list item: draw its marker
+        bool listOrdered;       // That marker is a number rather than a bullet
+        bool tableHeader;
+        uint16_t cellCount;     // TableRow
+        uint32_t listNumber;
+        uint32_t infoOffset;    // CodeBlock: fence info string (language)
+        uint32_t infoLength;
+        uint32_t firstRun;
+        uint32_t runCount;
+    };
+
+    // Output of MarkdownParser. Holds only the blocks produced since the last
+    // Clear(), so a streaming consumer can hand off each chunk and reuse it.
+    // Allocates from the given resource (the request arena in the pipeline).
+    struct MarkdownDocument {
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+        explicit MarkdownDocument(const allocator_type& alloc = {})
+            : blocks(alloc)
+            , runs(alloc)
+            , text(alloc)
+        {
+        }
+
+        std::pmr::vector<MarkdownBlock> blocks;
+        std::pmr::vector<MarkdownRun> runs;
+        std::pmr::string text;
+
+        std::string_view Text(uint32_t offset, uint32_t length) const {
+            return std::string_view(text).substr(offset, length);
+        }
+
+        void Clear() {
+            blocks.clear();
+            runs.clear();
+            text.clear();
+        }
+
+        // Append the blocks as a JSON array, runs inlined and default fields
+        // omitted (the wire format of PreviewMarkdown::blocksJson)
+        void WriteJson(std::pmr::string& out) const;
+    };
+}
@@ -0,0 +1,796 @@
+#include "MarkdownInlines.h"
+#include <cstring>
+
+namespace Lumos {
+    namespace {
+        constexpr size_t MAX_LABEL_LENGTH = 999;
+        constexpr size_t MAX_DELIMITER_RUN = 1024; // Longer runs are never emphasis in practice
+
+        enum StyleIndex { STRONG = 0, EMPHASIS = 1, STRIKE = 2 };
+
+        struct NamedEntity {
+            const char* name;
+            uint32_t codepoint;
+        };
+
+        // The entities that actually show up in READMEs; others stay literal
+        const NamedEntity ENTITIES[] = {
+            { "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+            { "nbsp", 0xA0 }, { "copy", 0xA9 }, { "reg", 0xAE }, { "trade", 0x2122 },
+            { "hellip", 0x2026 }, { "mdash", 0x2014 }, { "ndash", 0x2013 }, { "bull", 0x2022 },
+            { "middot", 0xB7 }, { "deg", 0xB0 }, { "times", 0xD7 }, { "divide", 0xF7 },
+            { "lsquo", 0x2018 }, { "rsquo", 0x2019 }, { "ldquo", 0x201C }, { "rdquo", 0x201D },
+            { "laquo", 0xAB }, { "raquo", 0xBB }, { "para", 0xB6 }, { "sect", 0xA7 },
+            { "euro", 0x20AC }, { "pound", 0xA3 }, { "yen", 0xA5 }, { "cent", 0xA2 },
+            { "larr", 0x2190 }, { "rarr", 0x2192 }, { "uarr", 0x2191 }, { "darr", 0x2193 },
+            { "check", 0x2713 }, { "ensp", 0x2002 }, { "emsp", 0x2003 }, { "thinsp", 0x2009 }
+        };
+
+        bool IsAsciiAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+        bool IsAsciiDigit(char c) { return c >= '0' && c <= '9'; }
+        bool IsAsciiAlnum(char c) { return IsAsciiAlpha(c) || IsAsciiDigit(c); }
+
+        void AppendCodepoint(std::string& out, uint32_t cp) {
+            if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                cp = 0xFFFD;
+            }
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        // `&...;` at source[pos]; appends the character and moves past it
+        bool DecodeEntity(std::string_view source, size_t& pos, std::string& out) {
+            size_t p = pos + 1;
+            size_t n = source.size();
+            if (p < n && source[p] == '#') {
+                ++p;
+                bool hex = p < n && (source[p] == 'x' || source[p] == 'X');
+                if (hex) ++p;
+                size_t start = p;
+                uint32_t cp = 0;
+                size_t maxDigits = hex ? 6 : 7;
+                while (p < n && p - start < maxDigits) {
+                    char c = source[p];
+                    uint32_t digit;
+                    if (IsAsciiDigit(c)) digit = static_cast<uint32_t>(c - '0');
+                    else if (hex && c >= 'a' && c <= 'f') digit = static_cast<uint32_t>(c - 'a' + 10);
+                    else if (hex && c >= 'A' && c <= 'F') digit = static_cast<uint32_t>(c - 'A' + 10);
+                    else break;
+                    cp = cp * (hex ? 16 : 10) + digit;
+                    ++p;
+                }
+                if (p == start || p >= n || source[p] != ';') {
+                    return false;
+                }
+                AppendCodepoint(out, cp);
+                pos = p + 1;
+                return true;
+            }
+
+            size_t start = p;
+            while (p < n && p - start < 32 && IsAsciiAlnum(source[p])) ++p;
+            if (p == start || p >= n || source[p] != ';') {
+                return false;
+            }
+            std::string_view name = source.substr(start, p - start);
+            for (const auto& entity : ENTITIES) {
+                if (name == entity.name) {
+                    AppendCodepoint(out, entity.codepoint);
+                    pos = p + 1;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Delimiters are classified by the characters around the run; UTF-8
+        // bytes count as letters, which is right for everything but Unicode
+        // punctuation and spaces
+        char Before(std::string_view source, size_t pos) { return pos > 0 ? source[pos - 1] : '\n'; }
+        char After(std::string_view source, size_t pos) { return pos < source.size() ? source[pos] : '\n'; }
+    }
+
+    MarkdownInlineParser::MarkdownInlineParser(const MarkdownLinkReferences& references)
+        : m_references(references)
+        , m_lastDelimiter(-1)
+        , m_missedReference(false)
+    {
+    }
+
+    bool MarkdownInlineParser::IsPunctuation(char c) {
+        return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+    }
+
+    void MarkdownInlineParser::AppendUnescaped(std::string& out, std::string_view text) {
+        for (size_t i = 0; i < text.size();) {
+            char c = text[i];
+            if (c == '\\' && i + 1 < text.size() && IsPunctuation(text[i + 1])) {
+                out.push_back(text[i + 1]);
+                i += 2;
+            } else if (c == '&' && DecodeEntity(text, i, out)) {
+                continue;
+            } else {
+                out.push_back(c);
+                ++i;
+            }
+        }
+    }
+
+    std::string MarkdownInlineParser::NormalizeLabel(std::string_view label) {
+        std::string normalized;
+        normalized.reserve(label.size());
+        bool pendingSpace = false;
+        for (char c : label) {
+            if (IsSpace(c)) {
+                pendingSpace = !normalized.empty();
+                continue;
+            }
+            if (pendingSpace) {
+                normalized.push_back(' ');
+                pendingSpace = false;
+            }
+            normalized.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+        return normalized;
+    }
+
+    bool MarkdownInlineParser::ScanDestination(std::string_view source, size_t& pos, std::string_view& destination) {
+        size_t n = source.size();
+        size_t p = pos;
+        if (p < n && source[p] == '<') {
+            ++p;
+            size_t start = p;
+            while (p < n && source[p] != '>') {
+                char c = source[p];
+                if (c == '\n' || c == '<') {
+                    return false;
+                }
+                p += (c == '\\' && p + 1 < n) ? 2 : 1;
+            }
+            if (p >= n) {
+                return false;
+            }
+            destination = source.substr(start, p - start);
+            pos = p + 1;
+            return true;
+        }
+
+        size_t start = p;
+        int depth = 0;
+        while (p < n) {
+            char c = source[p];
+            if (static_cast<unsigned char>(c) <= ' ') {
+                break;
+            }
+            if (c == '\\' && p + 1 < n && IsPunctuation(source[p + 1])) {
+                p += 2;
+                continue;
+            }
+            if (c == '(') {
+                if (++depth > 32) return false;
+            } else if (c == ')') {
+                if (depth == 0) break;
+                --depth;
+            }
+            ++p;
+        }
+        if (p == start || depth != 0) {
+            return false;
+        }
+        destination = source.substr(start, p - start);
+        pos = p;
+        return true;
+    }
+
+    bool MarkdownInlineParser::ScanTitle(std::string_view source, size_t& pos) {
+        size_t n = source.size();
+        if (pos >= n) {
+            return false;
+        }
+        char open = source[pos];
+        char close = open == '(' ? ')' : open;
+        if (open != '"' && open != '\'' && open != '(') {
+            return false;
+        }
+        for (size_t p = pos + 1; p < n; ++p) {
+            char c = source[p];
+            if (c == '\\' && p + 1 < n) {
+                ++p;
+            } else if (c == close) {
+                pos = p + 1;
+                return true;
+            } else if (open == '(' && c == '(') {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    void MarkdownInlineParser::Parse(std::string_view source, MarkdownDocument& document,
+                                     uint16_t cell, MarkdownAlign align) {
+        m_nodes.clear();
+        m_brackets.clear();
+        m_links.clear();
+        m_buffer.clear();
+        m_lastDelimiter = -1;
+        m_missedReference = false;
+
+        size_t n = source.size();
+        size_t pos = 0;
+        while (pos < n) {
+            char c = source[pos];
+            switch (c) {
+            case '\\':
+                if (pos + 1 < n && source[pos + 1] == '\n') {
+                    AppendLineBreak(true);
+                    pos += 2;
+                    while (pos < n && (source[pos] == ' ' || source[pos] == '\t')) ++pos;
+                } else if (pos + 1 < n && IsPunctuation(source[pos + 1])) {
+                    AppendChar(source[pos + 1]);
+                    pos += 2;
+                } else {
+                    AppendChar('\\');
+                    ++pos;
+                }
+                break;
+            case '`':
+                ParseCodeSpan(source, pos);
+                break;
+            case '*':
+            case '_':
+            case '~': {
+                size_t length = 1;
+                while (pos + length < n && source[pos + length] == c) ++length;
+                PushDelimiter(source, pos, length);
+                pos += length;
+                break;
+            }
+            case '!':
+                if (pos + 1 < n && source[pos + 1] == '[') {
+                    Node node{};
+                    node.kind = NodeKind::Bracket;
+                    node.image = true;
+                    node.link = -1;
+                    m_nodes.push_back(node);
+                    m_brackets.push_back(Bracket{ static_cast<uint32_t>(m_nodes.size() - 1), pos + 2, true, true });
+                    pos += 2;
+                } else {
+                    AppendChar('!');
+                    ++pos;
+                }
+                break;
+            case '[': {
+                Node node{};
+                node.kind = NodeKind::Bracket;
+                node.link = -1;
+                m_nodes.push_back(node);
+                m_brackets.push_back(Bracket{ static_cast<uint32_t>(m_nodes.size() - 1), pos + 1, false, true });
+                ++pos;
+                break;
+            }
+            case ']':
+                CloseBracket(source, pos);
+                break;
+            case '<':
+                if (!ParseAutolink(source, pos)) {
+                    AppendChar('<');
+                    ++pos;
+                }
+                break;
+            case '&':
+                if (!ParseEntity(source, pos)) {
+                    AppendChar('&');
+                    ++pos;
+                }
+                break;
+            case '\n': {
+                // Two trailing spaces make a hard break; either way they go
+                bool hard = false;
+                if (!m_nodes.empty() && m_nodes.back().kind == NodeKind::Text && m_nodes.back().style == 0) {
+                    Node& last = m_nodes.back();
+                    size_t spaces = 0;
+                    while (spaces < last.textLength && m_buffer[last.textOffset + last.textLength - 1 - spaces] == ' ') {
+                        ++spaces;
+                    }
+                    hard = spaces >= 2;
+                    last.textLength -= static_cast<uint32_t>(spaces);
+                    m_buffer.resize(m_buffer.size() - spaces);
+                }
+                AppendLineBreak(hard);
+                ++pos;
+                while (pos < n && (source[pos] == ' ' || source[pos] == '\t')) ++pos;
+                break;
+            }
+            default: {
+                size_t start = pos;
+                while (pos < n && !std::strchr("\\`*_~![]<&\n", source[pos])) ++pos;
+                if (pos == start) ++pos; // NUL: strchr matches the terminator
+                AppendText(source.substr(start, pos - start));
+                break;
+            }
+            }
+        }
+
+        ProcessEmphasis(-1);
+        Flatten(document, cell, align);
+    }
+
+    void MarkdownInlineParser::AppendText(std::string_view text, uint16_t style) {
+        if (text.empty()) {
+            return;
+        }
+        if (!m_nodes.empty()) {
+            Node& last = m_nodes.back();
+            if (last.kind == NodeKind::Text && last.style == style && style != MarkdownLineBreak &&
+                last.textOffset + last.textLength == m_buffer.size()) {
+                m_buffer.append(text);
+                last.textLength += static_cast<uint32_t>(text.size());
+                return;
+            }
+        }
+
+        Node node{};
+        node.kind = NodeKind::Text;
+        node.style = style;
+        node.link = -1;
+        node.textOffset = static_cast<uint32_t>(m_buffer.size());
+        node.textLength = static_cast<uint32_t>(text.size());
+        m_buffer.append(text);
+        m_nodes.push_back(node);
+    }
+
+    void MarkdownInlineParser::AppendLineBreak(bool hard) {
+        if (!hard) {
+            AppendChar(' '); // Soft break: the UI wraps paragraphs itself
+            return;
+        }
+        Node node{};
+        node.kind = NodeKind::Text;
+        node.style = MarkdownLineBreak;
+        node.link = -1;
+        node.textOffset = static_cast<uint32_t>(m_buffer.size());
+        m_nodes.push_back(node);
+    }
+
+    void MarkdownInlineParser::PushDelimiter(std::string_view source, size_t start, size_t length) {
+        char c = source[start];
+        if (length > MAX_DELIMITER_RUN || (c == '~' && length > 2)) {
+            AppendText(source.substr(start, length));
+            return;
+        }
+
+        char before = Before(source, start);
+        char after = After(source, start + length);
+        bool leftFlanking = !IsSpace(after) && (!IsPunctuation(after) || IsSpace(before) || IsPunctuation(before));
+        bool rightFlanking = !IsSpace(before) && (!IsPunctuation(before) || IsSpace(after) || IsPunctuation(after));
+
+        Node node{};
+        node.kind = NodeKind::Delimiter;
+        node.delimiter = c;
+        node.link = -1;
+        node.count = static_cast<uint16_t>(length);
+        node.originalCount = node.count;
+        if (c == '_') {
+            // Intraword underscores (snake_case) never emphasize
+            node.canOpen = leftFlanking && (!rightFlanking || IsPunctuation(before));
+            node.canClose = rightFlanking && (!leftFlanking || IsPunctuation(after));
+        } else {
+            node.canOpen = leftFlanking;
+            node.canClose = rightFlanking;
+        }
+        node.previousDelimiter = m_lastDelimiter;
+        node.nextDelimiter = -1;
+
+        int32_t index = static_cast<int32_t>(m_nodes.size());
+        m_nodes.push_back(node);
+        if (m_lastDelimiter != -1) {
+            m_nodes[m_lastDelimiter].nextDelimiter = index;
+        }
+        m_lastDelimiter = index;
+    }
+
+    void MarkdownInlineParser::ParseCodeSpan(std::string_view source, size_t& pos) {
+        size_t n = source.size();
+        size_t length = 1;
+        while (pos + length < n && source[pos + length] == '`') ++length;
+
+        // Closing run of exactly the same length
+        size_t p = pos + length;
+        while (p < n) {
+            if (source[p] != '`') {
+                ++p;
+                continue;
+            }
+            size_t run = 1;
+            while (p + run < n && source[p + run] == '`') ++run;
+            if (run == length) {
+                break;
+            }
+            p += run;
+        }
+        if (p >= n) {
+            AppendText(source.substr(pos, length));
+            pos += length;
+            return;
+        }
+
+        std::string_view content = source.substr(pos + length, p - pos - length);
+        if (content.size() >= 2 && content.front() == ' ' && content.back() == ' ' &&
+            content.find_first_not_of(' ') != std::string_view::npos) {
+            content = content.substr(1, content.size() - 2);
+        }
+
+        size_t newline = content.find('\n');
+        if (newline == std::string_view::npos) {
+            AppendText(content, MarkdownCode);
+        } else {
+            std::string flattened(content);
+            for (char& ch : flattened) {
+                if (ch == '\n') ch = ' ';
+            }
+            AppendText(flattened, MarkdownCode);
+        }
+        pos = p + length;
+    }
+
+    bool MarkdownInlineParser::ParseAutolink(std::string_view source, size_t& pos) {
+        size_t n = source.size();
+        size_t p = pos + 1;
+        std::string destination;
+
+        // URI: scheme of 2-32 characters, then anything up to '>' but spaces and '<'
+        size_t schemeEnd = p;
+        if (schemeEnd < n && IsAsciiAlpha(source[schemeEnd])) {
+            ++schemeEnd;
+            while (schemeEnd < n && schemeEnd - p < 32 &&
+                   (IsAsciiAlnum(source[schemeEnd]) || source[schemeEnd] == '+' ||
+                    source[schemeEnd] == '.' || source[schemeEnd] == '-')) {
+                ++schemeEnd;
+            }
+        }
+        size_t end = std::string_view::npos;
+        if (schemeEnd - p >= 2 && schemeEnd < n && source[schemeEnd] == ':') {
+            size_t q = schemeEnd + 1;
+            while (q < n && source[q] != '>' && source[q] != '<' && static_cast<unsigned char>(source[q]) > ' ') ++q;
+            if (q < n && source[q] == '>') {
+                end = q;
+                destination.assign(source.substr(p, q - p));
+            }
+        }
+
+        // Email
+        if (end == std::string_view::npos) {
+            size_t q = p;
+            while (q < n && (IsAsciiAlnum(source[q]) || std::strchr(".!#$%&'*+/=?^_`{|}~-", source[q]))) ++q;
+            if (q == p || q >= n || source[q] != '@') {
+                return false;
+            }
+            size_t domain = ++q;
+            while (q < n && (IsAsciiAlnum(source[q]) || source[q] == '-' || source[q] == '.')) ++q;
+            if (q == domain || q >= n || source[q] != '>') {
+                return false;
+            }
+            end = q;
+            destination = "mailto:";
+            destination.append(source.substr(p, q - p));
+        }
+
+        Node open{};
+        open.kind = NodeKind::Bracket;
+        open.link = static_cast<int32_t>(m_links.size());
+        m_links.push_back(std::move(destination));
+        m_nodes.push_back(open);
+        AppendText(source.substr(p, end - p));
+        Node close{};
+        close.kind = NodeKind::LinkEnd;
+        close.link = -1;
+        m_nodes.push_back(close);
+
+        pos = end + 1;
+        return true;
+    }
+
+    bool MarkdownInlineParser::ParseEntity(std::string_view source, size_t& pos) {
+        std::string decoded;
+        if (!DecodeEntity(source, pos, decoded)) {
+            return false;
+        }
+        AppendText(decoded);
+        return true;
+    }
+
+    void MarkdownInlineParser::CloseBracket(std::string_view source, size_t& pos) {
+        if (m_brackets.empty()) {
+            AppendChar(']');
+            ++pos;
+            return;
+        }
+
+        Bracket opener = m_brackets.back();
+        m_brackets.pop_back();
+        size_t after = pos + 1;
+        std::string destination;
+        if (!opener.active || !ParseLinkTail(source, after, pos, opener, destination)) {
+            AppendChar(']');
+            ++pos;
+            return;
+        }
+
+        m_nodes[opener.node].link = static_cast<int32_t>(m_links.size());
+        m_links.push_back(std::move(destination));
+        Node close{};
+        close.kind = NodeKind::LinkEnd;
+        close.link = -1;
+        m_nodes.push_back(close);
+
+        ProcessEmphasis(static_cast<int32_t>(opener.node));
+
+        // Links cannot contain links
+        if (!opener.image) {
+            for (auto& bracket : m_brackets) {
+                if (!bracket.image) bracket.active = false;
+            }
+        }
+        pos = after;
+    }
+
+    bool MarkdownInlineParser::ParseLinkTail(std::string_view source, size_t& pos, size_t labelEnd,
+                                             const Bracket& opener, std::string& destination) {
+        size_t n = source.size();
+
+        // Inline: (destination "title")
+        if (pos < n && source[pos] == '(') {
+            size_t p = pos + 1;
+            while (p < n && IsSpace(source[p])) ++p;
+            std::string_view raw;
+            bool ok = true;
+            if (p < n && source[p] != ')') {
+                ok = ScanDestination(source, p, raw);
+                if (ok) {
+                    size_t q = p;
+                    while (q < n && IsSpace(source[q])) ++q;
+                    if (q > p && ScanTitle(source, q)) {
+                        while (q < n && IsSpace(source[q])) ++q;
+                    }
+                    p = q;
+                }
+            }
+            if (ok && p < n && source[p] == ')') {
+                AppendUnescaped(destination, raw);
+                pos = p + 1;
+                return true;
+            }
+        }
+
+        // Reference: [text][label], [label][] or [label]
+        std::string_view label = source.substr(opener.labelStart, labelEnd - opener.labelStart);
+        size_t after = pos;
+        if (pos < n && source[pos] == '[') {
+            size_t close = source.find(']', pos + 1);
+            if (close != std::string_view::npos && close - pos - 1 <= MAX_LABEL_LENGTH) {
+                std::string_view reference = source.substr(pos + 1, close - pos - 1);
+                if (reference.find('[') == std::string_view::npos) {
+                    if (!reference.empty()) {
+                        label = reference;
+                    }
+                    after = close + 1;
+                }
+            }
+        }
+        if (label.size() > MAX_LABEL_LENGTH) {
+            return false;
+        }
+
+        // A definition later in the file is not known yet; the block parser
+        // collects the rest and parses this text again
+        auto found = m_references.find(NormalizeLabel(label));
+        if (found == m_references.end()) {
+            m_missedReference = true;
+            return false;
+        }
+        destination = found->second;
+        pos = after;
+        return true;
+    }
+
+    void MarkdownInlineParser::ProcessEmphasis(int32_t stackBottom) {
+        // Lowest opener worth revisiting per (character, closer length mod 3,
+        // closer can open); keeps unmatched runs from going quadratic
+        int32_t openersBottom[3][3][2];
+        for (auto& byChar : openersBottom)
+            for (auto& byLength : byChar)
+                byLength[0] = byLength[1] = stackBottom;
+
+        int32_t closer = m_lastDelimiter;
+        int32_t first = -1;
+        while (closer != -1 && closer > stackBottom) {
+            first = closer;
+            closer = m_nodes[closer].previousDelimiter;
+        }
+
+        closer = first;
+        while (closer != -1) {
+            Node& c = m_nodes[closer];
+            if (!c.canClose) {
+                closer = c.nextDelimiter;
+                continue;
+            }
+
+            int kind = c.delimiter == '*' ? 0 : c.delimiter == '_' ? 1 : 2;
+            int32_t& bottom = openersBottom[kind][c.originalCount % 3][c.canOpen ? 1 : 0];
+
+            int32_t opener = c.previousDelimiter;
+            bool found = false;
+            while (opener != -1 && opener > stackBottom && opener > bottom) {
+                const Node& o = m_nodes[opener];
+                if (o.delimiter == c.delimiter && o.canOpen) {
+                    if (c.delimiter == '~') {
+                        found = o.count == c.count;
+                    } else {
+                        // "Rule of 3": *foo**bar* is not strong-in-emphasis
+                        found = !(o.canClose || c.canOpen) || c.originalCount % 3 == 0 ||
+                                (o.originalCount + c.originalCount) % 3 != 0;
+                    }
+                    if (found) break;
+                }
+                opener = o.previousDelimiter;
+            }
+
+            if (!found) {
+                bottom = c.previousDelimiter;
+                int32_t next = c.nextDelimiter;
+                if (!c.canOpen) {
+                    RemoveDelimiter(closer);
+                }
+                closer = next;
+                continue;
+            }
+
+            Node& o = m_nodes[opener];
+            uint16_t use;
+            int style;
+            if (c.delimiter == '~') {
+                use = c.count;
+                style = STRIKE;
+            } else {
+                use = (o.count >= 2 && c.count >= 2) ? 2 : 1;
+                style = use == 2 ? STRONG : EMPHASIS;
+            }
+            ++o.opens[style];
+            ++c.closes[style];
+            o.count = static_cast<uint16_t>(o.count - use);
+            c.count = static_cast<uint16_t>(c.count - use);
+
+            for (int32_t d = o.nextDelimiter; d != closer && d != -1;) {
+                int32_t next = m_nodes[d].nextDelimiter;
+                RemoveDelimiter(d);
+                d = next;
+            }
+            if (o.count == 0) {
+                RemoveDelimiter(opener);
+            }
+            if (c.count == 0) {
+                int32_t next = c.nextDelimiter;
+                RemoveDelimiter(closer);
+                closer = next;
+            }
+        }
+
+        while (m_lastDelimiter != -1 && m_lastDelimiter > stackBottom) {
+            RemoveDelimiter(m_lastDelimiter);
+        }
+    }
+
+    void MarkdownInlineParser::RemoveDelimiter(int32_t index) {
+        Node& node = m_nodes[index];
+        if (node.previousDelimiter != -1) {
+            m_nodes[node.previousDelimiter].nextDelimiter = node.nextDelimiter;
+        }
+        if (node.nextDelimiter != -1) {
+            m_nodes[node.nextDelimiter].previousDelimiter = node.previousDelimiter;
+        }
+        if (m_lastDelimiter == index) {
+            m_lastDelimiter = node.previousDelimiter;
+        }
+        node.previousDelimiter = node.nextDelimiter = -1;
+    }
+
+    void MarkdownInlineParser::Flatten(MarkdownDocument& document, uint16_t cell, MarkdownAlign align) {
+        struct OpenLink {
+            uint16_t style;
+            uint32_t offset;
+            uint32_t length;
+        };
+        OpenLink links[8];
+        size_t linkDepth = 0;
+        size_t linkOverflow = 0; // Images nested deeper than `links` holds
+        int depth[3] = { 0, 0, 0 };
+        size_t firstRun = document.runs.size();
+
+        auto emit = [&](std::string_view text, uint16_t style) {
+            if (text.empty() && style != MarkdownLineBreak) {
+                return;
+            }
+            if (depth[STRONG] > 0) style |= MarkdownStrong;
+            if (depth[EMPHASIS] > 0) style |= MarkdownEmphasis;
+            if (depth[STRIKE] > 0) style |= MarkdownStrikethrough;
+            uint32_t linkOffset = 0;
+            uint32_t linkLength = 0;
+            if (linkDepth > 0) {
+                style |= links[linkDepth - 1].style;
+                linkOffset = links[linkDepth - 1].offset;
+                linkLength = links[linkDepth - 1].length;
+            }
+
+            if (document.runs.size() > firstRun) {
+                MarkdownRun& last = document.runs.back();
+                if (last.style == style && style != MarkdownLineBreak && last.linkOffset == linkOffset &&
+                    last.linkLength == linkLength && last.textOffset + last.textLength == document.text.size()) {
+                    document.text.append(text);
+                    last.textLength += static_cast<uint32_t>(text.size());
+                    return;
+                }
+            }
+
+            MarkdownRun run{};
+            run.textOffset = static_cast<uint32_t>(document.text.size());
+            run.textLength = static_cast<uint32_t>(text.size());
+            run.linkOffset = linkOffset;
+            run.linkLength = linkLength;
+            run.style = style;
+            run.cell = cell;
+            run.align = align;
+            document.text.append(text);
+            document.runs.push_back(run);
+        };
+
+        for (const Node& node : m_nodes) {
+            switch (node.kind) {
+            case NodeKind::Text:
+                emit(std::string_view(m_buffer).substr(node.textOffset, node.textLength), node.style);
+                break;
+            case NodeKind::Delimiter:
+                for (int s = 0; s < 3; ++s) depth[s] -= node.closes[s];
+                if (node.count > 0) {
+                    emit(std::string(node.count, node.delimiter), 0);
+                }
+                for (int s = 0; s < 3; ++s) depth[s] += node.opens[s];
+                break;
+            case NodeKind::Bracket:
+                if (node.link < 0) {
+                    emit(node.image ? "![" : "[", 0);
+                } else if (linkDepth < sizeof(links) / sizeof(links[0])) {
+                    const std::string& destination = m_links[node.link];
+                    links[linkDepth].style = node.image ? MarkdownImage : MarkdownLink;
+                    links[linkDepth].offset = static_cast<uint32_t>(document.text.size());
+                    links[linkDepth].length = static_cast<uint32_t>(destination.size());
+                    document.text.append(destination);
+                    ++linkDepth;
+                } else {
+                    ++linkOverflow;
+                }
+                break;
+            case NodeKind::LinkEnd:
+                if (linkOverflow > 0) {
+                    --linkOverflow;
+                } else if (linkDepth > 0) {
+                    --linkDepth;
+                }
+                break;
+            }
+        }
+    }
+}
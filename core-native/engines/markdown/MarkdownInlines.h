@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MarkdownDocument.h"
+
+namespace Lumos {
+    // Link reference definitions seen so far: normalized label -> destination
+    using MarkdownLinkReferences = std::unordered_map<std::string, std::string>;
+
+    // Inline half of the Markdown engine: turns the text of one leaf block
+    // (paragraph, heading, table cell) into styled runs. Code spans,
+    // emphasis via the CommonMark delimiter algorithm, GFM strikethrough,
+    // inline and reference links, images, autolinks, escapes, entities and
+    // hard breaks. Raw inline HTML is kept as text.
+    class MarkdownInlineParser {
+    public:
+        explicit MarkdownInlineParser(const MarkdownLinkReferences& references);
+
+        void Parse(std::string_view source, MarkdownDocument& document,
+                   uint16_t cell = 0, MarkdownAlign align = MarkdownAlign::None);
+
+        // The last Parse() left a reference-shaped "[label]" as text because
+        // `references` had no such label (it may be defined further on)
+        bool MissedReference() const { return m_missedReference; }
+
+        // Backslash escapes and entities resolved, as in link destinations
+        // and code fence info strings
+        static void AppendUnescaped(std::string& out, std::string_view text);
+
+        // Case-folded, whitespace-collapsed label for reference lookups
+        static std::string NormalizeLabel(std::string_view label);
+
+        // Parse `<dest>` or a bare destination at `source[pos]`; on success
+        // `pos` moves past it and `destination` holds the raw text
+        static bool ScanDestination(std::string_view source, size_t& pos, std::string_view& destination);
+
+        // Parse a "title", 'title' or (title) at `source[pos]`
+        static bool ScanTitle(std::string_view source, size_t& pos);
+
+        static bool IsPunctuation(char c);
+        static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+    private:
+        enum class NodeKind : uint8_t { Text, Delimiter, Bracket, LinkEnd };
+
+        struct Node {
+            NodeKind kind;
+            char delimiter;           // '*', '_' or '~'
+            bool canOpen;
+            bool canClose;
+            bool image;               // Bracket opened with "!["
+            uint16_t style;           // Text: MarkdownCode / MarkdownLineBreak
+            uint16_t count;           // Delimiter characters still unmatched
+            uint16_t originalCount;
+            uint32_t textOffset;      // Text: decoded text in m_buffer
+            uint32_t textLength;
+            int32_t link;             // Bracket: index in m_links once matched
+            int32_t previousDelimiter;// Delimiter stack, as a linked list of node indices
+            int32_t nextDelimiter;
+            uint8_t opens[3];         // Strong, emphasis, strikethrough spans opened after the node's text
+            uint8_t closes[3];        // ...closed before it
+        };
+
+        struct Bracket {
+            uint32_t node;
+            size_t labelStart;        // Source offset just past '['
+            bool image;
+            bool active;
+        };
+
+        void AppendText(std::string_view text, uint16_t style = 0);
+        void AppendChar(char c) { AppendText(std::string_view(&c, 1)); }
+        void AppendLineBreak(bool hard);
+        void PushDelimiter(std::string_view source, size_t start, size_t length);
+        void ParseCodeSpan(std::string_view source, size_t& pos);
+        bool ParseAutolink(std::string_view source, size_t& pos);
+        bool ParseEntity(std::string_view source, size_t& pos);
+        void CloseBracket(std::string_view source, size_t& pos);
+        bool ParseLinkTail(std::string_view source, size_t& pos, size_t labelEnd, const Bracket& opener,
+                           std::string& destination);
+        void ProcessEmphasis(int32_t stackBottom);
+        void RemoveDelimiter(int32_t index);
+        void Flatten(MarkdownDocument& document, uint16_t cell, MarkdownAlign align);
+
+        const MarkdownLinkReferences& m_references;
+        std::vector<Node> m_nodes;
+        std::vector<Bracket> m_brackets;
+        std::vector<std::string> m_links;
+        std::string m_buffer;
+        int32_t m_lastDelimiter;
+        bool m_missedReference;
+    };
+}
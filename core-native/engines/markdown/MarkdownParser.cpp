@@ -0,0 +1,851 @@
+#include "MarkdownParser.h"
+#include <algorithm>
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        constexpr size_t CODE_INDENT = 4;
+        constexpr size_t MAX_NESTING = 32; // Deeper quotes/lists are read as text
+        constexpr size_t MAX_LABEL_LENGTH = 999;
+
+        // HTML blocks that end at a blank line (CommonMark type 6)
+        const std::string_view HTML_BLOCK_TAGS[] = {
+            "address", "article", "aside", "base", "basefont", "blockquote", "body", "caption", "center",
+            "col", "colgroup", "dd", "details", "dialog", "dir", "div", "dl", "dt", "fieldset",
+            "figcaption", "figure", "footer", "form", "frame", "frameset", "h1", "h2", "h3", "h4", "h5",
+            "h6", "head", "header", "hr", "html", "iframe", "legend", "li", "link", "main", "menu",
+            "menuitem", "nav", "noframes", "ol", "optgroup", "option", "p", "param", "picture", "section",
+            "summary", "table", "tbody", "td", "tfoot", "th", "thead", "title", "tr", "track", "ul"
+        };
+
+        // Raw-text elements whose block ends at the closing tag (type 1)
+        struct RawHtmlTag {
+            std::string_view name;
+            std::string_view end;
+        };
+        const RawHtmlTag HTML_RAW_TAGS[] = {
+            { "script", "</script>" }, { "pre", "</pre>" }, { "style", "</style>" }, { "textarea", "</textarea>" }
+        };
+
+        bool IsWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+        std::string_view Trim(std::string_view text) {
+            while (!text.empty() && IsWhitespace(text.front())) text.remove_prefix(1);
+            while (!text.empty() && IsWhitespace(text.back())) text.remove_suffix(1);
+            return text;
+        }
+
+        bool IsBlankText(std::string_view text) {
+            for (char c : text) {
+                if (!IsWhitespace(c)) return false;
+            }
+            return true;
+        }
+
+        size_t LeadingSpaces(std::string_view text) {
+            size_t i = 0;
+            while (i < text.size() && text[i] == ' ') ++i;
+            return i;
+        }
+
+        bool EqualsLower(std::string_view text, std::string_view lower) {
+            if (text.size() != lower.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < text.size(); ++i) {
+                char c = text[i];
+                if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+                if (c != lower[i]) return false;
+            }
+            return true;
+        }
+    }
+
+    size_t MarkdownParser::Line::Indent() const {
+        size_t i = pos;
+        while (i < text.size() && text[i] == ' ') ++i;
+        return i - pos;
+    }
+
+    bool MarkdownParser::Line::IsBlank() const {
+        return IsBlankText(Rest());
+    }
+
+    MarkdownParser::MarkdownParser(std::string_view source)
+        : m_inlines(m_references)
+    {
+        Reset(source);
+    }
+
+    void MarkdownParser::Reset(std::string_view source) {
+        m_source = source;
+        m_position = 0;
+        m_done = false;
+        m_blocksEmitted = 0;
+        m_document = nullptr;
+        m_collecting = false;
+        m_referencesCollected = false;
+        m_containers.clear();
+        m_leaf = LeafKind::None;
+        m_leafText.clear();
+        m_lastLineStart = 0;
+        m_pendingBlankLines = 0;
+        m_fenceChar = 0;
+        m_fenceLength = 0;
+        m_fenceIndent = 0;
+        m_fenceInfo.clear();
+        m_htmlEnd = {};
+        m_tableAligns.clear();
+        m_references.clear();
+        if (m_source.substr(0, 3) == "\xEF\xBB\xBF") {
+            m_position = 3; // UTF-8 BOM
+        }
+    }
+
+    bool MarkdownParser::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, { L".md", L".markdown" });
+    }
+
+    bool MarkdownParser::Parse(MarkdownDocument& document, size_t blockBudget) {
+        if (m_done) {
+            return false;
+        }
+
+        m_document = &document;
+        size_t target = document.blocks.size() + blockBudget;
+        while (document.blocks.size() < target && m_position < m_source.size()) {
+            NextLine();
+        }
+
+        if (m_position >= m_source.size()) {
+            CloseLeaf();
+            CloseContainersTo(0);
+            m_done = true;
+        }
+        m_document = nullptr;
+        return !m_done;
+    }
+
+    void MarkdownParser::NextLine() {
+        size_t end = m_source.find('\n', m_position);
+        size_t next = end == std::string_view::npos ? m_source.size() : end + 1;
+        std::string_view line = m_source.substr(m_position, next - m_position);
+        if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        m_position = next;
+        ProcessLine(line);
+    }
+
+    bool MarkdownParser::CollectReferences() {
+        if (m_referencesCollected || m_collecting) {
+            return false;
+        }
+        m_referencesCollected = true;
+        if (m_source.find("]:") == std::string_view::npos) {
+            return false; // No definition anywhere
+        }
+
+        // Run the block structure of the whole input again, without inline
+        // parsing, on a parser of its own; definitions are only recognised
+        // where a paragraph may start, so code blocks and HTML keep theirs
+        // literal. Its blocks go to a scratch document dropped line by line.
+        MarkdownParser lookahead(m_source);
+        MarkdownDocument scratch;
+        lookahead.m_document = &scratch;
+        lookahead.m_collecting = true;
+        while (lookahead.m_position < m_source.size()) {
+            lookahead.NextLine();
+            scratch.Clear();
+        }
+        lookahead.CloseLeaf();
+        lookahead.CloseContainersTo(0);
+
+        // Both saw the same first definitions up to here; emplace keeps ours
+        for (auto& reference : lookahead.m_references) {
+            m_references.emplace(reference.first, std::move(reference.second));
+        }
+        return true;
+    }
+
+    bool MarkdownParser::RetryWithAllReferences(size_t runCount, size_t textSize) {
+        if (!CollectReferences()) {
+            return false;
+        }
+        m_document->runs.resize(runCount);
+        m_document->text.resize(textSize);
+        return true;
+    }
+
+    void MarkdownParser::ProcessLine(std::string_view raw) {
+        // Expand tabs in the indentation and container markers, where they
+        // decide structure; tabs inside content are left alone
+        size_t prefixEnd = std::min(raw.find_first_not_of(" \t>-*+.)0123456789"), raw.size());
+        if (raw.substr(0, prefixEnd).find('\t') != std::string_view::npos) {
+            m_expanded.clear();
+            for (size_t i = 0; i < raw.size(); ++i) {
+                if (i < prefixEnd && raw[i] == '\t') {
+                    m_expanded.append(4 - m_expanded.size() % 4, ' ');
+                } else {
+                    m_expanded.push_back(raw[i]);
+                }
+            }
+            raw = m_expanded;
+        }
+
+        Line line{ raw, 0 };
+        size_t matched = 0;
+        bool allMatched = MatchContainers(line, matched);
+
+        if (allMatched && m_leaf == LeafKind::FencedCode) {
+            size_t indent = line.Indent();
+            std::string_view content = line.Rest().substr(indent);
+            size_t run = 0;
+            while (run < content.size() && content[run] == m_fenceChar) ++run;
+            if (indent < CODE_INDENT && run >= m_fenceLength && IsBlankText(content.substr(run))) {
+                CloseLeaf();
+                return;
+            }
+            m_leafText.append(line.Rest().substr(std::min(indent, m_fenceIndent)));
+            m_leafText.push_back('\n');
+            return;
+        }
+
+        if (allMatched && m_leaf == LeafKind::Html) {
+            if (m_htmlEnd.empty() && line.IsBlank()) {
+                CloseLeaf();
+                return;
+            }
+            m_leafText.append(line.Rest());
+            m_leafText.push_back('\n');
+            if (!m_htmlEnd.empty() && line.Rest().find(m_htmlEnd) != std::string_view::npos) {
+                CloseLeaf();
+            }
+            return;
+        }
+
+        if (!allMatched) {
+            // Lazy continuation: "> quoted\nstill the same paragraph"
+            if (m_leaf == LeafKind::Paragraph && !line.IsBlank() && !StartsBlock(line)) {
+                m_lastLineStart = m_leafText.size();
+                m_leafText.append(Trim(line.Rest()));
+                m_leafText.push_back('\n');
+                return;
+            }
+            CloseLeaf();
+            CloseContainersTo(matched);
+        }
+
+        OpenContainers(line);
+        ProcessLeaf(line);
+    }
+
+    bool MarkdownParser::MatchContainers(Line& line, size_t& matched) {
+        for (const Container& container : m_containers) {
+            if (container.kind == ContainerKind::Quote) {
+                size_t indent = line.Indent();
+                if (indent >= CODE_INDENT || line.At(indent) != '>') {
+                    break;
+                }
+                line.pos += indent + 1;
+                if (line.At(0) == ' ') ++line.pos;
+            } else if (!line.IsBlank()) {
+                if (line.Indent() < container.contentIndent) {
+                    break;
+                }
+                line.pos += container.contentIndent;
+            }
+            ++matched;
+        }
+        return matched == m_containers.size();
+    }
+
+    bool MarkdownParser::OpenContainers(Line& line) {
+        bool opened = false;
+        while (m_containers.size() < MAX_NESTING) {
+            size_t indent = line.Indent();
+            if (indent >= CODE_INDENT) {
+                break;
+            }
+
+            if (line.At(indent) == '>') {
+                CloseLeaf();
+                line.pos += indent + 1;
+                if (line.At(0) == ' ') ++line.pos;
+                m_containers.push_back(Container{ ContainerKind::Quote, false, 0, 0, false });
+                opened = true;
+                continue;
+            }
+
+            // "* * *" is a rule, not three nested bullets
+            if (IsThematicBreak(line.Rest())) {
+                break;
+            }
+
+            bool ordered = false;
+            uint32_t number = 0;
+            size_t width = ListMarker(line, ordered, number);
+            if (width == 0) {
+                break;
+            }
+            size_t afterMarker = indent + width;
+            char next = line.At(afterMarker);
+            if (next != ' ' && next != '\0') {
+                break;
+            }
+            size_t spaces = 0;
+            while (line.At(afterMarker + spaces) == ' ') ++spaces;
+            bool emptyItem = line.pos + afterMarker + spaces >= line.text.size();
+
+            // Only "1." or a non-empty bullet may interrupt a paragraph
+            if (m_leaf == LeafKind::Paragraph && (emptyItem || (ordered && number != 1))) {
+                break;
+            }
+            CloseLeaf();
+
+            size_t contentIndent;
+            if (emptyItem || spaces > CODE_INDENT) {
+                // Content starts one space after the marker; the rest is indented code
+                contentIndent = afterMarker + 1;
+                line.pos += emptyItem ? afterMarker + spaces : afterMarker + 1;
+            } else {
+                contentIndent = afterMarker + spaces;
+                line.pos += contentIndent;
+            }
+            m_containers.push_back(Container{ ContainerKind::ListItem, true,
+                                              static_cast<uint32_t>(contentIndent), number, ordered });
+            opened = true;
+        }
+        return opened;
+    }
+
+    void MarkdownParser::ProcessLeaf(Line& line) {
+        if (line.IsBlank()) {
+            if (m_leaf == LeafKind::Paragraph || m_leaf == LeafKind::Table) {
+                CloseLeaf();
+            } else if (m_leaf == LeafKind::IndentedCode) {
+                ++m_pendingBlankLines;
+            }
+            return;
+        }
+
+        std::string_view rest = line.Rest();
+        size_t indent = line.Indent();
+        if (indent >= CODE_INDENT && m_leaf != LeafKind::Paragraph) {
+            if (m_leaf != LeafKind::IndentedCode) {
+                CloseLeaf();
+                m_leaf = LeafKind::IndentedCode;
+            }
+            m_leafText.append(m_pendingBlankLines, '\n');
+            m_pendingBlankLines = 0;
+            m_leafText.append(rest.substr(CODE_INDENT));
+            m_leafText.push_back('\n');
+            return;
+        }
+        if (m_leaf == LeafKind::IndentedCode) {
+            CloseLeaf();
+        }
+
+        std::string_view content = rest.substr(std::min(indent, CODE_INDENT - 1));
+        if (m_leaf == LeafKind::Paragraph) {
+            if (TryStartTable(content)) {
+                return;
+            }
+            if (int level = SetextLevel(content)) {
+                ExtractReferences();
+                std::string_view text = Trim(m_leafText);
+                if (!text.empty()) {
+                    EmitInline(MarkdownBlockKind::Heading, static_cast<uint8_t>(level), text);
+                    m_leaf = LeafKind::None;
+                    m_leafText.clear();
+                    return;
+                }
+                // The paragraph was only link definitions: an ordinary line after all
+                m_leaf = LeafKind::None;
+                m_leafText.clear();
+            }
+        }
+
+        std::string_view heading;
+        if (int level = AtxHeading(content, heading)) {
+            CloseLeaf();
+            EmitInline(MarkdownBlockKind::Heading, static_cast<uint8_t>(level), heading);
+            return;
+        }
+
+        if (IsThematicBreak(content)) {
+            CloseLeaf();
+            BeginBlock(MarkdownBlockKind::ThematicBreak);
+            EndBlock();
+            return;
+        }
+
+        char fence = 0;
+        size_t fenceLength = 0;
+        if (IsFenceStart(content, fence, fenceLength)) {
+            CloseLeaf();
+            m_leaf = LeafKind::FencedCode;
+            m_fenceChar = fence;
+            m_fenceLength = fenceLength;
+            m_fenceIndent = indent;
+
+            // Only the language (first word of the info string) is kept
+            std::string_view info = Trim(content.substr(fenceLength));
+            info = info.substr(0, std::min(info.find_first_of(" \t"), info.size()));
+            MarkdownInlineParser::AppendUnescaped(m_fenceInfo, info);
+            return;
+        }
+
+        std::string_view htmlEnd;
+        if (IsHtmlStart(content, htmlEnd)) {
+            CloseLeaf();
+            m_leaf = LeafKind::Html;
+            m_htmlEnd = htmlEnd;
+            m_leafText.append(rest);
+            m_leafText.push_back('\n');
+            if (!htmlEnd.empty() && content.find(htmlEnd, 2) != std::string_view::npos) {
+                CloseLeaf();
+            }
+            return;
+        }
+
+        if (m_leaf == LeafKind::Table) {
+            EmitRow(content, false);
+            return;
+        }
+
+        if (m_leaf != LeafKind::Paragraph) {
+            CloseLeaf();
+            m_leaf = LeafKind::Paragraph;
+        }
+        m_lastLineStart = m_leafText.size();
+        m_leafText.append(content.substr(LeadingSpaces(content)));
+        m_leafText.push_back('\n');
+    }
+
+    void MarkdownParser::CloseContainersTo(size_t depth) {
+        while (m_containers.size() > depth) {
+            // An empty list item still shows its marker
+            if (m_containers.back().kind == ContainerKind::ListItem && m_containers.back().markerPending) {
+                BeginBlock(MarkdownBlockKind::Paragraph);
+                EndBlock();
+            }
+            m_containers.pop_back();
+        }
+    }
+
+    void MarkdownParser::CloseLeaf() {
+        std::string_view text = m_leafText;
+        if (!text.empty() && text.back() == '\n') {
+            text.remove_suffix(1);
+        }
+
+        switch (m_leaf) {
+        case LeafKind::Paragraph:
+            ExtractReferences();
+            text = Trim(m_leafText);
+            if (!text.empty()) {
+                EmitInline(MarkdownBlockKind::Paragraph, 0, text);
+            }
+            break;
+        case LeafKind::FencedCode:
+        case LeafKind::IndentedCode:
+            EmitVerbatim(MarkdownBlockKind::CodeBlock, text, m_fenceInfo);
+            break;
+        case LeafKind::Html:
+            EmitVerbatim(MarkdownBlockKind::HtmlBlock, text, {});
+            break;
+        case LeafKind::Table:
+        case LeafKind::None:
+            break;
+        }
+
+        m_leaf = LeafKind::None;
+        m_leafText.clear();
+        m_lastLineStart = 0;
+        m_pendingBlankLines = 0;
+        m_fenceInfo.clear();
+        m_htmlEnd = {};
+    }
+
+    bool MarkdownParser::StartsBlock(const Line& line) const {
+        size_t indent = line.Indent();
+        if (indent >= CODE_INDENT) {
+            return false;
+        }
+        std::string_view content = line.Rest().substr(indent);
+        char fence = 0;
+        size_t length = 0;
+        std::string_view ignored;
+        bool ordered = false;
+        uint32_t number = 0;
+        size_t marker = ListMarker(line, ordered, number);
+        return content[0] == '>' || IsThematicBreak(content) || AtxHeading(content, ignored) != 0 ||
+               IsFenceStart(content, fence, length) || IsHtmlStart(content, ignored) ||
+               (marker != 0 && line.At(indent + marker) == ' ');
+    }
+
+    bool MarkdownParser::IsThematicBreak(std::string_view text) {
+        size_t i = LeadingSpaces(text);
+        if (i >= CODE_INDENT || i >= text.size()) {
+            return false;
+        }
+        char marker = text[i];
+        if (marker != '-' && marker != '*' && marker != '_') {
+            return false;
+        }
+        size_t count = 0;
+        for (; i < text.size(); ++i) {
+            if (text[i] == marker) {
+                ++count;
+            } else if (text[i] != ' ' && text[i] != '\t') {
+                return false;
+            }
+        }
+        return count >= 3;
+    }
+
+    size_t MarkdownParser::ListMarker(const Line& line, bool& ordered, uint32_t& number) {
+        std::string_view text = line.Rest().substr(line.Indent());
+        if (text.empty()) {
+            return 0;
+        }
+        if (text[0] == '-' || text[0] == '+' || text[0] == '*') {
+            ordered = false;
+            number = 0;
+            return 1;
+        }
+
+        size_t digits = 0;
+        uint32_t value = 0;
+        while (digits < text.size() && digits < 9 && text[digits] >= '0' && text[digits] <= '9') {
+            value = value * 10 + static_cast<uint32_t>(text[digits] - '0');
+            ++digits;
+        }
+        if (digits == 0 || digits >= text.size() || (text[digits] != '.' && text[digits] != ')')) {
+            return 0;
+        }
+        ordered = true;
+        number = value;
+        return digits + 1;
+    }
+
+    int MarkdownParser::AtxHeading(std::string_view text, std::string_view& content) {
+        size_t level = 0;
+        while (level < text.size() && text[level] == '#') ++level;
+        if (level == 0 || level > 6 || (level < text.size() && text[level] != ' ' && text[level] != '\t')) {
+            return 0;
+        }
+
+        content = Trim(text.substr(level));
+        // Optional closing run of '#', which must follow a space
+        size_t end = content.size();
+        while (end > 0 && content[end - 1] == '#') --end;
+        if (end == 0) {
+            content = {};
+        } else if (end < content.size() && (content[end - 1] == ' ' || content[end - 1] == '\t')) {
+            content = Trim(content.substr(0, end));
+        }
+        return static_cast<int>(level);
+    }
+
+    bool MarkdownParser::IsFenceStart(std::string_view text, char& fence, size_t& length) {
+        if (text.empty() || (text[0] != '`' && text[0] != '~')) {
+            return false;
+        }
+        size_t run = 0;
+        while (run < text.size() && text[run] == text[0]) ++run;
+        if (run < 3) {
+            return false;
+        }
+        // A backtick fence's info string cannot contain backticks (it would be a code span)
+        if (text[0] == '`' && text.find('`', run) != std::string_view::npos) {
+            return false;
+        }
+        fence = text[0];
+        length = run;
+        return true;
+    }
+
+    bool MarkdownParser::IsHtmlStart(std::string_view text, std::string_view& endMarker) {
+        if (text.size() < 2 || text[0] != '<') {
+            return false;
+        }
+        if (text.substr(0, 4) == "<!--") {
+            endMarker = "-->";
+            return true;
+        }
+        if (text[1] == '?') {
+            endMarker = "?>";
+            return true;
+        }
+        if (text.substr(0, 9) == "<![CDATA[") {
+            endMarker = "]]>";
+            return true;
+        }
+        if (text[1] == '!' && text.size() > 2 && ((text[2] >= 'A' && text[2] <= 'Z') || (text[2] >= 'a' && text[2] <= 'z'))) {
+            endMarker = ">";
+            return true;
+        }
+
+        size_t start = text[1] == '/' ? 2 : 1;
+        size_t end = start;
+        while (end < text.size() && end - start < 16 &&
+               ((text[end] >= 'a' && text[end] <= 'z') || (text[end] >= 'A' && text[end] <= 'Z') ||
+                (text[end] >= '0' && text[end] <= '9'))) {
+            ++end;
+        }
+        if (end == start) {
+            return false;
+        }
+        std::string_view name = text.substr(start, end - start);
+        char after = end < text.size() ? text[end] : ' ';
+
+        if (start == 1 && (after == ' ' || after == '\t' || after == '>')) {
+            for (const auto& raw : HTML_RAW_TAGS) {
+                if (EqualsLower(name, raw.name)) {
+                    endMarker = raw.end;
+                    return true;
+                }
+            }
+        }
+        if (after == ' ' || after == '\t' || after == '>' || text.substr(end, 2) == "/>") {
+            for (std::string_view tag : HTML_BLOCK_TAGS) {
+                if (EqualsLower(name, tag)) {
+                    endMarker = {};
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    int MarkdownParser::SetextLevel(std::string_view text) {
+        if (text.empty() || (text[0] != '=' && text[0] != '-')) {
+            return 0;
+        }
+        size_t run = 0;
+        while (run < text.size() && text[run] == text[0]) ++run;
+        if (!IsBlankText(text.substr(run))) {
+            return 0;
+        }
+        return text[0] == '=' ? 1 : 2;
+    }
+
+    void MarkdownParser::SplitCells(std::string_view row, std::vector<std::string_view>& cells) {
+        cells.clear();
+        row = Trim(row);
+        if (!row.empty() && row.front() == '|') {
+            row.remove_prefix(1);
+        }
+        if (!row.empty() && row.back() == '|' && (row.size() < 2 || row[row.size() - 2] != '\\')) {
+            row.remove_suffix(1);
+        }
+
+        size_t start = 0;
+        for (size_t i = 0; i < row.size(); ++i) {
+            if (row[i] == '\\') {
+                ++i; // "\|" stays in the cell for the inline parser to unescape
+            } else if (row[i] == '|') {
+                cells.push_back(row.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        cells.push_back(row.substr(start));
+    }
+
+    bool MarkdownParser::ParseDelimiterRow(std::string_view row, std::vector<MarkdownAlign>& aligns) {
+        // Cheap rejection first: this runs for every paragraph continuation line
+        if (row.find('-') == std::string_view::npos || row.find_first_not_of(" \t|:-") != std::string_view::npos) {
+            return false;
+        }
+
+        std::vector<std::string_view> cells;
+        SplitCells(row, cells);
+        aligns.clear();
+        for (std::string_view cell : cells) {
+            cell = Trim(cell);
+            bool left = !cell.empty() && cell.front() == ':';
+            bool right = cell.size() > 1 && cell.back() == ':';
+            std::string_view dashes = cell.substr(left ? 1 : 0, cell.size() - (left ? 1 : 0) - (right ? 1 : 0));
+            if (dashes.empty() || dashes.find_first_not_of('-') != std::string_view::npos) {
+                return false;
+            }
+            aligns.push_back(left && right ? MarkdownAlign::Center
+                             : right ? MarkdownAlign::Right
+                             : left ? MarkdownAlign::Left
+                             : MarkdownAlign::None);
+        }
+        return true;
+    }
+
+    bool MarkdownParser::TryStartTable(std::string_view delimiterRow) {
+        std::string_view header = std::string_view(m_leafText).substr(m_lastLineStart);
+        if (!header.empty() && header.back() == '\n') {
+            header.remove_suffix(1);
+        }
+        if (delimiterRow.find('|') == std::string_view::npos && header.find('|') == std::string_view::npos) {
+            return false;
+        }
+        std::vector<MarkdownAlign> aligns;
+        if (!ParseDelimiterRow(delimiterRow, aligns)) {
+            return false;
+        }
+        SplitCells(header, m_cells);
+        if (m_cells.size() != aligns.size()) {
+            return false;
+        }
+
+        // Lines before the header row stay a paragraph of their own
+        std::string headerRow(header);
+        m_leafText.resize(m_lastLineStart);
+        CloseLeaf();
+
+        m_tableAligns = std::move(aligns);
+        EmitRow(headerRow, true);
+        m_leaf = LeafKind::Table;
+        return true;
+    }
+
+    void MarkdownParser::ExtractReferences() {
+        std::string_view text = m_leafText;
+        size_t pos = 0;
+        while (pos < text.size() && text[pos] == '[') {
+            // [label]: destination "optional title"
+            size_t close = pos + 1;
+            while (close < text.size() && text[close] != ']' && text[close] != '[') {
+                close += text[close] == '\\' ? 2 : 1;
+            }
+            if (close >= text.size() || text[close] != ']' || close - pos - 1 > MAX_LABEL_LENGTH ||
+                close + 1 >= text.size() || text[close + 1] != ':') {
+                break;
+            }
+            std::string_view label = text.substr(pos + 1, close - pos - 1);
+            if (IsBlankText(label)) {
+                break;
+            }
+
+            size_t p = close + 2;
+            while (p < text.size() && IsWhitespace(text[p])) ++p;
+            std::string_view destination;
+            if (!MarkdownInlineParser::ScanDestination(text, p, destination)) {
+                break;
+            }
+
+            size_t end = std::string_view::npos;
+            size_t q = p;
+            while (q < text.size() && IsWhitespace(text[q])) ++q;
+            if (q > p && MarkdownInlineParser::ScanTitle(text, q)) {
+                while (q < text.size() && (text[q] == ' ' || text[q] == '\t')) ++q;
+                if (q >= text.size() || text[q] == '\n') end = q;
+            }
+            if (end == std::string_view::npos) {
+                // No usable title: the destination must end its line
+                q = p;
+                while (q < text.size() && (text[q] == ' ' || text[q] == '\t')) ++q;
+                if (q < text.size() && text[q] != '\n') {
+                    break;
+                }
+                end = q;
+            }
+
+            // The first definition of a label wins
+            std::string key = MarkdownInlineParser::NormalizeLabel(label);
+            if (m_references.find(key) == m_references.end()) {
+                std::string resolved;
+                MarkdownInlineParser::AppendUnescaped(resolved, destination);
+                m_references.emplace(std::move(key), std::move(resolved));
+            }
+            pos = end < text.size() ? end + 1 : text.size();
+        }
+        m_leafText.erase(0, pos);
+    }
+
+    MarkdownBlock& MarkdownParser::BeginBlock(MarkdownBlockKind kind) {
+        MarkdownBlock block{};
+        block.kind = kind;
+        for (const Container& container : m_containers) {
+            if (container.kind == ContainerKind::Quote) {
+                ++block.quoteDepth;
+            } else {
+                ++block.listDepth;
+            }
+        }
+
+        // The innermost new item draws its marker; "- - a" shows one bullet
+        for (auto it = m_containers.rbegin(); it != m_containers.rend(); ++it) {
+            if (it->kind == ContainerKind::ListItem && it->markerPending) {
+                block.listItemStart = true;
+                block.listOrdered = it->ordered;
+                block.listNumber = it->number;
+                break;
+            }
+        }
+        for (Container& container : m_containers) {
+            container.markerPending = false;
+        }
+
+        block.firstRun = static_cast<uint32_t>(m_document->runs.size());
+        m_document->blocks.push_back(block);
+        ++m_blocksEmitted;
+        return m_document->blocks.back();
+    }
+
+    void MarkdownParser::EndBlock() {
+        MarkdownBlock& block = m_document->blocks.back();
+        block.runCount = static_cast<uint32_t>(m_document->runs.size()) - block.firstRun;
+    }
+
+    void MarkdownParser::EmitInline(MarkdownBlockKind kind, uint8_t level, std::string_view text) {
+        BeginBlock(kind).level = level;
+        if (!m_collecting) {
+            size_t runCount = m_document->runs.size();
+            size_t textSize = m_document->text.size();
+            m_inlines.Parse(text, *m_document);
+            if (m_inlines.MissedReference() && RetryWithAllReferences(runCount, textSize)) {
+                m_inlines.Parse(text, *m_document);
+            }
+        }
+        EndBlock();
+    }
+
+    void MarkdownParser::EmitVerbatim(MarkdownBlockKind kind, std::string_view text, std::string_view info) {
+        MarkdownBlock& block = BeginBlock(kind);
+        MarkdownDocument& document = *m_document;
+        if (!info.empty()) {
+            block.infoOffset = static_cast<uint32_t>(document.text.size());
+            block.infoLength = static_cast<uint32_t>(info.size());
+            document.text.append(info);
+        }
+
+        MarkdownRun run{};
+        run.textOffset = static_cast<uint32_t>(document.text.size());
+        run.textLength = static_cast<uint32_t>(text.size());
+        run.style = MarkdownCode;
+        document.text.append(text);
+        document.runs.push_back(run);
+        EndBlock();
+    }
+
+    void MarkdownParser::EmitRow(std::string_view row, bool header) {
+        SplitCells(row, m_cells);
+        MarkdownBlock& block = BeginBlock(MarkdownBlockKind::TableRow);
+        block.tableHeader = header;
+        block.cellCount = static_cast<uint16_t>(std::min<size_t>(m_tableAligns.size(), UINT16_MAX));
+
+        // Extra cells are dropped, missing ones left empty
+        auto parseCells = [&] {
+            bool missed = false;
+            for (size_t i = 0; i < block.cellCount && i < m_cells.size(); ++i) {
+                m_inlines.Parse(Trim(m_cells[i]), *m_document, static_cast<uint16_t>(i), m_tableAligns[i]);
+                missed = missed || m_inlines.MissedReference();
+            }
+            return missed;
+        };
+        size_t runCount = m_document->runs.size();
+        size_t textSize = m_document->text.size();
+        if (!m_collecting && parseCells() && RetryWithAllReferences(runCount, textSize)) {
+            parseCells();
+        }
+        EndBlock();
+    }
+}
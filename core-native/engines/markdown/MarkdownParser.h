@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MarkdownDocument.h"
+#include "MarkdownInlines.h"
+
+namespace Lumos {
+    // Streaming CommonMark block parser with GFM tables and strikethrough.
+    // Input is consumed line by line and each block is emitted as soon as it
+    // is closed, so the first screenful of a multi-megabyte README is ready
+    // after parsing only that much of it. A reference link whose definition
+    // has not been seen yet costs one block-only pass over the whole input
+    // to collect every definition; files without one never pay it.
+    class MarkdownParser {
+    public:
+        // `source` (UTF-8, normally a mapped file) must outlive the parser
+        explicit MarkdownParser(std::string_view source);
+
+        MarkdownParser(const MarkdownParser&) = delete;
+        MarkdownParser& operator=(const MarkdownParser&) = delete;
+
+        // Start over on another source, keeping the buffers grown so far
+        void Reset(std::string_view source);
+
+        // Append blocks to `document` until it has `blockBudget` more or the
+        // input is exhausted. Returns true while there is more to parse.
+        bool Parse(MarkdownDocument& document, size_t blockBudget);
+
+        // Extensions MarkdownRenderer accepts (case-insensitive)
+        static bool HandlesExtension(std::wstring_view extension);
+
+        bool Done() const { return m_done; }
+        size_t BytesConsumed() const { return m_position; }
+        uint64_t BlocksEmitted() const { return m_blocksEmitted; }
+
+    private:
+        enum class ContainerKind : uint8_t { Quote, ListItem };
+
+        struct Container {
+            ContainerKind kind;
+            bool markerPending;      // ListItem: no block emitted yet
+            uint32_t contentIndent;  // ListItem: columns its content is indented by
+            uint32_t number;         // ListItem: ordered number
+            bool ordered;
+        };
+
+        enum class LeafKind : uint8_t { None, Paragraph, FencedCode, IndentedCode, Html, Table };
+
+        // One input line with block prefixes consumed as we go. Tabs in the
+        // indentation are expanded up front, so columns are bytes.
+        struct Line {
+            std::string_view text;
+            size_t pos;
+
+            size_t Indent() const;
+            bool IsBlank() const;
+            std::string_view Rest() const { return text.substr(pos); }
+            char At(size_t offset) const { return pos + offset < text.size() ? text[pos + offset] : '\0'; }
+        };
+
+        void NextLine();
+        bool CollectReferences();
+        bool RetryWithAllReferences(size_t runCount, size_t textSize);
+        void ProcessLine(std::string_view raw);
+        bool MatchContainers(Line& line, size_t& matched);
+        bool OpenContainers(Line& line);
+        void ProcessLeaf(Line& line);
+        void CloseContainersTo(size_t depth);
+        void CloseLeaf();
+
+        bool StartsBlock(const Line& line) const;
+        static bool IsThematicBreak(std::string_view text);
+        static size_t ListMarker(const Line& line, bool& ordered, uint32_t& number);
+        static int AtxHeading(std::string_view text, std::string_view& content);
+        static bool IsFenceStart(std::string_view text, char& fence, size_t& length);
+        static bool IsHtmlStart(std::string_view text, std::string_view& endMarker);
+        static int SetextLevel(std::string_view text);
+        static void SplitCells(std::string_view row, std::vector<std::string_view>& cells);
+        static bool ParseDelimiterRow(std::string_view row, std::vector<MarkdownAlign>& aligns);
+
+        bool TryStartTable(std::string_view delimiterRow);
+        void ExtractReferences();
+
+        MarkdownBlock& BeginBlock(MarkdownBlockKind kind);
+        void EndBlock();
+        void EmitInline(MarkdownBlockKind kind, uint8_t level, std::string_view text);
+        void EmitVerbatim(MarkdownBlockKind kind, std::string_view text, std::string_view info);
+        void EmitRow(std::string_view row, bool header);
+
+        std::string_view m_source;
+        size_t m_position;
+        bool m_done;
+        uint64_t m_blocksEmitted;
+        MarkdownDocument* m_document;
+        bool m_collecting;               // Lookahead of CollectReferences(): no inlines
+        bool m_referencesCollected;      // Every definition in the file is known
+
+        std::vector<Container> m_containers;
+
+        LeafKind m_leaf;
+        std::string m_leafText;          // Paragraph / code / HTML lines joined by '\n'
+        size_t m_lastLineStart;          // Paragraph: where its last line begins in m_leafText
+        size_t m_pendingBlankLines;      // IndentedCode: blanks kept only if more code follows
+        char m_fenceChar;
+        size_t m_fenceLength;
+        size_t m_fenceIndent;
+        std::string m_fenceInfo;
+        std::string_view m_htmlEnd;      // Empty: HTML block ends at a blank line
+        std::vector<MarkdownAlign> m_tableAligns;
+
+        std::string m_expanded;          // Line with indentation tabs expanded
+        std::vector<std::string_view> m_cells;
+
+        MarkdownLinkReferences m_references;
+        MarkdownInlineParser m_inlines;
+    };
+}
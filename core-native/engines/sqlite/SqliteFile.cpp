@@ -0,0 +1,710 @@
+#include "SqliteFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include "SqliteTableSql.h"
+#include "../../common/Json.h"
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        const uint8_t MAGIC[16] = {'S', 'Q', 'L', 'i', 't', 'e', ' ', 'f', 'o', 'r', 'm', 'a', 't', ' ', '3', 0};
+
+        constexpr size_t HEADER_SIZE = 100;
+
+        // B-tree page types
+        constexpr uint8_t INDEX_INTERIOR = 2;
+        constexpr uint8_t TABLE_INTERIOR = 5;
+        constexpr uint8_t INDEX_LEAF = 10;
+        constexpr uint8_t TABLE_LEAF = 13;
+
+        // A blob cell shows this much hex; the rest is only counted
+        constexpr size_t BLOB_PREVIEW_BYTES = 32;
+
+        // Record headers list one varint per column; SQLite allows at most 32767
+        constexpr uint64_t MAX_RECORD_HEADER = 32767 * 9 + 9;
+
+        // Big-endian base-128, at most 9 bytes, the ninth contributing all 8 bits
+        bool ReadVarint(ByteView bytes, size_t& offset, uint64_t& value) {
+            value = 0;
+            for (size_t i = 0; i < 9; ++i) {
+                if (!bytes.Has(offset, 1)) {
+                    return false;
+                }
+                uint8_t byte = bytes.U8(offset++);
+                if (i == 8) {
+                    value = (value << 8) | byte;
+                    return true;
+                }
+                value = (value << 7) | (byte & 0x7F);
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return true;
+        }
+
+        // Bytes a serial type occupies in the record body
+        uint64_t SerialTypeSize(uint64_t serialType) {
+            static const uint8_t SIZES[12] = {0, 1, 2, 3, 4, 6, 8, 8, 0, 0, 0, 0};
+            return serialType < 12 ? SIZES[serialType] : (serialType - 12) / 2;
+        }
+
+        void AppendCodePoint(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        const char* EncodingName(SqliteTextEncoding encoding) {
+            switch (encoding) {
+            case SqliteTextEncoding::Utf16le: return "UTF-16le";
+            case SqliteTextEncoding::Utf16be: return "UTF-16be";
+            default: return "UTF-8";
+            }
+        }
+
+        // What the sqlite3 shell would print for the value
+        void AppendCell(std::pmr::string& out, const SqliteValue& value) {
+            static const char HEX[] = "0123456789abcdef";
+            char buffer[32];
+
+            switch (value.type) {
+            case SqliteValueType::Null:
+                out.append("null");
+                break;
+            case SqliteValueType::Integer: {
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.integer);
+                out.push_back('"');
+                out.append(buffer, result.ptr);
+                out.push_back('"');
+                break;
+            }
+            case SqliteValueType::Real: {
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.real);
+                std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+                out.push_back('"');
+                out.append(text);
+                // 3.0 rather than 3, so reals still look like reals
+                if (text.find_first_of(".eEn") == std::string_view::npos) {
+                    out.append(".0");
+                }
+                out.push_back('"');
+                break;
+            }
+            case SqliteValueType::Text:
+                if (value.truncated) {
+                    std::pmr::string text(out.get_allocator());
+                    text.reserve(value.bytes.size() + 3);
+                    text.append(value.bytes);
+                    text.append("\xE2\x80\xA6");
+                    AppendJsonString(out, text);
+                } else {
+                    AppendJsonString(out, value.bytes);
+                }
+                break;
+            case SqliteValueType::Blob: {
+                out.append("\"x'");
+                for (unsigned char byte : value.bytes) {
+                    out.push_back(HEX[byte >> 4]);
+                    out.push_back(HEX[byte & 0xF]);
+                }
+                out.append(value.truncated ? "\xE2\x80\xA6' (" : "' (");
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.size);
+                out.append(buffer, result.ptr);
+                out.append(value.size == 1 ? " byte)\"" : " bytes)\"");
+                break;
+            }
+            }
+        }
+
+        // Column DEFAULT for rows written before ALTER TABLE ADD COLUMN
+        SqliteValue DefaultValue(const SqliteColumn& column) {
+            SqliteValue value;
+            if (!column.hasDefault) {
+                return value;
+            }
+            const std::string& literal = column.defaultLiteral;
+            if (!column.defaultIsText) {
+                int64_t integer = 0;
+                auto result = std::from_chars(literal.data(), literal.data() + literal.size(), integer);
+                if (result.ec == std::errc() && result.ptr == literal.data() + literal.size()) {
+                    value.type = SqliteValueType::Integer;
+                    value.integer = integer;
+                    return value;
+                }
+                double real = 0;
+                auto realResult = std::from_chars(literal.data(), literal.data() + literal.size(), real);
+                if (realResult.ec == std::errc() && realResult.ptr == literal.data() + literal.size()) {
+                    value.type = SqliteValueType::Real;
+                    value.real = real;
+                    return value;
+                }
+            }
+            value.type = SqliteValueType::Text;
+            value.bytes = literal.substr(0, SqliteFile::MAX_VALUE_BYTES);
+            value.truncated = literal.size() > SqliteFile::MAX_VALUE_BYTES;
+            value.size = literal.size();
+            return value;
+        }
+    }
+
+    void SqliteSchema::WriteJson(std::pmr::string& out) const {
+        out.append("{\"encoding\":\"");
+        out.append(EncodingName(header.encoding));
+        out.append("\",\"wal\":");
+        out.append(header.walMode ? "true" : "false");
+        out.append(",\"autoVacuum\":");
+        out.append(header.autoVacuum ? "true" : "false");
+        AppendField(out, "pageSize", header.pageSize);
+        AppendField(out, "pageCount", header.pageCount);
+        AppendField(out, "freelistPages", header.freelistPages);
+        AppendField(out, "userVersion", header.userVersion);
+        AppendField(out, "applicationId", header.applicationId);
+        AppendField(out, "sqliteVersion", header.sqliteVersion);
+        out.append(",\"objects\":[");
+        for (size_t i = 0; i < objects.size(); ++i) {
+            const SqliteObject& object = objects[i];
+            out.append(i == 0 ? "{\"type\":" : ",{\"type\":");
+            AppendJsonString(out, object.type);
+            out.append(",\"name\":");
+            AppendJsonString(out, object.name);
+            out.append(",\"tableName\":");
+            AppendJsonString(out, object.tableName);
+            AppendField(out, "rootPage", object.rootPage);
+            out.append(",\"sql\":");
+            AppendJsonString(out, object.sql);
+            out.push_back('}');
+        }
+        out.append("]}");
+    }
+
+    void SqliteRows::WriteJson(std::pmr::string& out) const {
+        out.append("{\"name\":");
+        AppendJsonString(out, table);
+        AppendField(out, "firstRow", firstRow);
+        out.append(",\"columns\":[");
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (c != 0) {
+                out.push_back(',');
+            }
+            AppendJsonString(out, columns[c]);
+        }
+        out.append("],\"rows\":[");
+        for (size_t r = 0; r < rowCount; ++r) {
+            out.append(r == 0 ? "[" : ",[");
+            for (size_t c = 0; c < columns.size(); ++c) {
+                if (c != 0) {
+                    out.push_back(',');
+                }
+                AppendCell(out, values[r * columns.size() + c]);
+            }
+            out.push_back(']');
+        }
+        out.append("],\"more\":");
+        out.append(more ? "true" : "false");
+        out.push_back('}');
+    }
+
+    SqliteFile::SqliteFile(ByteView data)
+        : m_data(data)
+        , m_valid(false)
+    {
+        if (!data.Matches(0, MAGIC, sizeof(MAGIC)) || !data.Has(0, HEADER_SIZE)) {
+            return;
+        }
+
+        uint32_t pageSize = data.U16BE(16);
+        if (pageSize == 1) {
+            pageSize = 65536;
+        }
+        if (pageSize < 512 || pageSize > 65536 || (pageSize & (pageSize - 1)) != 0) {
+            return;
+        }
+        uint32_t reserved = data.U8(20);
+        if (pageSize - reserved < 480) {
+            return;
+        }
+
+        m_header.pageSize = pageSize;
+        m_header.usableSize = pageSize - reserved;
+        m_header.walMode = data.U8(18) == 2 || data.U8(19) == 2;
+
+        // The in-header size is only current if the last writer knew about it
+        uint64_t filePages = data.Size() / pageSize;
+        uint32_t headerPages = data.U32BE(28);
+        bool headerPagesValid = headerPages != 0 && data.U32BE(24) == data.U32BE(92);
+        uint64_t pageCount = headerPagesValid && headerPages < filePages ? headerPages : filePages;
+        m_header.pageCount = static_cast<uint32_t>(std::min<uint64_t>(pageCount, UINT32_MAX));
+
+        m_header.freelistPages = data.U32BE(36);
+        m_header.schemaCookie = data.U32BE(40);
+        m_header.schemaFormat = data.U32BE(44);
+        m_header.autoVacuum = data.U32BE(52) != 0;
+        uint32_t encoding = data.U32BE(56);
+        m_header.encoding = encoding == 2 ? SqliteTextEncoding::Utf16le
+                          : encoding == 3 ? SqliteTextEncoding::Utf16be
+                          : SqliteTextEncoding::Utf8;
+        m_header.userVersion = data.U32BE(60);
+        m_header.applicationId = data.U32BE(68);
+        m_header.sqliteVersion = data.U32BE(96);
+
+        m_valid = m_header.pageCount != 0;
+    }
+
+    bool SqliteFile::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, { L".db", L".sqlite", L".sqlite3", L".db3", L".s3db", L".sl3" });
+    }
+
+    bool SqliteFile::ReadSchema(SqliteSchema& schema) const {
+        schema.header = m_header;
+        schema.objects.clear();
+        if (!m_valid) {
+            return false;
+        }
+
+        // sqlite_schema(type, name, tbl_name, rootpage, sql) is the table rooted at page 1
+        std::vector<SqliteValue> fields;
+        bool complete = Walk(1, 0, [&](const Cell& cell) {
+            if (!ReadRecord(cell.payload, 5, MAX_SQL_BYTES, fields) || fields.size() < 5) {
+                return true;
+            }
+            SqliteObject object;
+            object.type = std::move(fields[0].bytes);
+            object.name = std::move(fields[1].bytes);
+            object.tableName = std::move(fields[2].bytes);
+            if (fields[3].type == SqliteValueType::Integer && fields[3].integer > 0 &&
+                fields[3].integer <= static_cast<int64_t>(m_header.pageCount)) {
+                object.rootPage = static_cast<uint32_t>(fields[3].integer);
+            }
+            object.sql = std::move(fields[4].bytes);
+            schema.objects.push_back(std::move(object));
+            return schema.objects.size() < MAX_SCHEMA_OBJECTS;
+        });
+        return complete;
+    }
+
+    bool SqliteFile::ReadRows(const SqliteObject& table, uint64_t firstRow, size_t count, SqliteRows& rows) const {
+        rows.table = table.name;
+        rows.firstRow = firstRow;
+        rows.columns.clear();
+        rows.values.clear();
+        rows.rowCount = 0;
+        rows.more = false;
+        if (!m_valid || table.rootPage == 0) {
+            return false;
+        }
+
+        bool isTable = table.type == "table";
+        SqliteTableSql layout = isTable ? SqliteTableSql::Parse(table.sql) : SqliteTableSql();
+        bool rowidTree = isTable && !layout.withoutRowid;
+
+        // Record field -> column shown; virtual generated columns are not in
+        // the file, so they are not shown either
+        std::vector<size_t> storage = layout.StorageOrder();
+        std::vector<size_t> shownIndex(layout.columns.size(), SIZE_MAX);
+        for (size_t c = 0; c < layout.columns.size(); ++c) {
+            if (!layout.columns[c].virtualGenerated) {
+                shownIndex[c] = rows.columns.size();
+                rows.columns.push_back(layout.columns[c].name);
+            }
+        }
+        bool numbered = rows.columns.empty();
+
+        std::vector<SqliteValue> fields;
+        bool complete = Walk(table.rootPage, firstRow, [&](const Cell& cell) {
+            if (rows.rowCount == count) {
+                rows.more = true;
+                return false;
+            }
+            if (!ReadRecord(cell.payload, numbered ? SIZE_MAX : storage.size(), MAX_VALUE_BYTES, fields)) {
+                fields.clear();
+            }
+
+            // Without a usable CREATE TABLE the first record decides the columns
+            if (numbered && rows.rowCount == 0) {
+                for (size_t f = 0; f < fields.size(); ++f) {
+                    rows.columns.push_back("column" + std::to_string(f + 1));
+                }
+            }
+
+            size_t base = rows.values.size();
+            rows.values.resize(base + rows.columns.size());
+            if (numbered) {
+                for (size_t f = 0; f < fields.size() && f < rows.columns.size(); ++f) {
+                    rows.values[base + f] = std::move(fields[f]);
+                }
+            } else {
+                for (size_t f = 0; f < storage.size(); ++f) {
+                    const SqliteColumn& column = layout.columns[storage[f]];
+                    SqliteValue& value = rows.values[base + shownIndex[storage[f]]];
+                    if (rowidTree && column.rowidAlias) {
+                        value.type = SqliteValueType::Integer;
+                        value.integer = cell.rowid;
+                    } else if (f < fields.size()) {
+                        value = std::move(fields[f]);
+                    } else {
+                        value = DefaultValue(column);
+                    }
+                    // SQLite stores 3.0 as 3 to save space and converts back on read
+                    if (column.realAffinity && value.type == SqliteValueType::Integer) {
+                        value.type = SqliteValueType::Real;
+                        value.real = static_cast<double>(value.integer);
+                    }
+                }
+            }
+            ++rows.rowCount;
+            return true;
+        });
+        return complete;
+    }
+
+    ByteView SqliteFile::Page(uint32_t number) const {
+        if (number == 0 || number > m_header.pageCount) {
+            return ByteView();
+        }
+        return m_data.Sub(static_cast<size_t>(number - 1) * m_header.pageSize, m_header.pageSize);
+    }
+
+    // In-order walk of the b-tree at `root`: table b-trees yield their leaf
+    // cells in rowid order, index b-trees interleave interior entries
+    // between their children. The first `skip` entries are passed over;
+    // whole leaves are skipped on their cell count alone.
+    bool SqliteFile::Walk(uint32_t root, uint64_t skip, const CellVisitor& visit) const {
+        struct Frame {
+            ByteView page;
+            size_t header;     // Offset of the page header (100 on page 1)
+            uint8_t type;
+            uint16_t cellCount;
+            uint32_t step;     // Next child or entry to visit
+        };
+
+        std::vector<Frame> stack;
+        stack.reserve(MAX_TREE_DEPTH);
+        uint64_t pagesVisited = 0;
+        bool indexTree = false;
+
+        auto descend = [&](uint32_t number) {
+            ByteView page = Page(number);
+            if (page.Empty() || stack.size() == MAX_TREE_DEPTH || ++pagesVisited > m_header.pageCount) {
+                return false;
+            }
+            size_t header = number == 1 ? HEADER_SIZE : 0;
+            uint8_t type = page.U8(header);
+            bool interior = type == INDEX_INTERIOR || type == TABLE_INTERIOR;
+            bool leaf = type == INDEX_LEAF || type == TABLE_LEAF;
+            if (!interior && !leaf) {
+                return false;
+            }
+            bool isIndex = type == INDEX_INTERIOR || type == INDEX_LEAF;
+            if (stack.empty()) {
+                indexTree = isIndex;
+            } else if (isIndex != indexTree) {
+                return false;
+            }
+            uint16_t cellCount = page.U16BE(header + 3);
+            if (!page.Has(header + (interior ? 12 : 8), static_cast<size_t>(cellCount) * 2)) {
+                return false;
+            }
+            stack.push_back({page, header, type, cellCount, 0});
+            return true;
+        };
+
+        auto cellOffset = [](const Frame& frame, size_t index) {
+            size_t pointers = frame.header + (frame.type == INDEX_LEAF || frame.type == TABLE_LEAF ? 8 : 12);
+            return static_cast<size_t>(frame.page.U16BE(pointers + index * 2));
+        };
+
+        if (!descend(root)) {
+            return false;
+        }
+
+        Cell cell;
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+
+            if (frame.type == TABLE_LEAF || frame.type == INDEX_LEAF) {
+                if (skip >= frame.cellCount) {
+                    skip -= frame.cellCount;
+                    stack.pop_back();
+                    continue;
+                }
+                for (size_t i = static_cast<size_t>(skip); i < frame.cellCount; ++i) {
+                    if (!ParseCell(frame.page, frame.type, cellOffset(frame, i), cell)) {
+                        return false;
+                    }
+                    if (!visit(cell)) {
+                        return true;
+                    }
+                }
+                skip = 0;
+                stack.pop_back();
+                continue;
+            }
+
+            // Interior pages: table b-trees only route, index b-trees also
+            // hold an entry between each pair of children
+            uint32_t children = frame.cellCount + 1u;
+            uint32_t steps = frame.type == INDEX_INTERIOR ? children + frame.cellCount : children;
+            if (frame.step >= steps) {
+                stack.pop_back();
+                continue;
+            }
+
+            uint32_t step = frame.step++;
+            bool isEntry = frame.type == INDEX_INTERIOR && (step & 1) != 0;
+            size_t index = frame.type == INDEX_INTERIOR ? step / 2 : step;
+
+            if (isEntry) {
+                if (skip > 0) {
+                    --skip;
+                    continue;
+                }
+                if (!ParseCell(frame.page, frame.type, cellOffset(frame, index), cell)) {
+                    return false;
+                }
+                if (!visit(cell)) {
+                    return true;
+                }
+                continue;
+            }
+
+            uint32_t child = index < frame.cellCount
+                ? frame.page.U32BE(cellOffset(frame, index))
+                : frame.page.U32BE(frame.header + 8);
+            if (!descend(child)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SqliteFile::ParseCell(ByteView page, uint8_t pageType, size_t offset, Cell& cell) const {
+        if (offset >= page.Size()) {
+            return false;
+        }
+
+        cell = Cell();
+        if (pageType == INDEX_INTERIOR) {
+            offset += 4;  // Left child
+        }
+        uint64_t payloadSize = 0;
+        if (!ReadVarint(page, offset, payloadSize)) {
+            return false;
+        }
+        if (pageType == TABLE_LEAF) {
+            uint64_t rowid = 0;
+            if (!ReadVarint(page, offset, rowid)) {
+                return false;
+            }
+            cell.rowid = static_cast<int64_t>(rowid);
+        }
+
+        size_t local = LocalPayloadSize(payloadSize, pageType == TABLE_LEAF);
+        bool spills = local < payloadSize;
+        if (!page.Has(offset, local + (spills ? 4 : 0))) {
+            return false;
+        }
+        cell.payload.local = page.Sub(offset, local);
+        cell.payload.size = payloadSize;
+        cell.payload.overflow = spills ? page.U32BE(offset + local) : 0;
+        return true;
+    }
+
+    // How much of a payload stays on the b-tree page; the rest goes to overflow pages
+    size_t SqliteFile::LocalPayloadSize(uint64_t payloadSize, bool tableLeaf) const {
+        uint64_t usable = m_header.usableSize;
+        uint64_t maxLocal = tableLeaf ? usable - 35 : (usable - 12) * 64 / 255 - 23;
+        if (payloadSize <= maxLocal) {
+            return static_cast<size_t>(payloadSize);
+        }
+        uint64_t minLocal = (usable - 12) * 32 / 255 - 23;
+        uint64_t local = minLocal + (payloadSize - minLocal) % (usable - 4);
+        return static_cast<size_t>(local <= maxLocal ? local : minLocal);
+    }
+
+    // Append payload bytes [offset, offset + length) to `out`, following the
+    // overflow chain as far as needed. False if the chain is broken.
+    bool SqliteFile::CopyPayload(const Payload& payload, uint64_t offset, size_t length, std::string& out) const {
+        if (offset > payload.size || length > payload.size - offset) {
+            return false;
+        }
+
+        size_t localSize = payload.local.Size();
+        if (offset < localSize) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(length, localSize - offset));
+            out.append(reinterpret_cast<const char*>(payload.local.Data() + offset), take);
+            offset += take;
+            length -= take;
+        }
+        if (length == 0) {
+            return true;
+        }
+
+        // Each overflow page: next page number, then usableSize - 4 bytes of payload
+        uint64_t perPage = m_header.usableSize - 4;
+        uint64_t chainIndex = (offset - localSize) / perPage;
+        uint64_t withinPage = (offset - localSize) % perPage;
+        uint32_t number = payload.overflow;
+        if (chainIndex >= m_header.pageCount) {
+            return false;
+        }
+        for (uint64_t i = 0; i < chainIndex; ++i) {
+            ByteView page = Page(number);
+            if (page.Empty()) {
+                return false;
+            }
+            number = page.U32BE(0);
+        }
+
+        uint64_t hops = 0;
+        while (length > 0) {
+            ByteView page = Page(number);
+            if (page.Empty() || ++hops > m_header.pageCount) {
+                return false;
+            }
+            size_t take = static_cast<size_t>(std::min<uint64_t>(length, perPage - withinPage));
+            out.append(reinterpret_cast<const char*>(page.Data() + 4 + withinPage), take);
+            length -= take;
+            withinPage = 0;
+            number = page.U32BE(0);
+        }
+        return true;
+    }
+
+    // Decode a record's first `maxFields` fields. Text and blobs keep at most
+    // `maxBytes`; what is skipped is never read, so a huge blob in the middle
+    // of a row costs only the overflow pages before the fields after it.
+    bool SqliteFile::ReadRecord(const Payload& payload, size_t maxFields, size_t maxBytes,
+                                std::vector<SqliteValue>& values) const {
+        values.clear();
+
+        std::string scratch;
+        if (!CopyPayload(payload, 0, static_cast<size_t>(std::min<uint64_t>(9, payload.size)), scratch)) {
+            return false;
+        }
+        size_t offset = 0;
+        uint64_t headerSize = 0;
+        if (!ReadVarint(ByteView(reinterpret_cast<const uint8_t*>(scratch.data()), scratch.size()), offset, headerSize) ||
+            headerSize > payload.size || headerSize > MAX_RECORD_HEADER || headerSize < offset) {
+            return false;
+        }
+
+        std::string header;
+        if (!CopyPayload(payload, 0, static_cast<size_t>(headerSize), header)) {
+            return false;
+        }
+        ByteView types(reinterpret_cast<const uint8_t*>(header.data()), header.size());
+
+        uint64_t body = headerSize;
+        while (offset < header.size() && values.size() < maxFields) {
+            uint64_t serialType = 0;
+            if (!ReadVarint(types, offset, serialType)) {
+                return false;
+            }
+            uint64_t size = SerialTypeSize(serialType);
+            if (size > payload.size - body) {
+                return false;
+            }
+
+            SqliteValue value;
+            value.size = size;
+            if (serialType >= 1 && serialType <= 7) {
+                scratch.clear();
+                if (!CopyPayload(payload, body, static_cast<size_t>(size), scratch)) {
+                    return false;
+                }
+                uint64_t bits = 0;
+                for (unsigned char byte : scratch) {
+                    bits = (bits << 8) | byte;
+                }
+                if (serialType == 7) {
+                    value.type = SqliteValueType::Real;
+                    std::memcpy(&value.real, &bits, sizeof(value.real));
+                } else {
+                    // Sign-extend from the stored width
+                    unsigned shift = static_cast<unsigned>(64 - 8 * size);
+                    value.type = SqliteValueType::Integer;
+                    value.integer = static_cast<int64_t>(bits << shift) >> shift;
+                }
+            } else if (serialType == 8 || serialType == 9) {
+                value.type = SqliteValueType::Integer;
+                value.integer = serialType == 9 ? 1 : 0;
+            } else if (serialType >= 12) {
+                bool text = (serialType & 1) != 0;
+                size_t keep = static_cast<size_t>(std::min<uint64_t>(size, text ? maxBytes : BLOB_PREVIEW_BYTES));
+                scratch.clear();
+                if (!CopyPayload(payload, body, keep, scratch)) {
+                    return false;
+                }
+                value.truncated = keep < size;
+                if (text) {
+                    value.type = SqliteValueType::Text;
+                    DecodeText(scratch, value.truncated, value.bytes);
+                } else {
+                    value.type = SqliteValueType::Blob;
+                    value.bytes = scratch;
+                }
+            }
+            // 0, and the reserved 10 and 11, are NULL
+
+            body += size;
+            values.push_back(std::move(value));
+        }
+        return true;
+    }
+
+    // Text in the database encoding to UTF-8. A cut-off value ends on a whole
+    // character; malformed UTF-8 is left for the JSON writer to replace.
+    void SqliteFile::DecodeText(std::string_view raw, bool truncated, std::string& out) const {
+        out.clear();
+        if (m_header.encoding == SqliteTextEncoding::Utf8) {
+            size_t end = raw.size();
+            if (truncated) {
+                size_t lead = end;
+                while (lead > 0 && end - lead < 4 && (static_cast<unsigned char>(raw[lead - 1]) & 0xC0) == 0x80) {
+                    --lead;
+                }
+                if (lead > 0 && static_cast<unsigned char>(raw[lead - 1]) >= 0xC0 &&
+                    Utf8SequenceLength(raw, lead - 1) == 0) {
+                    end = lead - 1;
+                }
+            }
+            out.assign(raw.data(), end);
+            return;
+        }
+
+        bool bigEndian = m_header.encoding == SqliteTextEncoding::Utf16be;
+        ByteView units(reinterpret_cast<const uint8_t*>(raw.data()), raw.size() & ~static_cast<size_t>(1));
+        out.reserve(units.Size());
+        for (size_t i = 0; i < units.Size(); i += 2) {
+            uint32_t cp = units.U16(i, bigEndian);
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                uint32_t low = units.Has(i + 2, 2) ? units.U16(i + 2, bigEndian) : 0;
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                } else if (truncated && !units.Has(i + 2, 2)) {
+                    break;  // The other half was cut off
+                } else {
+                    cp = 0xFFFD;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = 0xFFFD;
+            }
+            AppendCodePoint(out, cp);
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../common/ByteView.h"
+
+namespace Lumos {
+    enum class SqliteTextEncoding : uint32_t {
+        Utf8 = 1,
+        Utf16le = 2,
+        Utf16be = 3
+    };
+
+    // The fields of the 100-byte database header worth showing
+    struct SqliteHeader {
+        uint32_t pageSize = 0;
+        uint32_t usableSize = 0;      // Page size less the reserved bytes at the end of each page
+        uint32_t pageCount = 0;       // Clamped to the pages actually in the file
+        uint32_t freelistPages = 0;
+        uint32_t schemaCookie = 0;
+        uint32_t schemaFormat = 0;
+        uint32_t userVersion = 0;
+        uint32_t applicationId = 0;
+        uint32_t sqliteVersion = 0;   // SQLITE_VERSION_NUMBER of the last writer, e.g. 3045001
+        SqliteTextEncoding encoding = SqliteTextEncoding::Utf8;
+        bool walMode = false;         // Recent changes may live only in the -wal file
+        bool autoVacuum = false;
+    };
+
+    // A row of sqlite_schema
+    struct SqliteObject {
+        std::string type;       // table, index, view or trigger
+        std::string name;
+        std::string tableName;
+        uint32_t rootPage = 0;  // 0 for views, triggers and virtual tables
+        std::string sql;        // UTF-8; empty for automatic indexes
+    };
+
+    struct SqliteSchema {
+        SqliteHeader header;
+        std::vector<SqliteObject> objects;
+
+        // {"pageSize":...,"objects":[{"type":...,"sql":...}]}
+        void WriteJson(std::pmr::string& out) const;
+    };
+
+    enum class SqliteValueType : uint8_t { Null, Integer, Real, Text, Blob };
+
+    // One field of a record. Text keeps at most MAX_VALUE_BYTES and blobs
+    // only their first bytes; a preview has no use for a 50 MB blob and
+    // must not fault it in.
+    struct SqliteValue {
+        SqliteValueType type = SqliteValueType::Null;
+        bool truncated = false;
+        int64_t integer = 0;
+        double real = 0;
+        std::string bytes;      // Text as UTF-8, or the first bytes of a blob
+        uint64_t size = 0;      // Full size in the file
+    };
+
+    struct SqliteRows {
+        std::string table;
+        uint64_t firstRow = 0;
+        std::vector<std::string> columns;
+        std::vector<SqliteValue> values;  // Row-major, columns.size() per row
+        size_t rowCount = 0;
+        bool more = false;                // The table goes on past the last row read
+
+        // {"name":...,"firstRow":...,"columns":[...],"rows":[[...]],"more":...};
+        // every cell is a display string or null
+        void WriteJson(std::pmr::string& out) const;
+    };
+
+    // Read-only SQLite reader over a memory-mapped database file. It follows
+    // the b-trees page by page, so showing the schema or the first rows of a
+    // table touches a handful of pages however large the file is. Corrupt or
+    // hostile files end the walk early; nothing is trusted without a bounds
+    // check, tree depth and pages visited are capped, and cycles stop at the
+    // page count. Changes still in a -wal file are not seen.
+    class SqliteFile {
+    public:
+        static constexpr size_t MAX_VALUE_BYTES = 256;
+        static constexpr size_t MAX_SQL_BYTES = 256 * 1024;
+        static constexpr size_t MAX_SCHEMA_OBJECTS = 10000;
+        static constexpr size_t MAX_TREE_DEPTH = 32;
+
+        explicit SqliteFile(ByteView data);
+
+        static bool HandlesExtension(std::wstring_view extension);
+
+        // Starts with the SQLite magic and has a sane page size
+        bool IsValid() const { return m_valid; }
+        const SqliteHeader& Header() const { return m_header; }
+
+        // Walk sqlite_schema. False if the walk hit corruption; whatever was
+        // read before that is kept.
+        bool ReadSchema(SqliteSchema& schema) const;
+
+        // Up to `count` rows of a table starting at row `firstRow`, in rowid
+        // (or primary key) order. Leaves before `firstRow` are skipped by
+        // their cell counts without decoding them.
+        bool ReadRows(const SqliteObject& table, uint64_t firstRow, size_t count, SqliteRows& rows) const;
+
+    private:
+        // Where a cell's payload lives: the part on its b-tree page and,
+        // when it spills, the first page of its overflow chain
+        struct Payload {
+            ByteView local;
+            uint64_t size = 0;
+            uint32_t overflow = 0;
+        };
+
+        // A table or index entry; rowid is set for table b-trees only
+        struct Cell {
+            int64_t rowid = 0;
+            Payload payload;
+        };
+
+        // Return false to stop the walk
+        using CellVisitor = std::function<bool(const Cell& cell)>;
+
+        ByteView Page(uint32_t number) const;
+        bool Walk(uint32_t root, uint64_t skip, const CellVisitor& visit) const;
+        bool ParseCell(ByteView page, uint8_t pageType, size_t offset, Cell& cell) const;
+        size_t LocalPayloadSize(uint64_t payloadSize, bool tableLeaf) const;
+        bool CopyPayload(const Payload& payload, uint64_t offset, size_t length, std::string& out) const;
+        bool ReadRecord(const Payload& payload, size_t maxFields, size_t maxBytes, std::vector<SqliteValue>& values) const;
+        void DecodeText(std::string_view raw, bool truncated, std::string& out) const;
+
+        ByteView m_data;
+        SqliteHeader m_header;
+        bool m_valid;
+    };
+}
@@ -0,0 +1,301 @@
+#include "SqliteTableSql.h"
+#include <algorithm>
+#include "../../common/StringUtil.h"
+
+namespace Lumos {
+    namespace {
+        enum class TokenKind { Word, Quoted, String, Number, Punct };
+
+        struct Token {
+            TokenKind kind;
+            std::string text;  // Quotes removed and doubled quotes collapsed
+        };
+
+        bool IsWordChar(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+                   static_cast<unsigned char>(c) >= 0x80;
+        }
+
+        bool IsKeyword(const Token& token, std::string_view keyword) {
+            return token.kind == TokenKind::Word && EqualsIgnoreCaseAscii(token.text, keyword);
+        }
+
+        bool IsPunct(const Token& token, char c) {
+            return token.kind == TokenKind::Punct && token.text.size() == 1 && token.text[0] == c;
+        }
+
+        // Quoted text up to the matching `close`; a doubled close quote is a literal one
+        size_t ReadQuoted(std::string_view sql, size_t i, char close, std::string& out) {
+            ++i;
+            while (i < sql.size()) {
+                if (sql[i] == close) {
+                    if (close != ']' && i + 1 < sql.size() && sql[i + 1] == close) {
+                        out.push_back(close);
+                        i += 2;
+                        continue;
+                    }
+                    return i + 1;
+                }
+                out.push_back(sql[i++]);
+            }
+            return i;
+        }
+
+        std::vector<Token> Tokenize(std::string_view sql) {
+            std::vector<Token> tokens;
+            size_t i = 0;
+            while (i < sql.size()) {
+                char c = sql[i];
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v') {
+                    ++i;
+                } else if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-') {
+                    while (i < sql.size() && sql[i] != '\n') {
+                        ++i;
+                    }
+                } else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*') {
+                    size_t end = sql.find("*/", i + 2);
+                    i = end == std::string_view::npos ? sql.size() : end + 2;
+                } else if (c == '"' || c == '`' || c == '[') {
+                    Token token{TokenKind::Quoted, {}};
+                    i = ReadQuoted(sql, i, c == '[' ? ']' : c, token.text);
+                    tokens.push_back(std::move(token));
+                } else if (c == '\'') {
+                    Token token{TokenKind::String, {}};
+                    i = ReadQuoted(sql, i, '\'', token.text);
+                    tokens.push_back(std::move(token));
+                } else if ((c >= '0' && c <= '9') || (c == '.' && i + 1 < sql.size() && sql[i + 1] >= '0' && sql[i + 1] <= '9')) {
+                    size_t start = i;
+                    while (i < sql.size() && (IsWordChar(sql[i]) || sql[i] == '.' ||
+                           ((sql[i] == '+' || sql[i] == '-') && (sql[i - 1] == 'e' || sql[i - 1] == 'E')))) {
+                        ++i;
+                    }
+                    tokens.push_back({TokenKind::Number, std::string(sql.substr(start, i - start))});
+                } else if (IsWordChar(c)) {
+                    size_t start = i;
+                    while (i < sql.size() && IsWordChar(sql[i])) {
+                        ++i;
+                    }
+                    tokens.push_back({TokenKind::Word, std::string(sql.substr(start, i - start))});
+                } else {
+                    tokens.push_back({TokenKind::Punct, std::string(1, c)});
+                    ++i;
+                }
+            }
+            return tokens;
+        }
+
+        bool IsName(const Token& token) {
+            return token.kind == TokenKind::Word || token.kind == TokenKind::Quoted || token.kind == TokenKind::String;
+        }
+
+        // Index just past the parenthesis that closes the one at `open`
+        size_t SkipParens(const std::vector<Token>& tokens, size_t open, size_t end) {
+            int depth = 0;
+            for (size_t i = open; i < end; ++i) {
+                if (IsPunct(tokens[i], '(')) {
+                    ++depth;
+                } else if (IsPunct(tokens[i], ')') && --depth == 0) {
+                    return i + 1;
+                }
+            }
+            return end;
+        }
+
+        bool StartsTableConstraint(const Token& token) {
+            return IsKeyword(token, "CONSTRAINT") || IsKeyword(token, "PRIMARY") || IsKeyword(token, "UNIQUE") ||
+                   IsKeyword(token, "CHECK") || IsKeyword(token, "FOREIGN");
+        }
+
+        bool StartsColumnConstraint(const Token& token) {
+            return IsKeyword(token, "CONSTRAINT") || IsKeyword(token, "PRIMARY") || IsKeyword(token, "NOT") ||
+                   IsKeyword(token, "NULL") || IsKeyword(token, "UNIQUE") || IsKeyword(token, "CHECK") ||
+                   IsKeyword(token, "DEFAULT") || IsKeyword(token, "COLLATE") || IsKeyword(token, "REFERENCES") ||
+                   IsKeyword(token, "GENERATED") || IsKeyword(token, "AS");
+        }
+
+        bool ContainsIgnoreCaseAscii(std::string_view text, std::string_view part) {
+            for (size_t i = 0; i + part.size() <= text.size(); ++i) {
+                if (EqualsIgnoreCaseAscii(text.substr(i, part.size()), part)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // SQLite's affinity rules, checked in its order: any INT makes the
+        // column INTEGER, CHAR/CLOB/TEXT makes it TEXT, BLOB or no type BLOB
+        bool HasRealAffinity(std::string_view type) {
+            for (std::string_view other : { "INT", "CHAR", "CLOB", "TEXT", "BLOB" }) {
+                if (ContainsIgnoreCaseAscii(type, other)) {
+                    return false;
+                }
+            }
+            return ContainsIgnoreCaseAscii(type, "REAL") || ContainsIgnoreCaseAscii(type, "FLOA") ||
+                   ContainsIgnoreCaseAscii(type, "DOUB");
+        }
+    }
+
+    SqliteTableSql SqliteTableSql::Parse(std::string_view sql) {
+        SqliteTableSql table;
+        std::vector<Token> tokens = Tokenize(sql);
+        if (tokens.size() < 4 || !IsKeyword(tokens[0], "CREATE")) {
+            return table;
+        }
+
+        size_t open = 0;
+        while (open < tokens.size() && !IsPunct(tokens[open], '(')) {
+            if (IsKeyword(tokens[open], "VIRTUAL") || IsKeyword(tokens[open], "AS")) {
+                return table;  // Module arguments or a SELECT, not column definitions
+            }
+            ++open;
+        }
+        if (open >= tokens.size()) {
+            return table;
+        }
+        size_t close = SkipParens(tokens, open, tokens.size());
+        if (close == tokens.size() && !IsPunct(tokens.back(), ')')) {
+            return table;  // Unbalanced
+        }
+        size_t bodyEnd = close - 1;  // The closing parenthesis
+
+        for (size_t i = close; i + 1 < tokens.size(); ++i) {
+            if (IsKeyword(tokens[i], "WITHOUT") && IsKeyword(tokens[i + 1], "ROWID")) {
+                table.withoutRowid = true;
+            }
+        }
+
+        // Declared types decide rowid aliasing, which needs the whole list
+        std::vector<bool> integerType;
+        std::vector<bool> descendingKey;
+
+        size_t i = open + 1;
+        while (i < bodyEnd) {
+            size_t end = i;
+            while (end < bodyEnd && !IsPunct(tokens[end], ',')) {
+                end = IsPunct(tokens[end], '(') ? SkipParens(tokens, end, bodyEnd) : end + 1;
+            }
+
+            if (StartsTableConstraint(tokens[i])) {
+                size_t k = i;
+                while (k + 1 < end && !(IsKeyword(tokens[k], "PRIMARY") && IsKeyword(tokens[k + 1], "KEY"))) {
+                    ++k;
+                }
+                if (k + 2 < end && IsPunct(tokens[k + 2], '(')) {
+                    size_t listEnd = SkipParens(tokens, k + 2, end) - 1;
+                    bool expectName = true;
+                    table.primaryKey.clear();
+                    for (size_t t = k + 3; t < listEnd; ++t) {
+                        if (IsPunct(tokens[t], ',')) {
+                            expectName = true;
+                        } else if (IsPunct(tokens[t], '(')) {
+                            t = SkipParens(tokens, t, listEnd) - 1;
+                        } else if (expectName && IsName(tokens[t])) {
+                            expectName = false;
+                            for (size_t c = 0; c < table.columns.size(); ++c) {
+                                if (EqualsIgnoreCaseAscii(table.columns[c].name, tokens[t].text)) {
+                                    table.primaryKey.push_back(c);
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    for (size_t c : table.primaryKey) {
+                        table.columns[c].primaryKey = true;
+                    }
+                    // PRIMARY KEY(x DESC) still aliases the rowid; only the column form does not
+                    if (table.primaryKey.size() == 1 && integerType[table.primaryKey[0]]) {
+                        descendingKey[table.primaryKey[0]] = false;
+                    }
+                }
+            } else if (IsName(tokens[i])) {
+                SqliteColumn column;
+                column.name = tokens[i].text;
+
+                size_t k = i + 1;
+                std::string type;
+                while (k < end && !StartsColumnConstraint(tokens[k])) {
+                    if (IsPunct(tokens[k], '(')) {
+                        k = SkipParens(tokens, k, end);
+                        continue;
+                    }
+                    if (tokens[k].kind == TokenKind::Word || tokens[k].kind == TokenKind::Quoted) {
+                        type += type.empty() ? "" : " ";
+                        type += tokens[k].text;
+                    }
+                    ++k;
+                }
+                bool isInteger = EqualsIgnoreCaseAscii(type, "INTEGER");
+                column.realAffinity = HasRealAffinity(type);
+                bool descending = false;
+
+                while (k < end) {
+                    if (IsKeyword(tokens[k], "PRIMARY") && k + 1 < end && IsKeyword(tokens[k + 1], "KEY")) {
+                        column.primaryKey = true;
+                        table.primaryKey.assign(1, table.columns.size());
+                        k += 2;
+                        if (k < end && IsKeyword(tokens[k], "DESC")) {
+                            descending = true;
+                        }
+                    } else if (IsKeyword(tokens[k], "AS") && k + 1 < end && IsPunct(tokens[k + 1], '(')) {
+                        // GENERATED ALWAYS AS (expr) [VIRTUAL | STORED]; VIRTUAL by default
+                        k = SkipParens(tokens, k + 1, end);
+                        column.virtualGenerated = !(k < end && IsKeyword(tokens[k], "STORED"));
+                    } else if (IsKeyword(tokens[k], "DEFAULT") && k + 1 < end) {
+                        const Token* value = &tokens[k + 1];
+                        std::string sign;
+                        if ((IsPunct(*value, '-') || IsPunct(*value, '+')) && k + 2 < end) {
+                            sign = IsPunct(*value, '-') ? "-" : "";
+                            value = &tokens[k + 2];
+                        }
+                        if (value->kind == TokenKind::Number) {
+                            column.hasDefault = true;
+                            column.defaultLiteral = sign + value->text;
+                        } else if (value->kind == TokenKind::String && sign.empty()) {
+                            column.hasDefault = true;
+                            column.defaultIsText = true;
+                            column.defaultLiteral = value->text;
+                        } else if (IsKeyword(*value, "TRUE") || IsKeyword(*value, "FALSE")) {
+                            column.hasDefault = true;
+                            column.defaultLiteral = IsKeyword(*value, "TRUE") ? "1" : "0";
+                        }
+                        k += 2;
+                    } else if (IsPunct(tokens[k], '(')) {
+                        k = SkipParens(tokens, k, end);
+                    } else {
+                        ++k;
+                    }
+                }
+
+                integerType.push_back(isInteger);
+                descendingKey.push_back(descending);
+                table.columns.push_back(std::move(column));
+            }
+
+            i = end + 1;
+        }
+
+        if (!table.withoutRowid && table.primaryKey.size() == 1) {
+            size_t key = table.primaryKey[0];
+            table.columns[key].rowidAlias = integerType[key] && !descendingKey[key];
+        }
+        return table;
+    }
+
+    std::vector<size_t> SqliteTableSql::StorageOrder() const {
+        std::vector<size_t> order;
+        order.reserve(columns.size());
+        if (withoutRowid) {
+            for (size_t key : primaryKey) {
+                if (std::find(order.begin(), order.end(), key) == order.end()) {
+                    order.push_back(key);
+                }
+            }
+        }
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (!columns[c].virtualGenerated && std::find(order.begin(), order.end(), c) == order.end()) {
+                order.push_back(c);
+            }
+        }
+        return order;
+    }
+}
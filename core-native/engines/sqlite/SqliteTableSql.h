@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Lumos {
+    // A column as declared in CREATE TABLE, with what decides where (and
+    // whether) it sits in the table's records
+    struct SqliteColumn {
+        std::string name;
+        bool rowidAlias = false;      // INTEGER PRIMARY KEY: stored as NULL, the value is the rowid
+        bool primaryKey = false;
+        bool virtualGenerated = false; // GENERATED ... VIRTUAL: never stored
+        bool realAffinity = false;    // REAL, FLOAT, DOUBLE: integral values are stored as integers
+        bool hasDefault = false;      // Literal DEFAULT, for rows written before ADD COLUMN
+        std::string defaultLiteral;   // Unquoted text or the number as written
+        bool defaultIsText = false;
+    };
+
+    // Just enough of CREATE TABLE to lay records out: column names in
+    // declaration order, the primary key and WITHOUT ROWID. Expressions are
+    // skipped, not understood; anything unexpected leaves `columns` empty and
+    // the caller numbers the record fields instead.
+    struct SqliteTableSql {
+        std::vector<SqliteColumn> columns;
+        std::vector<size_t> primaryKey;  // Indexes into columns, in key order
+        bool withoutRowid = false;
+
+        static SqliteTableSql Parse(std::string_view sql);
+
+        // Columns in record order: for WITHOUT ROWID the key first, then
+        // the rest; virtual generated columns are left out
+        std::vector<size_t> StorageOrder() const;
+    };
+}
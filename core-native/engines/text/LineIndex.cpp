@@ -0,0 +1,47 @@
+#include "LineIndex.h"
+#include <cstring>
+
+namespace Lumos {
+    LineIndex::LineIndex()
+        : m_bytes(0)
+        , m_completeLines(0)
+        , m_partialStart(0)
+    {
+        m_checkpoints.push_back(0);
+    }
+
+    void LineIndex::Append(const uint8_t* data, size_t length) {
+        const uint8_t* cursor = data;
+        const uint8_t* end = data + length;
+        while (cursor < end) {
+            // memchr is vectorized by every libc we ship on
+            auto newline = static_cast<const uint8_t*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+            if (newline == nullptr) {
+                break;
+            }
+            ++m_completeLines;
+            m_partialStart = m_bytes + static_cast<uint64_t>(newline - data) + 1;
+            if (m_completeLines % CHECKPOINT_LINES == 0) {
+                m_checkpoints.push_back(m_partialStart);
+            }
+            cursor = newline + 1;
+        }
+        m_bytes += length;
+    }
+
+    void LineIndex::Reset() {
+        m_bytes = 0;
+        m_completeLines = 0;
+        m_partialStart = 0;
+        m_checkpoints.assign(1, 0);
+    }
+
+    uint64_t LineIndex::Seek(uint64_t line, uint64_t& checkpointLine) const {
+        size_t checkpoint = static_cast<size_t>(line / CHECKPOINT_LINES);
+        if (checkpoint >= m_checkpoints.size()) {
+            checkpoint = m_checkpoints.size() - 1;
+        }
+        checkpointLine = static_cast<uint64_t>(checkpoint) * CHECKPOINT_LINES;
+        return m_checkpoints[checkpoint];
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Lumos {
+    // Line index over an append-only byte stream. Bytes are fed in as they
+    // are read and never revisited, so keeping a growing log indexed costs
+    // only the bytes appended since the last call. Every CHECKPOINT_LINES-th
+    // line start is recorded, so any line can be found by reading at most
+    // one checkpoint interval of the file.
+    class LineIndex {
+    public:
+        static constexpr uint64_t CHECKPOINT_LINES = 4096;
+
+        LineIndex();
+
+        // Index `length` bytes that directly follow everything indexed so far
+        void Append(const uint8_t* data, size_t length);
+
+        // Forget everything (file truncated or replaced)
+        void Reset();
+
+        uint64_t Bytes() const { return m_bytes; }
+
+        // Lines terminated by '\n'
+        uint64_t CompleteLines() const { return m_completeLines; }
+
+        // Complete lines plus the unterminated last line, if any
+        uint64_t LineCount() const { return m_completeLines + (m_partialStart < m_bytes ? 1 : 0); }
+
+        // Offset where the unterminated last line starts (== Bytes() if none)
+        uint64_t PartialLineStart() const { return m_partialStart; }
+
+        // Offset of the closest recorded line start at or before `line`; the
+        // number of that line is stored in `checkpointLine`
+        uint64_t Seek(uint64_t line, uint64_t& checkpointLine) const;
+
+    private:
+        uint64_t m_bytes;
+        uint64_t m_completeLines;
+        uint64_t m_partialStart;
+        std::vector<uint64_t> m_checkpoints; // Start of line k * CHECKPOINT_LINES
+    };
+}
@@ -0,0 +1,383 @@
+#include "LogTail.h"
+#include <algorithm>
+#include <iostream>
+#include "../../common/StringUtil.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../common/Utf8.h"
+#endif
+
+namespace Lumos {
+    // Read handle that stays on the same file when the path is renamed or
+    // replaced underneath it
+    class LogTail::File {
+    public:
+        File() = default;
+        ~File() { Close(); }
+
+#ifdef _WIN32
+        bool Open(const std::wstring& path) {
+            Close();
+            m_handle = CreateFileW(path.c_str(), GENERIC_READ,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            BY_HANDLE_FILE_INFORMATION info;
+            if (m_handle == INVALID_HANDLE_VALUE || !GetFileInformationByHandle(m_handle, &info)) {
+                Close();
+                return false;
+            }
+            m_volume = info.dwVolumeSerialNumber;
+            m_fileIndex = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+            return true;
+        }
+
+        void Close() {
+            if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+            m_handle = INVALID_HANDLE_VALUE;
+        }
+
+        uint64_t Size() const {
+            LARGE_INTEGER size;
+            return GetFileSizeEx(m_handle, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+        }
+
+        // Returns bytes read, 0 at EOF, -1 on error
+        long long ReadAt(uint64_t offset, uint8_t* buffer, size_t length) {
+            OVERLAPPED ov = {};
+            ov.Offset = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD read = 0;
+            if (!ReadFile(m_handle, buffer, static_cast<DWORD>(length), &read, &ov)) {
+                return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+            }
+            return read;
+        }
+
+        // Whether `path` still names the open file; `exists` is false while
+        // the path is missing (between a rotation's rename and create)
+        bool SameAs(const std::wstring& path, bool& exists) const {
+            HANDLE other = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                       nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+            exists = other != INVALID_HANDLE_VALUE;
+            if (!exists) {
+                return false;
+            }
+            BY_HANDLE_FILE_INFORMATION info;
+            bool same = GetFileInformationByHandle(other, &info) && info.dwVolumeSerialNumber == m_volume &&
+                        ((static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow) == m_fileIndex;
+            CloseHandle(other);
+            return same;
+        }
+
+    private:
+        HANDLE m_handle = INVALID_HANDLE_VALUE;
+        DWORD m_volume = 0;
+        uint64_t m_fileIndex = 0;
+#else
+        bool Open(const std::wstring& path) {
+            Close();
+            m_fd = open(ToUtf8(path).c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (m_fd < 0 || fstat(m_fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+                Close();
+                return false;
+            }
+            m_device = st.st_dev;
+            m_inode = st.st_ino;
+            return true;
+        }
+
+        void Close() {
+            if (m_fd >= 0) close(m_fd);
+            m_fd = -1;
+        }
+
+        uint64_t Size() const {
+            struct stat st;
+            return fstat(m_fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        }
+
+        long long ReadAt(uint64_t offset, uint8_t* buffer, size_t length) {
+            ssize_t n = pread(m_fd, buffer, length, static_cast<off_t>(offset));
+            return n < 0 ? -1 : static_cast<long long>(n);
+        }
+
+        bool SameAs(const std::wstring& path, bool& exists) const {
+            struct stat st;
+            exists = stat(ToUtf8(path).c_str(), &st) == 0;
+            return exists && st.st_dev == m_device && st.st_ino == m_inode;
+        }
+
+    private:
+        int m_fd = -1;
+        dev_t m_device = 0;
+        ino_t m_inode = 0;
+#endif
+    };
+
+    LogTail::LogTail(std::wstring path, LogTailCallback callback)
+        : m_path(std::move(path))
+        , m_callback(std::move(callback))
+        , m_file(std::make_unique<File>())
+        , m_stopping(false)
+        , m_watching(false)
+        , m_pendingStart(0)
+        , m_skippedLines(0)
+        , m_truncated(false)
+        , m_rotated(false)
+        , m_indexed(false)
+        , m_statusDirty(false)
+        , m_bytesRead(0)
+    {
+        size_t slash = m_path.find_last_of(L"\\/");
+        m_directory = slash == std::wstring::npos ? L"." : m_path.substr(0, slash == 0 ? 1 : slash);
+        m_fileName = slash == std::wstring::npos ? m_path : m_path.substr(slash + 1);
+    }
+
+    LogTail::~LogTail() {
+        Stop();
+    }
+
+    bool LogTail::HandlesExtension(std::wstring_view extension) {
+        return ExtensionIn(extension, { L".log" });
+    }
+
+    bool LogTail::Open(size_t maxLines, std::string& initialText) {
+        initialText.clear();
+        if (!m_file->Open(m_path)) {
+            return false;
+        }
+
+        uint64_t size = m_file->Size();
+        size_t length = static_cast<size_t>(std::min<uint64_t>(size, MAX_UPDATE_BYTES));
+        uint64_t start = size - length;
+        m_chunk.resize(std::max(length, READ_CHUNK_SIZE));
+        long long read = length > 0 ? m_file->ReadAt(start, m_chunk.data(), length) : 0;
+        if (read < 0) {
+            return false;
+        }
+        std::string_view tail(reinterpret_cast<const char*>(m_chunk.data()), static_cast<size_t>(read));
+
+        // Whole lines only: the unterminated last line arrives with the first
+        // update once the writer finishes it
+        size_t end = tail.rfind('\n');
+        if (end == std::string_view::npos) {
+            m_pendingStart = start + tail.size();
+            return true;
+        }
+        ++end;
+        m_pendingStart = start + end;
+
+        // Walk back one line at a time from the end of the window
+        size_t begin = end;
+        size_t lines = 0;
+        while (lines < maxLines && begin > 0) {
+            size_t previous = begin >= 2 ? tail.rfind('\n', begin - 2) : std::string_view::npos;
+            if (previous == std::string_view::npos) {
+                if (start == 0) {
+                    begin = 0;
+                }
+                break; // Otherwise the window cut this line; leave it out
+            }
+            begin = previous + 1;
+            ++lines;
+        }
+        initialText.assign(tail.substr(begin, end - begin));
+        return true;
+    }
+
+    void LogTail::Follow() {
+        if (m_thread.joinable()) {
+            return;
+        }
+        // Opened here rather than on the tail thread, so Stop() never races
+        // the watcher being set up
+        m_watching = m_watcher.Open() && m_watcher.Add(m_directory) >= 0;
+        if (!m_watching) {
+            std::wcerr << L"Cannot watch " << m_directory << L"; polling every "
+                       << POLL_INTERVAL.count() << L" ms" << std::endl;
+        }
+        m_thread = std::thread(&LogTail::Run, this);
+    }
+
+    void LogTail::Stop() {
+        m_stopping.store(true);
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_sleep.notify_all();
+        m_watcher.Wake();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        m_watcher.Close();
+    }
+
+    void LogTail::Run() {
+        using Clock = std::chrono::steady_clock;
+
+        // Count the existing lines once; from here on only appends are read
+        ReadAppended(m_file->Size());
+        m_indexed = true;
+        m_statusDirty = true;
+
+        std::vector<FileChange> changes;
+        auto nextFlush = Clock::now();
+        while (!m_stopping.load()) {
+            changes.clear();
+            if (HasUpdate()) {
+                // Let appends pile up until the next refresh slot; queued
+                // notifications for the same file collapse in the meantime
+                SleepUntil(nextFlush);
+                if (m_watching && !m_watcher.Wait(changes, std::chrono::milliseconds(0))) {
+                    m_watching = false;
+                }
+            } else if (m_watching) {
+                if (!m_watcher.Wait(changes, POLL_INTERVAL) || m_watcher.WatchCount() == 0) {
+                    std::wcerr << L"Lost watch on " << m_directory << L"; falling back to polling" << std::endl;
+                    m_watching = false;
+                } else if (!changes.empty() && !AffectsFile(changes)) {
+                    continue; // Another file in a busy log directory
+                }
+            } else {
+                SleepUntil(Clock::now() + POLL_INTERVAL);
+            }
+            if (m_stopping.load()) {
+                break;
+            }
+
+            CheckFile();
+            auto now = Clock::now();
+            if (HasUpdate() && now >= nextFlush) {
+                if (!Flush()) {
+                    break;
+                }
+                nextFlush = now + REFRESH_INTERVAL;
+            }
+        }
+    }
+
+    bool LogTail::AffectsFile(const std::vector<FileChange>& changes) const {
+        for (const FileChange& change : changes) {
+#ifdef _WIN32
+            bool match = EqualsIgnoreCase(change.name, m_fileName);
+#else
+            bool match = change.name == m_fileName;
+#endif
+            if (match || change.kind == FileChangeKind::Overflow || change.kind == FileChangeKind::Lost) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void LogTail::SleepUntil(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleep.wait_until(lock, deadline, [this] { return m_stopping.load(); });
+    }
+
+    void LogTail::CheckFile() {
+        bool exists = false;
+        if (!m_file->SameAs(m_path, exists) && exists) {
+            // Rotated: finish what was written to the old file and show it,
+            // then move on
+            ReadAppended(m_file->Size());
+            if (HasUpdate() && !Flush()) {
+                m_stopping.store(true);
+                return;
+            }
+            auto next = std::make_unique<File>();
+            if (!next->Open(m_path)) {
+                return; // Replacement not readable yet; retry on the next change
+            }
+            m_file = std::move(next);
+            ResetContent();
+            m_rotated = true;
+        }
+
+        uint64_t size = m_file->Size();
+        if (size < m_index.Bytes()) {
+            // copytruncate, or rewritten in place
+            ResetContent();
+            m_truncated = true;
+            m_rotated = false;
+        }
+        if (size > m_index.Bytes()) {
+            ReadAppended(size);
+        }
+    }
+
+    void LogTail::ReadAppended(uint64_t size) {
+        while (m_index.Bytes() < size && !m_stopping.load()) {
+            uint64_t offset = m_index.Bytes();
+            size_t length = static_cast<size_t>(std::min<uint64_t>(size - offset, m_chunk.size()));
+            long long read = m_file->ReadAt(offset, m_chunk.data(), length);
+            if (read <= 0) {
+                break;
+            }
+            m_index.Append(m_chunk.data(), static_cast<size_t>(read));
+            m_bytesRead.fetch_add(static_cast<uint64_t>(read), std::memory_order_relaxed);
+
+            // Bytes before m_pendingStart were shown by Open() or skipped
+            uint64_t end = offset + static_cast<uint64_t>(read);
+            uint64_t from = std::max(offset, m_pendingStart + m_pending.size());
+            if (from < end) {
+                m_pending.append(reinterpret_cast<const char*>(m_chunk.data()) + (from - offset),
+                                 static_cast<size_t>(end - from));
+                TrimPending();
+            }
+        }
+    }
+
+    void LogTail::ResetContent() {
+        m_index.Reset();
+        m_pendingStart = 0;
+        m_pending.clear();
+        m_skippedLines = 0;
+        m_statusDirty = true;
+    }
+
+    void LogTail::TrimPending() {
+        // Amortized: trim back to one update's worth once twice that piled up
+        if (m_pending.size() <= 2 * MAX_UPDATE_BYTES) {
+            return;
+        }
+        size_t cut = m_pending.find('\n', m_pending.size() - MAX_UPDATE_BYTES);
+        cut = cut == std::string::npos ? m_pending.size() - MAX_UPDATE_BYTES : cut + 1;
+        m_skippedLines += static_cast<uint64_t>(std::count(m_pending.begin(), m_pending.begin() + cut, '\n'));
+        m_pending.erase(0, cut);
+        m_pendingStart += cut;
+    }
+
+    bool LogTail::HasUpdate() const {
+        return m_statusDirty || m_index.PartialLineStart() > m_pendingStart;
+    }
+
+    bool LogTail::Flush() {
+        size_t complete = m_index.PartialLineStart() > m_pendingStart
+            ? static_cast<size_t>(m_index.PartialLineStart() - m_pendingStart)
+            : 0;
+
+        LogTailUpdate update;
+        update.truncated = m_truncated;
+        update.rotated = m_rotated;
+        update.fileSize = m_index.Bytes();
+        update.totalLines = m_indexed ? m_index.CompleteLines() : 0;
+        update.skippedLines = m_skippedLines;
+        update.text = std::string_view(m_pending.data(), complete);
+        bool keepGoing = m_callback(update);
+
+        m_pending.erase(0, complete);
+        m_pendingStart += complete;
+        m_skippedLines = 0;
+        m_truncated = false;
+        m_rotated = false;
+        m_statusDirty = false;
+        return keepGoing;
+    }
+}
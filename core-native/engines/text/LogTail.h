@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "LineIndex.h"
+#include "../../io/DirectoryWatcher.h"
+
+namespace Lumos {
+    // Lines appended since the previous update
+    struct LogTailUpdate {
+        bool truncated;         // File was cut short or rewritten: drop what is shown first
+        bool rotated;           // Path now names a new file; text continues from its start
+        uint64_t fileSize;
+        uint64_t totalLines;    // Complete lines in the file; 0 until the initial index is done
+        uint64_t skippedLines;  // Appended lines left out because they did not fit the window
+        std::string_view text;  // Whole lines, each ending in '\n'; raw file bytes
+    };
+
+    // Called on the tail's own thread; return false to stop following (e.g.
+    // the UI has gone away)
+    using LogTailCallback = std::function<bool(const LogTailUpdate&)>;
+
+    // Follows a growing text file the way `tail -F` does. Only bytes past
+    // the last read offset are read and indexed, so the cost tracks the
+    // append rate rather than the file size. Updates are coalesced to at
+    // most one per REFRESH_INTERVAL and hold at most MAX_UPDATE_BYTES of the
+    // newest lines. Truncation (copytruncate) and replacement (rename +
+    // create) of the path are detected; after a replacement the old file is
+    // read to its end before following switches to the new one.
+    class LogTail {
+    public:
+        static constexpr auto REFRESH_INTERVAL = std::chrono::milliseconds(100);
+        static constexpr size_t MAX_UPDATE_BYTES = 256 * 1024;
+
+        LogTail(std::wstring path, LogTailCallback callback);
+        ~LogTail();
+
+        // Extensions previewed in follow mode (case-insensitive)
+        static bool HandlesExtension(std::wstring_view extension);
+
+        LogTail(const LogTail&) = delete;
+        LogTail& operator=(const LogTail&) = delete;
+
+        // Open the file and return its last lines (at most `maxLines` and
+        // MAX_UPDATE_BYTES) for the first paint. Nothing is indexed yet.
+        bool Open(size_t maxLines, std::string& initialText);
+
+        // Index the existing content and start following, on a thread of
+        // its own. Updates start after Open()'s text; call once.
+        void Follow();
+
+        void Stop();
+
+        uint64_t BytesRead() const { return m_bytesRead.load(std::memory_order_relaxed); }
+
+    private:
+        class File;
+
+        // Polled even with a working watcher: network shares and writers
+        // that map the file do not always raise change notifications
+        static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(1000);
+        static constexpr size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+        void Run();
+        void CheckFile();
+        void ReadAppended(uint64_t size);
+        void ResetContent();
+        bool AffectsFile(const std::vector<FileChange>& changes) const;
+        void SleepUntil(std::chrono::steady_clock::time_point deadline);
+        void TrimPending();
+        bool Flush();
+        bool HasUpdate() const;
+
+        std::wstring m_path;
+        std::wstring m_directory;
+        std::wstring m_fileName;
+        LogTailCallback m_callback;
+
+        std::unique_ptr<File> m_file;
+        DirectoryWatcher m_watcher;
+        std::thread m_thread;
+        std::atomic<bool> m_stopping;
+        bool m_watching;
+        std::mutex m_sleepMutex;
+        std::condition_variable m_sleep;
+
+        // Tail thread only
+        LineIndex m_index;
+        uint64_t m_pendingStart;      // File offset of m_pending[0]; bytes before it were shown or skipped
+        std::string m_pending;        // Read but not yet sent, possibly ending in a partial line
+        std::vector<uint8_t> m_chunk;
+        uint64_t m_skippedLines;
+        bool m_truncated;
+        bool m_rotated;
+        bool m_indexed;               // Existing content counted; totalLines is meaningful
+        bool m_statusDirty;
+
+        std::atomic<uint64_t> m_bytesRead;
+    };
+}
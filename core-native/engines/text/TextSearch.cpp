@@ -0,0 +1,580 @@
+#include "TextSearch.h"
+#include <algorithm>
+#include <cstring>
+#include "../../common/CpuFeatures.h"
+#include "../../common/Utf8.h"
+
+namespace Lumos {
+    namespace {
+        constexpr size_t MAX_PATTERN_BYTES = 64 * 1024;
+        // How often long-running scans look at the stop flags
+        constexpr size_t STOP_CHECK_INTERVAL = 4096;
+
+        // Simple one-to-one case pairs whose two forms have the same UTF-8
+        // length, so a match is always exactly as long as the pattern. No
+        // locale is involved; other scripts are matched as written.
+        uint32_t ToLower(uint32_t cp) {
+            if (cp >= 'A' && cp <= 'Z') return cp + 0x20;
+            if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+            if ((cp >= 0x100 && cp <= 0x12F) || (cp >= 0x132 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177)) {
+                return cp | 1;
+            }
+            if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) return (cp & 1) ? cp + 1 : cp;
+            if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return cp + 0x20;
+            if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;
+            if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;
+            return cp;
+        }
+
+        uint32_t ToUpper(uint32_t cp) {
+            if (cp >= 'a' && cp <= 'z') return cp - 0x20;
+            if (cp >= 0xE0 && cp <= 0xFE && cp != 0xF7) return cp - 0x20;
+            if ((cp >= 0x100 && cp <= 0x12F) || (cp >= 0x132 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177)) {
+                return cp & ~1u;
+            }
+            if ((cp >= 0x13A && cp <= 0x148) || (cp >= 0x17A && cp <= 0x17E)) return (cp & 1) ? cp : cp - 1;
+            if (cp >= 0x3B1 && cp <= 0x3C9 && cp != 0x3C2) return cp - 0x20;
+            if (cp >= 0x430 && cp <= 0x44F) return cp - 0x20;
+            if (cp >= 0x450 && cp <= 0x45F) return cp - 0x50;
+            return cp;
+        }
+
+        void AppendTwoByte(std::string& out, uint32_t cp) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+
+        // Literal text every match of `pattern` starts with, or empty if that
+        // is not obvious. Used to skip lines the regex cannot match.
+        std::string RequiredPrefix(std::string_view pattern) {
+            if (pattern.find('|') != std::string_view::npos) {
+                return {}; // An alternative could start with anything
+            }
+            size_t i = !pattern.empty() && pattern[0] == '^' ? 1 : 0;
+            size_t start = i;
+            while (i < pattern.size() && std::strchr("\\^$.|?*+()[]{}", pattern[i]) == nullptr) {
+                ++i;
+            }
+            // A quantifier makes the character before it optional or repeated
+            if (i < pattern.size() && std::strchr("?*{", pattern[i]) != nullptr && i > start) {
+                --i;
+                while (i > start && (static_cast<unsigned char>(pattern[i]) & 0xC0) == 0x80) {
+                    --i; // Back to the start of a multi-byte character
+                }
+            }
+            return std::string(pattern.substr(start, i - start));
+        }
+
+        // Candidate positions are those whose first and last pattern bytes
+        // match either case; verification looks at the bytes in between
+        struct Needle {
+            uint8_t first[2];
+            uint8_t last[2];
+            size_t lastOffset;
+        };
+
+        // Calls sink(p) for each candidate p in [begin, stop), in order, until
+        // it returns false. stop + lastOffset must not exceed the text size.
+        template <typename Sink>
+        bool ScanScalar(const uint8_t* data, size_t begin, size_t stop, const Needle& needle, Sink& sink) {
+            for (size_t p = begin; p < stop; ++p) {
+                if ((data[p] == needle.first[0] || data[p] == needle.first[1]) &&
+                    (data[p + needle.lastOffset] == needle.last[0] || data[p + needle.lastOffset] == needle.last[1]) &&
+                    !sink(p)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        size_t CountByteScalar(const uint8_t* data, size_t length, uint8_t byte) {
+            size_t count = 0;
+            const uint8_t* end = data + length;
+            while (data < end) {
+                auto found = static_cast<const uint8_t*>(std::memchr(data, byte, static_cast<size_t>(end - data)));
+                if (found == nullptr) {
+                    break;
+                }
+                ++count;
+                data = found + 1;
+            }
+            return count;
+        }
+
+#ifdef LUMOS_X64
+        inline uint32_t LowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+        }
+
+        const bool g_hasAvx2 = Cpu().avx2;
+
+        template <typename Sink>
+        bool ScanSse2(const uint8_t* data, size_t begin, size_t stop, const Needle& needle, Sink& sink) {
+            const __m128i first0 = _mm_set1_epi8(static_cast<char>(needle.first[0]));
+            const __m128i first1 = _mm_set1_epi8(static_cast<char>(needle.first[1]));
+            const __m128i last0 = _mm_set1_epi8(static_cast<char>(needle.last[0]));
+            const __m128i last1 = _mm_set1_epi8(static_cast<char>(needle.last[1]));
+
+            size_t i = begin;
+            for (; i + 16 <= stop; i += 16) {
+                __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + needle.lastOffset));
+                __m128i hit = _mm_and_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(head, first0), _mm_cmpeq_epi8(head, first1)),
+                    _mm_or_si128(_mm_cmpeq_epi8(tail, last0), _mm_cmpeq_epi8(tail, last1)));
+                for (uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit)); mask != 0; mask &= mask - 1) {
+                    if (!sink(i + LowestBit(mask))) {
+                        return false;
+                    }
+                }
+            }
+            return ScanScalar(data, i, stop, needle, sink);
+        }
+
+        template <typename Sink>
+        LUMOS_TARGET("avx2") bool ScanAvx2(const uint8_t* data, size_t begin, size_t stop, const Needle& needle, Sink& sink) {
+            const __m256i first0 = _mm256_set1_epi8(static_cast<char>(needle.first[0]));
+            const __m256i first1 = _mm256_set1_epi8(static_cast<char>(needle.first[1]));
+            const __m256i last0 = _mm256_set1_epi8(static_cast<char>(needle.last[0]));
+            const __m256i last1 = _mm256_set1_epi8(static_cast<char>(needle.last[1]));
+
+            size_t i = begin;
+            for (; i + 32 <= stop; i += 32) {
+                __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + needle.lastOffset));
+                __m256i hit = _mm256_and_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(head, first0), _mm256_cmpeq_epi8(head, first1)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(tail, last0), _mm256_cmpeq_epi8(tail, last1)));
+                for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit)); mask != 0; mask &= mask - 1) {
+                    if (!sink(i + LowestBit(mask))) {
+                        return false;
+                    }
+                }
+            }
+            return ScanScalar(data, i, stop, needle, sink);
+        }
+
+        // Byte counts accumulate in 8-bit lanes for at most 255 blocks, then
+        // get widened with SAD; no popcount needed
+        size_t CountByteSse2(const uint8_t* data, size_t length, uint8_t byte) {
+            const __m128i target = _mm_set1_epi8(static_cast<char>(byte));
+            const __m128i zero = _mm_setzero_si128();
+            __m128i total = zero;
+            size_t i = 0;
+            while (i + 16 <= length) {
+                __m128i counts = zero;
+                for (size_t blocks = 0; blocks < 255 && i + 16 <= length; ++blocks, i += 16) {
+                    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(bytes, target));
+                }
+                total = _mm_add_epi64(total, _mm_sad_epu8(counts, zero));
+            }
+            uint64_t lanes[2];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), total);
+            return static_cast<size_t>(lanes[0] + lanes[1]) + CountByteScalar(data + i, length - i, byte);
+        }
+
+        LUMOS_TARGET("avx2") size_t CountByteAvx2(const uint8_t* data, size_t length, uint8_t byte) {
+            const __m256i target = _mm256_set1_epi8(static_cast<char>(byte));
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i total = zero;
+            size_t i = 0;
+            while (i + 32 <= length) {
+                __m256i counts = zero;
+                for (size_t blocks = 0; blocks < 255 && i + 32 <= length; ++blocks, i += 32) {
+                    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                    counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(bytes, target));
+                }
+                total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, zero));
+            }
+            uint64_t lanes[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+            return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+                   CountByteScalar(data + i, length - i, byte);
+        }
+#endif
+
+        template <typename Sink>
+        bool ScanCandidates(const uint8_t* data, size_t begin, size_t stop, const Needle& needle, Sink& sink) {
+#ifdef LUMOS_X64
+            return g_hasAvx2 ? ScanAvx2(data, begin, stop, needle, sink) : ScanSse2(data, begin, stop, needle, sink);
+#else
+            return ScanScalar(data, begin, stop, needle, sink);
+#endif
+        }
+
+        Needle MakeNeedle(const std::string& pattern, const std::string& alternate) {
+            Needle needle;
+            needle.first[0] = static_cast<uint8_t>(pattern.front());
+            needle.first[1] = static_cast<uint8_t>(alternate.front());
+            needle.last[0] = static_cast<uint8_t>(pattern.back());
+            needle.last[1] = static_cast<uint8_t>(alternate.back());
+            needle.lastOffset = pattern.size() - 1;
+            return needle;
+        }
+
+        size_t CountNewlines(const uint8_t* data, size_t length) {
+#ifdef LUMOS_X64
+            return g_hasAvx2 ? CountByteAvx2(data, length, '\n') : CountByteSse2(data, length, '\n');
+#else
+            return CountByteScalar(data, length, '\n');
+#endif
+        }
+    }
+
+    TextSearch::TextSearch(WorkerPool& workers)
+        : m_workers(workers)
+        , m_ignoreCase(false)
+        , m_nextToPublish(0)
+        , m_linesBefore(0)
+        , m_lastEnd(0)
+        , m_scannedBytes(0)
+        , m_stopped(false)
+        , m_truncated(false)
+        , m_pendingChunks(0)
+    {
+    }
+
+    TextSearch::~TextSearch() = default;
+
+    bool TextSearch::Compile(const TextSearchOptions& options, std::string& error) {
+        m_pattern.clear();
+        m_alternate.clear();
+        m_units.clear();
+        m_regex.reset();
+        m_ignoreCase = options.ignoreCase;
+
+        if (options.pattern.empty()) {
+            error = "Empty search pattern";
+            return false;
+        }
+        if (options.pattern.size() > MAX_PATTERN_BYTES) {
+            error = "Search pattern too long";
+            return false;
+        }
+
+        if (options.regex) {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (options.ignoreCase) {
+                flags |= std::regex::icase;
+            }
+            try {
+                m_regex = std::make_unique<std::regex>(options.pattern, flags);
+            } catch (const std::regex_error& e) {
+                error = e.what();
+                return false;
+            }
+            CompileLiteral(RequiredPrefix(options.pattern));
+            return true;
+        }
+
+        CompileLiteral(options.pattern);
+        return true;
+    }
+
+    void TextSearch::CompileLiteral(std::string_view pattern) {
+        if (!m_ignoreCase) {
+            m_pattern = pattern;
+            m_alternate = m_pattern;
+            return;
+        }
+
+        for (size_t i = 0; i < pattern.size();) {
+            size_t length = Utf8SequenceLength(pattern, i);
+            if (length == 1) {
+                auto c = static_cast<uint32_t>(static_cast<unsigned char>(pattern[i]));
+                m_pattern.push_back(static_cast<char>(ToLower(c)));
+                m_alternate.push_back(static_cast<char>(ToUpper(ToLower(c))));
+            } else if (length == 2) {
+                uint32_t cp = ((static_cast<unsigned char>(pattern[i]) & 0x1Fu) << 6) |
+                              (static_cast<unsigned char>(pattern[i + 1]) & 0x3Fu);
+                uint32_t lower = ToLower(cp);
+                AppendTwoByte(m_pattern, lower);
+                AppendTwoByte(m_alternate, ToUpper(lower));
+            } else {
+                // Wider characters have no pairs in the table; malformed bytes match as written
+                length = length == 0 ? 1 : length;
+                m_pattern.append(pattern.substr(i, length));
+                m_alternate.append(pattern.substr(i, length));
+            }
+            m_units.push_back(static_cast<uint8_t>(length));
+            i += length;
+        }
+    }
+
+    size_t TextSearch::FindLiteral(ByteView text, size_t from, size_t to) const {
+        if (text.Size() < m_pattern.size()) {
+            return SIZE_MAX;
+        }
+        Needle needle = MakeNeedle(m_pattern, m_alternate);
+        size_t stop = std::min<size_t>(to, text.Size() - needle.lastOffset);
+        size_t found = SIZE_MAX;
+        auto sink = [&](size_t position) {
+            if (!MatchesAt(text.Data() + position)) {
+                return true;
+            }
+            found = position;
+            return false;
+        };
+        if (from < stop) {
+            ScanCandidates(text.Data(), from, stop, needle, sink);
+        }
+        return found;
+    }
+
+    bool TextSearch::MatchesAt(const uint8_t* at) const {
+        const char* text = reinterpret_cast<const char*>(at);
+        if (!m_ignoreCase) {
+            return std::memcmp(text, m_pattern.data(), m_pattern.size()) == 0;
+        }
+        // Whole characters must match one form or the other: mixing the lead
+        // byte of one case with the tail of the other spells a third letter
+        size_t offset = 0;
+        for (uint8_t length : m_units) {
+            if (std::memcmp(text + offset, m_pattern.data() + offset, length) != 0 &&
+                std::memcmp(text + offset, m_alternate.data() + offset, length) != 0) {
+                return false;
+            }
+            offset += length;
+        }
+        return true;
+    }
+
+    TextSearchSummary TextSearch::Run(ByteView text, const CancellationToken& cancellation,
+                                      TextMatchCallback onMatches) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_matches.clear();
+        m_chunks.clear();
+        m_nextToPublish = 0;
+        m_linesBefore = 0;
+        m_lastEnd = 0;
+        m_scannedBytes = 0;
+        m_onMatches = std::move(onMatches);
+        m_stopped.store(false);
+        m_truncated = false;
+
+        if (m_pattern.empty() && !m_regex) {
+            return { 0, 0, false, false };
+        }
+
+        // Cut at line breaks so every chunk starts a line (regex matching is
+        // per line); a line longer than a whole chunk is cut where it falls
+        const uint8_t* data = text.Data();
+        size_t size = text.Size();
+        for (size_t begin = 0; begin < size;) {
+            size_t end = size - begin > CHUNK_SIZE ? begin + CHUNK_SIZE : size;
+            if (end < size) {
+                size_t window = size - end < CHUNK_SIZE ? size - end : CHUNK_SIZE;
+                auto newline = static_cast<const uint8_t*>(std::memchr(data + end, '\n', window));
+                if (newline != nullptr) {
+                    end = static_cast<size_t>(newline - data) + 1;
+                }
+            }
+            m_chunks.push_back(Chunk{ begin, end, {}, 0, false, false });
+            begin = end;
+        }
+
+        m_pendingChunks = m_chunks.size();
+        for (size_t i = 0; i < m_chunks.size(); ++i) {
+            m_workers.Submit([this, i, text, cancellation] { ScanChunk(m_chunks[i], text, cancellation); });
+        }
+        m_finished.wait(lock, [this] { return m_pendingChunks == 0; });
+        m_onMatches = nullptr;
+
+        return { m_matches.size(), m_scannedBytes, m_truncated, cancellation.IsCancellationRequested() };
+    }
+
+    void TextSearch::ScanChunk(Chunk& chunk, ByteView text, const CancellationToken& cancellation) {
+        bool scanned = false;
+        if (!m_stopped.load(std::memory_order_relaxed) && !cancellation.IsCancellationRequested()) {
+            if (m_regex) {
+                scanned = ScanRegex(chunk, text, cancellation);
+            } else {
+                scanned = ScanLiteral(chunk, text, cancellation);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        chunk.scanned = scanned;
+        chunk.done = true;
+        Publish();
+        if (--m_pendingChunks == 0) {
+            m_finished.notify_all();
+        }
+    }
+
+    bool TextSearch::ScanLiteral(Chunk& chunk, ByteView text, const CancellationToken& cancellation) {
+        const uint8_t* data = text.Data();
+        size_t length = m_pattern.size();
+        if (text.Size() < length) {
+            chunk.newlines = CountNewlines(data + chunk.begin, chunk.end - chunk.begin);
+            return true;
+        }
+
+        Needle needle = MakeNeedle(m_pattern, m_alternate);
+
+        // Matches may run past the chunk end, but only start inside it
+        size_t stop = std::min<size_t>(chunk.end, text.Size() - needle.lastOffset);
+        size_t next = chunk.begin;       // Matches do not overlap
+        size_t counted = chunk.begin;    // Newlines before this offset are in `line`
+        uint64_t line = 0;
+        size_t candidates = 0;
+        bool stopped = false;
+
+        auto sink = [&](size_t position) {
+            if (++candidates % STOP_CHECK_INTERVAL == 0 &&
+                (m_stopped.load(std::memory_order_relaxed) || cancellation.IsCancellationRequested())) {
+                stopped = true;
+                return false;
+            }
+            if (position < next || !MatchesAt(data + position)) {
+                return true;
+            }
+            line += CountNewlines(data + counted, position - counted);
+            counted = position;
+            chunk.matches.push_back(TextMatch{ position, static_cast<uint32_t>(length), line });
+            next = position + length;
+            // One past the cap tells Publish() the index is truncated
+            return chunk.matches.size() <= MAX_MATCHES;
+        };
+
+        if (chunk.begin < stop) {
+            ScanCandidates(data, chunk.begin, stop, needle, sink);
+        }
+        if (stopped) {
+            return false;
+        }
+        chunk.newlines = line + CountNewlines(data + counted, chunk.end - counted);
+        return true;
+    }
+
+    bool TextSearch::ScanRegex(Chunk& chunk, ByteView text, const CancellationToken& cancellation) {
+        const char* base = reinterpret_cast<const char*>(text.Data());
+        uint64_t line = 0;
+        size_t lines = 0;
+
+        for (size_t lineStart = chunk.begin; lineStart < chunk.end; ++line) {
+            if (++lines % STOP_CHECK_INTERVAL == 0 &&
+                (m_stopped.load(std::memory_order_relaxed) || cancellation.IsCancellationRequested())) {
+                return false;
+            }
+
+            if (!m_pattern.empty()) {
+                // Go straight to the next line holding the required prefix
+                size_t found = FindLiteral(text, lineStart, chunk.end);
+                size_t skipTo = chunk.end;
+                if (found != SIZE_MAX) {
+                    skipTo = found;
+                    while (skipTo > lineStart && base[skipTo - 1] != '\n') {
+                        --skipTo;
+                    }
+                }
+                line += CountNewlines(text.Data() + lineStart, skipTo - lineStart);
+                lineStart = skipTo;
+                if (lineStart >= chunk.end) {
+                    break;
+                }
+            }
+
+            auto newline = static_cast<const char*>(std::memchr(base + lineStart, '\n', chunk.end - lineStart));
+            size_t lineEnd = newline ? static_cast<size_t>(newline - base) : chunk.end;
+            size_t searchEnd = lineEnd;
+            if (searchEnd > lineStart && base[searchEnd - 1] == '\r') {
+                --searchEnd;
+            }
+            if (searchEnd - lineStart > MAX_REGEX_LINE) {
+                searchEnd = lineStart + MAX_REGEX_LINE;
+            }
+
+            const char* from = base + lineStart;
+            const char* end = base + searchEnd;
+            auto flags = std::regex_constants::match_default;
+            std::cmatch match;
+            while (from <= end && std::regex_search(from, end, match, *m_regex, flags)) {
+                const char* at = match[0].first;
+                size_t length = static_cast<size_t>(match.length(0));
+                // Later searches on the line must see the character before them for ^ and \b
+                flags |= std::regex_constants::match_prev_avail;
+                if (length == 0) {
+                    from = at + 1; // Empty matches (a*, ^) highlight nothing
+                    continue;
+                }
+                chunk.matches.push_back(TextMatch{ static_cast<uint64_t>(at - base), static_cast<uint32_t>(length), line });
+                if (chunk.matches.size() > MAX_MATCHES) {
+                    chunk.newlines = line;
+                    return true;
+                }
+                from = match[0].second;
+            }
+
+            if (newline == nullptr) {
+                break;
+            }
+            lineStart = lineEnd + 1;
+        }
+        chunk.newlines = line;
+        return true;
+    }
+
+    void TextSearch::Publish() {
+        while (m_nextToPublish < m_chunks.size() && m_chunks[m_nextToPublish].done) {
+            Chunk& chunk = m_chunks[m_nextToPublish++];
+            if (!chunk.scanned) {
+                m_stopped.store(true); // Cancelled: later matches would leave a hole in the index
+            }
+            if (m_stopped.load()) {
+                chunk.matches = {};
+                continue;
+            }
+
+            size_t first = m_matches.size();
+            for (TextMatch& match : chunk.matches) {
+                if (match.offset < m_lastEnd) {
+                    continue; // Overlaps the previous chunk's last match (pattern spans a line break)
+                }
+                if (m_matches.size() >= MAX_MATCHES) {
+                    m_truncated = true;
+                    m_stopped.store(true);
+                    break;
+                }
+                match.line += m_linesBefore;
+                m_matches.push_back(match);
+                m_lastEnd = match.offset + match.length;
+            }
+            m_linesBefore += chunk.newlines;
+            m_scannedBytes = chunk.end;
+            chunk.matches = {};
+
+            if (m_onMatches && !m_onMatches(m_matches.data() + first, m_matches.size() - first, m_scannedBytes)) {
+                m_stopped.store(true);
+            }
+        }
+    }
+
+    size_t TextSearch::MatchCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_matches.size();
+    }
+
+    std::vector<TextMatch> TextSearch::Matches(size_t first, size_t count) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (first >= m_matches.size()) {
+            return {};
+        }
+        size_t last = first + std::min(count, m_matches.size() - first);
+        return std::vector<TextMatch>(m_matches.begin() + first, m_matches.begin() + last);
+    }
+
+    size_t TextSearch::FindMatchAt(uint64_t offset) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::lower_bound(m_matches.begin(), m_matches.end(), offset,
+                                   [](const TextMatch& match, uint64_t value) { return match.offset < value; });
+        return static_cast<size_t>(it - m_matches.begin());
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../common/ByteView.h"
+#include "../../common/CancellationToken.h"
+#include "../../common/WorkerPool.h"
+
+namespace Lumos {
+    struct TextSearchOptions {
+        std::string pattern;      // UTF-8
+        bool ignoreCase = false;  // ASCII plus Latin-1, Latin Extended-A, Greek and Cyrillic letters
+        bool regex = false;       // ECMAScript syntax, matched within single lines
+    };
+
+    struct TextMatch {
+        uint64_t offset;
+        uint32_t length;
+        uint64_t line;  // 0-based
+    };
+
+    struct TextSearchSummary {
+        uint64_t matches;
+        uint64_t scannedBytes;
+        bool truncated;   // Stopped at MAX_MATCHES
+        bool cancelled;
+    };
+
+    // New matches in offset order, continuing where the previous call left
+    // off, and how far into the text the scan is complete. Called from
+    // worker threads, one call at a time; return false to stop the scan.
+    using TextMatchCallback = std::function<bool(const TextMatch* matches, size_t count, uint64_t scannedBytes)>;
+
+    // Find-in-preview over a memory-mapped text file. The text is cut into
+    // CHUNK_SIZE pieces at line breaks and scanned on the worker pool; each
+    // chunk's matches are published as soon as every chunk before it is
+    // done, so the first hits show while the rest of the file is still being
+    // scanned and the published matches always form a sorted index. Literal
+    // patterns are located with a SIMD filter on their first and last bytes
+    // and then verified; matches do not overlap, like an editor's Find Next.
+    class TextSearch {
+    public:
+        static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+        static constexpr size_t MAX_MATCHES = 100000;
+        // std::regex recurses per character; longer lines are searched in their first MAX_REGEX_LINE bytes
+        static constexpr size_t MAX_REGEX_LINE = 4096;
+
+        explicit TextSearch(WorkerPool& workers);
+        ~TextSearch();
+
+        TextSearch(const TextSearch&) = delete;
+        TextSearch& operator=(const TextSearch&) = delete;
+
+        // False, with the reason in `error`, if the pattern is empty or does
+        // not compile
+        bool Compile(const TextSearchOptions& options, std::string& error);
+
+        // Scan `text`, which must stay mapped until this returns. Blocks until
+        // the scan finishes, is cancelled or `onMatches` returns false, so it
+        // must not be called from the worker pool itself.
+        TextSearchSummary Run(ByteView text, const CancellationToken& cancellation,
+                              TextMatchCallback onMatches = nullptr);
+
+        // The index built by the last Run(); safe to read while it runs
+        size_t MatchCount() const;
+        std::vector<TextMatch> Matches(size_t first, size_t count) const;
+        // Index of the first match starting at or after `offset`; MatchCount() if none
+        size_t FindMatchAt(uint64_t offset) const;
+
+    private:
+        struct Chunk {
+            uint64_t begin;
+            uint64_t end;
+            std::vector<TextMatch> matches;  // Lines relative to the chunk start
+            uint64_t newlines;
+            bool done;
+            bool scanned;  // False if skipped or abandoned part-way
+        };
+
+        void CompileLiteral(std::string_view pattern);
+        // First match of the literal pattern starting in [from, to), or SIZE_MAX
+        size_t FindLiteral(ByteView text, size_t from, size_t to) const;
+        void ScanChunk(Chunk& chunk, ByteView text, const CancellationToken& cancellation);
+        bool ScanLiteral(Chunk& chunk, ByteView text, const CancellationToken& cancellation);
+        bool ScanRegex(Chunk& chunk, ByteView text, const CancellationToken& cancellation);
+        bool MatchesAt(const uint8_t* at) const;
+        void Publish();
+
+        WorkerPool& m_workers;
+
+        // Compiled pattern
+        std::string m_pattern;           // Folded to lower case when ignoring case; a regex's required prefix
+        std::string m_alternate;         // Same bytes with each letter in its other case
+        std::vector<uint8_t> m_units;    // Byte length of each code point of m_pattern
+        std::unique_ptr<std::regex> m_regex;
+        bool m_ignoreCase;
+
+        // Current run, guarded by m_mutex except each chunk's scan
+        mutable std::mutex m_mutex;
+        std::vector<Chunk> m_chunks;
+        size_t m_nextToPublish;
+        uint64_t m_linesBefore;
+        uint64_t m_lastEnd;
+        uint64_t m_scannedBytes;
+        TextMatchCallback m_onMatches;
+        std::atomic<bool> m_stopped;
+        bool m_truncated;
+        size_t m_pendingChunks;
+        std::condition_variable m_finished;
+        std::vector<TextMatch> m_matches;
+    };
+}
@@ -0,0 +1,212 @@
+#include "RawTiffTileSource.h"
+#include <algorithm>
+#include <vector>
+
+namespace Lumos {
+    namespace {
+        constexpr uint32_t COMPRESSION_NONE = 1;
+        constexpr uint32_t PHOTOMETRIC_WHITE_IS_ZERO = 0;
+        constexpr uint32_t PHOTOMETRIC_BLACK_IS_ZERO = 1;
+        constexpr uint32_t PHOTOMETRIC_RGB = 2;
+        constexpr uint32_t PLANAR_CHUNKY = 1;
+    }
+
+    std::unique_ptr<RawTiffTileSource> RawTiffTileSource::Open(std::wstring_view path) {
+        MappedFile file;
+        if (!file.Open(path, MapAccess::Random)) {
+            return nullptr;
+        }
+
+        std::unique_ptr<RawTiffTileSource> source(new RawTiffTileSource(std::move(file)));
+        if (!source->ReadLayout()) {
+            return nullptr;
+        }
+        return source;
+    }
+
+    RawTiffTileSource::RawTiffTileSource(MappedFile file)
+        : m_file(std::move(file))
+        , m_tiff(m_file.View())
+        , m_width(0)
+        , m_height(0)
+        , m_samples(1)
+        , m_invert(false)
+        , m_tiled(false)
+        , m_chunkWidth(0)
+        , m_chunkHeight(0)
+        , m_chunksAcross(0)
+        , m_chunkOffsets{}
+    {
+    }
+
+    bool RawTiffTileSource::ReadLayout() {
+        if (!m_tiff.IsValid()) {
+            return false;
+        }
+
+        uint32_t compression = COMPRESSION_NONE;
+        uint32_t bitsPerSample = 1;
+        uint32_t photometric = PHOTOMETRIC_BLACK_IS_ZERO;
+        uint32_t planar = PLANAR_CHUNKY;
+        uint32_t rowsPerStrip = 0;
+        bool haveStrips = false;
+        TiffEntry stripOffsets{};
+
+        bool found = m_tiff.VisitIfd(m_tiff.FirstIfdOffset(), [&](const TiffEntry& entry) {
+            switch (entry.tag) {
+            case TiffTag::ImageWidth: m_width = m_tiff.Value(entry); break;
+            case TiffTag::ImageLength: m_height = m_tiff.Value(entry); break;
+            case TiffTag::BitsPerSample: bitsPerSample = m_tiff.Value(entry); break;
+            case TiffTag::Compression: compression = m_tiff.Value(entry); break;
+            case TiffTag::Photometric: photometric = m_tiff.Value(entry); break;
+            case TiffTag::SamplesPerPixel: m_samples = m_tiff.Value(entry); break;
+            case TiffTag::RowsPerStrip: rowsPerStrip = m_tiff.Value(entry); break;
+            case TiffTag::PlanarConfiguration: planar = m_tiff.Value(entry); break;
+            case TiffTag::TileWidth: m_chunkWidth = m_tiff.Value(entry); break;
+            case TiffTag::TileLength: m_chunkHeight = m_tiff.Value(entry); break;
+            case TiffTag::TileOffsets:
+                m_chunkOffsets = entry;
+                m_tiled = true;
+                break;
+            case TiffTag::StripOffsets:
+                stripOffsets = entry;
+                haveStrips = true;
+                break;
+            }
+        });
+
+        if (!found || m_width == 0 || m_height == 0 || compression != COMPRESSION_NONE ||
+            bitsPerSample != 8 || planar != PLANAR_CHUNKY || m_samples < 1 || m_samples > 4) {
+            return false;
+        }
+        if (photometric == PHOTOMETRIC_RGB ? m_samples < 3 : (photometric > PHOTOMETRIC_BLACK_IS_ZERO || m_samples > 2)) {
+            return false;
+        }
+        m_invert = photometric == PHOTOMETRIC_WHITE_IS_ZERO;
+
+        if (m_tiled) {
+            if (m_chunkWidth == 0 || m_chunkHeight == 0) {
+                return false;
+            }
+        } else {
+            if (!haveStrips) {
+                return false;
+            }
+            m_chunkOffsets = stripOffsets;
+            m_chunkWidth = m_width;
+            m_chunkHeight = (rowsPerStrip == 0 || rowsPerStrip > m_height) ? m_height : rowsPerStrip;
+        }
+        m_chunksAcross = (m_width + m_chunkWidth - 1) / m_chunkWidth;
+
+        uint64_t chunksDown = (m_height + m_chunkHeight - 1) / m_chunkHeight;
+        return m_chunkOffsets.count >= chunksDown * m_chunksAcross;
+    }
+
+    const uint8_t* RawTiffTileSource::Locate(uint32_t x, uint32_t y, uint32_t& contiguous) const {
+        uint32_t column = x / m_chunkWidth;
+        uint32_t row = y / m_chunkHeight;
+        uint64_t chunkOffset = m_tiff.Value(m_chunkOffsets, row * m_chunksAcross + column);
+
+        uint32_t innerX = x % m_chunkWidth;
+        uint32_t innerY = y % m_chunkHeight;
+        contiguous = std::min(m_chunkWidth - innerX, m_width - x);
+
+        uint64_t position = chunkOffset + (static_cast<uint64_t>(innerY) * m_chunkWidth + innerX) * m_samples;
+        ByteView data = m_file.View();
+        if (!data.Has(static_cast<size_t>(position), static_cast<size_t>(contiguous) * m_samples)) {
+            return nullptr;
+        }
+        return data.Data() + position;
+    }
+
+    void RawTiffTileSource::ReadRow(uint32_t y, uint32_t x, uint32_t count, uint32_t step, uint8_t* out) const {
+        y = std::min(y, m_height - 1);
+        uint32_t i = 0;
+        while (i < count) {
+            uint32_t px = std::min(x + i * step, m_width - 1);
+            uint32_t contiguous = 0;
+            const uint8_t* src = Locate(px, y, contiguous);
+
+            // Pixels of this output row that fall inside the same chunk row
+            uint32_t run = std::min(count - i, (contiguous + step - 1) / step);
+            if (x + i * step >= m_width) {
+                run = 1; // Clamped past the right edge: repeat the last column
+            }
+
+            uint8_t* dst = out + static_cast<size_t>(i) * 4;
+            for (uint32_t k = 0; k < run; ++k, dst += 4) {
+                if (src == nullptr) {
+                    dst[0] = dst[1] = dst[2] = dst[3] = 0; // Chunk missing from a truncated file
+                    continue;
+                }
+                const uint8_t* p = src + static_cast<size_t>(k) * step * m_samples;
+                switch (m_samples) {
+                case 1:
+                case 2: {
+                    uint8_t gray = m_invert ? static_cast<uint8_t>(255 - p[0]) : p[0];
+                    dst[0] = dst[1] = dst[2] = gray;
+                    dst[3] = m_samples == 2 ? p[1] : 255;
+                    break;
+                }
+                default:
+                    dst[0] = p[2];
+                    dst[1] = p[1];
+                    dst[2] = p[0];
+                    dst[3] = m_samples == 4 ? p[3] : 255;
+                    break;
+                }
+            }
+            i += run;
+        }
+    }
+
+    bool RawTiffTileSource::DecodeRegion(const TileRegion& region, uint32_t level,
+                                         uint8_t* bgra, size_t stride,
+                                         const CancellationToken& cancellation) {
+        if (region.x >= m_width || region.y >= m_height || region.width == 0 || region.height == 0 || level > 31) {
+            return false;
+        }
+
+        uint32_t step = 1u << level;
+        uint32_t outWidth = (region.width + step - 1) >> level;
+        uint32_t outHeight = (region.height + step - 1) >> level;
+
+        if (level == 0) {
+            for (uint32_t oy = 0; oy < outHeight; ++oy) {
+                if (cancellation.IsCancellationRequested()) {
+                    return false;
+                }
+                ReadRow(region.y + oy, region.x, outWidth, 1, bgra + oy * stride);
+            }
+            return true;
+        }
+
+        // Average a 2x2 sample spread across each 2^level cell: far cheaper
+        // than a full box filter on gigapixel inputs, and free of the
+        // shimmering plain point sampling gives
+        thread_local std::vector<uint8_t> rows;
+        rows.resize(static_cast<size_t>(outWidth) * 4 * 4);
+        uint8_t* a = rows.data();
+        uint8_t* b = a + static_cast<size_t>(outWidth) * 4;
+        uint8_t* c = b + static_cast<size_t>(outWidth) * 4;
+        uint8_t* d = c + static_cast<size_t>(outWidth) * 4;
+        uint32_t half = step / 2;
+
+        for (uint32_t oy = 0; oy < outHeight; ++oy) {
+            if (cancellation.IsCancellationRequested()) {
+                return false;
+            }
+            uint32_t y = region.y + (oy << level);
+            ReadRow(y, region.x, outWidth, step, a);
+            ReadRow(y, region.x + half, outWidth, step, b);
+            ReadRow(y + half, region.x, outWidth, step, c);
+            ReadRow(y + half, region.x + half, outWidth, step, d);
+
+            uint8_t* out = bgra + oy * stride;
+            for (size_t i = 0; i < static_cast<size_t>(outWidth) * 4; ++i) {
+                out[i] = static_cast<uint8_t>((a[i] + b[i] + c[i] + d[i] + 2) >> 2);
+            }
+        }
+        return true;
+    }
+}
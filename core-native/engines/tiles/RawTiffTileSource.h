@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include "TileSource.h"
+#include "../image/TiffReader.h"
+#include "../../io/MappedFile.h"
+
+namespace Lumos {
+    // Uncompressed, 8-bit, chunky TIFF (gray, gray+alpha, RGB, RGBA), tiled
+    // or stripped, read straight from a memory map. This is the layout scans
+    // and stitched panoramas are usually saved in; a region decode touches
+    // only the pages holding the sampled rows.
+    class RawTiffTileSource : public TileSource {
+    public:
+        // Null if the file is not a TIFF in this layout
+        static std::unique_ptr<RawTiffTileSource> Open(std::wstring_view path);
+
+        uint32_t Width() const override { return m_width; }
+        uint32_t Height() const override { return m_height; }
+
+        bool DecodeRegion(const TileRegion& region, uint32_t level,
+                          uint8_t* bgra, size_t stride,
+                          const CancellationToken& cancellation) override;
+
+        const char* Name() const override { return "raw-tiff"; }
+
+    private:
+        explicit RawTiffTileSource(MappedFile file);
+        bool ReadLayout();
+
+        // Gather `count` pixels of row `y`, starting at `x` and `step` pixels
+        // apart (clamped to the right edge), as BGRA into `out`
+        void ReadRow(uint32_t y, uint32_t x, uint32_t count, uint32_t step, uint8_t* out) const;
+
+        // Start of the chunk (tile or strip) holding pixel (x, y), and how many
+        // pixels of that row are contiguous from x. Null if outside the file.
+        const uint8_t* Locate(uint32_t x, uint32_t y, uint32_t& contiguous) const;
+
+        MappedFile m_file;
+        TiffReader m_tiff;
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_samples;
+        bool m_invert; // WhiteIsZero grayscale
+        bool m_tiled;
+        uint32_t m_chunkWidth;   // Tile width, or image width for strips
+        uint32_t m_chunkHeight;  // Tile height, or rows per strip
+        uint32_t m_chunksAcross;
+        TiffEntry m_chunkOffsets;
+    };
+}
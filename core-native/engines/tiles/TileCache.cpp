@@ -0,0 +1,108 @@
+#include "TileCache.h"
+
+namespace Lumos {
+    namespace {
+        // Bookkeeping overhead per tile on top of the pixels
+        constexpr size_t ENTRY_OVERHEAD = 96;
+    }
+
+    TileCache::TileCache(MemoryGovernor& governor, std::string name, PoolPriority priority)
+        : m_bytes(0)
+        , m_hits(0)
+        , m_misses(0)
+    {
+        m_pool = governor.RegisterPool(std::move(name), priority, [this](size_t bytes) { return Trim(bytes); });
+    }
+
+    TileCache::~TileCache() {
+        Clear();
+    }
+
+    bool TileCache::Put(std::shared_ptr<const Tile> tile) {
+        uint64_t key = Key(tile->level, tile->x, tile->y);
+        size_t bytes = tile->pixels.size() + ENTRY_OVERHEAD;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto existing = m_index.find(key);
+        if (existing != m_index.end()) {
+            EraseLocked(existing->second);
+        }
+
+        while (!m_pool->TryCharge(bytes)) {
+            if (EvictLruLocked() == 0) {
+                return false;
+            }
+        }
+
+        m_lru.push_front(Entry{ key, std::move(tile), bytes });
+        m_index.emplace(key, m_lru.begin());
+        m_bytes += bytes;
+        return true;
+    }
+
+    std::shared_ptr<const Tile> TileCache::Get(uint64_t key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        m_pool->Touch();
+        ++m_hits;
+        return it->second->tile;
+    }
+
+    bool TileCache::Contains(uint64_t key) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_index.count(key) != 0;
+    }
+
+    void TileCache::Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pool->Release(m_bytes);
+        m_lru.clear();
+        m_index.clear();
+        m_bytes = 0;
+    }
+
+    TileCacheStats TileCache::Stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return { m_hits, m_misses, m_lru.size(), m_bytes };
+    }
+
+    size_t TileCache::Trim(size_t bytes) {
+        // Same rule as PreviewCache: never block inside a reclaim
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return 0;
+        }
+
+        size_t freed = 0;
+        while (freed < bytes) {
+            size_t got = EvictLruLocked();
+            if (got == 0) {
+                break;
+            }
+            freed += got;
+        }
+        return freed;
+    }
+
+    size_t TileCache::EvictLruLocked() {
+        if (m_lru.empty()) {
+            return 0;
+        }
+        size_t bytes = m_lru.back().bytes;
+        EraseLocked(std::prev(m_lru.end()));
+        return bytes;
+    }
+
+    void TileCache::EraseLocked(std::list<Entry>::iterator it) {
+        m_pool->Release(it->bytes);
+        m_bytes -= it->bytes;
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../memory/MemoryGovernor.h"
+
+namespace Lumos {
+    // One decoded tile: 32-bit BGRA, rows `width * 4` bytes apart
+    struct Tile {
+        uint32_t level;
+        uint32_t x;      // Tile column at this level
+        uint32_t y;      // Tile row at this level
+        uint32_t width;  // Pixels; edge tiles are narrower than TILE_SIZE
+        uint32_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct TileCacheStats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t tiles;
+        size_t bytes;
+    };
+
+    // LRU of decoded tiles for one image, charged to a governor pool so
+    // panning a gigapixel image cannot outgrow the process budget
+    class TileCache {
+    public:
+        explicit TileCache(MemoryGovernor& governor, std::string name = "tile-cache",
+                           PoolPriority priority = PoolPriority::Cache);
+        ~TileCache();
+
+        TileCache(const TileCache&) = delete;
+        TileCache& operator=(const TileCache&) = delete;
+
+        static uint64_t Key(uint32_t level, uint32_t x, uint32_t y) {
+            return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(y) << 24) | x;
+        }
+
+        // False if the budget could not be met even after evicting our own tiles
+        bool Put(std::shared_ptr<const Tile> tile);
+        std::shared_ptr<const Tile> Get(uint64_t key);
+        bool Contains(uint64_t key) const;
+
+        void Clear();
+        TileCacheStats Stats() const;
+
+    private:
+        struct Entry {
+            uint64_t key;
+            std::shared_ptr<const Tile> tile;
+            size_t bytes;
+        };
+
+        // Evict least recently used tiles until `bytes` are freed (reclaim callback)
+        size_t Trim(size_t bytes);
+        size_t EvictLruLocked();
+        void EraseLocked(std::list<Entry>::iterator it);
+
+        mutable std::mutex m_mutex;
+        std::list<Entry> m_lru; // Most recently used at the front
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+        size_t m_bytes;
+        uint64_t m_hits;
+        uint64_t m_misses;
+
+        std::shared_ptr<MemoryPool> m_pool;
+    };
+}
@@ -0,0 +1,20 @@
+#include "TileSource.h"
+#include "RawTiffTileSource.h"
+#ifdef _WIN32
+#include "WicTileSource.h"
+#endif
+
+namespace Lumos {
+    std::unique_ptr<TileSource> OpenTileSource(std::wstring_view path) {
+        // The memory-mapped reader first: no codec, no lock, truly random access
+        if (auto raw = RawTiffTileSource::Open(path)) {
+            return raw;
+        }
+#ifdef _WIN32
+        if (auto wic = WicTileSource::Open(path)) {
+            return wic;
+        }
+#endif
+        return nullptr;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "../../common/CancellationToken.h"
+
+namespace Lumos {
+    // Rectangle in full-resolution (level 0) pixels
+    struct TileRegion {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // Decodes arbitrary regions of one large image without decoding the rest.
+    // Implementations must allow concurrent DecodeRegion calls.
+    class TileSource {
+    public:
+        virtual ~TileSource() = default;
+
+        virtual uint32_t Width() const = 0;
+        virtual uint32_t Height() const = 0;
+
+        // Decode `region` downsampled by 2^level into 32-bit BGRA (straight
+        // alpha) rows `stride` bytes apart. The output is
+        // ceil(region.width / 2^level) x ceil(region.height / 2^level).
+        // Returns false on failure or cancellation.
+        virtual bool DecodeRegion(const TileRegion& region, uint32_t level,
+                                  uint8_t* bgra, size_t stride,
+                                  const CancellationToken& cancellation) = 0;
+
+        virtual const char* Name() const = 0;
+    };
+
+    // Uncompressed TIFF from a memory map anywhere; WIC codecs on Windows for
+    // everything else. Null if nothing can open the file.
+    std::unique_ptr<TileSource> OpenTileSource(std::wstring_view path);
+}
@@ -0,0 +1,209 @@
+#include "TiledImage.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Lumos {
+    namespace {
+        // One ring of tiles beyond the visible edge: enough to hide a pan
+        // step without decoding a screenful nobody looks at
+        constexpr uint32_t PREFETCH_MARGIN = 1;
+    }
+
+    TiledImage::TiledImage(std::unique_ptr<TileSource> source, WorkerPool& workers, MemoryGovernor& governor,
+                           TileReadyCallback onTileReady)
+        : m_source(std::move(source))
+        , m_workers(workers)
+        , m_cache(governor)
+        , m_onTileReady(std::move(onTileReady))
+        , m_levels(1)
+        , m_outstanding(0)
+        , m_decoded(0)
+        , m_dropped(0)
+        , m_failed(0)
+    {
+        uint32_t edge = std::max(m_source->Width(), m_source->Height());
+        while ((edge >> (m_levels - 1)) > TILE_SIZE && m_levels < 32) {
+            ++m_levels;
+        }
+    }
+
+    TiledImage::~TiledImage() {
+        m_cancellation.Cancel();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wanted.clear();
+        m_drained.wait(lock, [this] { return m_outstanding == 0; });
+    }
+
+    uint32_t TiledImage::TilesAcross(uint32_t level) const {
+        uint64_t span = static_cast<uint64_t>(TILE_SIZE) << level;
+        return static_cast<uint32_t>((Width() + span - 1) / span);
+    }
+
+    uint32_t TiledImage::TilesDown(uint32_t level) const {
+        uint64_t span = static_cast<uint64_t>(TILE_SIZE) << level;
+        return static_cast<uint32_t>((Height() + span - 1) / span);
+    }
+
+    uint32_t TiledImage::LevelForZoom(double zoom) const {
+        if (!(zoom > 0.0) || zoom >= 1.0) {
+            return 0;
+        }
+        // Zoom 0.3 shows the image at 0.3x: level 1 (0.5x) still has more
+        // pixels than the screen, level 2 (0.25x) would be blurry
+        auto level = static_cast<uint32_t>(std::floor(std::log2(1.0 / zoom)));
+        return std::min(level, m_levels - 1);
+    }
+
+    TiledImage::TileRange TiledImage::RangeFor(const Viewport& viewport, uint32_t level, uint32_t margin) const {
+        double zoom = viewport.zoom > 0.0 ? viewport.zoom : 1.0;
+        double halfWidth = viewport.screenWidth / (2.0 * zoom);
+        double halfHeight = viewport.screenHeight / (2.0 * zoom);
+        double span = static_cast<double>(static_cast<uint64_t>(TILE_SIZE) << level);
+
+        auto first = [&](double edge) {
+            double tile = std::floor(edge / span) - margin;
+            return tile > 0.0 ? static_cast<uint32_t>(tile) : 0u;
+        };
+        auto last = [&](double edge, uint32_t count) {
+            double tile = std::floor(edge / span) + 1 + margin;
+            return tile < count ? static_cast<uint32_t>(std::max(tile, 0.0)) : count;
+        };
+
+        TileRange range;
+        range.left = first(viewport.centerX - halfWidth);
+        range.top = first(viewport.centerY - halfHeight);
+        range.right = last(viewport.centerX + halfWidth, TilesAcross(level));
+        range.bottom = last(viewport.centerY + halfHeight, TilesDown(level));
+        return range;
+    }
+
+    void TiledImage::SetViewport(const Viewport& viewport) {
+        uint32_t level = LevelForZoom(viewport.zoom);
+        TileRange visible = RangeFor(viewport, level, 0);
+        TileRange prefetch = RangeFor(viewport, level, PREFETCH_MARGIN);
+
+        // Visible tiles closest to the center first: that is where the eye is
+        double span = static_cast<double>(static_cast<uint64_t>(TILE_SIZE) << level);
+        double centerX = viewport.centerX / span - 0.5;
+        double centerY = viewport.centerY / span - 0.5;
+        struct Candidate {
+            double distance;
+            uint32_t x;
+            uint32_t y;
+        };
+        std::vector<Candidate> order;
+        for (uint32_t y = visible.top; y < visible.bottom; ++y) {
+            for (uint32_t x = visible.left; x < visible.right; ++x) {
+                double dx = x - centerX;
+                double dy = y - centerY;
+                order.push_back(Candidate{ dx * dx + dy * dy, x, y });
+            }
+        }
+        std::sort(order.begin(), order.end(),
+                  [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+        std::unordered_set<uint64_t> wanted;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& candidate : order) {
+            Queue(level, candidate.x, candidate.y, PRIORITY_VISIBLE, wanted);
+        }
+
+        // The next coarser level is a quarter of the work and gives
+        // CoveringTile something to show during fast zooms
+        if (level + 1 < m_levels) {
+            TileRange coarse = RangeFor(viewport, level + 1, 0);
+            for (uint32_t y = coarse.top; y < coarse.bottom; ++y) {
+                for (uint32_t x = coarse.left; x < coarse.right; ++x) {
+                    Queue(level + 1, x, y, PRIORITY_COARSER, wanted);
+                }
+            }
+        }
+
+        for (uint32_t y = prefetch.top; y < prefetch.bottom; ++y) {
+            for (uint32_t x = prefetch.left; x < prefetch.right; ++x) {
+                Queue(level, x, y, PRIORITY_PREFETCH, wanted);
+            }
+        }
+
+        // Jobs for tiles outside `wanted` find out when they start and bail
+        m_wanted.swap(wanted);
+    }
+
+    void TiledImage::Queue(uint32_t level, uint32_t x, uint32_t y, int priority,
+                           std::unordered_set<uint64_t>& wanted) {
+        uint64_t key = TileCache::Key(level, x, y);
+        if (!wanted.insert(key).second || m_cache.Contains(key) || !m_inFlight.insert(key).second) {
+            return;
+        }
+
+        ++m_outstanding;
+        m_workers.Submit([this, level, x, y] { Decode(level, x, y); }, priority);
+    }
+
+    void TiledImage::Decode(uint32_t level, uint32_t x, uint32_t y) {
+        uint64_t key = TileCache::Key(level, x, y);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_cancellation.IsCancellationRequested() || m_wanted.count(key) == 0) {
+                ++m_dropped;
+                FinishJobLocked(key);
+                return;
+            }
+        }
+
+        uint32_t span = TILE_SIZE << level;
+        TileRegion region;
+        region.x = x * span;
+        region.y = y * span;
+        region.width = std::min(span, Width() - region.x);
+        region.height = std::min(span, Height() - region.y);
+
+        auto tile = std::make_shared<Tile>();
+        tile->level = level;
+        tile->x = x;
+        tile->y = y;
+        tile->width = (region.width + (1u << level) - 1) >> level;
+        tile->height = (region.height + (1u << level) - 1) >> level;
+        tile->pixels.resize(static_cast<size_t>(tile->width) * tile->height * 4);
+
+        bool decoded = m_source->DecodeRegion(region, level, tile->pixels.data(), static_cast<size_t>(tile->width) * 4,
+                                              m_cancellation.Token());
+        if (decoded) {
+            ++m_decoded;
+            std::shared_ptr<const Tile> ready = std::move(tile);
+            m_cache.Put(ready); // Over budget: still delivered, just not kept
+            if (m_onTileReady) {
+                m_onTileReady(ready);
+            }
+        } else if (!m_cancellation.IsCancellationRequested()) {
+            ++m_failed;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FinishJobLocked(key);
+    }
+
+    void TiledImage::FinishJobLocked(uint64_t key) {
+        m_inFlight.erase(key);
+        --m_outstanding;
+        m_drained.notify_all();
+    }
+
+    std::shared_ptr<const Tile> TiledImage::GetTile(uint32_t level, uint32_t x, uint32_t y) {
+        return m_cache.Get(TileCache::Key(level, x, y));
+    }
+
+    std::shared_ptr<const Tile> TiledImage::CoveringTile(uint32_t level, uint32_t x, uint32_t y) {
+        for (; level < m_levels; ++level, x >>= 1, y >>= 1) {
+            if (auto tile = m_cache.Get(TileCache::Key(level, x, y))) {
+                return tile;
+            }
+        }
+        return nullptr;
+    }
+
+    TiledImageStats TiledImage::Stats() const {
+        return { m_decoded.load(), m_dropped.load(), m_failed.load(), m_cache.Stats() };
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include "TileCache.h"
+#include "TileSource.h"
+#include "../../common/CancellationToken.h"
+#include "../../common/WorkerPool.h"
+
+namespace Lumos {
+    // What is on screen, in full-resolution image pixels
+    struct Viewport {
+        double centerX;
+        double centerY;
+        double zoom;          // Screen pixels per image pixel; 1 = actual size
+        uint32_t screenWidth;
+        uint32_t screenHeight;
+    };
+
+    struct TiledImageStats {
+        uint64_t decoded;   // Tiles decoded
+        uint64_t dropped;   // Queued tiles skipped because the viewport moved on
+        uint64_t failed;
+        TileCacheStats cache;
+    };
+
+    // Multi-resolution pyramid over a TileSource, populated lazily. Level L
+    // is the image downsampled by 2^L, cut into TILE_SIZE squares; the top
+    // level fits in a single tile. Only tiles the viewport needs are decoded,
+    // on the worker pool, visible ones first.
+    class TiledImage {
+    public:
+        // Runs on a worker thread once a requested tile is in the cache
+        using TileReadyCallback = std::function<void(const std::shared_ptr<const Tile>&)>;
+
+        static constexpr uint32_t TILE_SIZE = 256;
+
+        TiledImage(std::unique_ptr<TileSource> source, WorkerPool& workers, MemoryGovernor& governor,
+                   TileReadyCallback onTileReady = nullptr);
+        ~TiledImage();
+
+        TiledImage(const TiledImage&) = delete;
+        TiledImage& operator=(const TiledImage&) = delete;
+
+        uint32_t Width() const { return m_source->Width(); }
+        uint32_t Height() const { return m_source->Height(); }
+        uint32_t LevelCount() const { return m_levels; }
+        uint32_t TilesAcross(uint32_t level) const;
+        uint32_t TilesDown(uint32_t level) const;
+
+        // Pyramid level whose resolution is closest to `zoom` without going
+        // below it, clamped to the levels this image has
+        uint32_t LevelForZoom(double zoom) const;
+
+        // Queue the tiles `viewport` needs and forget those it no longer
+        // does. Cheap; call on every pan/zoom step.
+        void SetViewport(const Viewport& viewport);
+
+        // Cached tile or null
+        std::shared_ptr<const Tile> GetTile(uint32_t level, uint32_t x, uint32_t y);
+
+        // Cached tile, or the nearest cached coarser tile containing it (to
+        // draw scaled up while the sharp one decodes). Null if none.
+        std::shared_ptr<const Tile> CoveringTile(uint32_t level, uint32_t x, uint32_t y);
+
+        TiledImageStats Stats() const;
+
+    private:
+        // Priorities on the worker pool; lower runs first
+        enum : int {
+            PRIORITY_VISIBLE = 0,
+            PRIORITY_COARSER = 1,
+            PRIORITY_PREFETCH = 2
+        };
+
+        struct TileRange {
+            uint32_t left;
+            uint32_t top;
+            uint32_t right;   // Exclusive
+            uint32_t bottom;  // Exclusive
+        };
+
+        TileRange RangeFor(const Viewport& viewport, uint32_t level, uint32_t margin) const;
+        void Queue(uint32_t level, uint32_t x, uint32_t y, int priority, std::unordered_set<uint64_t>& wanted);
+        void Decode(uint32_t level, uint32_t x, uint32_t y);
+        void FinishJobLocked(uint64_t key);
+
+        std::unique_ptr<TileSource> m_source;
+        WorkerPool& m_workers;
+        TileCache m_cache;
+        TileReadyCallback m_onTileReady;
+        uint32_t m_levels;
+
+        std::mutex m_mutex;
+        std::unordered_set<uint64_t> m_wanted;    // Tiles the current viewport needs
+        std::unordered_set<uint64_t> m_inFlight;  // Queued or decoding
+        size_t m_outstanding;                     // Jobs on the pool that still reference us
+        std::condition_variable m_drained;
+        CancellationSource m_cancellation;
+
+        std::atomic<uint64_t> m_decoded;
+        std::atomic<uint64_t> m_dropped;
+        std::atomic<uint64_t> m_failed;
+    };
+}
@@ -0,0 +1,115 @@
+#include "WicTileSource.h"
+#include <string>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+namespace Lumos {
+    namespace {
+        // Worker threads never initialize COM themselves; join the MTA on
+        // first use. WIC objects are free-threaded, so objects created on an
+        // STA thread remain usable from here.
+        struct ComApartment {
+            ComApartment() : initialized(SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {}
+            ~ComApartment() {
+                if (initialized) {
+                    CoUninitialize();
+                }
+            }
+            bool initialized;
+        };
+
+        void EnsureCom() {
+            thread_local ComApartment apartment;
+            (void)apartment;
+        }
+    }
+
+    std::unique_ptr<WicTileSource> WicTileSource::Open(std::wstring_view path) {
+        EnsureCom();
+
+        std::unique_ptr<WicTileSource> source(new WicTileSource());
+        HRESULT hr = source->m_factory.CoCreateInstance(CLSID_WICImagingFactory);
+        if (FAILED(hr)) {
+            return nullptr;
+        }
+
+        std::wstring pathString(path);
+        CComPtr<IWICBitmapDecoder> decoder;
+        hr = source->m_factory->CreateDecoderFromFilename(pathString.c_str(), nullptr, GENERIC_READ,
+                                                          WICDecodeMetadataCacheOnDemand, &decoder);
+        if (FAILED(hr)) {
+            return nullptr;
+        }
+
+        CComPtr<IWICBitmapFrameDecode> frame;
+        if (FAILED(decoder->GetFrame(0, &frame))) {
+            return nullptr;
+        }
+
+        CComPtr<IWICFormatConverter> converter;
+        if (FAILED(source->m_factory->CreateFormatConverter(&converter)) ||
+            FAILED(converter->Initialize(frame, GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone,
+                                         nullptr, 0.0, WICBitmapPaletteTypeCustom))) {
+            return nullptr;
+        }
+
+        UINT width = 0;
+        UINT height = 0;
+        if (FAILED(converter->GetSize(&width, &height)) || width == 0 || height == 0) {
+            return nullptr;
+        }
+
+        source->m_source = converter;
+        source->m_width = width;
+        source->m_height = height;
+        return source;
+    }
+
+    WicTileSource::WicTileSource()
+        : m_width(0)
+        , m_height(0)
+    {
+    }
+
+    bool WicTileSource::DecodeRegion(const TileRegion& region, uint32_t level,
+                                     uint8_t* bgra, size_t stride,
+                                     const CancellationToken& cancellation) {
+        if (region.x >= m_width || region.y >= m_height || region.width == 0 || region.height == 0 || level > 31) {
+            return false;
+        }
+        EnsureCom();
+
+        // Callers clip regions to the image; WIC rejects rects that overhang it
+        uint32_t width = region.width < m_width - region.x ? region.width : m_width - region.x;
+        uint32_t height = region.height < m_height - region.y ? region.height : m_height - region.y;
+        WICRect rect;
+        rect.X = static_cast<INT>(region.x);
+        rect.Y = static_cast<INT>(region.y);
+        rect.Width = static_cast<INT>(width);
+        rect.Height = static_cast<INT>(height);
+
+        uint32_t outWidth = (width + (1u << level) - 1) >> level;
+        uint32_t outHeight = (height + (1u << level) - 1) >> level;
+        UINT bufferSize = static_cast<UINT>(stride * outHeight);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (cancellation.IsCancellationRequested()) {
+            return false;
+        }
+
+        if (level == 0) {
+            return SUCCEEDED(m_source->CopyPixels(&rect, static_cast<UINT>(stride), bufferSize, bgra));
+        }
+
+        // Clip to the region, then let the Fant scaler box-filter it down
+        CComPtr<IWICBitmapClipper> clipper;
+        CComPtr<IWICBitmapScaler> scaler;
+        if (FAILED(m_factory->CreateBitmapClipper(&clipper)) ||
+            FAILED(clipper->Initialize(m_source, &rect)) ||
+            FAILED(m_factory->CreateBitmapScaler(&scaler)) ||
+            FAILED(scaler->Initialize(clipper, outWidth, outHeight, WICBitmapInterpolationModeFant))) {
+            return false;
+        }
+        return SUCCEEDED(scaler->CopyPixels(nullptr, static_cast<UINT>(stride), bufferSize, bgra));
+    }
+}
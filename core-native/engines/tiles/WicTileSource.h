@@ -0,0 +1,39 @@
+#pragma once
+#include <Windows.h>
+#include <wincodec.h>
+#include <atlbase.h>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include "TileSource.h"
+
+namespace Lumos {
+    // Any format with an installed WIC codec. Region decodes go through
+    // CopyPixels with a source rect, so codecs that support random access
+    // (tiled TIFF, JPEG XR, most HEIF) skip what lies outside the region;
+    // the rest decode sequentially up to its last row. WIC frames are not
+    // safe for concurrent use, so decodes are serialized on one mutex.
+    class WicTileSource : public TileSource {
+    public:
+        // Null if no installed codec can open the file
+        static std::unique_ptr<WicTileSource> Open(std::wstring_view path);
+
+        uint32_t Width() const override { return m_width; }
+        uint32_t Height() const override { return m_height; }
+
+        bool DecodeRegion(const TileRegion& region, uint32_t level,
+                          uint8_t* bgra, size_t stride,
+                          const CancellationToken& cancellation) override;
+
+        const char* Name() const override { return "wic"; }
+
+    private:
+        WicTileSource();
+
+        std::mutex m_mutex;
+        CComPtr<IWICImagingFactory> m_factory;
+        CComPtr<IWICBitmapSource> m_source; // Frame 0 converted to 32bppBGRA
+        uint32_t m_width;
+        uint32_t m_height;
+    };
+}
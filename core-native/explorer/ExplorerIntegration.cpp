@@ -12,8 +12,9 @@
 #pragma comment(lib, "Shell32.lib")
 
 namespace Lumos {
-    ExplorerIntegration::ExplorerIntegration()
-        : m_comInitialized(false)
+    ExplorerIntegration::ExplorerIntegration(IOScheduler& ioScheduler)
+        : SelectionResolver(ioScheduler)
+        , m_comInitialized(false)
     {
     }
 
@@ -40,36 +41,22 @@ namespace Lumos {
         return true;
     }
 
-    std::optional<FileInfo> ExplorerIntegration::GetSelectedFile() {
-        FileInfo info;
-        
-        // Retry logic to handle timing issues with Explorer selection
-        const int MAX_RETRIES = 3;
-        const int RETRY_DELAY_MS = 50;
-        
-        for (int attempt = 0; attempt < MAX_RETRIES; ++attempt) {
-            if (attempt > 0) {
-                std::wcout << L"[DEBUG] Retry attempt " << attempt << L"..." << std::endl;
-                Sleep(RETRY_DELAY_MS);
-            }
-
-            std::wcout << L"[DEBUG] Attempting UI Automation method..." << std::endl;
-            // Try UI Automation first (preferred)
-            if (GetSelectedFileViaUIAutomation(info)) {
-                std::wcout << L"[DEBUG] UI Automation succeeded" << std::endl;
-                return info;
-            }
-            std::wcout << L"[DEBUG] UI Automation failed, trying ShellView fallback..." << std::endl;
-
-            // Fallback to ShellView
-            if (GetSelectedFileViaShellView(info)) {
-                std::wcout << L"[DEBUG] ShellView succeeded" << std::endl;
-                return info;
-            }
-            std::wcout << L"[DEBUG] ShellView also failed" << std::endl;
+    bool ExplorerIntegration::TryResolve(FileInfo& outInfo) {
+        std::wcout << L"[DEBUG] Attempting UI Automation method..." << std::endl;
+        // Try UI Automation first (preferred)
+        if (GetSelectedFileViaUIAutomation(outInfo)) {
+            std::wcout << L"[DEBUG] UI Automation succeeded" << std::endl;
+            return true;
         }
+        std::wcout << L"[DEBUG] UI Automation failed, trying ShellView fallback..." << std::endl;
 
-        return std::nullopt;
+        // Fallback to ShellView
+        if (GetSelectedFileViaShellView(outInfo)) {
+            std::wcout << L"[DEBUG] ShellView succeeded" << std::endl;
+            return true;
+        }
+        std::wcout << L"[DEBUG] ShellView also failed" << std::endl;
+        return false;
     }
 
     bool ExplorerIntegration::GetSelectedFileViaUIAutomation(FileInfo& outInfo) {
@@ -115,8 +102,8 @@ namespace Lumos {
         }
 
         // Try to get the file path from the focused element
-        std::wstring filePath = GetFilePathFromElement(focusedElement);
-        std::wcout << L"[DEBUG-UIA] File path from focused: " << (filePath.empty() ? L"(empty)" : filePath) << std::endl;
+        std::pmr::wstring filePath = GetFilePathFromElement(focusedElement);
+        std::wcout << L"[DEBUG-UIA] File path from focused: " << (filePath.empty() ? L"(empty)" : filePath.c_str()) << std::endl;
         
         if (filePath.empty()) {
             // If focused element doesn't have a path, try to find selected items
@@ -133,7 +120,7 @@ namespace Lumos {
                 
                 if (SUCCEEDED(hr) && selectedElement) {
                     filePath = GetFilePathFromElement(selectedElement);
-                    std::wcout << L"[DEBUG-UIA] File path from selected: " << (filePath.empty() ? L"(empty)" : filePath) << std::endl;
+                    std::wcout << L"[DEBUG-UIA] File path from selected: " << (filePath.empty() ? L"(empty)" : filePath.c_str()) << std::endl;
                 } else {
                     std::wcout << L"[DEBUG-UIA] No selected element found" << std::endl;
                 }
@@ -141,14 +128,7 @@ namespace Lumos {
         }
 
         if (!filePath.empty()) {
-            if (IsDirectory(filePath)) {
-                outInfo.extension = L".folder"; // Explicitly mark as folder
-            } else {
-                outInfo.extension = GetFileExtension(filePath);
-            }
-            outInfo.path = filePath;
-            outInfo.size = IsDirectory(filePath) ? 0 : GetFileSize(filePath); // Folders size logic can be complex
-            return true;
+            return FillFileInfo(filePath, outInfo);
         }
 
         return false;
@@ -244,15 +224,7 @@ namespace Lumos {
                 if (fileCount > 0) {
                     wchar_t filePath[MAX_PATH];
                     DragQueryFile(hDrop, 0, filePath, MAX_PATH);
-                    
-                    if (IsDirectory(filePath)) {
-                        outInfo.extension = L".folder";
-                        outInfo.size = 0;
-                    } else {
-                        outInfo.extension = GetFileExtension(filePath);
-                        outInfo.size = GetFileSize(filePath);
-                    }
-                    outInfo.path = filePath;
+                    FillFileInfo(filePath, outInfo);
                 }
                 GlobalUnlock(medium.hGlobal);
             }
@@ -265,36 +237,9 @@ namespace Lumos {
         return false;
     }
 
-    bool ExplorerIntegration::IsDirectory(const std::wstring& path) {
-        DWORD attributes = GetFileAttributes(path.c_str());
-        if (attributes == INVALID_FILE_ATTRIBUTES) {
-            return false;
-        }
-        return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-    }
-
-    std::wstring ExplorerIntegration::GetFileExtension(const std::wstring& path) {
-        size_t dotPos = path.find_last_of(L'.');
-        if (dotPos != std::wstring::npos && dotPos < path.length() - 1) {
-            return path.substr(dotPos);
-        }
-        return L"";
-    }
-
-    uint64_t ExplorerIntegration::GetFileSize(const std::wstring& path) {
-        WIN32_FILE_ATTRIBUTE_DATA fileInfo;
-        if (GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &fileInfo)) {
-            LARGE_INTEGER size;
-            size.HighPart = fileInfo.nFileSizeHigh;
-            size.LowPart = fileInfo.nFileSizeLow;
-            return static_cast<uint64_t>(size.QuadPart);
-        }
-        return 0;
-    }
-
-    std::wstring ExplorerIntegration::GetFilePathFromElement(IUIAutomationElement* element) {
+    std::pmr::wstring ExplorerIntegration::GetFilePathFromElement(IUIAutomationElement* element) {
         if (!element) {
-            return L"";
+            return std::pmr::wstring(m_memory);
         }
 
         // Strategy 1: Try to get the Value pattern (works for some Explorer views)
@@ -304,11 +249,11 @@ namespace Lumos {
             BSTR value = nullptr;
             hr = valuePattern->get_CurrentValue(&value);
             if (SUCCEEDED(hr) && value) {
-                std::wstring result(value);
+                std::pmr::wstring result(value, m_memory);
                 SysFreeString(value);
                 
                 // Check if this is a valid file path
-                if (result.length() > 2 && result[1] == L':' && PathFileExists(result.c_str())) {
+                if (result.length() > 2 && result[1] == L':' && PathExists(result)) {
                     return result;
                 }
             }
@@ -318,7 +263,7 @@ namespace Lumos {
         BSTR name = nullptr;
         hr = element->get_CurrentName(&name);
         if (SUCCEEDED(hr) && name) {
-            std::wstring fileName(name);
+            std::pmr::wstring fileName(name, m_memory);
             SysFreeString(name);
 
             // Get the current folder path from the Explorer window
@@ -349,12 +294,12 @@ namespace Lumos {
                         BSTR locationURL = nullptr;
                         hr = webBrowser->get_LocationURL(&locationURL);
                         if (SUCCEEDED(hr) && locationURL) {
-                            std::wstring url(locationURL);
+                            std::pmr::wstring url(locationURL, m_memory);
                             SysFreeString(locationURL);
 
                             // Convert file:/// URL to path
                             if (url.find(L"file:///") == 0) {
-                                std::wstring folderPath = url.substr(8); // Remove "file:///"
+                                std::pmr::wstring folderPath(url.begin() + 8, url.end(), m_memory); // Remove "file:///"
                                 
                                 // Replace forward slashes with backslashes
                                 std::replace(folderPath.begin(), folderPath.end(), L'/', L'\\');
@@ -367,14 +312,14 @@ namespace Lumos {
                                 }
 
                                 // Construct full file path
-                                std::wstring fullPath = folderPath;
+                                std::pmr::wstring fullPath(folderPath, m_memory);
                                 if (!fullPath.empty() && fullPath.back() != L'\\') {
                                     fullPath += L'\\';
                                 }
                                 fullPath += fileName;
 
                                 // Verify the file exists
-                                if (PathFileExists(fullPath.c_str())) {
+                                if (PathExists(fullPath)) {
                                     return fullPath;
                                 }
                             }
@@ -384,6 +329,6 @@ namespace Lumos {
             }
         }
 
-        return L"";
+        return std::pmr::wstring(m_memory);
     }
 }
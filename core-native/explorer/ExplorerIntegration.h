@@ -1,35 +1,29 @@
 #pragma once
 #include <Windows.h>
 #include <string>
-#include <optional>
+#include <memory_resource>
 #include <UIAutomation.h>
 #include <atlbase.h>
+#include "SelectionResolver.h"
 
 namespace Lumos {
-    struct FileInfo {
-        std::wstring path;
-        std::wstring extension;
-        uint64_t size;
-    };
-
-    class ExplorerIntegration {
+    // Finds Explorer's selection through UI Automation, falling back to the
+    // shell view; SelectionResolver supplies the retries and the stat
+    class ExplorerIntegration : public SelectionResolver {
     public:
-        ExplorerIntegration();
-        ~ExplorerIntegration();
+        explicit ExplorerIntegration(IOScheduler& ioScheduler);
+        ~ExplorerIntegration() override;
 
         // Initialize COM and UI Automation
-        bool Initialize();
+        bool Initialize() override;
 
-        // Get currently selected file in Explorer
-        std::optional<FileInfo> GetSelectedFile();
+    protected:
+        bool TryResolve(FileInfo& outInfo) override;
 
     private:
         bool GetSelectedFileViaUIAutomation(FileInfo& outInfo);
         bool GetSelectedFileViaShellView(FileInfo& outInfo);
-        bool IsDirectory(const std::wstring& path);
-        std::wstring GetFileExtension(const std::wstring& path);
-        uint64_t GetFileSize(const std::wstring& path);
-        std::wstring GetFilePathFromElement(IUIAutomationElement* element);
+        std::pmr::wstring GetFilePathFromElement(IUIAutomationElement* element);
 
         bool m_comInitialized;
         CComPtr<IUIAutomation> m_uiAutomation;
@@ -0,0 +1,70 @@
+#include "SelectionResolver.h"
+#include <iostream>
+#include <thread>
+
+namespace Lumos {
+    SelectionResolver::SelectionResolver(IOScheduler& ioScheduler)
+        : m_ioScheduler(ioScheduler)
+        , m_memory(std::pmr::get_default_resource())
+    {
+    }
+
+    std::optional<FileInfo> SelectionResolver::GetSelectedFile(std::pmr::memory_resource* memory,
+                                                               const CancellationToken& cancellation) {
+        m_memory = memory;
+        m_cancellation = cancellation;
+        FileInfo info(m_memory);
+
+        const auto deadline = std::chrono::steady_clock::now() + SELECTION_DEADLINE;
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            if (cancellation.IsCancellationRequested()) {
+                std::wcout << L"[DEBUG] Selection superseded, giving up" << std::endl;
+                break;
+            }
+            if (attempt > 0) {
+                if (std::chrono::steady_clock::now() + RETRY_DELAY >= deadline) {
+                    std::wcout << L"[DEBUG] Selection deadline reached, giving up" << std::endl;
+                    break;
+                }
+                std::wcout << L"[DEBUG] Retry attempt " << attempt << L"..." << std::endl;
+                std::this_thread::sleep_for(RETRY_DELAY);
+            }
+
+            if (TryResolve(info)) {
+                return info;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    bool SelectionResolver::FillFileInfo(std::wstring_view path, FileInfo& outInfo) {
+        // One bounded stat answers both "is it a folder" and "how big is it".
+        // If the volume does not answer in time we still preview, just without a size.
+        auto stat = m_ioScheduler.Stat(path, STAT_BUDGET, IOPriority::Interactive, m_cancellation);
+        if (stat && stat->isDirectory) {
+            outInfo.extension = L".folder"; // Explicitly mark as folder
+            outInfo.size = 0;
+            outInfo.modifiedTime = 0;
+        } else {
+            outInfo.extension.assign(GetFileExtension(path));
+            outInfo.size = stat ? stat->size : 0;
+            outInfo.modifiedTime = stat ? stat->modifiedTime : 0;
+        }
+        outInfo.path.assign(path);
+        return true;
+    }
+
+    bool SelectionResolver::PathExists(std::wstring_view path) {
+        auto stat = m_ioScheduler.Stat(path, STAT_BUDGET, IOPriority::Interactive, m_cancellation);
+        return stat.has_value() && stat->exists;
+    }
+
+    std::wstring_view SelectionResolver::GetFileExtension(std::wstring_view path) {
+        size_t dotPos = path.find_last_of(L'.');
+        if (dotPos != std::wstring_view::npos && dotPos < path.length() - 1) {
+            return path.substr(dotPos);
+        }
+        return std::wstring_view();
+    }
+}
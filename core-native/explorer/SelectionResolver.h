@@ -0,0 +1,40 @@
+#pragma once
+#include <chrono>
+#include <string_view>
+#include "SelectionSource.h"
+#include "../io/IOScheduler.h"
+
+namespace Lumos {
+    // The portable half of resolving a selection: a few attempts within the
+    // selection deadline, and one bounded stat that turns the path found into
+    // a FileInfo. Subclasses find the path (UI Automation and the shell view
+    // in ExplorerIntegration; the session's file in the replay harness).
+    class SelectionResolver : public SelectionSource {
+    public:
+        explicit SelectionResolver(IOScheduler& ioScheduler);
+
+        std::optional<FileInfo> GetSelectedFile(std::pmr::memory_resource* memory,
+                                                const CancellationToken& cancellation = {}) override;
+
+    protected:
+        // One attempt at finding the selected path; on success fills
+        // `outInfo` through FillFileInfo
+        virtual bool TryResolve(FileInfo& outInfo) = 0;
+
+        bool FillFileInfo(std::wstring_view path, FileInfo& outInfo);
+        bool PathExists(std::wstring_view path);
+        static std::wstring_view GetFileExtension(std::wstring_view path);
+
+        // Budgets for filesystem probes; a stalled share must not hold up the hook
+        static constexpr auto SELECTION_DEADLINE = std::chrono::milliseconds(600);
+        static constexpr auto STAT_BUDGET = std::chrono::milliseconds(250);
+
+        // Explorer can lag the keypress by a frame or two
+        static constexpr int MAX_ATTEMPTS = 3;
+        static constexpr auto RETRY_DELAY = std::chrono::milliseconds(50);
+
+        IOScheduler& m_ioScheduler;
+        CancellationToken m_cancellation;
+        std::pmr::memory_resource* m_memory;
+    };
+}
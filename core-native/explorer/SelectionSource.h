@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include "../common/CancellationToken.h"
+
+namespace Lumos {
+    struct FileInfo {
+        using allocator_type = std::pmr::polymorphic_allocator<wchar_t>;
+
+        explicit FileInfo(const allocator_type& alloc = {})
+            : path(alloc)
+            , extension(alloc)
+            , size(0)
+            , modifiedTime(0)
+        {
+        }
+
+        std::pmr::wstring path;
+        std::pmr::wstring extension;
+        uint64_t size;
+        uint64_t modifiedTime; // FileStat::modifiedTime; 0 if the stat did not answer in time
+    };
+
+    // Where the pipeline learns which file a press is about: Explorer on
+    // Windows, a recorded session in the replay harness. Created, initialized
+    // and used on the pipeline's worker thread only.
+    class SelectionSource {
+    public:
+        virtual ~SelectionSource() = default;
+
+        virtual bool Initialize() = 0;
+
+        // The selected file, or nothing once the selection deadline passes or
+        // the token is cancelled by a newer keypress. All strings are
+        // allocated from `memory` (the per-request arena).
+        virtual std::optional<FileInfo> GetSelectedFile(std::pmr::memory_resource* memory,
+                                                        const CancellationToken& cancellation = {}) = 0;
+    };
+}
@@ -1,9 +1,12 @@
 #include "TrayIcon.h"
+#include <chrono>
 #include <iostream>
+#include "../metrics/MetricsReport.h"
 
 #define ID_TRAY_APP_ICON 1001
 #define ID_TRAY_EXIT 1002
 #define ID_TRAY_RESTORE 1003
+#define ID_TRAY_STATS 1004
 #define IDT_CONSOLE_CHECK_TIMER 1
 
 namespace Lumos {
@@ -85,6 +88,9 @@ namespace Lumos {
                         case ID_TRAY_RESTORE:
                             s_instance->RestoreConsole();
                             break;
+                        case ID_TRAY_STATS:
+                            s_instance->ShowPerformanceStats();
+                            break;
                         case ID_TRAY_EXIT:
                             PostQuitMessage(0); // This will break the main loop in main.cpp
                             break;
@@ -107,6 +113,7 @@ namespace Lumos {
         HMENU hMenu = CreatePopupMenu();
         if (hMenu) {
             InsertMenu(hMenu, -1, MF_BYPOSITION, ID_TRAY_RESTORE, L"Show Console");
+            InsertMenu(hMenu, -1, MF_BYPOSITION, ID_TRAY_STATS, L"Performance stats");
             InsertMenu(hMenu, -1, MF_BYPOSITION, ID_TRAY_EXIT, L"Quit Lumos");
 
             SetForegroundWindow(hwnd); // Required for menu to close properly
@@ -135,4 +142,16 @@ namespace Lumos {
             SetForegroundWindow(hConsole);
         }
     }
+
+    void TrayIcon::ShowPerformanceStats() {
+        MetricsSnapshot snapshot;
+        MetricsReport::Capture(Metrics::Live(), snapshot);
+        uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        std::wstring text = MetricsReport::Format(snapshot, now);
+
+        // Also to the console, where the columns line up
+        std::wcout << text << std::endl;
+        MessageBoxW(nullptr, text.c_str(), L"Lumos performance", MB_OK | MB_ICONINFORMATION | MB_SETFOREGROUND);
+    }
 }
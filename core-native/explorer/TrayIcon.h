@@ -21,6 +21,7 @@ namespace Lumos {
         void CheckConsoleState();
         void RestoreConsole();
         void HideConsole();
+        void ShowPerformanceStats();
 
         HWND m_hHiddenWindow;
         NOTIFYICONDATA m_nid;
@@ -0,0 +1,35 @@
+#include "HookGuard.h"
+#include <cwchar>
+
+namespace Lumos {
+    bool HookGuard::ShouldTriggerPreview(const HookContext& context) {
+        // Guard condition 1: Foreground window must be Explorer
+        if (!IsExplorerWindowClass(context.foregroundClass)) {
+            return false;
+        }
+
+        // Guard condition 2: No text input focused
+        if (IsTextInputClass(context.focusClass)) {
+            return false;
+        }
+
+        // Guard condition 3: Preview not already active
+        if (context.previewActive) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool HookGuard::IsExplorerWindowClass(const wchar_t* className) {
+        // Compare in place; this runs inside the hook for every Spacebar press
+        return wcscmp(className, L"CabinetWClass") == 0 ||      // File Explorer
+               wcscmp(className, L"ExploreWClass") == 0 ||      // Old Explorer
+               wcscmp(className, L"Progman") == 0 ||            // Desktop
+               wcscmp(className, L"WorkerW") == 0;              // Desktop (worker)
+    }
+
+    bool HookGuard::IsTextInputClass(const wchar_t* className) {
+        return wcsstr(className, L"Edit") != nullptr;
+    }
+}
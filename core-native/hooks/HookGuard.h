@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+
+namespace Lumos {
+    // What the keyboard hook saw when Spacebar went down. Filled in place
+    // inside the hook (no allocation), recorded into sessions as is.
+    struct HookContext {
+        static constexpr size_t CLASS_NAME_CHARS = 256;
+
+        wchar_t foregroundClass[CLASS_NAME_CHARS] = {};  // Empty if there is no foreground window
+        wchar_t focusClass[CLASS_NAME_CHARS] = {};       // Empty if nothing has focus
+        bool previewActive = false;
+    };
+
+    // Whether a Spacebar press should open a preview, decided from window
+    // class names alone so the replay harness applies the same rules
+    class HookGuard {
+    public:
+        static bool ShouldTriggerPreview(const HookContext& context);
+
+        // File Explorer windows and the desktop
+        static bool IsExplorerWindowClass(const wchar_t* className);
+
+        // Common text input class names (Edit, RichEdit, RichEdit20A/W, ...)
+        static bool IsTextInputClass(const wchar_t* className);
+    };
+}
@@ -1,6 +1,5 @@
 #include "KeyboardHook.h"
-#include <string>
-#include <algorithm>
+#include "../metrics/Metrics.h"
 
 namespace Lumos {
     KeyboardHook* KeyboardHook::s_instance = nullptr;
@@ -43,16 +42,26 @@ namespace Lumos {
         m_callback = callback;
     }
 
+    void KeyboardHook::SetKeyObserver(KeyObserver observer) {
+        m_observer = observer;
+    }
+
     LRESULT CALLBACK KeyboardHook::LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
         if (nCode == HC_ACTION && s_instance != nullptr) {
             KBDLLHOOKSTRUCT* pKeyboard = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
 
             // Check for spacebar key down
             if (wParam == WM_KEYDOWN && pKeyboard->vkCode == VK_SPACE) {
-                if (s_instance->ShouldTriggerPreview()) {
-                    if (s_instance->m_callback) {
-                        s_instance->m_callback();
-                    }
+                // Windows drops hooks that keep it waiting; watch how close we get
+                ScopedLatency latency(Histogram::HookCallback);
+                HookContext context;
+                s_instance->CaptureContext(context);
+                bool triggered = HookGuard::ShouldTriggerPreview(context);
+                if (s_instance->m_observer) {
+                    s_instance->m_observer(context, triggered);
+                }
+                if (triggered && s_instance->m_callback) {
+                    s_instance->m_callback();
                 }
             }
         }
@@ -60,59 +69,13 @@ namespace Lumos {
         return CallNextHookEx(nullptr, nCode, wParam, lParam);
     }
 
-    bool KeyboardHook::ShouldTriggerPreview() {
-        // Guard condition 1: Foreground window must be Explorer
-        if (!IsForegroundWindowExplorer()) {
-            return false;
-        }
-
-        // Guard condition 2: No text input focused
-        if (IsTextInputFocused()) {
-            return false;
-        }
-
-        // Guard condition 3: Preview not already active
-        if (m_previewActive) {
-            return false;
-        }
-
-        return true;
-    }
-
-    bool KeyboardHook::IsForegroundWindowExplorer() {
-        HWND foregroundWindow = GetForegroundWindow();
-        if (foregroundWindow == nullptr) {
-            return false;
+    void KeyboardHook::CaptureContext(HookContext& context) const {
+        if (HWND foregroundWindow = GetForegroundWindow()) {
+            GetClassName(foregroundWindow, context.foregroundClass, HookContext::CLASS_NAME_CHARS);
         }
-
-        wchar_t className[256] = { 0 };
-        GetClassName(foregroundWindow, className, 256);
-
-        std::wstring classNameStr(className);
-        
-        // Windows Explorer class names
-        return classNameStr == L"CabinetWClass" ||      // File Explorer
-               classNameStr == L"ExploreWClass" ||      // Old Explorer
-               classNameStr == L"Progman" ||            // Desktop
-               classNameStr == L"WorkerW";              // Desktop (worker)
-    }
-
-    bool KeyboardHook::IsTextInputFocused() {
-        HWND focusedWindow = GetFocus();
-        if (focusedWindow == nullptr) {
-            return false;
+        if (HWND focusedWindow = GetFocus()) {
+            GetClassName(focusedWindow, context.focusClass, HookContext::CLASS_NAME_CHARS);
         }
-
-        wchar_t className[256] = { 0 };
-        GetClassName(focusedWindow, className, 256);
-
-        std::wstring classNameStr(className);
-
-        // Common text input class names
-        return classNameStr == L"Edit" ||
-               classNameStr == L"RichEdit" ||
-               classNameStr == L"RichEdit20A" ||
-               classNameStr == L"RichEdit20W" ||
-               classNameStr.find(L"Edit") != std::wstring::npos;
+        context.previewActive = m_previewActive;
     }
 }
@@ -1,12 +1,17 @@
 #pragma once
 #include <Windows.h>
 #include <functional>
+#include "HookGuard.h"
 
 namespace Lumos {
     class KeyboardHook {
     public:
         using SpacebarCallback = std::function<void()>;
 
+        // Every Spacebar key-down, whether or not it triggered a preview.
+        // Runs inside the hook: record and return.
+        using KeyObserver = std::function<void(const HookContext& context, bool triggered)>;
+
         KeyboardHook();
         ~KeyboardHook();
 
@@ -19,6 +24,9 @@ namespace Lumos {
         // Set callback for spacebar press
         void SetSpacebarCallback(SpacebarCallback callback);
 
+        // Set observer for every spacebar press (session recording)
+        void SetKeyObserver(KeyObserver observer);
+
         // Check if hook is installed
         bool IsInstalled() const { return m_hookHandle != nullptr; }
 
@@ -26,12 +34,12 @@ namespace Lumos {
         static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
         static KeyboardHook* s_instance;
 
-        bool ShouldTriggerPreview();
-        bool IsForegroundWindowExplorer();
-        bool IsTextInputFocused();
+        // Class names of the foreground and focused windows, in place
+        void CaptureContext(HookContext& context) const;
 
         HHOOK m_hookHandle;
         SpacebarCallback m_callback;
+        KeyObserver m_observer;
         bool m_previewActive;
     };
 }
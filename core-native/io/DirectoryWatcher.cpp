@@ -0,0 +1,351 @@
+#include "DirectoryWatcher.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <unordered_set>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "../common/Utf8.h"
+#endif
+
+namespace Lumos {
+#ifdef _WIN32
+    namespace {
+        constexpr DWORD NOTIFY_BUFFER_SIZE = 64 * 1024; // Network shares reject anything larger
+        constexpr DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                        FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                                        FILE_NOTIFY_CHANGE_ATTRIBUTES;
+
+        struct Watch {
+            int id = -1;
+            HANDLE directory = INVALID_HANDLE_VALUE;
+            OVERLAPPED overlapped = {};
+            bool pending = false;
+            std::unique_ptr<DWORD[]> buffer; // DWORD-aligned, as the API requires
+
+            ~Watch() {
+                if (pending) {
+                    // The kernel owns the buffer until the cancelled read completes
+                    DWORD ignored;
+                    CancelIoEx(directory, &overlapped);
+                    GetOverlappedResult(directory, &overlapped, &ignored, TRUE);
+                }
+                if (overlapped.hEvent) CloseHandle(overlapped.hEvent);
+                if (directory != INVALID_HANDLE_VALUE) CloseHandle(directory);
+            }
+        };
+
+        // Turn one completed read into changes; false if the watch is dead
+        bool Collect(Watch& watch, std::vector<FileChange>& changes) {
+            DWORD bytes = 0;
+            watch.pending = false;
+            if (!GetOverlappedResult(watch.directory, &watch.overlapped, &bytes, FALSE)) {
+                if (GetLastError() == ERROR_NOTIFY_ENUM_DIR) {
+                    changes.push_back(FileChange{ FileChangeKind::Overflow, watch.id, {} });
+                    return true;
+                }
+                changes.push_back(FileChange{ FileChangeKind::Lost, watch.id, {} });
+                return false;
+            }
+            if (bytes == 0) {
+                // The kernel buffer overflowed and the events were dropped
+                changes.push_back(FileChange{ FileChangeKind::Overflow, watch.id, {} });
+                return true;
+            }
+
+            auto cursor = reinterpret_cast<const uint8_t*>(watch.buffer.get());
+            while (true) {
+                auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+                FileChangeKind kind;
+                switch (info->Action) {
+                case FILE_ACTION_ADDED: kind = FileChangeKind::Added; break;
+                case FILE_ACTION_REMOVED: kind = FileChangeKind::Removed; break;
+                case FILE_ACTION_RENAMED_OLD_NAME: kind = FileChangeKind::RenamedFrom; break;
+                case FILE_ACTION_RENAMED_NEW_NAME: kind = FileChangeKind::RenamedTo; break;
+                default: kind = FileChangeKind::Modified; break;
+                }
+                changes.push_back(FileChange{ kind, watch.id,
+                                              std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)) });
+
+                if (info->NextEntryOffset == 0) {
+                    break;
+                }
+                cursor += info->NextEntryOffset;
+            }
+            return true;
+        }
+    }
+
+    struct DirectoryWatcher::State {
+        HANDLE wakeEvent = nullptr;
+        std::vector<std::unique_ptr<Watch>> watches;
+        int nextId = 0;
+    };
+
+    DirectoryWatcher::DirectoryWatcher() = default;
+
+    DirectoryWatcher::~DirectoryWatcher() {
+        Close();
+    }
+
+    bool DirectoryWatcher::Open() {
+        Close();
+
+        auto state = std::make_unique<State>();
+        state->wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (state->wakeEvent == nullptr) {
+            return false;
+        }
+        m_state = std::move(state);
+        return true;
+    }
+
+    void DirectoryWatcher::Close() {
+        if (!m_state) {
+            return;
+        }
+        m_state->watches.clear();
+        CloseHandle(m_state->wakeEvent);
+        m_state.reset();
+    }
+
+    bool DirectoryWatcher::IsOpen() const {
+        return m_state != nullptr;
+    }
+
+    int DirectoryWatcher::Add(std::wstring_view directory) {
+        if (!m_state || m_state->watches.size() >= MAX_WATCHES) {
+            return -1;
+        }
+
+        auto watch = std::make_unique<Watch>();
+        watch->directory = CreateFileW(std::wstring(directory).c_str(), FILE_LIST_DIRECTORY,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                       OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        watch->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (watch->directory == INVALID_HANDLE_VALUE || watch->overlapped.hEvent == nullptr) {
+            return -1;
+        }
+        watch->buffer.reset(new DWORD[NOTIFY_BUFFER_SIZE / sizeof(DWORD)]);
+        watch->id = m_state->nextId++;
+
+        int id = watch->id;
+        m_state->watches.push_back(std::move(watch));
+        return id;
+    }
+
+    void DirectoryWatcher::Remove(int watch) {
+        if (!m_state) {
+            return;
+        }
+        auto& watches = m_state->watches;
+        watches.erase(std::remove_if(watches.begin(), watches.end(),
+                                     [watch](const std::unique_ptr<Watch>& w) { return w->id == watch; }),
+                      watches.end());
+    }
+
+    size_t DirectoryWatcher::WatchCount() const {
+        return m_state ? m_state->watches.size() : 0;
+    }
+
+    bool DirectoryWatcher::Wait(std::vector<FileChange>& changes, std::chrono::milliseconds timeout) {
+        if (!m_state) {
+            return false;
+        }
+
+        State& state = *m_state;
+        HANDLE handles[MAX_WATCHES + 1];
+        DWORD count = 0;
+        handles[count++] = state.wakeEvent;
+        for (auto it = state.watches.begin(); it != state.watches.end();) {
+            Watch& watch = **it;
+            if (!watch.pending) {
+                ResetEvent(watch.overlapped.hEvent);
+                if (!ReadDirectoryChangesW(watch.directory, watch.buffer.get(), NOTIFY_BUFFER_SIZE, FALSE,
+                                           NOTIFY_FILTER, nullptr, &watch.overlapped, nullptr)) {
+                    // Directory deleted or share disconnected
+                    changes.push_back(FileChange{ FileChangeKind::Lost, watch.id, {} });
+                    it = state.watches.erase(it);
+                    continue;
+                }
+                watch.pending = true;
+            }
+            handles[count++] = watch.overlapped.hEvent;
+            ++it;
+        }
+
+        DWORD waited = WaitForMultipleObjects(count, handles, FALSE, static_cast<DWORD>(timeout.count()));
+        if (waited == WAIT_FAILED) {
+            return false;
+        }
+        if (waited == WAIT_TIMEOUT || waited == WAIT_OBJECT_0) {
+            return true; // Timeout or Wake(); the reads stay queued for next time
+        }
+
+        // Collect every watch that completed, not just the first one signalled
+        for (auto it = state.watches.begin(); it != state.watches.end();) {
+            Watch& watch = **it;
+            if (watch.pending && HasOverlappedIoCompleted(&watch.overlapped) && !Collect(watch, changes)) {
+                it = state.watches.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        return true;
+    }
+
+    void DirectoryWatcher::Wake() {
+        if (m_state) {
+            SetEvent(m_state->wakeEvent);
+        }
+    }
+#else
+    namespace {
+        constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                        IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+    }
+
+    struct DirectoryWatcher::State {
+        int inotify = -1;
+        int wake = -1;
+        std::unordered_set<int> watches;
+        std::unordered_set<int> removed; // Removed by us; their IN_IGNORED is expected
+        alignas(inotify_event) char buffer[64 * 1024];
+    };
+
+    DirectoryWatcher::DirectoryWatcher() = default;
+
+    DirectoryWatcher::~DirectoryWatcher() {
+        Close();
+    }
+
+    bool DirectoryWatcher::Open() {
+        Close();
+
+        auto state = std::make_unique<State>();
+        state->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        state->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (state->inotify < 0 || state->wake < 0) {
+            if (state->inotify >= 0) close(state->inotify);
+            if (state->wake >= 0) close(state->wake);
+            return false;
+        }
+
+        m_state = std::move(state);
+        return true;
+    }
+
+    void DirectoryWatcher::Close() {
+        if (!m_state) {
+            return;
+        }
+        close(m_state->inotify);
+        close(m_state->wake);
+        m_state.reset();
+    }
+
+    bool DirectoryWatcher::IsOpen() const {
+        return m_state != nullptr;
+    }
+
+    int DirectoryWatcher::Add(std::wstring_view directory) {
+        if (!m_state || m_state->watches.size() >= MAX_WATCHES) {
+            return -1;
+        }
+        int wd = inotify_add_watch(m_state->inotify, ToUtf8(directory).c_str(), WATCH_MASK | IN_ONLYDIR);
+        if (wd < 0) {
+            return -1;
+        }
+        m_state->watches.insert(wd);
+        m_state->removed.erase(wd);
+        return wd;
+    }
+
+    void DirectoryWatcher::Remove(int watch) {
+        if (!m_state || m_state->watches.erase(watch) == 0) {
+            return;
+        }
+        inotify_rm_watch(m_state->inotify, watch);
+        m_state->removed.insert(watch);
+    }
+
+    size_t DirectoryWatcher::WatchCount() const {
+        return m_state ? m_state->watches.size() : 0;
+    }
+
+    bool DirectoryWatcher::Wait(std::vector<FileChange>& changes, std::chrono::milliseconds timeout) {
+        if (!m_state) {
+            return false;
+        }
+
+        State& state = *m_state;
+        pollfd fds[2] = { { state.inotify, POLLIN, 0 }, { state.wake, POLLIN, 0 } };
+        int ready = poll(fds, 2, static_cast<int>(timeout.count()));
+        if (ready < 0) {
+            return errno == EINTR;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t ignored;
+            (void)read(state.wake, &ignored, sizeof(ignored));
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            return true;
+        }
+
+        while (true) {
+            ssize_t bytes = read(state.inotify, state.buffer, sizeof(state.buffer));
+            if (bytes <= 0) {
+                break; // EAGAIN: drained
+            }
+
+            for (char* cursor = state.buffer; cursor < state.buffer + bytes;) {
+                auto event = reinterpret_cast<const inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // inotify has one queue for every watch
+                    changes.push_back(FileChange{ FileChangeKind::Overflow, -1, {} });
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    if (state.removed.erase(event->wd) == 0 && state.watches.erase(event->wd) != 0) {
+                        changes.push_back(FileChange{ FileChangeKind::Lost, event->wd, {} });
+                    }
+                    continue;
+                }
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    // IN_IGNORED follows for deletion; a moved directory keeps
+                    // its watch but no longer has the path we were asked for
+                    if ((event->mask & IN_MOVE_SELF) && state.watches.erase(event->wd) != 0) {
+                        inotify_rm_watch(state.inotify, event->wd);
+                        state.removed.insert(event->wd);
+                        changes.push_back(FileChange{ FileChangeKind::Lost, event->wd, {} });
+                    }
+                    continue;
+                }
+
+                FileChangeKind kind = FileChangeKind::Modified;
+                if (event->mask & IN_CREATE) kind = FileChangeKind::Added;
+                else if (event->mask & IN_DELETE) kind = FileChangeKind::Removed;
+                else if (event->mask & IN_MOVED_FROM) kind = FileChangeKind::RenamedFrom;
+                else if (event->mask & IN_MOVED_TO) kind = FileChangeKind::RenamedTo;
+                changes.push_back(FileChange{ kind, event->wd, event->len ? FromUtf8(event->name) : std::wstring() });
+            }
+        }
+        return true;
+    }
+
+    void DirectoryWatcher::Wake() {
+        if (m_state) {
+            uint64_t one = 1;
+            (void)write(m_state->wake, &one, sizeof(one));
+        }
+    }
+#endif
+}
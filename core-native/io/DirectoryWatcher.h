@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Lumos {
+    enum class FileChangeKind : uint8_t {
+        Added,
+        Removed,
+        Modified,     // Contents, size or attributes
+        RenamedFrom,  // Old name of a rename; the new name follows as RenamedTo
+        RenamedTo,
+        Overflow,     // Events were lost; anything under the directory may have changed
+        Lost          // The directory itself was removed or renamed; its watch is gone
+    };
+
+    struct FileChange {
+        FileChangeKind kind;
+        int watch;          // Id from Add(); -1 for an overflow of the whole queue
+        std::wstring name;  // Relative to the watched directory; empty for Overflow and Lost
+    };
+
+    // Change notifications for a set of directories (not their subtrees):
+    // ReadDirectoryChangesW on Windows, inotify elsewhere. Waiting is
+    // explicit, so the owner decides how changes are coalesced and how often
+    // it reacts to them.
+    class DirectoryWatcher {
+    public:
+        // WaitForMultipleObjects takes 64 handles, one of which is Wake()'s
+        static constexpr size_t MAX_WATCHES = 62;
+
+        DirectoryWatcher();
+        ~DirectoryWatcher();
+
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        bool Open();
+        void Close();
+        bool IsOpen() const;
+
+        // Start watching `directory`; returns its watch id, or -1
+        int Add(std::wstring_view directory);
+        void Remove(int watch);
+        size_t WatchCount() const;
+
+        // Block until changes arrive, `timeout` passes or Wake() is called,
+        // appending whatever arrived to `changes`. Returns false if the queue
+        // itself failed; the owner should fall back to polling.
+        bool Wait(std::vector<FileChange>& changes, std::chrono::milliseconds timeout);
+
+        // Make a concurrent Wait() return early; safe from any thread
+        void Wake();
+
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+    };
+}
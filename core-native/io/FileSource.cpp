@@ -0,0 +1,49 @@
+#include "FileSource.h"
+#include <algorithm>
+
+namespace Lumos {
+    FileSource::FileSource()
+        : m_size(0)
+        , m_open(false)
+    {
+    }
+
+    bool FileSource::Open(IOScheduler& io, std::wstring_view path, std::optional<uint64_t> expectedSize,
+                          MapAccess access, uint64_t readLimit, std::chrono::milliseconds budget,
+                          const CancellationToken& cancellation) {
+        Close();
+
+        if (expectedSize && !io.IsRemote(path) && m_mapped.Open(path, access)) {
+            if (m_mapped.Size() == *expectedSize) {
+                m_size = m_mapped.Size();
+                m_open = true;
+                return true;
+            }
+            m_mapped.Close();  // Changed since the stat: probably still being written
+        }
+
+        size_t length = static_cast<size_t>(std::min<uint64_t>(readLimit, SIZE_MAX));
+        io.Read(path, 0, length, budget, m_read, IOPriority::Interactive, cancellation);
+        if (m_read.status != IOStatus::Complete && m_read.status != IOStatus::Partial) {
+            m_read.data.clear();
+            return false;
+        }
+        m_size = std::max<uint64_t>(m_read.stat.size, m_read.data.size());
+        m_open = true;
+        return true;
+    }
+
+    void FileSource::Close() {
+        m_mapped.Close();
+        m_read.data.clear();
+        m_size = 0;
+        m_open = false;
+    }
+
+    ByteView FileSource::View() const {
+        if (m_mapped.IsOpen()) {
+            return m_mapped.View();
+        }
+        return ByteView(m_read.data.data(), m_read.data.size());
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "IOScheduler.h"
+#include "MappedFile.h"
+#include "../common/ByteView.h"
+#include "../common/CancellationToken.h"
+
+namespace Lumos {
+    // The bytes of a file an in-process parser walks. A local file whose
+    // size is still the one the selection saw is mapped, and only the pages
+    // the parser touches are read. Anything else - a file on a share, one
+    // the stat did not answer for, one being written - is read through the
+    // IOScheduler instead, up to a limit and by a deadline: a share that
+    // drops or a writer that truncates the file turns a mapped page into
+    // SIGBUS / EXCEPTION_IN_PAGE_ERROR in this process, where a read just
+    // fails.
+    class FileSource {
+    public:
+        FileSource();
+
+        FileSource(const FileSource&) = delete;
+        FileSource& operator=(const FileSource&) = delete;
+
+        // `expectedSize` is the selection's stat, nullopt if it did not
+        // answer. A read may stop short of `readLimit` at the deadline;
+        // parsers see that as a truncated file.
+        bool Open(IOScheduler& io, std::wstring_view path, std::optional<uint64_t> expectedSize,
+                  MapAccess access, uint64_t readLimit, std::chrono::milliseconds budget,
+                  const CancellationToken& cancellation);
+        void Close();
+
+        bool IsOpen() const { return m_open; }
+        bool IsMapped() const { return m_mapped.IsOpen(); }
+
+        // The whole file when mapped; when read, its first bytes
+        ByteView View() const;
+
+        // Size of the file itself, which View() may stop short of
+        uint64_t Size() const { return m_size; }
+
+    private:
+        MappedFile m_mapped;
+        IOResult m_read;  // Buffer kept for the next file read
+        uint64_t m_size;
+        bool m_open;
+    };
+}
@@ -0,0 +1,525 @@
+#include "IOScheduler.h"
+#include <algorithm>
+#include <cwctype>
+#include <tuple>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../common/Utf8.h"
+#endif
+
+namespace Lumos {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+#ifdef _WIN32
+        bool StatFile(const std::wstring& path, FileStat& out) {
+            WIN32_FILE_ATTRIBUTE_DATA data;
+            if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+                return false;
+            }
+            out.exists = true;
+            out.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            out.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            out.modifiedTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                               data.ftLastWriteTime.dwLowDateTime;
+            return true;
+        }
+
+        class FileReader {
+        public:
+            explicit FileReader(const std::wstring& path) {
+                m_handle = CreateFileW(path.c_str(), GENERIC_READ,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                       nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            }
+            ~FileReader() {
+                if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+            }
+            bool IsOpen() const { return m_handle != INVALID_HANDLE_VALUE; }
+
+            // Returns bytes read, 0 at EOF, -1 on error
+            long long ReadAt(uint64_t offset, uint8_t* buffer, size_t length) {
+                OVERLAPPED ov = {};
+                ov.Offset = static_cast<DWORD>(offset);
+                ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                DWORD bytesRead = 0;
+                if (!ReadFile(m_handle, buffer, static_cast<DWORD>(length), &bytesRead, &ov)) {
+                    return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+                }
+                return bytesRead;
+            }
+
+        private:
+            HANDLE m_handle;
+        };
+#else
+        // Per-worker scratch buffer so path conversion does not allocate per request
+        const char* NarrowPath(const std::wstring& path) {
+            thread_local std::string narrow;
+            narrow.clear();
+            AppendUtf8(narrow, path);
+            return narrow.c_str();
+        }
+
+        bool StatFile(const std::wstring& path, FileStat& out) {
+            struct stat st;
+            if (stat(NarrowPath(path), &st) != 0) {
+                return false;
+            }
+            out.exists = true;
+            out.isDirectory = S_ISDIR(st.st_mode);
+            out.size = S_ISDIR(st.st_mode) ? 0 : static_cast<uint64_t>(st.st_size);
+            out.modifiedTime = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ull +
+                               static_cast<uint64_t>(st.st_mtim.tv_nsec);
+            return true;
+        }
+
+        class FileReader {
+        public:
+            explicit FileReader(const std::wstring& path) {
+                m_fd = open(NarrowPath(path), O_RDONLY | O_CLOEXEC);
+            }
+            ~FileReader() {
+                if (m_fd >= 0) close(m_fd);
+            }
+            bool IsOpen() const { return m_fd >= 0; }
+
+            long long ReadAt(uint64_t offset, uint8_t* buffer, size_t length) {
+                ssize_t n = pread(m_fd, buffer, length, static_cast<off_t>(offset));
+                return n < 0 ? -1 : static_cast<long long>(n);
+            }
+
+        private:
+            int m_fd;
+        };
+#endif
+
+        bool IsRemoteVolume(const std::wstring& volume) {
+            if (volume.size() >= 2 && volume[0] == L'\\' && volume[1] == L'\\') {
+                return true;
+            }
+#ifdef _WIN32
+            if (volume.size() == 2 && volume[1] == L':') {
+                std::wstring root = volume + L"\\";
+                return GetDriveTypeW(root.c_str()) == DRIVE_REMOTE;
+            }
+#endif
+            return false;
+        }
+    }
+
+    IOResult IOOperation::Wait() {
+        IOResult result;
+        Wait(result);
+        return result;
+    }
+
+    void IOOperation::Wait(IOResult& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_request.deadline == std::chrono::steady_clock::time_point::max()) {
+            m_done.wait(lock, [this] { return m_finished; });
+        } else {
+            m_done.wait_until(lock, m_request.deadline, [this] { return m_finished; });
+        }
+
+        out.stat = m_result.stat;
+        out.data.assign(m_result.data.begin(), m_result.data.end());
+        if (m_finished) {
+            out.status = m_result.status;
+            return;
+        }
+
+        // The worker is still blocked (slow share, spun-down disk). Hand back
+        // what has arrived so far and let the worker drop the rest.
+        m_abandoned = true;
+        out.status = out.data.empty() ? IOStatus::DeadlineExpired : IOStatus::Partial;
+    }
+
+    bool IOOperation::IsDone() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_finished;
+    }
+
+    IOScheduler::IOScheduler(size_t workerCount)
+        : m_nextSequence(0)
+        , m_stopping(false)
+    {
+        m_pending.reserve(OPERATION_POOL_SIZE);
+        m_operationPool.reserve(OPERATION_POOL_SIZE);
+        workerCount = std::max<size_t>(workerCount, 1);
+        for (size_t i = 0; i < workerCount; ++i) {
+            m_workers.emplace_back(&IOScheduler::WorkerLoop, this);
+        }
+    }
+
+    IOScheduler::~IOScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            for (auto& op : m_pending) {
+                Finish(*op, IOStatus::Cancelled);
+            }
+            m_pending.clear();
+        }
+        m_wake.notify_all();
+
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    std::shared_ptr<IOOperation> IOScheduler::Submit(IORequest request) {
+        return Enqueue(request.path, request.offset, request.length, request.priority,
+                       request.deadline, request.cancellation);
+    }
+
+    std::shared_ptr<IOOperation> IOScheduler::Enqueue(std::wstring_view path, uint64_t offset, size_t length,
+                                                      IOPriority priority,
+                                                      std::chrono::steady_clock::time_point deadline,
+                                                      const CancellationToken& cancellation) {
+        std::shared_ptr<IOOperation> op;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            op = AcquireOperationLocked();
+        }
+
+        // Assigning into a recycled operation reuses its string and buffer
+        // capacity, so steady-state probes do not touch the heap
+        {
+            std::lock_guard<std::mutex> lock(op->m_mutex);
+            op->m_request.path.assign(path);
+            op->m_request.offset = offset;
+            op->m_request.length = length;
+            op->m_request.priority = priority;
+            op->m_request.deadline = deadline;
+            op->m_request.cancellation = cancellation;
+            AssignVolume(path, op->m_volume);
+            op->m_finished = false;
+            op->m_abandoned = false;
+            op->m_result.status = IOStatus::Failed;
+            op->m_result.stat = FileStat();
+            op->m_result.data.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                Finish(*op, IOStatus::Cancelled);
+                return op;
+            }
+            op->m_sequence = m_nextSequence++;
+            m_pending.push_back(op);
+        }
+        m_wake.notify_one();
+        return op;
+    }
+
+    std::shared_ptr<IOOperation> IOScheduler::AcquireOperationLocked() {
+        // An operation is free once only the pool still references it
+        for (auto& op : m_operationPool) {
+            if (op.use_count() == 1) {
+                return op;
+            }
+        }
+
+        auto op = std::make_shared<IOOperation>();
+        if (m_operationPool.size() < OPERATION_POOL_SIZE) {
+            m_operationPool.push_back(op);
+        }
+        return op;
+    }
+
+    IOResult IOScheduler::Read(std::wstring_view path, uint64_t offset, size_t length,
+                               std::chrono::milliseconds budget, IOPriority priority,
+                               const CancellationToken& cancellation) {
+        return Enqueue(path, offset, length, priority, Clock::now() + budget, cancellation)->Wait();
+    }
+
+    void IOScheduler::Read(std::wstring_view path, uint64_t offset, size_t length,
+                           std::chrono::milliseconds budget, IOResult& out, IOPriority priority,
+                           const CancellationToken& cancellation) {
+        Enqueue(path, offset, length, priority, Clock::now() + budget, cancellation)->Wait(out);
+    }
+
+    std::optional<FileStat> IOScheduler::Stat(std::wstring_view path, std::chrono::milliseconds budget,
+                                              IOPriority priority, const CancellationToken& cancellation) {
+        IOResult result = Read(path, 0, 0, budget, priority, cancellation);
+        if (result.status != IOStatus::Complete) {
+            return std::nullopt;
+        }
+        return result.stat;
+    }
+
+    CancellationToken IOScheduler::BeginSelection() {
+        std::lock_guard<std::mutex> lock(m_selectionMutex);
+        m_selection.Cancel();
+        std::swap(m_selection, m_previousSelection);
+        m_selection.Renew();
+        return m_selection.Token();
+    }
+
+    CancellationToken IOScheduler::CurrentSelection() const {
+        std::lock_guard<std::mutex> lock(m_selectionMutex);
+        return m_selection.Token();
+    }
+
+    void IOScheduler::SetVolumeConcurrency(const std::wstring& volume, size_t limit) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_volumeLimits[volume] = std::max<size_t>(limit, 1);
+        }
+        m_wake.notify_all();
+    }
+
+    void IOScheduler::SetVolumeLatency(const std::wstring& volume, std::chrono::microseconds perChunk) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (perChunk.count() > 0) {
+            m_volumeLatency[volume] = perChunk;
+        } else {
+            m_volumeLatency.erase(volume);
+        }
+    }
+
+    bool IOScheduler::IsRemote(std::wstring_view path) const {
+        // Per-thread scratch so asking does not allocate per press
+        thread_local std::wstring volume;
+        AssignVolume(path, volume);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_volumeLatency.find(volume) != m_volumeLatency.end()) {
+                return true;
+            }
+        }
+        return IsRemoteVolume(volume);
+    }
+
+    std::wstring IOScheduler::VolumeOf(std::wstring_view path) {
+        std::wstring volume;
+        AssignVolume(path, volume);
+        return volume;
+    }
+
+    void IOScheduler::AssignVolume(std::wstring_view p, std::wstring& out) {
+        out.clear();
+
+        // Strip the long-path prefixes \\?\UNC\ and \\?\ first
+        bool unc = false;
+        if (p.substr(0, 8) == L"\\\\?\\UNC\\") {
+            p.remove_prefix(8);
+            unc = true;
+        } else if (p.substr(0, 4) == L"\\\\?\\") {
+            p.remove_prefix(4);
+        } else if (p.size() > 2 && p[0] == L'\\' && p[1] == L'\\') {
+            p.remove_prefix(2);
+            unc = true;
+        }
+
+        if (unc) {
+            // \\server\share
+            size_t serverEnd = p.find(L'\\');
+            size_t shareEnd = serverEnd == std::wstring_view::npos ? serverEnd : p.find(L'\\', serverEnd + 1);
+            out.append(L"\\\\");
+            for (wchar_t c : p.substr(0, shareEnd)) {
+                out.push_back(static_cast<wchar_t>(std::towlower(c)));
+            }
+            return;
+        }
+
+        if (p.size() >= 2 && p[1] == L':') {
+            out.push_back(static_cast<wchar_t>(std::towupper(p[0])));
+            out.push_back(L':');
+            return;
+        }
+
+        if (!p.empty() && p[0] == L'/') {
+            out.assign(p.substr(0, p.find(L'/', 1)));
+        }
+    }
+
+    void IOScheduler::WorkerLoop() {
+        std::vector<uint8_t> chunk(READ_CHUNK_SIZE);
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true) {
+            std::shared_ptr<IOOperation> op;
+            while (!m_stopping && !(op = TakeNextLocked())) {
+                m_wake.wait(lock);
+            }
+            if (m_stopping) {
+                return;
+            }
+
+            ++m_volumeInFlight[op->m_volume];
+            auto slow = m_volumeLatency.find(op->m_volume);
+            auto latency = slow != m_volumeLatency.end() ? slow->second : std::chrono::microseconds(0);
+            lock.unlock();
+
+            Execute(*op, chunk, latency);
+
+            lock.lock();
+            --m_volumeInFlight[op->m_volume];
+            // A volume slot freed up; a queued request for it may now be runnable
+            m_wake.notify_all();
+        }
+    }
+
+    std::shared_ptr<IOOperation> IOScheduler::TakeNextLocked() {
+        auto now = Clock::now();
+
+        // Index, not iterator: erasing below moves end()
+        constexpr size_t NONE = static_cast<size_t>(-1);
+        size_t best = NONE;
+
+        for (size_t i = 0; i < m_pending.size();) {
+            IOOperation& op = *m_pending[i];
+
+            // Drop work nobody is waiting for anymore before it reaches the disk
+            if (op.m_request.cancellation.IsCancellationRequested()) {
+                Finish(op, IOStatus::Cancelled);
+                m_pending.erase(m_pending.begin() + static_cast<ptrdiff_t>(i));
+                continue;
+            }
+            if (op.m_request.deadline <= now) {
+                Finish(op, IOStatus::DeadlineExpired);
+                m_pending.erase(m_pending.begin() + static_cast<ptrdiff_t>(i));
+                continue;
+            }
+
+            if (m_volumeInFlight[op.m_volume] < VolumeLimitLocked(op.m_volume)) {
+                // Priority first, then earliest deadline, then submission order
+                if (best == NONE) {
+                    best = i;
+                } else {
+                    const IOOperation& current = *m_pending[best];
+                    auto key = [](const IOOperation& o) {
+                        return std::make_tuple(static_cast<int>(o.m_request.priority), o.m_request.deadline, o.m_sequence);
+                    };
+                    if (key(op) < key(current)) {
+                        best = i;
+                    }
+                }
+            }
+            ++i;
+        }
+
+        if (best == NONE) {
+            return nullptr;
+        }
+
+        auto op = m_pending[best];
+        m_pending.erase(m_pending.begin() + static_cast<ptrdiff_t>(best));
+        return op;
+    }
+
+    size_t IOScheduler::VolumeLimitLocked(const std::wstring& volume) {
+        auto it = m_volumeLimits.find(volume);
+        if (it != m_volumeLimits.end()) {
+            return it->second;
+        }
+
+        size_t limit = IsRemoteVolume(volume) ? REMOTE_VOLUME_CONCURRENCY : LOCAL_VOLUME_CONCURRENCY;
+        m_volumeLimits.emplace(volume, limit);
+        return limit;
+    }
+
+    void IOScheduler::Execute(IOOperation& op, std::vector<uint8_t>& chunk, std::chrono::microseconds latency) {
+        const IORequest& request = op.m_request;
+
+        auto shouldStop = [&]() -> std::optional<IOStatus> {
+            if (request.cancellation.IsCancellationRequested()) {
+                return IOStatus::Cancelled;
+            }
+            if (Clock::now() >= request.deadline) {
+                return IOStatus::Partial;
+            }
+            std::lock_guard<std::mutex> lock(op.m_mutex);
+            if (op.m_abandoned) {
+                return IOStatus::Partial;
+            }
+            return std::nullopt;
+        };
+
+        FileStat stat;
+        if (!StatFile(request.path, stat)) {
+            Finish(op, IOStatus::Failed);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(op.m_mutex);
+            op.m_result.stat = stat;
+        }
+
+        if (request.length == 0 || stat.isDirectory) {
+            Finish(op, IOStatus::Complete);
+            return;
+        }
+
+        if (auto stop = shouldStop()) {
+            Finish(op, *stop);
+            return;
+        }
+
+        FileReader reader(request.path);
+        if (!reader.IsOpen()) {
+            Finish(op, IOStatus::Failed);
+            return;
+        }
+
+        uint64_t end = request.offset + request.length;
+        if (end > stat.size) end = stat.size;
+        {
+            std::lock_guard<std::mutex> lock(op.m_mutex);
+            if (end > request.offset) {
+                op.m_result.data.reserve(static_cast<size_t>(end - request.offset));
+            }
+        }
+
+        // Read in chunks so deadlines and cancellation are honoured between them
+        uint64_t position = request.offset;
+        while (position < end) {
+            if (auto stop = shouldStop()) {
+                Finish(op, *stop);
+                return;
+            }
+
+            size_t toRead = static_cast<size_t>(std::min<uint64_t>(chunk.size(), end - position));
+            if (latency.count() > 0) {
+                std::this_thread::sleep_for(latency);
+            }
+            long long n = reader.ReadAt(position, chunk.data(), toRead);
+            if (n < 0) {
+                Finish(op, IOStatus::Failed);
+                return;
+            }
+            if (n == 0) {
+                break; // File shrank underneath us
+            }
+
+            std::lock_guard<std::mutex> lock(op.m_mutex);
+            op.m_result.data.insert(op.m_result.data.end(), chunk.data(), chunk.data() + n);
+            position += static_cast<uint64_t>(n);
+        }
+
+        Finish(op, IOStatus::Complete);
+    }
+
+    void IOScheduler::Finish(IOOperation& op, IOStatus status) {
+        {
+            std::lock_guard<std::mutex> lock(op.m_mutex);
+            if (op.m_finished) {
+                return;
+            }
+            if (status == IOStatus::Partial && op.m_result.data.empty()) {
+                status = IOStatus::DeadlineExpired;
+            }
+            op.m_result.status = status;
+            op.m_finished = true;
+        }
+        op.m_done.notify_all();
+    }
+}
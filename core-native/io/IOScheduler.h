@@ -0,0 +1,158 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "../common/CancellationToken.h"
+
+namespace Lumos {
+    // Interactive reads serve the preview the user is waiting for; speculative
+    // reads (prefetch, warm-up) only run when no interactive work is queued.
+    enum class IOPriority {
+        Interactive = 0,
+        Speculative = 1
+    };
+
+    enum class IOStatus {
+        Complete,         // Everything requested was read (or EOF was reached)
+        Partial,          // Deadline expired after some bytes were read
+        DeadlineExpired,  // Deadline expired before anything was read
+        Cancelled,        // Request was superseded by a newer selection
+        Failed            // File could not be opened or read
+    };
+
+    struct FileStat {
+        bool exists = false;
+        bool isDirectory = false;
+        uint64_t size = 0;
+        uint64_t modifiedTime = 0; // Platform-native stamp; only compare for equality
+    };
+
+    struct IORequest {
+        std::wstring path;
+        uint64_t offset = 0;
+        size_t length = 0; // 0 = metadata only
+        IOPriority priority = IOPriority::Interactive;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        CancellationToken cancellation;
+    };
+
+    struct IOResult {
+        IOStatus status = IOStatus::Failed;
+        FileStat stat;
+        std::vector<uint8_t> data;
+    };
+
+    // Handle to a queued or running request. Wait() always returns by the
+    // request deadline, even when the underlying read is stuck on a dead share.
+    class IOOperation {
+    public:
+        IOResult Wait();
+
+        // Same, into `out`, whose buffer is reused: a caller that keeps one
+        // IOResult around reads without touching the heap
+        void Wait(IOResult& out);
+        bool IsDone() const;
+
+    private:
+        friend class IOScheduler;
+
+        IORequest m_request;
+        std::wstring m_volume;
+        uint64_t m_sequence = 0;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_done;
+        bool m_finished = false;
+        bool m_abandoned = false;
+        IOResult m_result;
+    };
+
+    class IOScheduler {
+    public:
+        explicit IOScheduler(size_t workerCount = DEFAULT_WORKER_COUNT);
+        ~IOScheduler();
+
+        IOScheduler(const IOScheduler&) = delete;
+        IOScheduler& operator=(const IOScheduler&) = delete;
+
+        // Queue a request; the caller decides whether and how long to wait
+        std::shared_ptr<IOOperation> Submit(IORequest request);
+
+        // Blocking helpers bounded by a time budget
+        IOResult Read(std::wstring_view path, uint64_t offset, size_t length,
+                      std::chrono::milliseconds budget,
+                      IOPriority priority = IOPriority::Interactive,
+                      const CancellationToken& cancellation = {});
+        void Read(std::wstring_view path, uint64_t offset, size_t length,
+                  std::chrono::milliseconds budget, IOResult& out,
+                  IOPriority priority = IOPriority::Interactive,
+                  const CancellationToken& cancellation = {});
+        std::optional<FileStat> Stat(std::wstring_view path,
+                                     std::chrono::milliseconds budget,
+                                     IOPriority priority = IOPriority::Interactive,
+                                     const CancellationToken& cancellation = {});
+
+        // Cancel every request tagged with the previous selection token and
+        // hand out a fresh one for the new selection
+        CancellationToken BeginSelection();
+        CancellationToken CurrentSelection() const;
+
+        // Maximum number of in-flight requests per volume
+        void SetVolumeConcurrency(const std::wstring& volume, size_t limit);
+
+        // Extra time every chunk read from the volume takes. Lets tests,
+        // benchmarks and replays stand a local disk in for a slow share.
+        void SetVolumeLatency(const std::wstring& volume, std::chrono::microseconds perChunk);
+
+        // On a network share, or on a volume SetVolumeLatency made stand in
+        // for one. Callers read such files rather than map them.
+        bool IsRemote(std::wstring_view path) const;
+
+        // "C:", "\\server\share" or the first component of a POSIX path
+        static std::wstring VolumeOf(std::wstring_view path);
+
+    private:
+        static constexpr size_t DEFAULT_WORKER_COUNT = 6;
+        static constexpr size_t LOCAL_VOLUME_CONCURRENCY = 4;
+        static constexpr size_t REMOTE_VOLUME_CONCURRENCY = 2;
+        static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+        static constexpr size_t OPERATION_POOL_SIZE = 32;
+
+        std::shared_ptr<IOOperation> Enqueue(std::wstring_view path, uint64_t offset, size_t length,
+                                             IOPriority priority,
+                                             std::chrono::steady_clock::time_point deadline,
+                                             const CancellationToken& cancellation);
+        std::shared_ptr<IOOperation> AcquireOperationLocked();
+        static void AssignVolume(std::wstring_view path, std::wstring& out);
+        void WorkerLoop();
+        std::shared_ptr<IOOperation> TakeNextLocked();
+        size_t VolumeLimitLocked(const std::wstring& volume);
+        void Execute(IOOperation& op, std::vector<uint8_t>& chunk, std::chrono::microseconds latency);
+        static void Finish(IOOperation& op, IOStatus status);
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::vector<std::shared_ptr<IOOperation>> m_pending;
+        std::vector<std::shared_ptr<IOOperation>> m_operationPool;
+        std::map<std::wstring, size_t> m_volumeLimits;
+        std::map<std::wstring, size_t> m_volumeInFlight;
+        std::map<std::wstring, std::chrono::microseconds> m_volumeLatency;
+        std::vector<std::thread> m_workers;
+        uint64_t m_nextSequence;
+        bool m_stopping;
+
+        // Two sources taking turns: by the time one is renewed, the presses
+        // that held its token are usually gone and its flag is reused
+        mutable std::mutex m_selectionMutex;
+        CancellationSource m_selection;
+        CancellationSource m_previousSelection;
+    };
+}
@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../common/Utf8.h"
+#endif
+
+namespace Lumos {
+    MappedFile::MappedFile()
+        : m_data(nullptr)
+        , m_size(0)
+        , m_open(false)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#endif
+    {
+    }
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : MappedFile()
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_open, other.m_open);
+#ifdef _WIN32
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(std::wstring_view path, MapAccess access) {
+        Close();
+
+        // Per-thread scratch so opening does not allocate per press
+        thread_local std::wstring filePath;
+        filePath.assign(path);
+        DWORD flags = access == MapAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_size = static_cast<uint64_t>(size.QuadPart);
+        m_open = true;
+        if (m_size == 0) {
+            return true; // Zero-length files cannot be mapped
+        }
+
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping != nullptr) {
+            m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (m_data == nullptr) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+        m_open = false;
+    }
+#else
+    bool MappedFile::Open(std::wstring_view path, MapAccess access) {
+        Close();
+
+        // Per-thread scratch so opening does not allocate per press
+        thread_local std::string narrow;
+        narrow.clear();
+        AppendUtf8(narrow, path);
+        int fd = open(narrow.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            close(fd);
+            return false;
+        }
+
+        m_size = static_cast<uint64_t>(st.st_size);
+        if (m_size > 0) {
+            void* data = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                m_size = 0;
+                return false;
+            }
+            madvise(data, static_cast<size_t>(m_size),
+                    access == MapAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            m_data = data;
+        }
+
+        // The mapping keeps the file referenced; the descriptor is not needed
+        close(fd);
+        m_open = true;
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data) munmap(m_data, static_cast<size_t>(m_size));
+        m_data = nullptr;
+        m_size = 0;
+        m_open = false;
+    }
+#endif
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "../common/ByteView.h"
+
+namespace Lumos {
+    // How the mapping will be read; passed on to the OS read-ahead policy
+    enum class MapAccess {
+        Random,     // Container walks: IFDs, b-tree pages, font tables
+        Sequential  // Full scans: search, hashing
+    };
+
+    // Read-only memory map of a whole file. Parsers work on View() and only
+    // the pages they touch are read. The file stays shareable for writers and
+    // deletion; if another process truncates it while mapped, touching the
+    // lost pages faults, so callers map files they are about to parse and
+    // drop the mapping promptly. In the host process FileSource decides:
+    // files on shares or still being written are read instead.
+    class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Empty files open successfully with an empty view
+        bool Open(std::wstring_view path, MapAccess access = MapAccess::Random);
+        void Close();
+
+        bool IsOpen() const { return m_open; }
+        uint64_t Size() const { return m_size; }
+        ByteView View() const { return ByteView(static_cast<const uint8_t*>(m_data), static_cast<size_t>(m_size)); }
+
+    private:
+        void* m_data;
+        uint64_t m_size;
+        bool m_open;
+#ifdef _WIN32
+        void* m_file;
+        void* m_mapping;
+#endif
+    };
+}
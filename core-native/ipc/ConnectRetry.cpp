@@ -0,0 +1,25 @@
+#include "ConnectRetry.h"
+#include <thread>
+
+namespace Lumos {
+    bool ConnectRetry::Run(const std::function<ConnectOutcome()>& attempt, const std::function<bool()>& waitBusy) {
+        for (int i = 0; i < MAX_ATTEMPTS; ++i) {
+            switch (attempt()) {
+            case ConnectOutcome::Connected:
+                return true;
+            case ConnectOutcome::Busy:
+                // If the wait failed, try again or give up on the last attempt
+                if (!waitBusy() && i == MAX_ATTEMPTS - 1) {
+                    return false;
+                }
+                break;
+            case ConnectOutcome::NotReady:
+                std::this_thread::sleep_for(RETRY_DELAY);
+                break;
+            case ConnectOutcome::Failed:
+                return false;
+            }
+        }
+        return false;
+    }
+}
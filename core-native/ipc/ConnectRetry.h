@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+#include <functional>
+
+namespace Lumos {
+    // What one attempt to open the UI's pipe ran into
+    enum class ConnectOutcome {
+        Connected,
+        Busy,       // Every instance is taken; wait for one to free up
+        NotReady,   // No instance right now; one is being recycled
+        Failed      // Anything else; not worth retrying
+    };
+
+    // The retry policy behind IPCClient::ConnectToPipe, kept apart from the
+    // Win32 calls. The server is known to be up; retries only cover the short
+    // gap between one pipe instance closing and the next being created.
+    class ConnectRetry {
+    public:
+        static constexpr int MAX_ATTEMPTS = 10;
+        static constexpr auto RETRY_DELAY = std::chrono::milliseconds(10);
+
+        // Calls `attempt` until it connects, fails outright or runs out of
+        // attempts. `waitBusy` blocks until an instance frees up and returns
+        // false if none did in time.
+        static bool Run(const std::function<ConnectOutcome()>& attempt, const std::function<bool()>& waitBusy);
+    };
+}
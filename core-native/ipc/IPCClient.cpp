@@ -1,34 +1,99 @@
 #include "IPCClient.h"
 #include <iostream>
+#include "ConnectRetry.h"
+#include "../metrics/Metrics.h"
 
 namespace Lumos {
-    IPCClient::IPCClient() {
+    IPCClient::IPCClient(UIProcessSupervisor& uiProcess)
+        : m_uiProcess(uiProcess)
+    {
     }
 
     IPCClient::~IPCClient() {
     }
 
-    bool IPCClient::SendPreviewRequest(const PreviewRequest& request) {
-        // Ensure UI process is running
-        if (!IsUIProcessRunning()) {
-            std::wcout << L"UI process not running, attempting to launch..." << std::endl;
-            if (!LaunchUIProcess()) {
-                std::wcerr << L"Failed to launch UI process" << std::endl;
-                return false;
-            }
-            // Give UI process time to start
-            std::wcout << L"Waiting for UI process to initialize..." << std::endl;
-            Sleep(1000); // Increased from 500ms to 1000ms
+    // Follow-up messages go only to a UI that is already up; fill sets the
+    // type and the one payload the message carries
+    template <typename Fill>
+    bool IPCClient::Send(uint64_t generation, Fill fill, std::pmr::memory_resource* memory) {
+        if (!m_uiProcess.IsReady()) {
+            return false;
+        }
+
+        PreviewRequest message(memory);
+        message.generation = generation;
+        fill(message);
+
+        std::pmr::string json(memory);
+        message.WriteJson(json);
+        return WriteMessage(json);
+    }
+
+    bool IPCClient::SendPreviewRequest(const PreviewRequest& request, std::pmr::memory_resource* memory) {
+        // Ensure UI process is running and its pipe server is listening
+        if (!m_uiProcess.EnsureReady(std::chrono::milliseconds(UI_READY_TIMEOUT_MS))) {
+            std::wcerr << L"Failed to launch UI process" << std::endl;
+            return false;
         }
 
+        // Serialize request to JSON
+        std::pmr::string json(memory);
+        request.WriteJson(json);
+        return WriteMessage(json);
+    }
+
+    bool IPCClient::SendCancel(uint64_t generation, std::pmr::memory_resource* memory) {
+        // Nothing running that could still be working on it
+        return !m_uiProcess.IsReady() || Send(generation, [](PreviewRequest& message) {
+            message.type = PreviewMessageType::Cancel;
+        }, memory);
+    }
+
+    bool IPCClient::SendMarkdown(uint64_t generation, const PreviewMarkdown& chunk, std::pmr::memory_resource* memory) {
+        return Send(generation, [&](PreviewRequest& message) {
+            message.type = PreviewMessageType::Markdown;
+            message.markdown = chunk;
+        }, memory);
+    }
+
+    bool IPCClient::SendTail(uint64_t generation, const PreviewTail& tail, std::pmr::memory_resource* memory) {
+        return Send(generation, [&](PreviewRequest& message) {
+            message.type = PreviewMessageType::Tail;
+            message.tail = tail;
+        }, memory);
+    }
+
+    bool IPCClient::SendHashes(uint64_t generation, const PreviewHashes& hashes, std::pmr::memory_resource* memory) {
+        return Send(generation, [&](PreviewRequest& message) {
+            message.type = PreviewMessageType::Hashes;
+            message.hashes = hashes;
+        }, memory);
+    }
+
+    bool IPCClient::SendDatabase(uint64_t generation, const PreviewDatabase& database,
+                                 std::pmr::memory_resource* memory) {
+        return Send(generation, [&](PreviewRequest& message) {
+            message.type = PreviewMessageType::Database;
+            message.database = database;
+        }, memory);
+    }
+
+    bool IPCClient::SendProvider(uint64_t generation, const PreviewProvider& provider,
+                                 std::pmr::memory_resource* memory) {
+        return Send(generation, [&](PreviewRequest& message) {
+            message.type = PreviewMessageType::Provider;
+            message.provider = provider;
+        }, memory);
+    }
+
+    bool IPCClient::WriteMessage(const std::pmr::string& json) {
+        auto start = std::chrono::steady_clock::now();
         HANDLE hPipe;
         if (!ConnectToPipe(hPipe)) {
             std::wcerr << L"Failed to connect to named pipe" << std::endl;
             return false;
         }
 
-        // Serialize request to JSON
-        std::string json = request.ToJson();
         DWORD bytesWritten;
         
         bool success = WriteFile(
@@ -42,7 +107,8 @@ namespace Lumos {
         CloseHandle(hPipe);
         
         if (success && bytesWritten == json.length()) {
-            std::wcout << L"Successfully sent preview request (" << bytesWritten << L" bytes)" << std::endl;
+            Metrics::Record(Histogram::PipeSend, std::chrono::steady_clock::now() - start);
+            std::wcout << L"Successfully sent message (" << bytesWritten << L" bytes)" << std::endl;
             return true;
         }
         
@@ -50,71 +116,9 @@ namespace Lumos {
         return false;
     }
 
-    bool IPCClient::IsUIProcessRunning() {
-        HANDLE hPipe = CreateFile(
-            PIPE_NAME,
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            nullptr,
-            OPEN_EXISTING,
-            0,
-            nullptr
-        );
-
-        if (hPipe != INVALID_HANDLE_VALUE) {
-            CloseHandle(hPipe);
-            return true;
-        }
-
-        return false;
-    }
-
-    bool IPCClient::LaunchUIProcess() {
-        std::wstring uiPath = GetUIProcessPath();
-        
-        std::wcout << L"Attempting to launch UI process: " << uiPath << std::endl;
-        
-        // Check if file exists
-        DWORD fileAttr = GetFileAttributes(uiPath.c_str());
-        if (fileAttr == INVALID_FILE_ATTRIBUTES) {
-            std::wcerr << L"UI process executable not found at: " << uiPath << std::endl;
-            std::wcerr << L"Error code: " << GetLastError() << std::endl;
-            return false;
-        }
-        
-        STARTUPINFO si = { sizeof(STARTUPINFO) };
-        PROCESS_INFORMATION pi;
-
-        bool success = CreateProcess(
-            uiPath.c_str(),
-            nullptr,
-            nullptr,
-            nullptr,
-            FALSE,
-            0,
-            nullptr,
-            nullptr,
-            &si,
-            &pi
-        );
-
-        if (success) {
-            std::wcout << L"UI process launched successfully (PID: " << pi.dwProcessId << L")" << std::endl;
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
-        } else {
-            std::wcerr << L"Failed to create UI process. Error code: " << GetLastError() << std::endl;
-        }
-
-        return success;
-    }
-
     bool IPCClient::ConnectToPipe(HANDLE& hPipe) {
-        // Try to connect multiple times to allow server to start
-        const int MAX_ATTEMPTS = 10;
-        const int RETRY_DELAY_MS = 200;
-
-        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        hPipe = INVALID_HANDLE_VALUE;
+        auto attempt = [&hPipe]() {
             hPipe = CreateFile(
                 PIPE_NAME,
                 GENERIC_READ | GENERIC_WRITE,
@@ -126,64 +130,24 @@ namespace Lumos {
             );
 
             if (hPipe != INVALID_HANDLE_VALUE) {
-                return true;
+                return ConnectOutcome::Connected;
             }
 
             DWORD error = GetLastError();
-
             if (error == ERROR_PIPE_BUSY) {
-                // Pipe exists but is busy, wait for it
-                if (!WaitNamedPipe(PIPE_NAME, PIPE_TIMEOUT_MS)) {
-                    // If wait failed, try again in next loop iteration or fail if out of attempts
-                     if (attempt == MAX_ATTEMPTS - 1) return false;
-                }
-            } else if (error == ERROR_FILE_NOT_FOUND) {
-                // Pipe doesn't exist yet (server starting), wait and retry
-                Sleep(RETRY_DELAY_MS);
-            } else {
-                // Other error, fail immediately
-                std::wcerr << L"Failed to connect to pipe. Error: " << error << std::endl;
-                return false;
+                // Pipe exists but is busy
+                return ConnectOutcome::Busy;
             }
-        }
-
-        return false;
-    }
-
-    std::wstring IPCClient::GetUIProcessPath() {
-        wchar_t exePath[MAX_PATH];
-        GetModuleFileName(nullptr, exePath, MAX_PATH);
-        
-        std::wstring path(exePath);
-        size_t lastSlash = path.find_last_of(L"\\");
-        std::wstring exeDir;
-        if (lastSlash != std::wstring::npos) {
-            exeDir = path.substr(0, lastSlash + 1);
-        }
-        
-        // Try multiple possible names for the UI executable
-        // In MSIX packages, .NET apps may be in win-x64 subdirectory
-        std::wstring candidates[] = {
-            exeDir + L"ui-managed.exe",                    // Same directory (MSIX - flat)
-            exeDir + L"win-x64\\ui-managed.exe",           // MSIX with runtime identifier folder
-            exeDir + L"Lumos.UI.exe",                      // Same directory (alternative name)
-            exeDir + L"win-x64\\Lumos.UI.exe",             // MSIX RID folder (alternative name)
-            exeDir + L"..\\ui-managed\\bin\\x64\\Release\\net8.0-windows\\ui-managed.exe",  // Dev build
-            exeDir + L"..\\ui-managed\\bin\\x64\\Release\\net8.0-windows\\Lumos.UI.exe",    // Dev build alternative
-            exeDir + L"..\\ui-managed\\bin\\x64\\Debug\\net8.0-windows\\ui-managed.exe",    // Debug build
-            exeDir + L"..\\ui-managed\\bin\\x64\\Debug\\net8.0-windows\\Lumos.UI.exe"       // Debug build alternative
-        };
-        
-        for (const auto& candidate : candidates) {
-            DWORD fileAttr = GetFileAttributes(candidate.c_str());
-            if (fileAttr != INVALID_FILE_ATTRIBUTES && !(fileAttr & FILE_ATTRIBUTE_DIRECTORY)) {
-                std::wcout << L"Found UI executable at: " << candidate << std::endl;
-                return candidate;
+            if (error == ERROR_FILE_NOT_FOUND) {
+                // Pipe instance is being recycled
+                return ConnectOutcome::NotReady;
             }
-        }
-        
-        // Default to first candidate if none found
-        std::wcout << L"UI executable not found, using default: " << candidates[0] << std::endl;
-        return candidates[0];
+            std::wcerr << L"Failed to connect to pipe. Error: " << error << std::endl;
+            return ConnectOutcome::Failed;
+        };
+        auto waitBusy = []() {
+            return WaitNamedPipe(PIPE_NAME, PIPE_TIMEOUT_MS) != FALSE;
+        };
+        return ConnectRetry::Run(attempt, waitBusy);
     }
 }
@@ -1,28 +1,42 @@
 #pragma once
 #include <Windows.h>
 #include <string>
-#include "../shared-contracts/PreviewRequest.h"
+#include <memory_resource>
+#include "PreviewSink.h"
+#include "UIProcessSupervisor.h"
 
 namespace Lumos {
-    class IPCClient {
+    // PreviewSink over the UI's named pipe; launches the UI on demand
+    class IPCClient : public PreviewSink {
     public:
-        IPCClient();
-        ~IPCClient();
+        explicit IPCClient(UIProcessSupervisor& uiProcess);
+        ~IPCClient() override;
 
-        // Send preview request to UI process
-        bool SendPreviewRequest(const PreviewRequest& request);
-
-        // Check if UI process is running
-        bool IsUIProcessRunning();
-
-        // Launch UI process if not running
-        bool LaunchUIProcess();
+        bool SendPreviewRequest(const PreviewRequest& request,
+                                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendCancel(uint64_t generation,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendMarkdown(uint64_t generation, const PreviewMarkdown& chunk,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendTail(uint64_t generation, const PreviewTail& tail,
+                      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendHashes(uint64_t generation, const PreviewHashes& hashes,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendDatabase(uint64_t generation, const PreviewDatabase& database,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendProvider(uint64_t generation, const PreviewProvider& provider,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
 
     private:
         static constexpr const wchar_t* PIPE_NAME = L"\\\\.\\pipe\\LumosPreview";
         static constexpr DWORD PIPE_TIMEOUT_MS = 1000;
+        static constexpr DWORD UI_READY_TIMEOUT_MS = 10000;
 
+        template <typename Fill>
+        bool Send(uint64_t generation, Fill fill, std::pmr::memory_resource* memory);
         bool ConnectToPipe(HANDLE& hPipe);
-        std::wstring GetUIProcessPath();
+        bool WriteMessage(const std::pmr::string& json);
+
+        UIProcessSupervisor& m_uiProcess;
     };
 }
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include "../shared-contracts/PreviewRequest.h"
+
+namespace Lumos {
+    // Where the pipeline's messages go: the UI's named pipe (IPCClient), or
+    // a recorder in the replay harness. Every call is made from the
+    // pipeline's worker thread or a task it waits for.
+    class PreviewSink {
+    public:
+        virtual ~PreviewSink() = default;
+
+        // Send preview request to UI process. The JSON payload is built in
+        // `memory` (normally the per-request arena).
+        virtual bool SendPreviewRequest(const PreviewRequest& request,
+                                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // Tell the UI to abandon work for an older generation. Does nothing
+        // (and never launches the UI) if no UI is running.
+        virtual bool SendCancel(uint64_t generation,
+                                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // Follow-up chunk of a Markdown document already sent with
+        // SendPreviewRequest. Fails without launching the UI if it is gone.
+        virtual bool SendMarkdown(uint64_t generation, const PreviewMarkdown& chunk,
+                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // Lines appended to the log file shown for `generation`
+        virtual bool SendTail(uint64_t generation, const PreviewTail& tail,
+                              std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // Checksum progress, or the digests, for the file shown for `generation`
+        virtual bool SendHashes(uint64_t generation, const PreviewHashes& hashes,
+                                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // The first rows of one more table of the database shown for `generation`
+        virtual bool SendDatabase(uint64_t generation, const PreviewDatabase& database,
+                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+
+        // More rows from the native provider previewing `generation`
+        virtual bool SendProvider(uint64_t generation, const PreviewProvider& provider,
+                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource()) = 0;
+    };
+}
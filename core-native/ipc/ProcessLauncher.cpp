@@ -0,0 +1,290 @@
+#include "ProcessLauncher.h"
+#include <iostream>
+#include <mutex>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../common/Utf8.h"
+
+extern char** environ;
+#endif
+
+namespace Lumos {
+#ifdef _WIN32
+    class Win32ProcessLauncher : public ProcessLauncher {
+    public:
+        Win32ProcessLauncher()
+            : m_process(nullptr)
+        {
+            // Create-or-open: if the UI is already running it created the event first
+            m_readyEvent = CreateEvent(nullptr, TRUE, FALSE, READY_EVENT_NAME);
+        }
+
+        ~Win32ProcessLauncher() override {
+            if (m_process) CloseHandle(m_process);
+            if (m_readyEvent) CloseHandle(m_readyEvent);
+        }
+
+        bool IsReady() override {
+            if (WaitForSingleObject(m_readyEvent, 0) != WAIT_OBJECT_0) {
+                return false;
+            }
+
+            // The event outlives the UI while we hold a handle to it, so also
+            // check the instance mutex the UI holds for its whole lifetime
+            HANDLE instance = OpenMutex(SYNCHRONIZE, FALSE, INSTANCE_MUTEX_NAME);
+            if (instance == nullptr) {
+                ResetEvent(m_readyEvent);
+                return false;
+            }
+            CloseHandle(instance);
+            return true;
+        }
+
+        bool Launch(const std::wstring& path) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ResetEvent(m_readyEvent);
+
+            STARTUPINFO si = { sizeof(STARTUPINFO) };
+            PROCESS_INFORMATION pi;
+            if (!CreateProcess(path.c_str(), nullptr, nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
+                std::wcerr << L"Failed to create UI process. Error code: " << GetLastError() << std::endl;
+                return false;
+            }
+
+            std::wcout << L"UI process launched successfully (PID: " << pi.dwProcessId << L")" << std::endl;
+            CloseHandle(pi.hThread);
+            if (m_process) CloseHandle(m_process);
+            m_process = pi.hProcess;
+            return true;
+        }
+
+        bool WaitUntilReady(std::chrono::milliseconds timeout) override {
+            HANDLE process = DuplicateProcessHandle();
+            HANDLE handles[] = { m_readyEvent, process };
+            DWORD count = process ? 2 : 1;
+
+            DWORD result = WaitForMultipleObjects(count, handles, FALSE, static_cast<DWORD>(timeout.count()));
+            if (process) CloseHandle(process);
+            return result == WAIT_OBJECT_0;
+        }
+
+        bool WaitForExit(std::chrono::milliseconds timeout) override {
+            HANDLE process = DuplicateProcessHandle();
+            if (process == nullptr) {
+                return true;
+            }
+            DWORD result = WaitForSingleObject(process, static_cast<DWORD>(timeout.count()));
+            CloseHandle(process);
+            return result == WAIT_OBJECT_0;
+        }
+
+        bool HasProcess() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_process == nullptr) {
+                return false;
+            }
+            if (WaitForSingleObject(m_process, 0) == WAIT_OBJECT_0) {
+                CloseHandle(m_process);
+                m_process = nullptr;
+                ResetEvent(m_readyEvent);
+                return false;
+            }
+            return true;
+        }
+
+        bool FileExists(const std::wstring& path) override {
+            DWORD attributes = GetFileAttributes(path.c_str());
+            return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+        }
+
+        void Terminate() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_process) {
+                TerminateProcess(m_process, 0);
+            }
+        }
+
+    private:
+        // Waiters get their own handle so a concurrent relaunch cannot close it under them
+        HANDLE DuplicateProcessHandle() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_process == nullptr) {
+                return nullptr;
+            }
+            HANDLE copy = nullptr;
+            DuplicateHandle(GetCurrentProcess(), m_process, GetCurrentProcess(), &copy, SYNCHRONIZE, FALSE, 0);
+            return copy;
+        }
+
+        std::mutex m_mutex;
+        HANDLE m_process;
+        HANDLE m_readyEvent;
+    };
+
+    std::unique_ptr<ProcessLauncher> CreateProcessLauncher() {
+        return std::make_unique<Win32ProcessLauncher>();
+    }
+#else
+    class PosixProcessLauncher : public ProcessLauncher {
+    public:
+        // The descriptor number the UI finds the handshake pipe at
+        static constexpr int CHILD_READY_FD = 3;
+
+        PosixProcessLauncher()
+            : m_pid(-1)
+            , m_readyFd(-1)
+            , m_ready(false)
+        {
+        }
+
+        ~PosixProcessLauncher() override {
+            if (m_readyFd >= 0) close(m_readyFd);
+        }
+
+        bool IsReady() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ReapLocked();
+            return m_pid > 0 && m_ready;
+        }
+
+        bool Launch(const std::wstring& path) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            int fds[2];
+            if (pipe2(fds, O_CLOEXEC) != 0) {
+                return false;
+            }
+
+            // Everything the child needs is built here: between fork and exec
+            // it may only make async-signal-safe calls, so no allocation
+            std::string narrowPath = ToUtf8(path);
+            std::string readyVariable = std::string(READY_FD_VARIABLE) + "=" + std::to_string(CHILD_READY_FD);
+            std::vector<char*> environment;
+            for (char** entry = environ; *entry; ++entry) {
+                if (std::strncmp(*entry, readyVariable.c_str(), std::strlen(READY_FD_VARIABLE) + 1) != 0) {
+                    environment.push_back(*entry);
+                }
+            }
+            environment.push_back(readyVariable.data());
+            environment.push_back(nullptr);
+            char* argv[] = { narrowPath.data(), nullptr };
+
+            pid_t pid = fork();
+            if (pid < 0) {
+                close(fds[0]);
+                close(fds[1]);
+                return false;
+            }
+
+            if (pid == 0) {
+                // Child: move the write end to CHILD_READY_FD without CLOEXEC.
+                // dup2 onto itself keeps the flag, so clear it by hand then.
+                if (fds[1] == CHILD_READY_FD) {
+                    fcntl(CHILD_READY_FD, F_SETFD, 0);
+                } else if (dup2(fds[1], CHILD_READY_FD) < 0) {
+                    _exit(127);
+                }
+                execve(narrowPath.c_str(), argv, environment.data());
+                _exit(127);
+            }
+
+            close(fds[1]);
+            if (m_readyFd >= 0) close(m_readyFd);
+            m_readyFd = fds[0];
+            m_pid = pid;
+            m_ready = false;
+            std::wcout << L"UI process launched successfully (PID: " << pid << L")" << std::endl;
+            return true;
+        }
+
+        bool WaitUntilReady(std::chrono::milliseconds timeout) override {
+            int fd;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_ready) return true;
+                fd = m_readyFd;
+            }
+            if (fd < 0) {
+                return false;
+            }
+
+            pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+                return false;
+            }
+
+            char buffer[16];
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                return false; // Child exited (or closed the pipe) before signalling
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready = true;
+            return true;
+        }
+
+        bool WaitForExit(std::chrono::milliseconds timeout) override {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    ReapLocked();
+                    if (m_pid <= 0) return true;
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+
+        bool HasProcess() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ReapLocked();
+            return m_pid > 0;
+        }
+
+        bool FileExists(const std::wstring& path) override {
+            return access(ToUtf8(path).c_str(), X_OK) == 0;
+        }
+
+        void Terminate() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pid > 0) {
+                kill(m_pid, SIGTERM);
+            }
+        }
+
+    private:
+        void ReapLocked() {
+            if (m_pid > 0 && waitpid(m_pid, nullptr, WNOHANG) == m_pid) {
+                m_pid = -1;
+                m_ready = false;
+            }
+        }
+
+        std::mutex m_mutex;
+        pid_t m_pid;
+        int m_readyFd;
+        bool m_ready;
+    };
+
+    std::unique_ptr<ProcessLauncher> CreateProcessLauncher() {
+        return std::make_unique<PosixProcessLauncher>();
+    }
+#endif
+}
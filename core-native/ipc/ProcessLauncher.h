@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace Lumos {
+    // Starts the UI process and tracks its readiness handshake. The UI signals
+    // readiness once its pipe server is listening: on Windows by setting the
+    // named event READY_EVENT_NAME, elsewhere by writing "ready" to the file
+    // descriptor passed in LUMOS_READY_FD. Implementations are thread-safe.
+    class ProcessLauncher {
+    public:
+        virtual ~ProcessLauncher() = default;
+
+        // A UI instance is alive and has completed the handshake (whether or
+        // not this launcher started it)
+        virtual bool IsReady() = 0;
+
+        // Start a new UI process; returns as soon as it is created
+        virtual bool Launch(const std::wstring& path) = 0;
+
+        // Block until the handshake completes. Returns false on timeout or if
+        // the launched process exits first.
+        virtual bool WaitUntilReady(std::chrono::milliseconds timeout) = 0;
+
+        // Block until the launched process exits. Returns true if it exited
+        // (or was never launched), false on timeout.
+        virtual bool WaitForExit(std::chrono::milliseconds timeout) = 0;
+
+        // A process started by this launcher is still running
+        virtual bool HasProcess() = 0;
+
+        virtual bool FileExists(const std::wstring& path) = 0;
+
+        virtual void Terminate() = 0;
+
+        static constexpr const wchar_t* READY_EVENT_NAME = L"Local\\LumosUIReady";
+        static constexpr const wchar_t* INSTANCE_MUTEX_NAME = L"Local\\LumosUIInstance";
+        static constexpr const char* READY_FD_VARIABLE = "LUMOS_READY_FD";
+    };
+
+    // Win32 launcher on Windows, fork/exec launcher elsewhere
+    std::unique_ptr<ProcessLauncher> CreateProcessLauncher();
+}
@@ -0,0 +1,205 @@
+#include "SharedMemory.h"
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    SharedMemory::SharedMemory()
+        : m_data(nullptr)
+        , m_size(0)
+        , m_owner(false)
+#ifdef _WIN32
+        , m_mapping(nullptr)
+#endif
+    {
+    }
+
+    SharedMemory::~SharedMemory() {
+        Close();
+    }
+
+    SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+        : SharedMemory()
+    {
+        *this = std::move(other);
+    }
+
+    SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept {
+        if (this != &other) {
+            Close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_name, other.m_name);
+            std::swap(m_owner, other.m_owner);
+#ifdef _WIN32
+            std::swap(m_mapping, other.m_mapping);
+#endif
+        }
+        return *this;
+    }
+
+    std::string SharedMemory::UniqueName(std::string_view prefix, uint64_t id) {
+#ifdef _WIN32
+        uint64_t process = GetCurrentProcessId();
+#else
+        uint64_t process = static_cast<uint64_t>(getpid());
+#endif
+        std::string name(prefix);
+        name.append(".").append(std::to_string(process)).append(".").append(std::to_string(id));
+        return name;
+    }
+
+#ifdef _WIN32
+    bool SharedMemory::Create(std::string_view name, size_t size) {
+        Close();
+        if (size == 0) {
+            return false;
+        }
+
+        m_name = "Local\\";
+        m_name.append(name);
+        std::wstring wideName(m_name.begin(), m_name.end());  // ASCII identifiers only
+
+        uint64_t size64 = size;
+        HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                            static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64),
+                                            wideName.c_str());
+        if (mapping == nullptr) {
+            m_name.clear();
+            return false;
+        }
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            // Someone else's section: never write into it
+            CloseHandle(mapping);
+            m_name.clear();
+            return false;
+        }
+
+        m_data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (m_data == nullptr) {
+            CloseHandle(mapping);
+            m_name.clear();
+            return false;
+        }
+        m_mapping = mapping;
+        m_size = size;
+        m_owner = true;
+        return true;
+    }
+
+    bool SharedMemory::Open(std::string_view name, size_t size) {
+        Close();
+        if (size == 0) {
+            return false;
+        }
+
+        std::string osName(name);
+        std::wstring wideName(osName.begin(), osName.end());
+        HANDLE mapping = OpenFileMappingW(FILE_MAP_WRITE, FALSE, wideName.c_str());
+        if (mapping == nullptr) {
+            return false;
+        }
+        m_data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (m_data == nullptr) {
+            CloseHandle(mapping);
+            return false;
+        }
+        m_mapping = mapping;
+        m_size = size;
+        m_name = std::move(osName);
+        m_owner = false;
+        return true;
+    }
+
+    void SharedMemory::Close() {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_size = 0;
+        m_name.clear();
+        m_owner = false;
+    }
+#else
+    bool SharedMemory::Create(std::string_view name, size_t size) {
+        Close();
+        if (size == 0) {
+            return false;
+        }
+
+        std::string osName = "/";
+        osName.append(name);
+        int fd = shm_open(osName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(osName.c_str());
+            return false;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            shm_unlink(osName.c_str());
+            return false;
+        }
+        m_data = data;
+        m_size = size;
+        m_name = std::move(osName);
+        m_owner = true;
+        return true;
+    }
+
+    bool SharedMemory::Open(std::string_view name, size_t size) {
+        Close();
+        if (size == 0) {
+            return false;
+        }
+
+        std::string osName(name);
+        int fd = shm_open(osName.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < size) {
+            // Mapping past the end of the object would fault on first touch
+            close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        m_data = data;
+        m_size = size;
+        m_name = std::move(osName);
+        m_owner = false;
+        return true;
+    }
+
+    void SharedMemory::Close() {
+        if (m_data) {
+            munmap(m_data, m_size);
+            if (m_owner) {
+                shm_unlink(m_name.c_str());
+            }
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_name.clear();
+        m_owner = false;
+    }
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Lumos {
+    // Named, writable shared-memory section for handing large pixel buffers
+    // to the UI process (or results back from a decoder worker) without
+    // copying them through a pipe. Others open it by Name() while the owner
+    // keeps it alive; closing it (or the next Create) releases it. Windows
+    // sections are session-local and backed by the page file; POSIX ones
+    // are shm objects unlinked when their creator closes them.
+    class SharedMemory {
+    public:
+        SharedMemory();
+        ~SharedMemory();
+
+        SharedMemory(SharedMemory&& other) noexcept;
+        SharedMemory& operator=(SharedMemory&& other) noexcept;
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        // "<prefix>.<process id>.<id>": unique to this process and request
+        static std::string UniqueName(std::string_view prefix, uint64_t id);
+
+        // `name` is a plain identifier such as UniqueName returns; the
+        // section starts zero-filled. Fails if the name is taken.
+        bool Create(std::string_view name, size_t size);
+
+        // Map a section another process created; `name` is its Name()
+        bool Open(std::string_view name, size_t size);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr; }
+        uint8_t* Data() const { return static_cast<uint8_t*>(m_data); }
+        size_t Size() const { return m_size; }
+
+        // The name other processes open, with the OS prefix ("Local\..." or "/...")
+        const std::string& Name() const { return m_name; }
+
+    private:
+        void* m_data;
+        size_t m_size;
+        std::string m_name;
+        bool m_owner;
+#ifdef _WIN32
+        void* m_mapping;
+#endif
+    };
+}
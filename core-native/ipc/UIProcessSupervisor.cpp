@@ -0,0 +1,211 @@
+#include "UIProcessSupervisor.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <climits>
+#endif
+
+namespace Lumos {
+    UIProcessSupervisor::UIProcessSupervisor(std::unique_ptr<ProcessLauncher> launcher,
+                                             std::vector<std::wstring> candidatePaths)
+        : m_launcher(std::move(launcher))
+        , m_candidatePaths(std::move(candidatePaths))
+        , m_stopping(false)
+        , m_lastStartupTime(0)
+    {
+    }
+
+    UIProcessSupervisor::~UIProcessSupervisor() {
+        Stop();
+    }
+
+    void UIProcessSupervisor::Start() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_thread.joinable()) {
+            return;
+        }
+        m_stopping = false;
+        m_thread = std::thread(&UIProcessSupervisor::SuperviseLoop, this);
+    }
+
+    void UIProcessSupervisor::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    bool UIProcessSupervisor::EnsureReady(std::chrono::milliseconds timeout) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_launcher->IsReady()) {
+                return true;
+            }
+            if (!m_launcher->HasProcess()) {
+                std::wcout << L"UI process not running, attempting to launch..." << std::endl;
+                if (!LaunchLocked()) {
+                    return false;
+                }
+            }
+        }
+
+        // Wait for the handshake rather than a fixed sleep; returns as soon as
+        // the UI's pipe server is listening
+        std::wcout << L"Waiting for UI process to signal readiness..." << std::endl;
+        if (!m_launcher->WaitUntilReady(timeout)) {
+            std::wcerr << L"UI process did not become ready within " << timeout.count() << L" ms" << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastStartupTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_launchTime);
+        return true;
+    }
+
+    bool UIProcessSupervisor::IsReady() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_launcher->IsReady();
+    }
+
+    std::chrono::milliseconds UIProcessSupervisor::LastStartupTime() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastStartupTime;
+    }
+
+    void UIProcessSupervisor::SuperviseLoop() {
+        // Warm standby: have the UI up before the first Spacebar press
+        bool launched = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_launcher->IsReady() && !m_launcher->HasProcess()) {
+                launched = LaunchLocked();
+            }
+        }
+        if (launched && m_launcher->WaitUntilReady(PRELAUNCH_READY_TIMEOUT)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_lastStartupTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - m_launchTime);
+            std::wcout << L"UI process ready after " << m_lastStartupTime.count() << L" ms" << std::endl;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopping) {
+            if (!m_launcher->HasProcess()) {
+                // Nothing of ours to watch (not launched, or started by someone else)
+                m_wake.wait_for(lock, SUPERVISE_INTERVAL);
+                continue;
+            }
+
+            lock.unlock();
+            bool exited = m_launcher->WaitForExit(SUPERVISE_INTERVAL);
+            lock.lock();
+
+            if (!exited || m_stopping || m_launcher->HasProcess()) {
+                continue;
+            }
+
+            std::wcerr << L"UI process exited unexpectedly" << std::endl;
+            if (!RestartAllowedLocked()) {
+                std::wcerr << L"UI process is crash-looping; respawn paused until the next preview" << std::endl;
+                continue;
+            }
+            LaunchLocked();
+        }
+    }
+
+    bool UIProcessSupervisor::LaunchLocked() {
+        std::wstring path = ResolvePathLocked();
+        if (!m_launcher->FileExists(path)) {
+            // The cached location went away (update, redeploy); probe again once
+            m_resolvedPath.clear();
+            path = ResolvePathLocked();
+        }
+
+        std::wcout << L"Attempting to launch UI process: " << path << std::endl;
+        if (!m_launcher->FileExists(path)) {
+            std::wcerr << L"UI process executable not found at: " << path << std::endl;
+            return false;
+        }
+
+        m_launchTime = std::chrono::steady_clock::now();
+        return m_launcher->Launch(path);
+    }
+
+    const std::wstring& UIProcessSupervisor::ResolvePathLocked() {
+        if (!m_resolvedPath.empty()) {
+            return m_resolvedPath;
+        }
+
+        for (const auto& candidate : m_candidatePaths) {
+            if (m_launcher->FileExists(candidate)) {
+                std::wcout << L"Found UI executable at: " << candidate << std::endl;
+                m_resolvedPath = candidate;
+                return m_resolvedPath;
+            }
+        }
+
+        // Default to first candidate if none found
+        if (!m_candidatePaths.empty()) {
+            std::wcout << L"UI executable not found, using default: " << m_candidatePaths[0] << std::endl;
+            m_resolvedPath = m_candidatePaths[0];
+        }
+        return m_resolvedPath;
+    }
+
+    bool UIProcessSupervisor::RestartAllowedLocked() {
+        auto now = std::chrono::steady_clock::now();
+        while (!m_restarts.empty() && now - m_restarts.front() > RESTART_WINDOW) {
+            m_restarts.pop_front();
+        }
+        if (m_restarts.size() >= MAX_RESTARTS_PER_WINDOW) {
+            return false;
+        }
+        m_restarts.push_back(now);
+        return true;
+    }
+
+    std::vector<std::wstring> UIProcessSupervisor::DefaultCandidatePaths() {
+#ifdef _WIN32
+        wchar_t exePath[MAX_PATH];
+        GetModuleFileName(nullptr, exePath, MAX_PATH);
+
+        std::wstring path(exePath);
+        size_t lastSlash = path.find_last_of(L"\\");
+        std::wstring exeDir;
+        if (lastSlash != std::wstring::npos) {
+            exeDir = path.substr(0, lastSlash + 1);
+        }
+
+        // Try multiple possible names for the UI executable
+        // In MSIX packages, .NET apps may be in win-x64 subdirectory
+        return {
+            exeDir + L"ui-managed.exe",                    // Same directory (MSIX - flat)
+            exeDir + L"win-x64\\ui-managed.exe",           // MSIX with runtime identifier folder
+            exeDir + L"Lumos.UI.exe",                      // Same directory (alternative name)
+            exeDir + L"win-x64\\Lumos.UI.exe",             // MSIX RID folder (alternative name)
+            exeDir + L"..\\ui-managed\\bin\\x64\\Release\\net8.0-windows\\ui-managed.exe",  // Dev build
+            exeDir + L"..\\ui-managed\\bin\\x64\\Release\\net8.0-windows\\Lumos.UI.exe",    // Dev build alternative
+            exeDir + L"..\\ui-managed\\bin\\x64\\Debug\\net8.0-windows\\ui-managed.exe",    // Debug build
+            exeDir + L"..\\ui-managed\\bin\\x64\\Debug\\net8.0-windows\\Lumos.UI.exe"       // Debug build alternative
+        };
+#else
+        char exePath[PATH_MAX] = { 0 };
+        ssize_t n = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+        std::wstring exeDir;
+        if (n > 0) {
+            std::string narrow(exePath, static_cast<size_t>(n));
+            narrow = narrow.substr(0, narrow.find_last_of('/') + 1);
+            exeDir.assign(narrow.begin(), narrow.end());
+        }
+        return { exeDir + L"lumos-ui" };
+#endif
+    }
+}
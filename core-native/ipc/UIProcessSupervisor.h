@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ProcessLauncher.h"
+
+namespace Lumos {
+    // Keeps the UI process warm: launches it eagerly at startup, waits on its
+    // readiness handshake instead of sleeping, and respawns it if it dies.
+    class UIProcessSupervisor {
+    public:
+        UIProcessSupervisor(std::unique_ptr<ProcessLauncher> launcher, std::vector<std::wstring> candidatePaths);
+        ~UIProcessSupervisor();
+
+        UIProcessSupervisor(const UIProcessSupervisor&) = delete;
+        UIProcessSupervisor& operator=(const UIProcessSupervisor&) = delete;
+
+        // Pre-launch the UI in the background and start watching it
+        void Start();
+        void Stop();
+
+        // Make sure a ready UI is available, launching one if needed
+        bool EnsureReady(std::chrono::milliseconds timeout);
+
+        // A UI is up and has completed the handshake; never launches
+        bool IsReady();
+
+        // Time from the last launch to its ready signal
+        std::chrono::milliseconds LastStartupTime() const;
+
+        // ui-managed.exe / Lumos.UI.exe next to this executable, in the MSIX RID
+        // folder, or in the dev build output tree
+        static std::vector<std::wstring> DefaultCandidatePaths();
+
+    private:
+        static constexpr auto SUPERVISE_INTERVAL = std::chrono::milliseconds(500);
+        static constexpr auto PRELAUNCH_READY_TIMEOUT = std::chrono::milliseconds(15000);
+        static constexpr auto RESTART_WINDOW = std::chrono::seconds(60);
+        static constexpr size_t MAX_RESTARTS_PER_WINDOW = 5;
+
+        void SuperviseLoop();
+        bool LaunchLocked();
+        const std::wstring& ResolvePathLocked();
+        bool RestartAllowedLocked();
+
+        std::unique_ptr<ProcessLauncher> m_launcher;
+        std::vector<std::wstring> m_candidatePaths;
+        std::wstring m_resolvedPath;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+        bool m_stopping;
+        std::chrono::steady_clock::time_point m_launchTime;
+        std::chrono::milliseconds m_lastStartupTime;
+        std::deque<std::chrono::steady_clock::time_point> m_restarts;
+    };
+}
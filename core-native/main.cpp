@@ -1,56 +1,175 @@
 #include <Windows.h>
 #include <iostream>
+#include <map>
+#include <string>
 #include "hooks/KeyboardHook.h"
 #include "explorer/ExplorerIntegration.h"
 #include "explorer/TrayIcon.h"
 #include "ipc/IPCClient.h"
+#include "ipc/UIProcessSupervisor.h"
+#include "io/IOScheduler.h"
+#include "memory/MemoryGovernor.h"
+#include "cache/ChangeMonitor.h"
+#include "cache/PreviewCache.h"
+#include "common/Utf8.h"
+#include "common/WorkerPool.h"
+#include "metrics/Metrics.h"
+#include "metrics/MetricsSampler.h"
+#include "pipeline/PreviewPipeline.h"
+#include "plugins/ProviderLoader.h"
+#include "plugins/ProviderRegistry.h"
+#include "replay/SessionRecorder.h"
+#include "worker/DecoderPool.h"
+#include "worker/DecoderWorker.h"
 
 using namespace Lumos;
 
-int main() {
+int main(int argc, char* argv[]) {
+    // lumos.exe also serves as its own decoder worker
+    if (DecoderWorker::IsWorkerCommandLine(argc, argv)) {
+        return DecoderWorker().Run(argc, argv);
+    }
+
     std::wcout << L"Lumos - Quick Look for Windows" << std::endl;
     std::wcout << L"Initializing..." << std::endl;
 
-    // Initialize Explorer integration
-    ExplorerIntegration explorer;
-    if (!explorer.Initialize()) {
+    // Latencies and gauges go to a shared section from here on; the UI
+    // process inherits its name and records render times alongside
+    if (Metrics::Publish()) {
+        std::wcout << L"Metrics: " << FromUtf8(Metrics::SectionName()) << std::endl;
+    } else {
+        std::wcerr << L"Failed to publish metrics; recording privately" << std::endl;
+    }
+
+    // Shared I/O scheduler: every filesystem probe goes through it with a deadline
+    IOScheduler ioScheduler;
+
+    // Global memory budget for every native cache and decoder
+    MemoryGovernor memoryGovernor;
+    wchar_t budgetValue[32] = { 0 };
+    if (GetEnvironmentVariable(L"LUMOS_MEMORY_BUDGET_MB", budgetValue, 32) > 0) {
+        size_t budgetMb = wcstoul(budgetValue, nullptr, 10);
+        if (budgetMb > 0) {
+            memoryGovernor.SetBudget(budgetMb * 1024 * 1024);
+        }
+    }
+    memoryGovernor.StartLowMemoryMonitor();
+    std::wcout << L"Memory budget: " << (memoryGovernor.Budget() / (1024 * 1024)) << L" MB" << std::endl;
+
+    // Derived preview data (probes, thumbnails, hashes), charged to the governor
+    PreviewCache previewCache(memoryGovernor, "preview-cache");
+
+    // Drops cached data for previewed folders as soon as their files change;
+    // without it entries are still checked against file stamps on use
+    ChangeMonitor changeMonitor(ioScheduler);
+    changeMonitor.Subscribe(previewCache);
+    changeMonitor.Start();
+
+    // Keep the UI process warm: launch it now rather than on the first Spacebar press
+    UIProcessSupervisor uiProcess(CreateProcessLauncher(), UIProcessSupervisor::DefaultCandidatePaths());
+    uiProcess.Start();
+
+    // Create IPC client
+    IPCClient ipcClient(uiProcess);
+
+    // CPU-bound engine work (checksums) fans out over the cores
+    WorkerPool workerPool;
+
+    // Native preview providers: built-in engines plus any libraries in the
+    // providers folder, loaded once before the first press
+    ProviderRegistry providers;
+    size_t loaded = ProviderLoader::LoadDirectory(ProviderLoader::DefaultDirectory(), providers);
+    std::wcout << L"Preview providers loaded: " << loaded << std::endl;
+
+    // Untrusted headers and provider libraries are parsed in worker
+    // processes, so a malformed file cannot take the hook down with it
+    size_t decodeWorkers = DecoderPool::DefaultWorkerCount();
+    wchar_t workersValue[32] = { 0 };
+    if (GetEnvironmentVariable(L"LUMOS_DECODE_WORKERS", workersValue, 32) > 0) {
+        decodeWorkers = wcstoul(workersValue, nullptr, 10);  // 0 decodes in-process
+    }
+    DecoderPool decoders(decodeWorkers);
+    decoders.Start();
+    std::wcout << L"Decoder workers: " << decoders.WorkerCount() << std::endl;
+
+    // LUMOS_RECORD_SESSION=<file> records presses and what they selected
+    // for lumos-replay (file extensions and sizes only, never paths)
+    SessionRecorder sessionRecorder;
+    wchar_t sessionPath[MAX_PATH] = { 0 };
+    bool recording = false;
+    if (GetEnvironmentVariable(L"LUMOS_RECORD_SESSION", sessionPath, MAX_PATH) > 0) {
+        recording = sessionRecorder.Open(sessionPath);
+        if (recording) {
+            std::wcout << L"Recording session to " << sessionPath << std::endl;
+        } else {
+            std::wcerr << L"Failed to create session file " << sessionPath << std::endl;
+        }
+    }
+
+    // Selection resolution and sending run on the pipeline's worker thread
+    auto explorerSelection = [&](IOScheduler& io) -> std::unique_ptr<SelectionSource> {
+        auto explorer = std::make_unique<ExplorerIntegration>(io);
+        if (recording) {
+            return std::make_unique<RecordingSelection>(std::move(explorer), sessionRecorder);
+        }
+        return explorer;
+    };
+    PreviewPipeline pipeline(ioScheduler, ipcClient, explorerSelection, previewCache, memoryGovernor, changeMonitor,
+                             workerPool, providers, decoders);
+    if (!pipeline.Start()) {
         std::wcerr << L"Failed to initialize Explorer integration" << std::endl;
         return 1;
     }
 
-    // Create IPC client
-    IPCClient ipcClient;
+    // Memory per pool, cache hit rate and pipeline totals for the
+    // "Performance stats" tray entry and lumos-metrics
+    MetricsSampler metricsSampler;
+    metricsSampler.Add([&, pools = std::map<std::string, size_t>()]() mutable {
+        for (auto& pool : pools) {
+            pool.second = 0;  // Pools that went away read 0
+        }
+        for (const auto& pool : memoryGovernor.Snapshot()) {
+            pools[pool.name] += pool.charged;
+        }
+        for (const auto& pool : pools) {
+            Metrics::SetGauge("Memory " + pool.first, MetricUnit::Bytes, pool.second);
+        }
+        Metrics::SetGauge("Memory total", MetricUnit::Bytes, memoryGovernor.TotalCharged());
+
+        PreviewCacheStats cache = previewCache.Stats();
+        uint64_t lookups = cache.hits + cache.misses;
+        Metrics::SetGauge("Preview cache hit rate", MetricUnit::Percent, lookups > 0 ? cache.hits * 100 / lookups : 0);
+        Metrics::SetGauge("Preview cache entries", MetricUnit::Count, cache.entries);
+
+        PreviewPipeline::Stats previews = pipeline.GetStats();
+        Metrics::SetGauge("Presses", MetricUnit::Count, previews.submitted);
+        Metrics::SetGauge("Presses superseded", MetricUnit::Count, previews.superseded + previews.coalesced);
+
+        DecoderPool::Stats decoding = decoders.GetStats();
+        Metrics::SetGauge("Decoder jobs", MetricUnit::Count, decoding.jobs);
+        Metrics::SetGauge("Decoder crashes and timeouts", MetricUnit::Count, decoding.crashes + decoding.timeouts);
+    });
+    if (recording) {
+        // Writes what the hook buffered in the last second, off the hook thread
+        metricsSampler.Add([&]() {
+            sessionRecorder.Flush();
+        });
+    }
+    metricsSampler.Start();
 
     // Create keyboard hook
     KeyboardHook keyboardHook;
 
-    // Set spacebar callback
+    // Set spacebar callback: just hand the press to the pipeline. The hook
+    // must return quickly or Windows drops it.
     keyboardHook.SetSpacebarCallback([&]() {
-        std::wcout << L"Spacebar pressed - checking for selected file..." << std::endl;
-
-        // Get selected file
-        auto fileInfo = explorer.GetSelectedFile();
-        if (fileInfo.has_value()) {
-            std::wcout << L"Selected file: " << fileInfo->path << std::endl;
-            std::wcout << L"Extension: " << fileInfo->extension << std::endl;
-            std::wcout << L"Size: " << fileInfo->size << L" bytes" << std::endl;
-
-            // Create preview request
-            PreviewRequest request;
-            request.path = fileInfo->path;
-            request.extension = fileInfo->extension;
-            request.size = fileInfo->size;
-
-            // Send to UI process
-            if (ipcClient.SendPreviewRequest(request)) {
-                std::wcout << L"Preview request sent successfully" << std::endl;
-            } else {
-                std::wcerr << L"Failed to send preview request" << std::endl;
-            }
-        } else {
-            std::wcout << L"No file selected or folder selected" << std::endl;
-        }
+        pipeline.Submit();
     });
+    if (recording) {
+        keyboardHook.SetKeyObserver([&](const HookContext& context, bool triggered) {
+            sessionRecorder.RecordKey(context, triggered);
+        });
+    }
 
     // Install keyboard hook
     if (!keyboardHook.Install()) {
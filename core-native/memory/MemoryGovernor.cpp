@@ -0,0 +1,264 @@
+#include "MemoryGovernor.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace Lumos {
+    namespace {
+        int64_t NowTicks() {
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+        }
+
+        void UpdatePeak(std::atomic<size_t>& peak, size_t value) {
+            size_t current = peak.load(std::memory_order_relaxed);
+            while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    MemoryPool::MemoryPool(MemoryGovernor& governor, std::string name, PoolPriority priority, ReclaimCallback reclaim)
+        : m_governor(governor)
+        , m_name(std::move(name))
+        , m_priority(priority)
+        , m_reclaim(std::move(reclaim))
+        , m_charged(0)
+        , m_peak(0)
+        , m_reclaimed(0)
+        , m_refused(0)
+        , m_lastUse(NowTicks())
+    {
+    }
+
+    MemoryPool::~MemoryPool() {
+        m_governor.m_total.fetch_sub(m_charged.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    bool MemoryPool::TryCharge(size_t bytes) {
+        Touch();
+        size_t budget = m_governor.Budget();
+        size_t total = m_governor.m_total.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+        if (total > budget) {
+            // Free a little more than strictly needed so the next few charges
+            // do not each pay for a reclaim pass
+            size_t needed = total - budget + budget / 16;
+            m_governor.Reclaim(needed, this);
+
+            if (m_governor.m_total.load(std::memory_order_relaxed) > budget) {
+                m_governor.m_total.fetch_sub(bytes, std::memory_order_relaxed);
+                m_refused.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        UpdatePeak(m_peak, m_charged.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        return true;
+    }
+
+    void MemoryPool::ForceCharge(size_t bytes) {
+        Touch();
+        m_governor.m_total.fetch_add(bytes, std::memory_order_relaxed);
+        UpdatePeak(m_peak, m_charged.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+
+    void MemoryPool::Release(size_t bytes) {
+        // Clamp and subtract in one step, so racing releases can neither
+        // wrap the pool below zero nor return more than it held
+        size_t current = m_charged.load(std::memory_order_relaxed);
+        size_t taken = std::min(bytes, current);
+        while (!m_charged.compare_exchange_weak(current, current - taken, std::memory_order_relaxed)) {
+            taken = std::min(bytes, current);
+        }
+        m_governor.m_total.fetch_sub(taken, std::memory_order_relaxed);
+    }
+
+    void MemoryPool::Touch() {
+        m_lastUse.store(NowTicks(), std::memory_order_relaxed);
+    }
+
+    MemoryGovernor::MemoryGovernor(size_t budgetBytes)
+        : m_budget(budgetBytes)
+        , m_total(0)
+        , m_monitorStopping(false)
+        , m_stopEvent(nullptr)
+    {
+    }
+
+    MemoryGovernor::~MemoryGovernor() {
+        StopLowMemoryMonitor();
+    }
+
+    std::shared_ptr<MemoryPool> MemoryGovernor::RegisterPool(std::string name, PoolPriority priority,
+                                                             MemoryPool::ReclaimCallback reclaim) {
+        std::shared_ptr<MemoryPool> pool(new MemoryPool(*this, std::move(name), priority, std::move(reclaim)));
+
+        std::lock_guard<std::mutex> lock(m_poolsMutex);
+        m_pools.erase(std::remove_if(m_pools.begin(), m_pools.end(),
+                                     [](const std::weak_ptr<MemoryPool>& p) { return p.expired(); }),
+                      m_pools.end());
+        m_pools.push_back(pool);
+        return pool;
+    }
+
+    void MemoryGovernor::SetBudget(size_t budgetBytes) {
+        m_budget.store(budgetBytes, std::memory_order_relaxed);
+
+        size_t total = TotalCharged();
+        if (total > budgetBytes) {
+            Reclaim(total - budgetBytes, nullptr);
+        }
+    }
+
+    std::vector<PoolStats> MemoryGovernor::Snapshot() const {
+        std::vector<PoolStats> stats;
+        std::lock_guard<std::mutex> lock(m_poolsMutex);
+        for (const auto& weak : m_pools) {
+            if (auto pool = weak.lock()) {
+                stats.push_back({
+                    pool->m_name,
+                    pool->m_priority,
+                    pool->m_charged.load(std::memory_order_relaxed),
+                    pool->m_peak.load(std::memory_order_relaxed),
+                    pool->m_reclaimed.load(std::memory_order_relaxed),
+                    pool->m_refused.load(std::memory_order_relaxed)
+                });
+            }
+        }
+        return stats;
+    }
+
+    void MemoryGovernor::OnLowMemory() {
+        size_t target = Budget() / 2;
+        size_t total = TotalCharged();
+        if (total > target) {
+            size_t freed = Reclaim(total - target, nullptr);
+            std::wcout << L"[Memory] Low-memory notification, reclaimed " << (freed / 1024) << L" KB" << std::endl;
+        }
+    }
+
+    size_t MemoryGovernor::Reclaim(size_t needed, const MemoryPool* requester) {
+        std::unique_lock<std::mutex> reclaimLock(m_reclaimMutex, std::try_to_lock);
+        if (!reclaimLock.owns_lock()) {
+            return 0;
+        }
+
+        // Keep the candidates alive while their callbacks run outside m_poolsMutex
+        std::vector<std::shared_ptr<MemoryPool>> candidates;
+        {
+            std::lock_guard<std::mutex> lock(m_poolsMutex);
+            for (const auto& weak : m_pools) {
+                auto pool = weak.lock();
+                if (pool && pool.get() != requester && pool->m_reclaim &&
+                    pool->m_priority != PoolPriority::Critical &&
+                    (!requester || pool->m_priority <= requester->m_priority) &&
+                    pool->m_charged.load(std::memory_order_relaxed) > 0) {
+                    candidates.push_back(std::move(pool));
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+            if (a->m_priority != b->m_priority) {
+                return a->m_priority < b->m_priority;
+            }
+            return a->m_lastUse.load(std::memory_order_relaxed) < b->m_lastUse.load(std::memory_order_relaxed);
+        });
+
+        size_t freed = 0;
+        for (const auto& pool : candidates) {
+            if (freed >= needed) {
+                break;
+            }
+            size_t got = pool->m_reclaim(needed - freed);
+            pool->m_reclaimed.fetch_add(got, std::memory_order_relaxed);
+            freed += got;
+        }
+        return freed;
+    }
+
+    void MemoryGovernor::StartLowMemoryMonitor() {
+        if (m_monitor.joinable()) {
+            return;
+        }
+        m_monitorStopping = false;
+#ifdef _WIN32
+        m_stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+#endif
+        m_monitor = std::thread(&MemoryGovernor::MonitorLoop, this);
+    }
+
+    void MemoryGovernor::StopLowMemoryMonitor() {
+        if (!m_monitor.joinable()) {
+            return;
+        }
+        m_monitorStopping = true;
+#ifdef _WIN32
+        SetEvent(static_cast<HANDLE>(m_stopEvent));
+#endif
+        m_monitor.join();
+#ifdef _WIN32
+        CloseHandle(static_cast<HANDLE>(m_stopEvent));
+        m_stopEvent = nullptr;
+#endif
+    }
+
+    void MemoryGovernor::MonitorLoop() {
+#ifdef _WIN32
+        HANDLE lowMemory = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+        if (lowMemory == nullptr) {
+            std::wcerr << L"[Memory] Low-memory notifications unavailable" << std::endl;
+            return;
+        }
+
+        HANDLE handles[] = { static_cast<HANDLE>(m_stopEvent), lowMemory };
+        while (!m_monitorStopping) {
+            DWORD result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (result != WAIT_OBJECT_0 + 1) {
+                break;
+            }
+            OnLowMemory();
+
+            // The notification stays signalled while memory is low; back off
+            // instead of trimming in a tight loop
+            if (WaitForSingleObject(handles[0], 2000) == WAIT_OBJECT_0) {
+                break;
+            }
+        }
+        CloseHandle(lowMemory);
+#else
+        // Pressure stall information trigger: fire when tasks stall on memory
+        // for 150 ms within any 1 s window
+        int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            std::wcerr << L"[Memory] Low-memory notifications unavailable" << std::endl;
+            return;
+        }
+        const char trigger[] = "some 150000 1000000";
+        if (write(fd, trigger, strlen(trigger) + 1) < 0) {
+            close(fd);
+            std::wcerr << L"[Memory] Low-memory notifications unavailable" << std::endl;
+            return;
+        }
+
+        while (!m_monitorStopping) {
+            pollfd pfd = { fd, POLLPRI, 0 };
+            int n = poll(&pfd, 1, 500);
+            if (n < 0 || (pfd.revents & POLLERR)) {
+                break;
+            }
+            if (n > 0 && (pfd.revents & POLLPRI)) {
+                OnLowMemory();
+            }
+        }
+        close(fd);
+#endif
+    }
+}
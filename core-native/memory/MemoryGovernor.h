@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Lumos {
+    // Pools are reclaimed lowest priority first, least recently used first
+    // within the same priority. Critical pools are charged but never reclaimed.
+    enum class PoolPriority {
+        Speculative = 0,  // Prefetched / warm-up data
+        Cache = 1,        // Previously shown previews
+        Active = 2,       // Data backing the preview on screen
+        Critical = 3      // Never reclaimed
+    };
+
+    struct PoolStats {
+        std::string name;
+        PoolPriority priority;
+        size_t charged;
+        size_t peak;
+        size_t reclaimed;
+        uint64_t refused;
+    };
+
+    class MemoryGovernor;
+
+    // A charged pool owned by one cache or decoder. The owner charges bytes
+    // before it keeps them and releases them when it drops them.
+    class MemoryPool {
+    public:
+        // Asks the owner to free roughly `bytes`; returns what was actually freed.
+        // Runs on whichever thread triggered the reclaim and must not charge.
+        using ReclaimCallback = std::function<size_t(size_t bytes)>;
+
+        ~MemoryPool();
+
+        // Charge bytes against the global budget, reclaiming other pools if
+        // needed. Returns false (and charges nothing) if the budget cannot be met.
+        bool TryCharge(size_t bytes);
+
+        // Charge unconditionally (for memory that is already committed)
+        void ForceCharge(size_t bytes);
+
+        void Release(size_t bytes);
+
+        // Mark the pool as recently used
+        void Touch();
+
+        size_t Charged() const { return m_charged.load(std::memory_order_relaxed); }
+        const std::string& Name() const { return m_name; }
+
+    private:
+        friend class MemoryGovernor;
+        MemoryPool(MemoryGovernor& governor, std::string name, PoolPriority priority, ReclaimCallback reclaim);
+
+        MemoryGovernor& m_governor;
+        std::string m_name;
+        PoolPriority m_priority;
+        ReclaimCallback m_reclaim;
+
+        std::atomic<size_t> m_charged;
+        std::atomic<size_t> m_peak;
+        std::atomic<size_t> m_reclaimed;
+        std::atomic<uint64_t> m_refused;
+        std::atomic<int64_t> m_lastUse;
+    };
+
+    // Central memory budget shared by every native cache and decoder
+    class MemoryGovernor {
+    public:
+        explicit MemoryGovernor(size_t budgetBytes = DEFAULT_BUDGET);
+        ~MemoryGovernor();
+
+        MemoryGovernor(const MemoryGovernor&) = delete;
+        MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+        std::shared_ptr<MemoryPool> RegisterPool(std::string name, PoolPriority priority,
+                                                 MemoryPool::ReclaimCallback reclaim = nullptr);
+
+        void SetBudget(size_t budgetBytes);
+        size_t Budget() const { return m_budget.load(std::memory_order_relaxed); }
+        size_t TotalCharged() const { return m_total.load(std::memory_order_relaxed); }
+
+        // Live per-pool accounting
+        std::vector<PoolStats> Snapshot() const;
+
+        // Shrink everything reclaimable down to a fraction of the budget.
+        // Called by the OS low-memory monitor; may be called directly.
+        void OnLowMemory();
+
+        // Watch for OS low-memory notifications (memory resource notification
+        // on Windows, PSI on Linux) on a background thread
+        void StartLowMemoryMonitor();
+        void StopLowMemoryMonitor();
+
+        static constexpr size_t DEFAULT_BUDGET = 256ull * 1024 * 1024;
+
+    private:
+        friend class MemoryPool;
+
+        // Reclaim at least `needed` bytes from pools other than `requester`,
+        // never from a pool that outranks it. Without a requester (budget
+        // changes, low memory) every pool but Critical may give up memory.
+        size_t Reclaim(size_t needed, const MemoryPool* requester);
+        void MonitorLoop();
+
+        std::atomic<size_t> m_budget;
+        std::atomic<size_t> m_total;
+
+        mutable std::mutex m_poolsMutex;
+        std::vector<std::weak_ptr<MemoryPool>> m_pools;
+
+        // Only one thread reclaims at a time; others fail fast instead of
+        // waiting (a reclaim callback may need a lock the waiter holds)
+        std::mutex m_reclaimMutex;
+
+        std::thread m_monitor;
+        std::atomic<bool> m_monitorStopping;
+        void* m_stopEvent; // Win32 event handle; unused elsewhere
+    };
+}
@@ -0,0 +1,29 @@
+#include "RequestArena.h"
+#include <algorithm>
+
+namespace Lumos {
+    RequestArena::RequestArena(size_t initialCapacity)
+        : m_buffer(new std::byte[initialCapacity])
+        , m_capacity(initialCapacity)
+        , m_allocationsAtReset(0)
+        , m_bytesAtReset(0)
+    {
+        m_arena.emplace(m_buffer.get(), m_capacity, &m_upstream);
+    }
+
+    void RequestArena::Reset() {
+        size_t spilled = m_upstream.Bytes() - m_bytesAtReset;
+        m_arena.reset();
+
+        // Grow once to cover the largest request seen so far; after warm-up every
+        // request is served from the inline buffer and the heap is never touched.
+        if (spilled > 0 && m_capacity < MAX_CAPACITY) {
+            m_capacity = std::min(MAX_CAPACITY, std::max(m_capacity * 2, m_capacity + spilled));
+            m_buffer.reset(new std::byte[m_capacity]);
+        }
+
+        m_arena.emplace(m_buffer.get(), m_capacity, &m_upstream);
+        m_allocationsAtReset = m_upstream.Allocations();
+        m_bytesAtReset = m_upstream.Bytes();
+    }
+}
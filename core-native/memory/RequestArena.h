@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace Lumos {
+    // Upstream resource that forwards to the heap and counts every trip there.
+    // Used to verify the arena absorbs the whole request in steady state.
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+            : m_upstream(upstream)
+            , m_allocations(0)
+            , m_bytes(0)
+        {
+        }
+
+        size_t Allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+        size_t Bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            m_allocations.fetch_add(1, std::memory_order_relaxed);
+            m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        std::atomic<size_t> m_allocations;
+        std::atomic<size_t> m_bytes;
+    };
+
+    // Per-request monotonic arena. Everything transient that one preview request
+    // allocates (paths, extensions, serialized JSON, engine scratch) comes from
+    // here and is released together by Reset() when the next request starts.
+    // Not thread-safe: one arena per pipeline thread.
+    class RequestArena {
+    public:
+        explicit RequestArena(size_t initialCapacity = DEFAULT_CAPACITY);
+
+        RequestArena(const RequestArena&) = delete;
+        RequestArena& operator=(const RequestArena&) = delete;
+
+        std::pmr::memory_resource* Resource() { return &*m_arena; }
+
+        // Release everything from the previous request. If that request spilled
+        // to the heap, the inline buffer grows so the next one fits.
+        void Reset();
+
+        // Heap allocations made by the arena since construction / the last Reset()
+        size_t UpstreamAllocations() const { return m_upstream.Allocations() - m_allocationsAtReset; }
+        size_t Capacity() const { return m_capacity; }
+
+    private:
+        static constexpr size_t DEFAULT_CAPACITY = 16 * 1024;
+        static constexpr size_t MAX_CAPACITY = 4 * 1024 * 1024;
+
+        std::unique_ptr<std::byte[]> m_buffer;
+        size_t m_capacity;
+        CountingResource m_upstream;
+        size_t m_allocationsAtReset;
+        size_t m_bytesAtReset;
+        std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+    };
+}
@@ -0,0 +1,181 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstring>
+#include "../ipc/SharedMemory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    namespace {
+        uint64_t ProcessId() {
+#ifdef _WIN32
+            return GetCurrentProcessId();
+#else
+            return static_cast<uint64_t>(getpid());
+#endif
+        }
+
+        uint64_t UnixMilliseconds() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        // Recording starts in private memory, so the core records whether or
+        // not it ever publishes
+        MetricsSection& PrivateSection() {
+            static MetricsSection section;
+            return section;
+        }
+
+        MetricsSection* InitializePrivate() {
+            Metrics::Initialize(PrivateSection());
+            return &PrivateSection();
+        }
+
+        void CopyName(char* out, size_t capacity, std::string_view name) {
+            size_t length = std::min(name.size(), capacity - 1);
+            std::memcpy(out, name.data(), length);
+            std::memset(out + length, 0, capacity - length);
+        }
+    }
+
+    // Owns the published section. At exit recording falls back to private
+    // memory before the section is unmapped (and on POSIX unlinked).
+    class MetricsPublication {
+    public:
+        ~MetricsPublication() {
+            if (section.IsOpen()) {
+                Metrics::s_live.store(&PrivateSection(), std::memory_order_release);
+            }
+        }
+
+        SharedMemory section;
+    };
+
+    namespace {
+        MetricsPublication& Publication() {
+            static MetricsPublication publication;
+            return publication;
+        }
+    }
+
+    std::atomic<MetricsSection*> Metrics::s_live(InitializePrivate());
+
+    uint64_t Metrics::BucketLow(size_t index) {
+        using namespace MetricsLayout;
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint32_t exponent = static_cast<uint32_t>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        uint64_t sub = SUB_BUCKETS + index % SUB_BUCKETS;
+        return sub << (exponent - SUB_BUCKET_BITS);
+    }
+
+    uint64_t Metrics::BucketHigh(size_t index) {
+        using namespace MetricsLayout;
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint32_t exponent = static_cast<uint32_t>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        return BucketLow(index) + (1ull << (exponent - SUB_BUCKET_BITS)) - 1;
+    }
+
+    bool Metrics::SetGauge(std::string_view name, MetricUnit unit, uint64_t value) {
+        MetricsSection& section = *s_live.load(std::memory_order_relaxed);
+        if (name.size() >= MetricsLayout::GAUGE_NAME_BYTES) {
+            name = name.substr(0, MetricsLayout::GAUGE_NAME_BYTES - 1);
+        }
+        MetricsGauge* empty = nullptr;
+        for (auto& gauge : section.gauges) {
+            if (gauge.name[0] == '\0') {
+                if (!empty) {
+                    empty = &gauge;
+                }
+            } else if (name == gauge.name) {
+                gauge.value.store(value, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        if (!empty) {
+            return false;
+        }
+        // Value before name: a reader that sees the name sees a real value
+        empty->unit = static_cast<uint32_t>(unit);
+        empty->value.store(value, std::memory_order_release);
+        CopyName(empty->name, sizeof(empty->name), name);
+        return true;
+    }
+
+    void Metrics::StampSample() {
+        s_live.load(std::memory_order_relaxed)->header.sampledAt.store(UnixMilliseconds(), std::memory_order_release);
+    }
+
+    bool Metrics::Publish() {
+        SharedMemory& published = Publication().section;
+        if (published.IsOpen()) {
+            return true;
+        }
+        std::string name = SECTION_PREFIX;
+        name.append(".").append(std::to_string(ProcessId()));
+        if (!published.Create(name, sizeof(MetricsSection))) {
+            return false;
+        }
+        auto* section = reinterpret_cast<MetricsSection*>(published.Data());
+        Initialize(*section);
+        s_live.store(section, std::memory_order_release);
+
+#ifdef _WIN32
+        std::wstring wideName(published.Name().begin(), published.Name().end());
+        std::wstring variable(ENVIRONMENT_VARIABLE, ENVIRONMENT_VARIABLE + std::strlen(ENVIRONMENT_VARIABLE));
+        SetEnvironmentVariableW(variable.c_str(), wideName.c_str());
+#else
+        setenv(ENVIRONMENT_VARIABLE, published.Name().c_str(), 1);
+#endif
+        return true;
+    }
+
+    const std::string& Metrics::SectionName() {
+        return Publication().section.Name();
+    }
+
+    void Metrics::Initialize(MetricsSection& section) {
+        MetricsHeader& header = section.header;
+        header.magic = MetricsLayout::MAGIC;
+        header.version = MetricsLayout::VERSION;
+        header.subBucketBits = MetricsLayout::SUB_BUCKET_BITS;
+        header.bucketCount = static_cast<uint32_t>(MetricsLayout::BUCKETS);
+        header.histogramCount = static_cast<uint32_t>(MetricsLayout::HISTOGRAMS);
+        header.histogramStride = static_cast<uint32_t>(sizeof(MetricsHistogram));
+        header.histogramsOffset = static_cast<uint32_t>(offsetof(MetricsSection, histograms));
+        header.gaugeCount = static_cast<uint32_t>(MetricsLayout::GAUGES);
+        header.gaugeStride = static_cast<uint32_t>(sizeof(MetricsGauge));
+        header.gaugesOffset = static_cast<uint32_t>(offsetof(MetricsSection, gauges));
+        header.firstRendererSlot = static_cast<uint32_t>(Histogram::COUNT);
+        header.processId = ProcessId();
+        header.startedAt = UnixMilliseconds();
+
+        for (size_t i = 0; i < static_cast<size_t>(Histogram::COUNT); ++i) {
+            CopyName(section.histograms[i].name, MetricsLayout::NAME_BYTES, Name(static_cast<Histogram>(i)));
+        }
+    }
+
+    const char* Metrics::Name(Histogram histogram) {
+        switch (histogram) {
+        case Histogram::HookCallback: return "Hook callback";
+        case Histogram::HookToSend: return "Hook to send";
+        case Histogram::SelectionResolve: return "Selection";
+        case Histogram::PipeSend: return "Pipe send";
+        case Histogram::DecoderJob: return "Decoder job";
+        case Histogram::HashFile: return "Hash file";
+        case Histogram::DatabaseRead: return "Database read";
+        case Histogram::FontSpecimen: return "Font specimen";
+        case Histogram::ProviderPreview: return "Provider preview";
+        default: return "";
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Lumos {
+    // Latencies the core records, in nanoseconds
+    enum class Histogram : uint16_t {
+        HookCallback,      // Spacebar handling inside the keyboard hook
+        HookToSend,        // Press to its preview request written to the pipe
+        SelectionResolve,  // Asking Explorer for the selected file
+        PipeSend,          // Connecting to the UI's pipe and writing one message
+        DecoderJob,        // One job's round trip through a decoder worker
+        HashFile,          // Checksumming a file with every algorithm
+        DatabaseRead,      // Reading a SQLite file's schema and first rows
+        FontSpecimen,      // Rasterizing a font's specimen page
+        ProviderPreview,   // A native provider's run, in process or in a worker
+        COUNT
+    };
+
+    enum class MetricUnit : uint32_t {
+        Count = 0,
+        Bytes = 1,
+        Percent = 2
+    };
+
+    namespace MetricsLayout {
+        constexpr uint32_t MAGIC = 0x54454D4C;  // "LMET"
+        constexpr uint16_t VERSION = 1;
+
+        // Log-linear buckets: exact below 16 ns, then 16 per power of two
+        // (within 6.25%) up to 2^40 ns, about 18 minutes
+        constexpr uint32_t SUB_BUCKET_BITS = 4;
+        constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+        constexpr uint32_t MAX_EXPONENT = 40;
+        constexpr uint64_t MAX_VALUE = (1ull << MAX_EXPONENT) - 1;
+        constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        // Histograms after the core's own are named and filled by the UI
+        // process, one per renderer
+        constexpr size_t RENDERER_SLOTS = 16;
+        constexpr size_t HISTOGRAMS = static_cast<size_t>(Histogram::COUNT) + RENDERER_SLOTS;
+        constexpr size_t GAUGES = 48;
+
+        constexpr size_t NAME_BYTES = 32;
+        constexpr size_t GAUGE_NAME_BYTES = 48;
+    }
+
+    // The first 64 bytes of the section describe the rest, so readers in
+    // other languages find the tables by offset rather than by layout
+    struct MetricsHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t subBucketBits;
+        uint32_t bucketCount;
+        uint32_t histogramCount;
+        uint32_t histogramStride;
+        uint32_t histogramsOffset;
+        uint32_t gaugeCount;
+        uint32_t gaugeStride;
+        uint32_t gaugesOffset;
+        uint32_t firstRendererSlot;
+        uint64_t processId;
+        uint64_t startedAt;                // Unix milliseconds
+        std::atomic<uint64_t> sampledAt;   // Unix milliseconds of the last gauge sample
+    };
+
+    // Unnamed histograms are unused. Counts per bucket; the total is their sum.
+    struct MetricsHistogram {
+        char name[MetricsLayout::NAME_BYTES];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+        std::atomic<uint64_t> buckets[MetricsLayout::BUCKETS];
+    };
+
+    // Sampled values: memory per pool, cache and pool totals
+    struct MetricsGauge {
+        char name[MetricsLayout::GAUGE_NAME_BYTES];
+        uint32_t unit;  // MetricUnit
+        uint32_t reserved;
+        std::atomic<uint64_t> value;
+    };
+
+    struct MetricsSection {
+        MetricsHeader header;
+        MetricsHistogram histograms[MetricsLayout::HISTOGRAMS];
+        MetricsGauge gauges[MetricsLayout::GAUGES];
+    };
+
+    static_assert(sizeof(MetricsHeader) == 64, "MetricsHeader layout is read by other processes");
+    static_assert(sizeof(MetricsGauge) == 64, "MetricsGauge layout is read by other processes");
+    static_assert(offsetof(MetricsHistogram, buckets) == 48, "MetricsHistogram layout is read by other processes");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Metrics are shared between processes");
+
+    class MetricsPublication;
+
+    // Always-on process metrics. Recording is a few relaxed atomic adds on
+    // memory that, once Publish() has run, is a named shared-memory section
+    // any local process can map (see MetricsReport and tools/MetricsDump).
+    class Metrics {
+    public:
+        static void Record(Histogram histogram, uint64_t nanoseconds) {
+            RecordInto(s_live.load(std::memory_order_relaxed)->histograms[static_cast<size_t>(histogram)], nanoseconds);
+        }
+
+        static void Record(Histogram histogram, std::chrono::steady_clock::duration elapsed) {
+            auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            Record(histogram, nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+        }
+
+        static void RecordInto(MetricsHistogram& histogram, uint64_t nanoseconds) {
+            histogram.buckets[BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+            histogram.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+            uint64_t max = histogram.max.load(std::memory_order_relaxed);
+            while (nanoseconds > max &&
+                   !histogram.max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+            }
+        }
+
+        static size_t BucketIndex(uint64_t value) {
+            using namespace MetricsLayout;
+            if (value > MAX_VALUE) {
+                value = MAX_VALUE;
+            }
+            if (value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+            uint32_t exponent = HighestBit(value);
+            return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS +
+                   static_cast<size_t>((value >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS);
+        }
+
+        // Smallest and largest value counted in a bucket
+        static uint64_t BucketLow(size_t index);
+        static uint64_t BucketHigh(size_t index);
+
+        // Set a named gauge, taking a free slot the first time the name is
+        // seen. Called by MetricsSampler's thread only. False if full.
+        static bool SetGauge(std::string_view name, MetricUnit unit, uint64_t value);
+        static void StampSample();
+
+        // Create this process's section ("LumosMetrics.<process id>") and
+        // record into it from now on; it is released at exit. Call before
+        // anything records: earlier values stay behind in private memory.
+        // Also exports the name as LUMOS_METRICS to child processes.
+        static bool Publish();
+        static const std::string& SectionName();
+
+        static const MetricsSection& Live() { return *s_live.load(std::memory_order_acquire); }
+
+        static constexpr const char* SECTION_PREFIX = "LumosMetrics";
+        static constexpr const char* ENVIRONMENT_VARIABLE = "LUMOS_METRICS";
+
+        // Write the header and the core's histogram names into a zeroed section
+        static void Initialize(MetricsSection& section);
+        static const char* Name(Histogram histogram);
+
+    private:
+        static uint32_t HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return index;
+#else
+            return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+        }
+
+        friend class MetricsPublication;
+        static std::atomic<MetricsSection*> s_live;
+    };
+
+    // Records the time from construction to destruction
+    class ScopedLatency {
+    public:
+        explicit ScopedLatency(Histogram histogram)
+            : m_histogram(histogram)
+            , m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedLatency() {
+            Metrics::Record(m_histogram, std::chrono::steady_clock::now() - m_start);
+        }
+
+        ScopedLatency(const ScopedLatency&) = delete;
+        ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+    private:
+        Histogram m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
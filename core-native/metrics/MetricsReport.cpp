@@ -0,0 +1,182 @@
+#include "MetricsReport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "../common/Utf8.h"
+#include "../ipc/SharedMemory.h"
+
+namespace Lumos {
+    namespace {
+        std::string ReadName(const char* name, size_t capacity) {
+            return std::string(name, strnlen(name, capacity));
+        }
+
+        std::wstring Pad(std::wstring text, size_t width, bool right) {
+            if (text.size() >= width) {
+                return text;
+            }
+            std::wstring padding(width - text.size(), L' ');
+            return right ? padding + text : text + padding;
+        }
+
+        std::wstring Printf(const wchar_t* format, double value) {
+            wchar_t buffer[32];
+            std::swprintf(buffer, 32, format, value);
+            return buffer;
+        }
+    }
+
+    bool MetricsReport::Capture(const MetricsSection& section, MetricsSnapshot& out) {
+        const MetricsHeader& header = section.header;
+        if (header.magic != MetricsLayout::MAGIC || header.version != MetricsLayout::VERSION ||
+            header.bucketCount != MetricsLayout::BUCKETS || header.histogramCount != MetricsLayout::HISTOGRAMS ||
+            header.histogramStride != sizeof(MetricsHistogram) || header.gaugeCount != MetricsLayout::GAUGES) {
+            return false;
+        }
+        out.processId = header.processId;
+        out.startedAt = header.startedAt;
+        out.sampledAt = header.sampledAt.load(std::memory_order_acquire);
+        out.histograms.clear();
+        out.gauges.clear();
+
+        uint64_t buckets[MetricsLayout::BUCKETS];
+        for (const auto& histogram : section.histograms) {
+            if (histogram.name[0] == '\0') {
+                continue;
+            }
+            // Totals from the same reads as the percentiles, so they agree
+            // even while other threads record
+            uint64_t count = 0;
+            for (size_t i = 0; i < MetricsLayout::BUCKETS; ++i) {
+                buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+                count += buckets[i];
+            }
+            HistogramSummary summary;
+            summary.name = ReadName(histogram.name, sizeof(histogram.name));
+            summary.count = count;
+            summary.max = histogram.max.load(std::memory_order_relaxed);
+            summary.mean = count > 0 ? histogram.sum.load(std::memory_order_relaxed) / count : 0;
+            summary.p50 = Percentile(buckets, count, summary.max, 0.50);
+            summary.p95 = Percentile(buckets, count, summary.max, 0.95);
+            summary.p99 = Percentile(buckets, count, summary.max, 0.99);
+            out.histograms.push_back(std::move(summary));
+        }
+
+        for (const auto& gauge : section.gauges) {
+            if (gauge.name[0] == '\0') {
+                continue;
+            }
+            GaugeValue value;
+            value.name = ReadName(gauge.name, sizeof(gauge.name));
+            value.unit = static_cast<MetricUnit>(gauge.unit);
+            value.value = gauge.value.load(std::memory_order_acquire);
+            out.gauges.push_back(std::move(value));
+        }
+        return true;
+    }
+
+    bool MetricsReport::CaptureSection(std::string_view name, MetricsSnapshot& out, std::wstring& error) {
+        SharedMemory section;
+        if (!section.Open(name, sizeof(MetricsSection))) {
+            error = L"Cannot open metrics section " + FromUtf8(name);
+            return false;
+        }
+        if (!Capture(*reinterpret_cast<const MetricsSection*>(section.Data()), out)) {
+            error = L"Metrics section " + FromUtf8(name) + L" was written by a different Lumos build";
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t MetricsReport::Percentile(const uint64_t (&buckets)[MetricsLayout::BUCKETS], uint64_t count, uint64_t max,
+                                       double q) {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < MetricsLayout::BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t low = Metrics::BucketLow(i);
+                uint64_t middle = low + (Metrics::BucketHigh(i) - low) / 2;
+                return std::min(middle, max);
+            }
+        }
+        return max;
+    }
+
+    std::wstring MetricsReport::Format(const MetricsSnapshot& snapshot, uint64_t now) {
+        std::wstring text = L"Lumos performance (PID " + std::to_wstring(snapshot.processId);
+        if (now > snapshot.startedAt) {
+            uint64_t minutes = (now - snapshot.startedAt) / 60000;
+            text += L", up " + std::to_wstring(minutes / 60) + L"h " + std::to_wstring(minutes % 60) + L"m";
+        }
+        text += L")\n\n";
+
+        text += Pad(L"Latency", 18, false) + Pad(L"count", 9, true) + Pad(L"p50", 10, true) + Pad(L"p95", 10, true) +
+                Pad(L"p99", 10, true) + Pad(L"max", 10, true) + L"\n";
+        for (const auto& histogram : snapshot.histograms) {
+            text += Pad(FromUtf8(histogram.name), 18, false) + Pad(std::to_wstring(histogram.count), 9, true);
+            if (histogram.count == 0) {
+                text += Pad(L"-", 10, true) + Pad(L"-", 10, true) + Pad(L"-", 10, true) + Pad(L"-", 10, true);
+            } else {
+                text += Pad(FormatDuration(histogram.p50), 10, true) + Pad(FormatDuration(histogram.p95), 10, true) +
+                        Pad(FormatDuration(histogram.p99), 10, true) + Pad(FormatDuration(histogram.max), 10, true);
+            }
+            text += L"\n";
+        }
+
+        if (!snapshot.gauges.empty()) {
+            text += L"\n";
+            for (const auto& gauge : snapshot.gauges) {
+                std::wstring value;
+                switch (gauge.unit) {
+                case MetricUnit::Bytes:
+                    value = FormatBytes(gauge.value);
+                    break;
+                case MetricUnit::Percent:
+                    value = std::to_wstring(gauge.value) + L" %";
+                    break;
+                default:
+                    value = std::to_wstring(gauge.value);
+                    break;
+                }
+                text += Pad(FromUtf8(gauge.name), 36, false) + Pad(value, 12, true) + L"\n";
+            }
+            if (snapshot.sampledAt != 0 && now >= snapshot.sampledAt) {
+                text += L"(sampled " + std::to_wstring((now - snapshot.sampledAt) / 1000) + L" s ago)\n";
+            }
+        }
+        return text;
+    }
+
+    std::wstring MetricsReport::FormatDuration(uint64_t nanoseconds) {
+        if (nanoseconds < 1000) {
+            return std::to_wstring(nanoseconds) + L" ns";
+        }
+        double value = static_cast<double>(nanoseconds);
+        if (nanoseconds < 1000000) {
+            return Printf(L"%.1f us", value / 1e3);
+        }
+        if (nanoseconds < 1000000000) {
+            return Printf(L"%.1f ms", value / 1e6);
+        }
+        return Printf(L"%.2f s", value / 1e9);
+    }
+
+    std::wstring MetricsReport::FormatBytes(uint64_t bytes) {
+        if (bytes < 1024) {
+            return std::to_wstring(bytes) + L" B";
+        }
+        double value = static_cast<double>(bytes);
+        if (bytes < 1024 * 1024) {
+            return Printf(L"%.1f KB", value / 1024);
+        }
+        if (bytes < 1024ull * 1024 * 1024) {
+            return Printf(L"%.1f MB", value / (1024 * 1024));
+        }
+        return Printf(L"%.2f GB", value / (1024.0 * 1024 * 1024));
+    }
+}
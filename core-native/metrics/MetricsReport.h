@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Metrics.h"
+
+namespace Lumos {
+    struct HistogramSummary {
+        std::string name;
+        uint64_t count;
+        uint64_t mean;  // Nanoseconds, as are the rest
+        uint64_t p50;
+        uint64_t p95;
+        uint64_t p99;
+        uint64_t max;
+    };
+
+    struct GaugeValue {
+        std::string name;
+        MetricUnit unit;
+        uint64_t value;
+    };
+
+    struct MetricsSnapshot {
+        uint64_t processId = 0;
+        uint64_t startedAt = 0;  // Unix milliseconds
+        uint64_t sampledAt = 0;
+        std::vector<HistogramSummary> histograms;  // Named ones only, empty or not
+        std::vector<GaugeValue> gauges;
+    };
+
+    // Reads a metrics section, this process's or another's, into
+    // percentiles and text for the tray and the dump tool
+    class MetricsReport {
+    public:
+        // False if the section was written by a build with another layout
+        static bool Capture(const MetricsSection& section, MetricsSnapshot& out);
+
+        // Map the section another process published under `name` (its OS
+        // name, as in LUMOS_METRICS) and capture it
+        static bool CaptureSection(std::string_view name, MetricsSnapshot& out, std::wstring& error);
+
+        // The value at quantile `q` (0..1), placed mid-bucket and capped at
+        // the largest value seen. 0 when nothing was recorded.
+        static uint64_t Percentile(const uint64_t (&buckets)[MetricsLayout::BUCKETS], uint64_t count, uint64_t max,
+                                   double q);
+
+        // Aligned for a console; `now` in Unix milliseconds
+        static std::wstring Format(const MetricsSnapshot& snapshot, uint64_t now);
+
+        static std::wstring FormatDuration(uint64_t nanoseconds);
+        static std::wstring FormatBytes(uint64_t bytes);
+    };
+}
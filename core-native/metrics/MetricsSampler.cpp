@@ -0,0 +1,53 @@
+#include "MetricsSampler.h"
+#include "Metrics.h"
+
+namespace Lumos {
+    MetricsSampler::MetricsSampler()
+        : m_stopping(false)
+    {
+    }
+
+    MetricsSampler::~MetricsSampler() {
+        Stop();
+    }
+
+    void MetricsSampler::Add(Sampler sampler) {
+        m_samplers.push_back(std::move(sampler));
+    }
+
+    void MetricsSampler::Start() {
+        if (m_thread.joinable()) {
+            return;
+        }
+        m_stopping = false;
+        SampleAll();  // Readers see gauges from the start
+        m_thread = std::thread(&MetricsSampler::Loop, this);
+    }
+
+    void MetricsSampler::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void MetricsSampler::Loop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_wake.wait_for(lock, INTERVAL, [this] { return m_stopping; })) {
+            lock.unlock();
+            SampleAll();
+            lock.lock();
+        }
+    }
+
+    void MetricsSampler::SampleAll() {
+        for (const auto& sampler : m_samplers) {
+            sampler();
+        }
+        Metrics::StampSample();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Lumos {
+    // Refreshes the metrics gauges on a background thread: memory per pool,
+    // cache hit rates and the like, read from objects that keep their own
+    // totals. Samplers call Metrics::SetGauge or flush small buffers and
+    // must not block for long.
+    class MetricsSampler {
+    public:
+        using Sampler = std::function<void()>;
+
+        MetricsSampler();
+        ~MetricsSampler();
+
+        MetricsSampler(const MetricsSampler&) = delete;
+        MetricsSampler& operator=(const MetricsSampler&) = delete;
+
+        // Before Start()
+        void Add(Sampler sampler);
+
+        void Start();
+        void Stop();
+
+        static constexpr auto INTERVAL = std::chrono::seconds(1);
+
+    private:
+        void Loop();
+        void SampleAll();
+
+        std::vector<Sampler> m_samplers;
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping;
+    };
+}
@@ -0,0 +1,794 @@
+#include "PreviewPipeline.h"
+#include <future>
+#include <iostream>
+#include "../common/Utf8.h"
+#include "../explorer/SelectionSource.h"
+#include "../memory/RequestArena.h"
+#include "../metrics/Metrics.h"
+#include "../engines/image/ImageHeaderProbe.h"
+#include "../engines/image/EmbeddedPreview.h"
+#include "../engines/font/FontSpecimen.h"
+#include "../engines/font/GlyphCache.h"
+#include "../engines/font/OpenTypeFont.h"
+#include "../engines/hash/FileHasher.h"
+#include "../engines/markdown/MarkdownParser.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../engines/text/LogTail.h"
+#include "../io/FileSource.h"
+#include "../plugins/ProviderSession.h"
+#include "../worker/DecoderJobs.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    namespace {
+        // Lower-case hex of `length` bytes, most significant first
+        void AppendHex(std::pmr::string& out, const uint8_t* bytes, size_t length) {
+            static const char HEX[] = "0123456789abcdef";
+            for (size_t i = 0; i < length; ++i) {
+                out.push_back(HEX[bytes[i] >> 4]);
+                out.push_back(HEX[bytes[i] & 0xF]);
+            }
+        }
+
+        // Integers the way xxhsum and crc tools print them: big-endian
+        void AppendHex(std::pmr::string& out, uint64_t value, size_t bytes) {
+            uint8_t bigEndian[8];
+            for (size_t i = 0; i < bytes; ++i) {
+                bigEndian[i] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - i)));
+            }
+            AppendHex(out, bigEndian, bytes);
+        }
+
+        // What a decoder job needs to know of the selected file
+        DecoderFile ForDecoder(const FileInfo& file) {
+            DecoderFile decoded;
+            decoded.path = file.path;
+            decoded.extension = file.extension;
+            decoded.size = file.size;
+            decoded.modifiedTime = file.modifiedTime;
+            return decoded;
+        }
+
+        // "<PID>-<start time in microseconds since 1970>"
+        std::string NewSession() {
+#ifdef _WIN32
+            uint64_t process = GetCurrentProcessId();
+#else
+            uint64_t process = static_cast<uint64_t>(getpid());
+#endif
+            auto started = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            return std::to_string(process) + "-" + std::to_string(started);
+        }
+    }
+
+    PreviewPipeline::PreviewPipeline(IOScheduler& ioScheduler, PreviewSink& sink, SelectionFactory selection,
+                                     PreviewCache& previewCache, MemoryGovernor& memoryGovernor,
+                                     ChangeMonitor& changeMonitor, WorkerPool& workers,
+                                     const ProviderRegistry& providers, DecoderPool& decoders)
+        : m_ioScheduler(ioScheduler)
+        , m_sink(sink)
+        , m_selectionFactory(std::move(selection))
+        , m_previewCache(previewCache)
+        , m_changeMonitor(changeMonitor)
+        , m_providers(providers)
+        , m_decoders(decoders)
+        , m_session(NewSession())
+        , m_fileHasher(std::make_unique<FileHasher>(workers))
+        , m_stopping(false)
+        , m_latestGeneration(0)
+        , m_processedGeneration(0)
+        , m_tailFailed(false)
+        , m_lastSentGeneration(0)
+        , m_glyphCache(std::make_unique<GlyphCache>(memoryGovernor))
+        , m_markdownParser(std::make_unique<MarkdownParser>(std::string_view()))
+        , m_submitted(0)
+        , m_completed(0)
+        , m_superseded(0)
+        , m_coalesced(0)
+    {
+    }
+
+    PreviewPipeline::~PreviewPipeline() {
+        Stop();
+    }
+
+    bool PreviewPipeline::Start() {
+        if (m_thread.joinable()) {
+            return true;
+        }
+
+        std::promise<bool> started;
+        auto result = started.get_future();
+        m_thread = std::thread(&PreviewPipeline::WorkerLoop, this, &started);
+
+        if (!result.get()) {
+            m_thread.join();
+            return false;
+        }
+        return true;
+    }
+
+    void PreviewPipeline::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ioScheduler.BeginSelection(); // Unblock anything waiting on I/O
+        m_wake.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void PreviewPipeline::Submit() {
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_latestGeneration > m_processedGeneration) {
+                // The previous press never left the queue
+                m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+            ++m_latestGeneration;
+            m_latestPressedAt = std::chrono::steady_clock::now();
+
+            // Cancels every probe, read and engine still tagged with the old token
+            m_latestCancellation = m_ioScheduler.BeginSelection();
+        }
+        m_wake.notify_one();
+    }
+
+    PreviewPipeline::Stats PreviewPipeline::GetStats() const {
+        return {
+            m_submitted.load(std::memory_order_relaxed),
+            m_completed.load(std::memory_order_relaxed),
+            m_superseded.load(std::memory_order_relaxed),
+            m_coalesced.load(std::memory_order_relaxed)
+        };
+    }
+
+    void PreviewPipeline::WorkerLoop(std::promise<bool>* started) {
+        std::unique_ptr<SelectionSource> selection = m_selectionFactory(m_ioScheduler);
+        if (!selection || !selection->Initialize()) {
+            started->set_value(false);
+            return;
+        }
+        started->set_value(true);
+
+        // Transient memory for one preview request, released wholesale per keypress
+        RequestArena arena;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this] {
+                return m_stopping || m_latestGeneration > m_processedGeneration || !m_queuedTails.empty();
+            });
+            if (m_stopping) {
+                lock.unlock();
+                m_logTail.reset();
+                m_fontSurface.Close();
+                return;
+            }
+
+            // Tail updates go out from here too, so the sink only ever sees
+            // this thread
+            if (m_latestGeneration == m_processedGeneration) {
+                uint64_t generation = m_processedGeneration;
+                std::deque<QueuedTail> tails;
+                tails.swap(m_queuedTails);
+                lock.unlock();
+
+                bool sent = true;
+                for (auto& queued : tails) {
+                    queued.tail.text = queued.text;
+                    if (!m_sink.SendTail(generation, queued.tail)) {
+                        sent = false;
+                        break;
+                    }
+                }
+
+                lock.lock();
+                m_tailFailed = m_tailFailed || !sent;
+                continue;
+            }
+
+            // Always jump straight to the newest press
+            uint64_t generation = m_latestGeneration;
+            CancellationToken cancellation = m_latestCancellation;
+            m_pressedAt = m_latestPressedAt;
+            m_processedGeneration = generation;
+            m_queuedTails.clear();
+            m_tailFailed = false;
+            lock.unlock();
+
+            Process(generation, cancellation, *selection, arena);
+
+            lock.lock();
+        }
+    }
+
+    void PreviewPipeline::Process(uint64_t generation, const CancellationToken& cancellation,
+                                  SelectionSource& selection, RequestArena& arena) {
+        std::wcout << L"Spacebar pressed - checking for selected file..." << std::endl;
+        arena.Reset();
+
+        // The UI may still be rendering the previous request; let it stop now
+        // rather than when this one arrives
+        if (m_lastSentGeneration != 0 && m_lastSentGeneration < generation) {
+            m_sink.SendCancel(m_lastSentGeneration, arena.Resource());
+        }
+
+        // Whatever is on screen is about to be replaced; stop following it
+        // and release its specimen
+        m_logTail.reset();
+        m_fontSurface.Close();
+
+        // Get selected file
+        auto resolveStart = std::chrono::steady_clock::now();
+        auto fileInfo = selection.GetSelectedFile(arena.Resource(), cancellation);
+        if (cancellation.IsCancellationRequested()) {
+            m_superseded.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Metrics::Record(Histogram::SelectionResolve, std::chrono::steady_clock::now() - resolveStart);
+
+        if (fileInfo.has_value()) {
+            std::wcout << L"Selected file: " << fileInfo->path << std::endl;
+            std::wcout << L"Extension: " << fileInfo->extension << std::endl;
+            std::wcout << L"Size: " << fileInfo->size << L" bytes" << std::endl;
+
+            // Whatever gets cached for this file is dropped as soon as it changes
+            m_changeMonitor.WatchDirectoryOf(fileInfo->path);
+
+            // Create preview request
+            PreviewRequest request(arena.Resource());
+            request.generation = generation;
+            request.session = m_session;
+            request.path = fileInfo->path;
+            request.extension = fileInfo->extension;
+            request.size = fileInfo->size;
+
+            // Dimensions travel with the request so the window can open at
+            // its final size before the UI has decoded a single pixel
+            if (ImageHeaderProbe::HandlesExtension(fileInfo->extension)) {
+                ImageHeader header;
+                if (ProbeImage(*fileInfo, cancellation, header)) {
+                    PreviewImageInfo& image = request.image.emplace();
+                    image.width = header.width;
+                    image.height = header.height;
+                    image.orientation = header.orientation;
+                    image.bitDepth = header.bitDepth;
+                    image.frameCount = header.frameCount;
+                    image.hasColorProfile = header.hasColorProfile;
+                }
+            }
+
+            // Camera files carry a ready-made preview JPEG. Use it for RAW
+            // (often the only thing the UI can decode) and for images much
+            // larger than the window.
+            bool isRaw = EmbeddedPreviewFinder::IsRawExtension(fileInfo->extension);
+            bool isLarge = request.image &&
+                (request.image->width > PREVIEW_TARGET_EDGE || request.image->height > PREVIEW_TARGET_EDGE);
+            if (EmbeddedPreviewFinder::HandlesExtension(fileInfo->extension) && (isRaw || isLarge) &&
+                !cancellation.IsCancellationRequested()) {
+                EmbeddedPreview preview;
+                if (FindEmbeddedPreview(*fileInfo, isRaw, cancellation, preview)) {
+                    PreviewEmbeddedImage& embedded = request.embeddedPreview.emplace();
+                    embedded.offset = preview.offset;
+                    embedded.length = preview.length;
+                    embedded.width = preview.width;
+                    embedded.height = preview.height;
+                    if (!request.image) {
+                        PreviewImageInfo& image = request.image.emplace();
+                        image.width = preview.width;
+                        image.height = preview.height;
+                        image.orientation = preview.orientation;
+                        image.bitDepth = 24;
+                    }
+                }
+            }
+
+            if (cancellation.IsCancellationRequested()) {
+                m_superseded.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            // Built-in engines and native providers by extension; files whose
+            // extension nobody claims by their first bytes
+            ProviderMatch match = m_providers.Resolve(fileInfo->extension);
+            if (!match && !request.image && fileInfo->size > 0) {
+                match = SniffProvider(*fileInfo, cancellation);
+                if (cancellation.IsCancellationRequested()) {
+                    m_superseded.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            // Send to UI process
+            bool sent;
+            switch (match.builtin) {
+            case BuiltinPreview::Markdown:
+                sent = SendMarkdownPreview(request, *fileInfo, cancellation, arena);
+                break;
+            case BuiltinPreview::Log:
+                sent = SendLogPreview(request, arena);
+                break;
+            case BuiltinPreview::Hashes:
+                sent = SendHashPreview(request, *fileInfo, cancellation, arena);
+                break;
+            case BuiltinPreview::Database:
+                sent = SendDatabasePreview(request, *fileInfo, cancellation, arena);
+                break;
+            case BuiltinPreview::Font:
+                sent = SendFontPreview(request, *fileInfo, cancellation, arena);
+                break;
+            default:
+                sent = match.provider ? SendProviderPreview(request, *fileInfo, *match.provider, cancellation, arena)
+                                      : SendRequest(request, arena);
+                break;
+            }
+            if (sent) {
+                m_lastSentGeneration = generation;
+                std::wcout << L"Preview request sent successfully" << std::endl;
+            } else {
+                std::wcerr << L"Failed to send preview request" << std::endl;
+            }
+        } else {
+            std::wcout << L"No file selected or folder selected" << std::endl;
+        }
+
+        m_completed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool PreviewPipeline::SendRequest(const PreviewRequest& request, RequestArena& arena) {
+        if (!m_sink.SendPreviewRequest(request, arena.Resource())) {
+            return false;
+        }
+        Metrics::Record(Histogram::HookToSend, std::chrono::steady_clock::now() - m_pressedAt);
+        return true;
+    }
+
+    bool PreviewPipeline::ProbeImage(const FileInfo& file, const CancellationToken& cancellation,
+                                     ImageHeader& header) {
+        if (file.modifiedTime != 0) {
+            if (auto cached = m_previewCache.Get<ImageHeader>(CacheKind::ImageHeader, file.path,
+                                                              file.size, file.modifiedTime)) {
+                header = *cached;
+                return true;
+            }
+        }
+
+        IOResult& result = m_probeRead;
+        size_t probeBytes = ImageHeaderProbe::DEFAULT_PROBE_BYTES;
+        while (true) {
+            m_ioScheduler.Read(file.path, 0, probeBytes, PROBE_BUDGET_MS, result,
+                               IOPriority::Interactive, cancellation);
+            if (result.status != IOStatus::Complete && result.status != IOStatus::Partial) {
+                return false;
+            }
+
+            // Header parsers see untrusted bytes first: probe in a decoder
+            // worker, routed by path so repeat probes find it warm
+            ProbeStatus status = DecoderJobs::ProbeImage(m_decoders, ByteView(result.data.data(), result.data.size()),
+                                                         std::hash<std::wstring_view>()(file.path), cancellation, header);
+
+            // JPEGs with oversized APPn segments: one wider read, never the whole file
+            if (status == ProbeStatus::NeedMoreData && result.status == IOStatus::Complete &&
+                result.data.size() == probeBytes && probeBytes < ImageHeaderProbe::MAX_PROBE_BYTES) {
+                probeBytes = ImageHeaderProbe::MAX_PROBE_BYTES;
+                continue;
+            }
+            if (status != ProbeStatus::Ok) {
+                return false;
+            }
+
+            // Only what the cache keeps goes to the heap
+            if (result.stat.modifiedTime != 0) {
+                m_previewCache.Put<ImageHeader>(CacheKind::ImageHeader, file.path, result.stat.size,
+                                                result.stat.modifiedTime, std::make_shared<ImageHeader>(header),
+                                                sizeof(ImageHeader));
+            }
+            return true;
+        }
+    }
+
+    ProviderMatch PreviewPipeline::SniffProvider(const FileInfo& file, const CancellationToken& cancellation) {
+        IOResult& result = m_probeRead;
+        m_ioScheduler.Read(file.path, 0, m_providers.SniffBytes(), PROBE_BUDGET_MS, result,
+                           IOPriority::Interactive, cancellation);
+        if (result.status != IOStatus::Complete && result.status != IOStatus::Partial) {
+            return {};
+        }
+        return m_providers.Sniff(ByteView(result.data.data(), result.data.size()));
+    }
+
+    bool PreviewPipeline::OpenSource(const FileInfo& file, MapAccess access, uint64_t readLimit,
+                                     const CancellationToken& cancellation, FileSource& source) {
+        std::optional<uint64_t> expectedSize;
+        if (file.modifiedTime != 0) {
+            expectedSize = file.size;
+        }
+        return source.Open(m_ioScheduler, file.path, expectedSize, access, readLimit, READ_SOURCE_BUDGET_MS,
+                           cancellation);
+    }
+
+    bool PreviewPipeline::FindEmbeddedPreview(const FileInfo& file, bool isRaw, const CancellationToken& cancellation,
+                                              EmbeddedPreview& preview) {
+        // Files without one are cached too, as an empty preview
+        if (file.modifiedTime != 0) {
+            if (auto cached = m_previewCache.Get<EmbeddedPreview>(CacheKind::EmbeddedPreview, file.path,
+                                                                  file.size, file.modifiedTime)) {
+                preview = *cached;
+                return preview.length != 0;
+            }
+        }
+
+        // IFD chains and maker notes are as hostile as any header: walk them
+        // in a decoder worker, or in-process if the pool has none to offer
+        uint32_t minimumEdge = isRaw ? 0 : PREVIEW_TARGET_EDGE;
+        DecoderStatus ran = DecoderJobs::FindEmbeddedPreview(m_decoders, ForDecoder(file), PREVIEW_TARGET_EDGE,
+                                                             minimumEdge, cancellation, preview);
+        if (ran == DecoderStatus::Unavailable) {
+            // Only the IFD and segment pages are touched, never the image data
+            FileSource source;
+            if (!OpenSource(file, MapAccess::Random, READ_SOURCE_LIMIT, cancellation, source)) {
+                return false;
+            }
+            preview = EmbeddedPreviewFinder::Find(source.View(), PREVIEW_TARGET_EDGE, minimumEdge)
+                          .value_or(EmbeddedPreview());
+            ran = DecoderStatus::Ok;
+        }
+
+        // A file that crashed its worker would crash the next one too; one
+        // that timed out may only have been slow to read
+        if (file.modifiedTime != 0 && (ran == DecoderStatus::Ok || ran == DecoderStatus::Crashed) &&
+            !cancellation.IsCancellationRequested()) {
+            m_previewCache.Put<EmbeddedPreview>(CacheKind::EmbeddedPreview, file.path, file.size,
+                                                file.modifiedTime, std::make_shared<EmbeddedPreview>(preview),
+                                                sizeof(EmbeddedPreview));
+        }
+        return preview.length != 0;
+    }
+
+    bool PreviewPipeline::SendMarkdownPreview(PreviewRequest& request, const FileInfo& file,
+                                              const CancellationToken& cancellation, RequestArena& arena) {
+        // The first chunk rides on the request; later ones reuse one heap
+        // buffer rather than growing the arena
+        std::pmr::string blocks(arena.Resource());
+        std::pmr::string chunkJson;
+        bool first = true;
+        bool sent = false;
+        uint32_t firstBlock = 0;
+        auto onChunk = [&](const MarkdownDocument& document, bool complete, bool truncated) {
+            if (first) {
+                first = false;
+                document.WriteJson(blocks);
+                PreviewMarkdown& markdown = request.markdown.emplace();
+                markdown.complete = complete;
+                markdown.truncated = truncated;
+                markdown.blocksJson = blocks;
+                sent = SendRequest(request, arena);
+                firstBlock = static_cast<uint32_t>(document.blocks.size());
+                return sent;
+            }
+
+            chunkJson.clear();
+            document.WriteJson(chunkJson);
+            PreviewMarkdown chunk;
+            chunk.firstBlock = firstBlock;
+            chunk.complete = complete;
+            chunk.truncated = truncated;
+            chunk.blocksJson = chunkJson;
+            if (!m_sink.SendMarkdown(request.generation, chunk)) {
+                std::wcerr << L"Failed to send Markdown chunk at block " << firstBlock << std::endl;
+                return false;
+            }
+            firstBlock += static_cast<uint32_t>(document.blocks.size());
+            return true;
+        };
+
+        MarkdownDocument chunk(arena.Resource());
+        if (DecoderJobs::ParseMarkdown(m_decoders, ForDecoder(file), cancellation, chunk, onChunk) ==
+            DecoderStatus::Unavailable) {
+            FileSource source;
+            if (OpenSource(file, MapAccess::Sequential, DecoderJobs::MARKDOWN_MAX_BYTES, cancellation, source)) {
+                ByteView view = source.View();
+                size_t length = static_cast<size_t>(std::min<uint64_t>(view.Size(), DecoderJobs::MARKDOWN_MAX_BYTES));
+                std::string_view text(reinterpret_cast<const char*>(view.Data()), length);
+                // Past MARKDOWN_MAX_BYTES, or a read that ran out of time
+                bool tooLarge = length < source.Size();
+                DecoderJobs::StreamMarkdown(*m_markdownParser, text, tooLarge, cancellation, chunk, onChunk);
+            }
+        }
+
+        // Unreadable, or its worker was lost before the first chunk: the UI
+        // shows the source
+        if (first) {
+            return cancellation.IsCancellationRequested() || SendRequest(request, arena);
+        }
+        return sent;
+    }
+
+    bool PreviewPipeline::SendLogPreview(PreviewRequest& request, RequestArena& arena) {
+        uint64_t generation = request.generation;
+        auto tail = std::make_unique<LogTail>(std::wstring(request.path), [this, generation](const LogTailUpdate& update) {
+            return QueueTail(generation, update);
+        });
+
+        std::string window;
+        if (!tail->Open(LOG_INITIAL_LINES, window)) {
+            return SendRequest(request, arena);
+        }
+
+        PreviewTail& first = request.tail.emplace();
+        first.fileSize = request.size;
+        first.text = window;
+        if (!SendRequest(request, arena)) {
+            return false;
+        }
+
+        // Updates only start once the UI has the window they continue
+        tail->Follow();
+        m_logTail = std::move(tail);
+        return true;
+    }
+
+    bool PreviewPipeline::QueueTail(uint64_t generation, const LogTailUpdate& update) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping || m_tailFailed || generation != m_processedGeneration) {
+                return false;
+            }
+            QueuedTail& queued = m_queuedTails.emplace_back();
+            queued.tail.truncated = update.truncated;
+            queued.tail.rotated = update.rotated;
+            queued.tail.fileSize = update.fileSize;
+            queued.tail.totalLines = update.totalLines;
+            queued.tail.skippedLines = update.skippedLines;
+            queued.text = update.text;
+        }
+        m_wake.notify_one();
+        return true;
+    }
+
+    bool PreviewPipeline::SendHashPreview(PreviewRequest& request, const FileInfo& file,
+                                          const CancellationToken& cancellation, RequestArena& arena) {
+        std::pmr::string xxh3(arena.Resource());
+        std::pmr::string crc32c(arena.Resource());
+        std::pmr::string sha1(arena.Resource());
+        std::pmr::string sha256(arena.Resource());
+        auto setDigests = [&](PreviewHashes& message, const FileHashes& hashes) {
+            AppendHex(xxh3, hashes.xxh3, sizeof(hashes.xxh3));
+            AppendHex(crc32c, hashes.crc32c, sizeof(hashes.crc32c));
+            AppendHex(sha1, hashes.sha1, sizeof(hashes.sha1));
+            AppendHex(sha256, hashes.sha256, sizeof(hashes.sha256));
+            message.hashedBytes = message.totalBytes;
+            message.complete = true;
+            message.xxh3 = xxh3;
+            message.crc32c = crc32c;
+            message.sha1 = sha1;
+            message.sha256 = sha256;
+        };
+
+        if (file.modifiedTime != 0) {
+            if (auto cached = m_previewCache.Get<FileHashes>(CacheKind::FileHashes, file.path,
+                                                             file.size, file.modifiedTime)) {
+                PreviewHashes& hashes = request.hashes.emplace();
+                hashes.totalBytes = file.size;
+                setDigests(hashes, *cached);
+                return SendRequest(request, arena);
+            }
+        }
+
+        // Without a size the UI says the checksums are unavailable
+        std::optional<FileStat> stat = m_ioScheduler.Stat(request.path, PROBE_BUDGET_MS, IOPriority::Interactive,
+                                                          cancellation);
+        if (!stat || !stat->exists || stat->isDirectory) {
+            return SendRequest(request, arena);
+        }
+
+        PreviewHashes& first = request.hashes.emplace();
+        first.totalBytes = stat->size;
+        if (!SendRequest(request, arena)) {
+            return false;
+        }
+
+        // Read through the scheduler rather than mapped: a share dropping or
+        // a writer truncating the file mid-hash must not fault this process
+        uint64_t generation = request.generation;
+        auto start = std::chrono::steady_clock::now();
+        auto computed = m_fileHasher->Hash(m_ioScheduler, request.path, stat->size, cancellation,
+                                           [&](uint64_t hashedBytes, uint64_t totalBytes) {
+            PreviewHashes progress;
+            progress.hashedBytes = hashedBytes;
+            progress.totalBytes = totalBytes;
+            m_sink.SendHashes(generation, progress);
+        });
+        if (!computed) {
+            if (!cancellation.IsCancellationRequested()) {
+                std::wcerr << L"Could not read " << request.path << L" to the end for checksums" << std::endl;
+            }
+            return true;  // Superseded, or unreadable: the progress stops where it was
+        }
+
+        Metrics::Record(Histogram::HashFile, std::chrono::steady_clock::now() - start);
+
+        // Cached under the selection's stamp only if that is what was hashed
+        auto hashes = std::make_shared<FileHashes>(*computed);
+        if (file.modifiedTime != 0 && stat->modifiedTime == file.modifiedTime && stat->size == file.size) {
+            m_previewCache.Put<FileHashes>(CacheKind::FileHashes, file.path, file.size, file.modifiedTime,
+                                           hashes, sizeof(FileHashes));
+        }
+
+        PreviewHashes digests;
+        digests.totalBytes = stat->size;
+        setDigests(digests, *hashes);
+        if (!m_sink.SendHashes(generation, digests, arena.Resource())) {
+            std::wcerr << L"Failed to send checksums" << std::endl;
+        }
+        return true;
+    }
+
+    bool PreviewPipeline::SendDatabasePreview(PreviewRequest& request, const FileInfo& file,
+                                              const CancellationToken& cancellation, RequestArena& arena) {
+        // The schema rides on the request; each table's rows follow in a
+        // message of their own, reusing one heap buffer
+        std::pmr::string schemaJson(arena.Resource());
+        std::pmr::string tableJson;
+        bool first = true;
+        bool sent = false;
+        size_t table = 0;
+        auto onSchema = [&](const SqliteSchema& schema, size_t tableCount) {
+            first = false;
+            schema.WriteJson(schemaJson);
+            PreviewDatabase& database = request.database.emplace();
+            database.complete = tableCount == 0;
+            database.schemaJson = schemaJson;
+            sent = SendRequest(request, arena);
+            return sent;
+        };
+        auto onTable = [&](const SqliteRows* rows, bool last) {
+            tableJson.clear();
+            if (rows) {
+                rows->WriteJson(tableJson);
+            }
+            PreviewDatabase chunk;
+            chunk.complete = last;
+            chunk.tableJson = tableJson;
+            if (!m_sink.SendDatabase(request.generation, chunk)) {
+                std::wcerr << L"Failed to send rows of table " << table << std::endl;
+                return false;
+            }
+            ++table;
+            return true;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        if (DecoderJobs::ReadDatabase(m_decoders, ForDecoder(file), cancellation, onSchema, onTable) ==
+            DecoderStatus::Unavailable) {
+            // Only the schema and first leaf pages are touched; read-ahead
+            // would fetch pages of a multi-GB file nobody asked for
+            FileSource source;
+            if (OpenSource(file, MapAccess::Random, READ_SOURCE_LIMIT, cancellation, source)) {
+                SqliteFile database(source.View());
+                if (database.IsValid()) {
+                    DecoderJobs::StreamDatabase(database, cancellation, onSchema, onTable);
+                }
+            }
+        }
+
+        // Not SQLite after all (Thumbs.db), unreadable, or its worker was
+        // lost before the schema: a plain request
+        if (first) {
+            return cancellation.IsCancellationRequested() || SendRequest(request, arena);
+        }
+        Metrics::Record(Histogram::DatabaseRead, std::chrono::steady_clock::now() - start);
+        return sent;
+    }
+
+    bool PreviewPipeline::SendFontPreview(PreviewRequest& request, const FileInfo& file,
+                                          const CancellationToken& cancellation, RequestArena& arena) {
+        // The specimen is drawn straight into the section the UI maps, sized
+        // for the tallest one; pages below a shorter specimen are never touched
+        std::string name = SharedMemory::UniqueName("Lumos.Font", request.generation);
+        if (!m_fontSurface.Create(name, FontSpecimen::MAX_BYTES)) {
+            std::wcerr << L"Could not create the font specimen surface" << std::endl;
+        }
+
+        // The glyf reader and the CFF charstring interpreter run in a decoder
+        // worker, or in-process if the pool has none to offer
+        DecoderFile decoded = ForDecoder(file);
+        FontSummary font;
+        auto start = std::chrono::steady_clock::now();
+        if (DecoderJobs::DrawFont(m_decoders, decoded, m_fontSurface, cancellation, font) ==
+            DecoderStatus::Unavailable) {
+            // Tables are scattered and glyphs are read one by one
+            FileSource source;
+            if (OpenSource(file, MapAccess::Random, READ_SOURCE_LIMIT, cancellation, source)) {
+                // Pressing on the same font again reuses its glyphs
+                DecoderJobs::DrawSpecimen(source.View(), DecoderJobs::FontKey(decoded), *m_glyphCache,
+                                          m_fontSurface.Data(), m_fontSurface.Size(), font);
+            }
+        }
+        if (!font.valid) {
+            m_fontSurface.Close();
+            return SendRequest(request, arena);
+        }
+
+        PreviewFont& preview = request.font.emplace();
+        preview.family = font.names.family;
+        preview.subfamily = font.names.subfamily;
+        preview.fullName = font.names.fullName;
+        preview.version = font.names.version;
+        preview.format = font.format == FontOutlineFormat::TrueType ? "TrueType"
+                       : font.format == FontOutlineFormat::Cff ? "CFF" : "";
+        preview.faceCount = font.faceCount;
+        preview.glyphCount = font.glyphCount;
+        preview.unitsPerEm = font.unitsPerEm;
+        if (font.height != 0) {
+            preview.surfaceName = m_fontSurface.Name();
+            preview.width = FontSpecimen::WIDTH;
+            preview.height = font.height;
+            preview.stride = FontSpecimen::WIDTH * 4;
+            Metrics::Record(Histogram::FontSpecimen, std::chrono::steady_clock::now() - start);
+        } else {
+            m_fontSurface.Close();
+        }
+        return SendRequest(request, arena);
+    }
+
+    bool PreviewPipeline::SendProviderPreview(PreviewRequest& request, const FileInfo& file,
+                                              const NativeProvider& provider, const CancellationToken& cancellation,
+                                              RequestArena& arena) {
+        // The first batch rides on the preview message; a streaming
+        // provider's later batches follow as Provider messages
+        bool sent = false;
+        auto onBatch = [&](const ProviderBatch& batch) {
+            PreviewProvider rows;
+            rows.name = provider.name;
+            rows.firstRow = batch.firstRow;
+            rows.complete = batch.complete;
+            rows.failed = batch.failed;
+            rows.truncated = batch.truncated;
+            rows.rowsJson = batch.rowsJson;
+            if (!sent) {
+                request.provider = rows;
+                sent = SendRequest(request, arena);
+                return sent;
+            }
+            return m_sink.SendProvider(request.generation, rows);
+        };
+
+        LumosPreviewResult result;
+        auto start = std::chrono::steady_clock::now();
+        if (!provider.library.empty()) {
+            // Third-party code parsing untrusted files: a crash or hang costs
+            // a worker, not the preview host
+            size_t rowCount = 0;
+            size_t batchCount = 0;
+            result = DecoderJobs::RunProvider(m_decoders, provider, ForDecoder(file), cancellation, onBatch, rowCount,
+                                              batchCount);
+        } else {
+            FileSource source;
+            MapAccess access = provider.costClass == LUMOS_COST_FULL ? MapAccess::Sequential : MapAccess::Random;
+            if (!OpenSource(file, access, READ_SOURCE_LIMIT, cancellation, source)) {
+                return SendRequest(request, arena);
+            }
+            ProviderSession session(provider, cancellation, onBatch);
+            result = session.Run(source.View(), request.path, request.extension);
+        }
+
+        Metrics::Record(Histogram::ProviderPreview, std::chrono::steady_clock::now() - start);
+
+        if (result == LUMOS_PREVIEW_UNSUPPORTED) {
+            return SendRequest(request, arena);
+        }
+        // Superseded before anything went out: the next press sends its own
+        return sent || result == LUMOS_PREVIEW_CANCELLED;
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "../common/CancellationToken.h"
+#include "../common/WorkerPool.h"
+#include "../io/IOScheduler.h"
+#include "../ipc/PreviewSink.h"
+#include "../ipc/SharedMemory.h"
+#include "../cache/ChangeMonitor.h"
+#include "../cache/PreviewCache.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../worker/DecoderPool.h"
+
+namespace Lumos {
+    class FileHasher;
+    class GlyphCache;
+    class LogTail;
+    class MarkdownParser;
+    struct LogTailUpdate;
+    class RequestArena;
+    class SelectionSource;
+    struct FileInfo;
+    struct ImageHeader;
+    class FileSource;
+    enum class MapAccess;
+    struct EmbeddedPreview;
+
+    // Turns Spacebar presses into preview requests on a dedicated worker
+    // thread. Each press gets a new generation; a newer press cancels every
+    // stage still running for the older one (selection probes, I/O, engines)
+    // and tells the UI to drop it. The hook itself only bumps a counter.
+    class PreviewPipeline {
+    public:
+        struct Stats {
+            uint64_t submitted;
+            uint64_t completed;
+            uint64_t superseded;  // Abandoned part-way because a newer press arrived
+            uint64_t coalesced;   // Never started: replaced while still queued
+        };
+
+        // Creates the selection source on the worker thread
+        using SelectionFactory = std::function<std::unique_ptr<SelectionSource>(IOScheduler&)>;
+
+        PreviewPipeline(IOScheduler& ioScheduler, PreviewSink& sink, SelectionFactory selection,
+                        PreviewCache& previewCache, MemoryGovernor& memoryGovernor, ChangeMonitor& changeMonitor,
+                        WorkerPool& workers, const ProviderRegistry& providers, DecoderPool& decoders);
+        ~PreviewPipeline();
+
+        PreviewPipeline(const PreviewPipeline&) = delete;
+        PreviewPipeline& operator=(const PreviewPipeline&) = delete;
+
+        // Start the worker and create the selection source on it (Explorer's
+        // COM objects must live on the thread that uses them)
+        bool Start();
+        void Stop();
+
+        // Called from the keyboard hook; never blocks on pipeline work
+        void Submit();
+
+        Stats GetStats() const;
+
+    private:
+        // A log tail update waiting for the worker thread; tail.text is set
+        // to `text` when it is sent
+        struct QueuedTail {
+            PreviewTail tail;
+            std::string text;
+        };
+
+        void WorkerLoop(std::promise<bool>* started);
+        void Process(uint64_t generation, const CancellationToken& cancellation,
+                     SelectionSource& selection, RequestArena& arena);
+
+        // The generation's preview request, timed from its key press
+        bool SendRequest(const PreviewRequest& request, RequestArena& arena);
+
+        // Header probe for image files, served from the preview cache when the
+        // file is unchanged. False if it is not a recognizable image or the
+        // read did not finish within PROBE_BUDGET_MS.
+        bool ProbeImage(const FileInfo& file, const CancellationToken& cancellation, ImageHeader& header);
+
+        // Match the file's first bytes against built-in and provider
+        // signatures. Nothing if the read did not finish within PROBE_BUDGET_MS.
+        ProviderMatch SniffProvider(const FileInfo& file, const CancellationToken& cancellation);
+
+        // The file for an in-process parser (built-in providers, or any
+        // parser when the decoder pool has no worker to offer): mapped if
+        // local and unchanged since the selection's stat, otherwise its
+        // first `readLimit` bytes read within READ_SOURCE_BUDGET_MS
+        bool OpenSource(const FileInfo& file, MapAccess access, uint64_t readLimit,
+                        const CancellationToken& cancellation, FileSource& source);
+
+        // Preview-sized JPEG embedded in a camera JPEG, TIFF or RAW file,
+        // found by a decoder worker. False if there is none worth using.
+        bool FindEmbeddedPreview(const FileInfo& file, bool isRaw, const CancellationToken& cancellation,
+                                 EmbeddedPreview& preview);
+
+        // Send `request` carrying the first Markdown blocks, then stream the
+        // rest in chunks as a decoder worker parses them, until done,
+        // superseded or at DecoderJobs::MARKDOWN_MAX_BLOCKS. Falls back to a
+        // plain request (UI shows the source) if the file cannot be opened.
+        bool SendMarkdownPreview(PreviewRequest& request, const FileInfo& file,
+                                 const CancellationToken& cancellation, RequestArena& arena);
+
+        // Send `request` with the last lines of a log file and keep following
+        // it until the next press. Falls back to a plain request if the file
+        // cannot be opened.
+        bool SendLogPreview(PreviewRequest& request, RequestArena& arena);
+
+        // Called on the tail's thread: copy the update for the worker thread
+        // to send. False once a newer press or a failed send ended the follow.
+        bool QueueTail(uint64_t generation, const LogTailUpdate& update);
+
+        // Send `request` with the file's checksums if cached for this size and
+        // stamp; otherwise send it at once, hash the file while streaming
+        // progress, then send the digests. Superseded presses stop the hash.
+        bool SendHashPreview(PreviewRequest& request, const FileInfo& file, const CancellationToken& cancellation,
+                             RequestArena& arena);
+
+        // Send `request` with a SQLite database's schema, then the first
+        // rows of each table, one message per table, as a decoder worker
+        // reads them, until superseded. Files that are not SQLite
+        // (Thumbs.db) go out as plain requests.
+        bool SendDatabasePreview(PreviewRequest& request, const FileInfo& file,
+                                 const CancellationToken& cancellation, RequestArena& arena);
+
+        // Send `request` with a font's names and a specimen a decoder worker
+        // drew into a shared-memory section that stays open until the next
+        // press. Fonts that cannot be read or drawn go out without a surface.
+        bool SendFontPreview(PreviewRequest& request, const FileInfo& file, const CancellationToken& cancellation,
+                             RequestArena& arena);
+
+        // Send `request` with the rows a native provider emits for the
+        // file; providers loaded from a library run in a decoder
+        // worker. Files it turns down after all go out as plain requests.
+        bool SendProviderPreview(PreviewRequest& request, const FileInfo& file, const NativeProvider& provider,
+                                 const CancellationToken& cancellation, RequestArena& arena);
+
+        static constexpr auto PROBE_BUDGET_MS = std::chrono::milliseconds(150);
+
+        // The window shows images at most half a 4K screen wide; an embedded
+        // preview this large looks the same as decoding the full image
+        static constexpr uint32_t PREVIEW_TARGET_EDGE = 1920;
+
+        // Files read rather than mapped (see FileSource): how much of one the
+        // in-process parsers get, and how long reading it may take
+        static constexpr uint64_t READ_SOURCE_LIMIT = 64ull * 1024 * 1024;
+        static constexpr auto READ_SOURCE_BUDGET_MS = std::chrono::milliseconds(2000);
+
+        // Initial log window; TextRenderer used to show up to 10000 lines
+        static constexpr size_t LOG_INITIAL_LINES = 2000;
+
+        IOScheduler& m_ioScheduler;
+        PreviewSink& m_sink;
+        SelectionFactory m_selectionFactory;
+        PreviewCache& m_previewCache;
+        ChangeMonitor& m_changeMonitor;
+        const ProviderRegistry& m_providers;
+        DecoderPool& m_decoders;
+        const std::string m_session;  // See PreviewRequest::session
+        std::unique_ptr<FileHasher> m_fileHasher;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping;
+        uint64_t m_latestGeneration;
+        uint64_t m_processedGeneration;
+        CancellationToken m_latestCancellation;
+        std::chrono::steady_clock::time_point m_latestPressedAt;
+        std::deque<QueuedTail> m_queuedTails;  // For m_processedGeneration's log
+        bool m_tailFailed;                     // The UI refused an update; stop following
+
+        uint64_t m_lastSentGeneration; // Worker thread only
+        std::chrono::steady_clock::time_point m_pressedAt;  // Worker thread only; the press being processed
+        std::unique_ptr<LogTail> m_logTail; // Worker thread only; follows the log on screen
+        SharedMemory m_fontSurface;         // Worker thread only; the font specimen on screen
+        std::unique_ptr<GlyphCache> m_glyphCache;  // Worker thread only; glyphs of the last font drawn in-process
+        IOResult m_probeRead;               // Worker thread only; probe and sniff reads reuse its buffer
+        std::unique_ptr<MarkdownParser> m_markdownParser;  // Worker thread only; for in-process parses
+
+        std::atomic<uint64_t> m_submitted;
+        std::atomic<uint64_t> m_completed;
+        std::atomic<uint64_t> m_superseded;
+        std::atomic<uint64_t> m_coalesced;
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Stable C ABI for native preview providers: shared libraries (.dll, .so)
+// in the providers folder next to lumos.exe that add formats without a
+// rebuild. A provider exports LumosGetProvider, which returns a static
+// description of what it handles and how to preview it. The host matches
+// files on extension first, then on magic signatures when the extension is
+// unknown, and calls `preview` on its pipeline thread with the whole file
+// mapped read-only. The result is a list of name/value rows the UI shows as
+// a property sheet.
+//
+// Compatibility: structs only ever grow at the end, and each carries its
+// own size. The host rejects providers built against a newer ABI version
+// than its own, and providers never read host structs past `structSize`.
+//
+// Providers run in the host process: a crash there takes the previewer
+// down with it, so they must treat every byte of the file as hostile.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LUMOS_PROVIDER_ABI_VERSION 1u
+
+#if defined(_WIN32)
+#define LUMOS_PROVIDER_EXPORT __declspec(dllexport)
+#else
+#define LUMOS_PROVIDER_EXPORT __attribute__((visibility("default")))
+#endif
+
+// How much of the file a preview touches; the host may skip expensive
+// providers for files on slow or remote volumes
+typedef enum LumosCostClass {
+    LUMOS_COST_HEADER = 0,  // A fixed-size header
+    LUMOS_COST_PARTIAL = 1, // An index or a bounded sample
+    LUMOS_COST_FULL = 2     // Every byte
+} LumosCostClass;
+
+// Rows are forwarded to the UI in batches while `preview` runs, rather
+// than once it returns
+#define LUMOS_PROVIDER_STREAMING 0x1u
+
+// `length` bytes at `offset` identify the format. Signatures up to
+// LUMOS_MAX_SIGNATURE_END bytes into the file are honoured.
+typedef struct LumosSignature {
+    uint32_t offset;
+    uint32_t length;
+    const uint8_t* bytes;
+} LumosSignature;
+
+#define LUMOS_MAX_SIGNATURE_END 512u
+
+// The file being previewed. `data` stays valid until `preview` returns.
+typedef struct LumosPreviewInput {
+    uint32_t structSize;
+    const char* path;      // UTF-8
+    const char* extension; // UTF-8 with its leading dot, as the file is named
+    const uint8_t* data;
+    uint64_t size;
+} LumosPreviewInput;
+
+// Callbacks into the host, valid only during `preview`
+typedef struct LumosHost {
+    uint32_t structSize;
+    void* context;
+
+    // Append a row. Strings are UTF-8 and copied; over-long values are cut.
+    // Returns 0 once the host wants no more rows (superseded, or the row
+    // limit was reached): return from `preview` promptly.
+    int (*emit)(void* context, const char* name, const char* value);
+
+    // Nonzero once a newer preview has replaced this one. Check it between
+    // units of work in long previews.
+    int (*cancelled)(void* context);
+} LumosHost;
+
+typedef enum LumosPreviewResult {
+    LUMOS_PREVIEW_OK = 0,
+    LUMOS_PREVIEW_UNSUPPORTED = 1, // Not this provider's format after all
+    LUMOS_PREVIEW_FAILED = 2,      // Malformed; rows emitted so far are still shown
+    LUMOS_PREVIEW_CANCELLED = 3
+} LumosPreviewResult;
+
+typedef struct LumosProviderInfo {
+    uint32_t abiVersion; // LUMOS_PROVIDER_ABI_VERSION
+    uint32_t structSize; // sizeof(LumosProviderInfo)
+    const char* name;    // Shown in the UI, e.g. "Netpbm images"
+    const char* version;
+
+    // With their leading dot, ASCII, at most 8 characters after it;
+    // matched case-insensitively
+    const char* const* extensions;
+    uint32_t extensionCount;
+
+    const LumosSignature* signatures;
+    uint32_t signatureCount;
+
+    uint32_t costClass;  // LumosCostClass
+    uint32_t flags;      // LUMOS_PROVIDER_*
+
+    // Optional: confirm a signature match from the file's first bytes
+    // (at most LUMOS_MAX_SIGNATURE_END). Nonzero accepts.
+    int (*probe)(const uint8_t* head, size_t length);
+
+    // Returns a LumosPreviewResult
+    int (*preview)(const LumosPreviewInput* input, const LumosHost* host);
+} LumosProviderInfo;
+
+// The one exported entry point. The returned description must stay valid
+// until the library is unloaded.
+typedef const LumosProviderInfo* (*LumosGetProviderFn)(void);
+#define LUMOS_GET_PROVIDER_SYMBOL "LumosGetProvider"
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,170 @@
+#include "ProviderLoader.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "ProviderRegistry.h"
+#include "../common/StringUtil.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include "../common/Utf8.h"
+#endif
+
+namespace Lumos {
+    namespace {
+#ifdef _WIN32
+        constexpr const wchar_t* LIBRARY_EXTENSION = L".dll";
+        constexpr wchar_t SEPARATOR = L'\\';
+
+        void* OpenLibrary(const std::wstring& path, std::wstring& error) {
+            // Dependencies resolve from the provider's own folder, not the
+            // current directory
+            HMODULE module = LoadLibraryExW(path.c_str(), nullptr,
+                                            LOAD_LIBRARY_SEARCH_DLL_LOAD_DIR | LOAD_LIBRARY_SEARCH_DEFAULT_DIRS);
+            if (!module) {
+                error = L"LoadLibrary failed with error " + std::to_wstring(GetLastError());
+            }
+            return module;
+        }
+
+        void* Symbol(void* handle, const char* name) {
+            return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(handle), name));
+        }
+
+        void CloseLibrary(void* handle) {
+            FreeLibrary(static_cast<HMODULE>(handle));
+        }
+
+        std::vector<std::wstring> ListDirectory(const std::wstring& directory) {
+            std::vector<std::wstring> names;
+            WIN32_FIND_DATAW found;
+            HANDLE search = FindFirstFileW((directory + L"*").c_str(), &found);
+            if (search == INVALID_HANDLE_VALUE) {
+                return names;
+            }
+            do {
+                if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                    names.push_back(found.cFileName);
+                }
+            } while (FindNextFileW(search, &found));
+            FindClose(search);
+            return names;
+        }
+#else
+        constexpr const wchar_t* LIBRARY_EXTENSION = L".so";
+        constexpr wchar_t SEPARATOR = L'/';
+
+        void* OpenLibrary(const std::wstring& path, std::wstring& error) {
+            // RTLD_LOCAL: two providers may export the same helper names
+            void* handle = dlopen(ToUtf8(path).c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!handle) {
+                const char* reason = dlerror();
+                error = reason ? FromUtf8(reason) : L"dlopen failed";
+            }
+            return handle;
+        }
+
+        void* Symbol(void* handle, const char* name) {
+            return dlsym(handle, name);
+        }
+
+        void CloseLibrary(void* handle) {
+            dlclose(handle);
+        }
+
+        std::vector<std::wstring> ListDirectory(const std::wstring& directory) {
+            std::vector<std::wstring> names;
+            DIR* dir = opendir(ToUtf8(directory).c_str());
+            if (!dir) {
+                return names;
+            }
+            while (dirent* entry = readdir(dir)) {
+                if (entry->d_type != DT_DIR) {
+                    names.push_back(FromUtf8(entry->d_name));
+                }
+            }
+            closedir(dir);
+            return names;
+        }
+#endif
+    }
+
+    ProviderLibrary::ProviderLibrary(void* handle, std::wstring path, const LumosProviderInfo* info)
+        : m_handle(handle)
+        , m_path(std::move(path))
+        , m_info(info)
+    {
+    }
+
+    ProviderLibrary::~ProviderLibrary() {
+        CloseLibrary(m_handle);
+    }
+
+    std::unique_ptr<ProviderLibrary> ProviderLibrary::Load(const std::wstring& path, std::wstring& error) {
+        void* handle = OpenLibrary(path, error);
+        if (!handle) {
+            return nullptr;
+        }
+        auto getProvider = reinterpret_cast<LumosGetProviderFn>(Symbol(handle, LUMOS_GET_PROVIDER_SYMBOL));
+        if (!getProvider) {
+            error = L"no LumosGetProvider export";
+            CloseLibrary(handle);
+            return nullptr;
+        }
+        const LumosProviderInfo* info = getProvider();
+        if (!info) {
+            error = L"LumosGetProvider returned nothing";
+            CloseLibrary(handle);
+            return nullptr;
+        }
+        return std::unique_ptr<ProviderLibrary>(new ProviderLibrary(handle, path, info));
+    }
+
+    std::wstring ProviderLoader::DefaultDirectory() {
+#ifdef _WIN32
+        wchar_t exePath[MAX_PATH];
+        DWORD length = GetModuleFileName(nullptr, exePath, MAX_PATH);
+        std::wstring path(exePath, length);
+#else
+        char exePath[4096];
+        ssize_t length = readlink("/proc/self/exe", exePath, sizeof(exePath));
+        std::wstring path = length > 0 ? FromUtf8(std::string_view(exePath, static_cast<size_t>(length))) : std::wstring();
+#endif
+        size_t lastSlash = path.find_last_of(SEPARATOR);
+        std::wstring exeDir = lastSlash != std::wstring::npos ? path.substr(0, lastSlash + 1) : std::wstring();
+        return exeDir + L"providers" + SEPARATOR;
+    }
+
+    size_t ProviderLoader::LoadDirectory(const std::wstring& directory, ProviderRegistry& registry) {
+        std::wstring folder = directory;
+        if (!folder.empty() && folder.back() != SEPARATOR) {
+            folder.push_back(SEPARATOR);
+        }
+
+        std::vector<std::wstring> names = ListDirectory(folder);
+        std::sort(names.begin(), names.end());
+
+        size_t accepted = 0;
+        for (const std::wstring& name : names) {
+            size_t dot = name.find_last_of(L'.');
+            if (dot == std::wstring::npos || !EqualsIgnoreCase(std::wstring_view(name).substr(dot), LIBRARY_EXTENSION)) {
+                continue;
+            }
+            std::wstring error;
+            auto library = ProviderLibrary::Load(folder + name, error);
+            if (!library) {
+                std::wcerr << L"Skipping provider " << folder << name << L": " << error << std::endl;
+                continue;
+            }
+            const LumosProviderInfo* info = library->Info();
+            accepted += registry.Add(info, std::move(library)) ? 1 : 0;
+        }
+        if (accepted > 0) {
+            registry.Build();
+        }
+        return accepted;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "LumosProvider.h"
+
+namespace Lumos {
+    class ProviderRegistry;
+
+    // A provider shared library, unloaded on destruction
+    class ProviderLibrary {
+    public:
+        ~ProviderLibrary();
+
+        ProviderLibrary(const ProviderLibrary&) = delete;
+        ProviderLibrary& operator=(const ProviderLibrary&) = delete;
+
+        // Load `path` and ask it for its description. Null, with the reason
+        // in `error`, if it cannot be loaded or exports no LumosGetProvider.
+        static std::unique_ptr<ProviderLibrary> Load(const std::wstring& path, std::wstring& error);
+
+        const std::wstring& Path() const { return m_path; }
+        const LumosProviderInfo* Info() const { return m_info; }
+
+    private:
+        ProviderLibrary(void* handle, std::wstring path, const LumosProviderInfo* info);
+
+        void* m_handle;
+        std::wstring m_path;
+        const LumosProviderInfo* m_info;
+    };
+
+    class ProviderLoader {
+    public:
+        // The "providers" folder next to the executable
+        static std::wstring DefaultDirectory();
+
+        // Load every .dll (.so elsewhere) in `directory` into `registry`, in
+        // name order so which provider wins a shared extension does not
+        // depend on the file system. Returns how many were accepted; a
+        // missing directory is not an error.
+        static size_t LoadDirectory(const std::wstring& directory, ProviderRegistry& registry);
+    };
+}
@@ -0,0 +1,289 @@
+#include "ProviderRegistry.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include "ProviderLoader.h"
+#include "../common/Utf8.h"
+#ifndef NDEBUG
+#include "../engines/font/OpenTypeFont.h"
+#include "../engines/hash/FileHasher.h"
+#include "../engines/markdown/MarkdownParser.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../engines/text/LogTail.h"
+#endif
+
+namespace Lumos {
+    namespace {
+        using BuiltinEntry = PerfectHash::Entry<BuiltinPreview>;
+
+        constexpr BuiltinEntry Builtin(std::wstring_view extension, BuiltinPreview preview) {
+            return BuiltinEntry{ ExtensionKey(extension), preview, false };
+        }
+
+        // Keep in step with each engine's HandlesExtension; debug builds
+        // check at startup
+        constexpr std::array BUILTIN_EXTENSIONS = {
+            Builtin(L".md", BuiltinPreview::Markdown),
+            Builtin(L".markdown", BuiltinPreview::Markdown),
+            Builtin(L".log", BuiltinPreview::Log),
+            Builtin(L".iso", BuiltinPreview::Hashes),
+            Builtin(L".img", BuiltinPreview::Hashes),
+            Builtin(L".dmg", BuiltinPreview::Hashes),
+            Builtin(L".vhd", BuiltinPreview::Hashes),
+            Builtin(L".vhdx", BuiltinPreview::Hashes),
+            Builtin(L".vmdk", BuiltinPreview::Hashes),
+            Builtin(L".qcow2", BuiltinPreview::Hashes),
+            Builtin(L".zip", BuiltinPreview::Hashes),
+            Builtin(L".7z", BuiltinPreview::Hashes),
+            Builtin(L".rar", BuiltinPreview::Hashes),
+            Builtin(L".tar", BuiltinPreview::Hashes),
+            Builtin(L".gz", BuiltinPreview::Hashes),
+            Builtin(L".tgz", BuiltinPreview::Hashes),
+            Builtin(L".bz2", BuiltinPreview::Hashes),
+            Builtin(L".xz", BuiltinPreview::Hashes),
+            Builtin(L".zst", BuiltinPreview::Hashes),
+            Builtin(L".exe", BuiltinPreview::Hashes),
+            Builtin(L".msi", BuiltinPreview::Hashes),
+            Builtin(L".msix", BuiltinPreview::Hashes),
+            Builtin(L".appx", BuiltinPreview::Hashes),
+            Builtin(L".dll", BuiltinPreview::Hashes),
+            Builtin(L".sys", BuiltinPreview::Hashes),
+            Builtin(L".bin", BuiltinPreview::Hashes),
+            Builtin(L".apk", BuiltinPreview::Hashes),
+            Builtin(L".deb", BuiltinPreview::Hashes),
+            Builtin(L".rpm", BuiltinPreview::Hashes),
+            Builtin(L".db", BuiltinPreview::Database),
+            Builtin(L".sqlite", BuiltinPreview::Database),
+            Builtin(L".sqlite3", BuiltinPreview::Database),
+            Builtin(L".db3", BuiltinPreview::Database),
+            Builtin(L".s3db", BuiltinPreview::Database),
+            Builtin(L".sl3", BuiltinPreview::Database),
+            Builtin(L".ttf", BuiltinPreview::Font),
+            Builtin(L".otf", BuiltinPreview::Font),
+            Builtin(L".ttc", BuiltinPreview::Font),
+            Builtin(L".otc", BuiltinPreview::Font),
+        };
+
+        constexpr StaticPerfectHashMap<BuiltinPreview, BUILTIN_EXTENSIONS.size()> BUILTIN_TABLE(BUILTIN_EXTENSIONS);
+        static_assert(BUILTIN_TABLE.IsValid(), "No perfect hash for the built-in extensions");
+
+        struct BuiltinSignature {
+            const char* bytes;
+            uint32_t length;
+            BuiltinPreview preview;
+        };
+
+        // For files with no extension, or the wrong one. Only magic numbers
+        // no text file starts with: "true" (old Mac TrueType) and "BZh" are
+        // left out.
+        const BuiltinSignature BUILTIN_SIGNATURES[] = {
+            { "SQLite format 3\0", 16, BuiltinPreview::Database },
+            { "\x00\x01\x00\x00", 4, BuiltinPreview::Font },
+            { "OTTO", 4, BuiltinPreview::Font },
+            { "ttcf", 4, BuiltinPreview::Font },
+            { "PK\x03\x04", 4, BuiltinPreview::Hashes },
+            { "7z\xBC\xAF\x27\x1C", 6, BuiltinPreview::Hashes },
+            { "Rar!\x1A\x07", 6, BuiltinPreview::Hashes },
+            { "\xFD" "7zXZ\0", 6, BuiltinPreview::Hashes },
+            { "\x28\xB5\x2F\xFD", 4, BuiltinPreview::Hashes },
+            { "\x1F\x8B", 2, BuiltinPreview::Hashes },
+            { "\x7F" "ELF", 4, BuiltinPreview::Hashes },
+        };
+
+#ifndef NDEBUG
+        bool EngineHandles(BuiltinPreview preview, std::wstring_view extension) {
+            switch (preview) {
+            case BuiltinPreview::Markdown: return MarkdownParser::HandlesExtension(extension);
+            case BuiltinPreview::Log: return LogTail::HandlesExtension(extension);
+            case BuiltinPreview::Hashes: return FileHasher::HandlesExtension(extension);
+            case BuiltinPreview::Database: return SqliteFile::HandlesExtension(extension);
+            case BuiltinPreview::Font: return OpenTypeFont::HandlesExtension(extension);
+            default: return false;
+            }
+        }
+
+        std::wstring ExtensionOf(uint64_t key) {
+            std::wstring extension = L".";
+            for (; key != 0; key >>= 8) {
+                extension.push_back(static_cast<wchar_t>(key & 0xFF));
+            }
+            return extension;
+        }
+#endif
+    }
+
+    ProviderRegistry::ProviderRegistry()
+        : m_sniffBytes(0)
+    {
+#ifndef NDEBUG
+        for (const BuiltinEntry& entry : BUILTIN_EXTENSIONS) {
+            if (!EngineHandles(entry.value, ExtensionOf(entry.key))) {
+                std::wcerr << L"[DEBUG] Built-in table sends " << ExtensionOf(entry.key)
+                           << L" to an engine that does not handle it" << std::endl;
+            }
+        }
+#endif
+        for (const BuiltinSignature& signature : BUILTIN_SIGNATURES) {
+            AddSignature(0, reinterpret_cast<const uint8_t*>(signature.bytes), signature.length,
+                         ProviderMatch{ signature.preview, nullptr });
+        }
+        Build();
+    }
+
+    ProviderRegistry::~ProviderRegistry() = default;
+
+    BuiltinPreview ProviderRegistry::ResolveBuiltin(std::wstring_view extension) {
+        const BuiltinPreview* builtin = BUILTIN_TABLE.Find(ExtensionKey(extension));
+        return builtin ? *builtin : BuiltinPreview::None;
+    }
+
+    bool ProviderRegistry::Add(const LumosProviderInfo* info, std::unique_ptr<ProviderLibrary> library) {
+        std::wstring source = library ? library->Path() : L"(built in)";
+        if (!info) {
+            std::wcerr << L"Provider " << source << L" returned no description" << std::endl;
+            return false;
+        }
+        if (info->abiVersion == 0 || info->abiVersion > LUMOS_PROVIDER_ABI_VERSION ||
+            info->structSize < sizeof(LumosProviderInfo)) {
+            std::wcerr << L"Provider " << source << L" targets ABI " << info->abiVersion << L" (" << info->structSize
+                       << L" bytes); this host speaks ABI " << LUMOS_PROVIDER_ABI_VERSION << std::endl;
+            return false;
+        }
+        if (!info->name || !info->preview || (info->extensionCount > 0 && !info->extensions) ||
+            (info->signatureCount > 0 && !info->signatures) || info->costClass > LUMOS_COST_FULL) {
+            std::wcerr << L"Provider " << source << L" has an incomplete description" << std::endl;
+            return false;
+        }
+
+        auto provider = std::make_unique<NativeProvider>();
+        provider->info = info;
+        provider->name = info->name;
+        provider->version = info->version ? info->version : "";
+        provider->costClass = static_cast<LumosCostClass>(info->costClass);
+        provider->streaming = (info->flags & LUMOS_PROVIDER_STREAMING) != 0;
+        provider->library = library ? library->Path() : std::wstring();
+        std::wstring name = FromUtf8(info->name);
+
+        uint32_t extensionCount = std::min(info->extensionCount, MAX_EXTENSIONS);
+        for (uint32_t i = 0; i < extensionCount; ++i) {
+            uint64_t key = info->extensions[i] ? ExtensionKey(std::string_view(info->extensions[i])) : 0;
+            if (key == 0) {
+                std::wcerr << L"Provider " << name << L": ignoring extension " << FromUtf8(info->extensions[i] ? info->extensions[i] : "(null)")
+                           << L" (needs a dot and 1-8 ASCII characters)" << std::endl;
+                continue;
+            }
+            if (BUILTIN_TABLE.Find(key)) {
+                std::wcerr << L"Provider " << name << L": " << FromUtf8(info->extensions[i])
+                           << L" is previewed natively; ignoring it" << std::endl;
+                continue;
+            }
+            m_providerExtensions.emplace_back(key, provider.get());
+        }
+
+        uint32_t signatureCount = std::min(info->signatureCount, MAX_SIGNATURES);
+        for (uint32_t i = 0; i < signatureCount; ++i) {
+            const LumosSignature& signature = info->signatures[i];
+            if (!signature.bytes || signature.length == 0 || signature.offset >= LUMOS_MAX_SIGNATURE_END ||
+                signature.length > LUMOS_MAX_SIGNATURE_END - signature.offset) {
+                std::wcerr << L"Provider " << name << L": ignoring signature " << i << std::endl;
+                continue;
+            }
+            AddSignature(signature.offset, signature.bytes, signature.length, ProviderMatch{ BuiltinPreview::None, provider.get() });
+        }
+
+        std::wcout << L"Provider " << name << L" " << FromUtf8(provider->version) << L" from " << source << std::endl;
+        m_providers.push_back(std::move(provider));
+        if (library) {
+            m_libraries.push_back(std::move(library));
+        }
+        return true;
+    }
+
+    void ProviderRegistry::AddSignature(uint32_t offset, const uint8_t* bytes, uint32_t length, ProviderMatch match) {
+        m_signatures.push_back(Signature{ offset, std::vector<uint8_t>(bytes, bytes + length), match });
+    }
+
+    void ProviderRegistry::Build() {
+        // First claim on an extension wins
+        std::vector<PerfectHashMap<const NativeProvider*>::Entry> extensions;
+        for (const auto& [key, provider] : m_providerExtensions) {
+            bool taken = std::any_of(extensions.begin(), extensions.end(), [&](const auto& entry) { return entry.key == key; });
+            if (!taken) {
+                extensions.push_back({ key, provider, false });
+            }
+        }
+        m_extensionTable.Build(extensions);
+
+        // Group signatures by where their key sits; built-ins were added
+        // first, so they win any clash
+        m_shapes.clear();
+        m_sniffBytes = 0;
+        std::vector<std::vector<PerfectHashMap<uint32_t>::Entry>> shapeEntries;
+        for (uint32_t i = 0; i < m_signatures.size(); ++i) {
+            const Signature& signature = m_signatures[i];
+            uint32_t keyLength = static_cast<uint32_t>(std::min<size_t>(signature.bytes.size(), 8));
+            m_sniffBytes = std::max(m_sniffBytes, signature.offset + signature.bytes.size());
+
+            size_t shape = 0;
+            while (shape < m_shapes.size() &&
+                   (m_shapes[shape].offset != signature.offset || m_shapes[shape].keyLength != keyLength)) {
+                ++shape;
+            }
+            if (shape == m_shapes.size()) {
+                m_shapes.push_back(SignatureShape{ signature.offset, keyLength, {} });
+                shapeEntries.emplace_back();
+            }
+
+            uint64_t key = SignatureKey(signature.bytes.data(), keyLength);
+            auto& entries = shapeEntries[shape];
+            bool taken = std::any_of(entries.begin(), entries.end(), [&](const auto& entry) { return entry.key == key; });
+            if (!taken) {
+                entries.push_back({ key, i, false });
+            }
+        }
+        for (size_t shape = 0; shape < m_shapes.size(); ++shape) {
+            m_shapes[shape].table.Build(shapeEntries[shape]);
+        }
+        std::stable_sort(m_shapes.begin(), m_shapes.end(), [](const SignatureShape& a, const SignatureShape& b) {
+            return a.keyLength > b.keyLength;
+        });
+    }
+
+    ProviderMatch ProviderRegistry::Resolve(std::wstring_view extension) const {
+        uint64_t key = ExtensionKey(extension);
+        if (key == 0) {
+            return {};
+        }
+        if (const BuiltinPreview* builtin = BUILTIN_TABLE.Find(key)) {
+            return ProviderMatch{ *builtin, nullptr };
+        }
+        if (const NativeProvider* const* provider = m_extensionTable.Find(key)) {
+            return ProviderMatch{ BuiltinPreview::None, *provider };
+        }
+        return {};
+    }
+
+    ProviderMatch ProviderRegistry::Sniff(ByteView head) const {
+        for (const SignatureShape& shape : m_shapes) {
+            if (!head.Has(shape.offset, shape.keyLength)) {
+                continue;
+            }
+            const uint32_t* index = shape.table.Find(SignatureKey(head.Data() + shape.offset, shape.keyLength));
+            if (!index) {
+                continue;
+            }
+            const Signature& signature = m_signatures[*index];
+            if (!head.Has(signature.offset, signature.bytes.size()) ||
+                std::memcmp(head.Data() + signature.offset, signature.bytes.data(), signature.bytes.size()) != 0) {
+                continue;
+            }
+            const NativeProvider* provider = signature.match.provider;
+            if (provider && provider->info->probe && !provider->info->probe(head.Data(), head.Size())) {
+                continue;
+            }
+            return signature.match;
+        }
+        return {};
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "LumosProvider.h"
+#include "../common/ByteView.h"
+#include "../common/PerfectHash.h"
+
+namespace Lumos {
+    class ProviderLibrary;
+
+    // Previews the pipeline implements itself
+    enum class BuiltinPreview : uint8_t {
+        None,
+        Markdown,
+        Log,
+        Hashes,
+        Database,
+        Font
+    };
+
+    // A provider that passed validation. `info` stays valid as long as the
+    // registry that holds it.
+    struct NativeProvider {
+        const LumosProviderInfo* info;
+        std::string name;
+        std::string version;
+        LumosCostClass costClass;
+        bool streaming;
+        std::wstring library;  // Empty for providers linked into lumos.exe
+    };
+
+    struct ProviderMatch {
+        BuiltinPreview builtin = BuiltinPreview::None;
+        const NativeProvider* provider = nullptr;
+
+        explicit operator bool() const { return builtin != BuiltinPreview::None || provider != nullptr; }
+    };
+
+    // Decides which preview handles a file: by extension first, then by the
+    // magic bytes at its start when the extension is unknown. Built-in
+    // previews win over providers for the same extension or signature, and
+    // of two providers the first added wins.
+    //
+    // Built-in extensions live in a perfect-hash table built at compile
+    // time; providers' extensions and every signature go into tables built
+    // once by Build(). Add() and Build() run at startup, before the
+    // pipeline starts; after that the registry is read-only and safe to
+    // share.
+    class ProviderRegistry {
+    public:
+        // Provider extensions and signatures beyond these are ignored
+        static constexpr uint32_t MAX_EXTENSIONS = 256;
+        static constexpr uint32_t MAX_SIGNATURES = 64;
+
+        ProviderRegistry();
+        ~ProviderRegistry();
+
+        ProviderRegistry(const ProviderRegistry&) = delete;
+        ProviderRegistry& operator=(const ProviderRegistry&) = delete;
+
+        // Validate `info` against this host's ABI and take it in, keeping
+        // `library` (null for built-in providers) loaded for as long as the
+        // registry lives. False, with the reason on stderr, if rejected.
+        bool Add(const LumosProviderInfo* info, std::unique_ptr<ProviderLibrary> library = nullptr);
+
+        // Build the lookup tables from everything added so far
+        void Build();
+
+        ProviderMatch Resolve(std::wstring_view extension) const;
+
+        // `head` is the file's first bytes, at least SniffBytes() when the
+        // file is that long
+        ProviderMatch Sniff(ByteView head) const;
+        size_t SniffBytes() const { return m_sniffBytes; }
+
+        const std::vector<std::unique_ptr<NativeProvider>>& Providers() const { return m_providers; }
+
+        // The compile-time table alone, for callers with no registry
+        static BuiltinPreview ResolveBuiltin(std::wstring_view extension);
+
+    private:
+        struct Signature {
+            uint32_t offset;
+            std::vector<uint8_t> bytes;
+            ProviderMatch match;
+        };
+
+        // Signatures sharing an offset and key length share one table,
+        // keyed on their first (at most 8) bytes
+        struct SignatureShape {
+            uint32_t offset;
+            uint32_t keyLength;
+            PerfectHashMap<uint32_t> table;  // Index into m_signatures
+        };
+
+        void AddSignature(uint32_t offset, const uint8_t* bytes, uint32_t length, ProviderMatch match);
+
+        std::vector<std::unique_ptr<NativeProvider>> m_providers;
+        std::vector<std::unique_ptr<ProviderLibrary>> m_libraries;
+        std::vector<std::pair<uint64_t, const NativeProvider*>> m_providerExtensions;  // In the order added
+        std::vector<Signature> m_signatures;
+
+        PerfectHashMap<const NativeProvider*> m_extensionTable;
+        std::vector<SignatureShape> m_shapes;  // Longest keys first
+        size_t m_sniffBytes;
+    };
+}
@@ -0,0 +1,126 @@
+#include "ProviderSession.h"
+#include <cstring>
+#include "ProviderRegistry.h"
+#include "../common/Json.h"
+#include "../common/Utf8.h"
+
+namespace Lumos {
+    namespace {
+        // At most `limit` bytes of a provider's C string, cut on a UTF-8
+        // sequence boundary
+        std::string_view Bounded(const char* text, size_t limit) {
+            if (!text) {
+                return std::string_view();
+            }
+            size_t length = strnlen(text, limit + 1);
+            if (length > limit) {
+                length = limit;
+                while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+                    --length;
+                }
+            }
+            return std::string_view(text, length);
+        }
+    }
+
+    ProviderSession::ProviderSession(const NativeProvider& provider, const CancellationToken& cancellation,
+                                     ProviderBatchCallback onBatch)
+        : m_provider(provider)
+        , m_cancellation(cancellation)
+        , m_onBatch(std::move(onBatch))
+        , m_rows("[")
+        , m_batchFirstRow(0)
+        , m_rowCount(0)
+        , m_batchCount(0)
+        , m_stopped(false)
+        , m_undeliverable(false)
+    {
+    }
+
+    LumosPreviewResult ProviderSession::Run(ByteView data, std::wstring_view path, std::wstring_view extension) {
+        std::string utf8Path = ToUtf8(path);
+        std::string utf8Extension = ToUtf8(extension);
+
+        LumosPreviewInput input{};
+        input.structSize = sizeof(LumosPreviewInput);
+        input.path = utf8Path.c_str();
+        input.extension = utf8Extension.c_str();
+        input.data = data.Data();
+        input.size = data.Size();
+
+        LumosHost host{};
+        host.structSize = sizeof(LumosHost);
+        host.context = this;
+        host.emit = &ProviderSession::Emit;
+        host.cancelled = &ProviderSession::Cancelled;
+
+        m_lastFlush = std::chrono::steady_clock::now();
+        int result = m_provider.info->preview(&input, &host);
+
+        if (m_cancellation.IsCancellationRequested()) {
+            return LUMOS_PREVIEW_CANCELLED;
+        }
+        if (result == LUMOS_PREVIEW_UNSUPPORTED && m_batchCount == 0) {
+            return LUMOS_PREVIEW_UNSUPPORTED;
+        }
+        // Anything else, including a result code from a newer ABI, counts
+        // as a failure once rows were shown
+        bool failed = result != LUMOS_PREVIEW_OK;
+        if (!m_undeliverable) {
+            Flush(true, failed);
+        }
+        return failed ? LUMOS_PREVIEW_FAILED : LUMOS_PREVIEW_OK;
+    }
+
+    int ProviderSession::Emit(void* context, const char* name, const char* value) {
+        auto* session = static_cast<ProviderSession*>(context);
+        if (session->m_stopped || session->m_cancellation.IsCancellationRequested()) {
+            return 0;
+        }
+
+        if (session->m_rows.size() > 1) {
+            session->m_rows.push_back(',');
+        }
+        session->m_rows.append("{\"name\":");
+        AppendJsonString(session->m_rows, Bounded(name, MAX_NAME_BYTES));
+        session->m_rows.append(",\"value\":");
+        AppendJsonString(session->m_rows, Bounded(value, MAX_VALUE_BYTES));
+        session->m_rows.push_back('}');
+
+        if (++session->m_rowCount >= MAX_ROWS) {
+            session->m_stopped = true;
+            return 0;
+        }
+        if (session->m_rows.size() >= MAX_BATCH_BYTES ||
+            (session->m_provider.streaming &&
+             std::chrono::steady_clock::now() - session->m_lastFlush >= STREAM_INTERVAL)) {
+            return session->Flush(false, false) ? 1 : 0;
+        }
+        return 1;
+    }
+
+    int ProviderSession::Cancelled(void* context) {
+        auto* session = static_cast<ProviderSession*>(context);
+        return session->m_cancellation.IsCancellationRequested() ? 1 : 0;
+    }
+
+    bool ProviderSession::Flush(bool complete, bool failed) {
+        m_rows.push_back(']');
+        ProviderBatch batch;
+        batch.firstRow = m_batchFirstRow;
+        batch.rowCount = static_cast<uint32_t>(m_rowCount - m_batchFirstRow);
+        batch.complete = complete;
+        batch.failed = failed;
+        batch.truncated = complete && m_rowCount >= MAX_ROWS;
+        batch.rowsJson = m_rows;
+        bool sent = m_onBatch(batch);
+
+        m_batchFirstRow = static_cast<uint32_t>(m_rowCount);
+        m_rows.resize(1);  // Back to the opening bracket
+        m_lastFlush = std::chrono::steady_clock::now();
+        ++m_batchCount;
+        m_undeliverable = !sent;
+        m_stopped = m_stopped || !sent;
+        return sent;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "LumosProvider.h"
+#include "../common/ByteView.h"
+#include "../common/CancellationToken.h"
+
+namespace Lumos {
+    struct NativeProvider;
+
+    // Rows a provider emitted, as a JSON array of {"name","value"} objects
+    struct ProviderBatch {
+        uint32_t firstRow = 0;      // Index of the batch's first row in the preview
+        uint32_t rowCount = 0;
+        bool complete = false;      // The provider returned; no more batches follow
+        bool failed = false;        // It gave up part-way (malformed file)
+        bool truncated = false;     // Stopped at ProviderSession::MAX_ROWS
+        std::string_view rowsJson;  // Not owned
+    };
+
+    // False stops the provider: the UI is gone
+    using ProviderBatchCallback = std::function<bool(const ProviderBatch& batch)>;
+
+    // One call into a provider: hands it the file and host callbacks,
+    // bounds what it may emit, and passes the rows on in batches. Streaming
+    // providers' rows go out at most every STREAM_INTERVAL while they run;
+    // everyone else's in one batch when they return, unless MAX_BATCH_BYTES
+    // of rows pile up first. Runs on the calling thread, which the provider
+    // blocks until it returns.
+    class ProviderSession {
+    public:
+        static constexpr size_t MAX_ROWS = 10000;
+        static constexpr size_t MAX_NAME_BYTES = 256;
+        static constexpr size_t MAX_VALUE_BYTES = 4096;
+        static constexpr auto STREAM_INTERVAL = std::chrono::milliseconds(100);
+        static constexpr size_t MAX_BATCH_BYTES = 1024 * 1024;
+
+        ProviderSession(const NativeProvider& provider, const CancellationToken& cancellation,
+                        ProviderBatchCallback onBatch);
+
+        ProviderSession(const ProviderSession&) = delete;
+        ProviderSession& operator=(const ProviderSession&) = delete;
+
+        // Preview `data`, the mapped file. UNSUPPORTED with no batch sent
+        // means the caller should fall back to a plain preview; CANCELLED
+        // means a newer press took over and the last batch was not sent.
+        LumosPreviewResult Run(ByteView data, std::wstring_view path, std::wstring_view extension);
+
+        size_t RowCount() const { return m_rowCount; }
+        size_t BatchCount() const { return m_batchCount; }
+
+    private:
+        static int Emit(void* context, const char* name, const char* value);
+        static int Cancelled(void* context);
+
+        bool Flush(bool complete, bool failed);
+
+        const NativeProvider& m_provider;
+        const CancellationToken& m_cancellation;
+        ProviderBatchCallback m_onBatch;
+
+        std::pmr::string m_rows;  // Rows since the last batch: an open JSON array
+        uint32_t m_batchFirstRow;
+        size_t m_rowCount;
+        size_t m_batchCount;
+        bool m_stopped;           // Row limit reached or the UI is gone
+        bool m_undeliverable;     // The UI is gone
+        std::chrono::steady_clock::time_point m_lastFlush;
+    };
+}
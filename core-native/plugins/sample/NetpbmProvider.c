@@ -0,0 +1,220 @@
+// Sample preview provider: Netpbm images (PBM, PGM, PPM and PAM), whose
+// headers are plain text. Shows the image's dimensions, sample format and
+// first comment. Build it as a shared library against LumosProvider.h and
+// drop it in the providers folder.
+
+#include <stdio.h>
+#include <string.h>
+#include "../LumosProvider.h"
+
+#define MAX_HEADER_BYTES 4096
+#define MAX_COMMENT_BYTES 256
+
+typedef struct Cursor {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    char comment[MAX_COMMENT_BYTES];
+} Cursor;
+
+static int IsSpace(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Whitespace and # comments; the first comment is kept
+static void SkipSpace(Cursor* cursor) {
+    while (cursor->position < cursor->size) {
+        uint8_t c = cursor->data[cursor->position];
+        if (c == '#') {
+            size_t start = ++cursor->position;
+            while (cursor->position < cursor->size && cursor->data[cursor->position] != '\n' &&
+                   cursor->data[cursor->position] != '\r') {
+                ++cursor->position;
+            }
+            if (cursor->comment[0] == '\0') {
+                while (start < cursor->position && IsSpace(cursor->data[start])) {
+                    ++start;
+                }
+                size_t length = cursor->position - start;
+                length = length < MAX_COMMENT_BYTES - 1 ? length : MAX_COMMENT_BYTES - 1;
+                memcpy(cursor->comment, cursor->data + start, length);
+                cursor->comment[length] = '\0';
+            }
+        } else if (IsSpace(c)) {
+            ++cursor->position;
+        } else {
+            return;
+        }
+    }
+}
+
+// Decimal header field; 0 if missing or over 2^31
+static uint32_t ReadNumber(Cursor* cursor) {
+    SkipSpace(cursor);
+    uint64_t value = 0;
+    size_t digits = 0;
+    while (cursor->position < cursor->size && cursor->data[cursor->position] >= '0' &&
+           cursor->data[cursor->position] <= '9' && value <= 0x7FFFFFFF) {
+        value = value * 10 + (cursor->data[cursor->position++] - '0');
+        ++digits;
+    }
+    return digits > 0 && value <= 0x7FFFFFFF ? (uint32_t)value : 0;
+}
+
+// One whitespace-delimited word of a PAM header line
+static size_t ReadWord(Cursor* cursor, char* out, size_t capacity) {
+    while (cursor->position < cursor->size &&
+           (cursor->data[cursor->position] == ' ' || cursor->data[cursor->position] == '\t')) {
+        ++cursor->position;
+    }
+    size_t length = 0;
+    while (cursor->position < cursor->size && !IsSpace(cursor->data[cursor->position])) {
+        if (length + 1 < capacity) {
+            out[length++] = (char)cursor->data[cursor->position];
+        }
+        ++cursor->position;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static int EmitNumber(const LumosHost* host, const char* name, uint64_t value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    return host->emit(host->context, name, text);
+}
+
+static int Probe(const uint8_t* head, size_t length) {
+    // "P1" at the start of a text file is not enough: the magic is followed
+    // by whitespace, then a number or a comment (PAM: a header line)
+    if (length < 4 || head[0] != 'P' || head[1] < '1' || head[1] > '7' || !IsSpace(head[2])) {
+        return 0;
+    }
+    size_t i = 2;
+    while (i < length && IsSpace(head[i])) {
+        ++i;
+    }
+    return i < length && ((head[i] >= '0' && head[i] <= '9') || head[i] == '#' || head[1] == '7');
+}
+
+static int Preview(const LumosPreviewInput* input, const LumosHost* host) {
+    Cursor cursor;
+    cursor.data = input->data;
+    cursor.size = input->size < MAX_HEADER_BYTES ? (size_t)input->size : MAX_HEADER_BYTES;
+    cursor.position = 2;
+    cursor.comment[0] = '\0';
+    if (!Probe(cursor.data, cursor.size)) {
+        return LUMOS_PREVIEW_UNSUPPORTED;
+    }
+
+    static const char* const FORMATS[] = {
+        "PBM (plain bitmap)", "PGM (plain greymap)", "PPM (plain pixmap)",
+        "PBM (bitmap)", "PGM (greymap)", "PPM (pixmap)", "PAM (arbitrary map)"
+    };
+    static const uint32_t CHANNELS[] = { 1, 1, 3, 1, 1, 3, 0 };
+    int kind = cursor.data[1] - '1';
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = CHANNELS[kind];
+    uint32_t maxValue = 1;
+    char tupleType[64] = "";
+    if (kind == 6) {
+        // PAM: "KEY value" lines up to ENDHDR
+        char key[16];
+        int ended = 0;
+        while (!ended && cursor.position < cursor.size) {
+            SkipSpace(&cursor);
+            if (ReadWord(&cursor, key, sizeof(key)) == 0) {
+                break;
+            }
+            if (strcmp(key, "ENDHDR") == 0) {
+                ended = 1;
+            } else if (strcmp(key, "WIDTH") == 0) {
+                width = ReadNumber(&cursor);
+            } else if (strcmp(key, "HEIGHT") == 0) {
+                height = ReadNumber(&cursor);
+            } else if (strcmp(key, "DEPTH") == 0) {
+                channels = ReadNumber(&cursor);
+            } else if (strcmp(key, "MAXVAL") == 0) {
+                maxValue = ReadNumber(&cursor);
+            } else if (strcmp(key, "TUPLTYPE") == 0) {
+                ReadWord(&cursor, tupleType, sizeof(tupleType));
+            }
+            while (cursor.position < cursor.size && cursor.data[cursor.position] != '\n') {
+                ++cursor.position;
+            }
+        }
+        if (!ended) {
+            return LUMOS_PREVIEW_FAILED;
+        }
+    } else {
+        width = ReadNumber(&cursor);
+        height = ReadNumber(&cursor);
+        if (kind != 0 && kind != 3) {
+            maxValue = ReadNumber(&cursor);
+        }
+    }
+
+    if (!host->emit(host->context, "Format", FORMATS[kind]) ||
+        (tupleType[0] && !host->emit(host->context, "Tuple type", tupleType))) {
+        return LUMOS_PREVIEW_OK;
+    }
+    if (width == 0 || height == 0 || maxValue == 0 || maxValue > 65535 || channels == 0) {
+        host->emit(host->context, "Header", "Damaged: missing or out-of-range dimensions");
+        return LUMOS_PREVIEW_FAILED;
+    }
+
+    char dimensions[48];
+    snprintf(dimensions, sizeof(dimensions), "%u x %u", width, height);
+    host->emit(host->context, "Dimensions", dimensions);
+    EmitNumber(host, "Channels", channels);
+    EmitNumber(host, "Maximum value", maxValue);
+    EmitNumber(host, "Bits per sample", maxValue == 1 ? 1 : maxValue < 256 ? 8 : 16);
+
+    // Raster size for the binary formats; plain ones are text all through
+    if (kind >= 3) {
+        uint64_t rowBytes = kind == 3 ? ((uint64_t)width + 7) / 8
+                                      : (uint64_t)width * channels * (maxValue < 256 ? 1 : 2);
+        uint64_t rasterBytes = rowBytes * height;
+        uint64_t available = input->size - (cursor.position + 1 < input->size ? cursor.position + 1 : input->size);
+        EmitNumber(host, "Raster bytes", rasterBytes);
+        if (available < rasterBytes) {
+            host->emit(host->context, "Raster", "Truncated");
+        }
+    }
+    if (cursor.comment[0]) {
+        host->emit(host->context, "Comment", cursor.comment);
+    }
+    return LUMOS_PREVIEW_OK;
+}
+
+static const char* const EXTENSIONS[] = { ".pbm", ".pgm", ".ppm", ".pnm", ".pam" };
+
+static const uint8_t MAGIC[7][2] = {
+    { 'P', '1' }, { 'P', '2' }, { 'P', '3' }, { 'P', '4' }, { 'P', '5' }, { 'P', '6' }, { 'P', '7' }
+};
+
+static const LumosSignature SIGNATURES[] = {
+    { 0, 2, MAGIC[0] }, { 0, 2, MAGIC[1] }, { 0, 2, MAGIC[2] }, { 0, 2, MAGIC[3] },
+    { 0, 2, MAGIC[4] }, { 0, 2, MAGIC[5] }, { 0, 2, MAGIC[6] }
+};
+
+static const LumosProviderInfo PROVIDER = {
+    LUMOS_PROVIDER_ABI_VERSION,
+    sizeof(LumosProviderInfo),
+    "Netpbm images",
+    "1.0",
+    EXTENSIONS,
+    sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]),
+    SIGNATURES,
+    sizeof(SIGNATURES) / sizeof(SIGNATURES[0]),
+    LUMOS_COST_HEADER,
+    0,
+    Probe,
+    Preview
+};
+
+LUMOS_PROVIDER_EXPORT const LumosProviderInfo* LumosGetProvider(void) {
+    return &PROVIDER;
+}
@@ -0,0 +1,130 @@
+#include "ReplayBaseline.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include "SessionLog.h"
+#include "../common/Utf8.h"
+
+namespace Lumos {
+    namespace {
+        const char HEADER[] = "stage\tcount\tp50\tp95\tp99";
+
+        bool Regressed(uint64_t current, uint64_t baseline, double factor, uint64_t slack) {
+            return current > static_cast<double>(baseline) * factor && current > baseline + slack;
+        }
+    }
+
+    bool ReplayBaseline::Load(std::wstring_view path, std::vector<BaselineStage>& out, std::wstring& error) {
+        std::FILE* file = SessionLog::OpenFile(path, "rb");
+        if (file == nullptr) {
+            error = L"Cannot open baseline " + std::wstring(path);
+            return false;
+        }
+        out.clear();
+        char line[512];
+        bool sawHeader = false;
+        while (std::fgets(line, sizeof(line), file) != nullptr) {
+            std::string text(line);
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+                text.pop_back();
+            }
+            if (text.empty() || text[0] == '#') {
+                continue;
+            }
+            if (!sawHeader) {
+                sawHeader = text == HEADER;
+                if (!sawHeader) {
+                    break;
+                }
+                continue;
+            }
+            size_t tab = text.find('\t');
+            BaselineStage stage;
+            stage.name = text.substr(0, tab);
+            if (tab == std::string::npos ||
+                std::sscanf(text.c_str() + tab + 1, "%" SCNu64 "\t%" SCNu64 "\t%" SCNu64 "\t%" SCNu64,
+                            &stage.count, &stage.p50, &stage.p95, &stage.p99) != 4) {
+                std::fclose(file);
+                error = L"Bad baseline line: " + FromUtf8(text);
+                return false;
+            }
+            out.push_back(std::move(stage));
+        }
+        std::fclose(file);
+        if (!sawHeader) {
+            error = std::wstring(path) + L" is not a lumos-replay baseline";
+            return false;
+        }
+        return true;
+    }
+
+    bool ReplayBaseline::Save(std::wstring_view path, const std::vector<BaselineStage>& stages) {
+        std::FILE* file = SessionLog::OpenFile(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fprintf(file, "# lumos-replay baseline; nanoseconds\n%s\n", HEADER);
+        for (const auto& stage : stages) {
+            std::fprintf(file, "%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\n", stage.name.c_str(),
+                         stage.count, stage.p50, stage.p95, stage.p99);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    std::vector<BaselineStage> ReplayBaseline::FromSnapshot(const MetricsSnapshot& snapshot, double headroom,
+                                                            const std::vector<BaselineStage>& floor) {
+        auto scaled = [headroom](uint64_t value) {
+            return static_cast<uint64_t>(static_cast<double>(value) * headroom);
+        };
+        std::vector<BaselineStage> stages;
+        for (const auto& histogram : snapshot.histograms) {
+            BaselineStage stage;
+            stage.name = histogram.name;
+            stage.count = histogram.count;
+            stage.p50 = scaled(histogram.p50);
+            stage.p95 = scaled(histogram.p95);
+            stage.p99 = scaled(histogram.p99);
+            for (const auto& previous : floor) {
+                if (previous.name == stage.name) {
+                    stage.count = std::max(stage.count, previous.count);
+                    stage.p50 = std::max(stage.p50, previous.p50);
+                    stage.p95 = std::max(stage.p95, previous.p95);
+                    stage.p99 = std::max(stage.p99, previous.p99);
+                }
+            }
+            stages.push_back(std::move(stage));
+        }
+        return stages;
+    }
+
+    std::vector<std::wstring> ReplayBaseline::Compare(const std::vector<BaselineStage>& baseline,
+                                                      const MetricsSnapshot& current, double factor, uint64_t slack) {
+        std::vector<std::wstring> regressions;
+        for (const auto& stage : baseline) {
+            if (stage.count == 0) {
+                continue;
+            }
+            const HistogramSummary* found = nullptr;
+            for (const auto& histogram : current.histograms) {
+                if (histogram.name == stage.name) {
+                    found = &histogram;
+                }
+            }
+            std::wstring name = FromUtf8(stage.name);
+            if (found == nullptr || found->count == 0) {
+                regressions.push_back(name + L": no longer recorded (baseline " + std::to_wstring(stage.count) +
+                                      L" samples)");
+                continue;
+            }
+            if (Regressed(found->p50, stage.p50, factor, slack)) {
+                regressions.push_back(name + L": p50 " + MetricsReport::FormatDuration(found->p50) + L", baseline " +
+                                      MetricsReport::FormatDuration(stage.p50));
+            }
+            if (Regressed(found->p95, stage.p95, factor, slack)) {
+                regressions.push_back(name + L": p95 " + MetricsReport::FormatDuration(found->p95) + L", baseline " +
+                                      MetricsReport::FormatDuration(stage.p95));
+            }
+        }
+        return regressions;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../metrics/MetricsReport.h"
+
+namespace Lumos {
+    struct BaselineStage {
+        std::string name;  // Histogram name, as in MetricsSnapshot
+        uint64_t count = 0;
+        uint64_t p50 = 0;  // Nanoseconds
+        uint64_t p95 = 0;
+        uint64_t p99 = 0;
+    };
+
+    // Per-stage percentiles a replay is held to. Stored as tab-separated
+    // text next to the session so a deliberate change updates both in one
+    // diff (lumos-replay --write-baseline).
+    class ReplayBaseline {
+    public:
+        static bool Load(std::wstring_view path, std::vector<BaselineStage>& out, std::wstring& error);
+        static bool Save(std::wstring_view path, const std::vector<BaselineStage>& stages);
+
+        // The stages of `snapshot` with each percentile scaled by `headroom`
+        // and raised to the same stage's in `floor`, so that several runs
+        // (or machines) can accumulate into one baseline instead of it
+        // recording whichever run happened to be quietest
+        static std::vector<BaselineStage> FromSnapshot(const MetricsSnapshot& snapshot, double headroom,
+                                                       const std::vector<BaselineStage>& floor);
+
+        // One line per stage that got slower than `factor` times its
+        // baseline p50 or p95 and also by more than `slack` nanoseconds, or
+        // that stopped running. Empty when the replay is within bounds.
+        // The slack keeps microsecond stages from failing on scheduler noise.
+        static std::vector<std::wstring> Compare(const std::vector<BaselineStage>& baseline,
+                                                 const MetricsSnapshot& current, double factor, uint64_t slack);
+    };
+}
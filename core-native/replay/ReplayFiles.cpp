@@ -0,0 +1,336 @@
+#include "ReplayFiles.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../common/StringUtil.h"
+#include "../common/Utf8.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    namespace {
+        // SplitMix64: tiny, and the same sequence on every platform
+        class SeededBytes {
+        public:
+            explicit SeededBytes(uint64_t seed) : m_state(seed) {}
+
+            uint64_t Next() {
+                uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            void Fill(std::string& out, size_t length) {
+                size_t start = out.size();
+                out.resize(start + length);
+                for (size_t i = 0; i < length; i += 8) {
+                    uint64_t value = Next();
+                    std::memcpy(&out[start + i], &value, std::min<size_t>(8, length - i));
+                }
+            }
+
+        private:
+            uint64_t m_state;
+        };
+
+        void PutU16BE(std::string& out, uint32_t value) {
+            out.push_back(static_cast<char>(value >> 8));
+            out.push_back(static_cast<char>(value));
+        }
+
+        void PutU32BE(std::string& out, uint32_t value) {
+            PutU16BE(out, value >> 16);
+            PutU16BE(out, value & 0xFFFF);
+        }
+
+        void PutU16LE(std::string& out, uint32_t value) {
+            out.push_back(static_cast<char>(value));
+            out.push_back(static_cast<char>(value >> 8));
+        }
+
+        void PutU32LE(std::string& out, uint32_t value) {
+            PutU16LE(out, value & 0xFFFF);
+            PutU16LE(out, value >> 16);
+        }
+
+        // Compressed photos run about a byte per pixel; 4:3 like a camera
+        void ImageSize(uint64_t bytes, uint32_t& width, uint32_t& height) {
+            double edge = std::sqrt(static_cast<double>(std::max<uint64_t>(bytes, 1024)) * 4.0 / 3.0);
+            width = static_cast<uint32_t>(std::clamp(edge, 16.0, 12000.0));
+            height = std::max<uint32_t>(width * 3 / 4, 1);
+        }
+
+        enum class Kind { Binary, Markdown, Log, Text, Png, Jpeg, Gif, Bmp, Sqlite };
+
+        Kind KindOf(std::wstring_view extension) {
+            struct Entry { const wchar_t* extension; Kind kind; };
+            static const Entry KINDS[] = {
+                { L".md", Kind::Markdown }, { L".markdown", Kind::Markdown },
+                { L".log", Kind::Log },
+                { L".txt", Kind::Text }, { L".json", Kind::Text }, { L".xml", Kind::Text }, { L".csv", Kind::Text },
+                { L".cpp", Kind::Text }, { L".h", Kind::Text }, { L".cs", Kind::Text }, { L".js", Kind::Text },
+                { L".ts", Kind::Text }, { L".py", Kind::Text }, { L".ini", Kind::Text }, { L".yaml", Kind::Text },
+                { L".yml", Kind::Text }, { L".html", Kind::Text }, { L".css", Kind::Text },
+                { L".png", Kind::Png },
+                { L".jpg", Kind::Jpeg }, { L".jpeg", Kind::Jpeg },
+                { L".gif", Kind::Gif },
+                { L".bmp", Kind::Bmp },
+                { L".db", Kind::Sqlite }, { L".sqlite", Kind::Sqlite }, { L".sqlite3", Kind::Sqlite },
+                { L".db3", Kind::Sqlite }, { L".s3db", Kind::Sqlite }, { L".sl3", Kind::Sqlite },
+            };
+            for (const auto& entry : KINDS) {
+                if (EqualsIgnoreCase(extension, entry.extension)) {
+                    return entry.kind;
+                }
+            }
+            return Kind::Binary;
+        }
+
+        const char* const WORDS[] = {
+            "preview", "selection", "explorer", "latency", "cache", "header", "worker", "request",
+            "generation", "pipeline", "budget", "render", "window", "decode", "thumbnail", "volume",
+        };
+
+        void AppendWords(std::string& out, SeededBytes& random, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    out.push_back(' ');
+                }
+                out += WORDS[random.Next() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            }
+        }
+
+        // One more chunk of text of the kind; callers repeat until the size is reached
+        void AppendText(std::string& out, Kind kind, SeededBytes& random, uint64_t line) {
+            char prefix[96];
+            switch (kind) {
+            case Kind::Markdown:
+                switch (line % 5) {
+                case 0:
+                    out += "## Section " + std::to_string(line / 5 + 1) + "\n\n";
+                    break;
+                case 1:
+                case 2:
+                    AppendWords(out, random, 40 + random.Next() % 40);
+                    out += "\n\n";
+                    break;
+                case 3:
+                    for (int item = 0; item < 4; ++item) {
+                        out += "- **";
+                        AppendWords(out, random, 1);
+                        out += "**: ";
+                        AppendWords(out, random, 8);
+                        out += "\n";
+                    }
+                    out += "\n";
+                    break;
+                default:
+                    out += "```cpp\nauto value = Resolve(";
+                    AppendWords(out, random, 1);
+                    out += ");\n```\n\n";
+                    break;
+                }
+                break;
+            case Kind::Log:
+                std::snprintf(prefix, sizeof(prefix), "2026-01-01T%02u:%02u:%02u.%03uZ %s [worker-%u] ",
+                              static_cast<unsigned>(line / 3600000 % 24), static_cast<unsigned>(line / 60000 % 60),
+                              static_cast<unsigned>(line / 1000 % 60), static_cast<unsigned>(line % 1000),
+                              random.Next() % 20 == 0 ? "WARN" : "INFO", static_cast<unsigned>(random.Next() % 8));
+                out += prefix;
+                AppendWords(out, random, 6 + random.Next() % 10);
+                out += "\n";
+                break;
+            default:
+                AppendWords(out, random, 8 + random.Next() % 8);
+                out += "\n";
+                break;
+            }
+        }
+
+        // The header of the kind, or nothing; the rest is text or seeded bytes
+        std::string Header(Kind kind, uint64_t size) {
+            std::string out;
+            uint32_t width;
+            uint32_t height;
+            ImageSize(size, width, height);
+            switch (kind) {
+            case Kind::Png:
+                out.assign("\x89PNG\r\n\x1A\n", 8);
+                PutU32BE(out, 13);
+                out += "IHDR";
+                PutU32BE(out, width);
+                PutU32BE(out, height);
+                out += std::string("\x08\x06\x00\x00\x00", 5);  // 8-bit RGBA
+                PutU32BE(out, 0);                                // CRC; the probe does not check it
+                break;
+            case Kind::Jpeg:
+                out.assign("\xFF\xD8\xFF\xE0", 4);
+                PutU16BE(out, 16);
+                out += std::string("JFIF\0\x01\x01\x00\x00\x01\x00\x01\x00\x00", 14);
+                out += "\xFF\xC0";
+                PutU16BE(out, 17);
+                out.push_back(8);
+                PutU16BE(out, height);
+                PutU16BE(out, width);
+                out += std::string("\x03\x01\x22\x00\x02\x11\x01\x03\x11\x01", 10);
+                break;
+            case Kind::Gif:
+                out = "GIF89a";
+                PutU16LE(out, std::min<uint32_t>(width, 65535));
+                PutU16LE(out, std::min<uint32_t>(height, 65535));
+                out += std::string("\x00\x00\x00", 3);  // No global color table
+                break;
+            case Kind::Bmp:
+                out = "BM";
+                PutU32LE(out, static_cast<uint32_t>(size));
+                PutU32LE(out, 0);
+                PutU32LE(out, 54);
+                PutU32LE(out, 40);  // BITMAPINFOHEADER
+                PutU32LE(out, width);
+                PutU32LE(out, height);
+                PutU16LE(out, 1);
+                PutU16LE(out, 24);
+                out += std::string(24, '\0');
+                break;
+            case Kind::Sqlite: {
+                // An empty database: the header and a leaf page holding no tables
+                static constexpr uint32_t PAGE_SIZE = 4096;
+                uint32_t pages = static_cast<uint32_t>(std::max<uint64_t>(size / PAGE_SIZE, 1));
+                out.assign("SQLite format 3\0", 16);
+                PutU16BE(out, PAGE_SIZE);
+                out += std::string("\x01\x01\x00\x40\x20\x20", 6);  // Versions, reserved, payload fractions
+                PutU32BE(out, 1);       // 24: change counter
+                PutU32BE(out, pages);   // 28: database size
+                PutU32BE(out, 0);       // 32: first freelist page
+                PutU32BE(out, 0);       // 36: freelist pages
+                PutU32BE(out, 1);       // 40: schema cookie
+                PutU32BE(out, 4);       // 44: schema format
+                PutU32BE(out, 0);       // 48: default cache size
+                PutU32BE(out, 0);       // 52: largest root page
+                PutU32BE(out, 1);       // 56: UTF-8
+                out.resize(92, '\0');  // User version, vacuum, application id, reserved
+                PutU32BE(out, 1);       // 92: version-valid-for, matches the change counter
+                PutU32BE(out, 3045000); // 96: SQLite version
+                out.push_back(0x0D);    // Table leaf
+                PutU16BE(out, 0);
+                PutU16BE(out, 0);
+                PutU16BE(out, 0);       // Content area starts at the page end (65536 reads as 0)
+                out.push_back(0);
+                out.resize(static_cast<size_t>(pages) * PAGE_SIZE, '\0');
+                break;
+            }
+            default:
+                break;
+            }
+            return out;
+        }
+
+        bool MakeDirectory(const std::wstring& path) {
+#ifdef _WIN32
+            return CreateDirectoryW(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+            return mkdir(ToUtf8(path).c_str(), 0700) == 0 || errno == EEXIST;
+#endif
+        }
+
+        bool WriteContents(const std::wstring& path, Kind kind, uint64_t size, uint64_t seed) {
+            std::FILE* file = SessionLog::OpenFile(path, "wb");
+            if (file == nullptr) {
+                return false;
+            }
+            static constexpr size_t CHUNK_BYTES = 1024 * 1024;
+            SeededBytes random(seed);
+            std::string chunk = Header(kind, size);
+            uint64_t written = 0;
+            uint64_t line = 0;
+            bool text = kind == Kind::Markdown || kind == Kind::Log || kind == Kind::Text;
+            bool ok = true;
+            while (ok && written < size) {
+                uint64_t remaining = size - written;
+                while (chunk.size() < std::min<uint64_t>(CHUNK_BYTES, remaining)) {
+                    if (text) {
+                        AppendText(chunk, kind, random, line++);
+                    } else {
+                        random.Fill(chunk, static_cast<size_t>(std::min<uint64_t>(CHUNK_BYTES, remaining) - chunk.size()));
+                    }
+                }
+                size_t length = static_cast<size_t>(std::min<uint64_t>(chunk.size(), remaining));
+                ok = std::fwrite(chunk.data(), 1, length, file) == length;
+                written += length;
+                chunk.clear();
+            }
+            return std::fclose(file) == 0 && ok;
+        }
+    }
+
+    bool ReplayFiles::Materialize(const Session& session, const std::wstring& directory,
+                                  std::vector<std::wstring>& paths, std::wstring& error) {
+        if (!MakeDirectory(directory)) {
+            error = L"Cannot create " + directory;
+            return false;
+        }
+        paths.clear();
+        for (size_t i = 0; i < session.files.size(); ++i) {
+            const SessionFile& file = session.files[i];
+#ifdef _WIN32
+            std::wstring path = directory + L"\\file" + std::to_wstring(i);
+#else
+            std::wstring path = directory + L"/file" + std::to_wstring(i);
+#endif
+            bool ok;
+            if (file.extension == L".folder") {
+                ok = MakeDirectory(path);
+            } else {
+                path += file.extension;
+                ok = WriteContents(path, KindOf(file.extension), std::min(file.size, MAX_FILE_BYTES), i + 1);
+            }
+            if (!ok) {
+                error = L"Cannot create " + path;
+                return false;
+            }
+            paths.push_back(std::move(path));
+        }
+        return true;
+    }
+
+    void ReplayFiles::Remove(const std::wstring& directory, const std::vector<std::wstring>& paths) {
+        for (const auto& path : paths) {
+#ifdef _WIN32
+            if (!DeleteFileW(path.c_str())) {
+                RemoveDirectoryW(path.c_str());
+            }
+#else
+            std::string narrow = ToUtf8(path);
+            if (unlink(narrow.c_str()) != 0) {
+                rmdir(narrow.c_str());
+            }
+#endif
+        }
+#ifdef _WIN32
+        RemoveDirectoryW(directory.c_str());
+#else
+        rmdir(ToUtf8(directory).c_str());
+#endif
+    }
+
+    std::wstring ReplayFiles::DefaultDirectory() {
+#ifdef _WIN32
+        wchar_t temp[MAX_PATH];
+        DWORD length = GetTempPathW(MAX_PATH, temp);
+        return std::wstring(temp, length) + L"lumos-replay." + std::to_wstring(GetCurrentProcessId());
+#else
+        const char* temp = std::getenv("TMPDIR");
+        return FromUtf8(temp != nullptr && *temp != '\0' ? temp : "/tmp") + L"/lumos-replay." +
+               std::to_wstring(getpid());
+#endif
+    }
+}
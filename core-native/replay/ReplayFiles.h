@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SessionLog.h"
+
+namespace Lumos {
+    // Makes up the files a session previewed: same extension and size, with
+    // contents the pipeline's engines recognize (image headers, Markdown,
+    // log lines, an empty SQLite database) and seeded bytes elsewhere, so
+    // every replay of a session reads identical files.
+    class ReplayFiles {
+    public:
+        // Larger files are cut to this; hashing a recorded 4 GB ISO would
+        // time the disk, not the pipeline
+        static constexpr uint64_t MAX_FILE_BYTES = 64ull * 1024 * 1024;
+
+        // Create `directory` and one file (or folder) per session file;
+        // `paths[i]` is where files[i] went
+        static bool Materialize(const Session& session, const std::wstring& directory,
+                                std::vector<std::wstring>& paths, std::wstring& error);
+
+        // Undo Materialize
+        static void Remove(const std::wstring& directory, const std::vector<std::wstring>& paths);
+
+        // A fresh directory for this process under the system temp directory
+        static std::wstring DefaultDirectory();
+    };
+}
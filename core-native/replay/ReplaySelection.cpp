@@ -0,0 +1,31 @@
+#include "ReplaySelection.h"
+
+namespace Lumos {
+    void ReplayCursor::Select(std::wstring_view path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path.assign(path);
+    }
+
+    void ReplayCursor::CopySelected(std::wstring& out) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.assign(m_path);
+    }
+
+    ReplaySelection::ReplaySelection(IOScheduler& ioScheduler, const ReplayCursor& cursor)
+        : SelectionResolver(ioScheduler)
+        , m_cursor(cursor)
+    {
+    }
+
+    bool ReplaySelection::Initialize() {
+        return true;
+    }
+
+    bool ReplaySelection::TryResolve(FileInfo& outInfo) {
+        m_cursor.CopySelected(m_selected);
+        if (m_selected.empty()) {
+            return false;
+        }
+        return FillFileInfo(m_selected, outInfo);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "../explorer/SelectionResolver.h"
+
+namespace Lumos {
+    // What the replayed Explorer window has selected. The harness moves it
+    // before each press; the pipeline's worker reads it while resolving.
+    class ReplayCursor {
+    public:
+        // Empty for nothing selected. Both copy into existing buffers, so
+        // the harness itself adds no allocations to a press.
+        void Select(std::wstring_view path);
+        void CopySelected(std::wstring& out) const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::wstring m_path;
+    };
+
+    // Resolves the cursor the way ExplorerIntegration resolves Explorer:
+    // same retries and deadline, same bounded stat of the file found
+    class ReplaySelection : public SelectionResolver {
+    public:
+        ReplaySelection(IOScheduler& ioScheduler, const ReplayCursor& cursor);
+
+        bool Initialize() override;
+
+    protected:
+        bool TryResolve(FileInfo& outInfo) override;
+
+    private:
+        const ReplayCursor& m_cursor;
+        std::wstring m_selected;
+    };
+}
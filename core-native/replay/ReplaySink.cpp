@@ -0,0 +1,83 @@
+#include "ReplaySink.h"
+
+namespace Lumos {
+    ReplaySink::ReplaySink()
+        : m_messages(0)
+        , m_bytes(0)
+        , m_requests(0)
+        , m_cancels(0)
+    {
+    }
+
+    bool ReplaySink::SendPreviewRequest(const PreviewRequest& request, std::pmr::memory_resource* memory) {
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        return Deliver(request, memory);
+    }
+
+    bool ReplaySink::SendCancel(uint64_t generation, std::pmr::memory_resource* memory) {
+        PreviewRequest cancel(memory);
+        cancel.type = PreviewMessageType::Cancel;
+        cancel.generation = generation;
+        m_cancels.fetch_add(1, std::memory_order_relaxed);
+        return Deliver(cancel, memory);
+    }
+
+    bool ReplaySink::SendMarkdown(uint64_t generation, const PreviewMarkdown& chunk, std::pmr::memory_resource* memory) {
+        PreviewRequest message(memory);
+        message.type = PreviewMessageType::Markdown;
+        message.generation = generation;
+        message.markdown = chunk;
+        return Deliver(message, memory);
+    }
+
+    bool ReplaySink::SendTail(uint64_t generation, const PreviewTail& tail, std::pmr::memory_resource* memory) {
+        PreviewRequest message(memory);
+        message.type = PreviewMessageType::Tail;
+        message.generation = generation;
+        message.tail = tail;
+        return Deliver(message, memory);
+    }
+
+    bool ReplaySink::SendHashes(uint64_t generation, const PreviewHashes& hashes, std::pmr::memory_resource* memory) {
+        PreviewRequest message(memory);
+        message.type = PreviewMessageType::Hashes;
+        message.generation = generation;
+        message.hashes = hashes;
+        return Deliver(message, memory);
+    }
+
+    bool ReplaySink::SendDatabase(uint64_t generation, const PreviewDatabase& database,
+                                  std::pmr::memory_resource* memory) {
+        PreviewRequest message(memory);
+        message.type = PreviewMessageType::Database;
+        message.generation = generation;
+        message.database = database;
+        return Deliver(message, memory);
+    }
+
+    bool ReplaySink::SendProvider(uint64_t generation, const PreviewProvider& provider,
+                                  std::pmr::memory_resource* memory) {
+        PreviewRequest message(memory);
+        message.type = PreviewMessageType::Provider;
+        message.generation = generation;
+        message.provider = provider;
+        return Deliver(message, memory);
+    }
+
+    ReplaySink::Stats ReplaySink::GetStats() const {
+        return {
+            m_messages.load(std::memory_order_relaxed),
+            m_bytes.load(std::memory_order_relaxed),
+            m_requests.load(std::memory_order_relaxed),
+            m_cancels.load(std::memory_order_relaxed)
+        };
+    }
+
+    bool ReplaySink::Deliver(const PreviewRequest& message, std::pmr::memory_resource* memory) {
+        std::pmr::string json(memory);
+        message.WriteJson(json);
+        m_messages.fetch_add(1, std::memory_order_relaxed);
+        m_bytes.fetch_add(json.size(), std::memory_order_relaxed);
+        return true;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include "../ipc/PreviewSink.h"
+
+namespace Lumos {
+    // Stands in for the UI's pipe: every message is serialized exactly as
+    // IPCClient would write it, then counted and dropped
+    class ReplaySink : public PreviewSink {
+    public:
+        struct Stats {
+            uint64_t messages;
+            uint64_t bytes;
+            uint64_t requests;  // Preview requests, one per press that got that far
+            uint64_t cancels;
+        };
+
+        ReplaySink();
+
+        bool SendPreviewRequest(const PreviewRequest& request,
+                                std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendCancel(uint64_t generation,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendMarkdown(uint64_t generation, const PreviewMarkdown& chunk,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendTail(uint64_t generation, const PreviewTail& tail,
+                      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendHashes(uint64_t generation, const PreviewHashes& hashes,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendDatabase(uint64_t generation, const PreviewDatabase& database,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+        bool SendProvider(uint64_t generation, const PreviewProvider& provider,
+                          std::pmr::memory_resource* memory = std::pmr::get_default_resource()) override;
+
+        Stats GetStats() const;
+
+    private:
+        bool Deliver(const PreviewRequest& message, std::pmr::memory_resource* memory);
+
+        std::atomic<uint64_t> m_messages;
+        std::atomic<uint64_t> m_bytes;
+        std::atomic<uint64_t> m_requests;
+        std::atomic<uint64_t> m_cancels;
+    };
+}
@@ -0,0 +1,188 @@
+#include "SessionLog.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <cwchar>
+#include "../common/Utf8.h"
+
+namespace Lumos {
+    namespace {
+        std::vector<std::string_view> SplitTabs(std::string_view line) {
+            std::vector<std::string_view> fields;
+            size_t start = 0;
+            while (true) {
+                size_t tab = line.find('\t', start);
+                fields.push_back(line.substr(start, tab == std::string_view::npos ? tab : tab - start));
+                if (tab == std::string_view::npos) {
+                    return fields;
+                }
+                start = tab + 1;
+            }
+        }
+
+        bool ParseNumber(std::string_view text, uint64_t& out) {
+            if (text.empty() || text.size() > 20) {
+                return false;
+            }
+            out = 0;
+            for (char c : text) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                out = out * 10 + static_cast<uint64_t>(c - '0');
+            }
+            return true;
+        }
+
+        void CopyClassName(std::string_view utf8, wchar_t (&out)[HookContext::CLASS_NAME_CHARS]) {
+            std::wstring name = FromUtf8(utf8);
+            size_t length = std::min(name.size(), HookContext::CLASS_NAME_CHARS - 1);
+            std::wmemcpy(out, name.data(), length);
+            out[length] = L'\0';
+        }
+
+        // Tabs and line breaks would break the format; class names never have them
+        std::string Field(std::wstring_view text) {
+            std::string out = ToUtf8(text);
+            for (char& c : out) {
+                if (c == '\t' || c == '\n' || c == '\r') {
+                    c = ' ';
+                }
+            }
+            return out;
+        }
+    }
+
+    std::FILE* SessionLog::OpenFile(std::wstring_view path, const char* mode) {
+#ifdef _WIN32
+        std::wstring widePath(path);
+        std::wstring wideMode(mode, mode + std::strlen(mode));
+        return _wfopen(widePath.c_str(), wideMode.c_str());
+#else
+        return std::fopen(ToUtf8(path).c_str(), mode);
+#endif
+    }
+
+    bool SessionLog::Load(std::wstring_view path, Session& out, std::wstring& error) {
+        std::FILE* file = OpenFile(path, "rb");
+        if (file == nullptr) {
+            error = L"Cannot open session " + std::wstring(path);
+            return false;
+        }
+        std::string text;
+        char buffer[16384];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            text.append(buffer, read);
+        }
+        std::fclose(file);
+
+        out = Session();
+        size_t lineNumber = 0;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            std::string_view line(text.data() + start, (end == std::string::npos ? text.size() : end) - start);
+            start = end == std::string::npos ? text.size() : end + 1;
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            auto fields = SplitTabs(line);
+            auto fail = [&](const wchar_t* what) {
+                error = std::wstring(path) + L":" + std::to_wstring(lineNumber) + L": " + what;
+                return false;
+            };
+            if (lineNumber == 1) {
+                uint64_t version;
+                if (fields.size() != 2 || fields[0] != MAGIC || !ParseNumber(fields[1], version)) {
+                    return fail(L"not a Lumos session");
+                }
+                if (version != VERSION) {
+                    return fail(L"recorded by a different Lumos version");
+                }
+                continue;
+            }
+
+            if (fields[0] == "file" && fields.size() == 4) {
+                uint64_t index;
+                SessionFile entry;
+                if (!ParseNumber(fields[1], index) || !ParseNumber(fields[3], entry.size) || index > 1000000) {
+                    return fail(L"bad file entry");
+                }
+                entry.extension = FromUtf8(fields[2]);
+                if (out.files.size() <= index) {
+                    out.files.resize(index + 1);
+                }
+                out.files[index] = std::move(entry);
+            } else if (fields[0] == "key" && fields.size() == 6) {
+                SessionKey entry;
+                uint64_t triggered;
+                uint64_t previewActive;
+                if (!ParseNumber(fields[1], entry.at) || !ParseNumber(fields[2], triggered) ||
+                    !ParseNumber(fields[5], previewActive)) {
+                    return fail(L"bad key entry");
+                }
+                entry.triggered = triggered != 0;
+                CopyClassName(fields[3], entry.context.foregroundClass);
+                CopyClassName(fields[4], entry.context.focusClass);
+                entry.context.previewActive = previewActive != 0;
+                out.keys.push_back(entry);
+            } else if (fields[0] == "select" && fields.size() == 4) {
+                SessionSelection entry;
+                uint64_t index;
+                if (!ParseNumber(fields[1], entry.at) || !ParseNumber(fields[2], entry.press)) {
+                    return fail(L"bad select entry");
+                }
+                if (fields[3] != "-") {
+                    if (!ParseNumber(fields[3], index)) {
+                        return fail(L"bad select entry");
+                    }
+                    entry.file = static_cast<int64_t>(index);
+                }
+                out.selections.push_back(entry);
+            } else {
+                return fail(L"unknown entry");
+            }
+        }
+
+        if (lineNumber == 0) {
+            error = std::wstring(path) + L": empty session";
+            return false;
+        }
+        for (const auto& selection : out.selections) {
+            if (selection.file != SessionSelection::NONE &&
+                static_cast<uint64_t>(selection.file) >= out.files.size()) {
+                error = std::wstring(path) + L": selection of an unknown file";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SessionLog::WriteHeader(std::FILE* file) {
+        std::fprintf(file, "%s\t%d\n", MAGIC, VERSION);
+    }
+
+    void SessionLog::WriteFile(std::FILE* file, size_t index, const SessionFile& entry) {
+        std::fprintf(file, "file\t%zu\t%s\t%" PRIu64 "\n", index, Field(entry.extension).c_str(), entry.size);
+    }
+
+    void SessionLog::WriteKey(std::FILE* file, const SessionKey& entry) {
+        std::fprintf(file, "key\t%" PRIu64 "\t%d\t%s\t%s\t%d\n", entry.at, entry.triggered ? 1 : 0,
+                     Field(entry.context.foregroundClass).c_str(), Field(entry.context.focusClass).c_str(),
+                     entry.context.previewActive ? 1 : 0);
+    }
+
+    void SessionLog::WriteSelection(std::FILE* file, const SessionSelection& entry) {
+        if (entry.file == SessionSelection::NONE) {
+            std::fprintf(file, "select\t%" PRIu64 "\t%" PRIu64 "\t-\n", entry.at, entry.press);
+        } else {
+            std::fprintf(file, "select\t%" PRIu64 "\t%" PRIu64 "\t%" PRId64 "\n", entry.at, entry.press, entry.file);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../hooks/HookGuard.h"
+
+namespace Lumos {
+    // A file the session previewed. Only what the pipeline's choices depend
+    // on is kept (no names or contents); the replay makes up a file like it.
+    struct SessionFile {
+        std::wstring extension;  // ".folder" for folders, as in FileInfo
+        uint64_t size = 0;
+    };
+
+    // One Spacebar key-down as the hook saw it
+    struct SessionKey {
+        uint64_t at = 0;         // Microseconds since the session started
+        HookContext context;
+        bool triggered = false;  // What HookGuard decided when recorded
+    };
+
+    // What the selection resolved to for a press
+    struct SessionSelection {
+        static constexpr int64_t NONE = -1;
+
+        uint64_t at = 0;
+        uint64_t press = 0;      // Index among the triggered keys
+        int64_t file = NONE;     // Index into Session::files
+    };
+
+    struct Session {
+        std::vector<SessionFile> files;
+        std::vector<SessionKey> keys;
+        std::vector<SessionSelection> selections;
+    };
+
+    // Sessions are tab-separated text, one entry per line, so they diff
+    // well when checked in next to a baseline:
+    //
+    //   lumos-session  1
+    //   file    <index>  <extension>  <size>
+    //   key     <us>     <triggered>  <foreground class>  <focus class>  <preview active>
+    //   select  <us>     <press>      <file index or ->
+    //
+    // Entries may come in any order; a recorder appends them as it flushes.
+    class SessionLog {
+    public:
+        static constexpr const char* MAGIC = "lumos-session";
+        static constexpr int VERSION = 1;
+
+        // UTF-8 on every platform; _wfopen on Windows
+        static std::FILE* OpenFile(std::wstring_view path, const char* mode);
+
+        static bool Load(std::wstring_view path, Session& out, std::wstring& error);
+
+        static void WriteHeader(std::FILE* file);
+        static void WriteFile(std::FILE* file, size_t index, const SessionFile& entry);
+        static void WriteKey(std::FILE* file, const SessionKey& entry);
+        static void WriteSelection(std::FILE* file, const SessionSelection& entry);
+    };
+}
@@ -0,0 +1,133 @@
+#include "SessionRecorder.h"
+
+namespace Lumos {
+    SessionRecorder::SessionRecorder()
+        : m_file(nullptr)
+        , m_start(std::chrono::steady_clock::now())
+        , m_presses(0)
+    {
+        m_keys.reserve(RESERVED_KEYS);
+    }
+
+    SessionRecorder::~SessionRecorder() {
+        Close();
+    }
+
+    bool SessionRecorder::Open(std::wstring_view path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file != nullptr) {
+            return true;
+        }
+        m_file = SessionLog::OpenFile(path, "wb");
+        if (m_file == nullptr) {
+            return false;
+        }
+        SessionLog::WriteHeader(m_file);
+        std::fflush(m_file);
+        m_start = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    void SessionRecorder::Close() {
+        Flush();
+        std::lock_guard<std::mutex> writing(m_writeMutex);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file != nullptr) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    void SessionRecorder::RecordKey(const HookContext& context, bool triggered) {
+        SessionKey key;
+        key.at = Elapsed();
+        key.context = context;
+        key.triggered = triggered;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file == nullptr) {
+            return;
+        }
+        m_keys.push_back(key);
+        if (triggered) {
+            ++m_presses;
+        }
+    }
+
+    void SessionRecorder::RecordSelection(const std::optional<FileInfo>& file) {
+        SessionSelection selection;
+        selection.at = Elapsed();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file == nullptr) {
+            return;
+        }
+        // The press being resolved is the newest one; older ones were superseded
+        selection.press = m_presses > 0 ? m_presses - 1 : 0;
+        if (file) {
+            auto [entry, added] = m_fileIndex.emplace(std::wstring(file->path), m_fileIndex.size());
+            if (added) {
+                SessionFile recorded;
+                recorded.extension.assign(file->extension);
+                recorded.size = file->size;
+                m_files.emplace_back(entry->second, std::move(recorded));
+            }
+            selection.file = static_cast<int64_t>(entry->second);
+        }
+        m_selections.push_back(selection);
+    }
+
+    void SessionRecorder::Flush() {
+        std::vector<std::pair<size_t, SessionFile>> files;
+        std::vector<SessionKey> keys;
+        std::vector<SessionSelection> selections;
+        std::FILE* file;
+        std::lock_guard<std::mutex> writing(m_writeMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            file = m_file;
+            if (file == nullptr || (m_files.empty() && m_keys.empty() && m_selections.empty())) {
+                return;
+            }
+            files.swap(m_files);
+            keys.swap(m_keys);
+            selections.swap(m_selections);
+            m_keys.reserve(RESERVED_KEYS);
+        }
+
+        for (const auto& entry : files) {
+            SessionLog::WriteFile(file, entry.first, entry.second);
+        }
+        for (const auto& key : keys) {
+            SessionLog::WriteKey(file, key);
+        }
+        for (const auto& selection : selections) {
+            SessionLog::WriteSelection(file, selection);
+        }
+        std::fflush(file);
+    }
+
+    uint64_t SessionRecorder::Elapsed() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    RecordingSelection::RecordingSelection(std::unique_ptr<SelectionSource> inner, SessionRecorder& recorder)
+        : m_inner(std::move(inner))
+        , m_recorder(recorder)
+    {
+    }
+
+    bool RecordingSelection::Initialize() {
+        return m_inner->Initialize();
+    }
+
+    std::optional<FileInfo> RecordingSelection::GetSelectedFile(std::pmr::memory_resource* memory,
+                                                                const CancellationToken& cancellation) {
+        auto file = m_inner->GetSelectedFile(memory, cancellation);
+        if (!cancellation.IsCancellationRequested()) {
+            m_recorder.RecordSelection(file);
+        }
+        return file;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SessionLog.h"
+#include "../explorer/SelectionSource.h"
+
+namespace Lumos {
+    // Records a live session for lumos-replay: every Spacebar key-down with
+    // the window classes the hook guard looked at, and what each press's
+    // selection resolved to. Paths never reach the file; a file is its
+    // extension and size. Entries are buffered and written by Flush, which
+    // the metrics sampler calls once a second, so the hook only appends.
+    class SessionRecorder {
+    public:
+        SessionRecorder();
+        ~SessionRecorder();
+
+        SessionRecorder(const SessionRecorder&) = delete;
+        SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+        // Create (truncate) the session file and write its header
+        bool Open(std::wstring_view path);
+        void Close();
+
+        // Keyboard hook thread
+        void RecordKey(const HookContext& context, bool triggered);
+
+        // Pipeline worker thread, once per resolved press
+        void RecordSelection(const std::optional<FileInfo>& file);
+
+        void Flush();
+
+    private:
+        uint64_t Elapsed() const;
+
+        // Room for a burst of presses between flushes without growing inside the hook
+        static constexpr size_t RESERVED_KEYS = 256;
+
+        std::mutex m_writeMutex;  // Held while writing; never taken by the hook
+        std::mutex m_mutex;
+        std::FILE* m_file;
+        std::chrono::steady_clock::time_point m_start;
+        uint64_t m_presses;
+        std::unordered_map<std::wstring, size_t> m_fileIndex;
+
+        // Not yet written
+        std::vector<std::pair<size_t, SessionFile>> m_files;
+        std::vector<SessionKey> m_keys;
+        std::vector<SessionSelection> m_selections;
+    };
+
+    // Passes another source's selections through and records them
+    class RecordingSelection : public SelectionSource {
+    public:
+        RecordingSelection(std::unique_ptr<SelectionSource> inner, SessionRecorder& recorder);
+
+        bool Initialize() override;
+        std::optional<FileInfo> GetSelectedFile(std::pmr::memory_resource* memory,
+                                                const CancellationToken& cancellation = {}) override;
+
+    private:
+        std::unique_ptr<SelectionSource> m_inner;
+        SessionRecorder& m_recorder;
+    };
+}
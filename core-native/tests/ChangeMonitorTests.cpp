@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "Check.h"
+#include "../cache/ChangeMonitor.h"
+#include "../cache/PreviewCache.h"
+#include "../io/IOScheduler.h"
+#include "../memory/MemoryGovernor.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+namespace {
+    std::wstring Touch(std::string_view name, std::string_view text = "x") {
+        std::string path = Test::ScratchPath(name);
+        std::ofstream(path, std::ios::binary | std::ios::app).write(text.data(), static_cast<std::streamsize>(text.size()));
+        return FromUtf8(path);
+    }
+
+    template <typename Predicate>
+    bool Eventually(Predicate done) {
+        auto giveUp = std::chrono::steady_clock::now() + 5s;
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > giveUp) {
+                return false;
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        return true;
+    }
+
+    // Every batch the monitor delivered
+    class RecordingSubscriber : public ChangeSubscriber {
+    public:
+        void OnChanges(const ChangeBatch& batch) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batches.push_back(batch);
+        }
+
+        void CollectWatched(std::wstring_view, std::vector<WatchedFile>&) override {}
+
+        // A file written across a batch boundary is in both batches
+        size_t DistinctPaths() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::set<std::wstring> paths;
+            for (const ChangeBatch& batch : m_batches) {
+                paths.insert(batch.paths.begin(), batch.paths.end());
+            }
+            return paths.size();
+        }
+
+        // Whether a batch named `path` as possibly a removed directory
+        bool SawRemovedTree(const std::wstring& path) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const ChangeBatch& batch : m_batches) {
+                if (std::find(batch.removedTrees.begin(), batch.removedTrees.end(), path) != batch.removedTrees.end()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        size_t Batches() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_batches.size();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<ChangeBatch> m_batches;
+    };
+
+    std::shared_ptr<const int> Value(int value) {
+        return std::make_shared<const int>(value);
+    }
+}
+
+LUMOS_TEST(CacheHitsOnlyWhileTheStampMatches) {
+    MemoryGovernor governor;
+    PreviewCache cache(governor, "cache");
+    REQUIRE(cache.Put(CacheKind::ImageHeader, L"/a/photo.jpg", 100, 7, Value(1), 64));
+    REQUIRE(cache.Put(CacheKind::FileHashes, L"/a/photo.jpg", 100, 7, Value(2), 64));
+
+    auto header = cache.Get<int>(CacheKind::ImageHeader, L"/a/photo.jpg", 100, 7);
+    REQUIRE(header != nullptr);
+    CHECK_EQ(*header, 1);
+    CHECK_EQ(*cache.Get<int>(CacheKind::FileHashes, L"/a/photo.jpg", 100, 7), 2);
+    CHECK(cache.Get<int>(CacheKind::EmbeddedPreview, L"/a/photo.jpg", 100, 7) == nullptr);
+
+    // Rewritten since: the stale entry goes on lookup
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, L"/a/photo.jpg", 100, 8) == nullptr);
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, L"/a/photo.jpg", 100, 7) == nullptr);
+
+    PreviewCacheStats stats = cache.Stats();
+    CHECK_EQ(stats.hits, 2u);
+    CHECK_EQ(stats.entries, 1u);
+    CHECK_EQ(governor.TotalCharged(), stats.bytes);
+}
+
+LUMOS_TEST(CacheInvalidatesPathsAndTrees) {
+    MemoryGovernor governor;
+    PreviewCache cache(governor, "cache");
+    cache.Put(CacheKind::ImageHeader, L"/a/one.jpg", 1, 1, Value(1), 8);
+    cache.Put(CacheKind::FileHashes, L"/a/one.jpg", 1, 1, Value(1), 8);
+    cache.Put(CacheKind::ImageHeader, L"/a/b/two.jpg", 1, 1, Value(2), 8);
+    cache.Put(CacheKind::ImageHeader, L"/ab/three.jpg", 1, 1, Value(3), 8);
+
+    cache.Invalidate(L"/a/one.jpg");
+    CHECK_EQ(cache.Stats().entries, 2u);
+
+    // "/ab" is not beneath "/a"
+    cache.InvalidateUnder(L"/a");
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, L"/a/b/two.jpg", 1, 1) == nullptr);
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, L"/ab/three.jpg", 1, 1) != nullptr);
+
+    std::vector<WatchedFile> watched;
+    cache.CollectWatched(L"/ab", watched);
+    REQUIRE(watched.size() == 1);
+    CHECK(watched[0].path == L"/ab/three.jpg");
+
+    cache.Clear();
+    CHECK_EQ(governor.TotalCharged(), 0u);
+}
+
+LUMOS_TEST(CacheGivesWayUnderPressure) {
+    MemoryGovernor governor;
+    PreviewCache cache(governor, "cache");
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(cache.Put(CacheKind::Generic, L"/f" + std::to_wstring(i), 1, 1, Value(i), 10000));
+    }
+    size_t before = cache.Stats().bytes;
+
+    // Lowering the budget reclaims the least recently used entries
+    cache.Get<int>(CacheKind::Generic, L"/f0", 1, 1);
+    governor.SetBudget(before / 2);
+    CHECK(governor.TotalCharged() <= before / 2);
+    CHECK(cache.Get<int>(CacheKind::Generic, L"/f0", 1, 1) != nullptr);
+    CHECK(cache.Get<int>(CacheKind::Generic, L"/f1", 1, 1) == nullptr);
+
+    // Larger than the whole budget: refused
+    CHECK(!cache.Put(CacheKind::Generic, L"/huge", 1, 1, Value(0), before));
+}
+
+LUMOS_TEST(MonitorDropsChangedFiles) {
+    IOScheduler io;
+    MemoryGovernor governor;
+    PreviewCache cache(governor, "cache");
+    ChangeMonitor monitor(io);
+    monitor.Subscribe(cache);
+    REQUIRE(monitor.Start());
+
+    std::wstring path = Touch("photo.jpg");
+    std::wstring other = Touch("other.jpg");
+    cache.Put(CacheKind::ImageHeader, path, 1, 1, Value(1), 8);
+    cache.Put(CacheKind::ImageHeader, other, 1, 1, Value(2), 8);
+    monitor.WatchDirectoryOf(path);
+    REQUIRE(Eventually([&] { return monitor.Stats().directories == 1; }));
+
+    Touch("photo.jpg", "more");
+    REQUIRE(Eventually([&] { return cache.Stats().invalidated == 1; }));
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, path, 1, 1) == nullptr);
+    CHECK(cache.Get<int>(CacheKind::ImageHeader, other, 1, 1) != nullptr);
+}
+
+LUMOS_TEST(MonitorCoalescesBursts) {
+    IOScheduler io;
+    ChangeMonitor monitor(io);
+    RecordingSubscriber subscriber;
+    monitor.Subscribe(subscriber);
+    REQUIRE(monitor.Start());
+    monitor.WatchDirectoryOf(Touch("first"));
+    REQUIRE(Eventually([&] { return monitor.Stats().directories == 1; }));
+
+    // An unzip: many files, each written in several steps
+    constexpr int FILES = 200;
+    for (int i = 0; i < FILES; ++i) {
+        std::string name = "burst" + std::to_string(i);
+        Touch(name, "a");
+        Touch(name, "b");
+    }
+    REQUIRE(Eventually([&] { return subscriber.DistinctPaths() >= FILES; }));
+    CHECK_EQ(subscriber.DistinctPaths(), static_cast<size_t>(FILES));
+    CHECK(subscriber.Batches() < static_cast<size_t>(FILES) / 10);
+
+    ChangeMonitorStats stats = monitor.Stats();
+    CHECK(stats.events >= static_cast<uint64_t>(FILES));
+    CHECK(stats.maxLatencyUs > 0);
+}
+
+LUMOS_TEST(MonitorReportsRemovedFolders) {
+    IOScheduler io;
+    ChangeMonitor monitor(io);
+    RecordingSubscriber subscriber;
+    monitor.Subscribe(subscriber);
+    REQUIRE(monitor.Start());
+
+    std::filesystem::create_directory(Test::ScratchPath("album"));
+    Touch("album/one.jpg");
+    monitor.WatchDirectoryOf(Touch("top.jpg"));
+    REQUIRE(Eventually([&] { return monitor.Stats().directories == 1; }));
+
+    std::filesystem::remove_all(Test::ScratchPath("album"));
+    std::wstring album = FromUtf8(Test::ScratchPath("album"));
+    CHECK(Eventually([&] { return subscriber.SawRemovedTree(album); }));
+}
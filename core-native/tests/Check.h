@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "../common/Utf8.h"
+
+// A deliberately small test harness: every test executable links
+// TestMain.cpp, and each LUMOS_TEST case runs in registration order.
+// CHECK records a failure and carries on; REQUIRE stops the case.
+//
+//   LUMOS_TEST(ProbeReadsPngSize) {
+//       REQUIRE(ImageHeaderProbe::Probe(bytes, header));
+//       CHECK_EQ(header.width, 640u);
+//   }
+namespace Lumos::Test {
+    using CaseFunction = void (*)();
+
+    struct Registration {
+        Registration(const char* name, CaseFunction run);
+    };
+
+    // Thrown by REQUIRE; TestMain catches it and moves to the next case
+    struct Stop {};
+
+    void Fail(const char* file, int line, const std::wstring& message);
+
+    // The directory a case may write to; emptied before each case
+    std::wstring ScratchDirectory();
+    std::string ScratchPath(std::string_view name);
+
+    // A checked-in fixture under tests/data, read whole; empty if missing
+    std::vector<uint8_t> ReadData(std::string_view name);
+
+    template <typename T>
+    std::wstring Describe(const T& value) {
+        if constexpr (std::is_enum_v<T>) {
+            return std::to_wstring(static_cast<long long>(value));
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return value ? L"true" : L"false";
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            std::wostringstream text;
+            text << +value;
+            return text.str();
+        } else if constexpr (std::is_convertible_v<const T&, std::wstring_view>) {
+            return L"\"" + std::wstring(std::wstring_view(value)) + L"\"";
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            return L"\"" + FromUtf8(std::string_view(value)) + L"\"";
+        } else {
+            return L"?";
+        }
+    }
+
+    template <typename A, typename B>
+    bool CheckEqual(const A& actual, const B& expected, const char* expression, const char* file, int line) {
+        if (actual == expected) {
+            return true;
+        }
+        Fail(file, line, FromUtf8(expression) + L": got " + Describe(actual) + L", expected " + Describe(expected));
+        return false;
+    }
+}
+
+#define LUMOS_TEST_CONCAT_(a, b) a##b
+#define LUMOS_TEST(name)                                                                                   \
+    static void name();                                                                                    \
+    static ::Lumos::Test::Registration LUMOS_TEST_CONCAT_(name, _registration)(#name, &name);             \
+    static void name()
+
+#define CHECK(condition)                                                                                   \
+    ((condition) ? true : (::Lumos::Test::Fail(__FILE__, __LINE__, ::Lumos::FromUtf8("CHECK(" #condition ")")), false))
+
+#define CHECK_EQ(actual, expected)                                                                         \
+    ::Lumos::Test::CheckEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
+
+#define REQUIRE(condition)                                                                                 \
+    do {                                                                                                   \
+        if (!(condition)) {                                                                                \
+            ::Lumos::Test::Fail(__FILE__, __LINE__, ::Lumos::FromUtf8("REQUIRE(" #condition ")"));        \
+            throw ::Lumos::Test::Stop();                                                                   \
+        }                                                                                                  \
+    } while (false)
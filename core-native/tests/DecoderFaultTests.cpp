@@ -0,0 +1,185 @@
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "../worker/DecoderPool.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+// Linked against lumos-core-faults, so the workers (this executable, as in
+// DecoderPoolTests) serve the Test* jobs of WorkerProtocol.h
+namespace {
+    DecoderJob Job(WorkerJobKind kind, uint64_t affinity = 0, uint64_t value = 0) {
+        DecoderJob job;
+        job.kind = kind;
+        job.affinity = affinity;
+        job.values[0] = value;
+        return job;
+    }
+
+    // Process id of the worker that answers for `affinity`; 0 if none did
+    uint64_t EchoPid(DecoderPool& pool, uint64_t affinity) {
+        uint64_t pid = 0;
+        DecoderStatus status = pool.Run(Job(WorkerJobKind::TestEcho, affinity), CancellationToken(),
+                                        [&](const DecoderReply& reply) {
+            pid = reply.values[0];
+            return true;
+        });
+        return status == DecoderStatus::Ok ? pid : 0;
+    }
+
+    // Every worker launched, so routing is by affinity alone
+    bool WaitForLaunches(DecoderPool& pool, uint64_t launches) {
+        auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (pool.GetStats().launches < launches) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        return true;
+    }
+
+    std::chrono::milliseconds Since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+}
+
+LUMOS_TEST(CrashedWorkerIsRelaunched) {
+    DecoderPool pool(1);
+    pool.Start();
+    uint64_t first = EchoPid(pool, 0);
+    REQUIRE(first != 0);
+
+    CHECK(pool.Run(Job(WorkerJobKind::TestCrash), CancellationToken(), nullptr) == DecoderStatus::Crashed);
+    CHECK(pool.Run(Job(WorkerJobKind::TestExit, 0, 3), CancellationToken(), nullptr) == DecoderStatus::Crashed);
+
+    // The next job waits for the replacement rather than failing
+    uint64_t replacement = EchoPid(pool, 0);
+    CHECK(replacement != 0);
+    CHECK(replacement != first);
+
+    DecoderPool::Stats stats = pool.GetStats();
+    CHECK_EQ(stats.crashes, 2u);
+    CHECK_EQ(stats.timeouts, 0u);
+    CHECK_EQ(stats.launches, 3u);
+}
+
+LUMOS_TEST(HungWorkerTimesOutAndIsRelaunched) {
+    DecoderPool pool(1);
+    pool.Start();
+    uint64_t first = EchoPid(pool, 0);
+    REQUIRE(first != 0);
+
+    DecoderJob hang = Job(WorkerJobKind::TestHang);
+    hang.timeout = 200ms;
+    auto start = std::chrono::steady_clock::now();
+    CHECK(pool.Run(hang, CancellationToken(), nullptr) == DecoderStatus::TimedOut);
+    CHECK(Since(start) >= 150ms);
+    CHECK(Since(start) < 2000ms);
+
+    uint64_t replacement = EchoPid(pool, 0);
+    CHECK(replacement != 0);
+    CHECK(replacement != first);
+    CHECK_EQ(pool.GetStats().timeouts, 1u);
+    CHECK_EQ(pool.GetStats().crashes, 0u);
+}
+
+// A worker that honours the flag stops early and stays up
+LUMOS_TEST(CancellationStopsAJob) {
+    DecoderPool pool(1);
+    pool.Start();
+    uint64_t first = EchoPid(pool, 0);
+    REQUIRE(first != 0);
+
+    CancellationSource source;
+    std::thread canceller([&source] {
+        std::this_thread::sleep_for(50ms);
+        source.Cancel();
+    });
+    DecoderJob spin = Job(WorkerJobKind::TestSpin, 0, 10'000'000);
+    spin.timeout = 20s;
+    auto start = std::chrono::steady_clock::now();
+    CHECK(pool.Run(spin, source.Token(), nullptr) == DecoderStatus::Ok);
+    CHECK(Since(start) < 5000ms);
+    canceller.join();
+
+    CHECK_EQ(EchoPid(pool, 0), first);
+    CHECK_EQ(pool.GetStats().launches, 1u);
+}
+
+// One that ignores it gets CANCEL_GRACE, not the job's whole timeout
+LUMOS_TEST(CancelledHangIsKilledAfterTheGrace) {
+    DecoderPool pool(1);
+    pool.Start();
+    REQUIRE(EchoPid(pool, 0) != 0);
+
+    CancellationSource source;
+    std::thread canceller([&source] {
+        std::this_thread::sleep_for(50ms);
+        source.Cancel();
+    });
+    DecoderJob hang = Job(WorkerJobKind::TestHang);
+    hang.timeout = 20s;
+    auto start = std::chrono::steady_clock::now();
+    CHECK(pool.Run(hang, source.Token(), nullptr) == DecoderStatus::TimedOut);
+    CHECK(Since(start) < 5000ms);
+    canceller.join();
+
+    CHECK(EchoPid(pool, 0) != 0);
+    CHECK_EQ(pool.GetStats().timeouts, 1u);
+}
+
+LUMOS_TEST(AffinityKeepsJobsOnOneWorker) {
+    DecoderPool pool(4);
+    pool.Start();
+    REQUIRE(WaitForLaunches(pool, 4));
+
+    std::vector<uint64_t> owners;
+    std::set<uint64_t> workers;
+    for (uint64_t key = 0; key < 32; ++key) {
+        owners.push_back(EchoPid(pool, key));
+        REQUIRE(owners.back() != 0);
+        workers.insert(owners.back());
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            CHECK_EQ(EchoPid(pool, key), owners.back());
+        }
+    }
+    CHECK(workers.size() > 1);
+    CHECK_EQ(pool.GetStats().spilled, 0u);
+
+    // Losing key 0's worker moves only its keys, and they come back to the
+    // replacement in the same slot
+    REQUIRE(pool.Run(Job(WorkerJobKind::TestCrash, 0), CancellationToken(), nullptr) == DecoderStatus::Crashed);
+    REQUIRE(WaitForLaunches(pool, 5));
+    for (uint64_t key = 0; key < owners.size(); ++key) {
+        uint64_t pid = EchoPid(pool, key);
+        if (owners[key] == owners[0]) {
+            CHECK(pid != owners[0]);
+        } else {
+            CHECK_EQ(pid, owners[key]);
+        }
+    }
+}
+
+LUMOS_TEST(BusyFirstChoiceSpills) {
+    DecoderPool pool(2);
+    pool.Start();
+    REQUIRE(WaitForLaunches(pool, 2));
+    uint64_t owner = EchoPid(pool, 7);
+    REQUIRE(owner != 0);
+
+    std::thread busy([&pool] {
+        pool.Run(Job(WorkerJobKind::TestSpin, 7, 500'000), CancellationToken(), nullptr);
+    });
+    std::this_thread::sleep_for(100ms);
+    uint64_t other = EchoPid(pool, 7);
+    busy.join();
+
+    CHECK(other != 0);
+    CHECK(other != owner);
+    CHECK_EQ(pool.GetStats().spilled, 1u);
+    CHECK_EQ(EchoPid(pool, 7), owner);
+}
@@ -0,0 +1,479 @@
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include "Check.h"
+#include "TestImages.h"
+#include "../engines/font/FontSpecimen.h"
+#include "../engines/font/GlyphCache.h"
+#include "../engines/markdown/MarkdownParser.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../ipc/SharedMemory.h"
+#include "../plugins/ProviderLoader.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../worker/DecoderJobs.h"
+
+using namespace Lumos;
+
+// The workers are this executable: TestMain serves --decode-worker. Crashes,
+// hangs and cancellation are in DecoderFaultTests.cpp.
+namespace {
+    ByteView View(const TestImages::Bytes& bytes) {
+        return ByteView(bytes.data(), bytes.size());
+    }
+
+    std::wstring WriteFile(const char* name, const std::string& contents) {
+        std::filesystem::create_directories(Test::ScratchDirectory());
+        std::string path = Test::ScratchPath(name);
+        std::ofstream(path, std::ios::binary) << contents;
+        return FromUtf8(path);
+    }
+
+    std::wstring WriteFile(const char* name, const std::vector<uint8_t>& contents) {
+        return WriteFile(name, std::string(contents.begin(), contents.end()));
+    }
+
+    DecoderFile FileAt(const std::wstring& path, uint64_t size) {
+        DecoderFile file;
+        file.path = path;
+        file.size = size;
+        return file;
+    }
+
+    // What the pipeline would send of a Markdown file, one string per chunk
+    struct MarkdownChunks {
+        bool Add(const MarkdownDocument& chunk, bool complete, bool truncated) {
+            std::pmr::string json;
+            chunk.WriteJson(json);
+            chunks.emplace_back(json);
+            this->complete = complete;
+            this->truncated = truncated;
+            return true;
+        }
+
+        std::vector<std::string> chunks;
+        bool complete = false;
+        bool truncated = false;
+    };
+
+    // And of a database: the schema, then each table
+    struct DatabaseMessages {
+        bool Schema(const SqliteSchema& schema, size_t tableCount) {
+            std::pmr::string json;
+            schema.WriteJson(json);
+            messages.emplace_back(json);
+            tables = tableCount;
+            return true;
+        }
+
+        bool Table(const SqliteRows* rows, bool isLast) {
+            std::pmr::string json;
+            if (rows) {
+                rows->WriteJson(json);
+            }
+            messages.emplace_back(json);
+            last = isLast;
+            return true;
+        }
+
+        std::vector<std::string> messages;
+        size_t tables = 0;
+        bool last = false;
+    };
+
+    struct Sample {
+        Sample() {
+            std::wstring error;
+            auto library = ProviderLibrary::Load(FromUtf8(LUMOS_SAMPLE_PROVIDER), error);
+            const LumosProviderInfo* info = library ? library->Info() : nullptr;
+            loaded = info && registry.Add(info, std::move(library));
+        }
+
+        const NativeProvider& Provider() const { return *registry.Providers()[0]; }
+
+        ProviderRegistry registry;
+        bool loaded;
+    };
+}
+
+LUMOS_TEST(DisabledPoolProbesInProcess) {
+    DecoderPool pool(0);
+    pool.Start();
+    CHECK_EQ(pool.WorkerCount(), 0u);
+
+    DecoderJob job;
+    job.kind = WorkerJobKind::ImageProbe;
+    CHECK(pool.Run(job, CancellationToken(), nullptr) == DecoderStatus::Unavailable);
+
+    TestImages::Bytes png = TestImages::Png(640, 480);
+    ImageHeader header;
+    CHECK(DecoderJobs::ProbeImage(pool, View(png), 1, CancellationToken(), header) == ProbeStatus::Ok);
+    CHECK_EQ(header.width, 640u);
+    CHECK_EQ(pool.GetStats().jobs, 0u);
+}
+
+LUMOS_TEST(WorkersProbeImages) {
+    DecoderPool pool(2);
+    pool.Start();
+    REQUIRE(pool.WorkerCount() == 2);
+
+    TestImages::Bytes png = TestImages::Png(640, 480);
+    TestImages::Bytes jpeg = TestImages::Jpeg(300, 200, 6);
+    for (uint64_t affinity = 0; affinity < 8; ++affinity) {
+        ImageHeader header;
+        REQUIRE(DecoderJobs::ProbeImage(pool, View(png), affinity, CancellationToken(), header) == ProbeStatus::Ok);
+        CHECK(header.format == ImageFormat::Png);
+        CHECK_EQ(header.height, 480u);
+
+        REQUIRE(DecoderJobs::ProbeImage(pool, View(jpeg), affinity, CancellationToken(), header) == ProbeStatus::Ok);
+        CHECK_EQ(header.width, 300u);
+        CHECK_EQ(header.orientation, 6);
+    }
+
+    ImageHeader header;
+    TestImages::Bytes text(100, 'x');
+    CHECK(DecoderJobs::ProbeImage(pool, View(text), 0, CancellationToken(), header) == ProbeStatus::Unrecognized);
+    CHECK(DecoderJobs::ProbeImage(pool, ByteView(), 0, CancellationToken(), header) == ProbeStatus::NeedMoreData);
+
+    DecoderPool::Stats stats = pool.GetStats();
+    CHECK_EQ(stats.jobs, 18u);
+    CHECK_EQ(stats.crashes, 0u);
+    CHECK(stats.launches >= 1 && stats.launches <= 2);
+}
+
+LUMOS_TEST(WorkersRunProviders) {
+    Sample sample;
+    REQUIRE(sample.loaded);
+    DecoderPool pool(1);
+    pool.Start();
+
+    std::string ppm = "P6\n# from a worker\n3 2\n255\n" + std::string(10, '\x7F');
+    DecoderFile file;
+    std::wstring path = WriteFile("short.ppm", ppm);
+    file.path = path;
+    file.extension = L".ppm";
+    file.size = ppm.size();
+
+    std::vector<std::string> batches;
+    size_t rows = 0;
+    size_t batchCount = 0;
+    LumosPreviewResult result = DecoderJobs::RunProvider(pool, sample.Provider(), file, CancellationToken(),
+                                                         [&](const ProviderBatch& batch) {
+        batches.emplace_back(batch.rowsJson);
+        return true;
+    }, rows, batchCount);
+    CHECK(result == LUMOS_PREVIEW_OK);
+    CHECK_EQ(batchCount, 1u);
+    REQUIRE(batches.size() == 1);
+    CHECK(batches[0].find("{\"name\":\"Dimensions\",\"value\":\"3 x 2\"}") != std::string::npos);
+    CHECK(batches[0].find("{\"name\":\"Raster\",\"value\":\"Truncated\"}") != std::string::npos);
+    CHECK(rows >= 6);
+
+    // Not a Netpbm file after all
+    std::wstring other = WriteFile("text.ppm", "plain text");
+    file.path = other;
+    file.size = 10;
+    batches.clear();
+    result = DecoderJobs::RunProvider(pool, sample.Provider(), file, CancellationToken(),
+                                      [&](const ProviderBatch& batch) {
+        batches.emplace_back(batch.rowsJson);
+        return true;
+    }, rows, batchCount);
+    CHECK(result == LUMOS_PREVIEW_UNSUPPORTED);
+    CHECK(batches.empty());
+}
+
+LUMOS_TEST(ProviderArgumentsRoundTrip) {
+    std::string encoded = DecoderJobs::EncodeProviderArguments(L"/p/netpbm.so", L"/d/é.ppm", L".ppm");
+    DecoderJobs::ProviderArguments arguments;
+    REQUIRE(DecoderJobs::DecodeProviderArguments(encoded, arguments));
+    CHECK_EQ(arguments.library, "/p/netpbm.so");
+    CHECK_EQ(arguments.path, "/d/\xC3\xA9.ppm");
+    CHECK_EQ(arguments.extension, ".ppm");
+
+    CHECK(!DecoderJobs::DecodeProviderArguments(std::string_view("lib\0path", 8), arguments));
+    CHECK(!DecoderJobs::DecodeProviderArguments(std::string_view("lib\0path\0ext\0more", 17), arguments));
+    CHECK(!DecoderJobs::DecodeProviderArguments(std::string_view("\0path\0ext", 9), arguments));
+}
+
+LUMOS_TEST(ProviderRowsAreChecked) {
+    CHECK(DecoderJobs::IsProviderRows("[]", 0));
+    CHECK(DecoderJobs::IsProviderRows("[{\"name\":\"Size\",\"value\":\"3 x 2\"}]", 1));
+    CHECK(DecoderJobs::IsProviderRows("[{\"name\":\"a\\\"b\\\\\",\"value\":\"\\n\\t\\u001f\xC3\xA9\"},"
+                                      "{\"name\":\"\",\"value\":\"\"}]", 2));
+
+    // The count must match, and nothing but rows may ride along
+    CHECK(!DecoderJobs::IsProviderRows("[]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"a\",\"value\":\"b\"}]", 0));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"a\",\"value\":\"b\"}],\"x\":1", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"a\",\"value\":\"b\",\"x\":1}]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"a\",\"value\":\"b", 1));
+    CHECK(!DecoderJobs::IsProviderRows("", 0));
+
+    // Strings the UI's parser would reject
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"a\nb\",\"value\":\"\"}]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"\\x\",\"value\":\"\"}]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"\\ud800\",\"value\":\"\"}]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"\xC3\",\"value\":\"\"}]", 1));
+    CHECK(!DecoderJobs::IsProviderRows("[{\"name\":\"\\\",\"value\":\"\"}]", 1));
+}
+
+LUMOS_TEST(WorkersFindEmbeddedPreviews) {
+    DecoderPool pool(1);
+    pool.Start();
+
+    TestImages::Bytes raw = TestImages::RawWithPreviews(160, 2048, 8);
+    std::wstring path = WriteFile("camera.dng", raw);
+    EmbeddedPreview preview;
+    REQUIRE(DecoderJobs::FindEmbeddedPreview(pool, FileAt(path, raw.size()), 1920, 0, CancellationToken(), preview) ==
+            DecoderStatus::Ok);
+    auto expected = EmbeddedPreviewFinder::Find(View(raw), 1920, 0);
+    REQUIRE(expected.has_value());
+    CHECK_EQ(preview.offset, expected->offset);
+    CHECK_EQ(preview.length, expected->length);
+    CHECK_EQ(preview.width, 2048u);
+    CHECK_EQ(preview.orientation, 8);
+
+    // None at all, and a file that is gone
+    std::wstring text = WriteFile("plain.tif", "not a tiff");
+    CHECK(DecoderJobs::FindEmbeddedPreview(pool, FileAt(text, 10), 1920, 0, CancellationToken(), preview) ==
+          DecoderStatus::Ok);
+    CHECK_EQ(preview.length, 0u);
+    std::wstring missing = FromUtf8(Test::ScratchPath("missing.nef"));
+    CHECK(DecoderJobs::FindEmbeddedPreview(pool, FileAt(missing, 10), 1920, 0, CancellationToken(), preview) ==
+          DecoderStatus::Ok);
+    CHECK_EQ(preview.length, 0u);
+}
+
+LUMOS_TEST(WorkersParseMarkdownLikeThePipeline) {
+    DecoderPool pool(1);
+    pool.Start();
+
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        text += "## Section " + std::to_string(i) + "\n\nSome *text* and a [link][ref].\n\n";
+    }
+    text += "[ref]: https://example.com\n";
+    std::wstring path = WriteFile("long.md", text);
+
+    MarkdownChunks worked;
+    MarkdownDocument chunk;
+    REQUIRE(DecoderJobs::ParseMarkdown(pool, FileAt(path, text.size()), CancellationToken(), chunk,
+                                       [&](const MarkdownDocument& document, bool complete, bool truncated) {
+        return worked.Add(document, complete, truncated);
+    }) == DecoderStatus::Ok);
+
+    MarkdownChunks local;
+    MarkdownParser parser{ std::string_view() };
+    DecoderJobs::StreamMarkdown(parser, text, false, CancellationToken(), chunk,
+                                [&](const MarkdownDocument& document, bool complete, bool truncated) {
+        return local.Add(document, complete, truncated);
+    });
+
+    REQUIRE(worked.chunks.size() == 3);
+    CHECK(worked.chunks == local.chunks);
+    CHECK(worked.complete);
+    CHECK(!worked.truncated);
+    CHECK(worked.chunks[0].find("\"link\":\"https://example.com\"") != std::string::npos);
+
+    // Stopping after the first chunk stops the worker
+    size_t calls = 0;
+    CHECK(DecoderJobs::ParseMarkdown(pool, FileAt(path, text.size()), CancellationToken(), chunk,
+                                     [&](const MarkdownDocument&, bool, bool) {
+        ++calls;
+        return false;
+    }) == DecoderStatus::Ok);
+    CHECK_EQ(calls, 1u);
+}
+
+LUMOS_TEST(WorkersReadDatabasesLikeThePipeline) {
+    DecoderPool pool(1);
+    pool.Start();
+
+    std::vector<uint8_t> bytes = Test::ReadData("sqlite/basic.db");
+    std::wstring path = WriteFile("basic.db", bytes);
+    DatabaseMessages worked;
+    REQUIRE(DecoderJobs::ReadDatabase(pool, FileAt(path, bytes.size()), CancellationToken(),
+                                      [&](const SqliteSchema& schema, size_t tables) { return worked.Schema(schema, tables); },
+                                      [&](const SqliteRows* rows, bool last) { return worked.Table(rows, last); }) ==
+            DecoderStatus::Ok);
+
+    DatabaseMessages local;
+    SqliteFile database(ByteView(bytes.data(), bytes.size()));
+    DecoderJobs::StreamDatabase(database, CancellationToken(),
+                                [&](const SqliteSchema& schema, size_t tables) { return local.Schema(schema, tables); },
+                                [&](const SqliteRows* rows, bool last) { return local.Table(rows, last); });
+
+    REQUIRE(worked.tables > 0);
+    CHECK_EQ(worked.tables, local.tables);
+    CHECK_EQ(worked.messages.size(), worked.tables + 1);
+    CHECK(worked.messages == local.messages);
+    CHECK(worked.last);
+
+    // Thumbs.db is no SQLite database: nothing to show
+    std::wstring thumbs = WriteFile("Thumbs.db", std::string(4096, '\xD0'));
+    DatabaseMessages none;
+    CHECK(DecoderJobs::ReadDatabase(pool, FileAt(thumbs, 4096), CancellationToken(),
+                                    [&](const SqliteSchema& schema, size_t tables) { return none.Schema(schema, tables); },
+                                    [&](const SqliteRows* rows, bool last) { return none.Table(rows, last); }) ==
+          DecoderStatus::Ok);
+    CHECK(none.messages.empty());
+}
+
+LUMOS_TEST(WorkersDrawFontsIntoTheSurface) {
+    DecoderPool pool(1);
+    pool.Start();
+
+    std::vector<uint8_t> bytes = Test::ReadData("font/lumos.otf");
+    std::wstring path = WriteFile("lumos.otf", bytes);
+    SharedMemory surface;
+    REQUIRE(surface.Create(SharedMemory::UniqueName("Lumos.Test.Font", 1), FontSpecimen::MAX_BYTES));
+    FontSummary font;
+    REQUIRE(DecoderJobs::DrawFont(pool, FileAt(path, bytes.size()), surface, CancellationToken(), font) ==
+            DecoderStatus::Ok);
+    CHECK(font.valid);
+    CHECK(font.format == FontOutlineFormat::Cff);
+    CHECK(!font.names.family.empty());
+    REQUIRE(font.height > 0);
+
+    // The same pixels as drawing it here
+    std::vector<uint8_t> pixels(FontSpecimen::MAX_BYTES);
+    MemoryGovernor governor;
+    GlyphCache glyphs(governor);
+    FontSummary local;
+    REQUIRE(DecoderJobs::DrawSpecimen(ByteView(bytes.data(), bytes.size()), 0, glyphs, pixels.data(), pixels.size(),
+                                      local));
+    CHECK_EQ(local.height, font.height);
+    CHECK_EQ(local.names.family, font.names.family);
+    size_t drawn = static_cast<size_t>(font.height) * FontSpecimen::WIDTH * 4;
+    CHECK(std::memcmp(surface.Data(), pixels.data(), drawn) == 0);
+
+    // Without a surface only the names are read
+    SharedMemory closed;
+    CHECK(DecoderJobs::DrawFont(pool, FileAt(path, bytes.size()), closed, CancellationToken(), font) ==
+          DecoderStatus::Ok);
+    CHECK(font.valid);
+    CHECK_EQ(font.height, 0u);
+
+    std::wstring text = WriteFile("fake.ttf", "not a font");
+    CHECK(DecoderJobs::DrawFont(pool, FileAt(text, 10), surface, CancellationToken(), font) == DecoderStatus::Ok);
+    CHECK(!font.valid);
+}
+
+LUMOS_TEST(DisabledPoolLeavesParsingToTheCaller) {
+    DecoderPool pool(0);
+    pool.Start();
+    DecoderFile file = FileAt(L"/nowhere", 1);
+    EmbeddedPreview preview;
+    CHECK(DecoderJobs::FindEmbeddedPreview(pool, file, 1920, 0, CancellationToken(), preview) ==
+          DecoderStatus::Unavailable);
+    MarkdownDocument chunk;
+    CHECK(DecoderJobs::ParseMarkdown(pool, file, CancellationToken(), chunk,
+                                     [](const MarkdownDocument&, bool, bool) { return true; }) ==
+          DecoderStatus::Unavailable);
+    FontSummary font;
+    CHECK(DecoderJobs::DrawFont(pool, file, SharedMemory(), CancellationToken(), font) == DecoderStatus::Unavailable);
+}
+
+LUMOS_TEST(WorkerOutputIsChecked) {
+    std::vector<uint8_t> section(64 * 1024);
+
+    // Markdown: rebuilt with offsets of our own, split where the section ends
+    std::string_view text = "# Title\n\n> - *a* [b](c)\n\n| x |\n|:-|\n| 1 |\n";
+    MarkdownParser parser(text);
+    MarkdownDocument document;
+    parser.Parse(document, 100);
+    REQUIRE(document.blocks.size() >= 3);
+    size_t nextBlock = 0;
+    size_t bytes = DecoderJobs::EncodeMarkdown(document, nextBlock, section.data(), section.size());
+    CHECK_EQ(nextBlock, document.blocks.size());
+    MarkdownDocument decoded;
+    REQUIRE(DecoderJobs::DecodeMarkdown(ByteView(section.data(), bytes), decoded));
+    std::pmr::string expected;
+    std::pmr::string actual;
+    document.WriteJson(expected);
+    decoded.WriteJson(actual);
+    CHECK_EQ(actual, expected);
+
+    nextBlock = 0;
+    size_t half = DecoderJobs::EncodeMarkdown(document, nextBlock, section.data(), bytes / 2);
+    CHECK(nextBlock > 0 && nextBlock < document.blocks.size());
+    CHECK(half <= bytes / 2);
+
+    // Anything DecoderWorker would not have written
+    nextBlock = 0;
+    bytes = DecoderJobs::EncodeMarkdown(document, nextBlock, section.data(), section.size());
+    decoded.Clear();
+    CHECK(!DecoderJobs::DecodeMarkdown(ByteView(section.data(), bytes - 1), decoded));
+    std::vector<uint8_t> longer(section.begin(), section.begin() + bytes);
+    longer.push_back(0);
+    decoded.Clear();
+    CHECK(!DecoderJobs::DecodeMarkdown(ByteView(longer.data(), longer.size()), decoded));
+    std::vector<uint8_t> forged(section.begin(), section.begin() + bytes);
+    forged[4] = 99;  // First block's kind
+    decoded.Clear();
+    CHECK(!DecoderJobs::DecodeMarkdown(ByteView(forged.data(), forged.size()), decoded));
+    forged[4] = section[4];
+    forged[8] = 2;   // listItemStart, a flag
+    decoded.Clear();
+    CHECK(!DecoderJobs::DecodeMarkdown(ByteView(forged.data(), forged.size()), decoded));
+    uint32_t blocks = 0xFFFFFFFF;
+    std::memcpy(forged.data(), &blocks, sizeof(blocks));
+    decoded.Clear();
+    CHECK(!DecoderJobs::DecodeMarkdown(ByteView(forged.data(), forged.size()), decoded));
+
+    // SQLite: the schema and rows round-trip, rows past the section are left for "more"
+    std::vector<uint8_t> data = Test::ReadData("sqlite/basic.db");
+    SqliteFile database(ByteView(data.data(), data.size()));
+    SqliteSchema schema;
+    REQUIRE(database.ReadSchema(schema));
+    bytes = DecoderJobs::EncodeSchema(schema, section.data(), section.size());
+    SqliteSchema decodedSchema;
+    REQUIRE(DecoderJobs::DecodeSchema(ByteView(section.data(), bytes), decodedSchema));
+    expected.clear();
+    actual.clear();
+    schema.WriteJson(expected);
+    decodedSchema.WriteJson(actual);
+    CHECK_EQ(actual, expected);
+    CHECK(!DecoderJobs::DecodeSchema(ByteView(section.data(), bytes - 1), decodedSchema));
+
+    const SqliteObject* table = nullptr;
+    for (const SqliteObject& object : schema.objects) {
+        if (object.type == "table" && object.rootPage != 0 && !table) {
+            table = &object;
+        }
+    }
+    REQUIRE(table != nullptr);
+    SqliteRows rows;
+    database.ReadRows(*table, 0, DecoderJobs::DATABASE_PREVIEW_ROWS, rows);
+    REQUIRE(rows.rowCount > 1);
+    bytes = DecoderJobs::EncodeRows(rows, section.data(), section.size());
+    SqliteRows decodedRows;
+    REQUIRE(DecoderJobs::DecodeRows(ByteView(section.data(), bytes), decodedRows));
+    expected.clear();
+    actual.clear();
+    rows.WriteJson(expected);
+    decodedRows.WriteJson(actual);
+    CHECK_EQ(actual, expected);
+
+    SqliteRows noRows = rows;
+    noRows.values.clear();
+    noRows.rowCount = 0;
+    size_t header = DecoderJobs::EncodeRows(noRows, section.data(), section.size());
+    bytes = DecoderJobs::EncodeRows(rows, section.data(), header + (bytes - header) / 2);
+    REQUIRE(DecoderJobs::DecodeRows(ByteView(section.data(), bytes), decodedRows));
+    CHECK(decodedRows.rowCount > 0 && decodedRows.rowCount < rows.rowCount);
+    CHECK(decodedRows.more);
+
+    // Fonts: no specimen taller than the tallest
+    FontSummary font;
+    font.valid = true;
+    font.names.family = "Lumos";
+    font.height = FontSpecimen::MAX_HEIGHT;
+    bytes = DecoderJobs::EncodeFont(font, section.data(), section.size());
+    FontSummary decodedFont;
+    REQUIRE(DecoderJobs::DecodeFont(ByteView(section.data(), bytes), decodedFont));
+    CHECK_EQ(decodedFont.names.family, "Lumos");
+    font.height = FontSpecimen::MAX_HEIGHT + 1;
+    bytes = DecoderJobs::EncodeFont(font, section.data(), section.size());
+    CHECK(!DecoderJobs::DecodeFont(ByteView(section.data(), bytes), decodedFont));
+}
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include "Check.h"
+#include "../engines/font/FontSpecimen.h"
+#include "../engines/font/GlyphCache.h"
+#include "../engines/font/GlyphRasterizer.h"
+#include "../engines/font/OpenTypeFont.h"
+
+using namespace Lumos;
+
+// Fixtures and the glyph shapes they hold are described in
+// tests/data/font/make_fixtures.py
+namespace {
+    struct Font {
+        explicit Font(std::string_view name, uint32_t face = 0)
+            : bytes(Test::ReadData(name)), font(ByteView(bytes.data(), bytes.size()), face) {}
+
+        std::vector<uint8_t> bytes;
+        OpenTypeFont font;
+    };
+
+    // Outline bounds in font units
+    struct Bounds {
+        float left = 1e9f, bottom = 1e9f, right = -1e9f, top = -1e9f;
+    };
+
+    Bounds Measure(const GlyphOutline& outline) {
+        Bounds bounds;
+        for (size_t i = 0; i + 1 < outline.points.size(); i += 2) {
+            bounds.left = std::min(bounds.left, outline.points[i]);
+            bounds.right = std::max(bounds.right, outline.points[i]);
+            bounds.bottom = std::min(bounds.bottom, outline.points[i + 1]);
+            bounds.top = std::max(bounds.top, outline.points[i + 1]);
+        }
+        return bounds;
+    }
+
+    size_t Count(const GlyphOutline& outline, GlyphOutline::Verb verb) {
+        return static_cast<size_t>(std::count(outline.verbs.begin(), outline.verbs.end(), verb));
+    }
+
+    uint8_t CoverageAt(const GlyphBitmap& bitmap, int32_t x, int32_t y) {
+        // x right of the pen, y up from the baseline, both in pixels
+        int32_t column = x - bitmap.left;
+        int32_t row = bitmap.top - 1 - y;
+        if (column < 0 || row < 0 || column >= static_cast<int32_t>(bitmap.width) ||
+            row >= static_cast<int32_t>(bitmap.height)) {
+            return 0;
+        }
+        return bitmap.coverage[static_cast<size_t>(row) * bitmap.width + static_cast<size_t>(column)];
+    }
+
+    void CheckMetricsAndCmap(const OpenTypeFont& font) {
+        REQUIRE(font.IsValid());
+        CHECK_EQ(font.UnitsPerEm(), 1000);
+        CHECK_EQ(font.Ascender(), 800);
+        CHECK_EQ(font.Descender(), -200);
+        CHECK_EQ(font.Names().family, "Lumos Test");
+        CHECK_EQ(font.Names().subfamily, "Regular");
+
+        uint16_t square = font.GlyphIndex('A');
+        CHECK(square != 0);
+        CHECK_EQ(font.GlyphIndex(0x416), square);
+        CHECK(font.GlyphIndex('B') != 0);
+        CHECK_EQ(font.GlyphIndex('Z'), 0);
+        CHECK_EQ(font.GlyphIndex(0x1F600), 0);
+        CHECK_EQ(font.AdvanceWidth(square), 700);
+        CHECK_EQ(font.AdvanceWidth(font.GlyphIndex(' ')), 250);
+
+        std::vector<uint32_t> mapped = font.MappedCodepoints(100);
+        CHECK(std::is_sorted(mapped.begin(), mapped.end()));
+        CHECK(std::find(mapped.begin(), mapped.end(), 0x416u) != mapped.end());
+        CHECK_EQ(font.MappedCodepoints(2).size(), 2u);
+    }
+
+    void CheckSquare(const OpenTypeFont& font) {
+        GlyphOutline outline;
+        REQUIRE(font.LoadOutline(font.GlyphIndex('A'), outline));
+        CHECK_EQ(Count(outline, GlyphOutline::Verb::Move), 2u);
+        Bounds bounds = Measure(outline);
+        CHECK_EQ(bounds.left, 50.0f);
+        CHECK_EQ(bounds.right, 650.0f);
+        CHECK_EQ(bounds.bottom, 0.0f);
+        CHECK_EQ(bounds.top, 700.0f);
+
+        REQUIRE(font.LoadOutline(font.GlyphIndex(' '), outline));
+        CHECK(outline.Empty());
+        CHECK(!font.LoadOutline(font.GlyphCount(), outline));
+    }
+}
+
+LUMOS_TEST(TrueTypeMetricsAndCmap) {
+    Font ttf("font/lumos.ttf");
+    CheckMetricsAndCmap(ttf.font);
+    CHECK(ttf.font.OutlineFormat() == FontOutlineFormat::TrueType);
+    CHECK_EQ(ttf.font.FaceCount(), 1u);
+}
+
+LUMOS_TEST(TrueTypeOutlines) {
+    Font ttf("font/lumos.ttf");
+    CheckSquare(ttf.font);
+
+    GlyphOutline triangle;
+    REQUIRE(ttf.font.LoadOutline(ttf.font.GlyphIndex('B'), triangle));
+    CHECK_EQ(Count(triangle, GlyphOutline::Verb::Quad), 2u);
+    CHECK_EQ(Count(triangle, GlyphOutline::Verb::Cubic), 0u);
+
+    // Composite: the square, then a half-size copy moved right
+    GlyphOutline pair;
+    REQUIRE(ttf.font.LoadOutline(ttf.font.GlyphIndex('C'), pair));
+    CHECK_EQ(Count(pair, GlyphOutline::Verb::Move), 4u);
+    Bounds bounds = Measure(pair);
+    CHECK_EQ(bounds.right, 700.0f + 325.0f);
+    CHECK_EQ(bounds.top, 700.0f);
+}
+
+LUMOS_TEST(CffMetricsAndOutlines) {
+    Font otf("font/lumos.otf");
+    CheckMetricsAndCmap(otf.font);
+    CHECK(otf.font.OutlineFormat() == FontOutlineFormat::Cff);
+    CheckSquare(otf.font);
+
+    GlyphOutline triangle;
+    REQUIRE(otf.font.LoadOutline(otf.font.GlyphIndex('B'), triangle));
+    CHECK_EQ(Count(triangle, GlyphOutline::Verb::Cubic), 2u);
+    Bounds bounds = Measure(triangle);
+    CHECK_EQ(bounds.right, 600.0f);
+    CHECK_EQ(bounds.top, 700.0f);
+}
+
+LUMOS_TEST(CollectionFaces) {
+    Font first("font/lumos.ttc", 0);
+    Font second("font/lumos.ttc", 1);
+    CHECK_EQ(first.font.FaceCount(), 2u);
+    CHECK(first.font.OutlineFormat() == FontOutlineFormat::Cff);
+    CHECK(second.font.OutlineFormat() == FontOutlineFormat::TrueType);
+    CheckSquare(second.font);
+    CHECK(!Font("font/lumos.ttc", 2).font.IsValid());
+}
+
+LUMOS_TEST(RasterizesCoverage) {
+    Font ttf("font/lumos.ttf");
+    GlyphOutline outline;
+    REQUIRE(ttf.font.LoadOutline(ttf.font.GlyphIndex('A'), outline));
+
+    // 100 pixels per em: the box spans x 5..65 and y 0..70, the hole x 25..45, y 20..50
+    GlyphRasterizer rasterizer;
+    GlyphBitmap bitmap;
+    REQUIRE(rasterizer.Render(outline, 0.1f, bitmap));
+    CHECK(bitmap.width >= 60 && bitmap.width <= 62);
+    CHECK(bitmap.height >= 70 && bitmap.height <= 72);
+    CHECK_EQ(CoverageAt(bitmap, 10, 10), 255);
+    CHECK_EQ(CoverageAt(bitmap, 60, 65), 255);
+    CHECK_EQ(CoverageAt(bitmap, 35, 35), 0);  // Inside the hole
+    CHECK_EQ(CoverageAt(bitmap, 70, 35), 0);  // Right of the box
+
+    // The right edge at x 69.55 leaves its pixel about half covered
+    REQUIRE(rasterizer.Render(outline, 0.107f, bitmap));
+    uint8_t edge = CoverageAt(bitmap, 69, 10);
+    CHECK(edge > 64 && edge < 192);
+
+    GlyphOutline empty;
+    REQUIRE(rasterizer.Render(empty, 1.0f, bitmap));
+    CHECK_EQ(bitmap.width * bitmap.height, 0u);
+    CHECK(!rasterizer.Render(outline, 10.0f, bitmap));
+}
+
+LUMOS_TEST(GlyphCacheReusesBitmaps) {
+    Font ttf("font/lumos.ttf");
+    MemoryGovernor governor;
+    GlyphCache cache(governor);
+    cache.Bind(ttf.font, 1);
+    uint16_t square = ttf.font.GlyphIndex('A');
+    auto first = cache.Get(square, 32);
+    REQUIRE(first != nullptr);
+    CHECK(std::abs(first->advance - 22.4f) < 0.01f);
+    CHECK(cache.Get(square, 32) == first);
+    CHECK(cache.Get(square, 48) != first);
+    GlyphCacheStats stats = cache.Stats();
+    CHECK_EQ(stats.hits, 1u);
+    CHECK_EQ(stats.misses, 2u);
+    CHECK_EQ(stats.glyphs, 2u);
+    CHECK_EQ(governor.TotalCharged(), stats.bytes);
+
+    // The same font again keeps its glyphs; another one starts over
+    cache.Bind(ttf.font, 1);
+    CHECK(cache.Get(square, 32) == first);
+    cache.Bind(ttf.font, 2);
+    CHECK(cache.Get(square, 32) != first);
+    CHECK_EQ(cache.Stats().glyphs, 1u);
+    CHECK_EQ(governor.TotalCharged(), cache.Stats().bytes);
+
+    // A cap smaller than two bitmaps keeps only the newest
+    GlyphCache small(governor, first->coverage.size() + 256);
+    small.Bind(ttf.font, 1);
+    small.Get(square, 32);
+    small.Get(ttf.font.GlyphIndex('B'), 32);
+    CHECK_EQ(small.Stats().glyphs, 1u);
+}
+
+LUMOS_TEST(GlyphCacheGivesWayUnderPressure) {
+    Font ttf("font/lumos.ttf");
+    MemoryGovernor governor(64 * 1024);
+    GlyphCache cache(governor);
+    cache.Bind(ttf.font, 1);
+    for (uint16_t glyph = 0; glyph < ttf.font.GlyphCount(); ++glyph) {
+        cache.Get(glyph, 64);
+    }
+    REQUIRE(cache.Stats().bytes > 0);
+    CHECK(governor.TotalCharged() <= governor.Budget());
+
+    // An active pool takes the budget back from the cache
+    auto active = governor.RegisterPool("decoder", PoolPriority::Active);
+    CHECK(active->TryCharge(governor.Budget() - 1024));
+    CHECK(cache.Stats().bytes <= 1024);
+    CHECK(governor.TotalCharged() <= governor.Budget());
+
+    // Past the budget glyphs are still drawn, just not kept
+    CHECK(cache.Get(ttf.font.GlyphIndex('A'), 96) != nullptr);
+    CHECK(governor.TotalCharged() <= governor.Budget());
+}
+
+LUMOS_TEST(SpecimenDrawsEveryGlyph) {
+    Font otf("font/lumos.otf");
+    FontSpecimen specimen(otf.font);
+    REQUIRE(specimen.Height() > 0);
+    CHECK(specimen.Height() <= FontSpecimen::MAX_HEIGHT);
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(specimen.Stride()) * specimen.Height());
+    MemoryGovernor governor;
+    GlyphCache cache(governor);
+    cache.Bind(otf.font, 1);
+    FontSpecimenStats stats = specimen.Render(cache, pixels.data());
+    CHECK(stats.glyphsDrawn > stats.glyphsRendered);
+    CHECK(stats.glyphsRendered > 0);
+
+    // Some ink, and premultiplied: no channel above alpha
+    size_t inked = 0;
+    bool premultiplied = true;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        inked += pixels[i + 3] == 255 && pixels[i] == 0 ? 1 : 0;
+        premultiplied &= pixels[i] <= pixels[i + 3] && pixels[i + 1] <= pixels[i + 3] && pixels[i + 2] <= pixels[i + 3];
+    }
+    CHECK(inked > 1000);
+    CHECK(premultiplied);
+}
+
+LUMOS_TEST(RejectsDamagedFonts) {
+    Font ttf("font/lumos.ttf");
+    REQUIRE(ttf.font.IsValid());
+    for (size_t length : { size_t(0), size_t(4), size_t(12), size_t(100), ttf.bytes.size() / 2 }) {
+        OpenTypeFont cut(ByteView(ttf.bytes.data(), length));
+        GlyphOutline outline;
+        if (cut.IsValid()) {
+            for (uint16_t glyph = 0; glyph < cut.GlyphCount(); ++glyph) {
+                cut.LoadOutline(glyph, outline);
+            }
+        }
+    }
+    CHECK(OpenTypeFont::HandlesExtension(L".OTF"));
+    CHECK(OpenTypeFont::HandlesExtension(L".ttc"));
+    CHECK(!OpenTypeFont::HandlesExtension(L".fon"));
+}
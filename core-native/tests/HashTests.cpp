@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "Check.h"
+#include "../engines/hash/Crc32c.h"
+#include "../engines/hash/FileHasher.h"
+#include "../engines/hash/Sha1.h"
+#include "../engines/hash/Sha256.h"
+#include "../engines/hash/Xxh3.h"
+
+using namespace Lumos;
+
+namespace {
+    std::vector<uint8_t> Pattern(size_t length) {
+        std::vector<uint8_t> data(length);
+        for (size_t i = 0; i < length; ++i) {
+            data[i] = static_cast<uint8_t>(i * 131 + 7);
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> Bytes(std::string_view text) {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    template <size_t N>
+    std::string Hex(const uint8_t (&digest)[N]) {
+        std::string hex;
+        char byte[3];
+        for (uint8_t b : digest) {
+            std::snprintf(byte, sizeof(byte), "%02x", b);
+            hex += byte;
+        }
+        return hex;
+    }
+
+    // Bit at a time, straight from the polynomial
+    uint32_t ReferenceCrc32c(const std::vector<uint8_t>& data) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (uint8_t b : data) {
+            crc ^= b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    template <typename Hasher>
+    void FeedInPieces(Hasher& hasher, const std::vector<uint8_t>& data, size_t piece) {
+        for (size_t offset = 0; offset < data.size(); offset += piece) {
+            hasher.Update(data.data() + offset, std::min(piece, data.size() - offset));
+        }
+    }
+
+    std::string Sha1Hex(const std::vector<uint8_t>& data, size_t piece) {
+        Sha1 sha1;
+        FeedInPieces(sha1, data, piece);
+        uint8_t digest[Sha1::DIGEST_SIZE];
+        sha1.Finish(digest);
+        return Hex(digest);
+    }
+
+    std::string Sha256Hex(const std::vector<uint8_t>& data, size_t piece) {
+        Sha256 sha256;
+        FeedInPieces(sha256, data, piece);
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        sha256.Finish(digest);
+        return Hex(digest);
+    }
+
+    uint64_t Xxh3Of(const std::vector<uint8_t>& data, size_t piece) {
+        Xxh3 xxh3;
+        FeedInPieces(xxh3, data, piece);
+        return xxh3.Finish();
+    }
+
+    // XXH3_64bits() from the reference library; every length class the
+    // algorithm treats differently, and a multi-block input
+    struct Xxh3Vector {
+        size_t length;
+        uint64_t digest;
+    };
+    constexpr Xxh3Vector XXH3_VECTORS[] = {
+        { 0, 0x2D06800538D394C2ULL },
+        { 1, 0x4C5CCA45D0F4811FULL },
+        { 3, 0x6E3E2670E61106ACULL },
+        { 4, 0x5C4C63133443D03FULL },
+        { 8, 0xF9FD4DD0B04D78F5ULL },
+        { 9, 0x7C20DF9712C26EDFULL },
+        { 16, 0x86ABF6BACCEA0858ULL },
+        { 17, 0xB58BF5DC5022D071ULL },
+        { 128, 0x10D17F72C0CCBA41ULL },
+        { 129, 0x1648BDC3DB49D1A2ULL },
+        { 240, 0xB6CFAF343FAB81E6ULL },
+        { 241, 0x956CAE592C67279EULL },
+        { 1000, 0x571D5CBFEF44331BULL },
+        { 1024, 0x70BD377D9574F4BBULL },
+        { 100000, 0x14CE8D6FC2C4868BULL },
+        { 5000000, 0x6D7E2A3E6EBB63B7ULL },
+    };
+
+    // Pattern(5000000) from Python's hashlib
+    constexpr const char* PATTERN_SHA1 = "960e9a6a9eee9dd42238b9b98afbde061ad3a79d";
+    constexpr const char* PATTERN_SHA256 = "eeab63974f15260ff6edf91e0b40e0a2b1d187781c854574a2bbf157322ea891";
+}
+
+LUMOS_TEST(Crc32cMatchesTheReference) {
+    Crc32c empty;
+    CHECK_EQ(empty.Finish(), 0u);
+
+    Crc32c check;
+    std::vector<uint8_t> digits = Bytes("123456789");
+    check.Update(digits.data(), digits.size());
+    CHECK_EQ(check.Finish(), 0xE3069283u);
+
+    // Unaligned starts and lengths around the 8-byte hardware steps
+    std::vector<uint8_t> data = Pattern(1000);
+    for (size_t length : { 1u, 7u, 8u, 9u, 63u, 64u, 65u, 1000u }) {
+        for (size_t piece : { 1u, 3u, 64u, 4096u }) {
+            std::vector<uint8_t> prefix(data.begin(), data.begin() + static_cast<ptrdiff_t>(length));
+            Crc32c crc;
+            FeedInPieces(crc, prefix, piece);
+            CHECK_EQ(crc.Finish(), ReferenceCrc32c(prefix));
+        }
+    }
+}
+
+LUMOS_TEST(Sha1KnownAnswers) {
+    CHECK_EQ(Sha1Hex(Bytes(""), 1), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    CHECK_EQ(Sha1Hex(Bytes("abc"), 1), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    std::vector<uint8_t> twoBlocks = Bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+    CHECK_EQ(Sha1Hex(twoBlocks, 1), "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    CHECK_EQ(Sha1Hex(std::vector<uint8_t>(1000000, 'a'), 4096), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+    std::vector<uint8_t> data = Pattern(5000000);
+    CHECK_EQ(Sha1Hex(data, 1000003), PATTERN_SHA1);
+    CHECK_EQ(Sha1Hex(data, 63), PATTERN_SHA1);
+}
+
+LUMOS_TEST(Sha256KnownAnswers) {
+    CHECK_EQ(Sha256Hex(Bytes(""), 1), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK_EQ(Sha256Hex(Bytes("abc"), 1), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    std::vector<uint8_t> twoBlocks = Bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+    CHECK_EQ(Sha256Hex(twoBlocks, 1), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    CHECK_EQ(Sha256Hex(std::vector<uint8_t>(1000000, 'a'), 4096),
+             "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    std::vector<uint8_t> data = Pattern(5000000);
+    CHECK_EQ(Sha256Hex(data, 1000003), PATTERN_SHA256);
+    CHECK_EQ(Sha256Hex(data, 63), PATTERN_SHA256);
+}
+
+LUMOS_TEST(Xxh3MatchesTheReferenceLibrary) {
+    for (const Xxh3Vector& vector : XXH3_VECTORS) {
+        std::vector<uint8_t> data = Pattern(vector.length);
+        CHECK_EQ(Xxh3Of(data, data.size() + 1), vector.digest);
+        // Pieces that end mid-stripe, mid-buffer and exactly on a stripe
+        CHECK_EQ(Xxh3Of(data, 1), vector.digest);
+        CHECK_EQ(Xxh3Of(data, 64), vector.digest);
+        CHECK_EQ(Xxh3Of(data, 100), vector.digest);
+    }
+
+    // Finish() leaves the state alone
+    std::vector<uint8_t> data = Pattern(1024);
+    Xxh3 xxh3;
+    xxh3.Update(data.data(), 1000);
+    CHECK_EQ(xxh3.Finish(), XXH3_VECTORS[12].digest);
+    xxh3.Update(data.data() + 1000, 24);
+    CHECK_EQ(xxh3.Finish(), XXH3_VECTORS[13].digest);
+}
+
+LUMOS_TEST(FileHasherRunsAllFourInOnePass) {
+    WorkerPool workers(4);
+    FileHasher hasher(workers);
+    // Not a whole number of blocks, so the last one is short
+    std::vector<uint8_t> data = Pattern(5000000);
+
+    uint64_t lastHashed = 0;
+    bool monotonic = true;
+    auto hashes = hasher.Hash(ByteView(data.data(), data.size()), CancellationToken(),
+                              [&](uint64_t hashed, uint64_t total) {
+        monotonic &= hashed >= lastHashed && total == data.size();
+        lastHashed = hashed;
+    });
+    REQUIRE(hashes.has_value());
+    CHECK(monotonic);
+    CHECK_EQ(hashes->xxh3, XXH3_VECTORS[15].digest);
+    CHECK_EQ(hashes->crc32c, ReferenceCrc32c(data));
+    CHECK_EQ(Hex(hashes->sha1), PATTERN_SHA1);
+    CHECK_EQ(Hex(hashes->sha256), PATTERN_SHA256);
+
+    auto empty = hasher.Hash(ByteView(), CancellationToken());
+    REQUIRE(empty.has_value());
+    CHECK_EQ(empty->xxh3, XXH3_VECTORS[0].digest);
+    CHECK_EQ(Hex(empty->sha256), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+}
+
+LUMOS_TEST(FileHasherStopsWhenCancelled) {
+    WorkerPool workers(2);
+    FileHasher hasher(workers);
+    std::vector<uint8_t> data = Pattern(4 * FileHasher::BLOCK_SIZE);
+    CancellationSource cancellation;
+    cancellation.Cancel();
+    CHECK(!hasher.Hash(ByteView(data.data(), data.size()), cancellation.Token()).has_value());
+
+    // Usable again afterwards
+    CHECK(hasher.Hash(ByteView(data.data(), 1000), CancellationToken()).has_value());
+}
+
+// Through the scheduler nothing is mapped; a file shorter than the size
+// the caller had fails the hash instead of faulting
+LUMOS_TEST(FileHasherReadsThroughTheScheduler) {
+    WorkerPool workers(4);
+    FileHasher hasher(workers);
+    IOScheduler io(2);
+    std::vector<uint8_t> data = Pattern(5000000);
+    std::string path = Test::ScratchPath("hashed.bin");
+    FILE* file = std::fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    std::fwrite(data.data(), 1, data.size(), file);
+    std::fclose(file);
+
+    auto hashes = hasher.Hash(io, FromUtf8(path), data.size(), CancellationToken());
+    REQUIRE(hashes.has_value());
+    CHECK_EQ(hashes->xxh3, XXH3_VECTORS[15].digest);
+    CHECK_EQ(hashes->crc32c, ReferenceCrc32c(data));
+    CHECK_EQ(Hex(hashes->sha1), PATTERN_SHA1);
+    CHECK_EQ(Hex(hashes->sha256), PATTERN_SHA256);
+
+    CHECK(!hasher.Hash(io, FromUtf8(path), data.size() + FileHasher::BLOCK_SIZE, CancellationToken()).has_value());
+    CHECK(!hasher.Hash(io, FromUtf8(path + ".missing"), 1000, CancellationToken()).has_value());
+}
+
+LUMOS_TEST(FileHasherHandlesExtension) {
+    CHECK(FileHasher::HandlesExtension(L".ISO"));
+    CHECK(FileHasher::HandlesExtension(L".zip"));
+    CHECK(!FileHasher::HandlesExtension(L".jpg"));
+}
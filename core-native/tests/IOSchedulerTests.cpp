@@ -0,0 +1,276 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "Check.h"
+#include "../io/FileSource.h"
+#include "../io/IOScheduler.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+namespace {
+    std::wstring WriteFile(std::string_view name, size_t bytes) {
+        std::string path = Test::ScratchPath(name);
+        std::ofstream out(path, std::ios::binary);
+        for (size_t i = 0; i < bytes; ++i) {
+            out.put(static_cast<char>(i * 31));
+        }
+        return FromUtf8(path);
+    }
+
+#ifndef _WIN32
+    // A FIFO nobody writes to: open() blocks the worker the way a read from
+    // a dead share or a spun-down disk does, until Release() opens the other end
+    class StuckFile {
+    public:
+        explicit StuckFile(std::string_view name) : m_path(Test::ScratchPath(name)) {
+            mkfifo(m_path.c_str(), 0600);
+        }
+        ~StuckFile() { Release(); }
+
+        std::wstring Path() const { return FromUtf8(m_path); }
+
+        // Opening the write end fails until the worker is blocked opening
+        // the read end; retry for a while so a slow worker is not stranded
+        void Release() {
+            if (m_released) {
+                return;
+            }
+            m_released = true;
+            auto giveUp = std::chrono::steady_clock::now() + 2s;
+            while (std::chrono::steady_clock::now() < giveUp) {
+                int fd = open(m_path.c_str(), O_WRONLY | O_NONBLOCK);
+                if (fd >= 0) {
+                    close(fd);
+                    return;
+                }
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+
+    private:
+        std::string m_path;
+        bool m_released = false;
+    };
+#endif
+}
+
+LUMOS_TEST(ReadsRangeAndStat) {
+    IOScheduler io(2);
+    std::wstring path = WriteFile("range.bin", 200000);
+
+    IOResult result = io.Read(path, 1000, 100, 2000ms);
+    REQUIRE(result.status == IOStatus::Complete);
+    CHECK_EQ(result.data.size(), 100u);
+    CHECK_EQ(result.data[0], static_cast<uint8_t>(1000 * 31));
+    CHECK_EQ(result.stat.size, 200000u);
+
+    // Larger than one read chunk, and past the end of the file
+    result = io.Read(path, 100000, 500000, 2000ms);
+    REQUIRE(result.status == IOStatus::Complete);
+    CHECK_EQ(result.data.size(), 100000u);
+
+    auto stat = io.Stat(path, 2000ms);
+    REQUIRE(stat.has_value());
+    CHECK(stat->exists);
+    CHECK(!stat->isDirectory);
+
+    CHECK(!io.Stat(path + L".missing", 2000ms).has_value());
+    CHECK(io.Read(path + L".missing", 0, 16, 2000ms).status == IOStatus::Failed);
+}
+
+LUMOS_TEST(ReadIntoReusesTheBuffer) {
+    IOScheduler io(1);
+    std::wstring path = WriteFile("reuse.bin", 4096);
+
+    IOResult result;
+    io.Read(path, 0, 4096, 2000ms, result);
+    REQUIRE(result.status == IOStatus::Complete);
+    const uint8_t* buffer = result.data.data();
+
+    io.Read(path, 16, 100, 2000ms, result);
+    REQUIRE(result.status == IOStatus::Complete);
+    CHECK_EQ(result.data.size(), 100u);
+    CHECK_EQ(result.data[0], static_cast<uint8_t>(16 * 31));
+    CHECK(result.data.data() == buffer);
+
+    io.Read(path + L".missing", 0, 16, 2000ms, result);
+    CHECK(result.status == IOStatus::Failed);
+    CHECK(result.data.empty());
+}
+
+// Selection flags are recycled once nothing holds them; one still held
+// must never come back uncancelled
+LUMOS_TEST(SelectionTokensStayCancelled) {
+    IOScheduler io(1);
+    CancellationToken first = io.BeginSelection();
+    CancellationToken second = io.BeginSelection();
+    CHECK(first.IsCancellationRequested());
+    for (int i = 0; i < 4; ++i) {
+        CancellationToken next = io.BeginSelection();
+        CHECK(!next.IsCancellationRequested());
+        CHECK(first.IsCancellationRequested());
+        CHECK(second.IsCancellationRequested());
+        CHECK(!io.CurrentSelection().IsCancellationRequested());
+    }
+}
+
+LUMOS_TEST(VolumeOfPaths) {
+    CHECK_EQ(IOScheduler::VolumeOf(L"c:\\Users\\a.txt"), std::wstring(L"C:"));
+    CHECK_EQ(IOScheduler::VolumeOf(L"\\\\Server\\Share\\dir\\a.txt"), std::wstring(L"\\\\server\\share"));
+    CHECK_EQ(IOScheduler::VolumeOf(L"\\\\?\\UNC\\server\\share\\a"), std::wstring(L"\\\\server\\share"));
+    CHECK_EQ(IOScheduler::VolumeOf(L"\\\\?\\D:\\a"), std::wstring(L"D:"));
+    CHECK_EQ(IOScheduler::VolumeOf(L"/home/user/a"), std::wstring(L"/home"));
+    CHECK_EQ(IOScheduler::VolumeOf(L"relative"), std::wstring());
+}
+
+LUMOS_TEST(FileSourceMapsOnlyLocalUnchangedFiles) {
+    IOScheduler io(2);
+    std::wstring path = WriteFile("source.bin", 200000);
+    CHECK(!io.IsRemote(path));
+    CHECK(io.IsRemote(L"\\\\server\\share\\a.bin"));
+
+    FileSource source;
+    REQUIRE(source.Open(io, path, 200000, MapAccess::Random, 1000, 2000ms, {}));
+    CHECK(source.IsMapped());
+    CHECK_EQ(source.View().Size(), 200000u);
+
+    // Grown or shrunk since the stat, or never stat'ed: read, up to the limit
+    REQUIRE(source.Open(io, path, 150000, MapAccess::Random, 1000, 2000ms, {}));
+    CHECK(!source.IsMapped());
+    CHECK_EQ(source.View().Size(), 1000u);
+    CHECK_EQ(source.Size(), 200000u);
+    CHECK_EQ(source.View().Data()[999], static_cast<uint8_t>(999 * 31));
+    REQUIRE(source.Open(io, path, std::nullopt, MapAccess::Random, 1 << 20, 2000ms, {}));
+    CHECK(!source.IsMapped());
+    CHECK_EQ(source.View().Size(), 200000u);
+
+    // A volume standing in for a share is never mapped
+    io.SetVolumeLatency(IOScheduler::VolumeOf(path), 1us);
+    CHECK(io.IsRemote(path));
+    REQUIRE(source.Open(io, path, 200000, MapAccess::Random, 1 << 20, 2000ms, {}));
+    CHECK(!source.IsMapped());
+    CHECK_EQ(source.View().Size(), 200000u);
+
+    CHECK(!source.Open(io, path + L".missing", std::nullopt, MapAccess::Random, 1000, 2000ms, {}));
+    CHECK(!source.IsOpen());
+}
+
+LUMOS_TEST(CancelledBeforeStartNeverReadsDisk) {
+    IOScheduler io(1);
+    CancellationSource source;
+    source.Cancel();
+    IOResult result = io.Read(WriteFile("cancelled.bin", 64), 0, 64, 2000ms, IOPriority::Interactive, source.Token());
+    CHECK(result.status == IOStatus::Cancelled);
+}
+
+// A slow share: the chunks that arrived by the deadline come back as
+// Partial, and the worker gives up the rest without finishing the read
+LUMOS_TEST(SlowReadReturnsPartialAtDeadline) {
+    IOScheduler io(1);
+    std::wstring path = WriteFile("slow.bin", 16 * 64 * 1024);
+    io.SetVolumeLatency(IOScheduler::VolumeOf(path), 20ms);
+
+    auto start = std::chrono::steady_clock::now();
+    IOResult result = io.Read(path, 0, 16 * 64 * 1024, 100ms);
+    auto waited = std::chrono::steady_clock::now() - start;
+
+    CHECK(result.status == IOStatus::Partial);
+    CHECK(!result.data.empty());
+    CHECK(result.data.size() < 16 * 64 * 1024);
+    CHECK_EQ(result.data.size() % (64 * 1024), 0u);
+    CHECK(result.data[1] == static_cast<uint8_t>(31));
+    CHECK(waited >= 100ms);
+    CHECK(waited < 1000ms);
+
+    // The abandoned read stops at its next chunk and frees the worker
+    io.SetVolumeLatency(IOScheduler::VolumeOf(path), 0ms);
+    CHECK(io.Read(path, 0, 16, 2000ms).status == IOStatus::Complete);
+}
+
+#ifndef _WIN32
+LUMOS_TEST(DeadlineHoldsWhileDeviceIsStuck) {
+    IOScheduler io(2);
+    StuckFile stuck("stuck.fifo");
+
+    auto start = std::chrono::steady_clock::now();
+    IOResult result = io.Read(stuck.Path(), 0, 4096, 100ms);
+    auto waited = std::chrono::steady_clock::now() - start;
+
+    CHECK(result.status == IOStatus::DeadlineExpired);
+    CHECK(waited >= 100ms);
+    CHECK(waited < 1000ms);
+
+    // The other worker still serves requests while one is stuck
+    IOResult other = io.Read(WriteFile("other.bin", 16), 0, 16, 2000ms);
+    CHECK(other.status == IOStatus::Complete);
+    stuck.Release();
+}
+
+LUMOS_TEST(NewSelectionCancelsQueuedReads) {
+    IOScheduler io(2);
+    StuckFile stuck("stuck.fifo");
+    std::wstring volume = IOScheduler::VolumeOf(stuck.Path());
+    io.SetVolumeConcurrency(volume, 1);
+
+    // Occupies the volume's only slot
+    IORequest blocker;
+    blocker.path = stuck.Path();
+    blocker.length = 16;
+    auto blocked = io.Submit(blocker);
+    std::this_thread::sleep_for(20ms);
+
+    IORequest queued;
+    queued.path = WriteFile("queued.bin", 16);
+    queued.length = 16;
+    queued.cancellation = io.CurrentSelection();
+    auto waiting = io.Submit(queued);
+
+    CancellationToken next = io.BeginSelection();
+    CHECK(!next.IsCancellationRequested());
+    CHECK(queued.cancellation.IsCancellationRequested());
+
+    // Dropped as soon as a worker looks at the queue again
+    stuck.Release();
+    CHECK(waiting->Wait().status == IOStatus::Cancelled);
+    CHECK(blocked->Wait().status == IOStatus::Complete);
+}
+
+LUMOS_TEST(InteractiveRunsBeforeSpeculative) {
+    IOScheduler io(1);
+    StuckFile stuck("stuck.fifo");
+    StuckFile prefetchTarget("prefetch.fifo");
+
+    IORequest blocker;
+    blocker.path = stuck.Path();
+    blocker.length = 16;
+    auto blocked = io.Submit(blocker);
+    std::this_thread::sleep_for(20ms);
+
+    // Queued speculative first, then interactive. Had the only worker taken
+    // the speculative read first, it would block on the FIFO and the
+    // interactive one would miss its deadline.
+    IORequest speculative;
+    speculative.path = prefetchTarget.Path();
+    speculative.length = 16;
+    speculative.priority = IOPriority::Speculative;
+    auto prefetch = io.Submit(speculative);
+    IORequest interactive;
+    interactive.path = WriteFile("data.bin", 16);
+    interactive.length = 16;
+    interactive.deadline = std::chrono::steady_clock::now() + 2000ms;
+    auto preview = io.Submit(interactive);
+
+    stuck.Release();
+    CHECK(preview->Wait().status == IOStatus::Complete);
+    CHECK(blocked->Wait().status == IOStatus::Complete);
+    prefetchTarget.Release();
+    CHECK(prefetch->Wait().status == IOStatus::Complete);
+}
+#endif
@@ -0,0 +1,142 @@
+#include "Check.h"
+#include "TestImages.h"
+#include "../engines/image/EmbeddedPreview.h"
+#include "../engines/image/ImageHeaderProbe.h"
+
+using namespace Lumos;
+using namespace Lumos::TestImages;
+
+namespace {
+    ProbeStatus Probe(const Bytes& bytes, ImageHeader& header) {
+        return ImageHeaderProbe::Probe(ByteView(bytes.data(), bytes.size()), header);
+    }
+
+    ByteView View(const Bytes& bytes) {
+        return ByteView(bytes.data(), bytes.size());
+    }
+}
+
+LUMOS_TEST(ProbeJpegWithExifOrientation) {
+    ImageHeader header;
+    REQUIRE(Probe(Jpeg(4000, 3000, 6), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::Jpeg);
+    CHECK_EQ(header.width, 4000u);
+    CHECK_EQ(header.height, 3000u);
+    CHECK_EQ(header.orientation, 6);
+    CHECK_EQ(header.bitDepth, 24);
+}
+
+LUMOS_TEST(ProbePng) {
+    ImageHeader header;
+    REQUIRE(Probe(Png(640, 480, 8, 6, true), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::Png);
+    CHECK_EQ(header.width, 640u);
+    CHECK_EQ(header.height, 480u);
+    CHECK_EQ(header.bitDepth, 32);
+    CHECK(header.hasColorProfile);
+    CHECK_EQ(header.frameCount, 1u);
+
+    REQUIRE(Probe(Png(100, 50, 16, 0, false, 12), header) == ProbeStatus::Ok);
+    CHECK_EQ(header.bitDepth, 16);
+    CHECK_EQ(header.frameCount, 12u);
+}
+
+LUMOS_TEST(ProbeGifCountsFrames) {
+    ImageHeader header;
+    REQUIRE(Probe(Gif(320, 200, 3), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::Gif);
+    CHECK_EQ(header.width, 320u);
+    CHECK_EQ(header.height, 200u);
+    CHECK_EQ(header.frameCount, 3u);
+}
+
+LUMOS_TEST(ProbeBmpTopDown) {
+    ImageHeader header;
+    REQUIRE(Probe(Bmp(800, -600, 32), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::Bmp);
+    CHECK_EQ(header.width, 800u);
+    CHECK_EQ(header.height, 600u);
+    CHECK_EQ(header.bitDepth, 32);
+    CHECK(Probe(Bmp(0, 10), header) == ProbeStatus::Malformed);
+}
+
+LUMOS_TEST(ProbeWebPLossless) {
+    ImageHeader header;
+    REQUIRE(Probe(WebP(1024, 768), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::WebP);
+    CHECK_EQ(header.width, 1024u);
+    CHECK_EQ(header.height, 768u);
+    CHECK_EQ(header.bitDepth, 32);
+}
+
+LUMOS_TEST(ProbeTiff) {
+    ImageHeader header;
+    REQUIRE(Probe(RgbTiff(64, 48, 16), header) == ProbeStatus::Ok);
+    CHECK(header.format == ImageFormat::Tiff);
+    CHECK_EQ(header.width, 64u);
+    CHECK_EQ(header.height, 48u);
+    CHECK_EQ(header.bitDepth, 24);
+}
+
+LUMOS_TEST(ProbeTruncatedAndUnknown) {
+    ImageHeader header;
+    Bytes jpeg = Jpeg(4000, 3000, 6);
+    jpeg.resize(20);
+    CHECK(Probe(jpeg, header) == ProbeStatus::NeedMoreData);
+
+    Bytes png = Png(10, 10);
+    png.resize(20);
+    CHECK(Probe(png, header) == ProbeStatus::NeedMoreData);
+
+    CHECK(Probe(Bytes{ 'h', 'e', 'l', 'l', 'o', ' ', 'w' }, header) == ProbeStatus::Unrecognized);
+    CHECK(Probe(Bytes{ 0xFF, 0xD8 }, header) == ProbeStatus::NeedMoreData);
+
+    // RIFF that is not WebP (a WAV file)
+    Bytes wav = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' };
+    CHECK(Probe(wav, header) == ProbeStatus::Unrecognized);
+}
+
+LUMOS_TEST(ProbeHandlesExtension) {
+    CHECK(ImageHeaderProbe::HandlesExtension(L".JPG"));
+    CHECK(ImageHeaderProbe::HandlesExtension(L".webp"));
+    CHECK(!ImageHeaderProbe::HandlesExtension(L".txt"));
+}
+
+LUMOS_TEST(EmbeddedPreviewPicksSmallestAboveTarget) {
+    Bytes raw = RawWithPreviews(160, 2048, 8);
+    auto preview = EmbeddedPreviewFinder::Find(View(raw), 1920, 320);
+    REQUIRE(preview.has_value());
+    CHECK(preview->source == EmbeddedPreviewSource::TiffIfd);
+    CHECK_EQ(preview->width, 2048u);
+    CHECK_EQ(preview->orientation, 8);
+
+    // The preview bytes are a complete JPEG of their own
+    ImageHeader header;
+    REQUIRE(ImageHeaderProbe::Probe(View(raw).Sub(static_cast<size_t>(preview->offset),
+                                                  static_cast<size_t>(preview->length)), header) == ProbeStatus::Ok);
+    CHECK_EQ(header.width, 2048u);
+}
+
+LUMOS_TEST(EmbeddedPreviewFallsBackToLargest) {
+    Bytes raw = RawWithPreviews(160, 1024);
+    auto preview = EmbeddedPreviewFinder::Find(View(raw), 4000, 100);
+    REQUIRE(preview.has_value());
+    CHECK_EQ(preview->width, 1024u);
+
+    // Thumbnail only qualifies when the minimum allows it
+    CHECK(!EmbeddedPreviewFinder::Find(View(raw), 4000, 2000).has_value());
+}
+
+LUMOS_TEST(EmbeddedPreviewIgnoresTruncatedJpeg) {
+    Bytes raw = RawWithPreviews(160, 2048);
+    raw.resize(raw.size() / 2);
+    auto preview = EmbeddedPreviewFinder::Find(View(raw), 1920, 100);
+    CHECK(!preview.has_value() || preview->offset + preview->length <= raw.size());
+}
+
+LUMOS_TEST(EmbeddedPreviewExtensions) {
+    CHECK(EmbeddedPreviewFinder::IsRawExtension(L".CR2"));
+    CHECK(EmbeddedPreviewFinder::IsRawExtension(L".nef"));
+    CHECK(!EmbeddedPreviewFinder::IsRawExtension(L".jpg"));
+    CHECK(EmbeddedPreviewFinder::HandlesExtension(L".jpg"));
+}
@@ -0,0 +1,178 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include "Check.h"
+#include "../engines/text/LineIndex.h"
+#include "../engines/text/LogTail.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+namespace {
+    void Write(const std::string& path, std::string_view text, std::ios::openmode mode = std::ios::app) {
+        std::ofstream(path, std::ios::binary | mode).write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    std::string Lines(int first, int count) {
+        std::string text;
+        for (int i = first; i < first + count; ++i) {
+            text += "line " + std::to_string(i) + "\n";
+        }
+        return text;
+    }
+
+    // Everything the tail thread reported, waited for by the test
+    class Updates {
+    public:
+        LogTailCallback Callback() {
+            return [this](const LogTailUpdate& update) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_text += update.text;
+                m_totalLines = update.totalLines;
+                m_truncated |= update.truncated;
+                m_rotated |= update.rotated;
+                m_changed.notify_all();
+                return true;
+            };
+        }
+
+        template <typename Predicate>
+        bool WaitFor(Predicate done) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, 5s, [&] { return done(*this); });
+        }
+
+        std::string m_text;
+        uint64_t m_totalLines = 0;
+        bool m_truncated = false;
+        bool m_rotated = false;
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+    };
+}
+
+LUMOS_TEST(LineIndexCountsAcrossChunks) {
+    std::string text = Lines(0, 10000) + "partial";
+    LineIndex index;
+    // Odd chunk sizes so line ends fall on every position within a chunk
+    for (size_t offset = 0; offset < text.size(); offset += 977) {
+        size_t length = std::min<size_t>(977, text.size() - offset);
+        index.Append(reinterpret_cast<const uint8_t*>(text.data()) + offset, length);
+    }
+    CHECK_EQ(index.Bytes(), text.size());
+    CHECK_EQ(index.CompleteLines(), 10000u);
+    CHECK_EQ(index.LineCount(), 10001u);
+    CHECK_EQ(index.PartialLineStart(), text.size() - 7);
+
+    uint64_t checkpointLine = 0;
+    uint64_t offset = index.Seek(5000, checkpointLine);
+    CHECK_EQ(checkpointLine, LineIndex::CHECKPOINT_LINES);
+    CHECK_EQ(offset, Lines(0, static_cast<int>(LineIndex::CHECKPOINT_LINES)).size());
+
+    index.Reset();
+    CHECK_EQ(index.Bytes(), 0u);
+    CHECK_EQ(index.LineCount(), 0u);
+}
+
+LUMOS_TEST(OpenReturnsLastWholeLines) {
+    std::string path = Test::ScratchPath("app.log");
+    Write(path, Lines(0, 10) + "unfinished");
+
+    LogTail tail(FromUtf8(path), [](const LogTailUpdate&) { return true; });
+    std::string initial;
+    REQUIRE(tail.Open(3, initial));
+    CHECK_EQ(initial, Lines(7, 3));
+
+    LogTail missing(FromUtf8(Test::ScratchPath("missing.log")), [](const LogTailUpdate&) { return true; });
+    CHECK(!missing.Open(3, initial));
+}
+
+LUMOS_TEST(FollowSendsOnlyAppendedLines) {
+    std::string path = Test::ScratchPath("app.log");
+    Write(path, Lines(0, 100));
+
+    Updates updates;
+    LogTail tail(FromUtf8(path), updates.Callback());
+    std::string initial;
+    REQUIRE(tail.Open(10, initial));
+    tail.Follow();
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_totalLines == 100; }));
+    CHECK(updates.m_text.empty());
+
+    // A line in two writes arrives once it is finished
+    Write(path, Lines(100, 5) + "line ");
+    Write(path, "105\n");
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_totalLines == 106; }));
+    CHECK_EQ(updates.m_text, Lines(100, 6));
+    tail.Stop();
+
+    // The existing content was read once to index it, then only appends
+    uint64_t size = Lines(0, 106).size();
+    CHECK(tail.BytesRead() <= size);
+}
+
+LUMOS_TEST(TruncationStartsOver) {
+    std::string path = Test::ScratchPath("app.log");
+    Write(path, Lines(0, 50));
+
+    Updates updates;
+    LogTail tail(FromUtf8(path), updates.Callback());
+    std::string initial;
+    REQUIRE(tail.Open(10, initial));
+    tail.Follow();
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_totalLines == 50; }));
+
+    // copytruncate
+    Write(path, Lines(1000, 2), std::ios::trunc);
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_truncated && u.m_totalLines == 2; }));
+    CHECK_EQ(updates.m_text, Lines(1000, 2));
+}
+
+LUMOS_TEST(RotationFinishesTheOldFileFirst) {
+    std::string path = Test::ScratchPath("app.log");
+    std::string rotated = Test::ScratchPath("app.log.1");
+    Write(path, Lines(0, 20));
+
+    Updates updates;
+    LogTail tail(FromUtf8(path), updates.Callback());
+    std::string initial;
+    REQUIRE(tail.Open(10, initial));
+    tail.Follow();
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_totalLines == 20; }));
+
+    // The writer logs a last line to the renamed file before reopening
+    REQUIRE(std::rename(path.c_str(), rotated.c_str()) == 0);
+    Write(rotated, Lines(20, 1));
+    Write(path, Lines(0, 3));
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_rotated && u.m_totalLines == 3; }));
+    CHECK_EQ(updates.m_text, Lines(20, 1) + Lines(0, 3));
+}
+
+LUMOS_TEST(LargeAppendKeepsTheNewestWindow) {
+    std::string path = Test::ScratchPath("app.log");
+    Write(path, "");
+
+    Updates updates;
+    LogTail tail(FromUtf8(path), updates.Callback());
+    std::string initial;
+    REQUIRE(tail.Open(10, initial));
+
+    // Lands between the first paint and following, so the whole burst is
+    // pending at once; only the newest lines are passed on
+    std::string burst = Lines(0, 200000);
+    Write(path, burst);
+    tail.Follow();
+    REQUIRE(updates.WaitFor([](const Updates& u) { return u.m_totalLines == 200000; }));
+    CHECK(updates.m_text.size() <= 2 * LogTail::MAX_UPDATE_BYTES);
+    CHECK(updates.m_text.size() < burst.size());
+    CHECK(burst.compare(burst.size() - updates.m_text.size(), updates.m_text.size(), updates.m_text) == 0);
+}
+
+LUMOS_TEST(LogTailHandlesExtension) {
+    CHECK(LogTail::HandlesExtension(L".LOG"));
+    CHECK(!LogTail::HandlesExtension(L".txt"));
+}
@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "../memory/MemoryGovernor.h"
+
+using namespace Lumos;
+
+namespace {
+    // A pool whose owner frees whatever it is asked to, and notes the order
+    struct OwnedPool {
+        OwnedPool(MemoryGovernor& governor, std::string name, PoolPriority priority, std::vector<std::string>& order) {
+            pool = governor.RegisterPool(name, priority, [this, name, &order](size_t bytes) {
+                size_t freed = std::min(bytes, pool->Charged());
+                pool->Release(freed);
+                order.push_back(name);
+                return freed;
+            });
+        }
+
+        std::shared_ptr<MemoryPool> pool;
+    };
+}
+
+LUMOS_TEST(ChargesWithinBudget) {
+    MemoryGovernor governor(1000);
+    auto pool = governor.RegisterPool("decoder", PoolPriority::Active);
+    CHECK(pool->TryCharge(600));
+    CHECK(pool->TryCharge(400));
+    CHECK_EQ(governor.TotalCharged(), 1000u);
+
+    // Nothing reclaimable: refused, and nothing charged
+    CHECK(!pool->TryCharge(1));
+    CHECK_EQ(governor.TotalCharged(), 1000u);
+    CHECK_EQ(pool->Charged(), 1000u);
+
+    pool->Release(700);
+    CHECK_EQ(governor.TotalCharged(), 300u);
+    CHECK(pool->TryCharge(500));
+
+    auto stats = governor.Snapshot();
+    REQUIRE(stats.size() == 1);
+    CHECK_EQ(stats[0].name, std::string("decoder"));
+    CHECK_EQ(stats[0].charged, 800u);
+    CHECK_EQ(stats[0].peak, 1000u);
+    CHECK_EQ(stats[0].refused, 1u);
+}
+
+LUMOS_TEST(ReclaimsLowestPriorityFirst) {
+    MemoryGovernor governor(1000);
+    std::vector<std::string> order;
+    OwnedPool cache(governor, "cache", PoolPriority::Cache, order);
+    OwnedPool speculative(governor, "speculative", PoolPriority::Speculative, order);
+    OwnedPool critical(governor, "critical", PoolPriority::Critical, order);
+    CHECK(cache.pool->TryCharge(300));
+    CHECK(speculative.pool->TryCharge(300));
+    CHECK(critical.pool->TryCharge(300));
+
+    auto active = governor.RegisterPool("active", PoolPriority::Active);
+    REQUIRE(active->TryCharge(200));
+    REQUIRE(!order.empty());
+    CHECK_EQ(order[0], std::string("speculative"));
+    CHECK_EQ(critical.pool->Charged(), 300u);
+    CHECK(governor.TotalCharged() <= governor.Budget());
+}
+
+LUMOS_TEST(NeverReclaimsFromHigherPriority) {
+    MemoryGovernor governor(1000);
+    std::vector<std::string> order;
+    OwnedPool active(governor, "active", PoolPriority::Active, order);
+    OwnedPool cache(governor, "cache", PoolPriority::Cache, order);
+    CHECK(active.pool->TryCharge(700));
+    CHECK(cache.pool->TryCharge(200));
+
+    // A speculative charge may not push out what the user is looking at
+    auto speculative = governor.RegisterPool("speculative", PoolPriority::Speculative);
+    CHECK(!speculative->TryCharge(300));
+    CHECK(order.empty());
+    CHECK_EQ(active.pool->Charged(), 700u);
+    CHECK_EQ(cache.pool->Charged(), 200u);
+
+    // Pools of equal or lower priority still give way
+    auto prefetch = governor.RegisterPool("prefetch", PoolPriority::Cache);
+    CHECK(prefetch->TryCharge(150));
+    REQUIRE(order.size() == 1);
+    CHECK_EQ(order[0], std::string("cache"));
+    CHECK_EQ(active.pool->Charged(), 700u);
+
+    // A lower budget reclaims from everything but Critical
+    governor.SetBudget(500);
+    CHECK(active.pool->Charged() < 700u);
+    CHECK(governor.TotalCharged() <= governor.Budget());
+}
+
+LUMOS_TEST(ReleaseClampsToWhatWasCharged) {
+    MemoryGovernor governor(1000);
+    auto a = governor.RegisterPool("a", PoolPriority::Cache);
+    auto b = governor.RegisterPool("b", PoolPriority::Cache);
+    a->ForceCharge(100);
+    b->ForceCharge(200);
+
+    a->Release(500);
+    CHECK_EQ(a->Charged(), 0u);
+    CHECK_EQ(governor.TotalCharged(), 200u);
+}
+
+// Every thread releases twice what it charged, so releases race to clamp;
+// none may wrap the pool or take another pool's share of the total
+LUMOS_TEST(ConcurrentReleasesNeverUnderflow) {
+    static constexpr size_t THREADS = 10000;
+    MemoryGovernor governor(SIZE_MAX / 2);
+    auto shared = governor.RegisterPool("shared", PoolPriority::Cache);
+    auto other = governor.RegisterPool("other", PoolPriority::Cache);
+    other->ForceCharge(1000);
+
+    std::promise<void> go;
+    std::shared_future<void> started = go.get_future().share();
+    std::vector<std::thread> threads;
+    threads.reserve(THREADS);
+    for (size_t i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&] {
+            started.wait();
+            for (int round = 0; round < 16; ++round) {
+                shared->TryCharge(64);
+                shared->Release(128);
+            }
+        });
+    }
+    go.set_value();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK_EQ(shared->Charged(), 0u);
+    CHECK_EQ(governor.TotalCharged(), 1000u);
+    CHECK_EQ(other->Charged(), 1000u);
+}
+
+LUMOS_TEST(DroppedPoolReturnsItsCharge) {
+    MemoryGovernor governor(1000);
+    {
+        auto pool = governor.RegisterPool("transient", PoolPriority::Cache);
+        pool->ForceCharge(1500);
+        CHECK_EQ(governor.TotalCharged(), 1500u);
+    }
+    CHECK_EQ(governor.TotalCharged(), 0u);
+    CHECK(governor.Snapshot().empty());
+}
+
+LUMOS_TEST(LowerBudgetReclaims) {
+    MemoryGovernor governor(1000);
+    std::vector<std::string> order;
+    OwnedPool cache(governor, "cache", PoolPriority::Cache, order);
+    CHECK(cache.pool->TryCharge(900));
+    governor.SetBudget(400);
+    CHECK(governor.TotalCharged() <= 400u);
+    governor.OnLowMemory();
+    CHECK(governor.TotalCharged() <= 200u);
+}
@@ -0,0 +1,168 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "../metrics/Metrics.h"
+#include "../metrics/MetricsReport.h"
+
+using namespace Lumos;
+
+namespace {
+    // A zeroed section of our own, so cases do not see each other's values
+    std::unique_ptr<MetricsSection> NewSection() {
+        auto section = std::make_unique<MetricsSection>();
+        Metrics::Initialize(*section);
+        return section;
+    }
+
+    const HistogramSummary* Find(const MetricsSnapshot& snapshot, Histogram histogram) {
+        for (const auto& summary : snapshot.histograms) {
+            if (summary.name == Metrics::Name(histogram)) {
+                return &summary;
+            }
+        }
+        return nullptr;
+    }
+}
+
+LUMOS_TEST(BucketsCoverEveryValue) {
+    using namespace MetricsLayout;
+    for (uint64_t value = 0; value < SUB_BUCKETS; ++value) {
+        CHECK_EQ(Metrics::BucketIndex(value), value);
+    }
+
+    // Contiguous and ordered, each within 1/16 of its low end
+    for (size_t i = 0; i + 1 < BUCKETS; ++i) {
+        CHECK_EQ(Metrics::BucketHigh(i) + 1, Metrics::BucketLow(i + 1));
+        CHECK(Metrics::BucketHigh(i) - Metrics::BucketLow(i) <= Metrics::BucketLow(i) / SUB_BUCKETS);
+    }
+    CHECK_EQ(Metrics::BucketHigh(BUCKETS - 1), MAX_VALUE);
+
+    for (uint64_t value = 1; value < MAX_VALUE; value = value * 3 + 1) {
+        size_t index = Metrics::BucketIndex(value);
+        CHECK(index < BUCKETS);
+        CHECK(Metrics::BucketLow(index) <= value && value <= Metrics::BucketHigh(index));
+    }
+    CHECK_EQ(Metrics::BucketIndex(MAX_VALUE + 1), BUCKETS - 1);
+    CHECK_EQ(Metrics::BucketIndex(UINT64_MAX), BUCKETS - 1);
+}
+
+LUMOS_TEST(PercentilesStayWithinABucket) {
+    auto section = NewSection();
+    MetricsHistogram& histogram = section->histograms[static_cast<size_t>(Histogram::PipeSend)];
+    // 1..1000 µs, one each
+    for (uint64_t micros = 1; micros <= 1000; ++micros) {
+        Metrics::RecordInto(histogram, micros * 1000);
+    }
+
+    MetricsSnapshot snapshot;
+    REQUIRE(MetricsReport::Capture(*section, snapshot));
+    const HistogramSummary* summary = Find(snapshot, Histogram::PipeSend);
+    REQUIRE(summary != nullptr);
+    CHECK_EQ(summary->count, 1000u);
+    CHECK_EQ(summary->mean, 500500u);
+    CHECK_EQ(summary->max, 1000000u);
+    auto near = [](uint64_t actual, uint64_t expected) {
+        return actual >= expected - expected / 16 && actual <= expected + expected / 16;
+    };
+    CHECK(near(summary->p50, 500000));
+    CHECK(near(summary->p95, 950000));
+    CHECK(near(summary->p99, 990000));
+
+    // Unused histograms are listed, empty
+    const HistogramSummary* unused = Find(snapshot, Histogram::HookCallback);
+    REQUIRE(unused != nullptr);
+    CHECK_EQ(unused->count, 0u);
+    CHECK_EQ(unused->p99, 0u);
+
+    uint64_t empty[MetricsLayout::BUCKETS] = {};
+    CHECK_EQ(MetricsReport::Percentile(empty, 0, 0, 0.5), 0u);
+}
+
+LUMOS_TEST(PercentilesNeverExceedTheMax) {
+    uint64_t buckets[MetricsLayout::BUCKETS] = {};
+    buckets[Metrics::BucketIndex(1000)] = 3;
+    CHECK_EQ(MetricsReport::Percentile(buckets, 3, 1000, 0.99), 1000u);
+    CHECK_EQ(MetricsReport::Percentile(buckets, 3, 1000, 0.0), 1000u);
+}
+
+LUMOS_TEST(ConcurrentRecordsAllCount) {
+    auto section = NewSection();
+    MetricsHistogram& histogram = section->histograms[static_cast<size_t>(Histogram::DecoderJob)];
+    constexpr size_t THREADS = 8;
+    constexpr uint64_t PER_THREAD = 100000;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 0; i < PER_THREAD; ++i) {
+                Metrics::RecordInto(histogram, (i % 1000) * 1000 + t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    MetricsSnapshot snapshot;
+    REQUIRE(MetricsReport::Capture(*section, snapshot));
+    const HistogramSummary* summary = Find(snapshot, Histogram::DecoderJob);
+    REQUIRE(summary != nullptr);
+    CHECK_EQ(summary->count, THREADS * PER_THREAD);
+    CHECK_EQ(summary->max, 999000u + THREADS - 1);
+}
+
+LUMOS_TEST(CaptureRejectsOtherLayouts) {
+    auto section = NewSection();
+    MetricsSnapshot snapshot;
+    CHECK(MetricsReport::Capture(*section, snapshot));
+    section->header.version = MetricsLayout::VERSION + 1;
+    CHECK(!MetricsReport::Capture(*section, snapshot));
+    section->header.version = MetricsLayout::VERSION;
+    section->header.magic = 0;
+    CHECK(!MetricsReport::Capture(*section, snapshot));
+}
+
+LUMOS_TEST(PublishedSectionReadsBack) {
+    REQUIRE(Metrics::Publish());
+    Metrics::Record(Histogram::SelectionResolve, 2500);
+    CHECK(Metrics::SetGauge("cache.bytes", MetricUnit::Bytes, 3 * 1024 * 1024));
+    CHECK(Metrics::SetGauge("cache.bytes", MetricUnit::Bytes, 5 * 1024 * 1024));
+    CHECK(Metrics::SetGauge(std::string(100, 'g'), MetricUnit::Count, 1));
+
+    MetricsSnapshot snapshot;
+    std::wstring error;
+    REQUIRE(MetricsReport::CaptureSection(Metrics::SectionName(), snapshot, error));
+    CHECK(snapshot.processId != 0);
+    const HistogramSummary* resolve = Find(snapshot, Histogram::SelectionResolve);
+    REQUIRE(resolve != nullptr);
+    CHECK(resolve->count >= 1);
+
+    size_t matching = 0;
+    for (const auto& gauge : snapshot.gauges) {
+        if (gauge.name == "cache.bytes") {
+            ++matching;
+            CHECK_EQ(gauge.value, 5u * 1024 * 1024);
+            CHECK(gauge.unit == MetricUnit::Bytes);
+        }
+        CHECK(gauge.name.size() < MetricsLayout::GAUGE_NAME_BYTES);
+    }
+    CHECK_EQ(matching, 1u);
+
+    std::wstring text = MetricsReport::Format(snapshot, snapshot.startedAt + 3 * 3600000 + 120000);
+    CHECK(text.find(L"up 3h 2m") != std::wstring::npos);
+    CHECK(text.find(L"5.0 MB") != std::wstring::npos);
+
+    CHECK(!MetricsReport::CaptureSection("LumosMetrics.0", snapshot, error));
+    CHECK(!error.empty());
+}
+
+LUMOS_TEST(FormatsUnits) {
+    CHECK_EQ(MetricsReport::FormatDuration(999), L"999 ns");
+    CHECK_EQ(MetricsReport::FormatDuration(1500), L"1.5 us");
+    CHECK_EQ(MetricsReport::FormatDuration(2500000), L"2.5 ms");
+    CHECK_EQ(MetricsReport::FormatDuration(3000000000), L"3.00 s");
+    CHECK_EQ(MetricsReport::FormatBytes(1023), L"1023 B");
+    CHECK_EQ(MetricsReport::FormatBytes(1536), L"1.5 KB");
+    CHECK_EQ(MetricsReport::FormatBytes(5ull << 30), L"5.00 GB");
+}
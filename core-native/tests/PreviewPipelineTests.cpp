@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "TestImages.h"
+#include "../cache/ChangeMonitor.h"
+#include "../cache/PreviewCache.h"
+#include "../common/WorkerPool.h"
+#include "../io/IOScheduler.h"
+#include "../memory/MemoryGovernor.h"
+#include "../pipeline/PreviewPipeline.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../replay/ReplaySelection.h"
+#include "../worker/DecoderPool.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+namespace {
+    struct Message {
+        PreviewMessageType type;
+        uint64_t generation;
+        std::wstring path;
+        bool markdown;
+        bool tail;
+        std::string session = {};     // Preview messages only
+        std::thread::id thread = {};  // Set by the sink
+    };
+
+    // Keeps what the UI would have been told, in order
+    class RecordingSink : public PreviewSink {
+    public:
+        bool SendPreviewRequest(const PreviewRequest& request, std::pmr::memory_resource*) override {
+            Record({ request.type, request.generation, std::wstring(request.path), request.markdown.has_value(),
+                     request.tail.has_value(), std::string(request.session) });
+            return true;
+        }
+        bool SendCancel(uint64_t generation, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Cancel, generation, {}, false, false });
+        }
+        bool SendMarkdown(uint64_t generation, const PreviewMarkdown&, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Markdown, generation, {}, true, false });
+        }
+        bool SendTail(uint64_t generation, const PreviewTail&, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Tail, generation, {}, false, true });
+        }
+        bool SendHashes(uint64_t generation, const PreviewHashes&, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Hashes, generation, {}, false, false });
+        }
+        bool SendDatabase(uint64_t generation, const PreviewDatabase&, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Database, generation, {}, false, false });
+        }
+        bool SendProvider(uint64_t generation, const PreviewProvider&, std::pmr::memory_resource*) override {
+            return Record({ PreviewMessageType::Provider, generation, {}, false, false });
+        }
+
+        std::vector<Message> Messages() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_messages;
+        }
+
+        std::vector<Message> Previews() const {
+            std::vector<Message> previews;
+            for (const auto& message : Messages()) {
+                if (message.type == PreviewMessageType::Preview) {
+                    previews.push_back(message);
+                }
+            }
+            return previews;
+        }
+
+    private:
+        bool Record(Message message) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            message.thread = std::this_thread::get_id();
+            m_messages.push_back(std::move(message));
+            return true;
+        }
+
+        mutable std::mutex m_mutex;
+        std::vector<Message> m_messages;
+    };
+
+    // The pipeline as main.cpp assembles it, over a scripted selection and
+    // with decoding in-process
+    struct Harness {
+        IOScheduler io;
+        MemoryGovernor governor;
+        PreviewCache cache{ governor, "preview-cache" };
+        ChangeMonitor changeMonitor{ io };
+        WorkerPool workers;
+        ProviderRegistry providers;
+        DecoderPool decoders{ 0 };
+        RecordingSink sink;
+        ReplayCursor cursor;
+        PreviewPipeline pipeline{ io, sink,
+                                  [this](IOScheduler& scheduler) { return std::make_unique<ReplaySelection>(scheduler, cursor); },
+                                  cache, governor, changeMonitor, workers, providers, decoders };
+
+        Harness() {
+            changeMonitor.Subscribe(cache);
+            changeMonitor.Start();
+        }
+
+        // A zero poll yields instead of sleeping, for tests that time presses
+        bool WaitIdle(std::chrono::microseconds poll = 1ms) {
+            auto deadline = std::chrono::steady_clock::now() + 10s;
+            while (std::chrono::steady_clock::now() < deadline) {
+                auto stats = pipeline.GetStats();
+                if (stats.completed + stats.superseded + stats.coalesced >= stats.submitted) {
+                    return true;
+                }
+                if (poll.count() == 0) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(poll);
+                }
+            }
+            return false;
+        }
+    };
+
+    std::wstring WriteText(std::string_view name, std::string_view text) {
+        std::string path = Test::ScratchPath(name);
+        std::ofstream(path, std::ios::binary) << text;
+        return FromUtf8(path);
+    }
+
+    std::wstring WriteBytes(std::string_view name, const std::vector<uint8_t>& bytes) {
+        return WriteText(name, std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+    }
+}
+
+LUMOS_TEST(PressSendsOnePreviewForTheSelection) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    std::wstring path = WriteText("notes.txt", "plain text\n");
+    harness.cursor.Select(path);
+
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+    harness.pipeline.Stop();
+
+    auto previews = harness.sink.Previews();
+    REQUIRE(previews.size() == 1);
+    CHECK_EQ(previews[0].generation, 1u);
+    CHECK_EQ(previews[0].path, path);
+    CHECK_EQ(harness.pipeline.GetStats().completed, 1u);
+}
+
+LUMOS_TEST(MarkdownTravelsWithTheRequest) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    harness.cursor.Select(WriteText("readme.md", "# Title\n\nSome *text*.\n\n- a\n- b\n"));
+
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+    harness.pipeline.Stop();
+
+    auto previews = harness.sink.Previews();
+    REQUIRE(previews.size() == 1);
+    CHECK(previews[0].markdown);
+}
+
+LUMOS_TEST(NothingSelectedSendsNothing) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+    harness.pipeline.Stop();
+    CHECK(harness.sink.Previews().empty());
+}
+
+LUMOS_TEST(NextPressCancelsThePreviousGeneration) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    harness.cursor.Select(WriteText("first.txt", "first\n"));
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+
+    harness.cursor.Select(WriteText("second.txt", "second\n"));
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+    harness.pipeline.Stop();
+
+    auto messages = harness.sink.Messages();
+    REQUIRE(messages.size() == 3);
+    CHECK(messages[0].type == PreviewMessageType::Preview);
+    CHECK(messages[1].type == PreviewMessageType::Cancel);
+    CHECK_EQ(messages[1].generation, 1u);
+    CHECK(messages[2].type == PreviewMessageType::Preview);
+    CHECK_EQ(messages[2].generation, 2u);
+}
+
+// The UI outlives the core. A restarted core numbers its presses from 1
+// again, and only the session tells them from the old core's.
+LUMOS_TEST(RestartedCoreStartsANewSession) {
+    std::wstring path = WriteText("restart.txt", "text\n");
+    std::vector<Message> before;
+    {
+        Harness harness;
+        REQUIRE(harness.pipeline.Start());
+        harness.cursor.Select(path);
+        harness.pipeline.Submit();
+        REQUIRE(harness.WaitIdle());
+        harness.pipeline.Submit();
+        REQUIRE(harness.WaitIdle());
+        harness.pipeline.Stop();
+        before = harness.sink.Previews();
+    }
+
+    Harness restarted;
+    REQUIRE(restarted.pipeline.Start());
+    restarted.cursor.Select(path);
+    restarted.pipeline.Submit();
+    REQUIRE(restarted.WaitIdle());
+    restarted.pipeline.Stop();
+    auto after = restarted.sink.Previews();
+
+    REQUIRE(before.size() == 2);
+    REQUIRE(after.size() == 1);
+    CHECK(!before[0].session.empty());
+    CHECK_EQ(before[1].session, before[0].session);
+    CHECK_EQ(after[0].generation, 1u);
+    CHECK(after[0].session != before[0].session);
+
+    PreviewRequest request;
+    request.generation = 1;
+    request.session = after[0].session;
+    CHECK(request.ToJson().find("\"generation\":1,\"session\":\"" + after[0].session + "\"") != std::string::npos);
+}
+
+LUMOS_TEST(BurstEndsOnTheNewestPress) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    std::vector<std::wstring> paths;
+    for (int i = 0; i < 5; ++i) {
+        paths.push_back(WriteText("burst" + std::to_string(i) + ".md", "# Heading\n\nBody text.\n"));
+    }
+
+    constexpr uint64_t PRESSES = 50;
+    for (uint64_t press = 0; press < PRESSES; ++press) {
+        harness.cursor.Select(paths[press % paths.size()]);
+        harness.pipeline.Submit();
+    }
+    REQUIRE(harness.WaitIdle());
+    harness.pipeline.Stop();
+
+    auto stats = harness.pipeline.GetStats();
+    CHECK_EQ(stats.submitted, PRESSES);
+    CHECK_EQ(stats.completed + stats.superseded + stats.coalesced, PRESSES);
+
+    // Whatever got through went out oldest first, and the last press always did
+    auto previews = harness.sink.Previews();
+    REQUIRE(!previews.empty());
+    for (size_t i = 1; i < previews.size(); ++i) {
+        CHECK(previews[i].generation > previews[i - 1].generation);
+    }
+    CHECK_EQ(previews.back().generation, PRESSES);
+    CHECK_EQ(previews.back().path, paths[(PRESSES - 1) % paths.size()]);
+}
+
+// The sink is not thread-safe: lines appended to a followed log reach it
+// from the pipeline thread, not the tail's own
+LUMOS_TEST(LogTailUpdatesGoOutOnThePipelineThread) {
+    Harness harness;
+    REQUIRE(harness.pipeline.Start());
+    std::wstring path = WriteText("service.log", "started\n");
+    harness.cursor.Select(path);
+    harness.pipeline.Submit();
+    REQUIRE(harness.WaitIdle());
+
+    std::ofstream(ToUtf8(path), std::ios::binary | std::ios::app) << "appended\n";
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    auto tails = [&] {
+        size_t count = 0;
+        for (const auto& message : harness.sink.Messages()) {
+            count += message.type == PreviewMessageType::Tail;
+        }
+        return count;
+    };
+    while (tails() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    harness.pipeline.Stop();
+
+    auto messages = harness.sink.Messages();
+    REQUIRE(tails() > 0);
+    REQUIRE(messages[0].tail);
+    for (const auto& message : messages) {
+        CHECK(message.thread == messages[0].thread);
+    }
+}
+
+// Hours of browsing in one sitting: every pool stays inside a small budget,
+// and the last presses are no slower than the first
+LUMOS_TEST(TenThousandPressesStayWithinBudget) {
+    constexpr size_t BUDGET = 512 * 1024;
+    constexpr size_t PRESSES = 10000;
+    constexpr size_t WINDOW = 1000;
+
+    Harness harness;
+    harness.governor.SetBudget(BUDGET);
+    REQUIRE(harness.pipeline.Start());
+
+    // Every built-in engine but the log tail, which outlives its press
+    std::vector<std::wstring> paths;
+    for (int i = 0; i < 40; ++i) {
+        std::string n = std::to_string(i);
+        paths.push_back(WriteBytes("image" + n + ".png", TestImages::Png(64 + i, 48 + i)));
+        paths.push_back(WriteBytes("photo" + n + ".jpg", TestImages::Jpeg(640 + i, 480 + i, 6)));
+        paths.push_back(WriteText("notes" + n + ".md", "# Note " + n + "\n\nSome *text* and a [link](x).\n\n- a\n- b\n"));
+        paths.push_back(WriteText("plain" + n + ".txt", "plain text " + n + "\n"));
+        paths.push_back(WriteText("archive" + n + ".zip", std::string(4096 + i, 'z')));
+    }
+    paths.push_back(WriteBytes("face.ttf", Test::ReadData("font/lumos.ttf")));
+    paths.push_back(WriteBytes("face.otf", Test::ReadData("font/lumos.otf")));
+    paths.push_back(WriteBytes("basic.db", Test::ReadData("sqlite/basic.db")));
+
+    std::vector<double> window;
+    std::vector<double> medians;
+    size_t overBudget = 0;
+    for (size_t press = 0; press < PRESSES; ++press) {
+        harness.cursor.Select(paths[(press * 7) % paths.size()]);
+        auto start = std::chrono::steady_clock::now();
+        harness.pipeline.Submit();
+        REQUIRE(harness.WaitIdle(0us));
+        window.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        overBudget += harness.governor.TotalCharged() > BUDGET;
+
+        if (window.size() == WINDOW) {
+            std::nth_element(window.begin(), window.begin() + WINDOW / 2, window.end());
+            medians.push_back(window[WINDOW / 2]);
+            window.clear();
+        }
+    }
+    harness.pipeline.Stop();
+
+    CHECK_EQ(overBudget, 0u);
+    CHECK_EQ(harness.pipeline.GetStats().completed, PRESSES);
+    for (const auto& pool : harness.governor.Snapshot()) {
+        CHECK(pool.peak <= BUDGET);
+    }
+
+    // Generous against a noisy machine, tight against growth per press
+    REQUIRE(medians.size() == PRESSES / WINDOW);
+    std::wcout << L"  median press " << medians.front() << L" us first, " << medians.back() << L" us last" << std::endl;
+    CHECK(medians.back() <= medians.front() * 4 + 1000);
+}
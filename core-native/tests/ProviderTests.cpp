@@ -0,0 +1,328 @@
+#include <filesystem>
+#include <thread>
+#include "Check.h"
+#include "../plugins/ProviderLoader.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../plugins/ProviderSession.h"
+
+using namespace Lumos;
+
+// In-process providers drive the registry and session; the sample Netpbm
+// provider, built as a module next to this test, drives the loader
+namespace {
+    const char* const ROW_EXTENSIONS[] = { ".rows", ".md", "noDot", ".toolongext" };
+    const uint8_t ROW_MAGIC[] = { 'R', 'O', 'W', 'S' };
+    const uint8_t LATE_MAGIC[] = { 'L', 'A', 'T', 'E' };
+    const LumosSignature ROW_SIGNATURES[] = { { 0, 4, ROW_MAGIC }, { 100, 4, LATE_MAGIC } };
+
+    // The byte after the magic is the number of rows, 0xFF for as many as
+    // the host takes; an 'F' after that fails the preview
+    int PreviewRows(const LumosPreviewInput* input, const LumosHost* host) {
+        if (input->size < 6) {
+            return LUMOS_PREVIEW_UNSUPPORTED;
+        }
+        unsigned count = input->data[4];
+        for (unsigned i = 0; count == 0xFF || i < count; ++i) {
+            std::string name = "row " + std::to_string(i);
+            if (!host->emit(host->context, name.c_str(), input->extension)) {
+                return host->cancelled(host->context) ? LUMOS_PREVIEW_CANCELLED : LUMOS_PREVIEW_OK;
+            }
+        }
+        return input->data[5] == 'F' ? LUMOS_PREVIEW_FAILED : LUMOS_PREVIEW_OK;
+    }
+
+    // Turns down signature matches followed by '?'
+    int ProbeRows(const uint8_t* head, size_t length) {
+        return length < 5 || head[4] != '?';
+    }
+
+    LumosProviderInfo RowsProvider(const char* name = "Rows") {
+        LumosProviderInfo info{};
+        info.abiVersion = LUMOS_PROVIDER_ABI_VERSION;
+        info.structSize = sizeof(LumosProviderInfo);
+        info.name = name;
+        info.version = "2.0";
+        info.extensions = ROW_EXTENSIONS;
+        info.extensionCount = 4;
+        info.signatures = ROW_SIGNATURES;
+        info.signatureCount = 2;
+        info.costClass = LUMOS_COST_HEADER;
+        info.probe = ProbeRows;
+        info.preview = PreviewRows;
+        return info;
+    }
+
+    struct Batches {
+        ProviderBatchCallback Callback(bool accept = true) {
+            return [this, accept](const ProviderBatch& batch) {
+                list.push_back(batch);
+                json.emplace_back(batch.rowsJson);
+                return accept;
+            };
+        }
+
+        std::vector<ProviderBatch> list;
+        std::vector<std::string> json;
+    };
+
+    ByteView View(const std::string& bytes) {
+        return ByteView(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    }
+
+    std::string Input(uint8_t rows, char ending = '-') {
+        return std::string("ROWS") + static_cast<char>(rows) + ending;
+    }
+}
+
+LUMOS_TEST(BuiltinsResolveWithoutProviders) {
+    ProviderRegistry registry;
+    CHECK(registry.Resolve(L".md").builtin == BuiltinPreview::Markdown);
+    CHECK(registry.Resolve(L".SQLite3").builtin == BuiltinPreview::Database);
+    CHECK(registry.Resolve(L".ttc").builtin == BuiltinPreview::Font);
+    CHECK(!registry.Resolve(L".png"));
+    CHECK(!registry.Resolve(L""));
+    CHECK(!registry.Resolve(L".verylongextension"));
+    CHECK(ProviderRegistry::ResolveBuiltin(L".ZIP") == BuiltinPreview::Hashes);
+
+    CHECK(registry.Sniff(View(std::string("SQLite format 3\0rest", 20))).builtin == BuiltinPreview::Database);
+    CHECK(registry.Sniff(View("OTTO....")).builtin == BuiltinPreview::Font);
+    CHECK(registry.Sniff(View("\x1F\x8B\x08")).builtin == BuiltinPreview::Hashes);
+    CHECK(!registry.Sniff(View(std::string("SQLite format 3", 15))));
+    CHECK(!registry.Sniff(View("plain text")));
+    CHECK(!registry.Sniff(ByteView()));
+}
+
+LUMOS_TEST(ProvidersExtendTheTables) {
+    static const LumosProviderInfo rows = RowsProvider();
+    static const LumosProviderInfo shadow = RowsProvider("Shadow");
+
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&rows));
+    REQUIRE(registry.Add(&shadow));
+    registry.Build();
+    REQUIRE(registry.Providers().size() == 2);
+    CHECK_EQ(registry.Providers()[0]->version, "2.0");
+
+    // The first provider wins; built-ins keep theirs; malformed extensions
+    // are dropped
+    ProviderMatch match = registry.Resolve(L".ROWS");
+    REQUIRE(match.provider != nullptr);
+    CHECK_EQ(match.provider->name, "Rows");
+    CHECK(registry.Resolve(L".md").builtin == BuiltinPreview::Markdown);
+    CHECK(!registry.Resolve(L".toolongext"));
+
+    CHECK_EQ(registry.SniffBytes(), 104u);
+    CHECK(registry.Sniff(View("ROWS!")).provider == match.provider);
+    CHECK(!registry.Sniff(View("ROWS?")));
+    std::string late = std::string(100, '.') + "LATE";
+    CHECK(registry.Sniff(View(late)).provider == match.provider);
+    CHECK(!registry.Sniff(View(late.substr(0, 102))));
+}
+
+LUMOS_TEST(RejectsIncompatibleProviders) {
+    ProviderRegistry registry;
+    CHECK(!registry.Add(nullptr));
+
+    LumosProviderInfo newer = RowsProvider();
+    newer.abiVersion = LUMOS_PROVIDER_ABI_VERSION + 1;
+    CHECK(!registry.Add(&newer));
+
+    LumosProviderInfo older = RowsProvider();
+    older.structSize = 8;
+    CHECK(!registry.Add(&older));
+
+    LumosProviderInfo noPreview = RowsProvider();
+    noPreview.preview = nullptr;
+    CHECK(!registry.Add(&noPreview));
+
+    LumosProviderInfo noExtensions = RowsProvider();
+    noExtensions.extensions = nullptr;
+    CHECK(!registry.Add(&noExtensions));
+
+    LumosProviderInfo badCost = RowsProvider();
+    badCost.costClass = LUMOS_COST_FULL + 1;
+    CHECK(!registry.Add(&badCost));
+    CHECK(registry.Providers().empty());
+}
+
+LUMOS_TEST(SessionSendsRowsAsJson) {
+    static const LumosProviderInfo info = RowsProvider();
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+    const NativeProvider& provider = *registry.Providers()[0];
+    CancellationToken none;
+
+    Batches batches;
+    ProviderSession session(provider, none, batches.Callback());
+    CHECK(session.Run(View(Input(2)), L"/x/a.rows", L".rows") == LUMOS_PREVIEW_OK);
+    REQUIRE(batches.list.size() == 1);
+    CHECK(batches.list[0].complete);
+    CHECK(!batches.list[0].failed);
+    CHECK(!batches.list[0].truncated);
+    CHECK_EQ(batches.list[0].rowCount, 2u);
+    CHECK_EQ(batches.json[0], "[{\"name\":\"row 0\",\"value\":\".rows\"},{\"name\":\"row 1\",\"value\":\".rows\"}]");
+
+    // Rows emitted before a failure are still shown
+    Batches failed;
+    ProviderSession failing(provider, none, failed.Callback());
+    CHECK(failing.Run(View(Input(1, 'F')), L"/x/a.rows", L".rows") == LUMOS_PREVIEW_FAILED);
+    REQUIRE(failed.list.size() == 1);
+    CHECK(failed.list[0].failed);
+    CHECK_EQ(failed.list[0].rowCount, 1u);
+
+    // Not its format after all: nothing sent, the caller falls back
+    Batches unsupported;
+    ProviderSession declining(provider, none, unsupported.Callback());
+    CHECK(declining.Run(View("ROWS"), L"/x/a.rows", L".rows") == LUMOS_PREVIEW_UNSUPPORTED);
+    CHECK(unsupported.list.empty());
+}
+
+LUMOS_TEST(SessionStopsAtTheRowLimit) {
+    static const LumosProviderInfo info = RowsProvider();
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+
+    Batches batches;
+    CancellationToken none;
+    ProviderSession session(*registry.Providers()[0], none, batches.Callback());
+    CHECK(session.Run(View(Input(0xFF)), L"/x/a.rows", L".rows") == LUMOS_PREVIEW_OK);
+    CHECK_EQ(session.RowCount(), ProviderSession::MAX_ROWS);
+    REQUIRE(!batches.list.empty());
+    CHECK(batches.list.back().complete);
+    CHECK(batches.list.back().truncated);
+}
+
+LUMOS_TEST(SessionSplitsLargeOutput) {
+    static LumosProviderInfo info = RowsProvider();
+    info.preview = [](const LumosPreviewInput*, const LumosHost* host) {
+        std::string value(ProviderSession::MAX_VALUE_BYTES, 'v');
+        while (host->emit(host->context, "bulk", value.c_str())) {
+        }
+        return static_cast<int>(LUMOS_PREVIEW_OK);
+    };
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+    CancellationToken none;
+
+    // Consecutive batches of at most about MAX_BATCH_BYTES each
+    Batches batches;
+    ProviderSession session(*registry.Providers()[0], none, batches.Callback());
+    session.Run(View("x"), L"/x/a.rows", L".rows");
+    REQUIRE(batches.list.size() > 1);
+    uint32_t next = 0;
+    for (size_t i = 0; i < batches.list.size(); ++i) {
+        CHECK_EQ(batches.list[i].firstRow, next);
+        CHECK(batches.json[i].size() < ProviderSession::MAX_BATCH_BYTES + 2 * ProviderSession::MAX_VALUE_BYTES);
+        CHECK_EQ(batches.list[i].complete, i + 1 == batches.list.size());
+        next += batches.list[i].rowCount;
+    }
+    CHECK_EQ(next, ProviderSession::MAX_ROWS);
+
+    // The UI going away stops the provider at the first refused batch
+    Batches refused;
+    ProviderSession gone(*registry.Providers()[0], none, refused.Callback(false));
+    gone.Run(View("x"), L"/x/a.rows", L".rows");
+    CHECK_EQ(refused.list.size(), 1u);
+    CHECK(gone.RowCount() < ProviderSession::MAX_ROWS);
+}
+
+LUMOS_TEST(SessionStreamsWhileTheProviderRuns) {
+    static LumosProviderInfo info = RowsProvider();
+    info.flags = LUMOS_PROVIDER_STREAMING;
+    info.preview = [](const LumosPreviewInput*, const LumosHost* host) {
+        for (int i = 0; i < 6; ++i) {
+            host->emit(host->context, "tick", "");
+            std::this_thread::sleep_for(ProviderSession::STREAM_INTERVAL / 2);
+        }
+        return static_cast<int>(LUMOS_PREVIEW_OK);
+    };
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+    REQUIRE(registry.Providers()[0]->streaming);
+
+    Batches batches;
+    CancellationToken none;
+    ProviderSession session(*registry.Providers()[0], none, batches.Callback());
+    session.Run(View("x"), L"/x/a.rows", L".rows");
+    CHECK(batches.list.size() >= 2);
+    CHECK(!batches.list.front().complete);
+    CHECK(batches.list.back().complete);
+}
+
+LUMOS_TEST(SessionHonoursCancellation) {
+    static const LumosProviderInfo info = RowsProvider();
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+
+    CancellationSource cancellation;
+    CancellationToken token = cancellation.Token();
+    cancellation.Cancel();
+    Batches batches;
+    ProviderSession session(*registry.Providers()[0], token, batches.Callback());
+    CHECK(session.Run(View(Input(0xFF)), L"/x/a.rows", L".rows") == LUMOS_PREVIEW_CANCELLED);
+    CHECK(batches.list.empty());
+    CHECK_EQ(session.RowCount(), 0u);
+}
+
+LUMOS_TEST(SessionBoundsStrings) {
+    static LumosProviderInfo info = RowsProvider();
+    info.preview = [](const LumosPreviewInput*, const LumosHost* host) {
+        // The limit falls inside the two-byte é, which goes entirely
+        std::string name(ProviderSession::MAX_NAME_BYTES - 1, 'n');
+        name += "\xC3\xA9";
+        host->emit(host->context, name.c_str(), "say \"hi\"");
+        host->emit(host->context, "no value", nullptr);
+        return static_cast<int>(LUMOS_PREVIEW_OK);
+    };
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(&info));
+
+    Batches batches;
+    CancellationToken none;
+    ProviderSession session(*registry.Providers()[0], none, batches.Callback());
+    session.Run(View("x"), L"/x/a.rows", L".rows");
+    REQUIRE(batches.json.size() == 1);
+    CHECK_EQ(batches.json[0], "[{\"name\":\"" + std::string(ProviderSession::MAX_NAME_BYTES - 1, 'n') +
+                              "\",\"value\":\"say \\\"hi\\\"\"},{\"name\":\"no value\",\"value\":\"\"}]");
+}
+
+LUMOS_TEST(LoadsTheSampleProvider) {
+    std::wstring error;
+    auto library = ProviderLibrary::Load(FromUtf8(LUMOS_SAMPLE_PROVIDER), error);
+    REQUIRE(library != nullptr);
+    const LumosProviderInfo* info = library->Info();
+    CHECK_EQ(std::string(info->name), "Netpbm images");
+
+    ProviderRegistry registry;
+    REQUIRE(registry.Add(info, std::move(library)));
+    registry.Build();
+    ProviderMatch match = registry.Resolve(L".PPM");
+    REQUIRE(match.provider != nullptr);
+    CHECK(!match.provider->library.empty());
+
+    std::string ppm = "P6\n# made by hand\n3 2\n255\n";
+    CHECK(registry.Sniff(View(ppm)).provider == match.provider);
+    CHECK(!registry.Sniff(View("P6 is a text line")));
+
+    Batches batches;
+    CancellationToken none;
+    ProviderSession session(*match.provider, none, batches.Callback());
+    CHECK(session.Run(View(ppm + std::string(18, '\x7F')), L"/x/a.ppm", L".ppm") == LUMOS_PREVIEW_OK);
+    REQUIRE(batches.json.size() == 1);
+    const std::string& rows = batches.json[0];
+    CHECK(rows.find("{\"name\":\"Dimensions\",\"value\":\"3 x 2\"}") != std::string::npos);
+    CHECK(rows.find("{\"name\":\"Raster bytes\",\"value\":\"18\"}") != std::string::npos);
+    CHECK(rows.find("{\"name\":\"Comment\",\"value\":\"made by hand\"}") != std::string::npos);
+    CHECK(rows.find("Truncated") == std::string::npos);
+
+    CHECK(!ProviderLibrary::Load(FromUtf8(Test::ScratchPath("missing.so")), error));
+    CHECK(!error.empty());
+}
+
+LUMOS_TEST(LoadsADirectory) {
+    ProviderRegistry registry;
+    std::wstring directory = std::filesystem::path(LUMOS_SAMPLE_PROVIDER).parent_path().wstring();
+    CHECK_EQ(ProviderLoader::LoadDirectory(directory, registry), 1u);
+    CHECK(registry.Resolve(L".pam").provider != nullptr);
+    CHECK_EQ(ProviderLoader::LoadDirectory(FromUtf8(Test::ScratchPath("none")), registry), 0u);
+}
@@ -0,0 +1,96 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "Check.h"
+#include "../memory/RequestArena.h"
+#include "PreviewRequest.h"
+
+using namespace Lumos;
+
+// Every global heap allocation in this executable, so a case can assert
+// that a steady-state request never reaches the heap at all
+namespace {
+    std::atomic<size_t> g_heapAllocations{ 0 };
+
+    class HeapCounter {
+    public:
+        HeapCounter() : m_start(g_heapAllocations.load()) {}
+        size_t Count() const { return g_heapAllocations.load() - m_start; }
+
+    private:
+        size_t m_start;
+    };
+
+    // What the pipeline allocates per press: the request's strings and its JSON
+    void BuildRequest(RequestArena& arena, uint64_t generation) {
+        PreviewRequest request(arena.Resource());
+        request.generation = generation;
+        request.path = L"C:\\Users\\someone\\Downloads\\A rather long folder name\\holiday photo 0042.jpeg";
+        request.extension = L".jpeg";
+        request.size = 6291456;
+        request.image = PreviewImageInfo{ 4000, 3000, 6, 8, 1, true };
+        std::pmr::string json(arena.Resource());
+        request.WriteJson(json);
+    }
+}
+
+void* operator new(size_t bytes) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+LUMOS_TEST(SteadyStateRequestsNeverTouchTheHeap) {
+    RequestArena arena;
+    for (uint64_t generation = 1; generation <= 4; ++generation) {
+        arena.Reset();
+        BuildRequest(arena, generation);
+    }
+
+    for (uint64_t generation = 5; generation <= 100; ++generation) {
+        arena.Reset();
+        HeapCounter heap;
+        BuildRequest(arena, generation);
+        CHECK_EQ(heap.Count(), 0u);
+        CHECK_EQ(arena.UpstreamAllocations(), 0u);
+    }
+}
+
+LUMOS_TEST(SpillGrowsTheInlineBuffer) {
+    RequestArena arena(1024);
+    {
+        std::pmr::string big(arena.Resource());
+        big.assign(8000, 'x');
+        CHECK(arena.UpstreamAllocations() > 0);
+    }
+
+    arena.Reset();
+    CHECK(arena.Capacity() >= 8000u);
+    CHECK_EQ(arena.UpstreamAllocations(), 0u);
+
+    std::pmr::string again(arena.Resource());
+    again.assign(6000, 'y');
+    CHECK_EQ(arena.UpstreamAllocations(), 0u);
+}
+
+LUMOS_TEST(CapacityStopsGrowingAtTheCap) {
+    RequestArena arena(1024);
+    for (int i = 0; i < 8; ++i) {
+        {
+            std::pmr::string huge(arena.Resource());
+            huge.assign(16u * 1024 * 1024, 'z');
+        }
+        arena.Reset();
+    }
+    CHECK(arena.Capacity() <= 4u * 1024 * 1024);
+}
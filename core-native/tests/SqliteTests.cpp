@@ -0,0 +1,271 @@
+#include <algorithm>
+#include "Check.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../engines/sqlite/SqliteTableSql.h"
+
+using namespace Lumos;
+
+// Fixtures come from tests/data/sqlite/make_fixtures.py
+namespace {
+    struct Database {
+        explicit Database(std::string_view name) : bytes(Test::ReadData(name)), file(View()) {}
+
+        ByteView View() const { return ByteView(bytes.data(), bytes.size()); }
+
+        std::vector<uint8_t> bytes;
+        SqliteFile file;
+    };
+
+    const SqliteObject* Find(const SqliteSchema& schema, std::string_view name) {
+        for (const SqliteObject& object : schema.objects) {
+            if (object.name == name) {
+                return &object;
+            }
+        }
+        return nullptr;
+    }
+
+    const SqliteValue& Cell(const SqliteRows& rows, size_t row, size_t column) {
+        return rows.values[row * rows.columns.size() + column];
+    }
+}
+
+LUMOS_TEST(ReadsTheHeader) {
+    Database db("sqlite/basic.db");
+    REQUIRE(db.file.IsValid());
+    const SqliteHeader& header = db.file.Header();
+    CHECK_EQ(header.pageSize, 1024u);
+    CHECK_EQ(header.usableSize, 1024u);
+    CHECK_EQ(static_cast<size_t>(header.pageCount) * 1024, db.bytes.size());
+    CHECK_EQ(header.userVersion, 7u);
+    CHECK_EQ(header.applicationId, 1234u);
+    CHECK(header.encoding == SqliteTextEncoding::Utf8);
+    CHECK(!header.walMode);
+    CHECK(header.sqliteVersion >= 3000000u);
+}
+
+LUMOS_TEST(ReadsTheSchema) {
+    Database db("sqlite/basic.db");
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    const SqliteObject* items = Find(schema, "items");
+    REQUIRE(items != nullptr);
+    CHECK_EQ(items->type, "table");
+    CHECK(items->rootPage > 1);
+    CHECK(items->sql.rfind("CREATE TABLE items", 0) == 0);
+
+    const SqliteObject* index = Find(schema, "items_name");
+    REQUIRE(index != nullptr);
+    CHECK_EQ(index->type, "index");
+    CHECK_EQ(index->tableName, "items");
+    CHECK_EQ(Find(schema, "cheap")->rootPage, 0u);
+    CHECK_EQ(Find(schema, "items_touch")->type, "trigger");
+    // A WITHOUT ROWID table keeps its key in its own b-tree, with no automatic index
+    CHECK(Find(schema, "sqlite_autoindex_kv_1") == nullptr);
+
+    std::pmr::string json;
+    schema.WriteJson(json);
+    CHECK(json.find("\"odd \\\"name\\\"\"") != std::string::npos);
+}
+
+LUMOS_TEST(ReadsRowsInRowidOrder) {
+    Database db("sqlite/basic.db");
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    SqliteRows rows;
+    REQUIRE(db.file.ReadRows(*Find(schema, "items"), 0, 5, rows));
+    CHECK((rows.columns == std::vector<std::string>{ "id", "name", "price", "data", "note" }));
+    REQUIRE(rows.rowCount == 5);
+    CHECK(rows.more);
+
+    CHECK(Cell(rows, 0, 0).type == SqliteValueType::Integer);
+    CHECK_EQ(Cell(rows, 0, 0).integer, 1);
+    CHECK_EQ(Cell(rows, 0, 1).bytes, "item 00001");
+    CHECK(Cell(rows, 0, 2).type == SqliteValueType::Real);
+    CHECK_EQ(Cell(rows, 0, 2).real, 0.25);
+    CHECK(Cell(rows, 0, 3).type == SqliteValueType::Blob);
+    CHECK_EQ(Cell(rows, 0, 3).size, 2u);
+    CHECK(Cell(rows, 0, 4).type == SqliteValueType::Null);
+    CHECK_EQ(Cell(rows, 1, 4).integer, -2);
+    // 1.0 is stored as the integer 1; the REAL column makes it a real again
+    CHECK(Cell(rows, 3, 2).type == SqliteValueType::Real);
+    CHECK_EQ(Cell(rows, 3, 2).real, 1.0);
+
+    // Overflow pages: the size is the whole value, the bytes only a prefix
+    const SqliteValue& longName = Cell(rows, 1, 1);
+    CHECK(longName.truncated);
+    CHECK_EQ(longName.size, 5000u);
+    CHECK_EQ(longName.bytes, std::string(SqliteFile::MAX_VALUE_BYTES, 'x'));
+    const SqliteValue& longBlob = Cell(rows, 2, 4);
+    CHECK(longBlob.type == SqliteValueType::Blob);
+    CHECK_EQ(longBlob.size, 256u * 40);
+    CHECK(longBlob.truncated);
+    REQUIRE(longBlob.bytes.size() > 20);
+    CHECK_EQ(static_cast<uint8_t>(longBlob.bytes[20]), 20);
+}
+
+LUMOS_TEST(SkipsToARowDeepInTheTree) {
+    Database db("sqlite/basic.db");
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    const SqliteObject& items = *Find(schema, "items");
+
+    SqliteRows rows;
+    REQUIRE(db.file.ReadRows(items, 2500, 3, rows));
+    REQUIRE(rows.rowCount == 3);
+    CHECK_EQ(rows.firstRow, 2500u);
+    CHECK_EQ(Cell(rows, 0, 0).integer, 2501);
+    CHECK_EQ(Cell(rows, 2, 1).bytes, "item 02503");
+
+    REQUIRE(db.file.ReadRows(items, 2998, 10, rows));
+    CHECK_EQ(rows.rowCount, 2u);
+    CHECK(!rows.more);
+
+    REQUIRE(db.file.ReadRows(items, 5000, 10, rows));
+    CHECK_EQ(rows.rowCount, 0u);
+}
+
+LUMOS_TEST(ReadsWithoutRowidAndAddedColumns) {
+    Database db("sqlite/basic.db");
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    SqliteRows rows;
+    REQUIRE(db.file.ReadRows(*Find(schema, "kv"), 0, 1000, rows));
+    CHECK((rows.columns == std::vector<std::string>{ "k", "v", "flag" }));
+    REQUIRE(rows.rowCount == 501);
+    // Key order, the default for rows older than the column
+    CHECK_EQ(Cell(rows, 12, 0).bytes, "key012");
+    CHECK_EQ(Cell(rows, 12, 1).integer, 144);
+    CHECK_EQ(Cell(rows, 12, 2).bytes, "none");
+    CHECK_EQ(Cell(rows, 500, 0).bytes, "zzz");
+    CHECK_EQ(Cell(rows, 500, 2).bytes, "set");
+
+    // Quoted identifiers in every style
+    REQUIRE(db.file.ReadRows(*Find(schema, "odd \"name\""), 0, 10, rows));
+    CHECK((rows.columns == std::vector<std::string>{ "a b", "c" }));
+    CHECK_EQ(rows.rowCount, 1u);
+}
+
+LUMOS_TEST(RowsJson) {
+    Database db("sqlite/basic.db");
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    SqliteRows rows;
+    REQUIRE(db.file.ReadRows(*Find(schema, "items"), 0, 1, rows));
+    std::pmr::string json;
+    rows.WriteJson(json);
+    CHECK_EQ(std::string(json),
+             "{\"name\":\"items\",\"firstRow\":0,\"columns\":[\"id\",\"name\",\"price\",\"data\",\"note\"],"
+             "\"rows\":[[\"1\",\"item 00001\",\"0.25\",\"x'0100' (2 bytes)\",null]],\"more\":true}");
+
+    // As sqlite3 shows it: never a bare 1 in a REAL column
+    REQUIRE(db.file.ReadRows(*Find(schema, "items"), 3, 1, rows));
+    json.clear();
+    rows.WriteJson(json);
+    CHECK(json.find("\"item 00004\",\"1.0\"") != std::string::npos);
+}
+
+LUMOS_TEST(DecodesUtf16Text) {
+    Database db("sqlite/utf16.db");
+    REQUIRE(db.file.IsValid());
+    CHECK(db.file.Header().encoding == SqliteTextEncoding::Utf16le);
+    SqliteSchema schema;
+    REQUIRE(db.file.ReadSchema(schema));
+    REQUIRE(Find(schema, "words") != nullptr);
+    CHECK(Find(schema, "words")->sql.find("CREATE TABLE words") == 0);
+
+    SqliteRows rows;
+    REQUIRE(db.file.ReadRows(*Find(schema, "words"), 0, 10, rows));
+    REQUIRE(rows.rowCount == 3);
+    CHECK_EQ(Cell(rows, 0, 0).bytes, "h\xC3\xA9llo");
+    CHECK_EQ(Cell(rows, 1, 0).bytes, "\xD0\xBC\xD0\xB8\xD1\x80");
+    CHECK_EQ(Cell(rows, 2, 0).bytes, "\xF0\x9F\x98\x80");
+}
+
+LUMOS_TEST(SurvivesDamage) {
+    Database db("sqlite/basic.db");
+    REQUIRE(!db.bytes.empty());
+
+    // Cut short: the header's page count is clamped to the file
+    std::vector<uint8_t> cut(db.bytes.begin(), db.bytes.begin() + 20 * 1024 + 100);
+    SqliteFile truncated(ByteView(cut.data(), cut.size()));
+    REQUIRE(truncated.IsValid());
+    CHECK_EQ(truncated.Header().pageCount, 20u);
+    SqliteSchema schema;
+    truncated.ReadSchema(schema);
+    for (const SqliteObject& object : schema.objects) {
+        SqliteRows rows;
+        truncated.ReadRows(object, 0, 100, rows);
+    }
+
+    // Every interior table page pointing at itself: the walk must still end
+    std::vector<uint8_t> looped = db.bytes;
+    for (size_t page = 1; page < looped.size() / 1024; ++page) {
+        uint8_t* header = &looped[page * 1024];
+        if (header[0] == 0x05) {
+            header[8] = 0;
+            header[9] = 0;
+            header[10] = 0;
+            header[11] = static_cast<uint8_t>(page + 1);
+        }
+    }
+    SqliteFile cyclic(ByteView(looped.data(), looped.size()));
+    REQUIRE(cyclic.ReadSchema(schema));
+    SqliteRows rows;
+    cyclic.ReadRows(*Find(schema, "items"), 0, 100, rows);
+    CHECK(rows.rowCount <= 100);
+
+    std::vector<uint8_t> notSqlite = db.bytes;
+    notSqlite[0] = 'X';
+    CHECK(!SqliteFile(ByteView(notSqlite.data(), notSqlite.size())).IsValid());
+    CHECK(!SqliteFile(ByteView()).IsValid());
+}
+
+LUMOS_TEST(TableSqlLayouts) {
+    SqliteTableSql plain = SqliteTableSql::Parse(
+        "CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT DEFAULT 'x''y', n REAL DEFAULT -1.5, "
+        "CHECK (n > 0), FOREIGN KEY (id) REFERENCES other(id))");
+    REQUIRE(plain.columns.size() == 3);
+    CHECK(plain.columns[0].rowidAlias);
+    CHECK_EQ(plain.columns[1].defaultLiteral, "x'y");
+    CHECK(plain.columns[1].defaultIsText);
+    CHECK_EQ(plain.columns[2].defaultLiteral, "-1.5");
+    CHECK(!plain.withoutRowid);
+
+    // Table-level key: its columns go first in storage
+    SqliteTableSql keyed = SqliteTableSql::Parse(
+        "create table w (a, b text, c int, primary key (c, a)) without rowid");
+    REQUIRE(keyed.columns.size() == 3);
+    CHECK(keyed.withoutRowid);
+    CHECK((keyed.primaryKey == std::vector<size_t>{ 2, 0 }));
+    CHECK((keyed.StorageOrder() == std::vector<size_t>{ 2, 0, 1 }));
+
+    SqliteTableSql generated = SqliteTableSql::Parse(
+        "CREATE TABLE g (a INT, b INT GENERATED ALWAYS AS (a * 2) VIRTUAL, c INT AS (a + 1) STORED)");
+    REQUIRE(generated.columns.size() == 3);
+    CHECK(generated.columns[1].virtualGenerated);
+    CHECK(!generated.columns[2].virtualGenerated);
+    CHECK((generated.StorageOrder() == std::vector<size_t>{ 0, 2 }));
+
+    // Affinity by SQLite's rules: INT beats FLOAT, and no type is BLOB
+    SqliteTableSql typed = SqliteTableSql::Parse(
+        "CREATE TABLE r (a REAL, b double precision, c FLOAT, d FLOATING POINT, e INT, f, g VARCHAR(10))");
+    REQUIRE(typed.columns.size() == 7);
+    CHECK(typed.columns[0].realAffinity);
+    CHECK(typed.columns[1].realAffinity);
+    CHECK(typed.columns[2].realAffinity);
+    CHECK(!typed.columns[3].realAffinity);
+    CHECK(!typed.columns[4].realAffinity);
+    CHECK(!typed.columns[5].realAffinity);
+    CHECK(!typed.columns[6].realAffinity);
+
+    CHECK(!SqliteTableSql::Parse("CREATE VIRTUAL TABLE v USING fts5(x)").columns.size());
+    CHECK(!SqliteTableSql::Parse("CREATE TABLE t AS SELECT 1").columns.size());
+    CHECK(!SqliteTableSql::Parse("not sql at all (").columns.size());
+}
+
+LUMOS_TEST(SqliteHandlesExtension) {
+    CHECK(SqliteFile::HandlesExtension(L".SQLITE"));
+    CHECK(SqliteFile::HandlesExtension(L".db"));
+    CHECK(!SqliteFile::HandlesExtension(L".sql"));
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../engines/image/TiffReader.h"
+
+// Smallest well-formed headers of each format the engines read, built in
+// code so tests, fuzz seeds and benchmarks need no checked-in binaries.
+// None of them carries decodable pixel data unless it says so.
+namespace Lumos::TestImages {
+    using Bytes = std::vector<uint8_t>;
+
+    inline void PutU16BE(Bytes& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline void PutU32BE(Bytes& out, uint32_t value) {
+        PutU16BE(out, value >> 16);
+        PutU16BE(out, value & 0xFFFF);
+    }
+
+    inline void PutU16LE(Bytes& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    inline void PutU32LE(Bytes& out, uint32_t value) {
+        PutU16LE(out, value & 0xFFFF);
+        PutU16LE(out, value >> 16);
+    }
+
+    inline void PutText(Bytes& out, const char* text, size_t length) {
+        out.insert(out.end(), text, text + length);
+    }
+
+    inline void SetU32LE(Bytes& out, size_t at, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out[at + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // Little-endian TIFF laid out front to back: data first, then each IFD
+    // after whatever it points to, so every offset is known when written
+    class TiffBuilder {
+    public:
+        struct Entry {
+            uint16_t tag;
+            uint16_t type;  // 3 SHORT, 4 LONG, 7 UNDEFINED (values are bytes)
+            std::vector<uint32_t> values;
+        };
+
+        TiffBuilder() {
+            PutText(m_bytes, "II*\0", 4);
+            PutU32LE(m_bytes, 0);
+        }
+
+        // Offset of `length` bytes appended at the next even position
+        uint32_t Append(const uint8_t* data, size_t length) {
+            Align();
+            uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+            m_bytes.insert(m_bytes.end(), data, data + length);
+            return offset;
+        }
+
+        uint32_t Append(const Bytes& data) { return Append(data.data(), data.size()); }
+
+        uint32_t WriteIfd(std::vector<Entry> entries, uint32_t next = 0) {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+
+            // Values over four bytes go out of line, ahead of the IFD
+            std::vector<uint32_t> outOfLine(entries.size(), 0);
+            for (size_t i = 0; i < entries.size(); ++i) {
+                Bytes value = Encode(entries[i]);
+                if (value.size() > 4) {
+                    outOfLine[i] = Append(value);
+                }
+            }
+
+            Align();
+            uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+            PutU16LE(m_bytes, static_cast<uint32_t>(entries.size()));
+            for (size_t i = 0; i < entries.size(); ++i) {
+                const Entry& entry = entries[i];
+                PutU16LE(m_bytes, entry.tag);
+                PutU16LE(m_bytes, entry.type);
+                PutU32LE(m_bytes, static_cast<uint32_t>(entry.values.size()));
+                Bytes value = Encode(entry);
+                if (value.size() > 4) {
+                    PutU32LE(m_bytes, outOfLine[i]);
+                } else {
+                    value.resize(4, 0);
+                    m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+                }
+            }
+            PutU32LE(m_bytes, next);
+            return offset;
+        }
+
+        Bytes Finish(uint32_t firstIfd) {
+            SetU32LE(m_bytes, 4, firstIfd);
+            return m_bytes;
+        }
+
+    private:
+        void Align() {
+            if (m_bytes.size() & 1) {
+                m_bytes.push_back(0);
+            }
+        }
+
+        static Bytes Encode(const Entry& entry) {
+            Bytes value;
+            for (uint32_t v : entry.values) {
+                if (entry.type == 3) {
+                    PutU16LE(value, v);
+                } else if (entry.type == 4) {
+                    PutU32LE(value, v);
+                } else {
+                    value.push_back(static_cast<uint8_t>(v));
+                }
+            }
+            return value;
+        }
+
+        Bytes m_bytes;
+    };
+
+    // EXIF block with just an orientation in IFD0, as a JPEG APP1 carries it
+    inline Bytes ExifOrientation(uint16_t orientation) {
+        TiffBuilder tiff;
+        return tiff.Finish(tiff.WriteIfd({ { TiffTag::Orientation, 3, { orientation } } }));
+    }
+
+    // SOI, optional EXIF orientation, SOF0 (8-bit, three components), a
+    // token scan of `scanBytes`, EOI
+    inline Bytes Jpeg(uint32_t width, uint32_t height, uint16_t orientation = 0, size_t scanBytes = 16) {
+        Bytes out = { 0xFF, 0xD8 };
+        if (orientation != 0) {
+            Bytes exif = ExifOrientation(orientation);
+            out.push_back(0xFF);
+            out.push_back(0xE1);
+            PutU16BE(out, static_cast<uint32_t>(2 + 6 + exif.size()));
+            PutText(out, "Exif\0\0", 6);
+            out.insert(out.end(), exif.begin(), exif.end());
+        }
+        out.push_back(0xFF);
+        out.push_back(0xC0);
+        PutU16BE(out, 17);
+        out.push_back(8);
+        PutU16BE(out, height);
+        PutU16BE(out, width);
+        out.push_back(3);
+        for (uint8_t component = 1; component <= 3; ++component) {
+            out.push_back(component);
+            out.push_back(component == 1 ? 0x22 : 0x11);
+            out.push_back(component == 1 ? 0 : 1);
+        }
+        out.push_back(0xFF);
+        out.push_back(0xDA);
+        PutU16BE(out, 12);
+        out.push_back(3);
+        for (uint8_t component = 1; component <= 3; ++component) {
+            out.push_back(component);
+            out.push_back(component == 1 ? 0x00 : 0x11);
+        }
+        out.push_back(0);
+        out.push_back(63);
+        out.push_back(0);
+        for (size_t i = 0; i < scanBytes; ++i) {
+            out.push_back(static_cast<uint8_t>(0x55 + i % 64));
+        }
+        out.push_back(0xFF);
+        out.push_back(0xD9);
+        return out;
+    }
+
+    inline void PutPngChunk(Bytes& out, const char* type, const Bytes& data) {
+        PutU32BE(out, static_cast<uint32_t>(data.size()));
+        PutText(out, type, 4);
+        out.insert(out.end(), data.begin(), data.end());
+        PutU32BE(out, 0);  // CRC: the probe does not check it
+    }
+
+    inline Bytes Png(uint32_t width, uint32_t height, uint8_t bitDepth = 8, uint8_t colorType = 6,
+                     bool iccProfile = false, uint32_t frames = 0) {
+        Bytes out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        Bytes header;
+        PutU32BE(header, width);
+        PutU32BE(header, height);
+        header.push_back(bitDepth);
+        header.push_back(colorType);
+        header.push_back(0);
+        header.push_back(0);
+        header.push_back(0);
+        PutPngChunk(out, "IHDR", header);
+        if (frames > 0) {
+            Bytes animation;
+            PutU32BE(animation, frames);
+            PutU32BE(animation, 0);
+            PutPngChunk(out, "acTL", animation);
+        }
+        if (iccProfile) {
+            PutPngChunk(out, "iCCP", Bytes{ 'i', 'c', 'c', 0, 0, 0x78, 0x9C });
+        }
+        PutPngChunk(out, "IDAT", Bytes(16, 0));
+        PutPngChunk(out, "IEND", Bytes());
+        return out;
+    }
+
+    inline Bytes Gif(uint32_t width, uint32_t height, uint32_t frames = 1) {
+        Bytes out;
+        PutText(out, "GIF89a", 6);
+        PutU16LE(out, width);
+        PutU16LE(out, height);
+        out.push_back(0x80 | 0x07);  // 256-entry global color table
+        out.push_back(0);
+        out.push_back(0);
+        out.resize(out.size() + 3 * 256, 0);
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            out.push_back(0x2C);
+            PutU16LE(out, 0);
+            PutU16LE(out, 0);
+            PutU16LE(out, width);
+            PutU16LE(out, height);
+            out.push_back(0);
+            out.push_back(8);     // LZW minimum code size
+            out.push_back(2);     // One sub-block
+            out.push_back(0x4C);
+            out.push_back(0x01);
+            out.push_back(0);     // Block terminator
+        }
+        out.push_back(0x3B);
+        return out;
+    }
+
+    inline Bytes Bmp(int32_t width, int32_t height, uint16_t bitsPerPixel = 24) {
+        Bytes out = { 'B', 'M' };
+        PutU32LE(out, 54);
+        PutU32LE(out, 0);
+        PutU32LE(out, 54);
+        PutU32LE(out, 40);
+        PutU32LE(out, static_cast<uint32_t>(width));
+        PutU32LE(out, static_cast<uint32_t>(height));
+        PutU16LE(out, 1);
+        PutU16LE(out, bitsPerPixel);
+        out.resize(54, 0);
+        return out;
+    }
+
+    // Lossless WebP (VP8L) header
+    inline Bytes WebP(uint32_t width, uint32_t height, bool alpha = true) {
+        Bytes out;
+        PutText(out, "RIFF", 4);
+        PutU32LE(out, 4 + 8 + 6);
+        PutText(out, "WEBPVP8L", 8);
+        PutU32LE(out, 5);
+        out.push_back(0x2F);
+        PutU32LE(out, (width - 1) | ((height - 1) << 14) | ((alpha ? 1u : 0u) << 28));
+        out.push_back(0);  // Pad to even
+        return out;
+    }
+
+    // Channel `channel` (R, G, B) of the pixel at (x, y) in RgbTiff images
+    inline uint8_t PixelChannel(uint32_t x, uint32_t y, uint32_t channel) {
+        return static_cast<uint8_t>(channel == 0 ? x : channel == 1 ? y : (x ^ y));
+    }
+
+    // Uncompressed 8-bit RGB TIFF, tiled when `tile` is non-zero
+    inline Bytes RgbTiff(uint32_t width, uint32_t height, uint32_t tile) {
+        TiffBuilder tiff;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> counts;
+        uint32_t chunkWidth = tile ? tile : width;
+        uint32_t chunkHeight = tile ? tile : height;
+        for (uint32_t top = 0; top < height; top += chunkHeight) {
+            for (uint32_t left = 0; left < width; left += chunkWidth) {
+                Bytes chunk;
+                for (uint32_t y = top; y < top + chunkHeight; ++y) {
+                    for (uint32_t x = left; x < left + chunkWidth; ++x) {
+                        for (uint32_t c = 0; c < 3; ++c) {
+                            chunk.push_back(x < width && y < height ? PixelChannel(x, y, c) : 0);
+                        }
+                    }
+                }
+                offsets.push_back(tiff.Append(chunk));
+                counts.push_back(static_cast<uint32_t>(chunk.size()));
+            }
+        }
+
+        std::vector<TiffBuilder::Entry> entries = {
+            { TiffTag::ImageWidth, 4, { width } },
+            { TiffTag::ImageLength, 4, { height } },
+            { TiffTag::BitsPerSample, 3, { 8, 8, 8 } },
+            { TiffTag::Compression, 3, { 1 } },
+            { TiffTag::Photometric, 3, { 2 } },
+            { TiffTag::SamplesPerPixel, 3, { 3 } },
+            { TiffTag::PlanarConfiguration, 3, { 1 } },
+        };
+        if (tile) {
+            entries.push_back({ TiffTag::TileWidth, 4, { tile } });
+            entries.push_back({ TiffTag::TileLength, 4, { tile } });
+            entries.push_back({ TiffTag::TileOffsets, 4, offsets });
+            entries.push_back({ TiffTag::TileByteCounts, 4, counts });
+        } else {
+            entries.push_back({ TiffTag::RowsPerStrip, 4, { height } });
+            entries.push_back({ TiffTag::StripOffsets, 4, offsets });
+            entries.push_back({ TiffTag::StripByteCounts, 4, counts });
+        }
+        return tiff.Finish(tiff.WriteIfd(entries));
+    }
+
+    // A camera-style TIFF/RAW: IFD0 with a small JPEG thumbnail, and a
+    // SubIFD holding a larger preview JPEG
+    inline Bytes RawWithPreviews(uint32_t thumbnailEdge, uint32_t previewEdge, uint16_t orientation = 1) {
+        TiffBuilder tiff;
+        Bytes thumbnail = Jpeg(thumbnailEdge, thumbnailEdge * 3 / 4);
+        Bytes preview = Jpeg(previewEdge, previewEdge * 2 / 3, 0, 256);
+        uint32_t thumbnailAt = tiff.Append(thumbnail);
+        uint32_t previewAt = tiff.Append(preview);
+        uint32_t sub = tiff.WriteIfd({
+            { TiffTag::NewSubfileType, 4, { 1 } },
+            { TiffTag::Compression, 3, { 7 } },
+            { TiffTag::JpegInterchangeFormat, 4, { previewAt } },
+            { TiffTag::JpegInterchangeFormatLength, 4, { static_cast<uint32_t>(preview.size()) } },
+        });
+        uint32_t ifd0 = tiff.WriteIfd({
+            { TiffTag::ImageWidth, 4, { 6000 } },
+            { TiffTag::ImageLength, 4, { 4000 } },
+            { TiffTag::Orientation, 3, { orientation } },
+            { TiffTag::JpegInterchangeFormat, 4, { thumbnailAt } },
+            { TiffTag::JpegInterchangeFormatLength, 4, { static_cast<uint32_t>(thumbnail.size()) } },
+            { TiffTag::SubIFDs, 4, { sub } },
+        });
+        return tiff.Finish(ifd0);
+    }
+}
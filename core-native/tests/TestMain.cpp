@@ -0,0 +1,108 @@
+// Runs the LUMOS_TEST cases linked into this executable.
+//
+//   <tests> [name-substring]
+//
+// Exits 1 if any case failed. Test executables also serve as decoder
+// workers, since DecoderPool launches its own executable for them.
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+#include "Check.h"
+#include "../worker/DecoderWorker.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace Lumos::Test {
+    namespace {
+        struct Case {
+            const char* name;
+            CaseFunction run;
+        };
+
+        std::vector<Case>& Cases() {
+            static std::vector<Case> cases;
+            return cases;
+        }
+
+        size_t g_failures = 0;
+
+        std::filesystem::path ScratchRoot() {
+            static const std::filesystem::path root = std::filesystem::temp_directory_path() /
+                ("lumos-tests-" + std::to_string(getpid()));
+            return root;
+        }
+    }
+
+    Registration::Registration(const char* name, CaseFunction run) {
+        Cases().push_back({ name, run });
+    }
+
+    void Fail(const char* file, int line, const std::wstring& message) {
+        ++g_failures;
+        std::wcerr << FromUtf8(file) << L":" << line << L": " << message << std::endl;
+    }
+
+    std::wstring ScratchDirectory() {
+        return ScratchRoot().wstring();
+    }
+
+    std::string ScratchPath(std::string_view name) {
+        return (ScratchRoot() / std::string(name)).string();
+    }
+
+    std::vector<uint8_t> ReadData(std::string_view name) {
+        std::ifstream in(std::filesystem::path(LUMOS_TEST_DATA) / std::string(name), std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace Lumos;
+    if (DecoderWorker::IsWorkerCommandLine(argc, argv)) {
+        return DecoderWorker().Run(argc, argv);
+    }
+
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    size_t run = 0;
+    size_t failed = 0;
+    for (const auto& testCase : Test::Cases()) {
+        if (filter && !std::strstr(testCase.name, filter)) {
+            continue;
+        }
+        std::error_code ignored;
+        std::filesystem::remove_all(Test::ScratchRoot(), ignored);
+        std::filesystem::create_directories(Test::ScratchRoot(), ignored);
+
+        size_t failuresBefore = Test::g_failures;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            testCase.run();
+        } catch (const Test::Stop&) {
+        } catch (const std::exception& e) {
+            Test::Fail(testCase.name, 0, L"threw " + FromUtf8(e.what()));
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        ++run;
+        bool passed = Test::g_failures == failuresBefore;
+        failed += passed ? 0 : 1;
+        std::wcout << (passed ? L"[pass] " : L"[FAIL] ") << FromUtf8(testCase.name) << L" (" << elapsed.count()
+                   << L" ms)" << std::endl;
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(Test::ScratchRoot(), ignored);
+    std::wcout << run << L" case(s), " << failed << L" failed" << std::endl;
+    return failed == 0 && run > 0 ? 0 : 1;
+}
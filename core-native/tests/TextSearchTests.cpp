@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <random>
+#include "Check.h"
+#include "../engines/text/TextSearch.h"
+
+using namespace Lumos;
+
+namespace {
+    ByteView View(const std::string& text) {
+        return ByteView(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    }
+
+    // Text over a small alphabet so short patterns hit often, with lines of
+    // varying length; larger than a few chunks so matches straddle their ends
+    std::string RandomText(size_t bytes, uint32_t seed) {
+        std::mt19937 random(seed);
+        static constexpr char ALPHABET[] = "abcab \n";
+        std::string text(bytes, ' ');
+        for (char& c : text) {
+            c = ALPHABET[random() % (sizeof(ALPHABET) - 1)];
+        }
+        return text;
+    }
+
+    // What an editor's Find Next would step through
+    std::vector<TextMatch> Reference(const std::string& text, const std::string& pattern) {
+        std::vector<TextMatch> matches;
+        uint64_t line = 0;
+        size_t lineCounted = 0;
+        for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + pattern.size())) {
+            line += static_cast<uint64_t>(std::count(text.begin() + static_cast<ptrdiff_t>(lineCounted),
+                                                     text.begin() + static_cast<ptrdiff_t>(at), '\n'));
+            lineCounted = at;
+            matches.push_back(TextMatch{ at, static_cast<uint32_t>(pattern.size()), line });
+        }
+        return matches;
+    }
+
+    TextSearchSummary Search(TextSearch& search, const std::string& text, TextSearchOptions options) {
+        std::string error;
+        if (!search.Compile(options, error)) {
+            Test::Fail(__FILE__, __LINE__, L"Compile failed: " + FromUtf8(error));
+            throw Test::Stop();
+        }
+        return search.Run(View(text), CancellationToken());
+    }
+}
+
+LUMOS_TEST(LiteralMatchesTheReference) {
+    WorkerPool workers(4);
+    TextSearch search(workers);
+    std::string text = RandomText(3 * TextSearch::CHUNK_SIZE + 12345, 1);
+    for (std::string pattern : { "a", "ab", "abc", "cab", "a b", "b\na", "abcabc", "bbbbbbbbbbbb" }) {
+        TextSearchSummary summary = Search(search, text, { pattern });
+        std::vector<TextMatch> expected = Reference(text, pattern);
+        if (expected.size() > TextSearch::MAX_MATCHES) {
+            CHECK(summary.truncated);
+            expected.resize(TextSearch::MAX_MATCHES);
+        } else {
+            CHECK(!summary.truncated);
+            CHECK_EQ(summary.scannedBytes, text.size());
+        }
+        REQUIRE(search.MatchCount() == expected.size());
+
+        std::vector<TextMatch> actual = search.Matches(0, expected.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            bool same = actual[i].offset == expected[i].offset && actual[i].length == expected[i].length &&
+                        actual[i].line == expected[i].line;
+            mismatches += same ? 0 : 1;
+        }
+        CHECK_EQ(mismatches, 0u);
+    }
+}
+
+LUMOS_TEST(IgnoreCaseFoldsBeyondAscii) {
+    WorkerPool workers(2);
+    TextSearch search(workers);
+    // Unaccented letters: the fold covers the basic Greek alphabet only
+    std::string text = "Ошибка: ОШИБКА ошибка\nΣφαλμα σφαλμα ΣΦΑΛΜΑ\nERROR error Error\n";
+
+    TextSearchOptions options{ "ошибка", true };
+    CHECK_EQ(Search(search, text, options).matches, 3u);
+    options.pattern = "ΣΦΑΛΜΑ";
+    CHECK_EQ(Search(search, text, options).matches, 3u);
+    options.pattern = "eRrOr";
+    CHECK_EQ(Search(search, text, options).matches, 3u);
+
+    std::vector<TextMatch> matches = search.Matches(0, 3);
+    CHECK_EQ(matches[0].line, 2u);
+    CHECK_EQ(matches[2].offset, text.rfind("Error"));
+
+    options.ignoreCase = false;
+    CHECK_EQ(Search(search, text, options).matches, 0u);
+}
+
+LUMOS_TEST(RegexMatchesWithinLines) {
+    WorkerPool workers(2);
+    TextSearch search(workers);
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += (i % 3 == 0 ? "id=" : "name=") + std::to_string(i) + "\n";
+    }
+    TextSearchOptions options{ "^id=[0-9]*7$", false, true };
+    TextSearchSummary summary = Search(search, text, options);
+    CHECK_EQ(summary.matches, 33u);
+    std::vector<TextMatch> first = search.Matches(0, 1);
+    REQUIRE(first.size() == 1);
+    CHECK_EQ(first[0].line, 27u);
+    CHECK_EQ(first[0].length, 5u);
+
+    // '.' never crosses a line break
+    options.pattern = "=1.n";
+    CHECK_EQ(Search(search, text, options).matches, 0u);
+}
+
+LUMOS_TEST(CompileRejectsBadPatterns) {
+    WorkerPool workers(1);
+    TextSearch search(workers);
+    std::string error;
+    CHECK(!search.Compile({ "" }, error));
+    CHECK(!error.empty());
+    error.clear();
+    CHECK(!search.Compile({ "(unclosed", false, true }, error));
+    CHECK(!error.empty());
+}
+
+LUMOS_TEST(MatchesArePublishedInOrder) {
+    WorkerPool workers(4);
+    TextSearch search(workers);
+    std::string text = RandomText(4 * TextSearch::CHUNK_SIZE, 2);
+    std::string error;
+    REQUIRE(search.Compile({ "abcab" }, error));
+
+    uint64_t lastOffset = 0;
+    uint64_t lastScanned = 0;
+    size_t calls = 0;
+    bool ordered = true;
+    TextSearchSummary summary = search.Run(View(text), CancellationToken(),
+                                           [&](const TextMatch* matches, size_t count, uint64_t scanned) {
+        ++calls;
+        for (size_t i = 0; i < count; ++i) {
+            ordered &= matches[i].offset >= lastOffset;
+            lastOffset = matches[i].offset;
+        }
+        ordered &= scanned >= lastScanned;
+        lastScanned = scanned;
+        return true;
+    });
+    CHECK(ordered);
+    CHECK(calls > 1);
+    CHECK_EQ(lastScanned, text.size());
+    CHECK_EQ(summary.matches, static_cast<uint64_t>(search.MatchCount()));
+
+    // Lookup by offset for "next match from the cursor"
+    std::vector<TextMatch> all = search.Matches(0, search.MatchCount());
+    CHECK_EQ(search.FindMatchAt(0), 0u);
+    CHECK_EQ(search.FindMatchAt(all[10].offset), 10u);
+    CHECK_EQ(search.FindMatchAt(all[10].offset + 1), 11u);
+    CHECK_EQ(search.FindMatchAt(text.size()), search.MatchCount());
+}
+
+LUMOS_TEST(StopsWhenCancelled) {
+    WorkerPool workers(2);
+    TextSearch search(workers);
+    std::string text = RandomText(8 * TextSearch::CHUNK_SIZE, 3);
+    std::string error;
+    REQUIRE(search.Compile({ "abcabc" }, error));
+
+    CancellationSource cancellation;
+    cancellation.Cancel();
+    TextSearchSummary summary = search.Run(View(text), cancellation.Token());
+    CHECK(summary.cancelled);
+    CHECK(summary.scannedBytes < text.size());
+
+    // The callback refusing more also ends the scan
+    summary = search.Run(View(text), CancellationToken(), [](const TextMatch*, size_t, uint64_t) { return false; });
+    CHECK(summary.scannedBytes < text.size());
+}
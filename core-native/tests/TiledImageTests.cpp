@@ -0,0 +1,146 @@
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include "Check.h"
+#include "TestImages.h"
+#include "../engines/tiles/RawTiffTileSource.h"
+#include "../engines/tiles/TiledImage.h"
+#include "../memory/MemoryGovernor.h"
+
+using namespace Lumos;
+using namespace Lumos::TestImages;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr uint32_t WIDTH = 600;
+    constexpr uint32_t HEIGHT = 400;
+
+    std::wstring WriteTiff(std::string_view name, uint32_t tile) {
+        Bytes tiff = RgbTiff(WIDTH, HEIGHT, tile);
+        std::string path = Test::ScratchPath(name);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(tiff.data()),
+                                                    static_cast<std::streamsize>(tiff.size()));
+        return FromUtf8(path);
+    }
+
+    bool MatchesImage(const uint8_t* bgra, uint32_t x, uint32_t y) {
+        return bgra[0] == PixelChannel(x, y, 2) && bgra[1] == PixelChannel(x, y, 1) &&
+               bgra[2] == PixelChannel(x, y, 0) && bgra[3] == 255;
+    }
+
+    // Tiles announced by the callback, waited for by the test
+    class ReadyTiles {
+    public:
+        void Add(const std::shared_ptr<const Tile>& tile) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.insert(TileCache::Key(tile->level, tile->x, tile->y));
+            m_changed.notify_all();
+        }
+
+        bool WaitFor(uint32_t level, uint32_t x, uint32_t y) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, 5s, [&] { return m_ready.count(TileCache::Key(level, x, y)) > 0; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::set<uint64_t> m_ready;
+    };
+}
+
+LUMOS_TEST(RawTiffDecodesFullResolutionRegions) {
+    for (uint32_t tile : { 0u, 64u }) {
+        auto source = RawTiffTileSource::Open(WriteTiff(tile ? "tiled.tif" : "stripped.tif", tile));
+        REQUIRE(source != nullptr);
+        CHECK_EQ(source->Width(), WIDTH);
+        CHECK_EQ(source->Height(), HEIGHT);
+
+        // Straddles tile boundaries on both axes
+        TileRegion region{ 50, 40, 100, 60 };
+        std::vector<uint8_t> pixels(region.width * region.height * 4);
+        REQUIRE(source->DecodeRegion(region, 0, pixels.data(), region.width * 4, {}));
+        size_t mismatches = 0;
+        for (uint32_t y = 0; y < region.height; ++y) {
+            for (uint32_t x = 0; x < region.width; ++x) {
+                mismatches += MatchesImage(&pixels[(y * region.width + x) * 4], region.x + x, region.y + y) ? 0 : 1;
+            }
+        }
+        CHECK_EQ(mismatches, 0u);
+    }
+}
+
+LUMOS_TEST(RawTiffDownsamplesByLevel) {
+    auto source = RawTiffTileSource::Open(WriteTiff("tiled.tif", 64));
+    REQUIRE(source != nullptr);
+
+    // ceil(600 / 4) x ceil(3 / 4); each output pixel averages four samples
+    // spread across its 4x4 cell
+    TileRegion region{ 0, 0, WIDTH, 3 };
+    std::vector<uint8_t> pixels(150 * 1 * 4);
+    REQUIRE(source->DecodeRegion(region, 2, pixels.data(), 150 * 4, {}));
+    for (uint32_t ox : { 0u, 7u, 149u }) {
+        uint32_t x = ox * 4;
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            uint32_t sum = PixelChannel(x, 0, channel) + PixelChannel(x + 2, 0, channel) +
+                           PixelChannel(x, 2, channel) + PixelChannel(x + 2, 2, channel);
+            CHECK_EQ(pixels[ox * 4 + 2 - channel], static_cast<uint8_t>((sum + 2) >> 2));
+        }
+    }
+}
+
+LUMOS_TEST(RawTiffRejectsOtherLayouts) {
+    std::string path = Test::ScratchPath("not.tif");
+    Bytes png = Png(10, 10);
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(png.data()),
+                                                static_cast<std::streamsize>(png.size()));
+    CHECK(RawTiffTileSource::Open(FromUtf8(path)) == nullptr);
+    CHECK(RawTiffTileSource::Open(FromUtf8(Test::ScratchPath("missing.tif"))) == nullptr);
+}
+
+LUMOS_TEST(PyramidLevels) {
+    WorkerPool workers(2);
+    MemoryGovernor governor;
+    TiledImage image(RawTiffTileSource::Open(WriteTiff("tiled.tif", 64)), workers, governor);
+    CHECK_EQ(image.LevelCount(), 3u);
+    CHECK_EQ(image.TilesAcross(0), 3u);
+    CHECK_EQ(image.TilesDown(0), 2u);
+    CHECK_EQ(image.TilesAcross(2), 1u);
+    CHECK_EQ(image.LevelForZoom(1.0), 0u);
+    CHECK_EQ(image.LevelForZoom(0.5), 1u);
+    CHECK_EQ(image.LevelForZoom(0.3), 1u);
+    CHECK_EQ(image.LevelForZoom(0.25), 2u);
+    CHECK_EQ(image.LevelForZoom(0.001), 2u);
+}
+
+LUMOS_TEST(ViewportDecodesVisibleTiles) {
+    WorkerPool workers(2);
+    MemoryGovernor governor;
+    ReadyTiles ready;
+    TiledImage image(RawTiffTileSource::Open(WriteTiff("tiled.tif", 64)), workers, governor,
+                     [&ready](const std::shared_ptr<const Tile>& tile) { ready.Add(tile); });
+
+    // Whole image in a small window: the single top-level tile
+    image.SetViewport({ WIDTH / 2.0, HEIGHT / 2.0, 0.25, 150, 100 });
+    REQUIRE(ready.WaitFor(2, 0, 0));
+    auto top = image.GetTile(2, 0, 0);
+    REQUIRE(top != nullptr);
+    CHECK_EQ(top->width, 150u);
+    CHECK_EQ(top->height, 100u);
+
+    // Bottom-right corner at actual size: the narrow edge tile
+    image.SetViewport({ WIDTH - 40.0, HEIGHT - 40.0, 1.0, 80, 80 });
+    REQUIRE(ready.WaitFor(0, 2, 1));
+    auto edge = image.GetTile(0, 2, 1);
+    REQUIRE(edge != nullptr);
+    CHECK_EQ(edge->width, WIDTH - 512);
+    CHECK_EQ(edge->height, HEIGHT - 256);
+    CHECK(MatchesImage(&edge->pixels[0], 512, 256));
+
+    // A tile not decoded yet is covered by the coarser one
+    auto covering = image.CoveringTile(0, 0, 0);
+    CHECK(covering != nullptr);
+    CHECK(image.Stats().decoded >= 2);
+}
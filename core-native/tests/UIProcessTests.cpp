@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "Check.h"
+#include "../ipc/ProcessLauncher.h"
+#include "../ipc/UIProcessSupervisor.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+// The UI here is tests/stub/StubUi.cpp; see there for the modes
+namespace {
+    class StubMode {
+    public:
+        explicit StubMode(const char* mode, const char* delayMs = "100") {
+            setenv("LUMOS_STUB_UI", mode, 1);
+            setenv("LUMOS_STUB_UI_DELAY_MS", delayMs, 1);
+        }
+        ~StubMode() {
+            unsetenv("LUMOS_STUB_UI");
+            unsetenv("LUMOS_STUB_UI_DELAY_MS");
+            unsetenv("LUMOS_STUB_UI_LOG");
+        }
+    };
+
+    const std::wstring& StubPath() {
+        static const std::wstring path = FromUtf8(LUMOS_STUB_UI);
+        return path;
+    }
+
+    size_t CountLines(const std::string& path) {
+        std::ifstream in(path);
+        size_t lines = 0;
+        for (std::string line; std::getline(in, line);) {
+            ++lines;
+        }
+        return lines;
+    }
+
+    void Shutdown(ProcessLauncher& launcher) {
+        launcher.Terminate();
+        CHECK(launcher.WaitForExit(5s));
+        CHECK(!launcher.HasProcess());
+    }
+}
+
+LUMOS_TEST(LauncherWaitsForTheReadySignal) {
+    StubMode mode("slow", "200");
+    auto launcher = CreateProcessLauncher();
+    REQUIRE(launcher->FileExists(StubPath()));
+    REQUIRE(launcher->Launch(StubPath()));
+    CHECK(!launcher->IsReady());
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(launcher->WaitUntilReady(10s));
+    auto waited = std::chrono::steady_clock::now() - start;
+    CHECK(waited >= 150ms);
+    CHECK(waited < 5s);
+    CHECK(launcher->IsReady());
+    Shutdown(*launcher);
+    CHECK(!launcher->IsReady());
+}
+
+LUMOS_TEST(UiExitingBeforeReadyFailsFast) {
+    StubMode mode("exit");
+    auto launcher = CreateProcessLauncher();
+    REQUIRE(launcher->Launch(StubPath()));
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!launcher->WaitUntilReady(10s));
+    CHECK(std::chrono::steady_clock::now() - start < 5s);
+    CHECK(launcher->WaitForExit(5s));
+}
+
+LUMOS_TEST(SilentUiTimesOut) {
+    StubMode mode("silent");
+    auto launcher = CreateProcessLauncher();
+    REQUIRE(launcher->Launch(StubPath()));
+    CHECK(!launcher->WaitUntilReady(200ms));
+    CHECK(launcher->HasProcess());
+    CHECK(!launcher->IsReady());
+    Shutdown(*launcher);
+}
+
+// A stale LUMOS_READY_FD in our own environment (Lumos started by a
+// launcher itself) must not reach the UI alongside the real one
+LUMOS_TEST(ReplacesAnInheritedReadyVariable) {
+    StubMode mode("ready");
+    setenv(ProcessLauncher::READY_FD_VARIABLE, "99", 1);
+    auto launcher = CreateProcessLauncher();
+    REQUIRE(launcher->Launch(StubPath()));
+    CHECK(launcher->WaitUntilReady(10s));
+    unsetenv(ProcessLauncher::READY_FD_VARIABLE);
+    Shutdown(*launcher);
+}
+
+// Cold start to a usable UI, as the first Spacebar press sees it
+LUMOS_TEST(SupervisorStartsTheUiOnDemand) {
+    StubMode mode("ready");
+    auto owned = CreateProcessLauncher();
+    ProcessLauncher& launcher = *owned;
+    UIProcessSupervisor supervisor(std::move(owned), { L"/nonexistent/lumos-ui", StubPath() });
+    CHECK(!supervisor.IsReady());
+    CHECK(supervisor.EnsureReady(10s));
+    CHECK(supervisor.IsReady());
+    CHECK(supervisor.LastStartupTime() < 5000ms);
+    std::wcout << L"Cold start to ready: " << supervisor.LastStartupTime().count() << L" ms" << std::endl;
+
+    // Ready already: no second launch
+    CHECK(supervisor.EnsureReady(10s));
+    Shutdown(launcher);
+}
+
+LUMOS_TEST(SupervisorRespawnsADeadUi) {
+    StubMode mode("crash", "300");
+    std::string log = Test::ScratchPath("starts.log");
+    setenv("LUMOS_STUB_UI_LOG", log.c_str(), 1);
+    auto owned = CreateProcessLauncher();
+    ProcessLauncher& launcher = *owned;
+    UIProcessSupervisor supervisor(std::move(owned), { StubPath() });
+    supervisor.Start();
+
+    auto deadline = std::chrono::steady_clock::now() + 15s;
+    while (CountLines(log) < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(20ms);
+    }
+    CHECK(CountLines(log) >= 3);
+    CHECK(supervisor.LastStartupTime() < 5000ms);
+    supervisor.Stop();
+    Shutdown(launcher);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The benchmark counterpart of tests/Check.h: every benchmark executable
+// links BenchMain.cpp, and each LUMOS_BENCHMARK body is one iteration,
+// repeated until it has run long enough to time. Bodies that report the
+// bytes they processed also get a throughput column.
+//
+//   LUMOS_BENCHMARK(Crc32cOnly) {
+//       Crc32c crc;
+//       crc.Update(Data().data(), Data().size());
+//       Bench::Keep(crc.Finish());
+//       Bench::Processed(Data().size());
+//   }
+//
+// Inputs are built once, outside the timed bodies, by functions holding a
+// static; they may be smaller under --quick, which ctest uses.
+namespace Lumos::Bench {
+    using BodyFunction = void (*)();
+
+    struct Registration {
+        Registration(const char* name, BodyFunction body);
+    };
+
+    // Running for ctest: smoke-test sized inputs and short timings
+    bool Quick();
+
+    // Counts bytes toward the throughput column
+    void Processed(uint64_t bytes);
+
+    // Keeps the compiler from discarding a result nothing else reads
+    void Keep(uint64_t value);
+
+    // A checked-in fixture under tests/data, read whole; empty if missing
+    std::vector<uint8_t> ReadData(std::string_view name);
+
+    // Writes a generated input to the temporary directory for the
+    // benchmarks that read files, returning its path
+    std::string WriteScratch(std::string_view name, const std::vector<uint8_t>& bytes);
+}
+
+#define LUMOS_BENCHMARK_CONCAT_(a, b) a##b
+#define LUMOS_BENCHMARK(name)                                                                              \
+    static void name();                                                                                    \
+    static ::Lumos::Bench::Registration LUMOS_BENCHMARK_CONCAT_(name, _registration)(#name, &name);       \
+    static void name()
@@ -0,0 +1,170 @@
+// Runs the LUMOS_BENCHMARK cases linked into this executable.
+//
+//   <bench> [--quick] [name-substring]
+//
+// Each case is timed in rounds of a fixed iteration count, sized so a
+// round takes about a tenth of the time budget; the median and fastest
+// rounds are reported. --quick shrinks inputs and budgets so ctest only
+// checks that every benchmark still runs. Like the test executables,
+// benchmarks also serve as decoder workers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "Bench.h"
+#include "../../common/Utf8.h"
+#include "../../worker/DecoderWorker.h"
+
+namespace Lumos::Bench {
+    namespace {
+        struct Case {
+            const char* name;
+            BodyFunction body;
+        };
+
+        std::vector<Case>& Cases() {
+            static std::vector<Case> cases;
+            return cases;
+        }
+
+        bool g_quick = false;
+        std::atomic<uint64_t> g_sink{ 0 };
+        uint64_t g_processed = 0;
+
+        using Clock = std::chrono::steady_clock;
+
+        double RoundNanoseconds(BodyFunction body, uint64_t iterations) {
+            g_processed = 0;
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                body();
+            }
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+
+        std::wstring FormatTime(double nanoseconds) {
+            wchar_t text[32];
+            if (nanoseconds < 1e3) {
+                std::swprintf(text, 32, L"%.1f ns", nanoseconds);
+            } else if (nanoseconds < 1e6) {
+                std::swprintf(text, 32, L"%.2f us", nanoseconds / 1e3);
+            } else if (nanoseconds < 1e9) {
+                std::swprintf(text, 32, L"%.2f ms", nanoseconds / 1e6);
+            } else {
+                std::swprintf(text, 32, L"%.2f s", nanoseconds / 1e9);
+            }
+            return text;
+        }
+
+        std::wstring FormatRate(uint64_t bytes, double nanoseconds) {
+            wchar_t text[32];
+            double perSecond = static_cast<double>(bytes) * 1e9 / std::max(nanoseconds, 1.0);
+            if (perSecond >= 1024.0 * 1024 * 1024) {
+                std::swprintf(text, 32, L"%.2f GB/s", perSecond / (1024.0 * 1024 * 1024));
+            } else {
+                std::swprintf(text, 32, L"%.1f MB/s", perSecond / (1024.0 * 1024));
+            }
+            return text;
+        }
+
+        std::wstring Pad(std::wstring text, size_t width) {
+            return text.size() < width ? std::wstring(width - text.size(), L' ') + text : text;
+        }
+    }
+
+    Registration::Registration(const char* name, BodyFunction body) {
+        Cases().push_back({ name, body });
+    }
+
+    bool Quick() {
+        return g_quick;
+    }
+
+    void Processed(uint64_t bytes) {
+        g_processed += bytes;
+    }
+
+    void Keep(uint64_t value) {
+        g_sink.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::vector<uint8_t> ReadData(std::string_view name) {
+        std::ifstream in(std::filesystem::path(LUMOS_TEST_DATA) / std::string(name), std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::string WriteScratch(std::string_view name, const std::vector<uint8_t>& bytes) {
+        auto directory = std::filesystem::temp_directory_path() / "lumos-bench";
+        std::filesystem::create_directories(directory);
+        std::string path = (directory / std::string(name)).string();
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()),
+                                                   static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace Lumos;
+    using namespace Lumos::Bench;
+    if (DecoderWorker::IsWorkerCommandLine(argc, argv)) {
+        return DecoderWorker().Run(argc, argv);
+    }
+
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            g_quick = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+    const double budget = g_quick ? 20e6 : 1e9;
+    const size_t rounds = g_quick ? 3 : 9;
+
+    std::wcout << L"benchmark" << std::wstring(31, L' ') << Pad(L"median", 12) << Pad(L"fastest", 12)
+               << Pad(L"throughput", 14) << Pad(L"iterations", 12) << std::endl;
+    size_t run = 0;
+    for (const auto& benchmark : Cases()) {
+        if (filter && !std::strstr(benchmark.name, filter)) {
+            continue;
+        }
+        try {
+            // The first call builds static inputs and warms caches
+            benchmark.body();
+            uint64_t iterations = 1;
+            double round = RoundNanoseconds(benchmark.body, iterations);
+            while (round < budget / 10 && iterations < (1ull << 40)) {
+                iterations = round > 0 ? std::max<uint64_t>(iterations * 2, static_cast<uint64_t>(
+                                             static_cast<double>(iterations) * budget / 10 / round))
+                                       : iterations * 2;
+                round = RoundNanoseconds(benchmark.body, iterations);
+            }
+
+            std::vector<double> perIteration;
+            for (size_t i = 0; i < rounds; ++i) {
+                perIteration.push_back(RoundNanoseconds(benchmark.body, iterations) / static_cast<double>(iterations));
+            }
+            uint64_t bytes = g_processed / iterations;
+            std::sort(perIteration.begin(), perIteration.end());
+            double median = perIteration[perIteration.size() / 2];
+
+            std::wstring name = FromUtf8(benchmark.name);
+            name.resize(std::max<size_t>(name.size(), 40), L' ');
+            std::wcout << name << Pad(FormatTime(median), 12) << Pad(FormatTime(perIteration.front()), 12)
+                       << Pad(bytes > 0 ? FormatRate(bytes, median) : L"", 14)
+                       << Pad(std::to_wstring(iterations), 12) << std::endl;
+            ++run;
+        } catch (const std::exception& e) {
+            std::wcerr << FromUtf8(benchmark.name) << L" threw " << FromUtf8(e.what()) << std::endl;
+            return 1;
+        }
+    }
+    return run > 0 ? 0 : 1;
+}
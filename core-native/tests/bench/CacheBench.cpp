@@ -0,0 +1,71 @@
+// Preview cache hits and misses, inserts that evict under a tight budget,
+// and a change batch invalidating a folder
+#include <string>
+#include "Bench.h"
+#include "../../cache/PreviewCache.h"
+#include "../../memory/MemoryGovernor.h"
+
+using namespace Lumos;
+
+namespace {
+    constexpr size_t FILES = 4096;
+
+    const std::vector<std::wstring>& Paths() {
+        static std::vector<std::wstring> paths = [] {
+            std::vector<std::wstring> names;
+            for (size_t i = 0; i < FILES; ++i) {
+                names.push_back(L"C:\\Photos\\2026\\trip " + std::to_wstring(i % 16) + L"\\IMG_" + std::to_wstring(i) + L".jpg");
+            }
+            return names;
+        }();
+        return paths;
+    }
+
+    std::shared_ptr<const std::string> Value() {
+        static auto value = std::make_shared<const std::string>(64, 'v');
+        return value;
+    }
+
+    PreviewCache& Filled() {
+        static MemoryGovernor governor;
+        static PreviewCache cache(governor, "bench");
+        static bool filled = [] {
+            for (const auto& path : Paths()) {
+                cache.Put(CacheKind::ImageHeader, path, 1000, 1, Value(), 256);
+            }
+            return true;
+        }();
+        (void)filled;
+        return cache;
+    }
+}
+
+LUMOS_BENCHMARK(GetHit) {
+    static size_t next = 0;
+    const auto& path = Paths()[next++ % FILES];
+    Bench::Keep(Filled().Get<std::string>(CacheKind::ImageHeader, path, 1000, 1) != nullptr);
+}
+
+LUMOS_BENCHMARK(GetStale) {
+    static size_t next = 0;
+    const auto& path = Paths()[next++ % FILES];
+    Bench::Keep(Filled().Get<std::string>(CacheKind::EmbeddedPreview, path, 1000, 1) != nullptr);
+}
+
+// Each insert past the first few hundred evicts the least recently used
+LUMOS_BENCHMARK(PutEvicting) {
+    static MemoryGovernor governor(64 * 1024);
+    static PreviewCache cache(governor, "evicting");
+    static size_t next = 0;
+    Bench::Keep(cache.Put(CacheKind::ImageHeader, Paths()[next++ % FILES], 1000, 1, Value(), 256));
+}
+
+LUMOS_BENCHMARK(InvalidateFolder) {
+    MemoryGovernor governor;
+    PreviewCache cache(governor, "folder");
+    for (size_t i = 0; i < FILES; i += 4) {
+        cache.Put(CacheKind::ImageHeader, Paths()[i], 1000, 1, Value(), 256);
+    }
+    cache.InvalidateUnder(L"C:\\Photos\\2026\\trip 0");
+    Bench::Keep(cache.Stats().entries);
+}
@@ -0,0 +1,76 @@
+// A job's round trip through a decoder worker, and how throughput scales
+// with the worker count while eight callers keep the pool busy with short
+// CPU-bound jobs. Links lumos-core-faults for the Test* jobs.
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../../worker/DecoderPool.h"
+
+using namespace Lumos;
+
+namespace {
+    constexpr uint64_t CALLERS = 8;
+    constexpr uint64_t JOBS_PER_CALLER = 4;
+
+    // Started once per size, with every worker up before the first timing
+    DecoderPool& Pool(size_t workers) {
+        static std::map<size_t, std::unique_ptr<DecoderPool>> pools;
+        auto& pool = pools[workers];
+        if (!pool) {
+            pool = std::make_unique<DecoderPool>(workers);
+            pool->Start();
+            while (pool->GetStats().launches < workers) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        return *pool;
+    }
+
+    void Sweep(size_t workers) {
+        DecoderPool& pool = Pool(workers);
+        uint64_t spinMicroseconds = Bench::Quick() ? 100 : 1000;
+        std::vector<std::thread> callers;
+        for (uint64_t caller = 0; caller < CALLERS; ++caller) {
+            callers.emplace_back([&pool, caller, spinMicroseconds] {
+                for (uint64_t i = 0; i < JOBS_PER_CALLER; ++i) {
+                    DecoderJob job;
+                    job.kind = WorkerJobKind::TestSpin;
+                    job.affinity = caller * JOBS_PER_CALLER + i;
+                    job.values[0] = spinMicroseconds;
+                    Bench::Keep(static_cast<uint64_t>(pool.Run(job, CancellationToken(), nullptr)));
+                }
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+    }
+}
+
+LUMOS_BENCHMARK(RoundTrip) {
+    static const std::vector<uint8_t> input(4096, 0x5A);
+    DecoderJob job;
+    job.kind = WorkerJobKind::TestEcho;
+    job.input = ByteView(input.data(), input.size());
+    Bench::Keep(static_cast<uint64_t>(Pool(1).Run(job, CancellationToken(), nullptr)));
+    Bench::Processed(input.size());
+}
+
+// One iteration is CALLERS * JOBS_PER_CALLER jobs
+LUMOS_BENCHMARK(Workers1) {
+    Sweep(1);
+}
+
+LUMOS_BENCHMARK(Workers2) {
+    Sweep(2);
+}
+
+LUMOS_BENCHMARK(Workers4) {
+    Sweep(4);
+}
+
+LUMOS_BENCHMARK(Workers8) {
+    Sweep(8);
+}
@@ -0,0 +1,75 @@
+// Parsing a face, loading and rasterizing outlines from glyf and CFF, and
+// the whole specimen page cold and with a warm glyph cache
+#include "Bench.h"
+#include "../../engines/font/FontSpecimen.h"
+#include "../../engines/font/GlyphCache.h"
+#include "../../engines/font/GlyphRasterizer.h"
+#include "../../engines/font/OpenTypeFont.h"
+
+using namespace Lumos;
+
+namespace {
+    struct Font {
+        explicit Font(std::string_view name) : bytes(Bench::ReadData(name)), font(ByteView(bytes.data(), bytes.size())) {}
+
+        std::vector<uint8_t> bytes;
+        OpenTypeFont font;
+    };
+
+    const Font& TrueType() {
+        static Font font("font/lumos.ttf");
+        return font;
+    }
+
+    const Font& Cff() {
+        static Font font("font/lumos.otf");
+        return font;
+    }
+
+    void LoadAndRender(const OpenTypeFont& font) {
+        static GlyphRasterizer rasterizer;
+        GlyphOutline outline;
+        GlyphBitmap bitmap;
+        float scale = 48.0f / font.UnitsPerEm();
+        for (uint16_t glyph = 0; glyph < font.GlyphCount(); ++glyph) {
+            if (font.LoadOutline(glyph, outline)) {
+                Bench::Keep(rasterizer.Render(outline, scale, bitmap));
+            }
+        }
+    }
+
+    void RenderSpecimen(const OpenTypeFont& font, GlyphCache& cache) {
+        FontSpecimen specimen(font);
+        static std::vector<uint8_t> pixels;
+        pixels.assign(static_cast<size_t>(specimen.Stride()) * specimen.Height(), 0);
+        Bench::Keep(specimen.Render(cache, pixels.data()).glyphsDrawn);
+    }
+}
+
+LUMOS_BENCHMARK(OpenFace) {
+    OpenTypeFont font(ByteView(TrueType().bytes.data(), TrueType().bytes.size()));
+    Bench::Keep(font.GlyphCount());
+}
+
+LUMOS_BENCHMARK(RenderTrueTypeGlyphs) {
+    LoadAndRender(TrueType().font);
+}
+
+LUMOS_BENCHMARK(RenderCffGlyphs) {
+    LoadAndRender(Cff().font);
+}
+
+LUMOS_BENCHMARK(SpecimenCold) {
+    static MemoryGovernor governor;
+    GlyphCache cache(governor);
+    cache.Bind(TrueType().font, 0);
+    RenderSpecimen(TrueType().font, cache);
+}
+
+// Pressing on the same font again
+LUMOS_BENCHMARK(SpecimenWarm) {
+    static MemoryGovernor governor;
+    static GlyphCache cache(governor);
+    cache.Bind(TrueType().font, 1);
+    RenderSpecimen(TrueType().font, cache);
+}
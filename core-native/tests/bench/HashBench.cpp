@@ -0,0 +1,69 @@
+// Each algorithm alone, and all four through FileHasher's lanes
+#include "Bench.h"
+#include "../../common/WorkerPool.h"
+#include "../../engines/hash/Crc32c.h"
+#include "../../engines/hash/FileHasher.h"
+#include "../../engines/hash/Sha1.h"
+#include "../../engines/hash/Sha256.h"
+#include "../../engines/hash/Xxh3.h"
+
+using namespace Lumos;
+
+namespace {
+    const std::vector<uint8_t>& Data() {
+        static std::vector<uint8_t> data = [] {
+            std::vector<uint8_t> bytes(Bench::Quick() ? (1u << 20) : (16u << 20));
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                bytes[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+            }
+            return bytes;
+        }();
+        return data;
+    }
+
+    // A file larger than FileHasher's read-ahead window
+    const std::vector<uint8_t>& File() {
+        static std::vector<uint8_t> data(Bench::Quick() ? FileHasher::BLOCK_SIZE * 2 : FileHasher::BLOCK_SIZE * 16, 0xA5);
+        return data;
+    }
+}
+
+LUMOS_BENCHMARK(Crc32cOnly) {
+    Crc32c crc;
+    crc.Update(Data().data(), Data().size());
+    Bench::Keep(crc.Finish());
+    Bench::Processed(Data().size());
+}
+
+LUMOS_BENCHMARK(Xxh3Only) {
+    Xxh3 xxh3;
+    xxh3.Update(Data().data(), Data().size());
+    Bench::Keep(xxh3.Finish());
+    Bench::Processed(Data().size());
+}
+
+LUMOS_BENCHMARK(Sha1Only) {
+    Sha1 sha1;
+    sha1.Update(Data().data(), Data().size());
+    uint8_t digest[Sha1::DIGEST_SIZE];
+    sha1.Finish(digest);
+    Bench::Keep(digest[0]);
+    Bench::Processed(Data().size());
+}
+
+LUMOS_BENCHMARK(Sha256Only) {
+    Sha256 sha256;
+    sha256.Update(Data().data(), Data().size());
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    sha256.Finish(digest);
+    Bench::Keep(digest[0]);
+    Bench::Processed(Data().size());
+}
+
+LUMOS_BENCHMARK(FileHasherAllFour) {
+    static WorkerPool workers;
+    FileHasher hasher(workers);
+    auto hashes = hasher.Hash(ByteView(File().data(), File().size()), {});
+    Bench::Keep(hashes ? hashes->xxh3 : 0);
+    Bench::Processed(File().size());
+}
@@ -0,0 +1,108 @@
+// The scheduler's overhead on a local file against reading it directly,
+// and what a preview read waits for behind prefetching on a slow share
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "Bench.h"
+#include "../../common/Utf8.h"
+#include "../../io/IOScheduler.h"
+
+using namespace Lumos;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr size_t HEAD_BYTES = 64 * 1024;
+
+    const std::string& File() {
+        static std::string path = Bench::WriteScratch("io.bin", std::vector<uint8_t>(4 * 1024 * 1024, 0x5A));
+        return path;
+    }
+
+    IOScheduler& Scheduler() {
+        static IOScheduler scheduler;
+        return scheduler;
+    }
+
+    // The scratch volume as a remote share: two reads at a time, each
+    // 64 KB chunk taking an extra half millisecond
+    constexpr size_t SLOW_SLOTS = 2;
+    constexpr size_t PREFETCH_BYTES = 4 * 64 * 1024;
+
+    IOScheduler& SlowScheduler() {
+        static IOScheduler scheduler;
+        static bool configured = [] {
+            std::wstring volume = IOScheduler::VolumeOf(FromUtf8(File()));
+            scheduler.SetVolumeConcurrency(volume, SLOW_SLOTS);
+            scheduler.SetVolumeLatency(volume, 500us);
+            return true;
+        }();
+        Bench::Keep(configured);
+        return scheduler;
+    }
+}
+
+LUMOS_BENCHMARK(ReadHeadDirectly) {
+    std::vector<char> buffer(HEAD_BYTES);
+    std::ifstream in(File(), std::ios::binary);
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    Bench::Keep(static_cast<uint64_t>(in.gcount()));
+    Bench::Processed(HEAD_BYTES);
+}
+
+LUMOS_BENCHMARK(ReadHeadScheduled) {
+    static std::wstring path = FromUtf8(File());
+    IOResult result = Scheduler().Read(path, 0, HEAD_BYTES, 1000ms);
+    Bench::Keep(result.data.size());
+    Bench::Processed(HEAD_BYTES);
+}
+
+LUMOS_BENCHMARK(StatScheduled) {
+    static std::wstring path = FromUtf8(File());
+    Bench::Keep(Scheduler().Stat(path, 1000ms).value_or(FileStat()).size);
+}
+
+// A selection change superseding a speculative read of the whole file
+LUMOS_BENCHMARK(ReadSuperseded) {
+    static std::wstring path = FromUtf8(File());
+    IORequest request;
+    request.path = path;
+    request.length = 4 * 1024 * 1024;
+    request.priority = IOPriority::Speculative;
+    request.cancellation = Scheduler().BeginSelection();
+    auto operation = Scheduler().Submit(std::move(request));
+    Scheduler().BeginSelection();
+    Bench::Keep(static_cast<uint64_t>(operation->Wait().status));
+}
+
+LUMOS_BENCHMARK(ReadHeadSlowShare) {
+    static std::wstring path = FromUtf8(File());
+    IOResult result = SlowScheduler().Read(path, 0, HEAD_BYTES, 1000ms);
+    Bench::Keep(result.data.size());
+    Bench::Processed(HEAD_BYTES);
+}
+
+// The same read while speculative reads keep every slot on the volume
+// busy: it waits for the first slot to free up, not for the whole queue
+LUMOS_BENCHMARK(ReadHeadSlowShareUnderPrefetch) {
+    static std::wstring path = FromUtf8(File());
+    static std::vector<std::shared_ptr<IOOperation>> prefetches;
+    static uint64_t offset = 0;
+    prefetches.erase(std::remove_if(prefetches.begin(), prefetches.end(),
+                                    [](const auto& operation) { return operation->IsDone(); }),
+                     prefetches.end());
+    while (prefetches.size() < SLOW_SLOTS * 2) {
+        IORequest request;
+        request.path = path;
+        request.offset = offset;
+        request.length = PREFETCH_BYTES;
+        request.priority = IOPriority::Speculative;
+        prefetches.push_back(SlowScheduler().Submit(std::move(request)));
+        offset = (offset + PREFETCH_BYTES) % (4 * 1024 * 1024);
+    }
+
+    IOResult result = SlowScheduler().Read(path, 0, HEAD_BYTES, 1000ms);
+    Bench::Keep(result.data.size());
+    Bench::Processed(HEAD_BYTES);
+}
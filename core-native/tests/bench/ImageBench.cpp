@@ -0,0 +1,93 @@
+// Header probes, the embedded-preview search through a camera file, and
+// region decodes from a tiled TIFF at full size and down the pyramid
+#include <atomic>
+#include "Bench.h"
+#include "../TestImages.h"
+#include "../../common/Utf8.h"
+#include "../../common/WorkerPool.h"
+#include "../../engines/image/EmbeddedPreview.h"
+#include "../../engines/image/ImageHeaderProbe.h"
+#include "../../engines/tiles/RawTiffTileSource.h"
+#include "../../engines/tiles/TiledImage.h"
+#include "../../memory/MemoryGovernor.h"
+
+using namespace Lumos;
+
+namespace {
+    ByteView View(const std::vector<uint8_t>& bytes) {
+        return ByteView(bytes.data(), bytes.size());
+    }
+
+    uint32_t TiffEdge() {
+        return Bench::Quick() ? 512 : 4096;
+    }
+
+    const std::wstring& TiffPath() {
+        static std::wstring path = FromUtf8(Bench::WriteScratch("tiled.tif", TestImages::RgbTiff(TiffEdge(), TiffEdge(), 256)));
+        return path;
+    }
+
+    RawTiffTileSource& Tiff() {
+        static std::unique_ptr<RawTiffTileSource> source = RawTiffTileSource::Open(TiffPath());
+        return *source;
+    }
+
+    void Probe(const std::vector<uint8_t>& file) {
+        ImageHeader header;
+        Bench::Keep(static_cast<uint64_t>(ImageHeaderProbe::Probe(View(file), header)));
+        Bench::Keep(header.width);
+    }
+}
+
+LUMOS_BENCHMARK(ProbeJpeg) {
+    static const auto file = TestImages::Jpeg(6000, 4000, 6);
+    Probe(file);
+}
+
+LUMOS_BENCHMARK(ProbePng) {
+    static const auto file = TestImages::Png(1920, 1080);
+    Probe(file);
+}
+
+LUMOS_BENCHMARK(ProbeTiff) {
+    static const auto file = TestImages::RgbTiff(64, 64, 0);
+    Probe(file);
+}
+
+LUMOS_BENCHMARK(FindEmbeddedPreview) {
+    static const auto file = TestImages::RawWithPreviews(160, 1620, 6);
+    auto preview = EmbeddedPreviewFinder::Find(View(file), 1920, 320);
+    Bench::Keep(preview ? preview->length : 0);
+}
+
+// One 256-pixel tile at actual size
+LUMOS_BENCHMARK(DecodeTile) {
+    static std::vector<uint8_t> pixels(256 * 256 * 4);
+    TileRegion region{ 0, 0, 256, 256 };
+    Bench::Keep(Tiff().DecodeRegion(region, 0, pixels.data(), 256 * 4, {}));
+    Bench::Processed(256 * 256 * 3);
+}
+
+// The whole image averaged down to a single tile, what a zoomed-out view shows
+LUMOS_BENCHMARK(DecodeOverview) {
+    static std::vector<uint8_t> pixels(256 * 256 * 4);
+    uint32_t level = 0;
+    while ((TiffEdge() >> level) > 256) {
+        ++level;
+    }
+    TileRegion region{ 0, 0, 256, 256 };
+    Bench::Keep(Tiff().DecodeRegion(region, level, pixels.data(), 256 * 4, {}));
+    Bench::Processed(static_cast<uint64_t>(TiffEdge()) * TiffEdge() * 3);
+}
+
+// A fresh 1920x1080 viewport at actual size, until every visible tile is in
+LUMOS_BENCHMARK(ViewportFill) {
+    static WorkerPool workers;
+    static MemoryGovernor governor;
+    std::atomic<uint64_t> tiles{ 0 };
+    TiledImage image(RawTiffTileSource::Open(TiffPath()), workers, governor,
+                     [&tiles](const std::shared_ptr<const Tile>&) { tiles.fetch_add(1); });
+    image.SetViewport({ TiffEdge() / 2.0, TiffEdge() / 2.0, 1.0, 1920, 1080 });
+    workers.WaitIdle();
+    Bench::Keep(tiles.load());
+}
@@ -0,0 +1,50 @@
+// Parsing a README-shaped document whole, and just its first screen
+#include <string>
+#include "Bench.h"
+#include "../../engines/markdown/MarkdownParser.h"
+
+using namespace Lumos;
+
+namespace {
+    const std::string& Document() {
+        static std::string text = [] {
+            static constexpr const char* SECTION =
+                "## Installing\n\n"
+                "Run the *installer* and pick a folder; see [the guide][guide] or `setup --help`.\n"
+                "Settings live in **%APPDATA%**, one per line:\n\n"
+                "- `theme`: light, dark or *system*\n"
+                "- `font`: any installed face\n"
+                "  1. nested item with a <https://example.com/link>\n"
+                "  2. and ~~struck~~ text\n\n"
+                "> Quoted note spanning\n> two lines.\n\n"
+                "```cpp\nint main() { return 0; }\n```\n\n"
+                "| Key | Value |\n|:----|------:|\n| a | 1 |\n| b | 2 |\n\n"
+                "[guide]: https://example.com/guide \"Guide\"\n\n";
+            std::string document = "# Project\n\n";
+            size_t sections = Bench::Quick() ? 16 : 1024;
+            for (size_t i = 0; i < sections; ++i) {
+                document += SECTION;
+            }
+            return document;
+        }();
+        return text;
+    }
+}
+
+LUMOS_BENCHMARK(ParseDocument) {
+    MarkdownParser parser(Document());
+    MarkdownDocument document;
+    while (parser.Parse(document, 1000)) {
+    }
+    Bench::Keep(document.blocks.size());
+    Bench::Processed(Document().size());
+}
+
+// What the preview waits for before it first paints
+LUMOS_BENCHMARK(ParseFirstScreen) {
+    MarkdownParser parser(Document());
+    MarkdownDocument document;
+    parser.Parse(document, 64);
+    Bench::Keep(document.blocks.size());
+    Bench::Processed(parser.BytesConsumed());
+}
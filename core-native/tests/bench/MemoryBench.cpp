@@ -0,0 +1,72 @@
+// Request arenas against the heap they replace, and the governor's charge
+// path with and without contention
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../../memory/MemoryGovernor.h"
+#include "../../memory/RequestArena.h"
+
+using namespace Lumos;
+
+namespace {
+    // The allocations one preview request makes: a path, a handful of
+    // strings and a growing vector of JSON
+    void BuildRequest(std::pmr::memory_resource* resource) {
+        std::pmr::wstring path(L"C:\\Users\\someone\\Downloads\\holiday photos\\IMG_2041.CR3", resource);
+        std::pmr::vector<std::pmr::string> fields(resource);
+        for (int i = 0; i < 24; ++i) {
+            fields.emplace_back("a field long enough to leave the small-string buffer");
+        }
+        std::pmr::string json(resource);
+        for (const auto& field : fields) {
+            json += field;
+            json += ',';
+        }
+        Bench::Keep(json.size() + path.size());
+    }
+
+    MemoryGovernor& Governor() {
+        static MemoryGovernor governor(1ull << 40);
+        return governor;
+    }
+
+    MemoryPool& Pool() {
+        static std::shared_ptr<MemoryPool> pool = Governor().RegisterPool("bench", PoolPriority::Cache);
+        return *pool;
+    }
+}
+
+LUMOS_BENCHMARK(RequestOnTheHeap) {
+    BuildRequest(std::pmr::new_delete_resource());
+}
+
+LUMOS_BENCHMARK(RequestInAnArena) {
+    static RequestArena arena;
+    BuildRequest(arena.Resource());
+    arena.Reset();
+}
+
+LUMOS_BENCHMARK(PoolChargeAndRelease) {
+    Bench::Keep(Pool().TryCharge(4096));
+    Pool().Release(4096);
+}
+
+// Four threads charging one governor, as decoders and caches do at once;
+// one iteration is 10k charges per thread
+LUMOS_BENCHMARK(PoolChargeContended) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 10000; ++i) {
+                if (Pool().TryCharge(4096)) {
+                    Pool().Release(4096);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,40 @@
+// What recording costs the hot paths it instruments, alone and from four
+// threads at once, and what the tray pays to read it back
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../../metrics/Metrics.h"
+#include "../../metrics/MetricsReport.h"
+
+using namespace Lumos;
+
+LUMOS_BENCHMARK(Record) {
+    static uint64_t value = 1;
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+    Metrics::Record(Histogram::PipeSend, value >> 40);
+}
+
+LUMOS_BENCHMARK(RecordScoped) {
+    ScopedLatency latency(Histogram::HookCallback);
+}
+
+// One iteration is 10k records per thread, all into one histogram
+LUMOS_BENCHMARK(RecordContended) {
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (uint64_t i = 0; i < 10000; ++i) {
+                Metrics::Record(Histogram::DecoderJob, (i * 977 + t) & 0xFFFFF);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+LUMOS_BENCHMARK(CaptureAndFormat) {
+    MetricsSnapshot snapshot;
+    MetricsReport::Capture(Metrics::Live(), snapshot);
+    Bench::Keep(MetricsReport::Format(snapshot, 0).size());
+}
@@ -0,0 +1,53 @@
+// Choosing a preview for a selection: the builtin table, a provider's
+// extension and a signature sniff, with the sample provider loaded
+#include <string>
+#include "Bench.h"
+#include "../../common/Utf8.h"
+#include "../../plugins/ProviderLoader.h"
+#include "../../plugins/ProviderRegistry.h"
+
+using namespace Lumos;
+
+namespace {
+    ProviderRegistry& Registry() {
+        static ProviderRegistry registry;
+        static bool built = [] {
+            std::wstring error;
+            auto library = ProviderLibrary::Load(FromUtf8(LUMOS_SAMPLE_PROVIDER), error);
+            if (library) {
+                const LumosProviderInfo* info = library->Info();
+                registry.Add(info, std::move(library));
+            }
+            registry.Build();
+            return true;
+        }();
+        (void)built;
+        return registry;
+    }
+
+    ByteView View(std::string_view text) {
+        return ByteView(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    }
+}
+
+LUMOS_BENCHMARK(ResolveBuiltin) {
+    Bench::Keep(static_cast<uint64_t>(Registry().Resolve(L".SQLite3").builtin));
+}
+
+LUMOS_BENCHMARK(ResolveProvider) {
+    Bench::Keep(Registry().Resolve(L".ppm").provider != nullptr);
+}
+
+LUMOS_BENCHMARK(ResolveUnknown) {
+    Bench::Keep(static_cast<bool>(Registry().Resolve(L".docx")));
+}
+
+LUMOS_BENCHMARK(SniffSignature) {
+    static const std::string head = "P6\n3 2\n255\n" + std::string(256, '\0');
+    Bench::Keep(Registry().Sniff(View(head)).provider != nullptr);
+}
+
+LUMOS_BENCHMARK(SniffNothing) {
+    static const std::string head(512, 'a');
+    Bench::Keep(static_cast<bool>(Registry().Sniff(View(head))));
+}
@@ -0,0 +1,58 @@
+// Opening a database for the inspector: header and schema, the first page
+// of rows, and a jump deep into a 3000-row table
+#include <memory_resource>
+#include "Bench.h"
+#include "../../engines/sqlite/SqliteFile.h"
+
+using namespace Lumos;
+
+namespace {
+    const std::vector<uint8_t>& Database() {
+        static std::vector<uint8_t> bytes = Bench::ReadData("sqlite/basic.db");
+        return bytes;
+    }
+
+    ByteView View() {
+        return ByteView(Database().data(), Database().size());
+    }
+
+    const SqliteObject& Items() {
+        static SqliteSchema schema = [] {
+            SqliteSchema read;
+            SqliteFile(View()).ReadSchema(read);
+            return read;
+        }();
+        for (const SqliteObject& object : schema.objects) {
+            if (object.name == "items") {
+                return object;
+            }
+        }
+        return schema.objects.front();
+    }
+
+    void ReadRows(uint64_t firstRow) {
+        SqliteFile file(View());
+        SqliteRows rows;
+        Bench::Keep(file.ReadRows(Items(), firstRow, 100, rows));
+        std::pmr::string json;
+        rows.WriteJson(json);
+        Bench::Keep(json.size());
+    }
+}
+
+LUMOS_BENCHMARK(OpenAndReadSchema) {
+    SqliteFile file(View());
+    SqliteSchema schema;
+    Bench::Keep(file.ReadSchema(schema));
+    std::pmr::string json;
+    schema.WriteJson(json);
+    Bench::Keep(json.size());
+}
+
+LUMOS_BENCHMARK(ReadFirstRows) {
+    ReadRows(0);
+}
+
+LUMOS_BENCHMARK(ReadRowsFromTheEnd) {
+    ReadRows(2900);
+}
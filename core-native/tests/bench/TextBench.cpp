@@ -0,0 +1,87 @@
+// Indexing and opening a large log, and searching it literally, without
+// case and by regex
+#include <algorithm>
+#include <random>
+#include <string>
+#include "Bench.h"
+#include "../../common/Utf8.h"
+#include "../../common/WorkerPool.h"
+#include "../../engines/text/LineIndex.h"
+#include "../../engines/text/LogTail.h"
+#include "../../engines/text/TextSearch.h"
+
+using namespace Lumos;
+
+namespace {
+    // Log lines of varying length with an occasional ERROR
+    const std::vector<uint8_t>& Log() {
+        static std::vector<uint8_t> text = [] {
+            std::mt19937 random(44);
+            size_t bytes = Bench::Quick() ? (1u << 20) : (64u << 20);
+            std::string log;
+            log.reserve(bytes + 256);
+            while (log.size() < bytes) {
+                log += "2026-03-14 09:26:53.";
+                log += std::to_string(random() % 1000);
+                log += random() % 64 == 0 ? " ERROR " : " info  ";
+                log += "worker ";
+                log += std::to_string(random() % 16);
+                log.append(random() % 96, 'x');
+                log += '\n';
+            }
+            return std::vector<uint8_t>(log.begin(), log.end());
+        }();
+        return text;
+    }
+
+    const std::wstring& LogPath() {
+        static std::wstring path = FromUtf8(Bench::WriteScratch("tail.log", Log()));
+        return path;
+    }
+
+    void Search(TextSearchOptions options) {
+        static WorkerPool workers;
+        TextSearch search(workers);
+        std::string error;
+        search.Compile(options, error);
+        search.Run(ByteView(Log().data(), Log().size()), {});
+        Bench::Keep(search.MatchCount());
+        Bench::Processed(Log().size());
+    }
+}
+
+LUMOS_BENCHMARK(IndexLines) {
+    LineIndex index;
+    index.Append(Log().data(), Log().size());
+    Bench::Keep(index.LineCount());
+    Bench::Processed(Log().size());
+}
+
+// Appends in the sizes a growing log is read in
+LUMOS_BENCHMARK(IndexAppends) {
+    LineIndex index;
+    for (size_t offset = 0; offset < Log().size(); offset += 4096) {
+        index.Append(Log().data() + offset, std::min<size_t>(4096, Log().size() - offset));
+    }
+    Bench::Keep(index.LineCount());
+    Bench::Processed(Log().size());
+}
+
+LUMOS_BENCHMARK(OpenTail) {
+    LogTail tail(LogPath(), [](const LogTailUpdate&) { return true; });
+    std::string initial;
+    Bench::Keep(tail.Open(1000, initial));
+    Bench::Keep(initial.size());
+}
+
+LUMOS_BENCHMARK(SearchLiteral) {
+    Search({ "ERROR worker 7", false, false });
+}
+
+LUMOS_BENCHMARK(SearchIgnoringCase) {
+    Search({ "error worker 7", true, false });
+}
+
+LUMOS_BENCHMARK(SearchRegex) {
+    Search({ "ERROR worker 1[0-5]", false, true });
+}
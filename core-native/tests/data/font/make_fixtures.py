@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Writes the fonts FontTests.cpp reads (needs fontTools).
+
+    python3 make_fixtures.py
+
+Four glyphs with known shapes, 1000 units per em:
+
+    square    'A' and U+0416: a 600 x 700 box with a 200 x 300 hole
+    triangle  'B': quadratic curves in TrueType, cubic in CFF
+    pair      'C' (TrueType only): two squares as components, one at half
+              size and offset by (700, 0)
+    space     ' ': advance only
+
+lumos.ttf is TrueType, lumos.otf CFF, lumos.ttc both as a collection.
+"""
+import os
+from fontTools.fontBuilder import FontBuilder
+from fontTools.pens.t2CharStringPen import T2CharStringPen
+from fontTools.pens.ttGlyphPen import TTGlyphPen
+from fontTools.ttLib import TTCollection, TTFont
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+NAMES = {"familyName": "Lumos Test", "styleName": "Regular", "version": "Version 1.000"}
+CMAP = {ord("A"): "square", 0x416: "square", ord("B"): "triangle", ord("C"): "pair", ord(" "): "space"}
+ADVANCES = {".notdef": 500, "square": 700, "triangle": 650, "pair": 1100, "space": 250}
+
+
+def draw_square(pen):
+    pen.moveTo((50, 0))
+    pen.lineTo((50, 700))
+    pen.lineTo((650, 700))
+    pen.lineTo((650, 0))
+    pen.closePath()
+    # Hole, wound the other way
+    pen.moveTo((250, 200))
+    pen.lineTo((450, 200))
+    pen.lineTo((450, 500))
+    pen.lineTo((250, 500))
+    pen.closePath()
+
+
+def draw_triangle(pen, cubic):
+    pen.moveTo((0, 0))
+    if cubic:
+        pen.curveTo((100, 400), (200, 600), (300, 700))
+        pen.curveTo((400, 600), (500, 400), (600, 0))
+    else:
+        pen.qCurveTo((100, 500), (300, 700))
+        pen.qCurveTo((500, 500), (600, 0))
+    pen.closePath()
+
+
+def base(cff):
+    fb = FontBuilder(1000, isTTF=not cff)
+    order = [".notdef", "square", "triangle", "space"] + ([] if cff else ["pair"])
+    fb.setupGlyphOrder(order)
+    fb.setupCharacterMap({cp: name for cp, name in CMAP.items() if name in order})
+    return fb, order
+
+
+def truetype():
+    fb, order = base(False)
+    glyphs = {}
+    for name in order:
+        pen = TTGlyphPen(None)
+        if name == "square":
+            draw_square(pen)
+        elif name == "triangle":
+            draw_triangle(pen, False)
+        elif name == ".notdef":
+            pen.moveTo((0, 0))
+            pen.lineTo((0, 500))
+            pen.lineTo((400, 500))
+            pen.closePath()
+        glyphs[name] = pen.glyph()
+    pair = TTGlyphPen(glyphs)
+    pair.addComponent("square", (1, 0, 0, 1, 0, 0))
+    pair.addComponent("square", (0.5, 0, 0, 0.5, 700, 0))
+    glyphs["pair"] = pair.glyph()
+    fb.setupGlyf(glyphs)
+    return finish(fb, order)
+
+
+def cff():
+    fb, order = base(True)
+    charstrings = {}
+    for name in order:
+        pen = T2CharStringPen(ADVANCES[name], None)
+        if name == "square":
+            draw_square(pen)
+        elif name == "triangle":
+            draw_triangle(pen, True)
+        charstrings[name] = pen.getCharString()
+    fb.setupCFF("LumosTest-Regular", {"FullName": "Lumos Test"}, charstrings, {})
+    return finish(fb, order)
+
+
+def finish(fb, order):
+    fb.setupHorizontalMetrics({name: (ADVANCES[name], 0) for name in order})
+    fb.setupHorizontalHeader(ascent=800, descent=-200)
+    fb.setupNameTable(NAMES)
+    fb.setupOS2(sTypoAscender=800, sTypoDescender=-200, usWinAscent=800, usWinDescent=200)
+    fb.setupPost()
+    return fb.font
+
+
+if __name__ == "__main__":
+    ttf = truetype()
+    otf = cff()
+    ttf.save(os.path.join(HERE, "lumos.ttf"))
+    otf.save(os.path.join(HERE, "lumos.otf"))
+    collection = TTCollection()
+    collection.fonts = [TTFont(os.path.join(HERE, "lumos.otf")), TTFont(os.path.join(HERE, "lumos.ttf"))]
+    collection.save(os.path.join(HERE, "lumos.ttc"))
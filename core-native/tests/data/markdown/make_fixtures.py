@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Writes spec.json, the CommonMark examples MarkdownTests.cpp runs.
+
+    python3 make_fixtures.py path/to/pulldown-cmark-0.13.0/tests/suite/spec.rs
+
+The examples are those of CommonMark 0.31.2, taken from the test file the
+pulldown-cmark crate generates from spec.txt (it ships with the crate
+source, so `cargo fetch` is enough to get it). The output has the layout of
+the spec's own `spec_tests.py --dump-tests`: one object per example with
+`example`, `section`, `markdown` and `html`.
+"""
+import json
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+EXAMPLES = 652
+
+# First example of each section in 0.31.2
+SECTIONS = [
+    (1, "Tabs"),
+    (12, "Backslash escapes"),
+    (25, "Entity and numeric character references"),
+    (42, "Precedence"),
+    (43, "Thematic breaks"),
+    (62, "ATX headings"),
+    (80, "Setext headings"),
+    (107, "Indented code blocks"),
+    (119, "Fenced code blocks"),
+    (148, "HTML blocks"),
+    (192, "Link reference definitions"),
+    (219, "Paragraphs"),
+    (227, "Blank lines"),
+    (228, "Block quotes"),
+    (253, "List items"),
+    (301, "Lists"),
+    (327, "Inlines"),
+    (328, "Code spans"),
+    (350, "Emphasis and strong emphasis"),
+    (482, "Links"),
+    (572, "Images"),
+    (594, "Autolinks"),
+    (613, "Raw HTML"),
+    (633, "Hard line breaks"),
+    (648, "Soft line breaks"),
+    (650, "Textual content"),
+]
+
+TEST = re.compile(r'fn spec_test_(\d+)\(\) \{\n'
+                  r'    let original = r##"(.*?)"##;\n'
+                  r'    let expected = r##"(.*?)"##;', re.S)
+
+
+def section(example):
+    return [name for first, name in SECTIONS if first <= example][-1]
+
+
+def main(path):
+    with open(path, encoding="utf-8") as source:
+        tests = [(int(n), markdown, html) for n, markdown, html in TEST.findall(source.read())]
+    tests.sort()
+    if [n for n, _, _ in tests] != list(range(1, EXAMPLES + 1)):
+        sys.exit(f"{path}: expected examples 1-{EXAMPLES}, found {len(tests)}")
+
+    examples = [{"example": n, "section": section(n), "markdown": markdown, "html": html}
+                for n, markdown, html in tests]
+    with open(os.path.join(HERE, "spec.json"), "w", encoding="utf-8", newline="\n") as out:
+        json.dump(examples, out, ensure_ascii=True, indent=0)
+        out.write("\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    main(sys.argv[1])
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Writes the SQLite databases SqliteTests.cpp reads.
+
+    python3 make_fixtures.py
+
+Small pages so a few thousand rows already need interior pages and a
+modest text spills into an overflow chain. Rerun only when a case needs
+new content; the tests pin exact values.
+"""
+import os
+import sqlite3
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def create(name, encoding="UTF-8"):
+    path = os.path.join(HERE, name)
+    if os.path.exists(path):
+        os.remove(path)
+    db = sqlite3.connect(path)
+    db.execute("PRAGMA page_size = 1024")
+    db.execute(f"PRAGMA encoding = '{encoding}'")
+    return db
+
+
+def basic():
+    db = create("basic.db")
+    db.executescript('''
+        PRAGMA user_version = 7;
+        PRAGMA application_id = 1234;
+        CREATE TABLE items (
+            id INTEGER PRIMARY KEY,
+            name TEXT NOT NULL,
+            price REAL,
+            data BLOB,
+            note
+        );
+        CREATE INDEX items_name ON items(name);
+        CREATE VIEW cheap AS SELECT name FROM items WHERE price < 1;
+        CREATE TRIGGER items_touch AFTER UPDATE ON items BEGIN SELECT 1; END;
+        CREATE TABLE kv (k TEXT PRIMARY KEY, v INTEGER) WITHOUT ROWID;
+        CREATE TABLE "odd ""name""" ([a b] INT, `c` TEXT);
+    ''')
+    rows = []
+    for i in range(1, 3001):
+        rows.append((i, f"item {i:05d}", i / 4, bytes([i & 0xFF, (i >> 8) & 0xFF]), None if i % 2 else -i))
+    db.executemany("INSERT INTO items VALUES (?, ?, ?, ?, ?)", rows)
+    # Spills into an overflow chain; longer than a cell value is shown
+    db.execute("UPDATE items SET name = ? WHERE id = 2", ("x" * 5000,))
+    db.execute("UPDATE items SET note = ? WHERE id = 3", (bytes(range(256)) * 40,))
+    db.executemany("INSERT INTO kv VALUES (?, ?)", [(f"key{i:03d}", i * i) for i in range(500)])
+    db.execute("INSERT INTO \"odd \"\"name\"\"\" VALUES (1, 'one')")
+    # Rows written before the column existed read back as its default
+    db.execute("ALTER TABLE kv ADD COLUMN flag TEXT DEFAULT 'none'")
+    db.execute("INSERT INTO kv VALUES ('zzz', 0, 'set')")
+    db.commit()
+    db.close()
+
+
+def utf16():
+    db = create("utf16.db", "UTF-16le")
+    db.executescript("""
+        CREATE TABLE words (w TEXT);
+        INSERT INTO words VALUES ('héllo'), ('мир'), ('😀');
+    """)
+    db.commit()
+    db.close()
+
+
+if __name__ == "__main__":
+    basic()
+    utf16()
@@ -0,0 +1,35 @@
+// OpenType font reader and glyph rasterizer: tables, cmap, TrueType and
+// CFF outlines of the first glyphs, and a coverage bitmap of each
+#include <algorithm>
+#include "Fuzz.h"
+#include "../../engines/font/GlyphRasterizer.h"
+#include "../../engines/font/OpenTypeFont.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    GlyphRasterizer rasterizer;
+    for (uint32_t face = 0; face < 2; ++face) {
+        OpenTypeFont font(ByteView(data, size), face);
+        if (!font.IsValid()) {
+            break;
+        }
+        font.MappedCodepoints(64);
+        font.GlyphIndex('A');
+        float scale = font.UnitsPerEm() > 0 ? 24.0f / font.UnitsPerEm() : 0.024f;
+        uint16_t glyphs = std::min<uint16_t>(font.GlyphCount(), 32);
+        GlyphOutline outline;
+        GlyphBitmap bitmap;
+        for (uint16_t glyph = 0; glyph < glyphs; ++glyph) {
+            font.AdvanceWidth(glyph);
+            if (font.LoadOutline(glyph, outline)) {
+                rasterizer.Render(outline, scale, bitmap);
+            }
+        }
+    }
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    return { Fuzz::ReadData("font/lumos.ttf"), Fuzz::ReadData("font/lumos.otf"), Fuzz::ReadData("font/lumos.ttc") };
+}
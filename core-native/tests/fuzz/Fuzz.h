@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Each fuzz target defines LLVMFuzzerTestOneInput, as libFuzzer expects,
+// and Lumos::Fuzz::Seeds: well-formed inputs FuzzMain starts its mutations
+// from. The target must not crash, hang or leak on any input; it need not
+// check results.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace Lumos::Fuzz {
+    using Input = std::vector<uint8_t>;
+
+    std::vector<Input> Seeds();
+
+    // A checked-in fixture under tests/data, read whole; empty if missing
+    Input ReadData(std::string_view name);
+
+    inline Input FromText(std::string_view text) {
+        return Input(text.begin(), text.end());
+    }
+}
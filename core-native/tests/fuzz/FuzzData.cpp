@@ -0,0 +1,12 @@
+#include "Fuzz.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace Lumos::Fuzz {
+    Input ReadData(std::string_view name) {
+        std::ifstream in(std::filesystem::path(LUMOS_TEST_DATA) / std::string(name), std::ios::binary);
+        return Input(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+}
@@ -0,0 +1,229 @@
+// Runs a fuzz target without libFuzzer, so every target gets exercised on
+// each ctest run with any compiler:
+//
+//   <fuzzer> [--runs <n>] [--seed <n>] [--dump <run>] [input...]
+//
+// Feeds the target its seeds, any input files named, then <n> mutations of
+// them. The mutations come from a fixed generator, so a failing run repeats
+// exactly: a crash reports the mutation's number, and --dump writes that
+// mutation to mutation-<run>.bin for a debugger or libFuzzer.
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "Fuzz.h"
+#include "../../common/Utf8.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t MAX_INPUT_BYTES = 1024 * 1024;
+
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : m_state(seed) {}
+
+        // SplitMix64
+        uint64_t Next() {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        size_t Below(size_t bound) { return bound > 0 ? static_cast<size_t>(Next() % bound) : 0; }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Values parsers tend to treat specially: boundaries of 8-, 16- and
+    // 32-bit fields and small counts
+    constexpr uint32_t INTERESTING[] = { 0, 1, 2, 0x7F, 0x80, 0xFF, 0x100, 0x7FFF, 0x8000, 0xFFFF,
+                                         0x10000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+    void Mutate(Lumos::Fuzz::Input& input, const std::vector<Lumos::Fuzz::Input>& pool, Random& random) {
+        size_t steps = 1 + random.Below(8);
+        for (size_t step = 0; step < steps; ++step) {
+            size_t size = input.size();
+            switch (random.Below(8)) {
+            case 0:  // Flip a bit
+                if (size > 0) {
+                    input[random.Below(size)] ^= static_cast<uint8_t>(1u << random.Below(8));
+                }
+                break;
+            case 1:  // Random byte
+                if (size > 0) {
+                    input[random.Below(size)] = static_cast<uint8_t>(random.Next());
+                }
+                break;
+            case 2: {  // Interesting value, either byte order
+                size_t width = size_t(1) << random.Below(3);
+                if (size >= width) {
+                    uint32_t value = INTERESTING[random.Below(std::size(INTERESTING))];
+                    size_t at = random.Below(size - width + 1);
+                    bool bigEndian = random.Below(2) == 0;
+                    for (size_t i = 0; i < width; ++i) {
+                        size_t shift = 8 * (bigEndian ? width - 1 - i : i);
+                        input[at + i] = static_cast<uint8_t>(value >> shift);
+                    }
+                }
+                break;
+            }
+            case 3:  // Insert bytes
+                if (size < MAX_INPUT_BYTES) {
+                    size_t count = 1 + random.Below(16);
+                    input.insert(input.begin() + static_cast<ptrdiff_t>(random.Below(size + 1)), count,
+                                 static_cast<uint8_t>(random.Next()));
+                }
+                break;
+            case 4:  // Erase a range
+                if (size > 1) {
+                    size_t at = random.Below(size);
+                    size_t count = 1 + random.Below(std::min<size_t>(size - at, 64));
+                    input.erase(input.begin() + static_cast<ptrdiff_t>(at), input.begin() + static_cast<ptrdiff_t>(at + count));
+                }
+                break;
+            case 5:  // Copy a range over another
+                if (size > 1) {
+                    size_t from = random.Below(size);
+                    size_t to = random.Below(size);
+                    size_t count = 1 + random.Below(std::min<size_t>(size - std::max(from, to), 64));
+                    std::memmove(&input[to], &input[from], count);
+                }
+                break;
+            case 6:  // Truncate
+                if (size > 0) {
+                    input.resize(random.Below(size));
+                }
+                break;
+            default: {  // Splice in part of another input
+                const Lumos::Fuzz::Input& other = pool[random.Below(pool.size())];
+                if (!other.empty() && size < MAX_INPUT_BYTES) {
+                    size_t from = random.Below(other.size());
+                    size_t count = 1 + random.Below(std::min<size_t>(other.size() - from, 256));
+                    input.insert(input.begin() + static_cast<ptrdiff_t>(random.Below(size + 1)),
+                                 other.begin() + static_cast<ptrdiff_t>(from),
+                                 other.begin() + static_cast<ptrdiff_t>(from + count));
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    void WriteError(const char* data, size_t length) {
+#ifdef _WIN32
+        _write(2, data, static_cast<unsigned>(length));
+#else
+        (void)!write(2, data, length);
+#endif
+    }
+
+    // The mutation running, for the crash report; SIZE_MAX while seeds run
+    volatile size_t g_run = SIZE_MAX;
+
+    void ReportCrash(int signal) {
+        // Async-signal-safe from here on: no allocation, no stdio
+        char message[64];
+        size_t length = 0;
+        auto append = [&](const char* text) {
+            while (*text) {
+                message[length++] = *text++;
+            }
+        };
+        size_t run = g_run;
+        if (run == SIZE_MAX) {
+            append("Crashed on a seed");
+        } else {
+            append("Crashed on mutation ");
+            char digits[24];
+            size_t count = 0;
+            do {
+                digits[count++] = static_cast<char>('0' + run % 10);
+                run /= 10;
+            } while (run != 0);
+            while (count > 0) {
+                message[length++] = digits[--count];
+            }
+        }
+        message[length++] = '\n';
+        WriteError(message, length);
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace Lumos;
+    size_t runs = 10000;
+    uint64_t seed = 1;
+    size_t dump = SIZE_MAX;
+    std::vector<Fuzz::Input> pool = Fuzz::Seeds();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            dump = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::ifstream in(argv[i], std::ios::binary);
+            if (!in) {
+                std::wcerr << L"Cannot read " << argv[i] << std::endl;
+                return 2;
+            }
+            pool.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+    }
+    if (pool.empty()) {
+        std::wcerr << L"No seeds: are the fixtures under tests/data missing?" << std::endl;
+        return 2;
+    }
+
+    for (int signal : { SIGSEGV, SIGABRT, SIGFPE, SIGILL }) {
+        std::signal(signal, ReportCrash);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (dump == SIZE_MAX) {
+        for (const auto& input : pool) {
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+    }
+
+    Random random(seed);
+    for (size_t run = 0; run < runs; ++run) {
+        Fuzz::Input input = pool[random.Below(pool.size())];
+        Mutate(input, pool, random);
+        if (dump != SIZE_MAX) {
+            if (run == dump) {
+                std::string path = "mutation-" + std::to_string(run) + ".bin";
+                std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(input.data()),
+                                                            static_cast<std::streamsize>(input.size()));
+                std::wcout << L"Wrote " << FromUtf8(path) << std::endl;
+                return 0;
+            }
+            continue;
+        }
+        g_run = run;
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    if (dump != SIZE_MAX) {
+        std::wcerr << L"There is no mutation " << dump << L" in " << runs << L" run(s)" << std::endl;
+        return 2;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::wcout << pool.size() << L" seed(s) and " << runs << L" mutation(s) in " << elapsed.count() << L" ms" << std::endl;
+    return 0;
+}
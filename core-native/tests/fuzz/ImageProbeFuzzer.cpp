@@ -0,0 +1,29 @@
+// Image header probe and embedded-preview search: every byte comes from a
+// file the user merely selected
+#include "Fuzz.h"
+#include "../TestImages.h"
+#include "../../engines/image/EmbeddedPreview.h"
+#include "../../engines/image/ImageHeaderProbe.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    ByteView view(data, size);
+    ImageHeader header;
+    ImageHeaderProbe::Probe(view, header);
+    EmbeddedPreviewFinder::Find(view, 1024, 64);
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    using namespace TestImages;
+    return {
+        Jpeg(640, 480, 6),
+        Png(300, 200, 16, 2, true, 3),
+        Gif(32, 32, 4),
+        Bmp(-100, 50, 32),
+        WebP(800, 600),
+        RgbTiff(64, 48, 16),
+        RawWithPreviews(160, 1600, 8),
+    };
+}
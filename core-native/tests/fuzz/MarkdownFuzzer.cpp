@@ -0,0 +1,27 @@
+// Markdown block parser and inline pass, in the budgeted steps the
+// renderer takes
+#include "Fuzz.h"
+#include "../../engines/markdown/MarkdownParser.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    MarkdownParser parser(std::string_view(reinterpret_cast<const char*>(data), size));
+    MarkdownDocument document;
+    while (parser.Parse(document, 16)) {
+    }
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    return {
+        Fuzz::FromText("# Title\n\nSome *emphasis*, **strong**, `code` and ~~gone~~.\n\n"
+                       "Setext\n======\n\n> quote\n> > nested\n\n- one\n- two\n  1. three\n     continued\n\n"
+                       "---\n\n    indented code\n\n```c++ info\nfenced\n```\n"),
+        Fuzz::FromText("[ref]: https://example.com \"Title\"\n\nSee [the link][ref], [inline](</a b> 'x'), "
+                       "![image](img.png) and <https://auto.link>.\n\n<div>\nhtml block\n</div>\n\n"
+                       "Hard  \nbreak\\\nand &amp; &#169; &#x1F600; entities\n"),
+        Fuzz::FromText("| a | b |:-|\n|:--|--:|\n| 1 | 2 |\n| x \\| y | `|` |\n\n"
+                       "***nested _mixed* emphasis_**\n\n1) a\n2) b\n\n* [ ] task\n"),
+    };
+}
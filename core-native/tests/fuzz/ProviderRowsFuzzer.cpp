@@ -0,0 +1,22 @@
+// The check on rows a decoder worker sends back; the first byte is the
+// row count the worker claims
+#include "Fuzz.h"
+#include "../../worker/DecoderJobs.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    DecoderJobs::IsProviderRows(std::string_view(reinterpret_cast<const char*>(data) + 1, size - 1), data[0]);
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    return {
+        Fuzz::FromText("\x02[{\"name\":\"Dimensions\",\"value\":\"3 x 2\"},"
+                       "{\"name\":\"Comment\",\"value\":\"a \\\"quoted\\\" \\\\ path\\n\\u0007 \xC3\xA9\"}]"),
+        Fuzz::FromText(std::string_view("\0[]", 3)),
+    };
+}
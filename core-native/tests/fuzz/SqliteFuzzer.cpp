@@ -0,0 +1,36 @@
+// SQLite file reader: header, schema walk, and the first and a later page
+// of rows of every table it finds
+#include <memory_resource>
+#include "Fuzz.h"
+#include "../../engines/sqlite/SqliteFile.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    SqliteFile file(ByteView(data, size));
+    if (!file.IsValid()) {
+        return 0;
+    }
+    SqliteSchema schema;
+    file.ReadSchema(schema);
+    std::pmr::string json;
+    schema.WriteJson(json);
+
+    size_t tables = 0;
+    for (const SqliteObject& object : schema.objects) {
+        if (object.type != "table" || ++tables > 8) {
+            continue;
+        }
+        for (uint64_t firstRow : { uint64_t(0), uint64_t(1000) }) {
+            SqliteRows rows;
+            file.ReadRows(object, firstRow, 50, rows);
+            json.clear();
+            rows.WriteJson(json);
+        }
+    }
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    return { Fuzz::ReadData("sqlite/basic.db"), Fuzz::ReadData("sqlite/utf16.db") };
+}
@@ -0,0 +1,23 @@
+// CREATE TABLE parsing, which lays out the records of every table shown
+#include "Fuzz.h"
+#include "../../engines/sqlite/SqliteTableSql.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    SqliteTableSql table = SqliteTableSql::Parse(std::string_view(reinterpret_cast<const char*>(data), size));
+    table.StorageOrder();
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    return {
+        Fuzz::FromText("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT NOT NULL DEFAULT 'x', "
+                       "price REAL CHECK (price > (0)), data BLOB, note)"),
+        Fuzz::FromText("CREATE TABLE kv (k TEXT, v INTEGER DEFAULT -1.5e3, flag TEXT DEFAULT 'none', "
+                       "PRIMARY KEY (v DESC, k)) WITHOUT ROWID, STRICT"),
+        Fuzz::FromText("create table if not exists \"odd \"\"name\"\"\" ([a b] INT, `c` TEXT, "
+                       "d AS (a + 1) VIRTUAL, e GENERATED ALWAYS AS (c || 'x') STORED, -- comment\n"
+                       "CONSTRAINT pk PRIMARY KEY (\"a b\") /* block */)"),
+    };
+}
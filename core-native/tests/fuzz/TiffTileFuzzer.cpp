@@ -0,0 +1,41 @@
+// Raw TIFF tile source: layout from the IFD, then a region decode that
+// follows the file's tile or strip offsets. It maps a file, so each input
+// goes through one on disk.
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "Fuzz.h"
+#include "../TestImages.h"
+#include "../../engines/tiles/RawTiffTileSource.h"
+
+using namespace Lumos;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const std::filesystem::path path = std::filesystem::temp_directory_path() / "lumos-tiff-fuzz.tif";
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(data),
+                                                                  static_cast<std::streamsize>(size));
+    auto source = RawTiffTileSource::Open(path.wstring());
+    if (!source || source->Width() == 0 || source->Height() == 0) {
+        return 0;
+    }
+
+    // The top-left corner at full size, and the whole image sampled down
+    constexpr uint32_t EDGE = 64;
+    static uint8_t pixels[EDGE * EDGE * 4];
+    TileRegion corner{ 0, 0, std::min(source->Width(), EDGE), std::min(source->Height(), EDGE) };
+    source->DecodeRegion(corner, 0, pixels, EDGE * 4, CancellationToken());
+
+    auto scaled = [](uint32_t edge, uint32_t level) { return (uint64_t(edge) + (1ull << level) - 1) >> level; };
+    uint32_t level = 0;
+    while (level < 31 && (scaled(source->Width(), level) > EDGE || scaled(source->Height(), level) > EDGE)) {
+        ++level;
+    }
+    TileRegion whole{ 0, 0, source->Width(), source->Height() };
+    source->DecodeRegion(whole, level, pixels, EDGE * 4, CancellationToken());
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    using namespace TestImages;
+    return { RgbTiff(100, 70, 32), RgbTiff(90, 40, 0), RawWithPreviews(100, 300) };
+}
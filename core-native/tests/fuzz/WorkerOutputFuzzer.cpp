@@ -0,0 +1,102 @@
+// The checks on parse results a decoder worker sends back, each followed by
+// the JSON the pipeline would write from what passed; the first byte picks
+// the encoding
+#include <memory_resource>
+#include "Fuzz.h"
+#include "../../engines/markdown/MarkdownParser.h"
+#include "../../engines/sqlite/SqliteFile.h"
+#include "../../worker/DecoderJobs.h"
+
+using namespace Lumos;
+
+namespace {
+    enum Encoding : uint8_t { Markdown, Schema, Rows, Font, ENCODINGS };
+
+    // `encode` writes into a section-sized buffer
+    template <typename Encode>
+    Fuzz::Input Seed(Encoding encoding, Encode encode) {
+        Fuzz::Input input(1 + 64 * 1024);
+        input[0] = encoding;
+        input.resize(1 + encode(input.data() + 1, input.size() - 1));
+        return input;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    ByteView encoded(data + 1, size - 1);
+    std::pmr::string json;
+    switch (data[0] % ENCODINGS) {
+    case Markdown: {
+        MarkdownDocument document;
+        if (DecoderJobs::DecodeMarkdown(encoded, document)) {
+            document.WriteJson(json);
+        }
+        break;
+    }
+    case Schema: {
+        SqliteSchema schema;
+        if (DecoderJobs::DecodeSchema(encoded, schema)) {
+            schema.WriteJson(json);
+        }
+        break;
+    }
+    case Rows: {
+        SqliteRows rows;
+        if (DecoderJobs::DecodeRows(encoded, rows)) {
+            rows.WriteJson(json);
+        }
+        break;
+    }
+    default: {
+        FontSummary font;
+        DecoderJobs::DecodeFont(encoded, font);
+        break;
+    }
+    }
+    return 0;
+}
+
+std::vector<Fuzz::Input> Fuzz::Seeds() {
+    std::vector<Fuzz::Input> seeds;
+
+    std::string_view text = "# Title\n\n> - *a* [link](x \"t\")\n\n```c\ncode\n```\n\n| a | b |\n|:-|-:|\n| 1 | 2 |\n";
+    MarkdownParser parser(text);
+    MarkdownDocument document;
+    parser.Parse(document, 100);
+    seeds.push_back(Seed(Markdown, [&](uint8_t* out, size_t capacity) {
+        size_t nextBlock = 0;
+        return DecoderJobs::EncodeMarkdown(document, nextBlock, out, capacity);
+    }));
+
+    Fuzz::Input bytes = Fuzz::ReadData("sqlite/basic.db");
+    SqliteFile file(ByteView(bytes.data(), bytes.size()));
+    SqliteSchema schema;
+    file.ReadSchema(schema);
+    seeds.push_back(Seed(Schema, [&](uint8_t* out, size_t capacity) {
+        return DecoderJobs::EncodeSchema(schema, out, capacity);
+    }));
+    for (const SqliteObject& object : schema.objects) {
+        if (object.type == "table" && object.rootPage != 0) {
+            SqliteRows rows;
+            file.ReadRows(object, 0, 20, rows);
+            seeds.push_back(Seed(Rows, [&](uint8_t* out, size_t capacity) {
+                return DecoderJobs::EncodeRows(rows, out, capacity);
+            }));
+            break;
+        }
+    }
+
+    FontSummary font;
+    font.valid = true;
+    font.names.family = "Lumos Test";
+    font.format = FontOutlineFormat::Cff;
+    font.glyphCount = 12;
+    font.height = 400;
+    seeds.push_back(Seed(Font, [&](uint8_t* out, size_t capacity) {
+        return DecoderJobs::EncodeFont(font, out, capacity);
+    }));
+    return seeds;
+}
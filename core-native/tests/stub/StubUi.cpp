@@ -0,0 +1,63 @@
+// Stands in for the UI process in ui-process-tests: it speaks the POSIX
+// side of the readiness handshake and nothing else. LUMOS_STUB_UI picks
+// the behaviour:
+//
+//   ready    signal readiness, then run until terminated (the default)
+//   slow     as ready, after LUMOS_STUB_UI_DELAY_MS
+//   exit     exit with status 1 without signalling
+//   silent   never signal; run until terminated
+//   crash    signal readiness, then exit after LUMOS_STUB_UI_DELAY_MS
+//
+// Each start appends a line to LUMOS_STUB_UI_LOG, when set, so a test can
+// count respawns.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    std::chrono::milliseconds Delay() {
+        const char* value = std::getenv("LUMOS_STUB_UI_DELAY_MS");
+        return std::chrono::milliseconds(value ? std::atoi(value) : 100);
+    }
+
+    bool SignalReady() {
+        // The launcher passes the pipe's descriptor; it must be all we need
+        const char* fd = std::getenv("LUMOS_READY_FD");
+        if (!fd) {
+            return false;
+        }
+        return write(std::atoi(fd), "ready", 5) == 5;
+    }
+}
+
+int main() {
+    if (const char* log = std::getenv("LUMOS_STUB_UI_LOG")) {
+        if (std::FILE* file = std::fopen(log, "a")) {
+            std::fprintf(file, "%d\n", static_cast<int>(getpid()));
+            std::fclose(file);
+        }
+    }
+
+    const char* value = std::getenv("LUMOS_STUB_UI");
+    std::string mode = value ? value : "ready";
+    if (mode == "exit") {
+        return 1;
+    }
+    if (mode == "slow") {
+        std::this_thread::sleep_for(Delay());
+    }
+    if (mode != "silent" && !SignalReady()) {
+        return 2;
+    }
+    if (mode == "crash") {
+        std::this_thread::sleep_for(Delay());
+        return 3;
+    }
+    while (true) {
+        pause();
+    }
+}
@@ -0,0 +1,114 @@
+// lumos-metrics: print the latency percentiles and gauges a running Lumos
+// core publishes (see metrics/Metrics.h).
+//
+//   lumos-metrics [<process id> | <section name>] [--watch <seconds>]
+//
+// With no process on Linux it reads every live core found in /dev/shm.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../metrics/MetricsReport.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <dirent.h>
+#endif
+
+using namespace Lumos;
+
+namespace {
+    uint64_t UnixMilliseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    std::string SectionForProcess(const std::string& processId) {
+#ifdef _WIN32
+        return std::string("Local\\") + Metrics::SECTION_PREFIX + "." + processId;
+#else
+        return std::string("/") + Metrics::SECTION_PREFIX + "." + processId;
+#endif
+    }
+
+    // Sections of cores still running; a core that crashed leaves its
+    // POSIX section behind
+    std::vector<std::string> FindSections() {
+        std::vector<std::string> sections;
+#ifndef _WIN32
+        std::string prefix = std::string(Metrics::SECTION_PREFIX) + ".";
+        if (DIR* directory = opendir("/dev/shm")) {
+            while (dirent* entry = readdir(directory)) {
+                std::string name = entry->d_name;
+                if (name.compare(0, prefix.size(), prefix) != 0) {
+                    continue;
+                }
+                pid_t process = static_cast<pid_t>(std::strtol(name.c_str() + prefix.size(), nullptr, 10));
+                if (process > 0 && (kill(process, 0) == 0 || errno == EPERM)) {
+                    sections.push_back("/" + name);
+                } else {
+                    std::wcerr << L"Skipping /dev/shm/" << name.c_str() << L": its process is gone" << std::endl;
+                }
+            }
+            closedir(directory);
+        }
+#endif
+        return sections;
+    }
+
+    bool Dump(const std::string& section) {
+        MetricsSnapshot snapshot;
+        std::wstring error;
+        if (!MetricsReport::CaptureSection(section, snapshot, error)) {
+            std::wcerr << error << std::endl;
+            return false;
+        }
+        std::wcout << MetricsReport::Format(snapshot, UnixMilliseconds()) << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> sections;
+    int watchSeconds = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            watchSeconds = std::atoi(argv[++i]);
+        } else if (std::strspn(argv[i], "0123456789") == std::strlen(argv[i])) {
+            sections.push_back(SectionForProcess(argv[i]));
+        } else if (argv[i][0] != '-') {
+            sections.push_back(argv[i]);
+        } else {
+            std::wcerr << L"Usage: lumos-metrics [<process id> | <section name>] [--watch <seconds>]" << std::endl;
+            return 2;
+        }
+    }
+    if (sections.empty()) {
+        if (const char* inherited = std::getenv(Metrics::ENVIRONMENT_VARIABLE)) {
+            sections.push_back(inherited);
+        } else {
+            sections = FindSections();
+        }
+    }
+    if (sections.empty()) {
+        std::wcerr << L"No running Lumos core found; pass its process id" << std::endl;
+        return 1;
+    }
+
+    while (true) {
+        bool ok = true;
+        for (const auto& section : sections) {
+            ok = Dump(section) && ok;
+        }
+        if (watchSeconds <= 0) {
+            return ok ? 0 : 1;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(watchSeconds));
+    }
+}
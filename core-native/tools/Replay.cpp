@@ -0,0 +1,361 @@
+// lumos-replay: replay a recorded session (see replay/SessionRecorder.h)
+// against the real preview pipeline and report per-stage latency.
+//
+//   lumos-replay <session> [--baseline <file>] [--write-baseline <file>]
+//                [--headroom <factor>] [--keep-worst] [--paced]
+//                [--iterations <n>] [--tolerance <factor>] [--slack-ms <ms>]
+//                [--decode-workers <n>] [--files <directory>] [--verbose]
+//
+// Serial by default: each press runs to completion before the next, which
+// is what a baseline compares best against. --paced keeps the recorded
+// gaps, so fast presses supersede each other as they did live. Exits 1 if
+// a stage regressed against the baseline, or if the hook guard now decides
+// a recorded key differently.
+//
+// A written baseline is this run's percentiles times --headroom. With
+// --keep-worst, a stage already in that file keeps its larger values, so
+// running a few times (on a loaded machine too) gives a baseline that one
+// quiet run cannot make too tight.
+//
+// The report also counts heap allocations per press over the last
+// iteration, process-wide, once caches and buffers have warmed up.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../cache/ChangeMonitor.h"
+#include "../cache/PreviewCache.h"
+#include "../common/Utf8.h"
+#include "../common/WorkerPool.h"
+#include "../hooks/HookGuard.h"
+#include "../io/IOScheduler.h"
+#include "../memory/MemoryGovernor.h"
+#include "../metrics/Metrics.h"
+#include "../metrics/MetricsReport.h"
+#include "../pipeline/PreviewPipeline.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../replay/ReplayBaseline.h"
+#include "../replay/ReplayFiles.h"
+#include "../replay/ReplaySelection.h"
+#include "../replay/ReplaySink.h"
+#include "../replay/SessionLog.h"
+#include "../worker/DecoderPool.h"
+#include "../worker/DecoderWorker.h"
+
+using namespace Lumos;
+
+namespace {
+    std::atomic<uint64_t> g_allocations{ 0 };
+}
+
+// Every heap allocation in the process goes through here, so a press that
+// touches the heap shows up in the report
+void* operator new(std::size_t bytes) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes != 0 ? bytes : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    struct Options {
+        std::wstring session;
+        std::wstring baseline;
+        std::wstring writeBaseline;
+        std::wstring files;
+        bool paced = false;
+        bool verbose = false;
+        int iterations = 1;
+        double tolerance = 3.0;
+        double headroom = 2.0;
+        bool keepWorst = false;
+        uint64_t slackMs = 1;
+        size_t decodeWorkers = DecoderPool::DefaultWorkerCount();
+    };
+
+    // A press still in the pipeline this long means it hung
+    constexpr auto IDLE_TIMEOUT = std::chrono::seconds(30);
+
+    bool ParseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const char* argument = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (std::strcmp(argument, "--baseline") == 0 && hasValue) {
+                options.baseline = FromUtf8(argv[++i]);
+            } else if (std::strcmp(argument, "--write-baseline") == 0 && hasValue) {
+                options.writeBaseline = FromUtf8(argv[++i]);
+            } else if (std::strcmp(argument, "--files") == 0 && hasValue) {
+                options.files = FromUtf8(argv[++i]);
+            } else if (std::strcmp(argument, "--headroom") == 0 && hasValue) {
+                options.headroom = std::atof(argv[++i]);
+            } else if (std::strcmp(argument, "--keep-worst") == 0) {
+                options.keepWorst = true;
+            } else if (std::strcmp(argument, "--iterations") == 0 && hasValue) {
+                options.iterations = std::max(1, std::atoi(argv[++i]));
+            } else if (std::strcmp(argument, "--tolerance") == 0 && hasValue) {
+                options.tolerance = std::atof(argv[++i]);
+            } else if (std::strcmp(argument, "--slack-ms") == 0 && hasValue) {
+                options.slackMs = std::strtoull(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argument, "--decode-workers") == 0 && hasValue) {
+                options.decodeWorkers = std::strtoull(argv[++i], nullptr, 10);  // 0 decodes in-process
+            } else if (std::strcmp(argument, "--paced") == 0) {
+                options.paced = true;
+            } else if (std::strcmp(argument, "--verbose") == 0) {
+                options.verbose = true;
+            } else if (argument[0] != '-' && options.session.empty()) {
+                options.session = FromUtf8(argument);
+            } else {
+                return false;
+            }
+        }
+        return !options.session.empty() && options.tolerance >= 1.0 && options.headroom >= 1.0;
+    }
+
+    // The file each recorded press saw selected. Presses superseded before
+    // their selection resolved take the next one that did resolve; Explorer
+    // had moved on to it by then.
+    std::vector<int64_t> SelectionPerPress(const Session& session) {
+        uint64_t presses = 0;
+        for (const auto& key : session.keys) {
+            presses += key.triggered ? 1 : 0;
+        }
+        std::vector<int64_t> files(presses, SessionSelection::NONE);
+        std::vector<bool> resolved(presses, false);
+        for (const auto& selection : session.selections) {
+            if (selection.press < presses && !resolved[selection.press]) {
+                files[selection.press] = selection.file;
+                resolved[selection.press] = true;
+            }
+        }
+        for (size_t i = presses; i-- > 0;) {
+            if (!resolved[i] && i + 1 < presses) {
+                files[i] = files[i + 1];
+            }
+        }
+        return files;
+    }
+
+    bool WaitIdle(const PreviewPipeline& pipeline) {
+        auto deadline = std::chrono::steady_clock::now() + IDLE_TIMEOUT;
+        while (true) {
+            PreviewPipeline::Stats stats = pipeline.GetStats();
+            if (stats.completed + stats.superseded + stats.coalesced >= stats.submitted) {
+                return true;
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    uint64_t UnixMilliseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // The decoder pool launches this executable as its workers
+    if (DecoderWorker::IsWorkerCommandLine(argc, argv)) {
+        return DecoderWorker().Run(argc, argv);
+    }
+
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::wcerr << L"Usage: lumos-replay <session> [--baseline <file>] [--write-baseline <file>]\n"
+                      L"                    [--headroom <factor>] [--keep-worst] [--paced]\n"
+                      L"                    [--iterations <n>] [--tolerance <factor>] [--slack-ms <ms>]\n"
+                      L"                    [--decode-workers <n>] [--files <directory>] [--verbose]" << std::endl;
+        return 2;
+    }
+
+    Session session;
+    std::wstring error;
+    if (!SessionLog::Load(options.session, session, error)) {
+        std::wcerr << error << std::endl;
+        return 2;
+    }
+    std::vector<BaselineStage> baseline;
+    if (!options.baseline.empty() && !ReplayBaseline::Load(options.baseline, baseline, error)) {
+        std::wcerr << error << std::endl;
+        return 2;
+    }
+    std::vector<BaselineStage> worst;
+    if (options.keepWorst && !options.writeBaseline.empty()) {
+        // A first run has nothing to keep
+        if (std::FILE* existing = SessionLog::OpenFile(options.writeBaseline, "rb")) {
+            std::fclose(existing);
+            if (!ReplayBaseline::Load(options.writeBaseline, worst, error)) {
+                std::wcerr << error << std::endl;
+                return 2;
+            }
+        }
+    }
+
+    std::wstring directory = options.files.empty() ? ReplayFiles::DefaultDirectory() : options.files;
+    std::vector<std::wstring> paths;
+    if (!ReplayFiles::Materialize(session, directory, paths, error)) {
+        std::wcerr << error << std::endl;
+        ReplayFiles::Remove(directory, paths);
+        return 2;
+    }
+    std::vector<int64_t> pressFiles = SelectionPerPress(session);
+
+    // The pipeline logs every press; keep the report readable
+    std::wstreambuf* console = std::wcout.rdbuf();
+    if (!options.verbose) {
+        std::wcout.rdbuf(nullptr);
+    }
+
+    size_t guardMismatches = 0;
+    bool hung = false;
+    std::chrono::steady_clock::duration elapsed{};
+    PreviewPipeline::Stats previews{};
+    DecoderPool::Stats decoding{};
+    uint64_t lastIterationPresses = 0;
+    uint64_t lastIterationAllocations = 0;
+    ReplaySink sink;
+    {
+        // Assembled as in main.cpp, minus the UI, Explorer and provider
+        // libraries (a replay must not depend on what is installed)
+        IOScheduler ioScheduler;
+        MemoryGovernor memoryGovernor;
+        PreviewCache previewCache(memoryGovernor, "preview-cache");
+        ChangeMonitor changeMonitor(ioScheduler);
+        changeMonitor.Subscribe(previewCache);
+        changeMonitor.Start();
+        WorkerPool workerPool;
+        ProviderRegistry providers;
+        DecoderPool decoders(options.decodeWorkers);
+        decoders.Start();
+
+        ReplayCursor cursor;
+        PreviewPipeline pipeline(ioScheduler, sink,
+                                 [&cursor](IOScheduler& io) { return std::make_unique<ReplaySelection>(io, cursor); },
+                                 previewCache, memoryGovernor, changeMonitor, workerPool, providers, decoders);
+        if (!pipeline.Start()) {
+            std::wcout.rdbuf(console);
+            std::wcerr << L"Failed to start the pipeline" << std::endl;
+            ReplayFiles::Remove(directory, paths);
+            return 1;
+        }
+
+        auto replayStart = std::chrono::steady_clock::now();
+        for (int iteration = 0; iteration < options.iterations && !hung; ++iteration) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t pressesBefore = pipeline.GetStats().submitted;
+            uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+            size_t recordedPress = 0;
+            for (const auto& key : session.keys) {
+                if (options.paced) {
+                    std::this_thread::sleep_until(start + std::chrono::microseconds(key.at));
+                }
+
+                // Explorer's selection moves before the key goes down
+                if (key.triggered) {
+                    int64_t file = pressFiles[recordedPress++];
+                    cursor.Select(file == SessionSelection::NONE ? std::wstring_view() : paths[static_cast<size_t>(file)]);
+                }
+
+                // What KeyboardHook does for the key, minus reading window classes
+                bool triggered;
+                {
+                    ScopedLatency latency(Histogram::HookCallback);
+                    triggered = HookGuard::ShouldTriggerPreview(key.context);
+                    if (triggered) {
+                        pipeline.Submit();
+                    }
+                }
+                if (triggered != key.triggered) {
+                    ++guardMismatches;
+                }
+
+                if (!options.paced && triggered && !WaitIdle(pipeline)) {
+                    hung = true;
+                    break;
+                }
+            }
+            hung = hung || !WaitIdle(pipeline);
+            lastIterationPresses = pipeline.GetStats().submitted - pressesBefore;
+            lastIterationAllocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        }
+        elapsed = std::chrono::steady_clock::now() - replayStart;
+        previews = pipeline.GetStats();
+        decoding = decoders.GetStats();
+        pipeline.Stop();
+    }
+    std::wcout.rdbuf(console);
+    ReplayFiles::Remove(directory, paths);
+
+    ReplaySink::Stats sent = sink.GetStats();
+    Metrics::SetGauge("Presses", MetricUnit::Count, previews.submitted);
+    Metrics::SetGauge("Presses superseded", MetricUnit::Count, previews.superseded + previews.coalesced);
+    Metrics::SetGauge("Preview requests", MetricUnit::Count, sent.requests);
+    Metrics::SetGauge("Messages", MetricUnit::Count, sent.messages);
+    Metrics::SetGauge("Message bytes", MetricUnit::Bytes, sent.bytes);
+    Metrics::SetGauge("Decoder jobs", MetricUnit::Count, decoding.jobs);
+    Metrics::SetGauge("Decoder crashes and timeouts", MetricUnit::Count, decoding.crashes + decoding.timeouts);
+    Metrics::SetGauge("Heap allocations per press", MetricUnit::Count,
+                      lastIterationPresses != 0 ? lastIterationAllocations / lastIterationPresses : 0);
+
+    MetricsSnapshot snapshot;
+    MetricsReport::Capture(Metrics::Live(), snapshot);
+    std::wcout << L"Replayed " << options.session << L": " << session.keys.size() << L" keys, "
+               << session.files.size() << L" files, " << options.iterations << L" iteration(s), "
+               << (options.paced ? L"paced" : L"serial") << L", "
+               << MetricsReport::FormatDuration(static_cast<uint64_t>(
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()))
+               << L"\n" << std::endl;
+    std::wcout << MetricsReport::Format(snapshot, UnixMilliseconds()) << std::endl;
+
+    int status = 0;
+    if (hung) {
+        std::wcerr << L"A press did not finish within " << IDLE_TIMEOUT.count() << L" s" << std::endl;
+        status = 1;
+    }
+    if (guardMismatches > 0) {
+        std::wcerr << guardMismatches << L" key(s) where the hook guard now decides differently than recorded"
+                   << std::endl;
+        status = 1;
+    }
+    if (!options.writeBaseline.empty()) {
+        if (ReplayBaseline::Save(options.writeBaseline,
+                                 ReplayBaseline::FromSnapshot(snapshot, options.headroom, worst))) {
+            std::wcout << L"Baseline written to " << options.writeBaseline << std::endl;
+        } else {
+            std::wcerr << L"Cannot write " << options.writeBaseline << std::endl;
+            status = 1;
+        }
+    }
+    if (!options.baseline.empty()) {
+        auto regressions = ReplayBaseline::Compare(baseline, snapshot, options.tolerance,
+                                                   options.slackMs * 1000000);
+        for (const auto& regression : regressions) {
+            std::wcerr << L"Regression: " << regression << std::endl;
+        }
+        if (regressions.empty()) {
+            std::wcout << L"Within " << options.tolerance << L"x of " << options.baseline << std::endl;
+        } else {
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,881 @@
+#include "DecoderJobs.h"
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include "../common/Utf8.h"
+#include "../engines/font/FontSpecimen.h"
+#include "../engines/font/GlyphCache.h"
+#include "../engines/markdown/MarkdownParser.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../io/MappedFile.h"
+#include "../ipc/SharedMemory.h"
+#include "../plugins/ProviderRegistry.h"
+
+namespace Lumos {
+    // Headers cross the section as raw bytes between two copies of the same build
+    static_assert(std::is_trivially_copyable_v<ImageHeader>, "ImageHeader is copied through shared memory");
+    static_assert(std::is_trivially_copyable_v<EmbeddedPreview>, "EmbeddedPreview is copied through shared memory");
+
+    namespace {
+        bool SkipLiteral(std::string_view json, size_t& i, std::string_view literal) {
+            if (json.substr(i, literal.size()) != literal) {
+                return false;
+            }
+            i += literal.size();
+            return true;
+        }
+
+        bool IsHexDigit(char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        // A string as AppendJsonString writes it: valid UTF-8, and only the
+        // escapes it uses
+        bool SkipJsonString(std::string_view json, size_t& i) {
+            if (!SkipLiteral(json, i, "\"")) {
+                return false;
+            }
+            while (i < json.size()) {
+                auto c = static_cast<unsigned char>(json[i]);
+                if (c == '"') {
+                    ++i;
+                    return true;
+                }
+                if (c < 0x20) {
+                    return false;
+                }
+                if (c == '\\') {
+                    std::string_view escape = json.substr(i, 2);
+                    if (escape == "\\\"" || escape == "\\\\" || escape == "\\n" || escape == "\\t") {
+                        i += 2;
+                    } else if (json.substr(i, 4) == "\\u00" && i + 6 <= json.size() && IsHexDigit(json[i + 4]) &&
+                               IsHexDigit(json[i + 5])) {
+                        i += 6;
+                    } else {
+                        return false;
+                    }
+                    continue;
+                }
+                size_t length = Utf8SequenceLength(json, i);
+                if (length == 0) {
+                    return false;
+                }
+                i += length;
+            }
+            return false;
+        }
+
+        // Fields appended to a worker's section in host order. Past the
+        // capacity nothing more is written and Full() stays set.
+        class SectionWriter {
+        public:
+            SectionWriter(uint8_t* data, size_t capacity)
+                : m_data(data)
+                , m_capacity(capacity)
+                , m_size(0)
+                , m_full(false)
+            {
+            }
+
+            template <typename T>
+            void Put(T value) {
+                static_assert(std::is_arithmetic_v<T>, "Only plain numbers cross the section");
+                Append(&value, sizeof(value));
+            }
+
+            // Length-prefixed bytes
+            void PutString(std::string_view text) {
+                if (text.size() > UINT32_MAX) {
+                    m_full = true;
+                    return;
+                }
+                Put(static_cast<uint32_t>(text.size()));
+                Append(text.data(), text.size());
+            }
+
+            // Overwrite a number written earlier at `offset`
+            template <typename T>
+            void Patch(size_t offset, T value) {
+                if (offset + sizeof(value) <= m_size) {
+                    std::memcpy(m_data + offset, &value, sizeof(value));
+                }
+            }
+
+            size_t Size() const { return m_size; }
+            bool Full() const { return m_full; }
+
+            // Drop everything after `size`, such as a row that did not fit
+            void Rewind(size_t size) {
+                m_size = size;
+                m_full = false;
+            }
+
+        private:
+            void Append(const void* bytes, size_t length) {
+                if (m_full || length > m_capacity - m_size) {
+                    m_full = true;
+                    return;
+                }
+                std::memcpy(m_data + m_size, bytes, length);
+                m_size += length;
+            }
+
+            uint8_t* m_data;
+            size_t m_capacity;
+            size_t m_size;
+            bool m_full;
+        };
+
+        // The reading side, for output a worker may have forged. Any read
+        // past the end fails, and so does every read after it.
+        class SectionReader {
+        public:
+            explicit SectionReader(ByteView data)
+                : m_data(data)
+                , m_offset(0)
+                , m_failed(false)
+            {
+            }
+
+            template <typename T>
+            bool Get(T& value) {
+                static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Read flags as uint8_t");
+                if (m_failed || !m_data.Has(m_offset, sizeof(value))) {
+                    m_failed = true;
+                    return false;
+                }
+                std::memcpy(&value, m_data.Data() + m_offset, sizeof(value));
+                m_offset += sizeof(value);
+                return true;
+            }
+
+            // A 0 or 1 byte
+            bool GetFlag(bool& value) {
+                uint8_t byte = 0;
+                if (!Get(byte) || byte > 1) {
+                    m_failed = true;
+                    return false;
+                }
+                value = byte != 0;
+                return true;
+            }
+
+            bool GetString(std::string_view& text) {
+                uint32_t length = 0;
+                if (!Get(length) || !m_data.Has(m_offset, length)) {
+                    m_failed = true;
+                    return false;
+                }
+                text = std::string_view(reinterpret_cast<const char*>(m_data.Data() + m_offset), length);
+                m_offset += length;
+                return true;
+            }
+
+            bool GetString(std::string& text) {
+                std::string_view view;
+                if (!GetString(view)) {
+                    return false;
+                }
+                text.assign(view);
+                return true;
+            }
+
+            // Whether `count` more items of at least `minimumBytes` each could follow
+            bool Holds(uint64_t count, size_t minimumBytes) const {
+                return !m_failed && count <= (m_data.Size() - m_offset) / minimumBytes;
+            }
+
+            bool AtEnd() const { return !m_failed && m_offset == m_data.Size(); }
+
+        private:
+            ByteView m_data;
+            size_t m_offset;
+            bool m_failed;
+        };
+
+        // Smallest encodings, bounding counts a worker claims before
+        // anything is reserved for them
+        constexpr size_t MIN_MARKDOWN_BLOCK_BYTES = 21;
+        constexpr size_t MIN_MARKDOWN_RUN_BYTES = 13;
+        constexpr size_t MIN_SCHEMA_OBJECT_BYTES = 20;
+        constexpr size_t MIN_COLUMN_BYTES = 4;
+        constexpr size_t MIN_VALUE_BYTES = 30;
+
+        // Flags of a Markdown Partial
+        constexpr uint64_t MARKDOWN_FLAGS = DecoderJobs::BATCH_COMPLETE | DecoderJobs::BATCH_TRUNCATED;
+
+        // A job reading `file`, routed by path so repeat previews find it mapped
+        DecoderJob FileJob(WorkerJobKind kind, const DecoderFile& file, std::string_view arguments,
+                           std::chrono::milliseconds timeout) {
+            DecoderJob job;
+            job.kind = kind;
+            job.affinity = std::hash<std::wstring_view>()(file.path);
+            job.arguments = arguments;
+            job.values[0] = file.size;
+            job.values[1] = file.modifiedTime;
+            job.timeout = timeout;
+            return job;
+        }
+
+        void ReportMalformed(const wchar_t* what, const DecoderFile& file) {
+            std::wcerr << L"Decoder worker sent a malformed " << what << L" for " << file.path << std::endl;
+        }
+
+        void EncodeMarkdownBlock(const MarkdownDocument& document, const MarkdownBlock& block, SectionWriter& writer) {
+            writer.Put(static_cast<uint8_t>(block.kind));
+            writer.Put(block.level);
+            writer.Put(block.quoteDepth);
+            writer.Put(block.listDepth);
+            writer.Put(static_cast<uint8_t>(block.listItemStart));
+            writer.Put(static_cast<uint8_t>(block.listOrdered));
+            writer.Put(static_cast<uint8_t>(block.tableHeader));
+            writer.Put(block.cellCount);
+            writer.Put(block.listNumber);
+            writer.PutString(document.Text(block.infoOffset, block.infoLength));
+            writer.Put(block.runCount);
+            for (uint32_t r = 0; r < block.runCount; ++r) {
+                const MarkdownRun& run = document.runs[block.firstRun + r];
+                writer.PutString(document.Text(run.textOffset, run.textLength));
+                writer.PutString(document.Text(run.linkOffset, run.linkLength));
+                writer.Put(run.style);
+                writer.Put(run.cell);
+                writer.Put(static_cast<uint8_t>(run.align));
+            }
+        }
+
+        // Text rebuilt on this side, so offsets are ours rather than the worker's
+        bool AppendText(MarkdownDocument& out, std::string_view text, uint32_t& offset, uint32_t& length) {
+            if (out.text.size() + text.size() > UINT32_MAX) {
+                return false;
+            }
+            offset = text.empty() ? 0 : static_cast<uint32_t>(out.text.size());
+            length = static_cast<uint32_t>(text.size());
+            out.text.append(text);
+            return true;
+        }
+
+        bool DecodeMarkdownBlock(SectionReader& reader, MarkdownDocument& out) {
+            uint8_t kind = 0;
+            uint8_t align = 0;
+            std::string_view info;
+            MarkdownBlock block = {};
+            if (!reader.Get(kind) || kind > static_cast<uint8_t>(MarkdownBlockKind::TableRow) ||
+                !reader.Get(block.level) || block.level > 6 || !reader.Get(block.quoteDepth) ||
+                !reader.Get(block.listDepth) || !reader.GetFlag(block.listItemStart) ||
+                !reader.GetFlag(block.listOrdered) || !reader.GetFlag(block.tableHeader) ||
+                !reader.Get(block.cellCount) || !reader.Get(block.listNumber) || !reader.GetString(info) ||
+                !AppendText(out, info, block.infoOffset, block.infoLength) || !reader.Get(block.runCount) ||
+                !reader.Holds(block.runCount, MIN_MARKDOWN_RUN_BYTES) || out.runs.size() + block.runCount > UINT32_MAX) {
+                return false;
+            }
+            block.kind = static_cast<MarkdownBlockKind>(kind);
+            block.firstRun = static_cast<uint32_t>(out.runs.size());
+            for (uint32_t r = 0; r < block.runCount; ++r) {
+                MarkdownRun run = {};
+                std::string_view text;
+                std::string_view link;
+                if (!reader.GetString(text) || !reader.GetString(link) || !reader.Get(run.style) ||
+                    (run.style & ~0x7F) != 0 || !reader.Get(run.cell) || !reader.Get(align) ||
+                    align > static_cast<uint8_t>(MarkdownAlign::Right) ||
+                    !AppendText(out, text, run.textOffset, run.textLength) ||
+                    !AppendText(out, link, run.linkOffset, run.linkLength)) {
+                    return false;
+                }
+                run.align = static_cast<MarkdownAlign>(align);
+                out.runs.push_back(run);
+            }
+            out.blocks.push_back(block);
+            return true;
+        }
+
+        void EncodeValue(const SqliteValue& value, SectionWriter& writer) {
+            writer.Put(static_cast<uint8_t>(value.type));
+            writer.Put(static_cast<uint8_t>(value.truncated));
+            writer.Put(value.integer);
+            writer.Put(value.real);
+            writer.PutString(value.bytes);
+            writer.Put(value.size);
+        }
+
+        bool DecodeValue(SectionReader& reader, SqliteValue& value) {
+            uint8_t type = 0;
+            if (!reader.Get(type) || type > static_cast<uint8_t>(SqliteValueType::Blob) ||
+                !reader.GetFlag(value.truncated) || !reader.Get(value.integer) || !reader.Get(value.real) ||
+                !reader.GetString(value.bytes) || !reader.Get(value.size)) {
+                return false;
+            }
+            value.type = static_cast<SqliteValueType>(type);
+            return true;
+        }
+    }
+
+    ProbeStatus DecoderJobs::ProbeImage(DecoderPool& pool, ByteView head, uint64_t affinity,
+                                        const CancellationToken& cancellation, ImageHeader& out) {
+        DecoderJob job;
+        job.kind = WorkerJobKind::ImageProbe;
+        job.affinity = affinity;
+        job.input = head;
+        job.timeout = PROBE_TIMEOUT;
+
+        ProbeStatus status = ProbeStatus::Malformed;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (reply.final && reply.code <= static_cast<uint16_t>(ProbeStatus::Malformed)) {
+                status = static_cast<ProbeStatus>(reply.code);
+                if (status == ProbeStatus::Ok && reply.output.Size() == sizeof(ImageHeader)) {
+                    std::memcpy(&out, reply.output.Data(), sizeof(ImageHeader));
+                } else if (status == ProbeStatus::Ok) {
+                    status = ProbeStatus::Malformed;
+                }
+            }
+            return true;
+        });
+        if (ran == DecoderStatus::Unavailable) {
+            return ImageHeaderProbe::Probe(head, out);
+        }
+        return ran == DecoderStatus::Ok ? status : ProbeStatus::Malformed;
+    }
+
+    LumosPreviewResult DecoderJobs::RunProvider(DecoderPool& pool, const NativeProvider& provider, const DecoderFile& file,
+                                                const CancellationToken& cancellation, const ProviderBatchCallback& onBatch,
+                                                size_t& rowCount, size_t& batchCount) {
+        std::string arguments = EncodeProviderArguments(provider.library, file.path, file.extension);
+        DecoderJob job;
+        job.kind = WorkerJobKind::ProviderPreview;
+        job.affinity = std::hash<std::wstring_view>()(file.path);
+        job.arguments = arguments;
+        job.values[0] = file.size;
+        job.values[1] = file.modifiedTime;
+        job.values[2] = static_cast<uint64_t>(provider.costClass == LUMOS_COST_FULL ? MapAccess::Sequential : MapAccess::Random);
+        job.timeout = PROVIDER_TIMEOUT;
+
+        uint16_t result = LUMOS_PREVIEW_FAILED;
+        uint32_t shownRows = 0;
+        uint64_t nextRow = 0;
+        bool complete = false;
+        bool malformed = false;
+        rowCount = 0;
+        batchCount = 0;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (reply.final) {
+                result = reply.code;
+                return true;
+            }
+            ProviderBatch batch;
+            batch.firstRow = static_cast<uint32_t>(reply.values[0]);
+            batch.rowCount = static_cast<uint32_t>(reply.values[1]);
+            batch.complete = (reply.values[2] & BATCH_COMPLETE) != 0;
+            batch.failed = (reply.values[2] & BATCH_FAILED) != 0;
+            batch.truncated = (reply.values[2] & BATCH_TRUNCATED) != 0;
+            batch.rowsJson = std::string_view(reinterpret_cast<const char*>(reply.output.Data()), reply.output.Size());
+
+            // The rows go to the UI as they are; a worker is no more trusted
+            // than the file it parsed
+            if (reply.values[0] != nextRow || reply.values[1] > ProviderSession::MAX_ROWS - nextRow ||
+                !IsProviderRows(batch.rowsJson, batch.rowCount)) {
+                std::wcerr << L"Provider " << FromUtf8(provider.name) << L" sent malformed rows from its worker"
+                           << std::endl;
+                malformed = true;
+                return false;
+            }
+            nextRow += batch.rowCount;
+            ++batchCount;
+            complete = batch.complete;
+            bool sent = onBatch(batch);
+            if (sent) {
+                shownRows = batch.firstRow + batch.rowCount;
+            }
+            return sent;
+        });
+        rowCount = shownRows;
+
+        if (ran == DecoderStatus::Ok && !malformed) {
+            return result <= LUMOS_PREVIEW_CANCELLED ? static_cast<LumosPreviewResult>(result) : LUMOS_PREVIEW_FAILED;
+        }
+        if (cancellation.IsCancellationRequested()) {
+            return LUMOS_PREVIEW_CANCELLED;
+        }
+        if (batchCount == 0) {
+            return LUMOS_PREVIEW_UNSUPPORTED;
+        }
+        if (!complete) {
+            // The UI would otherwise wait on "Reading…" for rows that never come
+            ProviderBatch last;
+            last.firstRow = shownRows;
+            last.complete = true;
+            last.failed = true;
+            last.rowsJson = "[]";
+            onBatch(last);
+        }
+        return LUMOS_PREVIEW_FAILED;
+    }
+
+    DecoderStatus DecoderJobs::FindEmbeddedPreview(DecoderPool& pool, const DecoderFile& file, uint32_t targetEdge,
+                                                   uint32_t minimumEdge, const CancellationToken& cancellation,
+                                                   EmbeddedPreview& out) {
+        std::string arguments = ToUtf8(file.path);
+        DecoderJob job = FileJob(WorkerJobKind::EmbeddedPreview, file, arguments, PARSE_TIMEOUT);
+        job.values[2] = targetEdge;
+        job.values[3] = minimumEdge;
+
+        out = EmbeddedPreview();
+        bool malformed = false;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (!reply.final || reply.code != 0 || reply.output.Size() == 0) {
+                return reply.final;
+            }
+            EmbeddedPreview preview;
+            if (reply.output.Size() != sizeof(preview)) {
+                malformed = true;
+                return true;
+            }
+            std::memcpy(&preview, reply.output.Data(), sizeof(preview));
+
+            // The UI decodes these bytes of the file; JPEG edges are 16-bit
+            malformed = preview.source > EmbeddedPreviewSource::TiffIfd || preview.length == 0 ||
+                        preview.offset > file.size || preview.length > file.size - preview.offset ||
+                        preview.width == 0 || preview.width > 0xFFFF || preview.height == 0 ||
+                        preview.height > 0xFFFF || preview.orientation < 1 || preview.orientation > 8;
+            if (!malformed) {
+                out = preview;
+            }
+            return true;
+        });
+        if (malformed) {
+            ReportMalformed(L"embedded preview", file);
+            return DecoderStatus::Crashed;
+        }
+        return ran;
+    }
+
+    DecoderStatus DecoderJobs::ParseMarkdown(DecoderPool& pool, const DecoderFile& file,
+                                             const CancellationToken& cancellation, MarkdownDocument& chunk,
+                                             const MarkdownChunkCallback& onChunk) {
+        std::string arguments = ToUtf8(file.path);
+        DecoderJob job = FileJob(WorkerJobKind::MarkdownPreview, file, arguments, PARSE_TIMEOUT);
+
+        bool sent = false;
+        bool complete = false;
+        bool malformed = false;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (reply.final) {
+                return true;
+            }
+            chunk.Clear();
+            if ((reply.values[0] & ~MARKDOWN_FLAGS) != 0 || !DecodeMarkdown(reply.output, chunk)) {
+                malformed = true;
+                return false;
+            }
+            sent = true;
+            complete = (reply.values[0] & BATCH_COMPLETE) != 0;
+            return onChunk(chunk, complete, (reply.values[0] & BATCH_TRUNCATED) != 0);
+        });
+        if (malformed) {
+            ReportMalformed(L"Markdown chunk", file);
+            ran = DecoderStatus::Crashed;
+        }
+
+        // The UI would otherwise wait for blocks that never come
+        if (ran != DecoderStatus::Ok && sent && !complete && !cancellation.IsCancellationRequested()) {
+            chunk.Clear();
+            onChunk(chunk, true, true);
+        }
+        return ran;
+    }
+
+    DecoderStatus DecoderJobs::ReadDatabase(DecoderPool& pool, const DecoderFile& file,
+                                            const CancellationToken& cancellation, const DatabaseSchemaCallback& onSchema,
+                                            const DatabaseTableCallback& onTable) {
+        std::string arguments = ToUtf8(file.path);
+        DecoderJob job = FileJob(WorkerJobKind::DatabasePreview, file, arguments, PARSE_TIMEOUT);
+
+        bool schemaSent = false;
+        uint64_t tableCount = 0;
+        uint64_t tablesSent = 0;
+        bool malformed = false;
+        SqliteSchema schema;
+        SqliteRows rows;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (reply.final) {
+                return true;
+            }
+            if (!schemaSent) {
+                if (reply.values[0] > DATABASE_MAX_TABLES || !DecodeSchema(reply.output, schema)) {
+                    malformed = true;
+                    return false;
+                }
+                schemaSent = true;
+                tableCount = reply.values[0];
+                return onSchema(schema, static_cast<size_t>(tableCount));
+            }
+            if (tablesSent == tableCount || !DecodeRows(reply.output, rows)) {
+                malformed = true;
+                return false;
+            }
+            ++tablesSent;
+            return onTable(&rows, tablesSent == tableCount);
+        });
+        if (malformed) {
+            ReportMalformed(L"database preview", file);
+            ran = DecoderStatus::Crashed;
+        }
+
+        if (ran != DecoderStatus::Ok && schemaSent && tablesSent < tableCount &&
+            !cancellation.IsCancellationRequested()) {
+            onTable(nullptr, true);
+        }
+        return ran;
+    }
+
+    DecoderStatus DecoderJobs::DrawFont(DecoderPool& pool, const DecoderFile& file, const SharedMemory& surface,
+                                        const CancellationToken& cancellation, FontSummary& out) {
+        // Path, and the surface to draw into after a NUL
+        std::string arguments = ToUtf8(file.path);
+        if (surface.IsOpen()) {
+            arguments.push_back('\0');
+            arguments.append(surface.Name());
+        }
+        DecoderJob job = FileJob(WorkerJobKind::FontPreview, file, arguments, PARSE_TIMEOUT);
+        job.values[2] = surface.Size();
+
+        out = FontSummary();
+        bool malformed = false;
+        DecoderStatus ran = pool.Run(job, cancellation, [&](const DecoderReply& reply) {
+            if (!reply.final || reply.code != 0) {
+                return reply.final;
+            }
+            // A specimen taller than the surface would send the UI past its end
+            FontSummary font;
+            malformed = !DecodeFont(reply.output, font) ||
+                        static_cast<uint64_t>(font.height) * FontSpecimen::WIDTH * 4 > surface.Size();
+            if (!malformed) {
+                out = std::move(font);
+            }
+            return true;
+        });
+        if (malformed) {
+            ReportMalformed(L"font summary", file);
+            return DecoderStatus::Crashed;
+        }
+        return ran;
+    }
+
+    void DecoderJobs::StreamMarkdown(MarkdownParser& parser, std::string_view text, bool tooLarge,
+                                     const CancellationToken& cancellation, MarkdownDocument& chunk,
+                                     const MarkdownChunkCallback& onChunk) {
+        parser.Reset(text);
+        chunk.Clear();
+        parser.Parse(chunk, MARKDOWN_FIRST_BLOCKS);
+        if (!onChunk(chunk, parser.Done(), parser.Done() && tooLarge)) {
+            return;
+        }
+
+        while (!parser.Done()) {
+            if (cancellation.IsCancellationRequested()) {
+                return;
+            }
+
+            chunk.Clear();
+            size_t budget = MARKDOWN_MAX_BLOCKS - static_cast<size_t>(parser.BlocksEmitted());
+            parser.Parse(chunk, budget < MARKDOWN_CHUNK_BLOCKS ? budget : MARKDOWN_CHUNK_BLOCKS);
+
+            bool truncated = (!parser.Done() && parser.BlocksEmitted() >= MARKDOWN_MAX_BLOCKS) ||
+                             (parser.Done() && tooLarge);
+            if (!onChunk(chunk, parser.Done() || truncated, truncated) || truncated) {
+                return;
+            }
+        }
+    }
+
+    void DecoderJobs::StreamDatabase(const SqliteFile& database, const CancellationToken& cancellation,
+                                     const DatabaseSchemaCallback& onSchema, const DatabaseTableCallback& onTable) {
+        SqliteSchema schema;
+        if (!database.ReadSchema(schema)) {
+            std::wcerr << L"SQLite schema is damaged; showing " << schema.objects.size() << L" objects" << std::endl;
+        }
+
+        std::vector<const SqliteObject*> tables;
+        for (const SqliteObject& object : schema.objects) {
+            if (object.type == "table" && object.rootPage != 0 && tables.size() < DATABASE_MAX_TABLES) {
+                tables.push_back(&object);
+            }
+        }
+        if (!onSchema(schema, tables.size())) {
+            return;
+        }
+
+        SqliteRows rows;
+        for (size_t i = 0; i < tables.size(); ++i) {
+            if (cancellation.IsCancellationRequested()) {
+                return;
+            }
+            if (!database.ReadRows(*tables[i], 0, DATABASE_PREVIEW_ROWS, rows)) {
+                std::wcerr << L"Table " << i << L" is damaged; showing " << rows.rowCount << L" rows" << std::endl;
+            }
+            if (!onTable(&rows, i + 1 == tables.size())) {
+                return;
+            }
+        }
+    }
+
+    bool DecoderJobs::DrawSpecimen(ByteView data, uint64_t fontKey, GlyphCache& glyphs, uint8_t* pixels,
+                                   size_t capacity, FontSummary& out) {
+        out = FontSummary();
+        OpenTypeFont font(data);
+        if (!font.IsValid()) {
+            return false;
+        }
+
+        out.valid = true;
+        out.names = font.Names();
+        out.format = font.OutlineFormat();
+        out.faceCount = font.FaceCount();
+        out.glyphCount = font.GlyphCount();
+        out.unitsPerEm = font.UnitsPerEm();
+        if (font.OutlineFormat() == FontOutlineFormat::None || !pixels) {
+            return true;
+        }
+
+        FontSpecimen specimen(font);
+        if (static_cast<size_t>(specimen.Stride()) * specimen.Height() > capacity) {
+            return true;
+        }
+        glyphs.Bind(font, fontKey);
+        specimen.Render(glyphs, pixels);
+        out.height = specimen.Height();
+        return true;
+    }
+
+    uint64_t DecoderJobs::FontKey(const DecoderFile& file) {
+        if (file.modifiedTime == 0) {
+            return 0;
+        }
+        uint64_t key = std::hash<std::wstring_view>()(file.path) ^ (file.size * 0x9E3779B97F4A7C15ull) ^
+                       file.modifiedTime;
+        return key != 0 ? key : 1;
+    }
+
+    bool DecoderJobs::IsProviderRows(std::string_view rowsJson, uint32_t rowCount) {
+        size_t i = 0;
+        if (!SkipLiteral(rowsJson, i, "[")) {
+            return false;
+        }
+        for (uint32_t row = 0; row < rowCount; ++row) {
+            if ((row > 0 && !SkipLiteral(rowsJson, i, ",")) || !SkipLiteral(rowsJson, i, "{\"name\":") ||
+                !SkipJsonString(rowsJson, i) || !SkipLiteral(rowsJson, i, ",\"value\":") ||
+                !SkipJsonString(rowsJson, i) || !SkipLiteral(rowsJson, i, "}")) {
+                return false;
+            }
+        }
+        return SkipLiteral(rowsJson, i, "]") && i == rowsJson.size();
+    }
+
+    std::string DecoderJobs::EncodeProviderArguments(std::wstring_view library, std::wstring_view path,
+                                                     std::wstring_view extension) {
+        std::string arguments = ToUtf8(library);
+        arguments.push_back('\0');
+        arguments.append(ToUtf8(path));
+        arguments.push_back('\0');
+        arguments.append(ToUtf8(extension));
+        return arguments;
+    }
+
+    bool DecoderJobs::DecodeProviderArguments(std::string_view arguments, ProviderArguments& out) {
+        size_t first = arguments.find('\0');
+        size_t second = first == std::string_view::npos ? first : arguments.find('\0', first + 1);
+        if (second == std::string_view::npos || arguments.find('\0', second + 1) != std::string_view::npos) {
+            return false;
+        }
+        out.library = arguments.substr(0, first);
+        out.path = arguments.substr(first + 1, second - first - 1);
+        out.extension = arguments.substr(second + 1);
+        return !out.library.empty() && !out.path.empty();
+    }
+
+    size_t DecoderJobs::EncodeMarkdown(const MarkdownDocument& document, size_t& nextBlock, uint8_t* out,
+                                       size_t capacity) {
+        SectionWriter writer(out, capacity);
+        writer.Put(static_cast<uint32_t>(0));  // Blocks, once known
+        uint32_t count = 0;
+        while (nextBlock < document.blocks.size() && count < MARKDOWN_CHUNK_BLOCKS) {
+            size_t before = writer.Size();
+            EncodeMarkdownBlock(document, document.blocks[nextBlock], writer);
+            if (writer.Full()) {
+                writer.Rewind(before);
+                break;
+            }
+            ++nextBlock;
+            ++count;
+        }
+        writer.Patch(0, count);
+        return writer.Size();
+    }
+
+    bool DecoderJobs::DecodeMarkdown(ByteView encoded, MarkdownDocument& out) {
+        SectionReader reader(encoded);
+        uint32_t count = 0;
+        if (!reader.Get(count) || count > MARKDOWN_CHUNK_BLOCKS || !reader.Holds(count, MIN_MARKDOWN_BLOCK_BYTES)) {
+            return false;
+        }
+        for (uint32_t b = 0; b < count; ++b) {
+            if (!DecodeMarkdownBlock(reader, out)) {
+                return false;
+            }
+        }
+        return reader.AtEnd();
+    }
+
+    size_t DecoderJobs::EncodeSchema(const SqliteSchema& schema, uint8_t* out, size_t capacity) {
+        SectionWriter writer(out, capacity);
+        const SqliteHeader& header = schema.header;
+        writer.Put(header.pageSize);
+        writer.Put(header.usableSize);
+        writer.Put(header.pageCount);
+        writer.Put(header.freelistPages);
+        writer.Put(header.schemaCookie);
+        writer.Put(header.schemaFormat);
+        writer.Put(header.userVersion);
+        writer.Put(header.applicationId);
+        writer.Put(header.sqliteVersion);
+        writer.Put(static_cast<uint32_t>(header.encoding));
+        writer.Put(static_cast<uint8_t>(header.walMode));
+        writer.Put(static_cast<uint8_t>(header.autoVacuum));
+
+        // Objects past the section (megabytes of SQL) are left out
+        size_t countOffset = writer.Size();
+        writer.Put(static_cast<uint32_t>(0));
+        uint32_t count = 0;
+        for (const SqliteObject& object : schema.objects) {
+            size_t before = writer.Size();
+            writer.PutString(object.type);
+            writer.PutString(object.name);
+            writer.PutString(object.tableName);
+            writer.Put(object.rootPage);
+            writer.PutString(object.sql);
+            if (writer.Full()) {
+                writer.Rewind(before);
+                break;
+            }
+            ++count;
+        }
+        writer.Patch(countOffset, count);
+        return writer.Size();
+    }
+
+    bool DecoderJobs::DecodeSchema(ByteView encoded, SqliteSchema& out) {
+        SectionReader reader(encoded);
+        SqliteHeader& header = out.header;
+        uint32_t encoding = 0;
+        uint32_t count = 0;
+        if (!reader.Get(header.pageSize) || !reader.Get(header.usableSize) || !reader.Get(header.pageCount) ||
+            !reader.Get(header.freelistPages) || !reader.Get(header.schemaCookie) ||
+            !reader.Get(header.schemaFormat) || !reader.Get(header.userVersion) ||
+            !reader.Get(header.applicationId) || !reader.Get(header.sqliteVersion) || !reader.Get(encoding) ||
+            encoding < static_cast<uint32_t>(SqliteTextEncoding::Utf8) ||
+            encoding > static_cast<uint32_t>(SqliteTextEncoding::Utf16be) || !reader.GetFlag(header.walMode) ||
+            !reader.GetFlag(header.autoVacuum) || !reader.Get(count) || count > SqliteFile::MAX_SCHEMA_OBJECTS ||
+            !reader.Holds(count, MIN_SCHEMA_OBJECT_BYTES)) {
+            return false;
+        }
+        header.encoding = static_cast<SqliteTextEncoding>(encoding);
+
+        out.objects.resize(count);
+        for (SqliteObject& object : out.objects) {
+            if (!reader.GetString(object.type) || !reader.GetString(object.name) ||
+                !reader.GetString(object.tableName) || !reader.Get(object.rootPage) || !reader.GetString(object.sql)) {
+                return false;
+            }
+        }
+        return reader.AtEnd();
+    }
+
+    size_t DecoderJobs::EncodeRows(const SqliteRows& rows, uint8_t* out, size_t capacity) {
+        SectionWriter writer(out, capacity);
+        writer.PutString(rows.table);
+        writer.Put(rows.firstRow);
+        writer.Put(static_cast<uint32_t>(rows.columns.size()));
+        for (const std::string& column : rows.columns) {
+            writer.PutString(column);
+        }
+
+        // Rows that do not fit are left for the table's "more"
+        size_t countOffset = writer.Size();
+        writer.Put(static_cast<uint32_t>(0));
+        writer.Put(static_cast<uint8_t>(rows.more));
+        size_t columns = rows.columns.size();
+        uint32_t count = 0;
+        for (size_t r = 0; r < rows.rowCount; ++r) {
+            size_t before = writer.Size();
+            for (size_t c = 0; c < columns; ++c) {
+                EncodeValue(rows.values[r * columns + c], writer);
+            }
+            if (writer.Full()) {
+                writer.Rewind(before);
+                break;
+            }
+            ++count;
+        }
+        writer.Patch(countOffset, count);
+        writer.Patch(countOffset + sizeof(count), static_cast<uint8_t>(rows.more || count < rows.rowCount));
+        return writer.Size();
+    }
+
+    bool DecoderJobs::DecodeRows(ByteView encoded, SqliteRows& out) {
+        SectionReader reader(encoded);
+        uint32_t columns = 0;
+        uint32_t count = 0;
+        if (!reader.GetString(out.table) || !reader.Get(out.firstRow) || !reader.Get(columns) ||
+            !reader.Holds(columns, MIN_COLUMN_BYTES)) {
+            return false;
+        }
+        out.columns.resize(columns);
+        for (std::string& column : out.columns) {
+            if (!reader.GetString(column)) {
+                return false;
+            }
+        }
+
+        if (!reader.Get(count) || count > DATABASE_PREVIEW_ROWS || !reader.GetFlag(out.more) ||
+            !reader.Holds(static_cast<uint64_t>(count) * columns, MIN_VALUE_BYTES)) {
+            return false;
+        }
+        out.rowCount = count;
+        out.values.resize(static_cast<size_t>(count) * columns);
+        for (SqliteValue& value : out.values) {
+            if (!DecodeValue(reader, value)) {
+                return false;
+            }
+        }
+        return reader.AtEnd();
+    }
+
+    size_t DecoderJobs::EncodeFont(const FontSummary& font, uint8_t* out, size_t capacity) {
+        SectionWriter writer(out, capacity);
+        writer.Put(static_cast<uint8_t>(font.valid));
+        writer.PutString(font.names.family);
+        writer.PutString(font.names.subfamily);
+        writer.PutString(font.names.fullName);
+        writer.PutString(font.names.version);
+        writer.Put(static_cast<uint8_t>(font.format));
+        writer.Put(font.faceCount);
+        writer.Put(font.glyphCount);
+        writer.Put(font.unitsPerEm);
+        writer.Put(font.height);
+        return writer.Size();
+    }
+
+    bool DecoderJobs::DecodeFont(ByteView encoded, FontSummary& out) {
+        SectionReader reader(encoded);
+        uint8_t format = 0;
+        if (!reader.GetFlag(out.valid) || !reader.GetString(out.names.family) ||
+            !reader.GetString(out.names.subfamily) || !reader.GetString(out.names.fullName) ||
+            !reader.GetString(out.names.version) || !reader.Get(format) ||
+            format > static_cast<uint8_t>(FontOutlineFormat::Cff) || !reader.Get(out.faceCount) ||
+            !reader.Get(out.glyphCount) || !reader.Get(out.unitsPerEm) || !reader.Get(out.height) ||
+            out.height > FontSpecimen::MAX_HEIGHT) {
+            return false;
+        }
+        out.format = static_cast<FontOutlineFormat>(format);
+        return reader.AtEnd();
+    }
+}
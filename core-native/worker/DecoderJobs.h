@@ -0,0 +1,182 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "DecoderPool.h"
+#include "../common/ByteView.h"
+#include "../common/CancellationToken.h"
+#include "../engines/font/OpenTypeFont.h"
+#include "../engines/image/EmbeddedPreview.h"
+#include "../engines/image/ImageHeaderProbe.h"
+#include "../plugins/ProviderSession.h"
+
+namespace Lumos {
+    struct NativeProvider;
+    struct MarkdownDocument;
+    class MarkdownParser;
+    class SqliteFile;
+    struct SqliteSchema;
+    struct SqliteRows;
+    class GlyphCache;
+    class SharedMemory;
+
+    // The file a decoder job reads, as the pipeline resolved it
+    struct DecoderFile {
+        std::wstring_view path;
+        std::wstring_view extension;
+        uint64_t size = 0;
+        uint64_t modifiedTime = 0;  // 0 if unknown; the worker then maps it afresh
+    };
+
+    // A chunk of Markdown blocks, continuing where the last one ended. False stops the parse.
+    using MarkdownChunkCallback = std::function<bool(const MarkdownDocument& chunk, bool complete, bool truncated)>;
+
+    // A database's schema with the number of tables whose rows follow, then
+    // each of those tables' rows (null if they could not be read). False
+    // stops the read.
+    using DatabaseSchemaCallback = std::function<bool(const SqliteSchema& schema, size_t tableCount)>;
+    using DatabaseTableCallback = std::function<bool(const SqliteRows* rows, bool last)>;
+
+    // What a font preview shows next to its specimen
+    struct FontSummary {
+        bool valid = false;  // An OpenType font at all
+        FontNames names;
+        FontOutlineFormat format = FontOutlineFormat::None;
+        uint32_t faceCount = 1;
+        uint32_t glyphCount = 0;
+        uint32_t unitsPerEm = 0;
+        uint32_t height = 0;  // Of the specimen drawn (FontSpecimen::WIDTH wide); 0 if none was
+    };
+
+    // Pool side of the built-in job kinds, the encodings DecoderWorker
+    // shares with it, and the preview loops both run. Whatever a worker
+    // sends back is checked here before the pipeline sees it: structures
+    // are rebuilt field by field and re-encoded on this side, so a worker
+    // compromised by the file it parsed can corrupt that file's preview
+    // and nothing else.
+    class DecoderJobs {
+    public:
+        static constexpr auto PROBE_TIMEOUT = std::chrono::milliseconds(1000);
+        static constexpr auto PROVIDER_TIMEOUT = std::chrono::milliseconds(10000);  // Between batches
+        static constexpr auto PARSE_TIMEOUT = std::chrono::milliseconds(5000);      // Between chunks
+
+        // Enough blocks to fill the window travel with the request; the rest
+        // follow in larger chunks so the first paint never waits on the tail
+        static constexpr size_t MARKDOWN_FIRST_BLOCKS = 48;
+        static constexpr size_t MARKDOWN_CHUNK_BLOCKS = 512;
+        static constexpr size_t MARKDOWN_MAX_BLOCKS = 10000;
+        static constexpr uint64_t MARKDOWN_MAX_BYTES = 16ull * 1024 * 1024;
+
+        // Rows per table and tables with rows; the schema lists everything
+        static constexpr size_t DATABASE_PREVIEW_ROWS = 200;
+        static constexpr size_t DATABASE_MAX_TABLES = 64;
+
+        // ImageHeaderProbe::Probe in a worker. When the pool has no worker to
+        // offer it probes in-process, as before the pool existed; a worker
+        // lost to the header reports it Malformed.
+        static ProbeStatus ProbeImage(DecoderPool& pool, ByteView head, uint64_t affinity,
+                                      const CancellationToken& cancellation, ImageHeader& out);
+
+        // Run `provider` over `file` in a worker, passing its batches on to
+        // `onBatch`. UNSUPPORTED means nothing was shown and the caller
+        // should fall back to a plain preview: the provider declined, or its
+        // worker was lost (or never found) before the first batch. A worker
+        // lost after that closes the preview as FAILED.
+        static LumosPreviewResult RunProvider(DecoderPool& pool, const NativeProvider& provider, const DecoderFile& file,
+                                              const CancellationToken& cancellation, const ProviderBatchCallback& onBatch,
+                                              size_t& rowCount, size_t& batchCount);
+
+        // The jobs below read `file` in a worker. Unavailable means the pool
+        // has no worker to offer and the caller should run the same parser
+        // in-process; any other status means the worker's answer, or the
+        // lack of one, is final.
+
+        // EmbeddedPreviewFinder::Find. `out.length` is 0 if there is none,
+        // or the worker was lost looking.
+        static DecoderStatus FindEmbeddedPreview(DecoderPool& pool, const DecoderFile& file, uint32_t targetEdge,
+                                                 uint32_t minimumEdge, const CancellationToken& cancellation,
+                                                 EmbeddedPreview& out);
+
+        // StreamMarkdown over the file's first MARKDOWN_MAX_BYTES, each chunk
+        // rebuilt into `chunk`. A worker lost part-way closes the preview
+        // with an empty, truncated chunk.
+        static DecoderStatus ParseMarkdown(DecoderPool& pool, const DecoderFile& file,
+                                           const CancellationToken& cancellation, MarkdownDocument& chunk,
+                                           const MarkdownChunkCallback& onChunk);
+
+        // StreamDatabase. Nothing is called back for files that are not
+        // SQLite; a worker lost after the schema closes the preview with a
+        // last, empty table.
+        static DecoderStatus ReadDatabase(DecoderPool& pool, const DecoderFile& file,
+                                          const CancellationToken& cancellation, const DatabaseSchemaCallback& onSchema,
+                                          const DatabaseTableCallback& onTable);
+
+        // DrawFont, with the specimen drawn into `surface` (a section this
+        // process created, FontSpecimen::MAX_BYTES long; closed: no specimen)
+        static DecoderStatus DrawFont(DecoderPool& pool, const DecoderFile& file, const SharedMemory& surface,
+                                      const CancellationToken& cancellation, FontSummary& out);
+
+        // The preview loops, shared by the workers and the in-process
+        // fallback. StreamMarkdown sends the first MARKDOWN_FIRST_BLOCKS,
+        // then MARKDOWN_CHUNK_BLOCKS at a time up to MARKDOWN_MAX_BLOCKS;
+        // `tooLarge` marks the text as cut short, so its last chunk is
+        // truncated. StreamDatabase sends the schema and then the first
+        // DATABASE_PREVIEW_ROWS of up to DATABASE_MAX_TABLES tables.
+        // DrawSpecimen draws into `pixels` (nothing if null or too small for
+        // the specimen); false if `data` is not a font.
+        static void StreamMarkdown(MarkdownParser& parser, std::string_view text, bool tooLarge,
+                                   const CancellationToken& cancellation, MarkdownDocument& chunk,
+                                   const MarkdownChunkCallback& onChunk);
+        static void StreamDatabase(const SqliteFile& database, const CancellationToken& cancellation,
+                                   const DatabaseSchemaCallback& onSchema, const DatabaseTableCallback& onTable);
+        static bool DrawSpecimen(ByteView data, uint64_t fontKey, GlyphCache& glyphs, uint8_t* pixels,
+                                 size_t capacity, FontSummary& out);
+
+        // Names the file version glyphs were cached from; 0 (never reused)
+        // without a modification time
+        static uint64_t FontKey(const DecoderFile& file);
+
+        // ProviderPreview arguments: library, path and extension as
+        // NUL-separated UTF-8. Values: size, modified time, MapAccess.
+        struct ProviderArguments {
+            std::string_view library;
+            std::string_view path;
+            std::string_view extension;
+        };
+
+        static std::string EncodeProviderArguments(std::wstring_view library, std::wstring_view path,
+                                                   std::wstring_view extension);
+        static bool DecodeProviderArguments(std::string_view arguments, ProviderArguments& out);
+
+        // A batch's rows exactly as ProviderSession writes them: `rowCount`
+        // {"name","value"} objects of well-formed strings, nothing else
+        static bool IsProviderRows(std::string_view rowsJson, uint32_t rowCount);
+
+        // ProviderPreview Partial values: first row, row count, BATCH_* flags.
+        // Done values: rows, batches. MarkdownPreview Partials carry the
+        // flags alone.
+        static constexpr uint64_t BATCH_COMPLETE = 0x1;
+        static constexpr uint64_t BATCH_FAILED = 0x2;
+        static constexpr uint64_t BATCH_TRUNCATED = 0x4;
+
+        // Worker output of the parse jobs, written into a section of
+        // `capacity` bytes. Encode* return the bytes written; the Markdown
+        // and row encoders stop at the first block or row that does not
+        // fit, EncodeMarkdown moving `nextBlock` past those written and
+        // EncodeRows marking the rows as having more. Decode* check every
+        // field and reject anything DecoderWorker would not have written.
+        static size_t EncodeMarkdown(const MarkdownDocument& document, size_t& nextBlock, uint8_t* out,
+                                     size_t capacity);
+        static bool DecodeMarkdown(ByteView encoded, MarkdownDocument& out);
+
+        static size_t EncodeSchema(const SqliteSchema& schema, uint8_t* out, size_t capacity);
+        static bool DecodeSchema(ByteView encoded, SqliteSchema& out);
+        static size_t EncodeRows(const SqliteRows& rows, uint8_t* out, size_t capacity);
+        static bool DecodeRows(ByteView encoded, SqliteRows& out);
+
+        static size_t EncodeFont(const FontSummary& font, uint8_t* out, size_t capacity);
+        static bool DecodeFont(ByteView encoded, FontSummary& out);
+    };
+}
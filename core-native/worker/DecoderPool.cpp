@@ -0,0 +1,354 @@
+#include "DecoderPool.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "WorkerProcess.h"
+#include "../common/PerfectHash.h"
+#include "../metrics/Metrics.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    DecoderPool::DecoderPool(size_t workerCount, std::wstring executable)
+        : m_executable(std::move(executable))
+        , m_stopping(false)
+        , m_launchFailures(0)
+        , m_nextJobId(0)
+        , m_jobs(0)
+        , m_crashes(0)
+        , m_timeouts(0)
+        , m_launches(0)
+        , m_spilled(0)
+    {
+        static std::atomic<uint64_t> nextSection{ 0 };
+        workerCount = std::min(workerCount, MAX_WORKERS);
+        for (size_t i = 0; i < workerCount; ++i) {
+            auto slot = std::make_unique<Slot>();
+            slot->index = i;
+            slot->seed = PerfectHash::Mix(0x9E3779B97F4A7C15ull * (i + 1));
+            slot->busy = false;
+            if (!slot->section.Create(SharedMemory::UniqueName("LumosDecoder", nextSection++),
+                                      WorkerProtocol::SECTION_BYTES)) {
+                std::wcerr << L"Decoder worker " << i << L": cannot create its shared-memory section" << std::endl;
+                continue;
+            }
+            m_slots.push_back(std::move(slot));
+        }
+    }
+
+    DecoderPool::~DecoderPool() {
+        Stop();
+    }
+
+    void DecoderPool::Start() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_thread.joinable() || m_slots.empty()) {
+            return;
+        }
+        m_stopping = false;
+        m_thread = std::thread(&DecoderPool::SuperviseLoop, this);
+    }
+
+    void DecoderPool::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_available.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        for (auto& slot : m_slots) {
+            slot->process.reset();
+        }
+    }
+
+    DecoderStatus DecoderPool::Run(const DecoderJob& job, const CancellationToken& cancellation,
+                                   const DecoderReplyCallback& onReply) {
+        if (job.arguments.size() > WorkerProtocol::MAX_ARGUMENT_BYTES ||
+            job.input.Size() > WorkerProtocol::SECTION_BYTES - WorkerProtocol::DATA_OFFSET) {
+            std::wcerr << L"Decoder job of kind " << static_cast<int>(job.kind) << L" is too large to send" << std::endl;
+            return DecoderStatus::Unavailable;
+        }
+
+        while (Slot* slot = Acquire(job.affinity)) {
+            if (!slot->process->IsAlive()) {
+                // Died while idle: nothing of this job's doing, so run it on
+                // another worker while this one is replaced
+                std::wcerr << L"Decoder worker " << slot->index << L" (PID " << slot->process->Pid() << L") died while idle: "
+                           << slot->process->ExitReason() << std::endl;
+                Release(*slot, false);
+                continue;
+            }
+            m_jobs.fetch_add(1, std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            DecoderStatus status = Exchange(*slot, job, cancellation, onReply);
+            if (status == DecoderStatus::Ok) {
+                Metrics::Record(Histogram::DecoderJob, std::chrono::steady_clock::now() - start);
+            } else if (status == DecoderStatus::Crashed) {
+                m_crashes.fetch_add(1, std::memory_order_relaxed);
+            } else if (status == DecoderStatus::TimedOut) {
+                m_timeouts.fetch_add(1, std::memory_order_relaxed);
+            }
+            Release(*slot, status == DecoderStatus::Ok);
+            return status;
+        }
+        return DecoderStatus::Unavailable;
+    }
+
+    DecoderPool::Stats DecoderPool::GetStats() const {
+        Stats stats;
+        stats.jobs = m_jobs.load(std::memory_order_relaxed);
+        stats.crashes = m_crashes.load(std::memory_order_relaxed);
+        stats.timeouts = m_timeouts.load(std::memory_order_relaxed);
+        stats.launches = m_launches.load(std::memory_order_relaxed);
+        stats.spilled = m_spilled.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    size_t DecoderPool::DefaultWorkerCount() {
+        size_t cores = std::thread::hardware_concurrency();
+        return std::clamp<size_t>(cores > 1 ? cores - 1 : 1, 1, MAX_DEFAULT_WORKERS);
+    }
+
+    std::wstring DecoderPool::DefaultExecutable() {
+#ifdef _WIN32
+        wchar_t exePath[MAX_PATH];
+        DWORD length = GetModuleFileName(nullptr, exePath, MAX_PATH);
+        return std::wstring(exePath, length);
+#else
+        char exePath[4096];
+        ssize_t length = readlink("/proc/self/exe", exePath, sizeof(exePath));
+        return length > 0 ? std::wstring(exePath, exePath + length) : std::wstring();
+#endif
+    }
+
+    void DecoderPool::SuperviseLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopping) {
+            Slot* down = nullptr;
+            for (auto& slot : m_slots) {
+                if (!slot->process && !slot->busy) {
+                    down = slot.get();
+                    break;
+                }
+            }
+            bool backingOff = m_launchFailures >= MAX_LAUNCH_FAILURES && std::chrono::steady_clock::now() < m_retryAt;
+            if (!down || backingOff) {
+                m_wake.wait_for(lock, SUPERVISE_INTERVAL);
+                continue;
+            }
+
+            down->busy = true;
+            lock.unlock();
+            std::unique_ptr<WorkerProcess> process = LaunchWorker(*down);
+            lock.lock();
+            down->busy = false;
+
+            if (process) {
+                down->process = std::move(process);
+                m_launchFailures = 0;
+                m_launches.fetch_add(1, std::memory_order_relaxed);
+            } else if (++m_launchFailures == MAX_LAUNCH_FAILURES) {
+                m_retryAt = std::chrono::steady_clock::now() + LAUNCH_BACKOFF;
+                std::wcerr << L"Decoder workers fail to start; untrusted formats are not previewed until they do"
+                           << std::endl;
+            }
+            m_available.notify_all();
+        }
+    }
+
+    std::unique_ptr<WorkerProcess> DecoderPool::LaunchWorker(Slot& slot) {
+        std::wstring error;
+        auto process = WorkerProcess::Launch(m_executable, slot.section.Name(), slot.section.Size(), error);
+        if (!process) {
+            std::wcerr << L"Decoder worker " << slot.index << L" failed to launch: " << error << std::endl;
+            return nullptr;
+        }
+
+        // The Hello proves the worker mapped its section and speaks our protocol
+        WorkerFrame hello = {};
+        auto deadline = WorkerProcess::Clock::now() + LAUNCH_TIMEOUT;
+        if (process->Read(&hello, sizeof(hello), deadline) != ChannelStatus::Ok ||
+            hello.magic != WorkerProtocol::FRAME_MAGIC ||
+            hello.type != static_cast<uint16_t>(WorkerFrameType::Hello) ||
+            hello.code != WorkerProtocol::PROTOCOL_VERSION) {
+            process->Kill();
+            std::wcerr << L"Decoder worker " << slot.index << L" (PID " << process->Pid() << L") did not start: "
+                       << process->ExitReason() << std::endl;
+            return nullptr;
+        }
+        return process;
+    }
+
+    DecoderPool::Slot* DecoderPool::Acquire(uint64_t affinity) {
+        if (m_slots.empty()) {
+            return nullptr;  // Disabled
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto deadline = std::chrono::steady_clock::now() + ACQUIRE_TIMEOUT;
+        while (!m_stopping) {
+            // Highest score wins: the first choice among the workers that are
+            // up, and the best of those that are free
+            Slot* first = nullptr;
+            Slot* best = nullptr;
+            uint64_t firstScore = 0;
+            uint64_t bestScore = 0;
+            bool anyUp = false;
+            for (auto& slot : m_slots) {
+                if (!slot->process) {
+                    continue;
+                }
+                anyUp = true;
+                uint64_t score = PerfectHash::Mix(affinity ^ slot->seed);
+                if (!first || score > firstScore) {
+                    first = slot.get();
+                    firstScore = score;
+                }
+                if (!slot->busy && (!best || score > bestScore)) {
+                    best = slot.get();
+                    bestScore = score;
+                }
+            }
+            if (best) {
+                best->busy = true;
+                if (best != first) {
+                    m_spilled.fetch_add(1, std::memory_order_relaxed);
+                }
+                return best;
+            }
+            if (!anyUp && m_launchFailures >= MAX_LAUNCH_FAILURES) {
+                return nullptr;
+            }
+            if (m_available.wait_until(lock, deadline) == std::cv_status::timeout) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    void DecoderPool::Release(Slot& slot, bool healthy) {
+        if (!healthy) {
+            // Killed outside the lock: reaping can take a moment
+            slot.process->Kill();
+        }
+        std::unique_ptr<WorkerProcess> dead;
+        {
+            // Acquire and the supervisor read every slot's process under the
+            // lock, busy or not
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!healthy) {
+                dead = std::move(slot.process);
+            }
+            slot.busy = false;
+        }
+        if (dead) {
+            m_wake.notify_all();
+        } else {
+            m_available.notify_all();
+        }
+    }
+
+    DecoderStatus DecoderPool::Exchange(Slot& slot, const DecoderJob& job, const CancellationToken& cancellation,
+                                        const DecoderReplyCallback& onReply) {
+        using Clock = WorkerProcess::Clock;
+        WorkerProcess& process = *slot.process;
+        auto* header = reinterpret_cast<WorkerSectionHeader*>(slot.section.Data());
+        uint8_t* data = slot.section.Data() + WorkerProtocol::DATA_OFFSET;
+        size_t capacity = slot.section.Size() - WorkerProtocol::DATA_OFFSET;
+
+        header->cancelled.store(false, std::memory_order_relaxed);
+        if (!job.input.Empty()) {
+            std::memcpy(data, job.input.Data(), job.input.Size());
+        }
+
+        WorkerFrame frame = {};
+        frame.magic = WorkerProtocol::FRAME_MAGIC;
+        frame.type = static_cast<uint16_t>(WorkerFrameType::Job);
+        frame.code = static_cast<uint16_t>(job.kind);
+        frame.jobId = ++m_nextJobId;
+        frame.argumentBytes = static_cast<uint32_t>(job.arguments.size());
+        frame.sectionBytes = static_cast<uint32_t>(job.input.Size());
+        std::memcpy(frame.values, job.values, sizeof(frame.values));
+
+        // Writing the frame is a system call, which orders the input before it
+        auto ioDeadline = Clock::now() + IO_TIMEOUT;
+        if (process.Write(&frame, sizeof(frame), ioDeadline) != ChannelStatus::Ok ||
+            process.Write(job.arguments.data(), job.arguments.size(), ioDeadline) != ChannelStatus::Ok) {
+            std::wcerr << L"Decoder worker " << slot.index << L" stopped taking jobs: " << process.ExitReason() << std::endl;
+            return DecoderStatus::Crashed;
+        }
+
+        bool flagged = false;
+        auto quietDeadline = Clock::now() + job.timeout;
+        while (true) {
+            // Wait in short steps only while there is a cancellation to pass on
+            ChannelStatus status;
+            while (true) {
+                auto now = Clock::now();
+                if (!flagged && cancellation.IsCancellationRequested()) {
+                    header->cancelled.store(true, std::memory_order_release);
+                    flagged = true;
+                    quietDeadline = std::min(quietDeadline, now + CANCEL_GRACE);
+                }
+                if (now >= quietDeadline) {
+                    std::wcerr << L"Decoder worker " << slot.index << L" (PID " << process.Pid() << L") gave no answer in "
+                               << (flagged ? CANCEL_GRACE : job.timeout).count() << L" ms; killing it" << std::endl;
+                    return DecoderStatus::TimedOut;
+                }
+                auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(quietDeadline - now) +
+                            std::chrono::milliseconds(1);
+                if (!flagged && cancellation.CanBeCancelled()) {
+                    wait = std::min<std::chrono::milliseconds>(wait, CANCEL_POLL);
+                }
+                status = process.WaitReadable(wait);
+                if (status != ChannelStatus::TimedOut) {
+                    break;
+                }
+            }
+
+            WorkerFrame reply = {};
+            if (status != ChannelStatus::Ok ||
+                process.Read(&reply, sizeof(reply), Clock::now() + IO_TIMEOUT) != ChannelStatus::Ok) {
+                process.Kill();
+                std::wcerr << L"Decoder worker " << slot.index << L" (PID " << process.Pid() << L") crashed: "
+                           << process.ExitReason() << std::endl;
+                return DecoderStatus::Crashed;
+            }
+            bool isPartial = reply.type == static_cast<uint16_t>(WorkerFrameType::Partial);
+            bool isDone = reply.type == static_cast<uint16_t>(WorkerFrameType::Done);
+            if (reply.magic != WorkerProtocol::FRAME_MAGIC || reply.jobId != frame.jobId || (!isPartial && !isDone) ||
+                reply.argumentBytes != 0 || reply.sectionBytes > capacity) {
+                std::wcerr << L"Decoder worker " << slot.index << L" broke the protocol; killing it" << std::endl;
+                return DecoderStatus::Crashed;
+            }
+
+            DecoderReply decoded;
+            decoded.final = isDone;
+            decoded.code = reply.code;
+            decoded.values = reply.values;
+            decoded.output = ByteView(data, reply.sectionBytes);
+            bool keepGoing = onReply ? onReply(decoded) : true;
+            if (isDone) {
+                return DecoderStatus::Ok;
+            }
+
+            WorkerFrame ack = {};
+            ack.magic = WorkerProtocol::FRAME_MAGIC;
+            ack.type = static_cast<uint16_t>(WorkerFrameType::Ack);
+            ack.code = keepGoing && !cancellation.IsCancellationRequested() ? 1 : 0;
+            ack.jobId = frame.jobId;
+            if (process.Write(&ack, sizeof(ack), Clock::now() + IO_TIMEOUT) != ChannelStatus::Ok) {
+                return DecoderStatus::Crashed;
+            }
+            if (!flagged) {
+                quietDeadline = Clock::now() + job.timeout;
+            }
+        }
+    }
+}
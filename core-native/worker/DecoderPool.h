@@ -0,0 +1,153 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "WorkerProtocol.h"
+#include "../common/ByteView.h"
+#include "../common/CancellationToken.h"
+#include "../ipc/SharedMemory.h"
+
+namespace Lumos {
+    class WorkerProcess;
+
+    enum class DecoderStatus {
+        Ok,           // The worker answered; the job's own result is in the final reply
+        Crashed,      // The worker died (or broke the protocol) during the job
+        TimedOut,     // It went quiet for longer than the job allows and was killed
+        Unavailable   // No worker to run it: the pool is disabled, stopping or down
+    };
+
+    struct DecoderJob {
+        WorkerJobKind kind = WorkerJobKind::TestEcho;
+        uint64_t affinity = 0;             // Jobs with the same key go to the same worker while it is free
+        std::string_view arguments;        // Sent on the channel; at most MAX_ARGUMENT_BYTES
+        ByteView input;                    // Copied into the worker's section
+        uint64_t values[4] = {};
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(2000);  // Silence allowed between replies
+    };
+
+    // A Partial or Done frame. `output` points into the worker's section and
+    // is only valid during the callback.
+    struct DecoderReply {
+        bool final;
+        uint16_t code;
+        const uint64_t* values;  // 4
+        ByteView output;
+    };
+
+    // For Partial replies, false stops the job
+    using DecoderReplyCallback = std::function<bool(const DecoderReply& reply)>;
+
+    // Supervised pool of decoder worker processes. Parsers for untrusted
+    // formats run there, so a malformed file can crash or hang a worker but
+    // never lumos.exe and its keyboard hook. Each worker maps a section of
+    // its own for bulk input and output and serves one job at a time.
+    //
+    // Run() blocks the calling thread for the job's duration and may be
+    // called from any thread. A worker that dies or overruns its job's
+    // timeout is killed and relaunched in the background; the job reports
+    // Crashed or TimedOut and is not retried, since the file that did it
+    // would do it again. A worker found dead while idle is replaced
+    // transparently and the job runs elsewhere.
+    //
+    // Jobs are routed by rendezvous hashing of their affinity key over the
+    // workers that are up, so the same file keeps reaching the same worker
+    // (and its mapped files and loaded providers) and relaunching one worker
+    // only moves that worker's keys. When the first choice is busy the job
+    // takes the next free worker in the same order.
+    class DecoderPool {
+    public:
+        struct Stats {
+            uint64_t jobs;
+            uint64_t crashes;
+            uint64_t timeouts;
+            uint64_t launches;
+            uint64_t spilled;   // Ran on a worker other than their first choice
+        };
+
+        // Run more than this many decodes at once and they are I/O- or
+        // UI-bound anyway
+        static constexpr size_t MAX_DEFAULT_WORKERS = 8;
+        static constexpr size_t MAX_WORKERS = 64;
+
+        // 0 disables the pool: every Run() is Unavailable
+        explicit DecoderPool(size_t workerCount = DefaultWorkerCount(), std::wstring executable = DefaultExecutable());
+        ~DecoderPool();
+
+        DecoderPool(const DecoderPool&) = delete;
+        DecoderPool& operator=(const DecoderPool&) = delete;
+
+        // Launch the workers in the background
+        void Start();
+
+        // Kill every worker. Run() calls still in flight must have returned.
+        void Stop();
+
+        DecoderStatus Run(const DecoderJob& job, const CancellationToken& cancellation,
+                          const DecoderReplyCallback& onReply);
+
+        size_t WorkerCount() const { return m_slots.size(); }
+        Stats GetStats() const;
+
+        // One per core, leaving one for the pipeline, up to MAX_DEFAULT_WORKERS
+        static size_t DefaultWorkerCount();
+
+        // This executable: workers are lumos.exe started with --decode-worker
+        static std::wstring DefaultExecutable();
+
+    private:
+        struct Slot {
+            size_t index;
+            uint64_t seed;                            // Rendezvous-hashing weight
+            SharedMemory section;
+            std::unique_ptr<WorkerProcess> process;   // Null while down
+            bool busy;                                // Running a job or being launched
+        };
+
+        static constexpr auto SUPERVISE_INTERVAL = std::chrono::milliseconds(500);
+        static constexpr auto LAUNCH_TIMEOUT = std::chrono::milliseconds(5000);
+        static constexpr auto ACQUIRE_TIMEOUT = std::chrono::milliseconds(2000);
+        static constexpr auto IO_TIMEOUT = std::chrono::milliseconds(1000);
+        static constexpr auto CANCEL_POLL = std::chrono::milliseconds(10);
+        static constexpr auto CANCEL_GRACE = std::chrono::milliseconds(250);  // To stop once cancelled
+
+        // Workers that keep failing to start (missing or broken executable)
+        // are retried after a pause instead of in a loop
+        static constexpr size_t MAX_LAUNCH_FAILURES = 3;
+        static constexpr auto LAUNCH_BACKOFF = std::chrono::seconds(30);
+
+        void SuperviseLoop();
+        std::unique_ptr<WorkerProcess> LaunchWorker(Slot& slot);
+
+        Slot* Acquire(uint64_t affinity);
+        void Release(Slot& slot, bool healthy);  // Unhealthy workers are killed and relaunched
+        DecoderStatus Exchange(Slot& slot, const DecoderJob& job, const CancellationToken& cancellation,
+                               const DecoderReplyCallback& onReply);
+
+        std::wstring m_executable;
+        std::vector<std::unique_ptr<Slot>> m_slots;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;       // Supervisor: a worker went down, or stopping
+        std::condition_variable m_available;  // Callers: a worker came free or up
+        std::thread m_thread;
+        bool m_stopping;
+        size_t m_launchFailures;
+        std::chrono::steady_clock::time_point m_retryAt;
+
+        std::atomic<uint64_t> m_nextJobId;
+        std::atomic<uint64_t> m_jobs;
+        std::atomic<uint64_t> m_crashes;
+        std::atomic<uint64_t> m_timeouts;
+        std::atomic<uint64_t> m_launches;
+        std::atomic<uint64_t> m_spilled;
+    };
+}
@@ -0,0 +1,405 @@
+#include "DecoderWorker.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "DecoderJobs.h"
+#include "WorkerProcess.h"
+#include "../common/Utf8.h"
+#include "../engines/font/FontSpecimen.h"
+#include "../engines/font/GlyphCache.h"
+#include "../engines/image/ImageHeaderProbe.h"
+#include "../engines/markdown/MarkdownParser.h"
+#include "../engines/sqlite/SqliteFile.h"
+#include "../plugins/ProviderLoader.h"
+#include "../plugins/ProviderRegistry.h"
+#include "../plugins/ProviderSession.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Lumos {
+    // A full provider batch plus one row of the worst case escaping (every
+    // byte a \u00XX control character) must fit the section
+    static_assert(ProviderSession::MAX_BATCH_BYTES +
+                      6 * (ProviderSession::MAX_NAME_BYTES + ProviderSession::MAX_VALUE_BYTES) + 64 <=
+                  WorkerProtocol::SECTION_BYTES - WorkerProtocol::DATA_OFFSET,
+                  "A provider batch must fit a worker's section");
+
+    DecoderWorker::DecoderWorker() = default;
+
+    DecoderWorker::~DecoderWorker() = default;
+
+    bool DecoderWorker::IsWorkerCommandLine(int argc, char* argv[]) {
+        return argc >= 2 && std::strcmp(argv[1], WorkerProtocol::COMMAND_LINE_SWITCH) == 0;
+    }
+
+    int DecoderWorker::Run(int argc, char* argv[]) {
+        if (argc != 5) {
+            std::wcerr << L"Usage: " << FromUtf8(WorkerProtocol::COMMAND_LINE_SWITCH)
+                       << L" <channel> <section> <section bytes>" << std::endl;
+            return 2;
+        }
+        m_endpoint = WorkerEndpoint::Connect(argv[2]);
+        size_t sectionSize = std::strtoull(argv[4], nullptr, 10);
+        if (!m_endpoint || sectionSize <= WorkerProtocol::DATA_OFFSET || !m_section.Open(argv[3], sectionSize)) {
+            std::wcerr << L"Decoder worker cannot reach its pool" << std::endl;
+            return 3;
+        }
+        auto* header = reinterpret_cast<WorkerSectionHeader*>(m_section.Data());
+        m_cancellation = CancellationToken::FromFlag(header->cancelled);
+
+        WorkerFrame hello = {};
+        hello.magic = WorkerProtocol::FRAME_MAGIC;
+        hello.type = static_cast<uint16_t>(WorkerFrameType::Hello);
+        hello.code = WorkerProtocol::PROTOCOL_VERSION;
+        if (!m_endpoint->Write(&hello, sizeof(hello))) {
+            return 0;
+        }
+
+        while (true) {
+            WorkerFrame frame;
+            if (!m_endpoint->Read(&frame, sizeof(frame))) {
+                return 0;  // The pool hung up
+            }
+            if (frame.magic != WorkerProtocol::FRAME_MAGIC || frame.type != static_cast<uint16_t>(WorkerFrameType::Job) ||
+                frame.argumentBytes > WorkerProtocol::MAX_ARGUMENT_BYTES || frame.sectionBytes > OutputCapacity()) {
+                std::wcerr << L"Decoder worker: malformed job frame" << std::endl;
+                return 4;
+            }
+            m_arguments.resize(frame.argumentBytes);
+            if (!m_endpoint->Read(m_arguments.data(), m_arguments.size())) {
+                return 0;
+            }
+
+            Job job;
+            job.id = frame.jobId;
+            job.kind = static_cast<WorkerJobKind>(frame.code);
+            job.arguments = m_arguments;
+            job.input = ByteView(Output(), frame.sectionBytes);
+            job.values = frame.values;
+            Result result = Handle(job);
+
+            WorkerFrame done = {};
+            done.magic = WorkerProtocol::FRAME_MAGIC;
+            done.type = static_cast<uint16_t>(WorkerFrameType::Done);
+            done.code = result.code;
+            done.jobId = job.id;
+            done.sectionBytes = static_cast<uint32_t>(std::min(result.outputBytes, OutputCapacity()));
+            std::memcpy(done.values, result.values, sizeof(done.values));
+            if (!m_endpoint->Write(&done, sizeof(done))) {
+                return 0;
+            }
+        }
+    }
+
+    DecoderWorker::Result DecoderWorker::Handle(const Job& job) {
+        switch (job.kind) {
+        case WorkerJobKind::ImageProbe:
+            return HandleImageProbe(job);
+        case WorkerJobKind::ProviderPreview:
+            return HandleProviderPreview(job);
+        case WorkerJobKind::EmbeddedPreview:
+            return HandleEmbeddedPreview(job);
+        case WorkerJobKind::MarkdownPreview:
+            return HandleMarkdownPreview(job);
+        case WorkerJobKind::DatabasePreview:
+            return HandleDatabasePreview(job);
+        case WorkerJobKind::FontPreview:
+            return HandleFontPreview(job);
+#ifdef LUMOS_FAULT_INJECTION
+        case WorkerJobKind::TestEcho:
+        case WorkerJobKind::TestSpin:
+        case WorkerJobKind::TestCrash:
+        case WorkerJobKind::TestHang:
+        case WorkerJobKind::TestExit:
+            return HandleTest(job);
+#endif
+        default:
+            break;
+        }
+        Result unknown;
+        unknown.code = WorkerProtocol::UNKNOWN_JOB;
+        return unknown;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleImageProbe(const Job& job) {
+        ImageHeader header;
+        Result result;
+        result.code = static_cast<uint16_t>(ImageHeaderProbe::Probe(job.input, header));
+        std::memcpy(Output(), &header, sizeof(header));
+        result.outputBytes = sizeof(header);
+        return result;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleProviderPreview(const Job& job) {
+        Result result;
+        result.code = LUMOS_PREVIEW_UNSUPPORTED;
+
+        DecoderJobs::ProviderArguments arguments;
+        if (!DecoderJobs::DecodeProviderArguments(job.arguments, arguments)) {
+            return result;
+        }
+        const NativeProvider* provider = LoadProvider(FromUtf8(arguments.library));
+        std::wstring path = FromUtf8(arguments.path);
+        MapAccess access = job.values[2] == static_cast<uint64_t>(MapAccess::Sequential) ? MapAccess::Sequential
+                                                                                           : MapAccess::Random;
+        const MappedFile* file = provider ? MapFile(path, job.values[0], job.values[1], access) : nullptr;
+        if (!file) {
+            return result;
+        }
+
+        ProviderSession session(*provider, m_cancellation, [&](const ProviderBatch& batch) {
+            if (batch.rowsJson.size() > OutputCapacity()) {
+                return false;
+            }
+            std::memcpy(Output(), batch.rowsJson.data(), batch.rowsJson.size());
+            uint64_t values[4] = {};
+            values[0] = batch.firstRow;
+            values[1] = batch.rowCount;
+            values[2] = (batch.complete ? DecoderJobs::BATCH_COMPLETE : 0) |
+                        (batch.failed ? DecoderJobs::BATCH_FAILED : 0) |
+                        (batch.truncated ? DecoderJobs::BATCH_TRUNCATED : 0);
+            return SendPartial(job, batch.rowsJson.size(), values);
+        });
+        result.code = static_cast<uint16_t>(session.Run(file->View(), path, FromUtf8(arguments.extension)));
+        result.values[0] = session.RowCount();
+        result.values[1] = session.BatchCount();
+        m_uncached.Close();
+        return result;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleEmbeddedPreview(const Job& job) {
+        // Only the IFD and segment pages are touched, never the image data
+        Result result;
+        const MappedFile* file = MapFile(FromUtf8(job.arguments), job.values[0], job.values[1], MapAccess::Random);
+        if (!file) {
+            result.code = WorkerProtocol::UNREADABLE_FILE;
+            return result;
+        }
+        auto preview = EmbeddedPreviewFinder::Find(file->View(), static_cast<uint32_t>(job.values[2]),
+                                                   static_cast<uint32_t>(job.values[3]));
+        if (preview) {
+            std::memcpy(Output(), &*preview, sizeof(*preview));
+            result.outputBytes = sizeof(*preview);
+        }
+        m_uncached.Close();
+        return result;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleMarkdownPreview(const Job& job) {
+        Result result;
+        const MappedFile* file = MapFile(FromUtf8(job.arguments), job.values[0], job.values[1], MapAccess::Sequential);
+        if (!file) {
+            result.code = WorkerProtocol::UNREADABLE_FILE;
+            return result;
+        }
+        ByteView view = file->View();
+        size_t length = static_cast<size_t>(std::min<uint64_t>(view.Size(), DecoderJobs::MARKDOWN_MAX_BYTES));
+        std::string_view text(reinterpret_cast<const char*>(view.Data()), length);
+
+        // Each chunk goes out in as many Partials as the section needs. A
+        // block larger than the whole section ends the preview there.
+        auto send = [&](const MarkdownDocument& chunk, bool complete, bool truncated) {
+            size_t nextBlock = 0;
+            do {
+                size_t firstBlock = nextBlock;
+                size_t bytes = DecoderJobs::EncodeMarkdown(chunk, nextBlock, Output(), OutputCapacity());
+                bool tooLarge = nextBlock == firstBlock && nextBlock < chunk.blocks.size();
+                bool last = nextBlock == chunk.blocks.size();
+                uint64_t values[4] = {};
+                if ((last && complete) || tooLarge) {
+                    values[0] |= DecoderJobs::BATCH_COMPLETE;
+                }
+                if ((last && truncated) || tooLarge) {
+                    values[0] |= DecoderJobs::BATCH_TRUNCATED;
+                }
+                if (!SendPartial(job, bytes, values) || tooLarge) {
+                    return false;
+                }
+            } while (nextBlock < chunk.blocks.size());
+            return true;
+        };
+
+        if (!m_markdownParser) {
+            m_markdownParser = std::make_unique<MarkdownParser>(std::string_view());
+        }
+        MarkdownDocument chunk;
+        DecoderJobs::StreamMarkdown(*m_markdownParser, text, length < view.Size(), m_cancellation, chunk, send);
+        m_markdownParser->Reset(std::string_view());
+        m_uncached.Close();
+        return result;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleDatabasePreview(const Job& job) {
+        // Only the schema and first leaf pages are touched; read-ahead would
+        // fetch pages of a multi-GB file nobody asked for
+        Result result;
+        const MappedFile* file = MapFile(FromUtf8(job.arguments), job.values[0], job.values[1], MapAccess::Random);
+        if (!file) {
+            result.code = WorkerProtocol::UNREADABLE_FILE;
+            return result;
+        }
+        SqliteFile database(file->View());
+        if (!database.IsValid()) {
+            result.code = WorkerProtocol::UNREADABLE_FILE;
+            m_uncached.Close();
+            return result;
+        }
+
+        DecoderJobs::StreamDatabase(database, m_cancellation, [&](const SqliteSchema& schema, size_t tableCount) {
+            uint64_t values[4] = {};
+            values[0] = tableCount;
+            return SendPartial(job, DecoderJobs::EncodeSchema(schema, Output(), OutputCapacity()), values);
+        }, [&](const SqliteRows* rows, bool) {
+            uint64_t values[4] = {};
+            return SendPartial(job, DecoderJobs::EncodeRows(*rows, Output(), OutputCapacity()), values);
+        });
+        m_uncached.Close();
+        return result;
+    }
+
+    DecoderWorker::Result DecoderWorker::HandleFontPreview(const Job& job) {
+        // Tables are scattered and glyphs are read one by one
+        Result result;
+        size_t separator = job.arguments.find('\0');
+        std::wstring path = FromUtf8(job.arguments.substr(0, separator));
+        const MappedFile* file = MapFile(path, job.values[0], job.values[1], MapAccess::Random);
+        if (!file) {
+            result.code = WorkerProtocol::UNREADABLE_FILE;
+            return result;
+        }
+
+        // The pool's surface, which the UI maps once the pool has sent the
+        // summary; without one only the names are read
+        SharedMemory surface;
+        if (separator != std::string_view::npos &&
+            !surface.Open(job.arguments.substr(separator + 1), static_cast<size_t>(job.values[2]))) {
+            std::wcerr << L"Decoder worker cannot open the font specimen surface" << std::endl;
+        }
+        if (!m_glyphCache) {
+            m_glyphCache = std::make_unique<GlyphCache>(m_governor);
+        }
+
+        DecoderFile font;
+        font.path = path;
+        font.size = job.values[0];
+        font.modifiedTime = job.values[1];
+        FontSummary summary;
+        DecoderJobs::DrawSpecimen(file->View(), DecoderJobs::FontKey(font), *m_glyphCache, surface.Data(),
+                                  surface.Size(), summary);
+        result.outputBytes = DecoderJobs::EncodeFont(summary, Output(), OutputCapacity());
+        m_uncached.Close();
+        return result;
+    }
+
+#ifdef LUMOS_FAULT_INJECTION
+    DecoderWorker::Result DecoderWorker::HandleTest(const Job& job) {
+        Result result;
+        switch (job.kind) {
+        case WorkerJobKind::TestEcho:
+            result.outputBytes = job.input.Size();  // Already in place
+#ifdef _WIN32
+            result.values[0] = GetCurrentProcessId();
+#else
+            result.values[0] = static_cast<uint64_t>(getpid());
+#endif
+            break;
+        case WorkerJobKind::TestSpin: {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(job.values[0]);
+            uint64_t state = job.id;
+            while (std::chrono::steady_clock::now() < until && !m_cancellation.IsCancellationRequested()) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+            }
+            result.values[0] = state;
+            break;
+        }
+        case WorkerJobKind::TestCrash:
+            *static_cast<volatile int*>(nullptr) = 0;
+            break;
+        case WorkerJobKind::TestHang:
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        case WorkerJobKind::TestExit:
+            std::_Exit(static_cast<int>(job.values[0]));
+        default:
+            break;
+        }
+        return result;
+    }
+#endif
+
+    bool DecoderWorker::SendPartial(const Job& job, size_t bytes, const uint64_t (&values)[4]) {
+        WorkerFrame partial = {};
+        partial.magic = WorkerProtocol::FRAME_MAGIC;
+        partial.type = static_cast<uint16_t>(WorkerFrameType::Partial);
+        partial.jobId = job.id;
+        partial.sectionBytes = static_cast<uint32_t>(bytes);
+        std::memcpy(partial.values, values, sizeof(partial.values));
+        if (!m_endpoint->Write(&partial, sizeof(partial))) {
+            return false;
+        }
+
+        WorkerFrame ack;
+        if (!m_endpoint->Read(&ack, sizeof(ack)) || ack.magic != WorkerProtocol::FRAME_MAGIC ||
+            ack.type != static_cast<uint16_t>(WorkerFrameType::Ack) || ack.jobId != job.id) {
+            // Lost the pool mid-job; the main loop notices when it reads next
+            return false;
+        }
+        return ack.code != 0;
+    }
+
+    const MappedFile* DecoderWorker::MapFile(const std::wstring& path, uint64_t size, uint64_t modifiedTime,
+                                             MapAccess access) {
+        for (size_t i = 0; i < m_files.size(); ++i) {
+            if (m_files[i].path == path && m_files[i].size == size && m_files[i].modifiedTime == modifiedTime) {
+                MappedEntry entry = std::move(m_files[i]);
+                m_files.erase(m_files.begin() + i);
+                m_files.push_back(std::move(entry));
+                return &m_files.back().file;
+            }
+        }
+
+        MappedFile file;
+        if (!file.Open(path, access) || (modifiedTime != 0 && file.Size() != size)) {
+            return nullptr;
+        }
+        if (modifiedTime == 0) {
+            m_uncached = std::move(file);
+            return &m_uncached;
+        }
+        if (m_files.size() == MAPPED_FILES) {
+            m_files.erase(m_files.begin());
+        }
+        m_files.push_back(MappedEntry{ path, size, modifiedTime, std::move(file) });
+        return &m_files.back().file;
+    }
+
+    const NativeProvider* DecoderWorker::LoadProvider(const std::wstring& library) {
+        for (const auto& loaded : m_loaded) {
+            if (loaded.first == library) {
+                return loaded.second;
+            }
+        }
+
+        if (!m_providers) {
+            m_providers = std::make_unique<ProviderRegistry>();
+        }
+        const NativeProvider* provider = nullptr;
+        std::wstring error;
+        if (auto loaded = ProviderLibrary::Load(library, error)) {
+            const LumosProviderInfo* info = loaded->Info();
+            if (m_providers->Add(info, std::move(loaded))) {
+                provider = m_providers->Providers().back().get();
+            }
+        } else {
+            std::wcerr << L"Decoder worker cannot load provider " << library << L": " << error << std::endl;
+        }
+        m_loaded.emplace_back(library, provider);
+        return provider;
+    }
+}
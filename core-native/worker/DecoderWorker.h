@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "WorkerProtocol.h"
+#include "../common/ByteView.h"
+#include "../common/CancellationToken.h"
+#include "../io/MappedFile.h"
+#include "../ipc/SharedMemory.h"
+#include "../memory/MemoryGovernor.h"
+
+namespace Lumos {
+    class GlyphCache;
+    class MarkdownParser;
+    class ProviderRegistry;
+    class WorkerEndpoint;
+    struct NativeProvider;
+
+    // The worker side of DecoderPool: what lumos.exe runs when started with
+    // --decode-worker. Serves one job at a time until the pool closes the
+    // channel, keeping recently mapped files, loaded providers and the last
+    // font's glyphs warm for the jobs the pool routes back to it. Nothing here is trusted to
+    // survive the file it parses.
+    class DecoderWorker {
+    public:
+        DecoderWorker();
+        ~DecoderWorker();
+
+        DecoderWorker(const DecoderWorker&) = delete;
+        DecoderWorker& operator=(const DecoderWorker&) = delete;
+
+        static bool IsWorkerCommandLine(int argc, char* argv[]);
+
+        // Exit code for the process: 0 once the pool hangs up
+        int Run(int argc, char* argv[]);
+
+    private:
+        struct Job {
+            uint64_t id;
+            WorkerJobKind kind;
+            std::string_view arguments;
+            ByteView input;
+            const uint64_t* values;  // 4
+        };
+
+        struct Result {
+            uint16_t code = 0;
+            size_t outputBytes = 0;
+            uint64_t values[4] = {};
+        };
+
+        struct MappedEntry {
+            std::wstring path;
+            uint64_t size;
+            uint64_t modifiedTime;
+            MappedFile file;
+        };
+
+        // Files kept mapped for repeat previews; jobs of unknown modified
+        // time map afresh
+        static constexpr size_t MAPPED_FILES = 4;
+
+        Result Handle(const Job& job);
+        Result HandleImageProbe(const Job& job);
+        Result HandleProviderPreview(const Job& job);
+        Result HandleEmbeddedPreview(const Job& job);
+        Result HandleMarkdownPreview(const Job& job);
+        Result HandleDatabasePreview(const Job& job);
+        Result HandleFontPreview(const Job& job);
+        Result HandleTest(const Job& job);  // Defined in LUMOS_FAULT_INJECTION builds only
+
+        // Output overlays the job's input: read the input first
+        uint8_t* Output() const { return m_section.Data() + WorkerProtocol::DATA_OFFSET; }
+        size_t OutputCapacity() const { return m_section.Size() - WorkerProtocol::DATA_OFFSET; }
+
+        // Hand the pool `bytes` of Output() and wait for its Ack. False: stop.
+        bool SendPartial(const Job& job, size_t bytes, const uint64_t (&values)[4]);
+
+        const MappedFile* MapFile(const std::wstring& path, uint64_t size, uint64_t modifiedTime, MapAccess access);
+        const NativeProvider* LoadProvider(const std::wstring& library);
+
+        std::unique_ptr<WorkerEndpoint> m_endpoint;
+        SharedMemory m_section;
+        CancellationToken m_cancellation;  // The section's cancelled flag
+        std::string m_arguments;
+
+        std::vector<MappedEntry> m_files;  // Most recently used last
+        std::unique_ptr<ProviderRegistry> m_providers;
+        std::vector<std::pair<std::wstring, const NativeProvider*>> m_loaded;  // Null: failed to load
+        MappedFile m_uncached;
+
+        std::unique_ptr<MarkdownParser> m_markdownParser;  // Reset for each document
+        MemoryGovernor m_governor;                         // This worker's own budget
+        std::unique_ptr<GlyphCache> m_glyphCache;
+    };
+}
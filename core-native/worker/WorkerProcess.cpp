@@ -0,0 +1,505 @@
+#include "WorkerProcess.h"
+#include <algorithm>
+#include <atomic>
+#include "WorkerProtocol.h"
+#include "../common/Utf8.h"
+#include "../ipc/SharedMemory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#endif
+
+namespace Lumos {
+    namespace {
+        int RemainingMs(WorkerProcess::Clock::time_point deadline) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - WorkerProcess::Clock::now());
+            return static_cast<int>(std::clamp<long long>(left.count(), 0, INT32_MAX));
+        }
+    }
+
+#ifdef _WIN32
+    namespace {
+        constexpr DWORD PIPE_BUFFER_BYTES = 64 * 1024;
+        constexpr DWORD CONNECT_TIMEOUT_MS = 5000;
+        constexpr DWORD KILL_TIMEOUT_MS = 2000;
+
+        // Workers belong to a job object that kills them when its last
+        // handle closes, which is when lumos.exe exits or crashes
+        HANDLE WorkerJobObject() {
+            static HANDLE job = [] {
+                HANDLE created = CreateJobObjectW(nullptr, nullptr);
+                if (created) {
+                    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+                    limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+                    SetInformationJobObject(created, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+                }
+                return created;
+            }();
+            return job;
+        }
+    }
+
+    WorkerProcess::WorkerProcess()
+        : m_pid(0)
+        , m_process(nullptr)
+        , m_pipe(INVALID_HANDLE_VALUE)
+        , m_event(nullptr)
+        , m_peekEvent(nullptr)
+        , m_peekOverlapped(new OVERLAPPED())
+        , m_peekPending(false)
+        , m_peeked(false)
+        , m_peekByte(0)
+    {
+    }
+
+    WorkerProcess::~WorkerProcess() {
+        Kill();
+        if (m_pipe != INVALID_HANDLE_VALUE) CloseHandle(m_pipe);
+        if (m_event) CloseHandle(m_event);
+        if (m_peekEvent) CloseHandle(m_peekEvent);
+        if (m_process) CloseHandle(m_process);
+        delete static_cast<OVERLAPPED*>(m_peekOverlapped);
+    }
+
+    std::unique_ptr<WorkerProcess> WorkerProcess::Launch(const std::wstring& executable, const std::string& sectionName,
+                                                         size_t sectionSize, std::wstring& error) {
+        static std::atomic<uint64_t> nextChannel{ 0 };
+        std::unique_ptr<WorkerProcess> worker(new WorkerProcess());
+
+        // ASCII identifiers only, like section names
+        std::string pipeName = "\\\\.\\pipe\\" + SharedMemory::UniqueName("LumosDecoderPipe", nextChannel++);
+        std::wstring widePipeName(pipeName.begin(), pipeName.end());
+        worker->m_pipe = CreateNamedPipeW(widePipeName.c_str(),
+                                          PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                          PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                          1, PIPE_BUFFER_BYTES, PIPE_BUFFER_BYTES, 0, nullptr);
+        worker->m_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        worker->m_peekEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (worker->m_pipe == INVALID_HANDLE_VALUE || !worker->m_event || !worker->m_peekEvent) {
+            error = L"cannot create the worker channel (error " + std::to_wstring(GetLastError()) + L")";
+            return nullptr;
+        }
+
+        std::wstring commandLine = L"\"" + executable + L"\" " + FromUtf8(WorkerProtocol::COMMAND_LINE_SWITCH) +
+                                   L" " + widePipeName + L" " + FromUtf8(sectionName) + L" " +
+                                   std::to_wstring(sectionSize);
+        STARTUPINFOW si = { sizeof(STARTUPINFOW) };
+        PROCESS_INFORMATION pi;
+        // Suspended until it is in the job object, so not even a crash at
+        // startup can leave it outside
+        if (!CreateProcessW(executable.c_str(), commandLine.data(), nullptr, nullptr, FALSE,
+                            CREATE_SUSPENDED | CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+            error = L"CreateProcess failed with error " + std::to_wstring(GetLastError());
+            return nullptr;
+        }
+        if (HANDLE job = WorkerJobObject()) {
+            AssignProcessToJobObject(job, pi.hProcess);
+        }
+        ResumeThread(pi.hThread);
+        CloseHandle(pi.hThread);
+        worker->m_process = pi.hProcess;
+        worker->m_pid = pi.dwProcessId;
+
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = worker->m_event;
+        ResetEvent(worker->m_event);
+        if (!ConnectNamedPipe(worker->m_pipe, &overlapped)) {
+            DWORD lastError = GetLastError();
+            if (lastError == ERROR_IO_PENDING) {
+                HANDLE handles[] = { worker->m_event, worker->m_process };
+                DWORD wait = WaitForMultipleObjects(2, handles, FALSE, CONNECT_TIMEOUT_MS);
+                DWORD transferred = 0;
+                if (wait != WAIT_OBJECT_0 || !GetOverlappedResult(worker->m_pipe, &overlapped, &transferred, FALSE)) {
+                    CancelIoEx(worker->m_pipe, &overlapped);
+                    GetOverlappedResult(worker->m_pipe, &overlapped, &transferred, TRUE);
+                    error = L"the worker never opened its channel";
+                    return nullptr;
+                }
+            } else if (lastError != ERROR_PIPE_CONNECTED) {
+                error = L"ConnectNamedPipe failed with error " + std::to_wstring(lastError);
+                return nullptr;
+            }
+        }
+        return worker;
+    }
+
+    ChannelStatus WorkerProcess::Transfer(bool write, void* data, size_t size, Clock::time_point deadline) {
+        auto* bytes = static_cast<uint8_t*>(data);
+        size_t done = 0;
+        while (done < size) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = m_event;
+            ResetEvent(m_event);
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - done, MAXDWORD));
+            BOOL ok = write ? WriteFile(m_pipe, bytes + done, chunk, nullptr, &overlapped)
+                            : ReadFile(m_pipe, bytes + done, chunk, nullptr, &overlapped);
+            if (!ok && GetLastError() != ERROR_IO_PENDING) {
+                return ChannelStatus::Closed;
+            }
+
+            DWORD transferred = 0;
+            if (WaitForSingleObject(m_event, static_cast<DWORD>(RemainingMs(deadline))) != WAIT_OBJECT_0) {
+                CancelIoEx(m_pipe, &overlapped);
+                GetOverlappedResult(m_pipe, &overlapped, &transferred, TRUE);
+                return ChannelStatus::TimedOut;
+            }
+            if (!GetOverlappedResult(m_pipe, &overlapped, &transferred, FALSE) || transferred == 0) {
+                return ChannelStatus::Closed;
+            }
+            done += transferred;
+        }
+        return ChannelStatus::Ok;
+    }
+
+    ChannelStatus WorkerProcess::Write(const void* data, size_t size, Clock::time_point deadline) {
+        return Transfer(true, const_cast<void*>(data), size, deadline);
+    }
+
+    ChannelStatus WorkerProcess::Read(void* data, size_t size, Clock::time_point deadline) {
+        if (size == 0) {
+            return ChannelStatus::Ok;
+        }
+        ChannelStatus status = WaitReadable(std::chrono::milliseconds(RemainingMs(deadline)));
+        if (status != ChannelStatus::Ok) {
+            return status;
+        }
+        auto* bytes = static_cast<uint8_t*>(data);
+        bytes[0] = m_peekByte;
+        m_peeked = false;
+        return Transfer(false, bytes + 1, size - 1, deadline);
+    }
+
+    // Pipes have no poll(): a one-byte read stays pending across calls and
+    // its byte is handed to the next Read
+    ChannelStatus WorkerProcess::WaitReadable(std::chrono::milliseconds timeout) {
+        if (m_peeked) {
+            return ChannelStatus::Ok;
+        }
+        auto* overlapped = static_cast<OVERLAPPED*>(m_peekOverlapped);
+        if (!m_peekPending) {
+            *overlapped = OVERLAPPED();
+            overlapped->hEvent = m_peekEvent;
+            ResetEvent(m_peekEvent);
+            if (!ReadFile(m_pipe, &m_peekByte, 1, nullptr, overlapped) && GetLastError() != ERROR_IO_PENDING) {
+                return ChannelStatus::Closed;
+            }
+            m_peekPending = true;
+        }
+        if (WaitForSingleObject(m_peekEvent, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0) {
+            return ChannelStatus::TimedOut;
+        }
+        m_peekPending = false;
+        DWORD transferred = 0;
+        if (!GetOverlappedResult(m_pipe, overlapped, &transferred, FALSE) || transferred != 1) {
+            return ChannelStatus::Closed;
+        }
+        m_peeked = true;
+        return ChannelStatus::Ok;
+    }
+
+    bool WorkerProcess::IsAlive() {
+        return m_process && WaitForSingleObject(m_process, 0) == WAIT_TIMEOUT;
+    }
+
+    void WorkerProcess::Kill() {
+        if (!m_process) {
+            return;
+        }
+        if (WaitForSingleObject(m_process, 0) == WAIT_TIMEOUT) {
+            TerminateProcess(m_process, ERROR_PROCESS_ABORTED);
+            WaitForSingleObject(m_process, KILL_TIMEOUT_MS);
+        }
+        if (m_peekPending) {
+            DWORD transferred = 0;
+            CancelIoEx(m_pipe, static_cast<OVERLAPPED*>(m_peekOverlapped));
+            GetOverlappedResult(m_pipe, static_cast<OVERLAPPED*>(m_peekOverlapped), &transferred, TRUE);
+            m_peekPending = false;
+        }
+    }
+
+    std::wstring WorkerProcess::ExitReason() {
+        DWORD code = 0;
+        if (!m_process || !GetExitCodeProcess(m_process, &code) || code == STILL_ACTIVE) {
+            return std::wstring();
+        }
+        wchar_t text[32];
+        swprintf_s(text, L"exit code 0x%08X", code);
+        return text;
+    }
+
+    WorkerEndpoint::WorkerEndpoint()
+        : m_pipe(INVALID_HANDLE_VALUE)
+    {
+    }
+
+    WorkerEndpoint::~WorkerEndpoint() {
+        if (m_pipe != INVALID_HANDLE_VALUE) CloseHandle(m_pipe);
+    }
+
+    std::unique_ptr<WorkerEndpoint> WorkerEndpoint::Connect(std::string_view channel) {
+        std::wstring pipeName(channel.begin(), channel.end());
+        HANDLE pipe = CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        std::unique_ptr<WorkerEndpoint> endpoint(new WorkerEndpoint());
+        endpoint->m_pipe = pipe;
+        return endpoint;
+    }
+
+    bool WorkerEndpoint::Write(const void* data, size_t size) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            DWORD written = 0;
+            if (!WriteFile(m_pipe, bytes, static_cast<DWORD>(std::min<size_t>(size, MAXDWORD)), &written, nullptr) ||
+                written == 0) {
+                return false;
+            }
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool WorkerEndpoint::Read(void* data, size_t size) {
+        auto* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            DWORD read = 0;
+            if (!ReadFile(m_pipe, bytes, static_cast<DWORD>(std::min<size_t>(size, MAXDWORD)), &read, nullptr) ||
+                read == 0) {
+                return false;
+            }
+            bytes += read;
+            size -= read;
+        }
+        return true;
+    }
+#else
+    WorkerProcess::WorkerProcess()
+        : m_pid(0)
+        , m_fd(-1)
+        , m_status(0)
+        , m_reaped(false)
+    {
+    }
+
+    WorkerProcess::~WorkerProcess() {
+        Kill();
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    std::unique_ptr<WorkerProcess> WorkerProcess::Launch(const std::wstring& executable, const std::string& sectionName,
+                                                         size_t sectionSize, std::wstring& error) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            error = L"socketpair failed";
+            return nullptr;
+        }
+
+        // Everything the child needs is built before fork: between fork and
+        // exec only async-signal-safe calls are allowed
+        std::string narrowPath = ToUtf8(executable);
+        std::string channel = std::to_string(fds[1]);
+        std::string size = std::to_string(sectionSize);
+        char* argv[] = {
+            const_cast<char*>(narrowPath.c_str()),
+            const_cast<char*>(WorkerProtocol::COMMAND_LINE_SWITCH),
+            const_cast<char*>(channel.c_str()),
+            const_cast<char*>(sectionName.c_str()),
+            const_cast<char*>(size.c_str()),
+            nullptr
+        };
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            error = L"fork failed";
+            return nullptr;
+        }
+        if (pid == 0) {
+#ifdef __linux__
+            // Tied to the forking thread, which is the pool's supervisor
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+            fcntl(fds[1], F_SETFD, 0);  // The worker's end survives exec
+            execv(narrowPath.c_str(), argv);
+            _exit(127);
+        }
+
+        close(fds[1]);
+        std::unique_ptr<WorkerProcess> worker(new WorkerProcess());
+        worker->m_fd = fds[0];
+        worker->m_pid = static_cast<uint64_t>(pid);
+        return worker;
+    }
+
+    ChannelStatus WorkerProcess::Write(const void* data, size_t size, Clock::time_point deadline) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t sent = send(m_fd, bytes, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent > 0) {
+                bytes += sent;
+                size -= static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd pfd = { m_fd, POLLOUT, 0 };
+                int ready = poll(&pfd, 1, RemainingMs(deadline));
+                if (ready == 0) {
+                    return ChannelStatus::TimedOut;
+                }
+                continue;
+            }
+            return ChannelStatus::Closed;
+        }
+        return ChannelStatus::Ok;
+    }
+
+    ChannelStatus WorkerProcess::Read(void* data, size_t size, Clock::time_point deadline) {
+        auto* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            ssize_t received = recv(m_fd, bytes, size, MSG_DONTWAIT);
+            if (received > 0) {
+                bytes += received;
+                size -= static_cast<size_t>(received);
+                continue;
+            }
+            if (received == 0) {
+                return ChannelStatus::Closed;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                pollfd pfd = { m_fd, POLLIN, 0 };
+                int ready = poll(&pfd, 1, RemainingMs(deadline));
+                if (ready == 0) {
+                    return ChannelStatus::TimedOut;
+                }
+                continue;
+            }
+            return ChannelStatus::Closed;
+        }
+        return ChannelStatus::Ok;
+    }
+
+    ChannelStatus WorkerProcess::WaitReadable(std::chrono::milliseconds timeout) {
+        auto deadline = Clock::now() + timeout;
+        while (true) {
+            pollfd pfd = { m_fd, POLLIN, 0 };
+            int ready = poll(&pfd, 1, RemainingMs(deadline));
+            if (ready > 0) {
+                // A dead worker reads as end-of-file; Read reports it
+                return (pfd.revents & (POLLIN | POLLHUP)) ? ChannelStatus::Ok : ChannelStatus::Closed;
+            }
+            if (ready == 0) {
+                return ChannelStatus::TimedOut;
+            }
+            if (errno != EINTR) {
+                return ChannelStatus::Closed;
+            }
+        }
+    }
+
+    bool WorkerProcess::IsAlive() {
+        if (m_reaped) {
+            return false;
+        }
+        if (waitpid(static_cast<pid_t>(m_pid), &m_status, WNOHANG) == static_cast<pid_t>(m_pid)) {
+            m_reaped = true;
+            return false;
+        }
+        return true;
+    }
+
+    void WorkerProcess::Kill() {
+        if (m_pid == 0 || m_reaped) {
+            return;
+        }
+        kill(static_cast<pid_t>(m_pid), SIGKILL);
+        while (waitpid(static_cast<pid_t>(m_pid), &m_status, 0) < 0 && errno == EINTR) {
+        }
+        m_reaped = true;
+    }
+
+    std::wstring WorkerProcess::ExitReason() {
+        if (!m_reaped && IsAlive()) {
+            return std::wstring();
+        }
+        if (WIFSIGNALED(m_status)) {
+            return L"signal " + std::to_wstring(WTERMSIG(m_status));
+        }
+        return L"exit code " + std::to_wstring(WEXITSTATUS(m_status));
+    }
+
+    WorkerEndpoint::WorkerEndpoint()
+        : m_fd(-1)
+    {
+    }
+
+    WorkerEndpoint::~WorkerEndpoint() {
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    std::unique_ptr<WorkerEndpoint> WorkerEndpoint::Connect(std::string_view channel) {
+        std::string text(channel);
+        char* end = nullptr;
+        long fd = strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || fd < 0 || fcntl(static_cast<int>(fd), F_GETFD) < 0) {
+            return nullptr;
+        }
+        fcntl(static_cast<int>(fd), F_SETFD, FD_CLOEXEC);
+        std::unique_ptr<WorkerEndpoint> endpoint(new WorkerEndpoint());
+        endpoint->m_fd = static_cast<int>(fd);
+        return endpoint;
+    }
+
+    bool WorkerEndpoint::Write(const void* data, size_t size) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t sent = send(m_fd, bytes, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            bytes += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool WorkerEndpoint::Read(void* data, size_t size) {
+        auto* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            ssize_t received = recv(m_fd, bytes, size, 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            bytes += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+#endif
+}
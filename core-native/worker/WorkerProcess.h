@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Lumos {
+    enum class ChannelStatus {
+        Ok,
+        TimedOut,
+        Closed    // The other end is gone (or the channel broke)
+    };
+
+    // A decoder worker process and the duplex control channel to it: a
+    // socketpair on POSIX, an overlapped named pipe on Windows. Workers die
+    // with this process however it ends (a kill-on-close job object on
+    // Windows, PR_SET_PDEATHSIG and the channel closing on Linux).
+    //
+    // Not thread-safe: DecoderPool hands each worker to one caller at a time.
+    class WorkerProcess {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ~WorkerProcess();
+
+        WorkerProcess(const WorkerProcess&) = delete;
+        WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+        // Start `executable` in worker mode with the section it should map.
+        // Returns once the process exists and holds its end of the channel;
+        // the caller waits for its Hello. Null, with the reason in `error`,
+        // if it could not be started.
+        static std::unique_ptr<WorkerProcess> Launch(const std::wstring& executable, const std::string& sectionName,
+                                                     size_t sectionSize, std::wstring& error);
+
+        ChannelStatus Write(const void* data, size_t size, Clock::time_point deadline);
+        ChannelStatus Read(void* data, size_t size, Clock::time_point deadline);
+
+        // Wait for something to read without consuming it
+        ChannelStatus WaitReadable(std::chrono::milliseconds timeout);
+
+        bool IsAlive();
+
+        // Terminate (if still running) and reap the process
+        void Kill();
+
+        uint64_t Pid() const { return m_pid; }
+
+        // How the process ended, for the log ("signal 11", "exit code
+        // 0xC0000005"); empty while it runs
+        std::wstring ExitReason();
+
+    private:
+        WorkerProcess();
+
+        uint64_t m_pid;
+#ifdef _WIN32
+        ChannelStatus Transfer(bool write, void* data, size_t size, Clock::time_point deadline);
+
+        void* m_process;
+        void* m_pipe;
+        void* m_event;
+        void* m_peekEvent;
+        void* m_peekOverlapped;  // OVERLAPPED of a one-byte read left pending by WaitReadable
+        bool m_peekPending;
+        bool m_peeked;
+        uint8_t m_peekByte;
+#else
+        int m_fd;
+        int m_status;
+        bool m_reaped;
+#endif
+    };
+
+    // The worker's end of the control channel. Blocking with no timeouts:
+    // the pool enforces those by killing the worker.
+    class WorkerEndpoint {
+    public:
+        ~WorkerEndpoint();
+
+        WorkerEndpoint(const WorkerEndpoint&) = delete;
+        WorkerEndpoint& operator=(const WorkerEndpoint&) = delete;
+
+        // `channel` as WorkerProcess::Launch passed it on the command line
+        static std::unique_ptr<WorkerEndpoint> Connect(std::string_view channel);
+
+        // False once the pool is gone
+        bool Write(const void* data, size_t size);
+        bool Read(void* data, size_t size);
+
+    private:
+        WorkerEndpoint();
+
+#ifdef _WIN32
+        void* m_pipe;
+#else
+        int m_fd;
+#endif
+    };
+}
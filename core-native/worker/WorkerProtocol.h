@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Lumos {
+    // What a decoder worker is asked to do
+    enum class WorkerJobKind : uint16_t {
+        ImageProbe = 1,       // Input: a file's first bytes. Code: ProbeStatus; output: ImageHeader
+        ProviderPreview = 2,  // Arguments: DecoderJobs::ProviderArguments. Code: LumosPreviewResult;
+                              // each batch of rows arrives as a Partial
+
+        // Built-in parsers over a file the worker maps itself. Arguments: its
+        // path (UTF-8); values[0] and [1]: its size and modified time.
+        // Output is in DecoderJobs' encodings; code UNREADABLE_FILE if the
+        // file cannot be mapped, or is not what the job reads.
+        EmbeddedPreview = 3,  // values[2], [3]: target and minimum edge. Output: EmbeddedPreview,
+                              // none if the file has none
+        MarkdownPreview = 4,  // Each chunk of blocks arrives as a Partial; values[0]: BATCH_* flags
+        DatabasePreview = 5,  // A Partial with the schema (values[0]: tables to follow), then one
+                              // with each table's rows
+        FontPreview = 6,      // Arguments: path, then NUL and a surface to draw the specimen
+                              // into; values[2]: the surface's size. Output: FontSummary
+
+        // Fixtures for fault-injection tests and the pool benchmark; workers
+        // only serve them in LUMOS_FAULT_INJECTION builds
+        TestEcho = 0x100,     // Output: the input; values[0]: the worker's process id
+        TestSpin,             // values[0] microseconds of CPU work
+        TestCrash,            // Dies of an access violation
+        TestHang,             // Never answers, ignoring cancellation
+        TestExit              // Exits with code values[0] before answering
+    };
+
+    enum class WorkerFrameType : uint16_t {
+        Hello = 1,  // Worker → pool once it is up; code: PROTOCOL_VERSION
+        Job,        // Pool → worker; code: WorkerJobKind
+        Partial,    // Worker → pool: output so far. The worker waits for an Ack.
+        Ack,        // Pool → worker; code 1 to go on, 0 to stop the job
+        Done        // Worker → pool; code: the job's result
+    };
+
+    // Every message on the control channel is one frame, followed by
+    // `argumentBytes` of arguments (Job frames only). Bulk data travels in
+    // the worker's shared-memory section instead: a Job's input and a
+    // Partial or Done frame's output occupy its first `sectionBytes`. Both
+    // ends are the same executable, so frames are plain host-order structs.
+    struct WorkerFrame {
+        uint32_t magic;
+        uint16_t type;           // WorkerFrameType
+        uint16_t code;
+        uint64_t jobId;
+        uint32_t argumentBytes;
+        uint32_t sectionBytes;
+        uint64_t values[4];      // Small per-kind fields
+    };
+
+    // At the start of each worker's section, ahead of the data area
+    struct WorkerSectionHeader {
+        std::atomic<bool> cancelled;  // Set by the pool; handlers poll it
+        uint8_t reserved[63];
+    };
+
+    namespace WorkerProtocol {
+        constexpr uint32_t FRAME_MAGIC = 0x4B574D4C;  // "LMWK"
+        constexpr uint16_t PROTOCOL_VERSION = 1;
+
+        // lumos.exe --decode-worker <channel> <section> <section bytes>
+        constexpr const char* COMMAND_LINE_SWITCH = "--decode-worker";
+
+        // Room for a provider batch (ProviderSession::MAX_BATCH_BYTES plus
+        // one maximal row) and for the largest image probe. Markdown chunks
+        // are split to fit; schemas and row sets are cut short.
+        constexpr size_t SECTION_BYTES = 4 * 1024 * 1024;
+        constexpr size_t DATA_OFFSET = sizeof(WorkerSectionHeader);
+        constexpr uint32_t MAX_ARGUMENT_BYTES = 64 * 1024;
+
+        // Done code from a worker that has no handler for the job's kind
+        constexpr uint16_t UNKNOWN_JOB = 0xFFFF;
+
+        // Done code of a parse job whose file could not be mapped or read
+        constexpr uint16_t UNREADABLE_FILE = 1;
+    }
+
+    static_assert(sizeof(WorkerFrame) == 56, "WorkerFrame layout is part of the protocol");
+    static_assert(sizeof(WorkerSectionHeader) == 64, "WorkerSectionHeader layout is part of the protocol");
+    static_assert(std::atomic<bool>::is_always_lock_free, "Section flags are shared between processes");
+}
@@ -1,11 +1,288 @@
 using System;
+using System.Collections.Generic;
 
 namespace Lumos.Contracts
 {
     public class PreviewRequest
     {
-        public required string Path { get; set; }
-        public required string Extension { get; set; }
+        public const string PreviewType = "preview";
+        public const string CancelType = "cancel";
+        public const string MarkdownType = "markdown";
+        public const string TailType = "tail";
+        public const string HashesType = "hashes";
+        public const string DatabaseType = "database";
+        public const string ProviderType = "provider";
+
+        // "preview", "cancel", "markdown", "tail", "hashes", "database" or "provider"; cancel
+        // messages only carry a generation, the others a generation and
+        // the next chunk
+        public string Type { get; set; } = PreviewType;
+
+        // Monotonic per keypress on the native side
+        public long Generation { get; set; }
+
+        // The core-native instance that numbered Generation (its PID and
+        // start time). A restarted core counts from 1 again, so generations
+        // only compare within one session. Preview messages only.
+        public string Session { get; set; } = string.Empty;
+
+        public string Path { get; set; } = string.Empty;
+        public string Extension { get; set; } = string.Empty;
         public long Size { get; set; }
+
+        // Native header probe results; null when the file is not an image or
+        // the probe did not finish in time
+        public PreviewImageInfo? Image { get; set; }
+
+        // Embedded JPEG to decode instead of the full image; null if none
+        public PreviewEmbeddedImage? EmbeddedPreview { get; set; }
+
+        // Natively parsed Markdown blocks; null for other files
+        public PreviewMarkdown? Markdown { get; set; }
+
+        // Log window for follow mode; null for other files
+        public PreviewTail? Tail { get; set; }
+
+        // Checksum progress or digests for archives, disk images and binaries
+        public PreviewHashes? Hashes { get; set; }
+
+        // SQLite schema, then one table's first rows per database message
+        public PreviewDatabase? Database { get; set; }
+
+        // Font names, metrics and the specimen's shared-memory section
+        public PreviewFont? Font { get; set; }
+
+        // Rows from a native preview provider; null unless one handled the file
+        public PreviewProvider? Provider { get; set; }
+    }
+
+    public class PreviewImageInfo
+    {
+        public int Width { get; set; }
+        public int Height { get; set; }
+
+        // EXIF orientation 1-8; 5-8 are rotated a quarter turn
+        public int Orientation { get; set; } = 1;
+
+        public int BitDepth { get; set; }
+        public int FrameCount { get; set; } = 1;
+        public bool HasColorProfile { get; set; }
+
+        public bool IsQuarterTurn => Orientation >= 5 && Orientation <= 8;
+    }
+
+    public class PreviewEmbeddedImage
+    {
+        public long Offset { get; set; }
+        public long Length { get; set; }
+        public int Width { get; set; }
+        public int Height { get; set; }
+    }
+
+    public class PreviewTail
+    {
+        // Clear the view first: the file was cut short or rewritten
+        public bool Truncated { get; set; }
+
+        // The path now names a new file (log rotation); text is from its start
+        public bool Rotated { get; set; }
+
+        public long FileSize { get; set; }
+
+        // 0 while core-native is still counting the existing lines
+        public long TotalLines { get; set; }
+
+        // Appended lines left out to keep the update small
+        public long SkippedLines { get; set; }
+
+        // Whole lines, each ending in '\n'
+        public string Text { get; set; } = string.Empty;
+    }
+
+    public class PreviewHashes
+    {
+        public long HashedBytes { get; set; }
+        public long TotalBytes { get; set; }
+
+        // The digests below are set; no further hashes messages follow
+        public bool Complete { get; set; }
+
+        // Lower-case hex; empty until complete
+        public string Xxh3 { get; set; } = string.Empty;
+        public string Crc32c { get; set; } = string.Empty;
+        public string Sha1 { get; set; } = string.Empty;
+        public string Sha256 { get; set; } = string.Empty;
+    }
+
+    public class PreviewDatabase
+    {
+        // No further database messages follow
+        public bool Complete { get; set; }
+
+        // Preview message only
+        public DatabaseSchema? Schema { get; set; }
+
+        // Database messages only
+        public DatabaseTable? Table { get; set; }
+    }
+
+    public class DatabaseSchema
+    {
+        public int PageSize { get; set; }
+        public long PageCount { get; set; }
+        public long FreelistPages { get; set; }
+
+        // "UTF-8", "UTF-16le" or "UTF-16be"
+        public string Encoding { get; set; } = "UTF-8";
+
+        // WAL journal: changes not yet checkpointed are not shown
+        public bool Wal { get; set; }
+
+        public bool AutoVacuum { get; set; }
+        public long UserVersion { get; set; }
+        public long ApplicationId { get; set; }
+
+        // SQLITE_VERSION_NUMBER of the last writer, e.g. 3045001
+        public long SqliteVersion { get; set; }
+
+        public List<DatabaseObject> Objects { get; set; } = new List<DatabaseObject>();
+    }
+
+    // A row of sqlite_schema
+    public class DatabaseObject
+    {
+        // "table", "index", "view" or "trigger"
+        public string Type { get; set; } = string.Empty;
+        public string Name { get; set; } = string.Empty;
+        public string TableName { get; set; } = string.Empty;
+
+        // 0 for views, triggers and virtual tables, which have no rows to show
+        public long RootPage { get; set; }
+
+        public string Sql { get; set; } = string.Empty;
+    }
+
+    public class DatabaseTable
+    {
+        public string Name { get; set; } = string.Empty;
+        public long FirstRow { get; set; }
+        public List<string> Columns { get; set; } = new List<string>();
+
+        // Display text per cell as the sqlite3 shell would print it; null for NULL.
+        // Long text and blobs arrive cut short, ending in an ellipsis.
+        public List<List<string?>> Rows { get; set; } = new List<List<string?>>();
+
+        // The table has rows past the last one sent
+        public bool More { get; set; }
+    }
+
+    public class PreviewFont
+    {
+        public string Family { get; set; } = string.Empty;
+        public string Subfamily { get; set; } = string.Empty;
+        public string FullName { get; set; } = string.Empty;
+        public string Version { get; set; } = string.Empty;
+
+        // "TrueType" or "CFF"
+        public string Format { get; set; } = string.Empty;
+
+        // Fonts in a .ttc collection; only the first is drawn
+        public int FaceCount { get; set; } = 1;
+
+        public int GlyphCount { get; set; }
+        public int UnitsPerEm { get; set; }
+
+        // Named shared memory holding the specimen as premultiplied BGRA.
+        // Empty when nothing could be drawn; gone after the next press.
+        public string SurfaceName { get; set; } = string.Empty;
+
+        public int Width { get; set; }
+        public int Height { get; set; }
+        public int Stride { get; set; }
+    }
+
+    public class PreviewProvider
+    {
+        // The provider's display name
+        public string Name { get; set; } = string.Empty;
+
+        // Index of Rows[0] among all rows of the preview
+        public int FirstRow { get; set; }
+
+        // No further provider messages will follow for this generation
+        public bool Complete { get; set; }
+
+        // The provider gave up part-way; the rows are what it could read
+        public bool Failed { get; set; }
+
+        // The provider hit the native row limit
+        public bool Truncated { get; set; }
+
+        public List<ProviderRow> Rows { get; set; } = new List<ProviderRow>();
+    }
+
+    public class ProviderRow
+    {
+        public string Name { get; set; } = string.Empty;
+        public string Value { get; set; } = string.Empty;
+    }
+
+    public class PreviewMarkdown
+    {
+        // Index of Blocks[0] within the whole document
+        public int FirstBlock { get; set; }
+
+        // No further markdown messages will follow for this generation
+        public bool Complete { get; set; }
+
+        // The native parser stopped at its block limit
+        public bool Truncated { get; set; }
+
+        public List<MarkdownBlock> Blocks { get; set; } = new List<MarkdownBlock>();
+    }
+
+    // Leaf block of the flattened document; containers are expressed as the
+    // quote and list depths around it
+    public class MarkdownBlock
+    {
+        // "paragraph", "heading", "code", "html", "rule" or "row"
+        public string Kind { get; set; } = "paragraph";
+        public int Level { get; set; }
+        public int QuoteDepth { get; set; }
+        public int ListDepth { get; set; }
+        public bool ListItemStart { get; set; }
+        public bool ListOrdered { get; set; }
+        public long ListNumber { get; set; }
+        public int CellCount { get; set; }
+        public bool TableHeader { get; set; }
+
+        // Code block language, if any
+        public string? Info { get; set; }
+
+        public List<MarkdownRun> Runs { get; set; } = new List<MarkdownRun>();
+    }
+
+    [Flags]
+    public enum MarkdownStyle
+    {
+        None = 0,
+        Strong = 1,
+        Emphasis = 2,
+        Code = 4,
+        Strikethrough = 8,
+        Link = 16,
+        Image = 32,
+        LineBreak = 64
+    }
+
+    public class MarkdownRun
+    {
+        public string Text { get; set; } = string.Empty;
+        public MarkdownStyle Style { get; set; }
+        public string? Link { get; set; }
+
+        // Table rows: column index and alignment (0 none, 1 left, 2 center, 3 right)
+        public int Cell { get; set; }
+        public int Align { get; set; }
     }
 }
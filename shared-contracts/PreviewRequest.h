@@ -1,15 +1,169 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 
 namespace Lumos {
+    enum class PreviewMessageType {
+        Preview,  // Show a preview for `path`
+        Cancel,   // Abandon any work still running for `generation`
+        Markdown, // Further parsed blocks for the document of `generation`
+        Tail,     // Lines appended to the log file shown for `generation`
+        Hashes,   // Checksum progress or final digests for `generation`
+        Database, // First rows of one more table of the database shown for `generation`
+        Provider  // Further rows from the native provider previewing `generation`
+    };
+
+    // Layout hints from the native header probe, so the UI can open the
+    // window at its final size before the renderer has decoded anything
+    struct PreviewImageInfo {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint16_t orientation = 1;  // EXIF orientation 1-8
+        uint16_t bitDepth = 0;
+        uint32_t frameCount = 1;
+        bool hasColorProfile = false;
+    };
+
+    // Byte range of a self-contained JPEG inside the file (EXIF/MPF preview,
+    // RAW preview) that the UI decodes instead of the full image
+    struct PreviewEmbeddedImage {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    // A chunk of parsed Markdown blocks. The first chunk rides on the preview
+    // message; the rest follow as Markdown messages while parsing continues.
+    struct PreviewMarkdown {
+        uint32_t firstBlock = 0;   // Index of the chunk's first block in the document
+        bool complete = false;     // No more chunks will follow
+        bool truncated = false;    // Parsing stopped at the block limit
+        std::string_view blocksJson; // JSON array from MarkdownDocument::WriteJson; not owned
+    };
+
+    // Log file text for follow mode: the last lines with the preview message,
+    // then only what was appended, at most a few times a second
+    struct PreviewTail {
+        bool truncated = false;      // Clear the view first: the file was cut short
+        bool rotated = false;        // The path now names a new file; text is from its start
+        uint64_t fileSize = 0;
+        uint64_t totalLines = 0;     // 0 while the existing content is still being counted
+        uint64_t skippedLines = 0;   // Appended lines left out to keep the update small
+        std::string_view text;       // Whole lines, raw file bytes (not necessarily UTF-8); not owned
+    };
+
+    // Checksums of the whole file. The preview message carries the first
+    // state (final at once when cached); progress and the digests follow as
+    // Hashes messages while the native side hashes.
+    struct PreviewHashes {
+        uint64_t hashedBytes = 0;
+        uint64_t totalBytes = 0;
+        bool complete = false;       // Digests are set; no more messages follow
+        std::string_view xxh3;       // Lower-case hex, empty until complete; not owned
+        std::string_view crc32c;
+        std::string_view sha1;
+        std::string_view sha256;
+    };
+
+    // A SQLite database read natively: the schema rides on the preview
+    // message, then each table's first rows follow as a Database message
+    struct PreviewDatabase {
+        bool complete = false;         // No more tables follow
+        std::string_view schemaJson;   // Object from SqliteSchema::WriteJson, preview message only; not owned
+        std::string_view tableJson;    // Object from SqliteRows::WriteJson, Database messages only; not owned
+    };
+
+    // A font read natively. The specimen (sample lines and a glyph grid) is
+    // drawn into a named shared-memory section the UI maps by name, so the
+    // pixels never pass through the pipe; the UI must open it before the
+    // next press, which closes it.
+    struct PreviewFont {
+        std::string_view family;       // UTF-8 from the name table; not owned
+        std::string_view subfamily;
+        std::string_view fullName;
+        std::string_view version;
+        std::string_view format;       // "TrueType" or "CFF"
+        uint32_t faceCount = 1;        // Fonts in a .ttc collection; the first is shown
+        uint32_t glyphCount = 0;
+        uint32_t unitsPerEm = 0;
+        std::string_view surfaceName;  // Shared-memory section, empty if nothing was drawn; not owned
+        uint32_t width = 0;            // Premultiplied BGRA pixels
+        uint32_t height = 0;
+        uint32_t stride = 0;
+    };
+
+    // Name/value rows from a native preview provider (plugins/LumosProvider.h).
+    // Rows of a provider that declares streaming follow the preview message
+    // as Provider messages while it runs; others arrive all at once.
+    struct PreviewProvider {
+        std::string_view name;         // The provider's display name; not owned
+        uint32_t firstRow = 0;         // Index of this message's first row
+        bool complete = false;         // No more rows follow
+        bool failed = false;           // The file was malformed; the rows are what could be read
+        bool truncated = false;        // The provider hit the row limit
+        std::string_view rowsJson;     // JSON array of {"name","value"} objects; not owned
+    };
+
     struct PreviewRequest {
-        std::wstring path;
-        std::wstring extension;
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+        explicit PreviewRequest(const allocator_type& alloc = {})
+            : type(PreviewMessageType::Preview)
+            , generation(0)
+            , path(alloc)
+            , extension(alloc)
+            , size(0)
+        {
+        }
+
+        PreviewMessageType type;
+
+        // Monotonic per keypress; the UI drops anything older than the newest
+        // generation it has seen
+        uint64_t generation;
+
+        // The core instance that numbered `generation` (its PID and start
+        // time). A restarted core counts from 1 again, so the UI starts over
+        // when this changes. Preview messages only; not owned.
+        std::string_view session;
+
+        std::pmr::wstring path;
+        std::pmr::wstring extension;
         uint64_t size;
+
+        // Present for images whose header was probed in time
+        std::optional<PreviewImageInfo> image;
+
+        // Present when a preview-sized embedded JPEG was found
+        std::optional<PreviewEmbeddedImage> embeddedPreview;
+
+        // Present for Markdown documents parsed natively
+        std::optional<PreviewMarkdown> markdown;
+
+        // Present for log files shown in follow mode
+        std::optional<PreviewTail> tail;
+
+        // Present for archives, disk images and binaries
+        std::optional<PreviewHashes> hashes;
+
+        // Present for SQLite databases
+        std::optional<PreviewDatabase> database;
+
+        // Present for fonts
+        std::optional<PreviewFont> font;
+
+        // Present for files a native provider previewed
+        std::optional<PreviewProvider> provider;
         
         // Serialize to JSON string
         std::string ToJson() const;
+
+        // Serialize into a caller-owned (typically arena-backed) buffer
+        void WriteJson(std::pmr::string& out) const;
         
         // Deserialize from JSON string
         static PreviewRequest FromJson(const std::string& json);
@@ -1,39 +1,239 @@
 #include "../shared-contracts/PreviewRequest.h"
-#include <sstream>
-#include <iomanip>
-#include <Windows.h>
+#include <charconv>
+#include "common/Json.h"
+#include "common/Utf8.h"
 
 namespace Lumos {
-    std::string PreviewRequest::ToJson() const {
-        std::ostringstream oss;
-        oss << "{";
-        oss << "\"path\":\"";
-        
-        // Escape backslashes and quotes in path
-        for (wchar_t c : path) {
-            if (c == L'\\') {
-                oss << "\\\\";
-            } else if (c == L'"') {
-                oss << "\\\"";
-            } else if (c < 128) {
-                oss << static_cast<char>(c);
+    namespace {
+        void AppendNumber(std::pmr::string& out, uint64_t value) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        void AppendMarkdown(std::pmr::string& out, const std::optional<PreviewMarkdown>& markdown) {
+            if (!markdown) {
+                return;
             }
+            out.append(",\"markdown\":{\"firstBlock\":");
+            AppendNumber(out, markdown->firstBlock);
+            out.append(",\"complete\":");
+            out.append(markdown->complete ? "true" : "false");
+            out.append(",\"truncated\":");
+            out.append(markdown->truncated ? "true" : "false");
+            out.append(",\"blocks\":");
+            // Already JSON; spliced in as-is
+            out.append(markdown->blocksJson.empty() ? std::string_view("[]") : markdown->blocksJson);
+            out.push_back('}');
         }
-        
-        // Convert extension to UTF-8 using Windows API
-        int extensionSize = WideCharToMultiByte(CP_UTF8, 0, extension.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (extensionSize > 0) {
-            std::string extensionUtf8(extensionSize - 1, '\0');
-            WideCharToMultiByte(CP_UTF8, 0, extension.c_str(), -1, &extensionUtf8[0], extensionSize, nullptr, nullptr);
-            oss << "\",\"extension\":\"" << extensionUtf8 << "\"";
-        } else {
-            oss << "\",\"extension\":\"\"";
+
+        void AppendTail(std::pmr::string& out, const std::optional<PreviewTail>& tail) {
+            if (!tail) {
+                return;
+            }
+            out.append(",\"tail\":{\"truncated\":");
+            out.append(tail->truncated ? "true" : "false");
+            out.append(",\"rotated\":");
+            out.append(tail->rotated ? "true" : "false");
+            out.append(",\"fileSize\":");
+            AppendNumber(out, tail->fileSize);
+            out.append(",\"totalLines\":");
+            AppendNumber(out, tail->totalLines);
+            out.append(",\"skippedLines\":");
+            AppendNumber(out, tail->skippedLines);
+            out.append(",\"text\":");
+            AppendJsonString(out, tail->text);
+            out.push_back('}');
+        }
+
+        void AppendHashes(std::pmr::string& out, const std::optional<PreviewHashes>& hashes) {
+            if (!hashes) {
+                return;
+            }
+            out.append(",\"hashes\":{\"hashedBytes\":");
+            AppendNumber(out, hashes->hashedBytes);
+            out.append(",\"totalBytes\":");
+            AppendNumber(out, hashes->totalBytes);
+            out.append(",\"complete\":");
+            out.append(hashes->complete ? "true" : "false");
+            if (hashes->complete) {
+                // Hex digits only; nothing to escape
+                out.append(",\"xxh3\":\"").append(hashes->xxh3);
+                out.append("\",\"crc32c\":\"").append(hashes->crc32c);
+                out.append("\",\"sha1\":\"").append(hashes->sha1);
+                out.append("\",\"sha256\":\"").append(hashes->sha256);
+                out.push_back('"');
+            }
+            out.push_back('}');
+        }
+
+        void AppendDatabase(std::pmr::string& out, const std::optional<PreviewDatabase>& database) {
+            if (!database) {
+                return;
+            }
+            out.append(",\"database\":{\"complete\":");
+            out.append(database->complete ? "true" : "false");
+            if (!database->schemaJson.empty()) {
+                out.append(",\"schema\":");
+                out.append(database->schemaJson);
+            }
+            if (!database->tableJson.empty()) {
+                out.append(",\"table\":");
+                out.append(database->tableJson);
+            }
+            out.push_back('}');
+        }
+
+        void AppendFont(std::pmr::string& out, const std::optional<PreviewFont>& font) {
+            if (!font) {
+                return;
+            }
+            out.append(",\"font\":{\"family\":");
+            AppendJsonString(out, font->family);
+            out.append(",\"subfamily\":");
+            AppendJsonString(out, font->subfamily);
+            out.append(",\"fullName\":");
+            AppendJsonString(out, font->fullName);
+            out.append(",\"version\":");
+            AppendJsonString(out, font->version);
+            out.append(",\"format\":");
+            AppendJsonString(out, font->format);
+            out.append(",\"faceCount\":");
+            AppendNumber(out, font->faceCount);
+            out.append(",\"glyphCount\":");
+            AppendNumber(out, font->glyphCount);
+            out.append(",\"unitsPerEm\":");
+            AppendNumber(out, font->unitsPerEm);
+            out.append(",\"surfaceName\":");
+            AppendJsonString(out, font->surfaceName);
+            out.append(",\"width\":");
+            AppendNumber(out, font->width);
+            out.append(",\"height\":");
+            AppendNumber(out, font->height);
+            out.append(",\"stride\":");
+            AppendNumber(out, font->stride);
+            out.push_back('}');
+        }
+
+        void AppendProvider(std::pmr::string& out, const std::optional<PreviewProvider>& provider) {
+            if (!provider) {
+                return;
+            }
+            out.append(",\"provider\":{\"name\":");
+            AppendJsonString(out, provider->name);
+            out.append(",\"firstRow\":");
+            AppendNumber(out, provider->firstRow);
+            out.append(",\"complete\":");
+            out.append(provider->complete ? "true" : "false");
+            out.append(",\"failed\":");
+            out.append(provider->failed ? "true" : "false");
+            out.append(",\"truncated\":");
+            out.append(provider->truncated ? "true" : "false");
+            out.append(",\"rows\":");
+            out.append(provider->rowsJson.empty() ? std::string_view("[]") : provider->rowsJson);
+            out.push_back('}');
+        }
+    }
+
+    std::string PreviewRequest::ToJson() const {
+        std::pmr::string json;
+        WriteJson(json);
+        return std::string(json);
+    }
+
+    void PreviewRequest::WriteJson(std::pmr::string& out) const {
+        out.clear();
+        out.reserve(288 + path.size() + extension.size() + (markdown ? markdown->blocksJson.size() : 0) +
+                    (tail ? tail->text.size() + tail->text.size() / 8 : 0) + (hashes ? 256 : 0) +
+                    (database ? database->schemaJson.size() + database->tableJson.size() : 0) + (font ? 512 : 0) +
+                    (provider ? provider->name.size() + provider->rowsJson.size() + 128 : 0));
+
+        out.append("{\"type\":");
+        out.append(type == PreviewMessageType::Cancel ? "\"cancel\""
+                   : type == PreviewMessageType::Markdown ? "\"markdown\""
+                   : type == PreviewMessageType::Tail ? "\"tail\""
+                   : type == PreviewMessageType::Hashes ? "\"hashes\""
+                   : type == PreviewMessageType::Database ? "\"database\""
+                   : type == PreviewMessageType::Provider ? "\"provider\""
+                   : "\"preview\"");
+        out.append(",\"generation\":");
+        AppendNumber(out, generation);
+        if (!session.empty()) {
+            out.append(",\"session\":");
+            AppendJsonString(out, session);
+        }
+        if (type == PreviewMessageType::Cancel) {
+            out.push_back('}');
+            return;
+        }
+        if (type == PreviewMessageType::Markdown) {
+            AppendMarkdown(out, markdown);
+            out.push_back('}');
+            return;
+        }
+        if (type == PreviewMessageType::Tail) {
+            AppendTail(out, tail);
+            out.push_back('}');
+            return;
+        }
+        if (type == PreviewMessageType::Hashes) {
+            AppendHashes(out, hashes);
+            out.push_back('}');
+            return;
+        }
+        if (type == PreviewMessageType::Database) {
+            AppendDatabase(out, database);
+            out.push_back('}');
+            return;
+        }
+        if (type == PreviewMessageType::Provider) {
+            AppendProvider(out, provider);
+            out.push_back('}');
+            return;
+        }
+
+        out.append(",\"path\":");
+        AppendJsonString(out, path);
+        out.append(",\"extension\":");
+        AppendJsonString(out, extension);
+        out.append(",\"size\":");
+        AppendNumber(out, size);
+
+        if (image) {
+            out.append(",\"image\":{\"width\":");
+            AppendNumber(out, image->width);
+            out.append(",\"height\":");
+            AppendNumber(out, image->height);
+            out.append(",\"orientation\":");
+            AppendNumber(out, image->orientation);
+            out.append(",\"bitDepth\":");
+            AppendNumber(out, image->bitDepth);
+            out.append(",\"frameCount\":");
+            AppendNumber(out, image->frameCount);
+            out.append(",\"hasColorProfile\":");
+            out.append(image->hasColorProfile ? "true" : "false");
+            out.push_back('}');
+        }
+
+        if (embeddedPreview) {
+            out.append(",\"embeddedPreview\":{\"offset\":");
+            AppendNumber(out, embeddedPreview->offset);
+            out.append(",\"length\":");
+            AppendNumber(out, embeddedPreview->length);
+            out.append(",\"width\":");
+            AppendNumber(out, embeddedPreview->width);
+            out.append(",\"height\":");
+            AppendNumber(out, embeddedPreview->height);
+            out.push_back('}');
         }
-        
-        oss << ",\"size\":" << size;
-        oss << "}";
 
-        return oss.str();
+        AppendMarkdown(out, markdown);
+        AppendTail(out, tail);
+        AppendHashes(out, hashes);
+        AppendDatabase(out, database);
+        AppendFont(out, font);
+        AppendProvider(out, provider);
+        out.push_back('}');
     }
 
     PreviewRequest PreviewRequest::FromJson(const std::string& json) {
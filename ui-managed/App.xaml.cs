@@ -5,7 +5,9 @@ namespace Lumos.UI
 {
     public partial class App : Application
     {
+        private const string InstanceMutexName = "Local\\LumosUIInstance";
         private IPCServer? _ipcServer;
+        private Mutex? _instanceMutex;
 
         protected override void OnStartup(StartupEventArgs e)
         {
@@ -13,6 +15,16 @@ namespace Lumos.UI
 
             Logger.Log("Lumos UI starting up...");
 
+            // Held for the lifetime of the process; core-native checks for it to
+            // tell a live UI from a stale readiness signal
+            _instanceMutex = new Mutex(false, InstanceMutexName, out bool createdNew);
+            if (!createdNew)
+            {
+                Logger.Log("Another Lumos UI instance is already running, exiting");
+                Shutdown();
+                return;
+            }
+
             // Setup global exception handling
             AppDomain.CurrentDomain.UnhandledException += (s, args) =>
             {
@@ -46,6 +58,7 @@ namespace Lumos.UI
         protected override void OnExit(ExitEventArgs e)
         {
             _ipcServer?.Stop();
+            _instanceMutex?.Dispose();
             base.OnExit(e);
         }
     }
@@ -1,4 +1,5 @@
 using System;
+using System.Diagnostics;
 using System.Runtime.InteropServices;
 using System.Threading;
 using System.Threading.Tasks;
@@ -15,6 +16,10 @@ namespace Lumos.UI
     {
         private CancellationTokenSource? _renderCancellation;
         private readonly RendererFactory _rendererFactory;
+        private long _currentGeneration;
+        private string _session = string.Empty;  // Core-native instance that numbered _currentGeneration
+        private long _renderingGeneration = -1;
+        private IRenderer? _renderer;  // Showing _currentGeneration; continuation messages go to it
 
         public PreviewWindow()
         {
@@ -25,9 +30,25 @@ namespace Lumos.UI
 
         public async Task ShowPreview(PreviewRequest request)
         {
+            // A restarted core numbers its presses from 1 again
+            if (request.Session != _session)
+            {
+                _session = request.Session;
+                _currentGeneration = 0;
+            }
+
+            // A request can reach the dispatcher after a newer one; never let it win
+            if (request.Generation != 0 && request.Generation < _currentGeneration)
+            {
+                Logger.Log($"Ignoring stale preview for generation {request.Generation}");
+                return;
+            }
+            _currentGeneration = request.Generation;
+
             // Cancel any ongoing render
             _renderCancellation?.Cancel();
             _renderCancellation = new CancellationTokenSource();
+            var cancellation = _renderCancellation.Token;
 
             // Show loading state
             LoadingText.Visibility = Visibility.Visible;
@@ -37,7 +58,8 @@ namespace Lumos.UI
             try
             {
                 // Get appropriate renderer
-                var renderer = _rendererFactory.GetRenderer(request.Extension);
+                var renderer = _rendererFactory.GetRenderer(request);
+                _renderer = renderer;
                 if (renderer == null)
                 {
                     Logger.Log($"Unsupported file type: {request.Extension}");
@@ -47,26 +69,55 @@ namespace Lumos.UI
 
                 Logger.Log($"Using renderer: {renderer.GetType().Name}");
 
+                // The native side already probed the image header: open the
+                // window at its final size now and decode behind a placeholder
+                bool placeholderShown = false;
+                if (renderer is ImageRenderer && request.Image != null && request.Image.Width > 0 && request.Image.Height > 0)
+                {
+                    Logger.Log($"Probed image: {request.Image.Width}x{request.Image.Height}, orientation {request.Image.Orientation}");
+                    ContentPresenter.Content = ImageRenderer.CreatePlaceholder(request.Image);
+                    RevealWindow();
+                    placeholderShown = true;
+                }
+
                 // Render content
-                var content = await renderer.RenderAsync(request.Path, _renderCancellation.Token);
+                _renderingGeneration = request.Generation;
+                long renderStart = Stopwatch.GetTimestamp();
+                UIElement content;
+                try
+                {
+                    content = await renderer.RenderAsync(request, cancellation);
+                }
+                finally
+                {
+                    if (_renderingGeneration == request.Generation)
+                    {
+                        _renderingGeneration = -1;
+                    }
+                }
                 
-                if (!_renderCancellation.Token.IsCancellationRequested)
+                if (!cancellation.IsCancellationRequested)
                 {
                     LoadingText.Visibility = Visibility.Collapsed;
                     ContentPresenter.Content = content;
+                    PerformanceMetrics.RecordRender(renderer.GetType().Name, Stopwatch.GetTimestamp() - renderStart);
 
                     Logger.Log("Content rendered, positioning window...");
-                    // Position window centered on screen
-                    PositionWindowCentered();
-
-                    // Show window with fade-in animation
-                    Show();
-                    Activate(); // Ensure window is active
-                    var fadeIn = (Storyboard)Resources["FadeInAnimation"];
-                    fadeIn.Begin(this);
-                    Logger.Log("Window shown and animation started");
+                    if (placeholderShown)
+                    {
+                        // Same footprint as the placeholder; just keep it centered
+                        PositionWindowCentered();
+                    }
+                    else
+                    {
+                        RevealWindow();
+                    }
                 }
             }
+            catch (OperationCanceledException)
+            {
+                Logger.Log($"Render for generation {request.Generation} cancelled");
+            }
             catch (Exception ex)
             {
                 Logger.LogError("Error loading preview", ex);
@@ -74,6 +125,43 @@ namespace Lumos.UI
             }
         }
 
+        // Further Markdown blocks, log lines, checksums, tables or provider
+        // rows for the preview on screen. Log lines are dropped while the
+        // window is hidden.
+        public void AppendPreview(PreviewRequest message)
+        {
+            if (message.Generation != _currentGeneration || (message.Tail != null && !IsVisible))
+            {
+                return;
+            }
+            _renderer?.Append(message);
+        }
+
+        // Native side has moved on from `generation`; stop rendering it if it is
+        // still in progress. Content already on screen is left alone.
+        public void CancelPreview(long generation)
+        {
+            if (generation != _renderingGeneration || _renderCancellation == null)
+            {
+                return;
+            }
+
+            Logger.Log($"Cancelling render for generation {generation}");
+            _renderCancellation.Cancel();
+        }
+
+        // Center the window, then show it with the fade-in animation
+        private void RevealWindow()
+        {
+            PositionWindowCentered();
+
+            Show();
+            Activate(); // Ensure window is active
+            var fadeIn = (Storyboard)Resources["FadeInAnimation"];
+            fadeIn.Begin(this);
+            Logger.Log("Window shown and animation started");
+        }
+
         private void ShowError(string message)
         {
             LoadingText.Visibility = Visibility.Collapsed;
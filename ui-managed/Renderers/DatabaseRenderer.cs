@@ -0,0 +1,253 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Data;
+using System.Windows.Media;
+using Lumos.Contracts;
+
+namespace Lumos.UI.Renderers
+{
+    // SQLite databases: core-native reads the file format directly (no
+    // SQLite engine on either side) and sends the schema with the request,
+    // then the first rows of each table as they are read. This panel lists
+    // the objects and shows the selected one's rows and SQL. Keep the
+    // extensions in step with SqliteFile::HandlesExtension.
+    public class DatabaseRenderer : IRenderer
+    {
+        private static readonly string[] SupportedExtensions = { ".db", ".sqlite", ".sqlite3", ".db3", ".s3db", ".sl3" };
+
+        private readonly Dictionary<string, DatabaseTable> _tables = new Dictionary<string, DatabaseTable>();
+        private ListBox? _objects;
+        private DataGrid? _grid;
+        private TextBlock? _rowStatus;
+        private TextBox? _sql;
+        private bool _complete;
+        private long _generation = -1;
+
+        public bool CanHandle(string extension)
+        {
+            return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Database != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            var request = new PreviewRequest { Path = filePath };
+            return RenderAsync(request, cancellationToken);
+        }
+
+        // Synchronous for the same reason as MarkdownRenderer: database
+        // messages dispatched right behind the request must find the panel
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            _generation = request.Generation;
+            _tables.Clear();
+            _objects = null;
+
+            var header = new TextBlock
+            {
+                Text = Path.GetFileName(request.Path),
+                FontSize = 16,
+                FontWeight = FontWeights.Bold,
+                TextTrimming = TextTrimming.CharacterEllipsis
+            };
+
+            var schema = request.Database?.Schema;
+            if (schema == null)
+            {
+                // Not SQLite after all (Thumbs.db is a compound file) or unreadable
+                var message = new TextBlock
+                {
+                    Text = "Not a SQLite database",
+                    Foreground = Brushes.Gray,
+                    Margin = new Thickness(0, 6, 0, 0)
+                };
+                var fallback = new StackPanel { Margin = new Thickness(16) };
+                fallback.Children.Add(header);
+                fallback.Children.Add(message);
+                return Task.FromResult<UIElement>(new Border { Width = 480, Background = Brushes.White, Child = fallback });
+            }
+            _complete = request.Database!.Complete;
+
+            var summary = new TextBlock
+            {
+                Text = Summarize(schema, request.Size),
+                Foreground = Brushes.Gray,
+                Margin = new Thickness(0, 2, 0, 10),
+                TextWrapping = TextWrapping.Wrap
+            };
+
+            // Tables first, then the rest in schema order
+            _objects = new ListBox { Width = 200, Margin = new Thickness(0, 0, 10, 0) };
+            foreach (var item in schema.Objects.Where(o => o.Type == "table").Concat(schema.Objects.Where(o => o.Type != "table")))
+            {
+                _objects.Items.Add(new ListBoxItem
+                {
+                    Content = item.Type == "table" ? item.Name : $"{item.Name}  ({item.Type})",
+                    Tag = item,
+                    Foreground = item.Type == "table" ? Brushes.Black : Brushes.Gray
+                });
+            }
+            _objects.SelectionChanged += (_, _) => ShowSelected();
+
+            _grid = new DataGrid
+            {
+                IsReadOnly = true,
+                AutoGenerateColumns = false,
+                CanUserAddRows = false,
+                HeadersVisibility = DataGridHeadersVisibility.Column,
+                GridLinesVisibility = DataGridGridLinesVisibility.Vertical,
+                FontSize = 12,
+                Height = 420,
+                EnableRowVirtualization = true
+            };
+            _rowStatus = new TextBlock { Foreground = Brushes.Gray, FontSize = 11, Margin = new Thickness(0, 4, 0, 4) };
+            _sql = new TextBox
+            {
+                IsReadOnly = true,
+                BorderThickness = new Thickness(0),
+                Background = Brushes.Transparent,
+                FontFamily = new FontFamily("Consolas, Courier New"),
+                FontSize = 12,
+                TextWrapping = TextWrapping.Wrap,
+                MaxHeight = 160,
+                VerticalScrollBarVisibility = ScrollBarVisibility.Auto
+            };
+
+            var detail = new StackPanel();
+            detail.Children.Add(_grid);
+            detail.Children.Add(_rowStatus);
+            detail.Children.Add(_sql);
+
+            var body = new DockPanel();
+            DockPanel.SetDock(_objects, Dock.Left);
+            body.Children.Add(_objects);
+            body.Children.Add(detail);
+
+            var panel = new StackPanel { Margin = new Thickness(16) };
+            panel.Children.Add(header);
+            panel.Children.Add(summary);
+            panel.Children.Add(body);
+
+            if (_objects.Items.Count > 0)
+            {
+                _objects.SelectedIndex = 0;
+            }
+            else
+            {
+                _rowStatus.Text = "The database is empty";
+            }
+
+            var border = new Border { Width = 960, Background = Brushes.White, Child = panel };
+            return Task.FromResult<UIElement>(border);
+        }
+
+        public void Append(PreviewRequest message)
+        {
+            var database = message.Database;
+            if (database == null || _objects == null || message.Generation != _generation)
+            {
+                return;
+            }
+            _complete = database.Complete;
+            if (database.Table != null)
+            {
+                _tables[database.Table.Name] = database.Table;
+            }
+
+            // Rows for the table on screen, or the last word on one still waiting
+            var selected = (_objects.SelectedItem as ListBoxItem)?.Tag as DatabaseObject;
+            if (selected != null && (database.Table?.Name == selected.Name || _complete))
+            {
+                ShowSelected();
+            }
+        }
+
+        private void ShowSelected()
+        {
+            if (_objects == null || _grid == null || _rowStatus == null || _sql == null)
+            {
+                return;
+            }
+            var item = (_objects.SelectedItem as ListBoxItem)?.Tag as DatabaseObject;
+            if (item == null)
+            {
+                return;
+            }
+
+            _sql.Text = string.IsNullOrEmpty(item.Sql) ? "(created automatically for a UNIQUE or PRIMARY KEY constraint)" : item.Sql;
+            _grid.Columns.Clear();
+            _grid.ItemsSource = null;
+
+            if (item.Type != "table" || item.RootPage == 0)
+            {
+                _grid.Visibility = Visibility.Collapsed;
+                _rowStatus.Text = item.Type == "table" ? "Virtual table: rows come from its module" : string.Empty;
+                return;
+            }
+
+            _grid.Visibility = Visibility.Visible;
+            if (!_tables.TryGetValue(item.Name, out var table))
+            {
+                _rowStatus.Text = _complete ? "Rows not read: only the first tables are previewed" : "Reading rows…";
+                return;
+            }
+
+            for (int i = 0; i < table.Columns.Count; i++)
+            {
+                // Indexer paths and TextBlock headers, so column names never
+                // need escaping as binding paths or access keys
+                _grid.Columns.Add(new DataGridTextColumn
+                {
+                    Header = new TextBlock { Text = table.Columns[i] },
+                    Binding = new Binding($"[{i}]") { TargetNullValue = "NULL" },
+                    MaxWidth = 320
+                });
+            }
+            _grid.ItemsSource = table.Rows.Select(row => row.ToArray()).ToList();
+
+            _rowStatus.Text = table.Rows.Count == 0 ? "No rows"
+                : table.More ? $"First {table.Rows.Count:N0} rows"
+                : $"{table.Rows.Count:N0} rows";
+        }
+
+        private static string Summarize(DatabaseSchema schema, long size)
+        {
+            var parts = new List<string>
+            {
+                $"SQLite {FormatVersion(schema.SqliteVersion)}",
+                $"{size / (1024.0 * 1024.0):N1} MB",
+                $"{schema.PageCount:N0} pages of {schema.PageSize:N0} bytes",
+                schema.Encoding
+            };
+            if (schema.AutoVacuum)
+            {
+                parts.Add("auto-vacuum");
+            }
+            if (schema.FreelistPages > 0)
+            {
+                parts.Add($"{schema.FreelistPages:N0} free pages");
+            }
+            if (schema.Wal)
+            {
+                parts.Add("WAL: changes not yet checkpointed are not shown");
+            }
+            return string.Join(" · ", parts);
+        }
+
+        // 3045001 -> 3.45.1
+        private static string FormatVersion(long version)
+        {
+            return version > 0 ? $"{version / 1000000}.{version / 1000 % 1000}.{version % 1000}" : "3";
+        }
+    }
+}
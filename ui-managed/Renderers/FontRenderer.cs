@@ -0,0 +1,149 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Media;
+using System.Windows.Media.Imaging;
+using Lumos.Contracts;
+using Lumos.UI.Services;
+
+namespace Lumos.UI.Renderers
+{
+    // Fonts: core-native reads the file and draws the specimen (sample
+    // lines and a glyph grid) into shared memory; this panel shows it with
+    // the names from the font. WPF never loads the font itself, so a broken
+    // or hostile font cannot take the UI down. Keep the extensions in step
+    // with OpenTypeFont::HandlesExtension.
+    public class FontRenderer : IRenderer
+    {
+        private static readonly string[] SupportedExtensions = { ".ttf", ".otf", ".ttc", ".otc" };
+
+        public bool CanHandle(string extension)
+        {
+            return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Font != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            var request = new PreviewRequest { Path = filePath };
+            return RenderAsync(request, cancellationToken);
+        }
+
+        // Synchronous: the section is released on the next press, so it is
+        // copied out before anything else gets a chance to run
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            var font = request.Font;
+            var header = new TextBlock
+            {
+                Text = !string.IsNullOrEmpty(font?.FullName) ? font!.FullName : Path.GetFileName(request.Path),
+                FontSize = 16,
+                FontWeight = FontWeights.Bold,
+                TextTrimming = TextTrimming.CharacterEllipsis
+            };
+            var summary = new TextBlock
+            {
+                Text = font != null ? Summarize(font, request.Size) : "Not a font this previewer can read",
+                Foreground = Brushes.Gray,
+                Margin = new Thickness(0, 2, 0, 10),
+                TextWrapping = TextWrapping.Wrap
+            };
+
+            var panel = new StackPanel { Margin = new Thickness(16) };
+            panel.Children.Add(header);
+            panel.Children.Add(summary);
+
+            var specimen = font != null ? LoadSpecimen(font) : null;
+            if (specimen != null)
+            {
+                panel.Children.Add(new Image
+                {
+                    Source = specimen,
+                    Width = specimen.PixelWidth,
+                    Height = specimen.PixelHeight,
+                    Stretch = Stretch.None,
+                    HorizontalAlignment = HorizontalAlignment.Left
+                });
+            }
+            else if (font != null)
+            {
+                panel.Children.Add(new TextBlock
+                {
+                    Text = string.IsNullOrEmpty(font.Format) ? "No outlines to draw (bitmap-only or variable CFF2 font)" : "The specimen could not be drawn",
+                    Foreground = Brushes.Gray
+                });
+            }
+
+            var scroller = new ScrollViewer
+            {
+                Content = panel,
+                VerticalScrollBarVisibility = ScrollBarVisibility.Auto,
+                HorizontalScrollBarVisibility = ScrollBarVisibility.Disabled,
+                MaxHeight = 900
+            };
+            var border = new Border { Width = 1000, Background = Brushes.White, Child = scroller };
+            return Task.FromResult<UIElement>(border);
+        }
+
+        // Premultiplied BGRA, copied out of the native section
+        private static BitmapSource? LoadSpecimen(PreviewFont font)
+        {
+            if (string.IsNullOrEmpty(font.SurfaceName) || font.Width <= 0 || font.Height <= 0 || font.Stride < font.Width * 4)
+            {
+                return null;
+            }
+            try
+            {
+                using var section = MemoryMappedFile.OpenExisting(font.SurfaceName, MemoryMappedFileRights.Read);
+                long size = (long)font.Stride * font.Height;
+                using var view = section.CreateViewAccessor(0, size, MemoryMappedFileAccess.Read);
+                var pixels = new byte[size];
+                view.ReadArray(0, pixels, 0, pixels.Length);
+
+                var bitmap = BitmapSource.Create(font.Width, font.Height, 96, 96, PixelFormats.Pbgra32, null, pixels, font.Stride);
+                bitmap.Freeze();
+                return bitmap;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException || ex is ArgumentException)
+            {
+                // Gone already: a newer press released it
+                Logger.Log($"Font specimen unavailable: {ex.Message}");
+                return null;
+            }
+        }
+
+        private static string Summarize(PreviewFont font, long size)
+        {
+            var parts = new List<string>();
+            if (!string.IsNullOrEmpty(font.Family))
+            {
+                parts.Add(string.IsNullOrEmpty(font.Subfamily) ? font.Family : $"{font.Family} {font.Subfamily}");
+            }
+            if (!string.IsNullOrEmpty(font.Format))
+            {
+                parts.Add(font.Format);
+            }
+            parts.Add($"{font.GlyphCount:N0} glyphs");
+            parts.Add($"{font.UnitsPerEm:N0} units/em");
+            if (font.FaceCount > 1)
+            {
+                parts.Add($"collection of {font.FaceCount} fonts (first shown)");
+            }
+            parts.Add($"{size / 1024.0:N0} KB");
+            if (!string.IsNullOrEmpty(font.Version))
+            {
+                parts.Add(font.Version);
+            }
+            return string.Join(" · ", parts);
+        }
+    }
+}
@@ -1,6 +1,7 @@
 using System.Threading;
 using System.Threading.Tasks;
 using System.Windows;
+using Lumos.Contracts;
 
 namespace Lumos.UI.Renderers
 {
@@ -8,5 +9,17 @@ namespace Lumos.UI.Renderers
     {
         Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken);
         bool CanHandle(string extension);
+
+        // Claims a request by what core-native sent with it, whatever the
+        // file's extension; renderers with no native payload never do
+        bool CanRender(PreviewRequest request) => false;
+
+        Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken) =>
+            RenderAsync(request.Path, cancellationToken);
+
+        // A continuation message for the preview this renderer has on
+        // screen; ignored unless it carries this renderer's payload for the
+        // generation it rendered
+        void Append(PreviewRequest message) { }
     }
 }
@@ -4,14 +4,18 @@ using System.Threading;
 using System.Threading.Tasks;
 using System.Windows;
 using System.Windows.Controls;
+using System.Windows.Media;
 using System.Windows.Media.Imaging;
+using Lumos.Contracts;
 
 namespace Lumos.UI.Renderers
 {
     public class ImageRenderer : IRenderer
     {
         private static readonly string[] SupportedExtensions = {
-            ".jpg", ".jpeg", ".png", ".gif", ".bmp", ".webp", ".tiff", ".ico"
+            ".jpg", ".jpeg", ".png", ".gif", ".bmp", ".webp", ".tiff", ".ico",
+            // Camera RAW: shown through the embedded preview the native side locates
+            ".cr2", ".nef", ".arw", ".dng", ".orf", ".rw2"
         };
 
         private const int MaxResolution = 3840; // 4K
@@ -21,8 +25,19 @@ namespace Lumos.UI.Renderers
             return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
         }
 
-        public async Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
         {
+            return RenderAsync(new PreviewRequest { Path = filePath }, cancellationToken);
+        }
+
+        // Uses what the native side found: the EXIF orientation from the
+        // header probe (so the result matches CreatePlaceholder) and, when
+        // present, an embedded preview JPEG to decode instead of the full image
+        public async Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            var filePath = request.Path;
+            var embedded = request.EmbeddedPreview;
+
             // Load bitmap on background thread
             var bitmap = await Task.Run(() =>
             {
@@ -32,7 +47,14 @@ namespace Lumos.UI.Renderers
                 bmp.BeginInit();
                 bmp.CacheOption = BitmapCacheOption.OnLoad;
                 bmp.DecodePixelWidth = MaxResolution; // Cap resolution
-                bmp.UriSource = new Uri(filePath, UriKind.Absolute);
+                if (embedded != null)
+                {
+                    bmp.StreamSource = ReadRange(filePath, embedded.Offset, embedded.Length);
+                }
+                else
+                {
+                    bmp.UriSource = new Uri(filePath, UriKind.Absolute);
+                }
                 bmp.EndInit();
                 bmp.Freeze(); // Make thread-safe
 
@@ -42,18 +64,89 @@ namespace Lumos.UI.Renderers
             }, cancellationToken);
 
             // Create Image control on UI thread (this method is called from UI thread via Dispatcher)
-            var screenWidth = SystemParameters.PrimaryScreenWidth;
-            var screenHeight = SystemParameters.PrimaryScreenHeight;
-
             var image = new Image
             {
-                MaxWidth = screenWidth * 0.5,
-                MaxHeight = screenHeight * 0.5,
-                Stretch = System.Windows.Media.Stretch.Uniform,
+                Stretch = Stretch.Uniform,
                 Source = bitmap
             };
+            ApplyLayout(image, request.Image?.Orientation ?? 1);
 
             return image;
         }
+
+        // Just the embedded JPEG's bytes; the rest of the file is never read
+        private static MemoryStream ReadRange(string filePath, long offset, long length)
+        {
+            var buffer = new byte[length];
+            using (var stream = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite | FileShare.Delete,
+                                               4096, FileOptions.RandomAccess))
+            {
+                stream.Seek(offset, SeekOrigin.Begin);
+                stream.ReadExactly(buffer, 0, buffer.Length);
+            }
+            return new MemoryStream(buffer, writable: false);
+        }
+
+        // Stand-in with the footprint RenderAsync will produce, built from the
+        // probed header before any pixels are decoded
+        public static UIElement CreatePlaceholder(PreviewImageInfo info)
+        {
+            // RenderAsync decodes to MaxResolution wide; mirror that aspect
+            var height = (double)MaxResolution * info.Height / Math.Max(info.Width, 1);
+            var placeholder = new Viewbox
+            {
+                Stretch = Stretch.Uniform,
+                Child = new Border
+                {
+                    Width = MaxResolution,
+                    Height = height,
+                    Background = new SolidColorBrush(Color.FromRgb(228, 228, 228))
+                }
+            };
+            ApplyLayout(placeholder, info.Orientation);
+
+            return placeholder;
+        }
+
+        private static void ApplyLayout(FrameworkElement element, int orientation)
+        {
+            var screenWidth = SystemParameters.PrimaryScreenWidth;
+            var screenHeight = SystemParameters.PrimaryScreenHeight;
+
+            // Limits apply before the layout transform, so swap them for quarter turns
+            bool quarterTurn = orientation >= 5 && orientation <= 8;
+            element.MaxWidth = (quarterTurn ? screenHeight : screenWidth) * 0.5;
+            element.MaxHeight = (quarterTurn ? screenWidth : screenHeight) * 0.5;
+
+            var transform = OrientationTransform(orientation);
+            if (transform != null)
+            {
+                element.LayoutTransform = transform;
+            }
+        }
+
+        // EXIF orientation 2-8 as a layout transform (WPF decoders ignore the tag)
+        private static Transform? OrientationTransform(int orientation)
+        {
+            switch (orientation)
+            {
+                case 2: return new ScaleTransform(-1, 1);
+                case 3: return new RotateTransform(180);
+                case 4: return new ScaleTransform(1, -1);
+                case 5: return Combine(new ScaleTransform(-1, 1), new RotateTransform(270));
+                case 6: return new RotateTransform(90);
+                case 7: return Combine(new ScaleTransform(-1, 1), new RotateTransform(90));
+                case 8: return new RotateTransform(270);
+                default: return null;
+            }
+        }
+
+        private static Transform Combine(Transform first, Transform second)
+        {
+            var group = new TransformGroup();
+            group.Children.Add(first);
+            group.Children.Add(second);
+            return group;
+        }
     }
 }
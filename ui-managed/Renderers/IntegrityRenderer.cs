@@ -0,0 +1,165 @@
+using System;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Media;
+using Lumos.Contracts;
+
+namespace Lumos.UI.Renderers
+{
+    // Archives, disk images and binaries: nothing to look at, but their
+    // checksums are what people open them for. core-native hashes the file
+    // (xxHash3, CRC32C, SHA-1 and SHA-256 in one pass) and streams progress;
+    // this panel only shows it. Keep the extensions in step with
+    // FileHasher::HandlesExtension.
+    public class IntegrityRenderer : IRenderer
+    {
+        private static readonly string[] SupportedExtensions =
+        {
+            ".iso", ".img", ".dmg", ".vhd", ".vhdx", ".vmdk", ".qcow2",
+            ".zip", ".7z", ".rar", ".tar", ".gz", ".tgz", ".bz2", ".xz", ".zst",
+            ".exe", ".msi", ".msix", ".appx", ".dll", ".sys", ".bin", ".apk", ".deb", ".rpm"
+        };
+
+        private ProgressBar? _progress;
+        private TextBlock? _status;
+        private StackPanel? _digests;
+        private long _generation = -1;
+
+        public bool CanHandle(string extension)
+        {
+            return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Hashes != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            var request = new PreviewRequest { Path = filePath };
+            return RenderAsync(request, cancellationToken);
+        }
+
+        // Synchronous for the same reason as MarkdownRenderer: hashes messages
+        // dispatched right behind the request must find the panel
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            _generation = request.Generation;
+
+            var header = new TextBlock
+            {
+                Text = Path.GetFileName(request.Path),
+                FontSize = 16,
+                FontWeight = FontWeights.Bold,
+                TextTrimming = TextTrimming.CharacterEllipsis
+            };
+            var size = new TextBlock
+            {
+                Text = $"{request.Size:N0} bytes",
+                Foreground = Brushes.Gray,
+                Margin = new Thickness(0, 2, 0, 10)
+            };
+
+            _progress = new ProgressBar { Height = 6, Minimum = 0, Maximum = 1 };
+            _status = new TextBlock { Foreground = Brushes.Gray, FontSize = 11, Margin = new Thickness(0, 4, 0, 0) };
+            _digests = new StackPanel();
+
+            var panel = new StackPanel { Margin = new Thickness(16) };
+            panel.Children.Add(header);
+            panel.Children.Add(size);
+            panel.Children.Add(_progress);
+            panel.Children.Add(_status);
+            panel.Children.Add(_digests);
+
+            if (request.Hashes != null)
+            {
+                Update(request.Hashes);
+            }
+            else
+            {
+                _progress.Visibility = Visibility.Collapsed;
+                _status.Text = "Checksums unavailable: the file could not be read";
+            }
+
+            var border = new Border { Width = 640, Background = Brushes.White, Child = panel };
+            return Task.FromResult<UIElement>(border);
+        }
+
+        public void Append(PreviewRequest message)
+        {
+            var hashes = message.Hashes;
+            if (hashes == null || _digests == null || message.Generation != _generation)
+            {
+                return;
+            }
+            Update(hashes);
+        }
+
+        private void Update(PreviewHashes hashes)
+        {
+            if (_progress == null || _status == null || _digests == null)
+            {
+                return;
+            }
+
+            if (!hashes.Complete)
+            {
+                double fraction = hashes.TotalBytes > 0 ? (double)hashes.HashedBytes / hashes.TotalBytes : 0;
+                _progress.Value = fraction;
+                _status.Text = $"Hashing… {fraction:P0} of {hashes.TotalBytes / (1024.0 * 1024.0):N0} MB";
+                return;
+            }
+
+            _progress.Visibility = Visibility.Collapsed;
+            _status.Visibility = Visibility.Collapsed;
+            _digests.Children.Clear();
+            AddDigest("SHA-256", hashes.Sha256);
+            AddDigest("SHA-1", hashes.Sha1);
+            AddDigest("CRC32C", hashes.Crc32c);
+            AddDigest("XXH3", hashes.Xxh3);
+        }
+
+        private void AddDigest(string name, string hex)
+        {
+            var label = new TextBlock
+            {
+                Text = name,
+                Width = 64,
+                Foreground = Brushes.Gray,
+                VerticalAlignment = VerticalAlignment.Center
+            };
+            // Selectable so part of a digest can be compared by eye or copied
+            var value = new TextBox
+            {
+                Text = hex,
+                IsReadOnly = true,
+                BorderThickness = new Thickness(0),
+                Background = Brushes.Transparent,
+                FontFamily = new FontFamily("Consolas, Courier New"),
+                FontSize = 12,
+                TextWrapping = TextWrapping.Wrap,
+                VerticalAlignment = VerticalAlignment.Center
+            };
+            var copy = new Button
+            {
+                Content = "Copy",
+                Padding = new Thickness(8, 1, 8, 1),
+                Margin = new Thickness(8, 0, 0, 0),
+                VerticalAlignment = VerticalAlignment.Center
+            };
+            copy.Click += (_, _) => Clipboard.SetText(hex);
+
+            var row = new DockPanel { Margin = new Thickness(0, 6, 0, 0) };
+            DockPanel.SetDock(label, Dock.Left);
+            DockPanel.SetDock(copy, Dock.Right);
+            row.Children.Add(label);
+            row.Children.Add(copy);
+            row.Children.Add(value);
+            _digests.Children.Add(row);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+using System;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Media;
+using Lumos.Contracts;
+
+namespace Lumos.UI.Renderers
+{
+    // Log files in follow mode: core-native sends the last lines with the
+    // request and then only what gets appended, so the file is never read
+    // here and the view stays live while the preview is open
+    public class LogRenderer : IRenderer
+    {
+        private static readonly string[] SupportedExtensions = { ".log" };
+
+        // Oldest text is dropped beyond this, like TextRenderer's 10000 lines
+        private const int MaxChars = 2 * 1024 * 1024;
+
+        private readonly TextRenderer _fallback = new TextRenderer();
+
+        private TextBox? _textBox;
+        private TextBlock? _status;
+        private long _generation = -1;
+
+        public bool CanHandle(string extension)
+        {
+            return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Tail != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            return _fallback.RenderAsync(filePath, cancellationToken);
+        }
+
+        // Synchronous for the same reason as MarkdownRenderer: tail messages
+        // dispatched right behind the request must find the text box
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            if (request.Tail == null)
+            {
+                _textBox = null;
+                return _fallback.RenderAsync(request.Path, cancellationToken);
+            }
+
+            _generation = request.Generation;
+            _textBox = new TextBox
+            {
+                Text = request.Tail.Text,
+                IsReadOnly = true,
+                TextWrapping = TextWrapping.NoWrap,
+                VerticalScrollBarVisibility = ScrollBarVisibility.Auto,
+                HorizontalScrollBarVisibility = ScrollBarVisibility.Auto,
+                FontFamily = new FontFamily("Consolas, Courier New"),
+                FontSize = 12,
+                Padding = new Thickness(10),
+                MaxWidth = 1000,
+                MaxHeight = 800,
+                Background = Brushes.White,
+                BorderThickness = new Thickness(0)
+            };
+            _textBox.Loaded += (_, _) => _textBox?.ScrollToEnd();
+
+            _status = new TextBlock
+            {
+                Foreground = Brushes.Gray,
+                FontSize = 11,
+                Margin = new Thickness(10, 4, 10, 6)
+            };
+            UpdateStatus(request.Tail);
+
+            var panel = new DockPanel { Background = Brushes.White };
+            DockPanel.SetDock(_status, Dock.Bottom);
+            panel.Children.Add(_status);
+            panel.Children.Add(_textBox);
+            return Task.FromResult<UIElement>(panel);
+        }
+
+        public void Append(PreviewRequest message)
+        {
+            var tail = message.Tail;
+            if (tail == null || _textBox == null || message.Generation != _generation)
+            {
+                return;
+            }
+
+            // Only follow the end if the user has not scrolled up to read
+            bool atEnd = _textBox.VerticalOffset + _textBox.ViewportHeight >= _textBox.ExtentHeight - 1;
+
+            if (tail.Truncated)
+            {
+                _textBox.Clear();
+            }
+            if (tail.Rotated)
+            {
+                _textBox.AppendText("──── log rotated ────\n");
+            }
+            if (tail.SkippedLines > 0)
+            {
+                _textBox.AppendText($"… {tail.SkippedLines:N0} lines skipped …\n");
+            }
+            _textBox.AppendText(tail.Text);
+
+            if (_textBox.Text.Length > MaxChars)
+            {
+                int cut = _textBox.Text.IndexOf('\n', _textBox.Text.Length - MaxChars);
+                _textBox.Text = _textBox.Text.Substring(cut < 0 ? _textBox.Text.Length - MaxChars : cut + 1);
+            }
+            if (atEnd)
+            {
+                _textBox.ScrollToEnd();
+            }
+            UpdateStatus(tail);
+        }
+
+        private void UpdateStatus(PreviewTail tail)
+        {
+            if (_status == null)
+            {
+                return;
+            }
+            var lines = tail.TotalLines > 0 ? $"{tail.TotalLines:N0} lines · " : string.Empty;
+            _status.Text = $"Following · {lines}{tail.FileSize / 1024.0:N0} KB";
+        }
+    }
+}
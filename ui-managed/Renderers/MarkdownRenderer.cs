@@ -0,0 +1,277 @@
+using System;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Documents;
+using System.Windows.Media;
+using Lumos.Contracts;
+using Lumos.UI.Services;
+
+namespace Lumos.UI.Renderers
+{
+    // Lays out the blocks core-native already parsed; no Markdown parsing
+    // happens here. The first chunk arrives with the preview request and the
+    // rest are appended as markdown messages come in.
+    public class MarkdownRenderer : IRenderer
+    {
+        private static readonly string[] SupportedExtensions = { ".md", ".markdown" };
+
+        private static readonly FontFamily CodeFont = new FontFamily("Consolas, Courier New");
+        private static readonly Brush CodeBackground = new SolidColorBrush(Color.FromRgb(0xF4, 0xF4, 0xF4));
+        private static readonly Brush QuoteBorder = new SolidColorBrush(Color.FromRgb(0xD0, 0xD7, 0xDE));
+        private static readonly Brush MutedText = new SolidColorBrush(Color.FromRgb(0x57, 0x60, 0x6A));
+        private static readonly double[] HeadingSizes = { 26, 22, 18, 16, 14, 13 };
+
+        private const double IndentPerLevel = 22;
+
+        private readonly TextRenderer _fallback = new TextRenderer();
+
+        // Document being filled for the current generation
+        private FlowDocument? _document;
+        private Table? _table;
+        private long _generation = -1;
+        private int _nextBlock;
+
+        public bool CanHandle(string extension)
+        {
+            return Array.Exists(SupportedExtensions, ext => ext.Equals(extension, StringComparison.OrdinalIgnoreCase));
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Markdown != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            return _fallback.RenderAsync(filePath, cancellationToken);
+        }
+
+        // Builds the viewer synchronously from the first chunk, so chunks
+        // dispatched right behind the request always find the document
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            if (request.Markdown == null)
+            {
+                // Native parse unavailable (e.g. file vanished): show the source
+                _document = null;
+                return _fallback.RenderAsync(request.Path, cancellationToken);
+            }
+
+            _document = new FlowDocument
+            {
+                FontFamily = new FontFamily("Segoe UI"),
+                FontSize = 14,
+                PagePadding = new Thickness(24, 16, 24, 16),
+                Background = Brushes.White
+            };
+            _table = null;
+            _generation = request.Generation;
+            _nextBlock = 0;
+            Append(request.Generation, request.Markdown);
+
+            UIElement viewer = new FlowDocumentScrollViewer
+            {
+                Document = _document,
+                Width = 860,
+                MaxHeight = 800,
+                VerticalScrollBarVisibility = ScrollBarVisibility.Auto,
+                IsToolBarVisible = false
+            };
+            return Task.FromResult(viewer);
+        }
+
+        public void Append(PreviewRequest message)
+        {
+            var chunk = message.Markdown;
+            if (chunk == null || _document == null || message.Generation != _generation)
+            {
+                return;
+            }
+            if (chunk.FirstBlock != _nextBlock)
+            {
+                Logger.Log($"Markdown chunk out of sequence (expected block {_nextBlock}, got {chunk.FirstBlock})");
+                return;
+            }
+
+            foreach (var block in chunk.Blocks)
+            {
+                AddBlock(block);
+            }
+            _nextBlock += chunk.Blocks.Count;
+
+            if (chunk.Truncated)
+            {
+                _table = null;
+                _document.Blocks.Add(new Paragraph(new Run("… (document truncated)"))
+                {
+                    Foreground = MutedText,
+                    FontStyle = FontStyles.Italic
+                });
+            }
+        }
+
+        private void AddBlock(MarkdownBlock block)
+        {
+            if (block.Kind == "row")
+            {
+                AddRow(block);
+                return;
+            }
+            _table = null;
+
+            Block element;
+            switch (block.Kind)
+            {
+                case "heading":
+                    var heading = new Paragraph
+                    {
+                        FontSize = HeadingSizes[Math.Clamp(block.Level, 1, 6) - 1],
+                        FontWeight = FontWeights.SemiBold,
+                        Margin = new Thickness(0, 12, 0, 6)
+                    };
+                    AddInlines(heading.Inlines, block, 0);
+                    element = heading;
+                    break;
+
+                case "code":
+                case "html":
+                    element = new Paragraph(new Run(block.Runs.Count > 0 ? block.Runs[0].Text : string.Empty))
+                    {
+                        FontFamily = CodeFont,
+                        FontSize = 12,
+                        Background = CodeBackground,
+                        Padding = new Thickness(8)
+                    };
+                    break;
+
+                case "rule":
+                    element = new BlockUIContainer(new Separator { Margin = new Thickness(0, 8, 0, 8) });
+                    break;
+
+                default:
+                    var paragraph = new Paragraph { Margin = new Thickness(0, 0, 0, 8) };
+                    AddInlines(paragraph.Inlines, block, 0);
+                    element = paragraph;
+                    break;
+            }
+
+            ApplyContainers(element, block);
+            _document!.Blocks.Add(element);
+        }
+
+        // Quotes and lists are not nodes; indent by depth and draw the marker
+        // on the first block of each item
+        private static void ApplyContainers(Block element, MarkdownBlock block)
+        {
+            double indent = (block.QuoteDepth + block.ListDepth) * IndentPerLevel;
+            var margin = element.Margin;
+            element.Margin = new Thickness(indent, margin.Top, margin.Right, margin.Bottom);
+
+            if (block.QuoteDepth > 0)
+            {
+                element.BorderBrush = QuoteBorder;
+                element.BorderThickness = new Thickness(3, 0, 0, 0);
+                element.Padding = new Thickness(10, element.Padding.Top, element.Padding.Right, element.Padding.Bottom);
+                element.Foreground = MutedText;
+            }
+
+            if (block.ListItemStart && element is Paragraph paragraph)
+            {
+                var marker = block.ListOrdered ? $"{block.ListNumber}. " : "• ";
+                var first = paragraph.Inlines.FirstInline;
+                if (first != null)
+                {
+                    paragraph.Inlines.InsertBefore(first, new Run(marker));
+                }
+                else
+                {
+                    paragraph.Inlines.Add(new Run(marker));
+                }
+                paragraph.TextIndent = -IndentPerLevel * 0.7;
+                paragraph.Margin = new Thickness(paragraph.Margin.Left + IndentPerLevel * 0.7, paragraph.Margin.Top,
+                                                 paragraph.Margin.Right, paragraph.Margin.Bottom);
+            }
+        }
+
+        private void AddRow(MarkdownBlock block)
+        {
+            if (_table == null || block.TableHeader)
+            {
+                _table = new Table { CellSpacing = 0, Margin = new Thickness(block.QuoteDepth * IndentPerLevel, 4, 0, 8) };
+                for (int i = 0; i < block.CellCount; i++)
+                {
+                    _table.Columns.Add(new TableColumn());
+                }
+                _table.RowGroups.Add(new TableRowGroup());
+                _document!.Blocks.Add(_table);
+            }
+
+            var row = new TableRow();
+            for (int cell = 0; cell < block.CellCount; cell++)
+            {
+                var paragraph = new Paragraph { Margin = new Thickness(0) };
+                if (block.TableHeader)
+                {
+                    paragraph.FontWeight = FontWeights.SemiBold;
+                }
+                int align = AddInlines(paragraph.Inlines, block, cell);
+                paragraph.TextAlignment = align == 2 ? TextAlignment.Center
+                                        : align == 3 ? TextAlignment.Right
+                                        : TextAlignment.Left;
+                row.Cells.Add(new TableCell(paragraph)
+                {
+                    BorderBrush = QuoteBorder,
+                    BorderThickness = new Thickness(0.5),
+                    Padding = new Thickness(6, 3, 6, 3)
+                });
+            }
+            _table.RowGroups[0].Rows.Add(row);
+        }
+
+        // Adds the runs of one table cell (or of the whole block when it is
+        // not a row); returns the cell's alignment
+        private static int AddInlines(InlineCollection inlines, MarkdownBlock block, int cell)
+        {
+            int align = 0;
+            foreach (var run in block.Runs)
+            {
+                if (run.Cell != cell)
+                {
+                    continue;
+                }
+                align = run.Align;
+
+                if (run.Style.HasFlag(MarkdownStyle.LineBreak))
+                {
+                    inlines.Add(new LineBreak());
+                    continue;
+                }
+
+                Inline inline = run.Style.HasFlag(MarkdownStyle.Image)
+                    ? new Run($"[{run.Text}]") { Foreground = MutedText }
+                    : new Run(run.Text);
+                if (run.Style.HasFlag(MarkdownStyle.Strong)) inline.FontWeight = FontWeights.Bold;
+                if (run.Style.HasFlag(MarkdownStyle.Emphasis)) inline.FontStyle = FontStyles.Italic;
+                if (run.Style.HasFlag(MarkdownStyle.Strikethrough)) inline.TextDecorations = TextDecorations.Strikethrough;
+                if (run.Style.HasFlag(MarkdownStyle.Code))
+                {
+                    inline.FontFamily = CodeFont;
+                    inline.Background = CodeBackground;
+                }
+                if (run.Style.HasFlag(MarkdownStyle.Link) && !run.Style.HasFlag(MarkdownStyle.Image))
+                {
+                    // Clicking closes the preview, so links are shown, not followed
+                    inline = new Hyperlink(inline) { ToolTip = run.Link };
+                }
+                else if (run.Link != null)
+                {
+                    inline.ToolTip = run.Link;
+                }
+                inlines.Add(inline);
+            }
+            return align;
+        }
+    }
+}
@@ -0,0 +1,163 @@
+using System;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+using System.Windows;
+using System.Windows.Controls;
+using System.Windows.Media;
+using Lumos.Contracts;
+using Lumos.UI.Services;
+
+namespace Lumos.UI.Renderers
+{
+    // Formats added by native preview providers (core-native/plugins): the
+    // provider reads the file in core-native and sends name/value rows,
+    // which this panel lays out as a property sheet. Chosen by the provider
+    // payload on the request, never by extension, since the UI cannot know
+    // which providers are installed.
+    public class ProviderRenderer : IRenderer
+    {
+        private Grid? _rows;
+        private TextBlock? _status;
+        private long _generation = -1;
+
+        public bool CanHandle(string extension)
+        {
+            return false;
+        }
+
+        public bool CanRender(PreviewRequest request)
+        {
+            return request.Provider != null;
+        }
+
+        public Task<UIElement> RenderAsync(string filePath, CancellationToken cancellationToken)
+        {
+            var request = new PreviewRequest { Path = filePath };
+            return RenderAsync(request, cancellationToken);
+        }
+
+        // Synchronous for the same reason as MarkdownRenderer: provider
+        // messages dispatched right behind the request must find the panel
+        public Task<UIElement> RenderAsync(PreviewRequest request, CancellationToken cancellationToken)
+        {
+            _generation = request.Generation;
+
+            var header = new TextBlock
+            {
+                Text = Path.GetFileName(request.Path),
+                FontSize = 16,
+                FontWeight = FontWeights.Bold,
+                TextTrimming = TextTrimming.CharacterEllipsis
+            };
+            var summary = new TextBlock
+            {
+                Text = request.Provider != null
+                    ? $"{request.Provider.Name} · {request.Size / 1024.0:N0} KB"
+                    : $"{request.Size / 1024.0:N0} KB",
+                Foreground = Brushes.Gray,
+                Margin = new Thickness(0, 2, 0, 10)
+            };
+
+            _rows = new Grid();
+            _rows.ColumnDefinitions.Add(new ColumnDefinition { Width = GridLength.Auto });
+            _rows.ColumnDefinitions.Add(new ColumnDefinition { Width = new GridLength(1, GridUnitType.Star) });
+            _status = new TextBlock { Foreground = Brushes.Gray, FontSize = 11, Margin = new Thickness(0, 8, 0, 0) };
+
+            var panel = new StackPanel { Margin = new Thickness(16) };
+            panel.Children.Add(header);
+            panel.Children.Add(summary);
+            panel.Children.Add(_rows);
+            panel.Children.Add(_status);
+
+            if (request.Provider != null)
+            {
+                Update(request.Provider);
+            }
+            else
+            {
+                _status.Text = "Nothing to show";
+            }
+
+            var scroller = new ScrollViewer
+            {
+                Content = panel,
+                VerticalScrollBarVisibility = ScrollBarVisibility.Auto,
+                HorizontalScrollBarVisibility = ScrollBarVisibility.Disabled,
+                MaxHeight = 800
+            };
+            var border = new Border { Width = 640, Background = Brushes.White, Child = scroller };
+            return Task.FromResult<UIElement>(border);
+        }
+
+        public void Append(PreviewRequest message)
+        {
+            var provider = message.Provider;
+            if (provider == null || _rows == null || message.Generation != _generation)
+            {
+                return;
+            }
+            Update(provider);
+        }
+
+        private void Update(PreviewProvider provider)
+        {
+            if (_rows == null || _status == null)
+            {
+                return;
+            }
+
+            // Rows arrive in order; a batch that does not continue where the
+            // last one stopped was lost to a dropped message
+            if (provider.FirstRow != _rows.RowDefinitions.Count)
+            {
+                Logger.Log($"Provider rows out of step: expected {_rows.RowDefinitions.Count}, got {provider.FirstRow}");
+            }
+            foreach (var row in provider.Rows)
+            {
+                AddRow(row);
+            }
+
+            _status.Text = !provider.Complete ? "Reading…"
+                : provider.Failed ? $"{provider.Name} could not read all of this file"
+                : provider.Truncated ? $"Showing the first {_rows.RowDefinitions.Count:N0} rows"
+                : string.Empty;
+            _status.Visibility = string.IsNullOrEmpty(_status.Text) ? Visibility.Collapsed : Visibility.Visible;
+        }
+
+        private void AddRow(ProviderRow row)
+        {
+            if (_rows == null)
+            {
+                return;
+            }
+
+            int index = _rows.RowDefinitions.Count;
+            _rows.RowDefinitions.Add(new RowDefinition { Height = GridLength.Auto });
+
+            var name = new TextBlock
+            {
+                Text = row.Name,
+                Foreground = Brushes.Gray,
+                Margin = new Thickness(0, 3, 16, 3),
+                VerticalAlignment = VerticalAlignment.Top
+            };
+            // Selectable so values can be copied
+            var value = new TextBox
+            {
+                Text = row.Value,
+                IsReadOnly = true,
+                BorderThickness = new Thickness(0),
+                Background = Brushes.Transparent,
+                TextWrapping = TextWrapping.Wrap,
+                Margin = new Thickness(0, 3, 0, 3)
+            };
+            Grid.SetRow(name, index);
+            Grid.SetColumn(name, 0);
+            Grid.SetRow(value, index);
+            Grid.SetColumn(value, 1);
+            _rows.Children.Add(name);
+            _rows.Children.Add(value);
+        }
+    }
+}
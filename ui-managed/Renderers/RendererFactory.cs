@@ -1,6 +1,7 @@
 using System;
 using System.Collections.Generic;
 using System.Linq;
+using Lumos.Contracts;
 
 namespace Lumos.UI.Renderers
 {
@@ -8,24 +9,48 @@ namespace Lumos.UI.Renderers
     {
         private readonly List<IRenderer> _renderers;
 
+        // Each extension is resolved once by the ordered scan below (first
+        // match wins), then answered from here
+        private readonly Dictionary<string, IRenderer?> _byExtension =
+            new Dictionary<string, IRenderer?>(StringComparer.OrdinalIgnoreCase);
+
         public RendererFactory()
         {
             _renderers = new List<IRenderer>
             {
+                new ProviderRenderer(),
                 new ImageRenderer(),
+                new MarkdownRenderer(),
+                new LogRenderer(),
                 new TextRenderer(),
                 new PDFRenderer(),
                 new AudioRenderer(),
                 new VideoRenderer(),
                 new FolderRenderer(),
-                new OfficeRenderer()
+                new OfficeRenderer(),
+                new IntegrityRenderer(),
+                new DatabaseRenderer(),
+                new FontRenderer()
             };
         }
 
         public IRenderer? GetRenderer(string extension)
         {
-            extension = extension.ToLowerInvariant();
-            return _renderers.FirstOrDefault(r => r.CanHandle(extension));
+            if (!_byExtension.TryGetValue(extension, out var renderer))
+            {
+                var lower = extension.ToLowerInvariant();
+                renderer = _renderers.FirstOrDefault(r => r.CanHandle(lower));
+                _byExtension[extension] = renderer;
+            }
+            return renderer;
+        }
+
+        // What core-native sent with the request picks the renderer first:
+        // it matched those files by their contents, so their extension may
+        // be anything (or nothing). The rest go by extension.
+        public IRenderer? GetRenderer(PreviewRequest request)
+        {
+            return _renderers.FirstOrDefault(r => r.CanRender(request)) ?? GetRenderer(request.Extension);
         }
     }
 }
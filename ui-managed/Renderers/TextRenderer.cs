@@ -12,7 +12,7 @@ namespace Lumos.UI.Renderers
     public class TextRenderer : IRenderer
     {
         private static readonly string[] SupportedExtensions = {
-            ".txt", ".md", ".json", ".xml", ".log", ".cs", ".cpp", ".h", ".hpp",
+            ".txt", ".json", ".xml", ".cs", ".cpp", ".h", ".hpp",
             ".py", ".js", ".ts", ".html", ".css", ".yaml", ".yml", ".ini", ".cfg"
         };
 
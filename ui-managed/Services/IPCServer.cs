@@ -13,8 +13,17 @@ namespace Lumos.UI.Services
     public class IPCServer
     {
         private const string PipeName = "LumosPreview";
+        private const string ReadyEventName = "Local\\LumosUIReady";
         private CancellationTokenSource? _cancellationTokenSource;
         private Task? _serverTask;
+        private EventWaitHandle? _readyEvent;
+
+        // Newest generation seen so far; anything older is stale by definition
+        private long _latestGeneration;
+
+        // Core-native instance that numbered _latestGeneration. The UI
+        // outlives a core crash or restart, and the new core counts from 1.
+        private string _session = string.Empty;
 
         public void Start()
         {
@@ -26,6 +35,85 @@ namespace Lumos.UI.Services
         {
             _cancellationTokenSource?.Cancel();
             _serverTask?.Wait(TimeSpan.FromSeconds(2));
+            _readyEvent?.Reset();
+            _readyEvent?.Dispose();
+        }
+
+        // Tell core-native that the pipe is listening so it can stop waiting
+        // and send its first request (replaces the old fixed startup sleep)
+        private void SignalReady()
+        {
+            if (_readyEvent != null)
+            {
+                return;
+            }
+
+            try
+            {
+                _readyEvent = new EventWaitHandle(false, EventResetMode.ManualReset, ReadyEventName);
+                _readyEvent.Set();
+                Logger.Log("Signalled readiness to core-native");
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("Failed to signal readiness", ex);
+            }
+        }
+
+        private void Dispatch(PreviewRequest request)
+        {
+            if (request.Type == PreviewRequest.CancelType)
+            {
+                Application.Current.Dispatcher.InvokeAsync(() =>
+                {
+                    (Application.Current.MainWindow as PreviewWindow)?.CancelPreview(request.Generation);
+                });
+                return;
+            }
+
+            if (request.Type == PreviewRequest.MarkdownType || request.Type == PreviewRequest.TailType ||
+                request.Type == PreviewRequest.HashesType || request.Type == PreviewRequest.DatabaseType ||
+                request.Type == PreviewRequest.ProviderType)
+            {
+                // Continuation of a preview already shown; never a new generation
+                if (request.Generation != Interlocked.Read(ref _latestGeneration))
+                {
+                    return;
+                }
+                Application.Current.Dispatcher.InvokeAsync(() =>
+                {
+                    (Application.Current.MainWindow as PreviewWindow)?.AppendPreview(request);
+                });
+                return;
+            }
+
+            if (request.Session != _session)
+            {
+                Logger.Log($"core-native session {request.Session} started; generations count from 1 again");
+                _session = request.Session;
+                Interlocked.Exchange(ref _latestGeneration, 0);
+            }
+            if (request.Generation != 0 && request.Generation < Interlocked.Read(ref _latestGeneration))
+            {
+                Logger.Log($"Dropping stale request for generation {request.Generation}");
+                return;
+            }
+            Interlocked.Exchange(ref _latestGeneration, request.Generation);
+
+            // Fire and forget: the loop goes straight back to accepting the next
+            // message, so a newer request never waits behind an older render
+            Application.Current.Dispatcher.InvokeAsync(async () =>
+            {
+                Logger.Log("Dispatched to UI thread");
+                var window = Application.Current.MainWindow as PreviewWindow;
+                Logger.Log($"MainWindow is PreviewWindow: {window != null}");
+                if (window != null)
+                {
+                    Logger.Log("Calling ShowPreview...");
+                    await window.ShowPreview(request);
+                    Logger.Log("ShowPreview completed");
+                }
+            });
         }
 
         private async Task ServerLoop(CancellationToken cancellationToken)
@@ -42,6 +130,9 @@ namespace Lumos.UI.Services
                         PipeOptions.Asynchronous
                     );
 
+                    // The first instance exists, so clients can connect from now on
+                    SignalReady();
+
                     // Wait for client connection
                     await pipeServer.WaitForConnectionAsync(cancellationToken);
                     Logger.Log("Client connected to pipe");
@@ -49,7 +140,7 @@ namespace Lumos.UI.Services
                     // Read message
                     using var reader = new StreamReader(pipeServer, Encoding.UTF8);
                     var json = await reader.ReadToEndAsync();
-                    Logger.Log($"Received JSON: {json}");
+                    Logger.Log(json.Length > 512 ? $"Received JSON ({json.Length} chars)" : $"Received JSON: {json}");
 
                     if (!string.IsNullOrEmpty(json))
                     {
@@ -59,22 +150,10 @@ namespace Lumos.UI.Services
                             PropertyNameCaseInsensitive = true
                         };
                         var request = JsonSerializer.Deserialize<PreviewRequest>(json, options);
-                        Logger.Log($"Deserialized request - Path: {request?.Path}, Extension: {request?.Extension}");
+                        Logger.Log($"Deserialized request - Type: {request?.Type}, Generation: {request?.Generation}, Path: {request?.Path}, Extension: {request?.Extension}");
                         if (request != null)
                         {
-                            // Dispatch to UI thread
-                            await Application.Current.Dispatcher.InvokeAsync(async () =>
-                            {
-                                Logger.Log("Dispatched to UI thread");
-                                var window = Application.Current.MainWindow as PreviewWindow;
-                                Logger.Log($"MainWindow is PreviewWindow: {window != null}");
-                                if (window != null)
-                                {
-                                    Logger.Log("Calling ShowPreview...");
-                                    await window.ShowPreview(request);
-                                    Logger.Log("ShowPreview completed");
-                                }
-                            });
+                            Dispatch(request);
                         }
                     }
                 }
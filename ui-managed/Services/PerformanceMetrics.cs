@@ -0,0 +1,199 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO.MemoryMappedFiles;
+using System.Numerics;
+using System.Text;
+using System.Threading;
+
+namespace Lumos.UI.Services
+{
+    // Render times, one histogram per renderer, recorded into the metrics
+    // section core-native publishes (core-native/metrics/Metrics.h) so they
+    // show up in its "Performance stats" and in lumos-metrics. The core
+    // passes the section's name down in LUMOS_METRICS; without it this
+    // records nothing.
+    public static unsafe class PerformanceMetrics
+    {
+        private const string EnvironmentVariable = "LUMOS_METRICS";
+        private const uint Magic = 0x54454D4C;  // "LMET"
+        private const ushort Version = 1;
+
+        // MetricsHistogram: name, sum, max, then the buckets
+        private const int NameBytes = 32;
+        private const int SumOffset = 32;
+        private const int MaxOffset = 40;
+        private const int BucketsOffset = 48;
+
+        private static readonly object LockObj = new object();
+        private static readonly Dictionary<string, IntPtr> Histograms = new();
+        private static bool _opened;
+        private static MemoryMappedFile? _section;
+        private static MemoryMappedViewAccessor? _view;
+        private static byte* _base;
+
+        private static int _subBucketBits;
+        private static int _bucketCount;
+        private static ulong _maxValue;
+        private static int _histogramCount;
+        private static int _histogramStride;
+        private static int _histogramsOffset;
+        private static int _firstRendererSlot;
+
+        public static void RecordRender(string renderer, long stopwatchTicks)
+        {
+            if (stopwatchTicks < 0)
+            {
+                return;
+            }
+            var nanoseconds = (ulong)(stopwatchTicks * (1_000_000_000.0 / Stopwatch.Frequency));
+
+            byte* histogram;
+            lock (LockObj)
+            {
+                histogram = (byte*)FindHistogram(renderer);
+            }
+            if (histogram == null)
+            {
+                return;
+            }
+
+            // Same buckets as Metrics::RecordInto
+            Interlocked.Increment(ref *(long*)(histogram + BucketsOffset + 8 * BucketIndex(nanoseconds)));
+            Interlocked.Add(ref *(long*)(histogram + SumOffset), (long)nanoseconds);
+            ref long max = ref *(long*)(histogram + MaxOffset);
+            long seen = Interlocked.Read(ref max);
+            while ((ulong)seen < nanoseconds)
+            {
+                long previous = Interlocked.CompareExchange(ref max, (long)nanoseconds, seen);
+                if (previous == seen)
+                {
+                    break;
+                }
+                seen = previous;
+            }
+        }
+
+        private static int BucketIndex(ulong value)
+        {
+            ulong subBuckets = 1UL << _subBucketBits;
+            value = Math.Min(value, _maxValue);
+            if (value < subBuckets)
+            {
+                return (int)value;
+            }
+            int exponent = BitOperations.Log2(value);
+            return (exponent - _subBucketBits + 1) * (int)subBuckets + (int)((value >> (exponent - _subBucketBits)) - subBuckets);
+        }
+
+        // "ImageRenderer" records as "Render Image"
+        private static IntPtr FindHistogram(string renderer)
+        {
+            if (Histograms.TryGetValue(renderer, out var found))
+            {
+                return found;
+            }
+            if (!Open())
+            {
+                return IntPtr.Zero;
+            }
+
+            string label = "Render " + (renderer.EndsWith("Renderer") ? renderer[..^"Renderer".Length] : renderer);
+            byte[] name = Encoding.UTF8.GetBytes(label);
+            if (name.Length >= NameBytes)
+            {
+                Array.Resize(ref name, NameBytes - 1);
+            }
+
+            // Slots this process (or the UI before a restart) already named
+            // are reused; otherwise the first free one is claimed
+            byte* free = null;
+            for (int i = _firstRendererSlot; i < _histogramCount; i++)
+            {
+                byte* slot = _base + _histogramsOffset + (long)i * _histogramStride;
+                if (slot[0] == 0)
+                {
+                    free = free == null ? slot : free;
+                }
+                else if (NameEquals(slot, name))
+                {
+                    free = slot;
+                    break;
+                }
+            }
+            IntPtr histogram = IntPtr.Zero;
+            if (free != null)
+            {
+                for (int i = 0; i < NameBytes; i++)
+                {
+                    free[i] = i < name.Length ? name[i] : (byte)0;
+                }
+                histogram = (IntPtr)free;
+            }
+            else
+            {
+                Logger.LogWarning($"No metrics slot left for {label}");
+            }
+            Histograms[renderer] = histogram;
+            return histogram;
+        }
+
+        private static bool NameEquals(byte* slot, byte[] name)
+        {
+            for (int i = 0; i < name.Length; i++)
+            {
+                if (slot[i] != name[i])
+                {
+                    return false;
+                }
+            }
+            return slot[name.Length] == 0;
+        }
+
+        // Mapped for the life of the process
+        private static bool Open()
+        {
+            if (_opened)
+            {
+                return _base != null;
+            }
+            _opened = true;
+
+            string? name = Environment.GetEnvironmentVariable(EnvironmentVariable);
+            if (string.IsNullOrEmpty(name))
+            {
+                return false;
+            }
+            try
+            {
+                _section = MemoryMappedFile.OpenExisting(name, MemoryMappedFileRights.ReadWrite);
+                _view = _section.CreateViewAccessor(0, 0, MemoryMappedFileAccess.ReadWrite);
+                byte* pointer = null;
+                _view.SafeMemoryMappedViewHandle.AcquirePointer(ref pointer);
+                pointer += _view.PointerOffset;
+
+                if (*(uint*)pointer != Magic || *(ushort*)(pointer + 4) != Version)
+                {
+                    Logger.LogWarning($"Metrics section {name} has an unknown layout");
+                    return false;
+                }
+                _subBucketBits = *(ushort*)(pointer + 6);
+                _bucketCount = *(int*)(pointer + 8);
+                _histogramCount = *(int*)(pointer + 12);
+                _histogramStride = *(int*)(pointer + 16);
+                _histogramsOffset = *(int*)(pointer + 20);
+                _firstRendererSlot = *(int*)(pointer + 36);
+                int maxExponent = _bucketCount / (1 << _subBucketBits) + _subBucketBits - 1;
+                _maxValue = (1UL << maxExponent) - 1;
+                _base = pointer;
+                Logger.Log($"Recording render times into {name}");
+                return true;
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError($"Failed to open metrics section {name}", ex);
+                return false;
+            }
+        }
+    }
+}